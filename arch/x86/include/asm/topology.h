@@ -191,6 +191,8 @@ static inline int topology_get_logical_id(u32 apicid, enum x86_topology_domains
 #define topology_cluster_id(cpu)		(cpu_data(cpu).topo.l2c_id)
 #define topology_die_cpumask(cpu)		(per_cpu(cpu_die_map, cpu))
 #define topology_cluster_cpumask(cpu)		(cpu_clustergroup_mask(cpu))
+#define topology_llc_id(cpu)			((int)per_cpu_llc_id(cpu))
+#define topology_llc_cpumask(cpu)		(cpu_llc_shared_mask(cpu))
 #define topology_core_cpumask(cpu)		(per_cpu(cpu_core_map, cpu))
 #define topology_sibling_cpumask(cpu)		(per_cpu(cpu_sibling_map, cpu))
 
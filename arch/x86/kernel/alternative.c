@@ -2256,7 +2256,11 @@ noinstr int poke_int3_handler(struct pt_regs *regs)
 }
 
 #define TP_VEC_MAX (PAGE_SIZE / sizeof(struct text_poke_loc))
-static struct text_poke_loc tp_vec[TP_VEC_MAX];
+/* Queued batches grow up to this, memory permitting */
+#define TP_VEC_MAX_GROWN (16 * TP_VEC_MAX)
+static struct text_poke_loc tp_vec_static[TP_VEC_MAX];
+static struct text_poke_loc *tp_vec = tp_vec_static;
+static unsigned int tp_vec_max = TP_VEC_MAX;
 static int tp_vec_nr;
 
 /**
@@ -2509,9 +2513,37 @@ static bool tp_order_fail(void *addr)
 	return false;
 }
 
+/*
+ * Every batch costs three rounds of sync IPIs to all CPUs, whatever its
+ * size, so rather than flushing a full vector try to make it bigger.
+ */
+static bool tp_vec_grow(void)
+{
+	unsigned int max = tp_vec_max * 2;
+	struct text_poke_loc *vec;
+
+	lockdep_assert_held(&text_mutex);
+
+	if (max > TP_VEC_MAX_GROWN || !slab_is_available())
+		return false;
+
+	vec = kmalloc_array(max, sizeof(*vec), GFP_KERNEL | __GFP_NOWARN);
+	if (!vec)
+		return false;
+
+	/* Not in use by poke_int3_handler(), no batch is in flight */
+	memcpy(vec, tp_vec, tp_vec_nr * sizeof(*vec));
+	if (tp_vec != tp_vec_static)
+		kfree(tp_vec);
+	tp_vec = vec;
+	tp_vec_max = max;
+	return true;
+}
+
 static void text_poke_flush(void *addr)
 {
-	if (tp_vec_nr == TP_VEC_MAX || tp_order_fail(addr)) {
+	if (tp_order_fail(addr) ||
+	    (tp_vec_nr == tp_vec_max && !tp_vec_grow())) {
 		text_poke_bp_batch(tp_vec, tp_vec_nr);
 		tp_vec_nr = 0;
 	}
@@ -2520,6 +2552,13 @@ static void text_poke_flush(void *addr)
 void text_poke_finish(void)
 {
 	text_poke_flush(NULL);
+
+	/* Don't pin a grown vector between batches */
+	if (tp_vec != tp_vec_static) {
+		kfree(tp_vec);
+		tp_vec = tp_vec_static;
+		tp_vec_max = TP_VEC_MAX;
+	}
 }
 
 void __ref text_poke_queue(void *addr, const void *opcode, size_t len, const void *emulate)
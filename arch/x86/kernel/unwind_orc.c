@@ -2,6 +2,8 @@
 #include <linux/objtool.h>
 #include <linux/module.h>
 #include <linux/sort.h>
+#include <linux/hash.h>
+#include <linux/percpu.h>
 #include <asm/ptrace.h>
 #include <asm/stacktrace.h>
 #include <asm/unwind.h>
@@ -110,15 +112,104 @@ static struct orc_entry *__orc_find(int *ip_table, struct orc_entry *u_table,
 }
 
 #ifdef CONFIG_MODULES
+/*
+ * Module lookups need a binary search over all of the module's ORC entries,
+ * and stack samples hit the same return addresses over and over. Keep a
+ * small per-CPU cache of the results.
+ *
+ * The cache is used from any context, NMI included. A lookup or update in
+ * progress on this CPU makes nested users bypass it, rather than seeing or
+ * leaving a torn entry behind. Entries aren't invalidated when modules go
+ * away, instead a hit is only used if it still is what a search of the
+ * module currently at that address would return.
+ */
+#define ORC_CACHE_BITS	6
+
+struct orc_cache {
+	bool busy;
+	struct {
+		unsigned long ip;
+		struct orc_entry *orc;
+	} entries[1 << ORC_CACHE_BITS];
+};
+
+static DEFINE_PER_CPU(struct orc_cache, orc_cache);
+
+static struct orc_entry *orc_cache_find(unsigned long ip)
+{
+	struct orc_entry *orc = NULL;
+	struct orc_cache *cache;
+	unsigned int i;
+
+	preempt_disable_notrace();
+	cache = this_cpu_ptr(&orc_cache);
+	if (!cache->busy) {
+		i = hash_long(ip, ORC_CACHE_BITS);
+		cache->busy = true;
+		barrier();
+		if (cache->entries[i].ip == ip)
+			orc = cache->entries[i].orc;
+		barrier();
+		cache->busy = false;
+	}
+	preempt_enable_notrace();
+	return orc;
+}
+
+static void orc_cache_store(unsigned long ip, struct orc_entry *orc)
+{
+	struct orc_cache *cache;
+	unsigned int i;
+
+	preempt_disable_notrace();
+	cache = this_cpu_ptr(&orc_cache);
+	if (!cache->busy) {
+		i = hash_long(ip, ORC_CACHE_BITS);
+		cache->busy = true;
+		barrier();
+		cache->entries[i].ip = ip;
+		cache->entries[i].orc = orc;
+		barrier();
+		cache->busy = false;
+	}
+	preempt_enable_notrace();
+}
+
+/* Whether __orc_find() on @mod's table would return @orc for @ip */
+static bool orc_module_valid(struct module *mod, struct orc_entry *orc,
+			     unsigned long ip)
+{
+	int *ip_table = mod->arch.orc_unwind_ip;
+	unsigned int idx;
+
+	if (orc < mod->arch.orc_unwind ||
+	    orc >= mod->arch.orc_unwind + mod->arch.num_orcs)
+		return false;
+
+	idx = orc - mod->arch.orc_unwind;
+	if (idx && orc_ip(ip_table + idx) > ip)
+		return false;
+	return idx + 1 == mod->arch.num_orcs || orc_ip(ip_table + idx + 1) > ip;
+}
+
 static struct orc_entry *orc_module_find(unsigned long ip)
 {
+	struct orc_entry *orc;
 	struct module *mod;
 
 	mod = __module_address(ip);
 	if (!mod || !mod->arch.orc_unwind || !mod->arch.orc_unwind_ip)
 		return NULL;
-	return __orc_find(mod->arch.orc_unwind_ip, mod->arch.orc_unwind,
-			  mod->arch.num_orcs, ip);
+
+	orc = orc_cache_find(ip);
+	if (orc && orc_module_valid(mod, orc, ip))
+		return orc;
+
+	orc = __orc_find(mod->arch.orc_unwind_ip, mod->arch.orc_unwind,
+			 mod->arch.num_orcs, ip);
+	if (orc)
+		orc_cache_store(ip, orc);
+	return orc;
 }
 #else
 static struct orc_entry *orc_module_find(unsigned long ip)
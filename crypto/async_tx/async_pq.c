@@ -268,6 +268,44 @@ async_gen_syndrome(struct page **blocks, unsigned int *offsets, int disks,
 }
 EXPORT_SYMBOL_GPL(async_gen_syndrome);
 
+/**
+ * async_gen_syndrome_batch - calculate the raid6 syndromes of several stripes
+ * @stripes: blocks and offsets of each stripe, see async_gen_syndrome()
+ * @nr_stripes: number of entries in @stripes
+ * @disks: number of blocks of each stripe (including P and Q)
+ * @len: length of operation in bytes of each stripe
+ * @submit: submission/completion modifiers applied to the whole batch
+ *
+ * Each stripe is submitted as by async_gen_syndrome(), chained behind the
+ * previous one so that, when they land on the same channel, only the
+ * descriptor of the last stripe requests an interrupt and runs
+ * @submit->cb_fn. Stripes that can not be offloaded are computed
+ * synchronously one at a time, after waiting for the preceding ones.
+ */
+struct dma_async_tx_descriptor *
+async_gen_syndrome_batch(struct async_pq_stripe *stripes, int nr_stripes,
+			 int disks, size_t len, struct async_submit_ctl *submit)
+{
+	struct dma_async_tx_descriptor *tx = submit->depend_tx;
+	struct async_submit_ctl stripe_submit;
+	int i;
+
+	BUG_ON(nr_stripes <= 0);
+
+	for (i = 0; i < nr_stripes - 1; i++) {
+		init_async_submit(&stripe_submit, submit->flags & ~ASYNC_TX_ACK,
+				  tx, NULL, NULL, submit->scribble);
+		tx = async_gen_syndrome(stripes[i].blocks, stripes[i].offsets,
+					disks, len, &stripe_submit);
+	}
+
+	init_async_submit(&stripe_submit, submit->flags, tx, submit->cb_fn,
+			  submit->cb_param, submit->scribble);
+	return async_gen_syndrome(stripes[i].blocks, stripes[i].offsets,
+				  disks, len, &stripe_submit);
+}
+EXPORT_SYMBOL_GPL(async_gen_syndrome_batch);
+
 static inline struct dma_chan *
 pq_val_chan(struct async_submit_ctl *submit, struct page **blocks, int disks, size_t len)
 {
@@ -278,6 +278,49 @@ async_xor(struct page *dest, struct page **src_list, unsigned int offset,
 }
 EXPORT_SYMBOL_GPL(async_xor);
 
+/**
+ * async_xor_batch - xor several independent stripes with a single completion
+ * @stripes: destination and sources of each xor
+ * @nr_stripes: number of entries in @stripes
+ * @src_cnt: number of source pages of each stripe
+ * @len: length in bytes of each stripe
+ * @submit: submission / completion modifiers applied to the whole batch
+ *
+ * honored flags: ASYNC_TX_ACK, ASYNC_TX_XOR_ZERO_DST, ASYNC_TX_XOR_DROP_DST
+ *
+ * Each stripe is submitted as by async_xor_offs(), chained behind the
+ * previous one so that, when they land on the same channel, only the
+ * descriptor of the last stripe requests an interrupt and runs
+ * @submit->cb_fn. Stripes that can not be offloaded fall back to the
+ * synchronous xor one at a time, after waiting for the preceding ones.
+ * @submit->scribble, if provided, is reused by every stripe.
+ */
+struct dma_async_tx_descriptor *
+async_xor_batch(struct async_xor_stripe *stripes, int nr_stripes,
+		int src_cnt, size_t len, struct async_submit_ctl *submit)
+{
+	struct dma_async_tx_descriptor *tx = submit->depend_tx;
+	struct async_submit_ctl stripe_submit;
+	int i;
+
+	BUG_ON(nr_stripes <= 0);
+
+	for (i = 0; i < nr_stripes - 1; i++) {
+		init_async_submit(&stripe_submit, submit->flags & ~ASYNC_TX_ACK,
+				  tx, NULL, NULL, submit->scribble);
+		tx = async_xor_offs(stripes[i].dest, stripes[i].offset,
+				    stripes[i].src_list, stripes[i].src_offs,
+				    src_cnt, len, &stripe_submit);
+	}
+
+	init_async_submit(&stripe_submit, submit->flags, tx, submit->cb_fn,
+			  submit->cb_param, submit->scribble);
+	return async_xor_offs(stripes[i].dest, stripes[i].offset,
+			      stripes[i].src_list, stripes[i].src_offs,
+			      src_cnt, len, &stripe_submit);
+}
+EXPORT_SYMBOL_GPL(async_xor_batch);
+
 static int page_is_zero(struct page *p, unsigned int offset, size_t len)
 {
 	return !memchr_inv(page_address(p) + offset, 0, len);
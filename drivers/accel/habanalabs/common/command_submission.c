@@ -59,77 +59,58 @@ static void hl_push_cs_outcome(struct hl_device *hdev,
 			       u64 seq, ktime_t ts, int error)
 {
 	struct hl_cs_outcome *node;
-	unsigned long flags;
+	u64 tag;
 
 	/*
 	 * CS outcome store supports the following operations:
 	 * push outcome - store a recent CS outcome in the store
 	 * pop outcome - retrieve a SPECIFIC (by seq) CS outcome from the store
-	 * It uses 2 lists: used list and free list.
-	 * It has a pre-allocated amount of nodes, each node stores
-	 * a single CS outcome.
-	 * Initially, all the nodes are in the free list.
-	 * On push outcome, a node (any) is taken from the free list, its
-	 * information is filled in, and the node is moved to the used list.
-	 * It is possible, that there are no nodes left in the free list.
-	 * In this case, we will lose some information about old outcomes. We
-	 * will pop the OLDEST node from the used list, and make it free.
-	 * On pop, the node is searched for in the used list (using a search
-	 * index).
-	 * If found, the node is then removed from the used list, and moved
-	 * back to the free list. The outcome data that the node contained is
-	 * returned back to the user.
+	 * It is a ring of pre-allocated nodes indexed by the CS sequence, so
+	 * both operations touch a single node and need no lock. Every
+	 * completed CS takes the node of its sequence; if the CS that
+	 * completed HL_CS_OUTCOME_HISTORY_LEN sequences earlier still has
+	 * its outcome there, that (oldest) outcome is lost.
+	 * A node is claimed for writing by setting its tag to BUSY, and
+	 * published by storing seq + 1 in the tag. Pop consumes a node by
+	 * swinging the tag from seq + 1 back to 0, which fails if a writer
+	 * claimed the node in the meantime.
 	 */
+	BUILD_BUG_ON_NOT_POWER_OF_2(HL_CS_OUTCOME_HISTORY_LEN);
 
-	spin_lock_irqsave(&outcome_store->db_lock, flags);
+	node = &outcome_store->ring[seq & (HL_CS_OUTCOME_HISTORY_LEN - 1)];
 
-	if (list_empty(&outcome_store->free_list)) {
-		node = list_last_entry(&outcome_store->used_list,
-				       struct hl_cs_outcome, list_link);
-		hash_del(&node->map_link);
-		dev_dbg(hdev->dev, "CS %llu outcome was lost\n", node->seq);
-	} else {
-		node = list_last_entry(&outcome_store->free_list,
-				       struct hl_cs_outcome, list_link);
-	}
+	do {
+		tag = READ_ONCE(node->tag);
+		while (unlikely(tag == HL_CS_OUTCOME_BUSY)) {
+			cpu_relax();
+			tag = READ_ONCE(node->tag);
+		}
+	} while (cmpxchg(&node->tag, tag, HL_CS_OUTCOME_BUSY) != tag);
 
-	list_del_init(&node->list_link);
+	if (tag)
+		dev_dbg(hdev->dev, "CS %llu outcome was lost\n", tag - 1);
 
-	node->seq = seq;
 	node->ts = ts;
 	node->error = error;
 
-	list_add(&node->list_link, &outcome_store->used_list);
-	hash_add(outcome_store->outcome_map, &node->map_link, node->seq);
-
-	spin_unlock_irqrestore(&outcome_store->db_lock, flags);
+	smp_store_release(&node->tag, seq + 1);
 }
 
 static bool hl_pop_cs_outcome(struct hl_cs_outcome_store *outcome_store,
 			       u64 seq, ktime_t *ts, int *error)
 {
 	struct hl_cs_outcome *node;
-	unsigned long flags;
 
-	spin_lock_irqsave(&outcome_store->db_lock, flags);
+	node = &outcome_store->ring[seq & (HL_CS_OUTCOME_HISTORY_LEN - 1)];
 
-	hash_for_each_possible(outcome_store->outcome_map, node, map_link, seq)
-		if (node->seq == seq) {
-			*ts = node->ts;
-			*error = node->error;
-
-			hash_del(&node->map_link);
-			list_del_init(&node->list_link);
-			list_add(&node->list_link, &outcome_store->free_list);
-
-			spin_unlock_irqrestore(&outcome_store->db_lock, flags);
-
-			return true;
-		}
+	if (smp_load_acquire(&node->tag) != seq + 1)
+		return false;
 
-	spin_unlock_irqrestore(&outcome_store->db_lock, flags);
+	*ts = node->ts;
+	*error = node->error;
 
-	return false;
+	/* The data is only valid if no writer claimed the node meanwhile */
+	return cmpxchg(&node->tag, seq + 1, 0) == seq + 1;
 }
 
 static void hl_sob_reset(struct kref *ref)
@@ -200,7 +200,7 @@ int hl_ctx_create(struct hl_device *hdev, struct hl_fpriv *hpriv)
 int hl_ctx_init(struct hl_device *hdev, struct hl_ctx *ctx, bool is_kernel_ctx)
 {
 	char task_comm[TASK_COMM_LEN];
-	int rc = 0, i;
+	int rc = 0;
 
 	ctx->hdev = hdev;
 
@@ -216,12 +216,7 @@ int hl_ctx_init(struct hl_device *hdev, struct hl_ctx *ctx, bool is_kernel_ctx)
 	if (!ctx->cs_pending)
 		return -ENOMEM;
 
-	INIT_LIST_HEAD(&ctx->outcome_store.used_list);
-	INIT_LIST_HEAD(&ctx->outcome_store.free_list);
-	hash_init(ctx->outcome_store.outcome_map);
-	for (i = 0; i < ARRAY_SIZE(ctx->outcome_store.nodes_pool); ++i)
-		list_add(&ctx->outcome_store.nodes_pool[i].list_link,
-			 &ctx->outcome_store.free_list);
+	memset(&ctx->outcome_store, 0, sizeof(ctx->outcome_store));
 
 	hl_hw_block_mem_init(ctx);
 
@@ -1853,34 +1853,25 @@ struct hl_dmabuf_priv {
 
 /**
  * struct hl_cs_outcome - represents a single completed CS outcome
- * @list_link: link to either container's used list or free list
- * @map_link: list to the container hash map
+ * @tag: the original cs sequence + 1 when the slot holds an outcome, 0 when
+ *       it is empty, or HL_CS_OUTCOME_BUSY while it is being written
  * @ts: completion ts
- * @seq: the original cs sequence
  * @error: error code cs completed with, if any
  */
 struct hl_cs_outcome {
-	struct list_head list_link;
-	struct hlist_node map_link;
+	u64 tag;
 	ktime_t ts;
-	u64 seq;
 	int error;
 };
 
+#define HL_CS_OUTCOME_BUSY	U64_MAX
+
 /**
  * struct hl_cs_outcome_store - represents a limited store of completed CS outcomes
- * @outcome_map: index of completed CS searchable by sequence number
- * @used_list: list of outcome objects currently in use
- * @free_list: list of outcome objects currently not in use
- * @nodes_pool: a static pool of pre-allocated outcome objects
- * @db_lock: any operation on the store must take this lock
+ * @ring: lockless ring of outcomes, indexed by the CS sequence modulo its size
  */
 struct hl_cs_outcome_store {
-	DECLARE_HASHTABLE(outcome_map, 8);
-	struct list_head used_list;
-	struct list_head free_list;
-	struct hl_cs_outcome nodes_pool[HL_CS_OUTCOME_HISTORY_LEN];
-	spinlock_t db_lock;
+	struct hl_cs_outcome ring[HL_CS_OUTCOME_HISTORY_LEN];
 };
 
 /**
@@ -326,22 +326,12 @@ void ivpu_context_abort_locked(struct ivpu_file_priv *file_priv)
 		ivpu_jsm_context_release(vdev, file_priv->ctx.id);
 }
 
-static int ivpu_cmdq_push_job(struct ivpu_cmdq *cmdq, struct ivpu_job *job)
+static void ivpu_cmdq_fill_entry(struct ivpu_cmdq *cmdq, struct ivpu_job *job, u32 index)
 {
 	struct ivpu_device *vdev = job->vdev;
-	struct vpu_job_queue_header *header = &cmdq->jobq->header;
 	struct vpu_job_queue_entry *entry;
-	u32 tail = READ_ONCE(header->tail);
-	u32 next_entry = (tail + 1) % cmdq->entry_count;
-
-	/* Check if there is space left in job queue */
-	if (next_entry == header->head) {
-		ivpu_dbg(vdev, JOB, "Job queue full: ctx %d cmdq %d db %d head %d tail %d\n",
-			 job->file_priv->ctx.id, cmdq->id, cmdq->db_id, header->head, tail);
-		return -EBUSY;
-	}
 
-	entry = &cmdq->jobq->slot[tail].job;
+	entry = &cmdq->jobq->slot[index].job;
 	entry->batch_buf_addr = job->cmd_buf_vpu_addr;
 	entry->job_id = job->job_id;
 	entry->flags = 0;
@@ -360,9 +350,34 @@ static int ivpu_cmdq_push_job(struct ivpu_cmdq *cmdq, struct ivpu_job *job)
 				ivpu_bo_size(cmdq->secondary_preempt_buf);
 		}
 	}
+}
+
+/*
+ * Fill @count consecutive job queue entries and publish them with a single
+ * tail update, so the firmware sees either none or all of the jobs.
+ */
+static int ivpu_cmdq_push_jobs(struct ivpu_cmdq *cmdq, struct ivpu_job **jobs, u32 count)
+{
+	struct ivpu_device *vdev = jobs[0]->vdev;
+	struct vpu_job_queue_header *header = &cmdq->jobq->header;
+	u32 tail = READ_ONCE(header->tail);
+	u32 head = READ_ONCE(header->head);
+	u32 free_entries;
+	u32 i;
+
+	/* Check if there is space left in job queue */
+	free_entries = (head + cmdq->entry_count - tail - 1) % cmdq->entry_count;
+	if (free_entries < count) {
+		ivpu_dbg(vdev, JOB, "Job queue full: ctx %d cmdq %d db %d head %d tail %d count %u\n",
+			 jobs[0]->file_priv->ctx.id, cmdq->id, cmdq->db_id, head, tail, count);
+		return -EBUSY;
+	}
+
+	for (i = 0; i < count; i++)
+		ivpu_cmdq_fill_entry(cmdq, jobs[i], (tail + i) % cmdq->entry_count);
 
 	wmb(); /* Ensure that tail is updated after filling entry */
-	header->tail = next_entry;
+	header->tail = (tail + count) % cmdq->entry_count;
 	wmb(); /* Flush WC buffer for jobq header */
 
 	return 0;
@@ -509,40 +524,46 @@ void ivpu_jobs_abort_all(struct ivpu_device *vdev)
 		ivpu_job_signal_and_destroy(vdev, id, DRM_IVPU_JOB_STATUS_ABORTED);
 }
 
-static int ivpu_job_submit(struct ivpu_job *job, u8 priority)
+static int ivpu_jobs_submit(struct ivpu_job **jobs, u32 count, u8 priority)
 {
-	struct ivpu_file_priv *file_priv = job->file_priv;
-	struct ivpu_device *vdev = job->vdev;
+	struct ivpu_file_priv *file_priv = jobs[0]->file_priv;
+	struct ivpu_device *vdev = jobs[0]->vdev;
 	struct ivpu_cmdq *cmdq;
 	bool is_first_job;
+	u32 i, rpm_count;
 	int ret;
 
-	ret = ivpu_rpm_get(vdev);
-	if (ret < 0)
-		return ret;
+	/* Each job drops its own runtime PM reference once it is done */
+	for (rpm_count = 0; rpm_count < count; rpm_count++) {
+		ret = ivpu_rpm_get(vdev);
+		if (ret < 0)
+			goto err_rpm_put;
+	}
 
 	mutex_lock(&file_priv->lock);
 
 	cmdq = ivpu_cmdq_acquire(file_priv, priority);
 	if (!cmdq) {
 		ivpu_warn_ratelimited(vdev, "Failed to get job queue, ctx %d engine %d prio %d\n",
-				      file_priv->ctx.id, job->engine_idx, priority);
+				      file_priv->ctx.id, jobs[0]->engine_idx, priority);
 		ret = -EINVAL;
 		goto err_unlock_file_priv;
 	}
 
 	xa_lock(&vdev->submitted_jobs_xa);
 	is_first_job = xa_empty(&vdev->submitted_jobs_xa);
-	ret = __xa_alloc_cyclic(&vdev->submitted_jobs_xa, &job->job_id, job, file_priv->job_limit,
-				&file_priv->job_id_next, GFP_KERNEL);
-	if (ret < 0) {
-		ivpu_dbg(vdev, JOB, "Too many active jobs in ctx %d\n",
-			 file_priv->ctx.id);
-		ret = -EBUSY;
-		goto err_unlock_submitted_jobs_xa;
+	for (i = 0; i < count; i++) {
+		ret = __xa_alloc_cyclic(&vdev->submitted_jobs_xa, &jobs[i]->job_id, jobs[i],
+					file_priv->job_limit, &file_priv->job_id_next, GFP_KERNEL);
+		if (ret < 0) {
+			ivpu_dbg(vdev, JOB, "Too many active jobs in ctx %d\n",
+				 file_priv->ctx.id);
+			ret = -EBUSY;
+			goto err_erase_xa;
+		}
 	}
 
-	ret = ivpu_cmdq_push_job(cmdq, job);
+	ret = ivpu_cmdq_push_jobs(cmdq, jobs, count);
 	if (ret)
 		goto err_erase_xa;
 
@@ -557,27 +578,32 @@ static int ivpu_job_submit(struct ivpu_job *job, u8 priority)
 			vdev->busy_start_ts = ktime_get();
 	}
 
-	trace_job("submit", job);
-	ivpu_dbg(vdev, JOB, "Job submitted: id %3u ctx %2d engine %d prio %d addr 0x%llx next %d\n",
-		 job->job_id, file_priv->ctx.id, job->engine_idx, priority,
-		 job->cmd_buf_vpu_addr, cmdq->jobq->header.tail);
+	for (i = 0; i < count; i++) {
+		trace_job("submit", jobs[i]);
+		ivpu_dbg(vdev, JOB, "Job submitted: id %3u ctx %2d engine %d prio %d addr 0x%llx next %d\n",
+			 jobs[i]->job_id, file_priv->ctx.id, jobs[i]->engine_idx, priority,
+			 jobs[i]->cmd_buf_vpu_addr, cmdq->jobq->header.tail);
+	}
 
 	xa_unlock(&vdev->submitted_jobs_xa);
 
 	mutex_unlock(&file_priv->lock);
 
 	if (unlikely(ivpu_test_mode & IVPU_TEST_MODE_NULL_HW))
-		ivpu_job_signal_and_destroy(vdev, job->job_id, VPU_JSM_STATUS_SUCCESS);
+		for (i = 0; i < count; i++)
+			ivpu_job_signal_and_destroy(vdev, jobs[i]->job_id, VPU_JSM_STATUS_SUCCESS);
 
 	return 0;
 
 err_erase_xa:
-	__xa_erase(&vdev->submitted_jobs_xa, job->job_id);
-err_unlock_submitted_jobs_xa:
+	while (i--)
+		__xa_erase(&vdev->submitted_jobs_xa, jobs[i]->job_id);
 	xa_unlock(&vdev->submitted_jobs_xa);
 err_unlock_file_priv:
 	mutex_unlock(&file_priv->lock);
-	ivpu_rpm_put(vdev);
+err_rpm_put:
+	while (rpm_count--)
+		ivpu_rpm_put(vdev);
 	return ret;
 }
 
@@ -655,16 +681,9 @@ static inline u8 ivpu_job_to_hws_priority(struct ivpu_file_priv *file_priv, u8 p
 	return priority - 1;
 }
 
-int ivpu_submit_ioctl(struct drm_device *dev, void *data, struct drm_file *file)
+static int ivpu_submit_params_check(struct ivpu_file_priv *file_priv,
+				    struct drm_ivpu_submit *params)
 {
-	struct ivpu_file_priv *file_priv = file->driver_priv;
-	struct ivpu_device *vdev = file_priv->vdev;
-	struct drm_ivpu_submit *params = data;
-	struct ivpu_job *job;
-	u32 *buf_handles;
-	int idx, ret;
-	u8 priority;
-
 	if (params->engine != DRM_IVPU_ENGINE_COMPUTE)
 		return -EINVAL;
 
@@ -683,9 +702,21 @@ int ivpu_submit_ioctl(struct drm_device *dev, void *data, struct drm_file *file)
 	if (file_priv->has_mmu_faults)
 		return -EBADFD;
 
+	return 0;
+}
+
+static struct ivpu_job *ivpu_job_create_for_submit(struct drm_file *file,
+						   struct drm_ivpu_submit *params)
+{
+	struct ivpu_file_priv *file_priv = file->driver_priv;
+	struct ivpu_device *vdev = file_priv->vdev;
+	struct ivpu_job *job;
+	u32 *buf_handles;
+	int ret;
+
 	buf_handles = kcalloc(params->buffer_count, sizeof(u32), GFP_KERNEL);
 	if (!buf_handles)
-		return -ENOMEM;
+		return ERR_PTR(-ENOMEM);
 
 	ret = copy_from_user(buf_handles,
 			     (void __user *)params->buffers_ptr,
@@ -695,11 +726,6 @@ int ivpu_submit_ioctl(struct drm_device *dev, void *data, struct drm_file *file)
 		goto err_free_handles;
 	}
 
-	if (!drm_dev_enter(&vdev->drm, &idx)) {
-		ret = -ENODEV;
-		goto err_free_handles;
-	}
-
 	ivpu_dbg(vdev, JOB, "Submit ioctl: ctx %u buf_count %u\n",
 		 file_priv->ctx.id, params->buffer_count);
 
@@ -707,7 +733,7 @@ int ivpu_submit_ioctl(struct drm_device *dev, void *data, struct drm_file *file)
 	if (!job) {
 		ivpu_err(vdev, "Failed to create job\n");
 		ret = -ENOMEM;
-		goto err_exit_dev;
+		goto err_free_handles;
 	}
 
 	ret = ivpu_job_prepare_bos_for_submit(file, job, buf_handles, params->buffer_count,
@@ -717,26 +743,130 @@ int ivpu_submit_ioctl(struct drm_device *dev, void *data, struct drm_file *file)
 		goto err_destroy_job;
 	}
 
+	kfree(buf_handles);
+	return job;
+
+err_destroy_job:
+	ivpu_job_destroy(job);
+err_free_handles:
+	kfree(buf_handles);
+	return ERR_PTR(ret);
+}
+
+int ivpu_submit_ioctl(struct drm_device *dev, void *data, struct drm_file *file)
+{
+	struct ivpu_file_priv *file_priv = file->driver_priv;
+	struct ivpu_device *vdev = file_priv->vdev;
+	struct drm_ivpu_submit *params = data;
+	struct ivpu_job *job;
+	int idx, ret;
+	u8 priority;
+
+	ret = ivpu_submit_params_check(file_priv, params);
+	if (ret)
+		return ret;
+
+	if (!drm_dev_enter(&vdev->drm, &idx))
+		return -ENODEV;
+
+	job = ivpu_job_create_for_submit(file, params);
+	if (IS_ERR(job)) {
+		ret = PTR_ERR(job);
+		goto err_exit_dev;
+	}
+
 	priority = ivpu_job_to_hws_priority(file_priv, params->priority);
 
 	down_read(&vdev->pm->reset_lock);
-	ret = ivpu_job_submit(job, priority);
+	ret = ivpu_jobs_submit(&job, 1, priority);
 	up_read(&vdev->pm->reset_lock);
-	if (ret)
-		goto err_signal_fence;
+	if (ret) {
+		dma_fence_signal(job->done_fence);
+		ivpu_job_destroy(job);
+	}
 
+err_exit_dev:
 	drm_dev_exit(idx);
-	kfree(buf_handles);
 	return ret;
+}
+
+int ivpu_submit_batch_ioctl(struct drm_device *dev, void *data, struct drm_file *file)
+{
+	struct ivpu_file_priv *file_priv = file->driver_priv;
+	struct ivpu_device *vdev = file_priv->vdev;
+	struct drm_ivpu_submit_batch *args = data;
+	struct drm_ivpu_submit *params;
+	struct ivpu_job **jobs;
+	int idx, ret;
+	u8 priority;
+	u32 i;
+
+	if (args->flags)
+		return -EINVAL;
+
+	if (args->count == 0 || args->count > DRM_IVPU_SUBMIT_BATCH_MAX)
+		return -EINVAL;
+
+	params = memdup_array_user(u64_to_user_ptr(args->submits_ptr), args->count,
+				   sizeof(*params));
+	if (IS_ERR(params))
+		return PTR_ERR(params);
+
+	/* All jobs of a batch go to the same command queue */
+	for (i = 0; i < args->count; i++) {
+		ret = ivpu_submit_params_check(file_priv, &params[i]);
+		if (ret)
+			goto err_free_params;
+
+		if (params[i].engine != params[0].engine ||
+		    params[i].priority != params[0].priority) {
+			ret = -EINVAL;
+			goto err_free_params;
+		}
+	}
+
+	jobs = kcalloc(args->count, sizeof(*jobs), GFP_KERNEL);
+	if (!jobs) {
+		ret = -ENOMEM;
+		goto err_free_params;
+	}
+
+	if (!drm_dev_enter(&vdev->drm, &idx)) {
+		ret = -ENODEV;
+		goto err_free_jobs;
+	}
+
+	for (i = 0; i < args->count; i++) {
+		jobs[i] = ivpu_job_create_for_submit(file, &params[i]);
+		if (IS_ERR(jobs[i])) {
+			ret = PTR_ERR(jobs[i]);
+			goto err_destroy_jobs;
+		}
+	}
+
+	priority = ivpu_job_to_hws_priority(file_priv, params[0].priority);
+
+	down_read(&vdev->pm->reset_lock);
+	ret = ivpu_jobs_submit(jobs, args->count, priority);
+	up_read(&vdev->pm->reset_lock);
+	if (ret)
+		goto err_destroy_jobs;
 
-err_signal_fence:
-	dma_fence_signal(job->done_fence);
-err_destroy_job:
-	ivpu_job_destroy(job);
-err_exit_dev:
 	drm_dev_exit(idx);
-err_free_handles:
-	kfree(buf_handles);
+	kfree(jobs);
+	kfree(params);
+	return 0;
+
+err_destroy_jobs:
+	while (i--) {
+		dma_fence_signal(jobs[i]->done_fence);
+		ivpu_job_destroy(jobs[i]);
+	}
+	drm_dev_exit(idx);
+err_free_jobs:
+	kfree(jobs);
+err_free_params:
+	kfree(params);
 	return ret;
 }
 
@@ -7,6 +7,7 @@
 #ifndef _QAIC_H_
 #define _QAIC_H_
 
+#include <linux/idr.h>
 #include <linux/interrupt.h>
 #include <linux/kref.h>
 #include <linux/mhi.h>
@@ -79,11 +80,13 @@ struct dma_bridge_chan {
 	/* The user that opened this DBC */
 	struct qaic_user	*usr;
 	/*
-	 * Request ID of next memory handle that goes in request queue. One
+	 * Request IDs of the memory handles sliced against this DBC. One
 	 * memory handle can enqueue more than one request elements, all
-	 * this requests that belong to same memory handle have same request ID
+	 * this requests that belong to same memory handle have same request ID.
+	 * The ID is assigned at slice time so the encoded requests can be
+	 * copied to the request queue as-is on every execute.
 	 */
-	u16			next_req_id;
+	struct ida		req_ids;
 	/* true: DBC is in use; false: DBC not in use */
 	bool			in_use;
 	/*
@@ -205,7 +208,7 @@ struct qaic_bo {
 	 * calling DRM_IOCTL_QAIC_ATTACH_SLICE_BO ioctl.
 	 */
 	bool			sliced;
-	/* Request ID of this BO if it is queued for execution */
+	/* Request ID of this BO, valid while it is sliced */
 	u16			req_id;
 	/* Handle assigned to this BO */
 	u32			handle;
@@ -302,6 +302,7 @@ static int encode_reqs(struct qaic_device *qdev, struct bo_slice *slice,
 	 */
 	dev_addr = req->dev_addr;
 	for_each_sgtable_dma_sg(slice->sgt, sg, i) {
+		slice->reqs[i].req_id = cpu_to_le16(slice->bo->req_id);
 		slice->reqs[i].cmd = cmd;
 		slice->reqs[i].src_addr = cpu_to_le64(slice->dir == DMA_TO_DEVICE ?
 						      sg_dma_address(sg) : dev_addr);
@@ -863,17 +864,33 @@ static int qaic_prepare_export_bo(struct qaic_device *qdev, struct qaic_bo *bo,
 static int qaic_prepare_bo(struct qaic_device *qdev, struct qaic_bo *bo,
 			   struct qaic_attach_slice_hdr *hdr)
 {
+	struct dma_bridge_chan *dbc = &qdev->dbc[hdr->dbc_id];
 	int ret;
 
+	/*
+	 * The request ID is encoded into every request of every slice, so it
+	 * has to stay unique among the BOs sliced against this DBC for as long
+	 * as the slices exist.
+	 */
+	ret = ida_alloc_max(&dbc->req_ids, U16_MAX, GFP_KERNEL);
+	if (ret < 0)
+		return ret;
+	bo->req_id = ret;
+
 	if (bo->base.import_attach)
 		ret = qaic_prepare_import_bo(bo, hdr);
 	else
 		ret = qaic_prepare_export_bo(qdev, bo, hdr);
+	if (ret) {
+		ida_free(&dbc->req_ids, bo->req_id);
+		bo->req_id = 0;
+		return ret;
+	}
 	bo->dir = hdr->dir;
-	bo->dbc = &qdev->dbc[hdr->dbc_id];
+	bo->dbc = dbc;
 	bo->nr_slice = hdr->count;
 
-	return ret;
+	return 0;
 }
 
 static void qaic_unprepare_import_bo(struct qaic_bo *bo)
@@ -894,6 +911,8 @@ static void qaic_unprepare_bo(struct qaic_device *qdev, struct qaic_bo *bo)
 	else
 		qaic_unprepare_export_bo(qdev, bo);
 
+	ida_free(&bo->dbc->req_ids, bo->req_id);
+	bo->req_id = 0;
 	bo->dir = 0;
 	bo->dbc = NULL;
 	bo->nr_slice = 0;
@@ -1210,12 +1229,7 @@ static int send_bo_list_to_device(struct qaic_device *qdev, struct drm_file *fil
 			goto unlock_bo;
 		}
 
-		bo->req_id = dbc->next_req_id++;
-
 		list_for_each_entry(slice, &bo->slices, slice) {
-			for (j = 0; j < slice->nents; j++)
-				slice->reqs[j].req_id = cpu_to_le16(bo->req_id);
-
 			if (is_partial && (!pexec[i].resize || pexec[i].resize <= slice->offset))
 				/* Configure the slice for no DMA transfer */
 				ret = copy_partial_exec_reqs(qdev, slice, 0, dbc, head, tail);
@@ -1902,7 +1916,6 @@ static void empty_xfer_list(struct qaic_device *qdev, struct dma_bridge_chan *db
 		list_del_init(&bo->xfer_list);
 		spin_unlock_irqrestore(&dbc->xfer_lock, flags);
 		bo->nr_slice_xfer_done = 0;
-		bo->req_id = 0;
 		bo->perf_stats.req_received_ts = 0;
 		bo->perf_stats.req_submit_ts = 0;
 		bo->perf_stats.req_processed_ts = 0;
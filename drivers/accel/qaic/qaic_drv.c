@@ -417,6 +417,7 @@ static struct qaic_device *create_qdev(struct pci_dev *pdev, const struct pci_de
 		qdev->dbc[i].qdev = qdev;
 		qdev->dbc[i].id = i;
 		INIT_LIST_HEAD(&qdev->dbc[i].xfer_list);
+		ida_init(&qdev->dbc[i].req_ids);
 		ret = qaicm_srcu_init(drm, &qdev->dbc[i].ch_lock);
 		if (ret)
 			return NULL;
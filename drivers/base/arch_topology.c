@@ -776,6 +776,10 @@ void update_siblings_masks(unsigned int cpuid)
 	if (ret && ret != -ENOENT)
 		pr_info("Early cacheinfo allocation failed, ret = %d\n", ret);
 
+	/* the LLC is named after the lowest CPU that ever shared it */
+	if (cpuid_topo->llc_id < 0)
+		cpuid_topo->llc_id = cpuid;
+
 	/* update core and thread sibling masks */
 	for_each_online_cpu(cpu) {
 		cpu_topo = &cpu_topology[cpu];
@@ -783,6 +787,9 @@ void update_siblings_masks(unsigned int cpuid)
 		if (last_level_cache_is_shared(cpu, cpuid)) {
 			cpumask_set_cpu(cpu, &cpuid_topo->llc_sibling);
 			cpumask_set_cpu(cpuid, &cpu_topo->llc_sibling);
+			if (cpu_topo->llc_id >= 0 &&
+			    cpu_topo->llc_id < cpuid_topo->llc_id)
+				cpuid_topo->llc_id = cpu_topo->llc_id;
 		}
 
 		if (cpuid_topo->package_id != cpu_topo->package_id)
@@ -805,6 +812,13 @@ void update_siblings_masks(unsigned int cpuid)
 		cpumask_set_cpu(cpuid, &cpu_topo->thread_sibling);
 		cpumask_set_cpu(cpu, &cpuid_topo->thread_sibling);
 	}
+
+	/*
+	 * CPUs may come online out of order, hand a lower id found above to
+	 * the siblings that are already online so that they all agree.
+	 */
+	for_each_cpu(cpu, &cpuid_topo->llc_sibling)
+		cpu_topology[cpu].llc_id = cpuid_topo->llc_id;
 }
 
 static void clear_cpu_topology(int cpu)
@@ -834,6 +848,7 @@ void __init reset_cpu_topology(void)
 		cpu_topo->core_id = -1;
 		cpu_topo->cluster_id = -1;
 		cpu_topo->package_id = -1;
+		cpu_topo->llc_id = -1;
 
 		clear_cpu_topology(cpu);
 	}
@@ -179,6 +179,12 @@ struct regmap {
 
 	/* if set, the regmap core can sleep */
 	bool can_sleep;
+
+	/* if set, single register writes are queued in batch */
+	bool batching;
+	struct reg_sequence *batch;
+	unsigned int batch_len;
+	unsigned int batch_size;
 };
 
 struct regcache_ops {
@@ -186,50 +186,42 @@ static int regcache_maple_drop(struct regmap *map, unsigned int min,
 	return ret;
 }
 
-static int regcache_maple_sync_block(struct regmap *map, unsigned long *entry,
+static int regcache_maple_sync_block(struct regmap *map, void *buf,
 				     struct ma_state *mas,
-				     unsigned int min, unsigned int max)
+				     unsigned int min, unsigned int count)
 {
-	void *buf;
-	unsigned long r;
-	size_t val_bytes = map->format.val_bytes;
-	int ret = 0;
+	int ret;
 
 	mas_pause(mas);
 	rcu_read_unlock();
 
 	/*
-	 * Use a raw write if writing more than one register to a
-	 * device that supports raw writes to reduce transaction
-	 * overheads.
+	 * Use a raw write if writing more than one register to reduce
+	 * transaction overheads, the raw write path splits it further
+	 * if the bus requires.
 	 */
-	if (max - min > 1 && regmap_can_raw_write(map)) {
-		buf = kmalloc(val_bytes * (max - min), map->alloc_flags);
-		if (!buf) {
-			ret = -ENOMEM;
-			goto out;
-		}
+	if (count > 1)
+		ret = _regmap_raw_write(map, min, buf,
+					count * map->format.val_bytes, false);
+	else
+		ret = _regmap_write(map, min, map->format.parse_val(buf));
 
-		/* Render the data for a raw write */
-		for (r = min; r < max; r++) {
-			regcache_set_val(map, buf, r - min,
-					 entry[r - mas->index]);
-		}
+	rcu_read_lock();
 
-		ret = _regmap_raw_write(map, min, buf, (max - min) * val_bytes,
-					false);
+	return ret;
+}
 
-		kfree(buf);
-	} else {
-		for (r = min; r < max; r++) {
-			ret = _regmap_write(map, r,
-					    entry[r - mas->index]);
-			if (ret != 0)
-				goto out;
-		}
-	}
+static int regcache_maple_sync_single(struct regmap *map,
+				      struct ma_state *mas,
+				      unsigned int reg, unsigned int val)
+{
+	int ret;
+
+	mas_pause(mas);
+	rcu_read_unlock();
+
+	ret = _regmap_write(map, reg, val);
 
-out:
 	rcu_read_lock();
 
 	return ret;
@@ -244,8 +236,25 @@ static int regcache_maple_sync(struct regmap *map, unsigned int min,
 	unsigned long lmin = min;
 	unsigned long lmax = max;
 	unsigned int r, v, sync_start;
+	unsigned int count = 0, buf_regs = 0;
+	void *buf = NULL;
+	bool needs_sync;
 	int ret = 0;
-	bool sync_needed = false;
+
+	/*
+	 * Registers needing a sync are rendered into a single buffer
+	 * so that runs which continue across cache blocks still go out
+	 * as one raw write.
+	 */
+	if (regmap_can_raw_write(map) && !map->use_single_write) {
+		size_t buf_size = map->max_raw_write ?: PAGE_SIZE;
+
+		buf_regs = max_t(size_t, buf_size / map->format.val_bytes, 1);
+		buf = kmalloc_array(buf_regs, map->format.val_bytes,
+				    map->alloc_flags);
+		if (!buf)
+			return -ENOMEM;
+	}
 
 	map->cache_bypass = true;
 
@@ -254,39 +263,50 @@ static int regcache_maple_sync(struct regmap *map, unsigned int min,
 	mas_for_each(&mas, entry, max) {
 		for (r = max(mas.index, lmin); r <= min(mas.last, lmax); r++) {
 			v = entry[r - mas.index];
+			needs_sync = regcache_reg_needs_sync(map, r, v);
+
+			if (!buf) {
+				if (!needs_sync)
+					continue;
 
-			if (regcache_reg_needs_sync(map, r, v)) {
-				if (!sync_needed) {
-					sync_start = r;
-					sync_needed = true;
-				}
+				ret = regcache_maple_sync_single(map, &mas,
+								 r, v);
+				if (ret != 0)
+					goto out;
 				continue;
 			}
 
-			if (!sync_needed)
-				continue;
+			/* Flush the pending run if this doesn't extend it */
+			if (count && (!needs_sync || count == buf_regs ||
+				      r != sync_start + count)) {
+				ret = regcache_maple_sync_block(map, buf, &mas,
+								sync_start,
+								count);
+				if (ret != 0)
+					goto out;
+				count = 0;
+			}
 
-			ret = regcache_maple_sync_block(map, entry, &mas,
-							sync_start, r);
-			if (ret != 0)
-				goto out;
-			sync_needed = false;
-		}
+			if (!needs_sync)
+				continue;
 
-		if (sync_needed) {
-			ret = regcache_maple_sync_block(map, entry, &mas,
-							sync_start, r);
-			if (ret != 0)
-				goto out;
-			sync_needed = false;
+			if (!count)
+				sync_start = r;
+			regcache_set_val(map, buf, count++, v);
 		}
 	}
 
+	if (count)
+		ret = regcache_maple_sync_block(map, buf, &mas, sync_start,
+						count);
+
 out:
 	rcu_read_unlock();
 
 	map->cache_bypass = false;
 
+	kfree(buf);
+
 	return ret;
 }
 
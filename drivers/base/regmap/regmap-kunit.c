@@ -1963,6 +1963,61 @@ static void raw_sync(struct kunit *test)
 	KUNIT_EXPECT_MEMEQ(test, &hw_buf[2], &val[0], sizeof(val));
 }
 
+static void raw_batch(struct kunit *test)
+{
+	struct regmap *map;
+	struct regmap_config config;
+	struct regmap_ram_data *data;
+	u16 val[2];
+	u16 *hw_buf;
+	unsigned int rval;
+	int i;
+
+	config = raw_regmap_config;
+
+	map = gen_raw_regmap(test, &config, &data);
+	KUNIT_ASSERT_FALSE(test, IS_ERR(map));
+	if (IS_ERR(map))
+		return;
+
+	hw_buf = (u16 *)data->vals;
+
+	get_changed_bytes(&hw_buf[2], &val[0], sizeof(val));
+
+	for (i = 0; i < config.max_register + 1; i++)
+		data->written[i] = false;
+
+	KUNIT_EXPECT_EQ(test, 0, regmap_batch_begin(map));
+	KUNIT_EXPECT_EQ(test, -EBUSY, regmap_batch_begin(map));
+
+	/* Queue the writes out of order, overwriting one of them */
+	KUNIT_EXPECT_EQ(test, 0, regmap_write(map, 3, val[0]));
+	KUNIT_EXPECT_EQ(test, 0, regmap_write(map, 2, val[0]));
+	KUNIT_EXPECT_EQ(test, 0, regmap_write(map, 3, val[1]));
+
+	/* Nothing is written yet but the queued values can be read back */
+	for (i = 0; i < 2; i++) {
+		KUNIT_EXPECT_FALSE(test, data->written[i + 2]);
+		KUNIT_EXPECT_EQ(test, 0, regmap_read(map, i + 2, &rval));
+		KUNIT_EXPECT_EQ(test, val[i], rval);
+	}
+
+	KUNIT_EXPECT_EQ(test, 0, regmap_batch_commit(map));
+	KUNIT_EXPECT_EQ(test, -EINVAL, regmap_batch_commit(map));
+
+	for (i = 0; i < 2; i++) {
+		KUNIT_EXPECT_TRUE(test, data->written[i + 2]);
+
+		if (config.val_format_endian == REGMAP_ENDIAN_BIG)
+			val[i] = cpu_to_be16(val[i]);
+		else
+			val[i] = cpu_to_le16(val[i]);
+	}
+
+	/* The final values should now appear in the "hardware" */
+	KUNIT_EXPECT_MEMEQ(test, &hw_buf[2], &val[0], sizeof(val));
+}
+
 static void raw_ranges(struct kunit *test)
 {
 	struct regmap *map;
@@ -2063,6 +2118,7 @@ static struct kunit_case regmap_test_cases[] = {
 	KUNIT_CASE_PARAM(raw_write, raw_test_types_gen_params),
 	KUNIT_CASE_PARAM(raw_noinc_write, raw_test_types_gen_params),
 	KUNIT_CASE_PARAM(raw_sync, raw_test_cache_types_gen_params),
+	KUNIT_CASE_PARAM(raw_batch, raw_test_types_gen_params),
 	KUNIT_CASE_PARAM(raw_ranges, raw_test_cache_types_gen_params),
 	{}
 };
@@ -17,6 +17,7 @@
 #include <linux/delay.h>
 #include <linux/log2.h>
 #include <linux/hwspinlock.h>
+#include <linux/sort.h>
 #include <linux/unaligned.h>
 
 #define CREATE_TRACE_POINTS
@@ -1472,6 +1473,7 @@ void regmap_exit(struct regmap *map)
 		kfree(async->work_buf);
 		kfree(async);
 	}
+	kfree(map->batch);
 	if (map->hwlock)
 		hwspin_lock_free(map->hwlock);
 	if (map->lock == regmap_lock_mutex)
@@ -1911,6 +1913,50 @@ static inline void *_regmap_map_get_context(struct regmap *map)
 	return (map->bus || (!map->bus && map->read)) ? map : map->bus_context;
 }
 
+static struct reg_sequence *regmap_batch_find(struct regmap *map,
+					      unsigned int reg)
+{
+	unsigned int i;
+
+	for (i = map->batch_len; i > 0; i--)
+		if (map->batch[i - 1].reg == reg)
+			return &map->batch[i - 1];
+
+	return NULL;
+}
+
+static int regmap_batch_queue(struct regmap *map, unsigned int reg,
+			      unsigned int val)
+{
+	struct reg_sequence *entry;
+
+	/* A later write to a queued register simply replaces the value */
+	entry = regmap_batch_find(map, reg);
+	if (entry) {
+		entry->def = val;
+		return 0;
+	}
+
+	if (map->batch_len == map->batch_size) {
+		unsigned int size = max(2 * map->batch_size, 16U);
+
+		entry = krealloc_array(map->batch, size, sizeof(*entry),
+				       map->alloc_flags);
+		if (!entry)
+			return -ENOMEM;
+
+		map->batch = entry;
+		map->batch_size = size;
+	}
+
+	map->batch[map->batch_len++] = (struct reg_sequence) {
+		.reg = reg,
+		.def = val,
+	};
+
+	return 0;
+}
+
 int _regmap_write(struct regmap *map, unsigned int reg,
 		  unsigned int val)
 {
@@ -1920,6 +1966,9 @@ int _regmap_write(struct regmap *map, unsigned int reg,
 	if (!regmap_writeable(map, reg))
 		return -EIO;
 
+	if (map->batching)
+		return regmap_batch_queue(map, reg, val);
+
 	if (!map->cache_bypass && !map->defer_caching) {
 		ret = regcache_write(map, reg, val);
 		if (ret != 0)
@@ -2799,6 +2848,15 @@ static int _regmap_read(struct regmap *map, unsigned int reg,
 	int ret;
 	void *context = _regmap_map_get_context(map);
 
+	if (map->batching) {
+		struct reg_sequence *entry = regmap_batch_find(map, reg);
+
+		if (entry) {
+			*val = entry->def;
+			return 0;
+		}
+	}
+
 	if (!map->cache_bypass) {
 		ret = regcache_read(map, reg, val);
 		if (ret == 0)
@@ -3230,7 +3288,8 @@ static int _regmap_update_bits(struct regmap *map, unsigned int reg,
 	if (change)
 		*change = false;
 
-	if (regmap_volatile(map, reg) && map->reg_update_bits) {
+	if (regmap_volatile(map, reg) && map->reg_update_bits &&
+	    !map->batching) {
 		reg = regmap_reg_addr(map, reg);
 		ret = map->reg_update_bits(map->bus_context, reg, mask, val);
 		if (ret == 0 && change)
@@ -3383,6 +3442,146 @@ int regmap_async_complete(struct regmap *map)
 }
 EXPORT_SYMBOL_GPL(regmap_async_complete);
 
+/**
+ * regmap_batch_begin() - Start queueing register writes
+ *
+ * @map: Map to operate on.
+ *
+ * Until regmap_batch_commit() is called, single register writes made
+ * through regmap_write(), regmap_update_bits() and the functions built
+ * on them are queued rather than sent to the device.  Repeated writes to
+ * a register collapse into one, and reads of queued registers return
+ * the queued value.  This is intended for long initialisation sequences
+ * on slow buses where each write would otherwise be a bus transaction.
+ *
+ * As with regcache_sync(), queued writes reach the device in register
+ * order rather than in the order they were made, so this must only be
+ * used for sequences where that order does not matter to the device.
+ * Raw and bulk accesses bypass the queue and are not ordered against
+ * it, and delays in register sequences are lost for queued writes.
+ *
+ * Returns -EBUSY if a batch is already open.
+ */
+int regmap_batch_begin(struct regmap *map)
+{
+	int ret = 0;
+
+	map->lock(map->lock_arg);
+
+	if (map->batching)
+		ret = -EBUSY;
+	else
+		map->batching = true;
+
+	map->unlock(map->lock_arg);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(regmap_batch_begin);
+
+static int regmap_batch_cmp(const void *a, const void *b)
+{
+	const struct reg_sequence *ra = a, *rb = b;
+
+	if (ra->reg < rb->reg)
+		return -1;
+	return ra->reg > rb->reg;
+}
+
+static int regmap_batch_write_block(struct regmap *map,
+				    const struct reg_sequence *regs,
+				    unsigned int count)
+{
+	size_t val_bytes = map->format.val_bytes;
+	unsigned int i;
+	void *buf;
+	int ret;
+
+	buf = kmalloc_array(count, val_bytes, map->alloc_flags);
+	if (!buf)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++)
+		map->format.format_val(buf + i * val_bytes, regs[i].def, 0);
+
+	ret = _regmap_raw_write(map, regs[0].reg, buf, count * val_bytes,
+				false);
+
+	kfree(buf);
+
+	return ret;
+}
+
+static int _regmap_batch_flush(struct regmap *map)
+{
+	struct reg_sequence *regs = map->batch;
+	unsigned int n = map->batch_len;
+	bool raw = regmap_can_raw_write(map) && !map->use_single_write;
+	unsigned int i, j;
+	int ret = 0;
+
+	sort(regs, n, sizeof(*regs), regmap_batch_cmp, NULL);
+
+	for (i = 0; i < n; i = j) {
+		j = i + 1;
+
+		/* Gather registers that can go out in one raw block */
+		if (raw && !regmap_writeable_noinc(map, regs[i].reg)) {
+			while (j < n && !regmap_writeable_noinc(map, regs[j].reg) &&
+			       regs[j].reg == regs[j - 1].reg + map->reg_stride)
+				j++;
+		}
+
+		if (j - i > 1)
+			ret = regmap_batch_write_block(map, &regs[i], j - i);
+		else
+			ret = _regmap_write(map, regs[i].reg, regs[i].def);
+		if (ret) {
+			dev_err(map->dev, "Failed to write register %x: %d\n",
+				regs[i].reg, ret);
+			break;
+		}
+	}
+
+	map->batch_len = 0;
+
+	return ret;
+}
+
+/**
+ * regmap_batch_commit() - Write out queued register writes
+ *
+ * @map: Map to operate on.
+ *
+ * Ends the batch opened by regmap_batch_begin() and writes the queued
+ * values to the device, using a single raw write for each run of
+ * consecutive registers where the bus supports it.  On error the
+ * remaining queued writes are discarded.
+ *
+ * A value of zero will be returned on success, a negative errno will
+ * be returned in error cases.
+ */
+int regmap_batch_commit(struct regmap *map)
+{
+	int ret;
+
+	map->lock(map->lock_arg);
+
+	if (!map->batching) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	map->batching = false;
+	ret = _regmap_batch_flush(map);
+
+out:
+	map->unlock(map->lock_arg);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(regmap_batch_commit);
+
 /**
  * regmap_register_patch - Register and apply register updates to be applied
  *                         on device initialistion
@@ -71,6 +71,11 @@ define_id_show_func(cluster_id, "%d");
 static DEVICE_ATTR_RO(cluster_id);
 #endif
 
+#ifdef TOPOLOGY_LLC_SYSFS
+define_id_show_func(llc_id, "%d");
+static DEVICE_ATTR_RO(llc_id);
+#endif
+
 define_id_show_func(core_id, "%d");
 static DEVICE_ATTR_RO(core_id);
 
@@ -95,6 +100,12 @@ static const BIN_ATTR_RO(cluster_cpus, CPUMAP_FILE_MAX_BYTES);
 static const BIN_ATTR_RO(cluster_cpus_list, CPULIST_FILE_MAX_BYTES);
 #endif
 
+#ifdef TOPOLOGY_LLC_SYSFS
+define_siblings_read_func(llc_cpus, llc_cpumask);
+static const BIN_ATTR_RO(llc_cpus, CPUMAP_FILE_MAX_BYTES);
+static const BIN_ATTR_RO(llc_cpus_list, CPULIST_FILE_MAX_BYTES);
+#endif
+
 #ifdef TOPOLOGY_DIE_SYSFS
 define_siblings_read_func(die_cpus, die_cpumask);
 static const BIN_ATTR_RO(die_cpus, CPUMAP_FILE_MAX_BYTES);
@@ -132,6 +143,10 @@ static const struct bin_attribute *const bin_attrs[] = {
 	&bin_attr_cluster_cpus,
 	&bin_attr_cluster_cpus_list,
 #endif
+#ifdef TOPOLOGY_LLC_SYSFS
+	&bin_attr_llc_cpus,
+	&bin_attr_llc_cpus_list,
+#endif
 #ifdef TOPOLOGY_DIE_SYSFS
 	&bin_attr_die_cpus,
 	&bin_attr_die_cpus_list,
@@ -156,6 +171,9 @@ static struct attribute *default_attrs[] = {
 #endif
 #ifdef TOPOLOGY_CLUSTER_SYSFS
 	&dev_attr_cluster_id.attr,
+#endif
+#ifdef TOPOLOGY_LLC_SYSFS
+	&dev_attr_llc_id.attr,
 #endif
 	&dev_attr_core_id.attr,
 #ifdef TOPOLOGY_BOOK_SYSFS
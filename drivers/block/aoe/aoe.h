@@ -126,6 +126,7 @@ struct frame {
 	struct sk_buff *r_skb;		/* response skb for async processing */
 	struct buf *buf;
 	struct bvec_iter iter;
+	int iocid;			/* ktio queue chosen on receive */
 	char flags;
 };
 
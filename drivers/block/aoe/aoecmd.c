@@ -1204,11 +1204,12 @@ ktio(int id)
 		list_del(pos);
 		f = list_entry(pos, struct frame, head);
 		spin_unlock_irq(&iocq[id].lock);
+
+		/* The frame can be reused once completed. */
+		actual_id = f->iocid;
 		ktiocomplete(f);
 
 		/* Figure out if extra threads are required. */
-		actual_id = f->t->d->aoeminor % ncpus;
-
 		if (!kts[actual_id].active) {
 			BUG_ON(id != 0);
 			mutex_lock(&ktio_spawn_lock);
@@ -1272,7 +1273,12 @@ aoe_ktstart(struct ktstate *k)
 	return 0;
 }
 
-/* pass it off to kthreads for processing */
+/* pass it off to kthreads for processing
+ *
+ * The response is completed by the ktio thread of the CPU that received
+ * it, so that the receive side scaling of the network interfaces spreads
+ * the completions of a single device over several threads.
+ */
 static void
 ktcomplete(struct frame *f, struct sk_buff *skb)
 {
@@ -1280,7 +1286,8 @@ ktcomplete(struct frame *f, struct sk_buff *skb)
 	ulong flags;
 
 	f->r_skb = skb;
-	id = f->t->d->aoeminor % ncpus;
+	id = raw_smp_processor_id() % ncpus;
+	f->iocid = id;
 	spin_lock_irqsave(&iocq[id].lock, flags);
 	if (!kts[id].active) {
 		spin_unlock_irqrestore(&iocq[id].lock, flags);
@@ -107,6 +107,10 @@ static DEFINE_IDA(rssd_index_ida);
 
 static int mtip_block_initialize(struct driver_data *dd);
 
+static unsigned int poll_queues;
+module_param(poll_queues, uint, 0444);
+MODULE_PARM_DESC(poll_queues, "Number of IOPOLL hardware queues. Default: 0");
+
 #ifdef CONFIG_COMPAT
 struct mtip_compat_ide_task_request_s {
 	__u8		io_ports[8];
@@ -640,6 +644,47 @@ static void mtip_handle_tfe(struct driver_data *dd)
 	print_tags(dd, "reissued (TFE)", tagaccum, cmd_cnt);
 }
 
+/*
+ * Read and clear the completed register of a slot group. The commands
+ * returned are owned by the caller, which must complete them.
+ */
+static u32 mtip_claim_completed(struct mtip_port *port, int group)
+{
+	unsigned long flags;
+	u32 completed;
+
+	spin_lock_irqsave(&port->completed_lock[group], flags);
+	completed = readl(port->completed[group]);
+	if (completed)
+		writel(completed, port->completed[group]);
+	spin_unlock_irqrestore(&port->completed_lock[group], flags);
+
+	return completed;
+}
+
+static int mtip_complete_group(struct driver_data *dd, int group,
+			       u32 completed)
+{
+	struct mtip_cmd *command;
+	int tag, bit, nr = 0;
+
+	for (bit = 0; (bit < 32) && completed; bit++, completed >>= 1) {
+		if (!(completed & 0x01))
+			continue;
+		tag = (group << 5) | bit;
+
+		/* skip internal command slot. */
+		if (unlikely(tag == MTIP_TAG_INTERNAL))
+			continue;
+
+		command = mtip_cmd_from_tag(dd, tag);
+		mtip_complete_command(command, 0);
+		nr++;
+	}
+
+	return nr;
+}
+
 /*
  * Handle a set device bits interrupt
  */
@@ -647,30 +692,14 @@ static inline void mtip_workq_sdbfx(struct mtip_port *port, int group,
 							u32 completed)
 {
 	struct driver_data *dd = port->dd;
-	int tag, bit;
-	struct mtip_cmd *command;
 
 	if (!completed) {
 		WARN_ON_ONCE(!completed);
 		return;
 	}
-	/* clear completed status register in the hardware.*/
-	writel(completed, port->completed[group]);
 
 	/* Process completed commands. */
-	for (bit = 0; (bit < 32) && completed; bit++) {
-		if (completed & 0x01) {
-			tag = (group << 5) | bit;
-
-			/* skip internal command slot. */
-			if (unlikely(tag == MTIP_TAG_INTERNAL))
-				continue;
-
-			command = mtip_cmd_from_tag(dd, tag);
-			mtip_complete_command(command, 0);
-		}
-		completed >>= 1;
-	}
+	mtip_complete_group(dd, group, completed);
 
 	/* If last, re-enable interrupts */
 	if (atomic_dec_return(&dd->irq_workers_active) == 0)
@@ -754,7 +783,8 @@ static inline irqreturn_t mtip_handle_irq(struct driver_data *data)
 			for (i = 0, workers = 0; i < MTIP_MAX_SLOT_GROUPS;
 									i++) {
 				twork = &dd->work[i];
-				twork->completed = readl(port->completed[i]);
+				twork->completed =
+					mtip_claim_completed(port, i);
 				if (twork->completed)
 					workers++;
 			}
@@ -2734,8 +2764,10 @@ static int mtip_hw_init(struct driver_data *dd)
 	atomic_set(&dd->port->cmd_slot_unal, dd->unal_qdepth);
 
 	/* Spinlock to prevent concurrent issue */
-	for (i = 0; i < MTIP_MAX_SLOT_GROUPS; i++)
+	for (i = 0; i < MTIP_MAX_SLOT_GROUPS; i++) {
 		spin_lock_init(&dd->port->cmd_issue_lock[i]);
+		spin_lock_init(&dd->port->completed_lock[i]);
+	}
 
 	/* Set the port mmio base address. */
 	dd->port->mmio	= dd->mmio + PORT_OFFSET;
@@ -3370,12 +3402,63 @@ static enum blk_eh_timer_return mtip_cmd_timeout(struct request *req)
 	return BLK_EH_RESET_TIMER;
 }
 
+static void mtip_map_queues(struct blk_mq_tag_set *set)
+{
+	struct blk_mq_queue_map *map;
+
+	map = &set->map[HCTX_TYPE_DEFAULT];
+	map->nr_queues = 1;
+	map->queue_offset = 0;
+	blk_mq_map_queues(map);
+
+	if (set->nr_maps == 1)
+		return;
+
+	set->map[HCTX_TYPE_READ].nr_queues = 0;
+
+	map = &set->map[HCTX_TYPE_POLL];
+	map->nr_queues = set->nr_hw_queues - 1;
+	map->queue_offset = 1;
+	blk_mq_map_queues(map);
+}
+
+/*
+ * All hardware queues share the command slots of the single port: poll
+ * every slot group, completing whatever the interrupt handler has not
+ * claimed yet.
+ */
+static int mtip_poll(struct blk_mq_hw_ctx *hctx, struct io_comp_batch *iob)
+{
+	struct driver_data *dd = hctx->queue->queuedata;
+	struct mtip_port *port = dd->port;
+	u32 completed;
+	int group, nr = 0;
+
+	if (unlikely(port->flags & MTIP_PF_PAUSE_IO) ||
+	    unlikely(test_bit(MTIP_DDF_REMOVE_PENDING_BIT, &dd->dd_flag)))
+		return 0;
+
+	for (group = 0; group < dd->slot_groups; group++) {
+		if (!readl(port->completed[group]))
+			continue;
+		if (unlikely(readl(port->mmio + PORT_IRQ_STAT) == 0xFFFFFFFF))
+			return 0;
+		completed = mtip_claim_completed(port, group);
+		if (completed)
+			nr += mtip_complete_group(dd, group, completed);
+	}
+
+	return nr;
+}
+
 static const struct blk_mq_ops mtip_mq_ops = {
 	.queue_rq	= mtip_queue_rq,
 	.init_request	= mtip_init_cmd,
 	.exit_request	= mtip_free_cmd,
 	.complete	= mtip_softirq_done_fn,
 	.timeout        = mtip_cmd_timeout,
+	.map_queues	= mtip_map_queues,
+	.poll		= mtip_poll,
 };
 
 /*
@@ -3419,6 +3502,12 @@ static int mtip_block_initialize(struct driver_data *dd)
 	dd->tags.flags = BLK_MQ_F_SHOULD_MERGE;
 	dd->tags.driver_data = dd;
 	dd->tags.timeout = MTIP_NCQ_CMD_TIMEOUT_MS;
+	if (poll_queues) {
+		/* The command slots of the port are shared by all queues */
+		dd->tags.nr_hw_queues += min(poll_queues, nr_cpu_ids);
+		dd->tags.nr_maps = HCTX_MAX_TYPES;
+		dd->tags.flags |= BLK_MQ_F_TAG_HCTX_SHARED;
+	}
 
 	rv = blk_mq_alloc_tag_set(&dd->tags);
 	if (rv) {
@@ -411,6 +411,12 @@ struct mtip_port {
 
 	/* Spinlock for working around command-issue bug. */
 	spinlock_t cmd_issue_lock[MTIP_MAX_SLOT_GROUPS];
+
+	/*
+	 * Serializes reading and clearing of the completed registers between
+	 * the interrupt handler and the poll handler.
+	 */
+	spinlock_t completed_lock[MTIP_MAX_SLOT_GROUPS];
 };
 
 /*
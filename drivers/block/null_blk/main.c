@@ -9,6 +9,7 @@
 #include <linux/sched.h>
 #include <linux/fs.h>
 #include <linux/init.h>
+#include <linux/random.h>
 #include "null_blk.h"
 
 #undef pr_fmt
@@ -37,12 +38,72 @@ static inline u64 mb_per_tick(int mbps)
  * UP:		Device is currently on and visible in userspace.
  * THROTTLED:	Device is being throttled.
  * CACHE:	Device is using a write-back cache.
+ * LAT_MODEL:	Device completion times follow the latency model.
  */
 enum nullb_device_flags {
 	NULLB_DEV_FL_CONFIGURED	= 0,
 	NULLB_DEV_FL_UP		= 1,
 	NULLB_DEV_FL_THROTTLED	= 2,
 	NULLB_DEV_FL_CACHE	= 3,
+	NULLB_DEV_FL_LAT_MODEL	= 4,
+};
+
+/*
+ * Named latency model profiles. Selecting one through the "profile"
+ * attribute loads its values into the individual latency attributes, which
+ * can then be tuned further. The model is only used with irqmode=2 (timer).
+ */
+struct nullb_profile {
+	const char *name;
+	unsigned long read_nsec;
+	unsigned long write_nsec;
+	unsigned int lat_jitter;
+	unsigned int lat_tail_permille;
+	unsigned long lat_tail_nsec;
+	unsigned long qd_nsec;
+	unsigned int gc_interval_mb;
+	unsigned long gc_stall_nsec;
+	unsigned int queue_mbps;
+};
+
+static const struct nullb_profile nullb_profiles[] = {
+	{
+		.name			= "none",
+	},
+	{
+		.name			= "nvme",
+		.read_nsec		= 80 * NSEC_PER_USEC,
+		.write_nsec		= 15 * NSEC_PER_USEC,
+		.lat_jitter		= 20,
+		.lat_tail_permille	= 1,
+		.lat_tail_nsec		= 500 * NSEC_PER_USEC,
+		.qd_nsec		= 500,
+		.gc_interval_mb		= 4096,
+		.gc_stall_nsec		= 2 * NSEC_PER_MSEC,
+		.queue_mbps		= 3000,
+	},
+	{
+		.name			= "sata-ssd",
+		.read_nsec		= 100 * NSEC_PER_USEC,
+		.write_nsec		= 50 * NSEC_PER_USEC,
+		.lat_jitter		= 25,
+		.lat_tail_permille	= 5,
+		.lat_tail_nsec		= 2 * NSEC_PER_MSEC,
+		.qd_nsec		= 2 * NSEC_PER_USEC,
+		.gc_interval_mb		= 1024,
+		.gc_stall_nsec		= 10 * NSEC_PER_MSEC,
+		.queue_mbps		= 500,
+	},
+	{
+		.name			= "hdd",
+		.read_nsec		= 4 * NSEC_PER_MSEC,
+		.write_nsec		= 4 * NSEC_PER_MSEC,
+		.lat_jitter		= 50,
+		.lat_tail_permille	= 20,
+		.lat_tail_nsec		= 20 * NSEC_PER_MSEC,
+		.qd_nsec		= 0,
+		.queue_mbps		= 180,
+	},
 };
 
 #define MAP_SZ		((PAGE_SIZE >> SECTOR_SHIFT) + 2)
@@ -468,6 +529,17 @@ NULLB_DEVICE_ATTR(no_sched, bool, NULL);
 NULLB_DEVICE_ATTR(shared_tags, bool, NULL);
 NULLB_DEVICE_ATTR(shared_tag_bitmap, bool, NULL);
 NULLB_DEVICE_ATTR(fua, bool, NULL);
+NULLB_DEVICE_ATTR(read_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(write_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(lat_jitter, uint, NULL);
+NULLB_DEVICE_ATTR(lat_tail_permille, uint, NULL);
+NULLB_DEVICE_ATTR(lat_tail_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(qd_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(gc_interval_mb, uint, NULL);
+NULLB_DEVICE_ATTR(gc_stall_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(queue_mbps, uint, NULL);
+NULLB_DEVICE_ATTR(zone_reset_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(zone_finish_nsec, ulong, NULL);
 
 static ssize_t nullb_device_power_show(struct config_item *item, char *page)
 {
@@ -586,6 +658,51 @@ static ssize_t nullb_device_zone_offline_store(struct config_item *item,
 }
 CONFIGFS_ATTR_WO(nullb_device_, zone_offline);
 
+static ssize_t nullb_device_profile_show(struct config_item *item, char *page)
+{
+	struct nullb_device *dev = to_nullb_device(item);
+
+	return snprintf(page, PAGE_SIZE, "%s\n",
+			nullb_profiles[dev->profile].name);
+}
+
+static ssize_t nullb_device_profile_store(struct config_item *item,
+					  const char *page, size_t count)
+{
+	struct nullb_device *dev = to_nullb_device(item);
+	const struct nullb_profile *p;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(nullb_profiles); i++) {
+		if (sysfs_streq(page, nullb_profiles[i].name))
+			break;
+	}
+	if (i == ARRAY_SIZE(nullb_profiles))
+		return -EINVAL;
+
+	mutex_lock(&lock);
+	if (test_bit(NULLB_DEV_FL_CONFIGURED, &dev->flags)) {
+		mutex_unlock(&lock);
+		return -EBUSY;
+	}
+
+	p = &nullb_profiles[i];
+	dev->profile = i;
+	dev->read_nsec = p->read_nsec;
+	dev->write_nsec = p->write_nsec;
+	dev->lat_jitter = p->lat_jitter;
+	dev->lat_tail_permille = p->lat_tail_permille;
+	dev->lat_tail_nsec = p->lat_tail_nsec;
+	dev->qd_nsec = p->qd_nsec;
+	dev->gc_interval_mb = p->gc_interval_mb;
+	dev->gc_stall_nsec = p->gc_stall_nsec;
+	dev->queue_mbps = p->queue_mbps;
+	mutex_unlock(&lock);
+
+	return count;
+}
+CONFIGFS_ATTR(nullb_device_, profile);
+
 static struct configfs_attribute *nullb_device_attrs[] = {
 	&nullb_device_attr_size,
 	&nullb_device_attr_completion_nsec,
@@ -621,6 +738,18 @@ static struct configfs_attribute *nullb_device_attrs[] = {
 	&nullb_device_attr_shared_tags,
 	&nullb_device_attr_shared_tag_bitmap,
 	&nullb_device_attr_fua,
+	&nullb_device_attr_profile,
+	&nullb_device_attr_read_nsec,
+	&nullb_device_attr_write_nsec,
+	&nullb_device_attr_lat_jitter,
+	&nullb_device_attr_lat_tail_permille,
+	&nullb_device_attr_lat_tail_nsec,
+	&nullb_device_attr_qd_nsec,
+	&nullb_device_attr_gc_interval_mb,
+	&nullb_device_attr_gc_stall_nsec,
+	&nullb_device_attr_queue_mbps,
+	&nullb_device_attr_zone_reset_nsec,
+	&nullb_device_attr_zone_finish_nsec,
 	NULL,
 };
 
@@ -706,7 +835,10 @@ static ssize_t memb_group_features_show(struct config_item *item, char *page)
 			"shared_tags,size,submit_queues,use_per_node_hctx,"
 			"virt_boundary,zoned,zone_capacity,zone_max_active,"
 			"zone_max_open,zone_nr_conv,zone_offline,zone_readonly,"
-			"zone_size,zone_append_max_sectors,zone_full\n");
+			"zone_size,zone_append_max_sectors,zone_full,profile,"
+			"read_nsec,write_nsec,lat_jitter,lat_tail_permille,"
+			"lat_tail_nsec,qd_nsec,gc_interval_mb,gc_stall_nsec,"
+			"queue_mbps,zone_reset_nsec,zone_finish_nsec\n");
 }
 
 CONFIGFS_ATTR_RO(memb_group_, features);
@@ -811,13 +943,103 @@ static enum hrtimer_restart null_cmd_timer_expired(struct hrtimer *timer)
 {
 	struct nullb_cmd *cmd = container_of(timer, struct nullb_cmd, timer);
 
+	if (test_bit(NULLB_DEV_FL_LAT_MODEL, &cmd->nq->dev->flags))
+		atomic_dec(&cmd->nq->nr_inflight);
 	blk_mq_end_request(blk_mq_rq_from_pdu(cmd), cmd->error);
 	return HRTIMER_NORESTART;
 }
 
+/*
+ * Reserve the transfer of @bytes on the hardware queue and return the time
+ * at which it ends: transfers on one queue are serialized at queue_mbps.
+ */
+static u64 null_queue_bw_reserve(struct nullb_queue *nq, u64 now,
+				 unsigned int bytes)
+{
+	u64 xfer = div64_u64((u64)bytes * NSEC_PER_SEC,
+			     (u64)nq->dev->queue_mbps << 20);
+	u64 end;
+
+	spin_lock(&nq->bw_lock);
+	end = max(now, nq->bw_next_ns) + xfer;
+	nq->bw_next_ns = end;
+	spin_unlock(&nq->bw_lock);
+
+	return end;
+}
+
+/*
+ * Every gc_interval_mb of data written, stall the whole device for
+ * gc_stall_nsec. Commands completing during a stall wait for its end.
+ */
+static u64 null_gc_stall_end(struct nullb *nullb, struct request *rq, u64 now)
+{
+	struct nullb_device *dev = nullb->dev;
+	unsigned int bytes = blk_rq_bytes(rq);
+	u64 written;
+
+	if (op_is_write(req_op(rq)) && bytes) {
+		written = atomic64_add_return(bytes, &nullb->gc_written);
+		if (div_u64(written >> 20, dev->gc_interval_mb) !=
+		    div_u64((written - bytes) >> 20, dev->gc_interval_mb))
+			atomic64_set(&nullb->gc_stall_end,
+				     now + dev->gc_stall_nsec);
+	}
+
+	return atomic64_read(&nullb->gc_stall_end);
+}
+
+static u64 null_cmd_latency(struct nullb_cmd *cmd)
+{
+	struct request *rq = blk_mq_rq_from_pdu(cmd);
+	struct nullb_queue *nq = cmd->nq;
+	struct nullb_device *dev = nq->dev;
+	u64 lat, now, end;
+
+	switch (req_op(rq)) {
+	case REQ_OP_ZONE_RESET:
+	case REQ_OP_ZONE_RESET_ALL:
+		lat = dev->zone_reset_nsec;
+		break;
+	case REQ_OP_ZONE_FINISH:
+		lat = dev->zone_finish_nsec;
+		break;
+	default:
+		lat = op_is_write(req_op(rq)) ? dev->write_nsec :
+						dev->read_nsec;
+		break;
+	}
+	if (!lat)
+		lat = dev->completion_nsec;
+
+	if (dev->lat_jitter) {
+		u32 span = min_t(u64, lat * dev->lat_jitter / 100, U32_MAX / 2);
+
+		lat = lat - span + get_random_u32_below(2 * span + 1);
+	}
+	if (dev->lat_tail_permille &&
+	    get_random_u32_below(1000) < dev->lat_tail_permille)
+		lat += dev->lat_tail_nsec;
+	lat += (u64)dev->qd_nsec * atomic_inc_return(&nq->nr_inflight);
+
+	now = ktime_get_ns();
+	if (dev->queue_mbps)
+		end = null_queue_bw_reserve(nq, now, blk_rq_bytes(rq)) + lat;
+	else
+		end = now + lat;
+	if (dev->gc_interval_mb)
+		end = max(end, null_gc_stall_end(dev->nullb, rq, now));
+
+	return end - now;
+}
+
 static void null_cmd_end_timer(struct nullb_cmd *cmd)
 {
-	ktime_t kt = cmd->nq->dev->completion_nsec;
+	struct nullb_device *dev = cmd->nq->dev;
+	ktime_t kt = dev->completion_nsec;
+
+	if (test_bit(NULLB_DEV_FL_LAT_MODEL, &dev->flags))
+		kt = null_cmd_latency(cmd);
 
 	hrtimer_start(&cmd->timer, kt, HRTIMER_MODE_REL);
 }
@@ -1661,6 +1883,9 @@ static void null_init_queue(struct nullb *nullb, struct nullb_queue *nq)
 	nq->dev = nullb->dev;
 	INIT_LIST_HEAD(&nq->poll_list);
 	spin_lock_init(&nq->poll_lock);
+	atomic_set(&nq->nr_inflight, 0);
+	spin_lock_init(&nq->bw_lock);
+	nq->bw_next_ns = 0;
 }
 
 static int null_init_hctx(struct blk_mq_hw_ctx *hctx, void *driver_data,
@@ -1853,6 +2078,22 @@ static int null_validate_conf(struct nullb_device *dev)
 						dev->cache_size);
 	dev->mbps = min_t(unsigned int, 1024 * 40, dev->mbps);
 
+	if (dev->read_nsec || dev->write_nsec || dev->lat_jitter ||
+	    dev->lat_tail_permille || dev->qd_nsec || dev->gc_interval_mb ||
+	    dev->queue_mbps || dev->zone_reset_nsec || dev->zone_finish_nsec) {
+		if (dev->irqmode != NULL_IRQ_TIMER) {
+			pr_err("latency model requires irqmode=%d\n",
+			       NULL_IRQ_TIMER);
+			return -EINVAL;
+		}
+		dev->lat_jitter = min_t(unsigned int, dev->lat_jitter, 100);
+		dev->lat_tail_permille = min_t(unsigned int,
+					       dev->lat_tail_permille, 1000);
+		set_bit(NULLB_DEV_FL_LAT_MODEL, &dev->flags);
+	} else {
+		clear_bit(NULLB_DEV_FL_LAT_MODEL, &dev->flags);
+	}
+
 	if (dev->zoned &&
 	    (!dev->zone_size || !is_power_of_2(dev->zone_size))) {
 		pr_err("zone_size must be power-of-two\n");
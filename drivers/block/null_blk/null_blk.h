@@ -28,6 +28,11 @@ struct nullb_queue {
 
 	struct list_head poll_list;
 	spinlock_t poll_lock;
+
+	/* Latency model state, see null_cmd_latency() */
+	atomic_t nr_inflight;
+	spinlock_t bw_lock;
+	u64 bw_next_ns;
 };
 
 struct nullb_zone {
@@ -48,6 +53,8 @@ struct nullb_zone {
 	sector_t wp;
 	unsigned int len;
 	unsigned int capacity;
+	/* entry in imp_open_zones, protected by zone_res_lock */
+	struct list_head imp_open;
 };
 
 struct nullb_device {
@@ -68,7 +75,7 @@ struct nullb_device {
 	unsigned int nr_zones_imp_open;
 	unsigned int nr_zones_exp_open;
 	unsigned int nr_zones_closed;
-	unsigned int imp_close_zone_no;
+	struct list_head imp_open_zones; /* implicitly open zones, FIFO order */
 	struct nullb_zone *zones;
 	sector_t zone_size_sects;
 	bool need_zone_res_mgmt;
@@ -95,6 +102,18 @@ struct nullb_device {
 	unsigned int hw_queue_depth; /* queue depth */
 	unsigned int index; /* index of the disk, only valid with a disk */
 	unsigned int mbps; /* Bandwidth throttle cap (in MB/s) */
+	unsigned int profile; /* latency model profile, see nullb_profiles */
+	unsigned long read_nsec; /* base read latency, completion_nsec if 0 */
+	unsigned long write_nsec; /* base write latency, completion_nsec if 0 */
+	unsigned int lat_jitter; /* uniform latency jitter in percent */
+	unsigned int lat_tail_permille; /* probability of a tail latency */
+	unsigned long lat_tail_nsec; /* latency added to tail commands */
+	unsigned long qd_nsec; /* latency added per command in flight */
+	unsigned int gc_interval_mb; /* MB written between two GC stalls */
+	unsigned long gc_stall_nsec; /* duration of a GC stall */
+	unsigned int queue_mbps; /* bandwidth cap per hardware queue (MB/s) */
+	unsigned long zone_reset_nsec; /* latency of a zone reset */
+	unsigned long zone_finish_nsec; /* latency of a zone finish */
 	bool blocking; /* blocking blk-mq device */
 	bool use_per_node_hctx; /* use per-node allocation for hardware context */
 	bool power; /* power on/off the device */
@@ -119,6 +138,8 @@ struct nullb {
 	struct blk_mq_tag_set __tag_set;
 	atomic_long_t cur_bytes;
 	struct hrtimer bw_timer;
+	atomic64_t gc_written;
+	atomic64_t gc_stall_end;
 	unsigned long cache_flush_pos;
 	spinlock_t lock;
 
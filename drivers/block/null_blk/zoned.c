@@ -125,12 +125,13 @@ int null_init_zoned_dev(struct nullb_device *dev,
 		pr_info("zone_max_open limit disabled, limit >= zone count\n");
 	}
 	dev->need_zone_res_mgmt = dev->zone_max_active || dev->zone_max_open;
-	dev->imp_close_zone_no = dev->zone_nr_conv;
+	INIT_LIST_HEAD(&dev->imp_open_zones);
 
 	for (i = 0; i <  dev->zone_nr_conv; i++) {
 		zone = &dev->zones[i];
 
 		null_init_zone_lock(dev, zone);
+		INIT_LIST_HEAD(&zone->imp_open);
 		zone->start = sector;
 		zone->len = dev->zone_size_sects;
 		zone->capacity = zone->len;
@@ -145,6 +146,7 @@ int null_init_zoned_dev(struct nullb_device *dev,
 		zone = &dev->zones[i];
 
 		null_init_zone_lock(dev, zone);
+		INIT_LIST_HEAD(&zone->imp_open);
 		zone->start = sector;
 		if (zone->start + dev->zone_size_sects > dev_capacity_sects)
 			zone->len = dev_capacity_sects - zone->start;
@@ -255,32 +257,41 @@ size_t null_zone_valid_read_len(struct nullb *nullb,
 	return (zone->wp - sector) << SECTOR_SHIFT;
 }
 
+/*
+ * Implicitly open zones are kept in the order they were opened (FIFO), so
+ * that the zone closed to make room for a new one, the one opened first, is
+ * found without scanning the zone array. Writes do not reorder the list.
+ * Called with zone_res_lock held.
+ */
+static void null_add_imp_open_zone(struct nullb_device *dev,
+				   struct nullb_zone *zone)
+{
+	dev->nr_zones_imp_open++;
+	list_add_tail(&zone->imp_open, &dev->imp_open_zones);
+}
+
+static void null_del_imp_open_zone(struct nullb_device *dev,
+				   struct nullb_zone *zone)
+{
+	dev->nr_zones_imp_open--;
+	list_del_init(&zone->imp_open);
+}
+
 static void null_close_imp_open_zone(struct nullb_device *dev)
 {
 	struct nullb_zone *zone;
-	unsigned int zno, i;
 
-	zno = dev->imp_close_zone_no;
-	if (zno >= dev->nr_zones)
-		zno = dev->zone_nr_conv;
+	zone = list_first_entry_or_null(&dev->imp_open_zones,
+					struct nullb_zone, imp_open);
+	if (!zone)
+		return;
 
-	for (i = dev->zone_nr_conv; i < dev->nr_zones; i++) {
-		zone = &dev->zones[zno];
-		zno++;
-		if (zno >= dev->nr_zones)
-			zno = dev->zone_nr_conv;
-
-		if (zone->cond == BLK_ZONE_COND_IMP_OPEN) {
-			dev->nr_zones_imp_open--;
-			if (zone->wp == zone->start) {
-				zone->cond = BLK_ZONE_COND_EMPTY;
-			} else {
-				zone->cond = BLK_ZONE_COND_CLOSED;
-				dev->nr_zones_closed++;
-			}
-			dev->imp_close_zone_no = zno;
-			return;
-		}
+	null_del_imp_open_zone(dev, zone);
+	if (zone->wp == zone->start) {
+		zone->cond = BLK_ZONE_COND_EMPTY;
+	} else {
+		zone->cond = BLK_ZONE_COND_CLOSED;
+		dev->nr_zones_closed++;
 	}
 }
 
@@ -401,9 +412,9 @@ static blk_status_t null_zone_write(struct nullb_cmd *cmd, sector_t sector,
 			}
 			if (zone->cond == BLK_ZONE_COND_CLOSED) {
 				dev->nr_zones_closed--;
-				dev->nr_zones_imp_open++;
+				null_add_imp_open_zone(dev, zone);
 			} else if (zone->cond == BLK_ZONE_COND_EMPTY) {
-				dev->nr_zones_imp_open++;
+				null_add_imp_open_zone(dev, zone);
 			}
 
 			spin_unlock(&dev->zone_res_lock);
@@ -423,7 +434,7 @@ static blk_status_t null_zone_write(struct nullb_cmd *cmd, sector_t sector,
 			if (zone->cond == BLK_ZONE_COND_EXP_OPEN)
 				dev->nr_zones_exp_open--;
 			else if (zone->cond == BLK_ZONE_COND_IMP_OPEN)
-				dev->nr_zones_imp_open--;
+				null_del_imp_open_zone(dev, zone);
 			spin_unlock(&dev->zone_res_lock);
 		}
 		zone->cond = BLK_ZONE_COND_FULL;
@@ -470,7 +481,7 @@ static blk_status_t null_open_zone(struct nullb_device *dev,
 			}
 			break;
 		case BLK_ZONE_COND_IMP_OPEN:
-			dev->nr_zones_imp_open--;
+			null_del_imp_open_zone(dev, zone);
 			break;
 		case BLK_ZONE_COND_CLOSED:
 			ret = null_check_zone_resources(dev, zone);
@@ -518,7 +529,7 @@ static blk_status_t null_close_zone(struct nullb_device *dev,
 
 		switch (zone->cond) {
 		case BLK_ZONE_COND_IMP_OPEN:
-			dev->nr_zones_imp_open--;
+			null_del_imp_open_zone(dev, zone);
 			break;
 		case BLK_ZONE_COND_EXP_OPEN:
 			dev->nr_zones_exp_open--;
@@ -565,7 +576,7 @@ static blk_status_t null_finish_zone(struct nullb_device *dev,
 			}
 			break;
 		case BLK_ZONE_COND_IMP_OPEN:
-			dev->nr_zones_imp_open--;
+			null_del_imp_open_zone(dev, zone);
 			break;
 		case BLK_ZONE_COND_EXP_OPEN:
 			dev->nr_zones_exp_open--;
@@ -603,7 +614,7 @@ static blk_status_t null_reset_zone(struct nullb_device *dev,
 
 		switch (zone->cond) {
 		case BLK_ZONE_COND_IMP_OPEN:
-			dev->nr_zones_imp_open--;
+			null_del_imp_open_zone(dev, zone);
 			break;
 		case BLK_ZONE_COND_EXP_OPEN:
 			dev->nr_zones_exp_open--;
@@ -717,6 +728,14 @@ blk_status_t null_process_zoned_cmd(struct nullb_cmd *cmd, enum req_op op,
 		if (zone->cond == BLK_ZONE_COND_OFFLINE)
 			return BLK_STS_IOERR;
 
+		/*
+		 * Without memory backing, there is no data to check against
+		 * the write pointer: do not serialize reads with the writes
+		 * and zone management operations of the zone.
+		 */
+		if (!dev->memory_backed)
+			return null_process_cmd(cmd, op, sector, nr_sectors);
+
 		null_lock_zone(dev, zone);
 		sts = null_process_cmd(cmd, op, sector, nr_sectors);
 		null_unlock_zone(dev, zone);
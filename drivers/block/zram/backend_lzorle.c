@@ -6,6 +6,13 @@
 
 #include "backend_lzorle.h"
 
+/*
+ * Pages without a single match in their first quarter are practically
+ * never worth storing compressed, so don't spend the rest of the page on
+ * finding out.
+ */
+#define LZORLE_PROBE_SHIFT	2
+
 static void lzorle_release_params(struct zcomp_params *params)
 {
 }
@@ -33,8 +40,14 @@ static int lzorle_compress(struct zcomp_params *params, struct zcomp_ctx *ctx,
 {
 	int ret;
 
-	ret = lzorle1x_1_compress(req->src, req->src_len, req->dst,
-				  &req->dst_len, ctx->context);
+	ret = lzorle1x_1_compress_probe(req->src, req->src_len, req->dst,
+					&req->dst_len, ctx->context,
+					req->src_len >> LZORLE_PROBE_SHIFT);
+	if (ret == LZO_E_NOT_COMPRESSIBLE) {
+		/* Reported as no gain, zram then stores the page as is */
+		req->dst_len = req->src_len;
+		return 0;
+	}
 	return ret == LZO_E_OK ? 0 : ret;
 }
 
@@ -9,6 +9,7 @@
 #include <linux/cpu.h>
 #include <linux/crypto.h>
 #include <linux/vmalloc.h>
+#include <linux/highmem.h>
 
 #include "zcomp.h"
 
@@ -59,10 +60,12 @@ static int zcomp_strm_init(struct zcomp *comp, struct zcomp_strm *zstrm)
 		return ret;
 
 	/*
-	 * allocate 2 pages. 1 for compressed data, plus 1 extra for the
-	 * case when compressed size is larger than the original one
+	 * allocate ZCOMP_STRM_BUF_SIZE. A single page compression needs 2
+	 * pages: 1 for compressed data, plus 1 extra for the case when
+	 * compressed size is larger than the original one. Batched
+	 * compression packs several objects into the same buffer.
 	 */
-	zstrm->buffer = vzalloc(2 * PAGE_SIZE);
+	zstrm->buffer = vzalloc(ZCOMP_STRM_BUF_SIZE);
 	if (!zstrm->buffer) {
 		zcomp_strm_free(comp, zstrm);
 		return -ENOMEM;
@@ -135,6 +138,56 @@ int zcomp_compress(struct zcomp *comp, struct zcomp_strm *zstrm,
 	return ret;
 }
 
+static int zcomp_compress_page(struct zcomp *comp, struct zcomp_strm *zstrm,
+			       struct page *page, void *dst,
+			       unsigned int *dst_len)
+{
+	void *src = kmap_local_page(page);
+	struct zcomp_req req = {
+		.src = src,
+		.dst = dst,
+		.src_len = PAGE_SIZE,
+		.dst_len = 2 * PAGE_SIZE,
+	};
+	int ret;
+
+	ret = comp->ops->compress(comp->params, &zstrm->ctx, &req);
+	kunmap_local(src);
+	if (!ret)
+		*dst_len = req.dst_len;
+	return ret;
+}
+
+/*
+ * Compress up to @nr pages on one (already acquired) stream. Compressed
+ * objects are packed back to back in zstrm->buffer, the length of the
+ * i-th object is returned in @dst_len[i]; its offset is the sum of the
+ * lengths of the preceding objects.
+ *
+ * Returns the number of compressed pages, which can be less than @nr
+ * when the stream buffer runs out of space, or a negative error code.
+ */
+int zcomp_compress_batch(struct zcomp *comp, struct zcomp_strm *zstrm,
+			 struct page **pages, unsigned int nr,
+			 unsigned int *dst_len)
+{
+	unsigned int i, off = 0;
+	int ret;
+
+	for (i = 0; i < nr; i++) {
+		if (ZCOMP_STRM_BUF_SIZE - off < 2 * PAGE_SIZE)
+			break;
+
+		ret = zcomp_compress_page(comp, zstrm, pages[i],
+					  zstrm->buffer + off, &dst_len[i]);
+		if (ret)
+			return ret;
+		off += dst_len[i];
+	}
+
+	return i;
+}
+
 int zcomp_decompress(struct zcomp *comp, struct zcomp_strm *zstrm,
 		     const void *src, unsigned int src_len, void *dst)
 {
@@ -7,6 +7,15 @@
 
 #define ZCOMP_PARAM_NO_LEVEL	INT_MIN
 
+/* Max number of pages compressed by one zcomp_compress_batch() call */
+#define ZCOMP_BATCH_PAGES	8
+/*
+ * Batched compression packs objects back to back in the stream buffer.
+ * A single object can take up to 2 pages, so one extra page on top of
+ * ZCOMP_BATCH_PAGES guarantees forward progress for every call.
+ */
+#define ZCOMP_STRM_BUF_SIZE	((ZCOMP_BATCH_PAGES + 1) * PAGE_SIZE)
+
 /*
  * Immutable driver (backend) parameters. The driver may attach private
  * data to it (e.g. driver representation of the dictionary, etc.).
@@ -81,6 +90,9 @@ void zcomp_stream_put(struct zcomp *comp);
 
 int zcomp_compress(struct zcomp *comp, struct zcomp_strm *zstrm,
 		   const void *src, unsigned int *dst_len);
+int zcomp_compress_batch(struct zcomp *comp, struct zcomp_strm *zstrm,
+			 struct page **pages, unsigned int nr,
+			 unsigned int *dst_len);
 int zcomp_decompress(struct zcomp *comp, struct zcomp_strm *zstrm,
 		     const void *src, unsigned int src_len, void *dst);
 
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Deduplication of identical pages stored in zram.
+ *
+ * Stored objects are indexed by a checksum of the uncompressed page.
+ * Compression is deterministic for a given algorithm and dictionary,
+ * so identical pages compress to identical objects and a candidate is
+ * confirmed by comparing the freshly compressed data with the stored
+ * object.
+ */
+
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/highmem.h>
+#include <linux/xxhash.h>
+
+#include "zram_drv.h"
+
+/* One hash bucket per this many device pages */
+#define ZRAM_HASH_PAGES_PER_BUCKET	8
+
+u64 zram_dedup_checksum(struct page *page)
+{
+	void *mem;
+	u64 checksum;
+
+	mem = kmap_local_page(page);
+	checksum = xxh64(mem, PAGE_SIZE, 0);
+	kunmap_local(mem);
+
+	return checksum;
+}
+
+static struct zram_hash *zram_dedup_bucket(struct zram *zram, u64 checksum)
+{
+	return &zram->hash[checksum & (zram->hash_size - 1)];
+}
+
+/*
+ * Looks up an object identical to @buf, the compressed @page, and takes
+ * a reference on it. Huge objects are stored as is, so those are
+ * compared against @page itself.
+ */
+struct zram_entry *zram_dedup_find(struct zram *zram, u64 checksum,
+				   struct page *page, const void *buf,
+				   unsigned int len, u32 gen)
+{
+	struct zram_hash *hash;
+	struct zram_entry *entry, *found = NULL;
+	const void *src = buf;
+	void *mem;
+
+	if (!zram_dedup_enabled(zram))
+		return NULL;
+
+	if (len == PAGE_SIZE)
+		src = kmap_local_page(page);
+
+	hash = zram_dedup_bucket(zram, checksum);
+	spin_lock(&hash->lock);
+	hlist_for_each_entry(entry, &hash->head, node) {
+		bool match;
+
+		if (entry->checksum != checksum || entry->len != len ||
+		    entry->gen != gen)
+			continue;
+
+		mem = zs_map_object(zram->mem_pool, entry->handle, ZS_MM_RO);
+		match = !memcmp(mem, src, len);
+		zs_unmap_object(zram->mem_pool, entry->handle);
+
+		if (match) {
+			entry->refcount++;
+			found = entry;
+			break;
+		}
+	}
+	spin_unlock(&hash->lock);
+
+	if (len == PAGE_SIZE)
+		kunmap_local(src);
+
+	if (found) {
+		atomic64_add(len, &zram->stats.dup_data_size);
+		atomic64_inc(&zram->stats.dup_pages);
+	}
+	return found;
+}
+
+/*
+ * Makes a newly stored object available for deduplication. Returns NULL
+ * if the entry cannot be allocated, in which case the caller keeps the
+ * plain handle.
+ */
+struct zram_entry *zram_dedup_insert(struct zram *zram, u64 checksum,
+				     unsigned long handle, unsigned int len,
+				     u32 gen)
+{
+	struct zram_hash *hash;
+	struct zram_entry *entry;
+
+	if (!zram_dedup_enabled(zram))
+		return NULL;
+
+	entry = kmalloc(sizeof(*entry), GFP_NOIO | __GFP_NOWARN);
+	if (!entry)
+		return NULL;
+
+	entry->checksum = checksum;
+	entry->handle = handle;
+	entry->len = len;
+	entry->gen = gen;
+	entry->refcount = 1;
+
+	hash = zram_dedup_bucket(zram, checksum);
+	spin_lock(&hash->lock);
+	hlist_add_head(&entry->node, &hash->head);
+	spin_unlock(&hash->lock);
+
+	atomic64_add(sizeof(*entry), &zram->stats.meta_data_size);
+	return entry;
+}
+
+/*
+ * Drops a slot reference. The object is released together with the
+ * last reference.
+ */
+void zram_dedup_put(struct zram *zram, struct zram_entry *entry)
+{
+	struct zram_hash *hash = zram_dedup_bucket(zram, entry->checksum);
+	unsigned int refcount;
+
+	spin_lock(&hash->lock);
+	refcount = --entry->refcount;
+	if (!refcount)
+		hlist_del(&entry->node);
+	spin_unlock(&hash->lock);
+
+	if (refcount) {
+		atomic64_sub(entry->len, &zram->stats.dup_data_size);
+		atomic64_dec(&zram->stats.dup_pages);
+		return;
+	}
+
+	zs_free(zram->mem_pool, entry->handle);
+	atomic64_sub(entry->len, &zram->stats.compr_data_size);
+	atomic64_sub(sizeof(*entry), &zram->stats.meta_data_size);
+	kfree(entry);
+}
+
+int zram_dedup_init(struct zram *zram, size_t num_pages)
+{
+	size_t i;
+
+	if (!zram_dedup_enabled(zram))
+		return 0;
+
+	zram->hash_size = roundup_pow_of_two(max_t(size_t, 1,
+			num_pages / ZRAM_HASH_PAGES_PER_BUCKET));
+	zram->hash = vzalloc(array_size(zram->hash_size, sizeof(*zram->hash)));
+	if (!zram->hash)
+		return -ENOMEM;
+
+	for (i = 0; i < zram->hash_size; i++) {
+		spin_lock_init(&zram->hash[i].lock);
+		INIT_HLIST_HEAD(&zram->hash[i].head);
+	}
+	return 0;
+}
+
+void zram_dedup_fini(struct zram *zram)
+{
+	vfree(zram->hash);
+	zram->hash = NULL;
+	zram->hash_size = 0;
+}
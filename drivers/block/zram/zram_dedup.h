@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#ifndef _ZRAM_DEDUP_H_
+#define _ZRAM_DEDUP_H_
+
+#include <linux/list.h>
+#include <linux/spinlock.h>
+
+struct zram;
+
+/*
+ * Compressed object shared by all slots that store identical pages.
+ * Slots that reference an entry have ZRAM_DEDUP set and keep the entry
+ * pointer in their handle field.
+ */
+struct zram_entry {
+	struct hlist_node node;
+	u64 checksum;
+	unsigned long handle;
+	unsigned int len;
+	/* dictionary generation the object has been compressed with */
+	u32 gen;
+	/* protected by the bucket lock */
+	unsigned int refcount;
+};
+
+struct zram_hash {
+	spinlock_t lock;
+	struct hlist_head head;
+};
+
+#ifdef CONFIG_ZRAM_DEDUP
+u64 zram_dedup_checksum(struct page *page);
+struct zram_entry *zram_dedup_find(struct zram *zram, u64 checksum,
+				   struct page *page, const void *buf,
+				   unsigned int len, u32 gen);
+struct zram_entry *zram_dedup_insert(struct zram *zram, u64 checksum,
+				     unsigned long handle, unsigned int len,
+				     u32 gen);
+void zram_dedup_put(struct zram *zram, struct zram_entry *entry);
+
+int zram_dedup_init(struct zram *zram, size_t num_pages);
+void zram_dedup_fini(struct zram *zram);
+#else
+static inline u64 zram_dedup_checksum(struct page *page) { return 0; }
+static inline struct zram_entry *zram_dedup_find(struct zram *zram,
+		u64 checksum, struct page *page, const void *buf,
+		unsigned int len, u32 gen)
+{
+	return NULL;
+}
+static inline struct zram_entry *zram_dedup_insert(struct zram *zram,
+		u64 checksum, unsigned long handle, unsigned int len, u32 gen)
+{
+	return NULL;
+}
+static inline void zram_dedup_put(struct zram *zram,
+				  struct zram_entry *entry) {}
+
+static inline int zram_dedup_init(struct zram *zram, size_t num_pages)
+{
+	return 0;
+}
+static inline void zram_dedup_fini(struct zram *zram) {}
+#endif
+
+#endif /* _ZRAM_DEDUP_H_ */
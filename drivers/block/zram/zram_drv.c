@@ -34,9 +34,15 @@
 #include <linux/cpuhotplug.h>
 #include <linux/part_stat.h>
 #include <linux/kernel_read_file.h>
+#include <linux/srcu.h>
+#include <linux/seq_file.h>
+#include <linux/workqueue.h>
 
 #include "zram_drv.h"
 
+#define CREATE_TRACE_POINTS
+#include "zram_trace.h"
+
 static DEFINE_IDR(zram_index_idr);
 /* idr index must be protected */
 static DEFINE_MUTEX(zram_index_mutex);
@@ -83,11 +89,6 @@ static inline struct zram *dev_to_zram(struct device *dev)
 	return (struct zram *)dev_to_disk(dev)->private_data;
 }
 
-static unsigned long zram_get_handle(struct zram *zram, u32 index)
-{
-	return zram->table[index].handle;
-}
-
 static void zram_set_handle(struct zram *zram, u32 index, unsigned long handle)
 {
 	zram->table[index].handle = handle;
@@ -100,6 +101,19 @@ static bool zram_test_flag(struct zram *zram, u32 index,
 	return zram->table[index].flags & BIT(flag);
 }
 
+static struct zram_entry *zram_get_entry(struct zram *zram, u32 index)
+{
+	return (struct zram_entry *)zram->table[index].handle;
+}
+
+/* Returns zsmalloc handle of the object, also for deduplicated slots */
+static unsigned long zram_get_handle(struct zram *zram, u32 index)
+{
+	if (zram_test_flag(zram, index, ZRAM_DEDUP))
+		return zram_get_entry(zram, index)->handle;
+	return zram->table[index].handle;
+}
+
 static void zram_set_flag(struct zram *zram, u32 index,
 			enum zram_pageflags flag)
 {
@@ -175,6 +189,87 @@ static inline u32 zram_get_priority(struct zram *zram, u32 index)
 	return prio & ZRAM_COMP_PRIORITY_MASK;
 }
 
+#ifdef CONFIG_ZRAM_DICT_TRAINING
+/*
+ * Protects dictionary generation backends from being released while
+ * writers still compress with them.
+ */
+DEFINE_STATIC_SRCU(zram_dict_srcu);
+
+static inline int zram_dict_read_lock(void)
+{
+	return srcu_read_lock(&zram_dict_srcu);
+}
+
+static inline void zram_dict_read_unlock(int idx)
+{
+	srcu_read_unlock(&zram_dict_srcu, idx);
+}
+
+static inline u32 zram_dict_gen(struct zram *zram)
+{
+	return smp_load_acquire(&zram->dict_gen);
+}
+
+static struct zcomp *zram_dict_comp(struct zram *zram, u32 gen)
+{
+	struct zcomp *comp = READ_ONCE(zram->dict_comps[gen & 1]);
+
+	return comp ?: zram->comps[ZRAM_PRIMARY_COMP];
+}
+
+/* Objects compressed with the primary algorithm depend on a generation */
+static bool zram_slot_uses_dict(struct zram *zram, u32 index)
+{
+	return zram_get_handle(zram, index) &&
+	       !zram_test_flag(zram, index, ZRAM_SAME) &&
+	       !zram_test_flag(zram, index, ZRAM_WB) &&
+	       zram_get_obj_size(zram, index) != PAGE_SIZE &&
+	       !zram_get_priority(zram, index);
+}
+
+static void zram_set_dict_gen(struct zram *zram, u32 index, u32 gen)
+{
+	if (gen & 1)
+		zram_set_flag(zram, index, ZRAM_DICT_GEN);
+	else
+		zram_clear_flag(zram, index, ZRAM_DICT_GEN);
+	atomic64_inc(&zram->dict_pages[gen & 1]);
+}
+
+static void zram_clear_dict_gen(struct zram *zram, u32 index)
+{
+	if (!zram_slot_uses_dict(zram, index))
+		return;
+
+	atomic64_dec(&zram->dict_pages[zram_test_flag(zram, index,
+						      ZRAM_DICT_GEN)]);
+	zram_clear_flag(zram, index, ZRAM_DICT_GEN);
+}
+#else
+static inline int zram_dict_read_lock(void) { return 0; }
+static inline void zram_dict_read_unlock(int idx) {};
+static inline u32 zram_dict_gen(struct zram *zram) { return 0; }
+static inline void zram_set_dict_gen(struct zram *zram, u32 index,
+				     u32 gen) {};
+static inline void zram_clear_dict_gen(struct zram *zram, u32 index) {};
+
+static struct zcomp *zram_dict_comp(struct zram *zram, u32 gen)
+{
+	return zram->comps[ZRAM_PRIMARY_COMP];
+}
+#endif
+
+/* Backend that the object stored in the slot has been compressed with */
+static struct zcomp *zram_slot_comp(struct zram *zram, u32 index)
+{
+	u32 prio = zram_get_priority(zram, index);
+
+	if (prio)
+		return zram->comps[prio];
+	return zram_dict_comp(zram, zram_test_flag(zram, index, ZRAM_DICT_GEN));
+}
+
 static void zram_accessed(struct zram *zram, u32 index)
 {
 	zram_clear_flag(zram, index, ZRAM_IDLE);
@@ -525,6 +620,37 @@ static ssize_t writeback_limit_show(struct device *dev,
 	return scnprintf(buf, PAGE_SIZE, "%llu\n", val);
 }
 
+/* Max number of pages (contiguous backing device blocks) per writeback bio */
+#define ZRAM_WB_REQ_PAGES	32
+/* Default and max number of writeback bios in flight */
+#define ZRAM_WB_BATCH_SIZE	4
+#define ZRAM_WB_BATCH_SIZE_MAX	BIO_MAX_VECS
+
+static ssize_t writeback_batch_size_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	u32 val;
+
+	if (kstrtouint(buf, 10, &val))
+		return -EINVAL;
+
+	if (!val)
+		return -EINVAL;
+
+	WRITE_ONCE(zram->wb_batch_size, min(val, ZRAM_WB_BATCH_SIZE_MAX));
+	return len;
+}
+
+static ssize_t writeback_batch_size_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 READ_ONCE(zram->wb_batch_size));
+}
+
 static void reset_bdev(struct zram *zram)
 {
 	if (!zram->backing_dev)
@@ -652,22 +778,6 @@ static ssize_t backing_dev_store(struct device *dev,
 	return err;
 }
 
-static unsigned long alloc_block_bdev(struct zram *zram)
-{
-	unsigned long blk_idx = 1;
-retry:
-	/* skip 0 bit to confuse zram.handle = 0 */
-	blk_idx = find_next_zero_bit(zram->bitmap, zram->nr_pages, blk_idx);
-	if (blk_idx == zram->nr_pages)
-		return 0;
-
-	if (test_and_set_bit(blk_idx, zram->bitmap))
-		goto retry;
-
-	atomic64_inc(&zram->stats.bd_count);
-	return blk_idx;
-}
-
 static void free_block_bdev(struct zram *zram, unsigned long blk_idx)
 {
 	int was_set;
@@ -740,20 +850,281 @@ static int scan_slots_for_writeback(struct zram *zram, u32 mode,
 	return 0;
 }
 
+struct zram_wb_req {
+	unsigned long blk_idx;
+	/* no. of reserved blocks and no. of queued pages */
+	unsigned int nr_blks;
+	unsigned int nr_pages;
+	struct zram_wb_ctl *wb_ctl;
+	struct list_head entry;
+	struct zram_pp_slot *pps[ZRAM_WB_REQ_PAGES];
+	struct page *pages[ZRAM_WB_REQ_PAGES];
+	struct bio_vec bio_vec[ZRAM_WB_REQ_PAGES];
+	struct bio bio;
+};
+
+struct zram_wb_ctl {
+	struct list_head idle_reqs;
+	/* completed requests, filled from the end_io path */
+	struct list_head done_reqs;
+	spinlock_t done_lock;
+	wait_queue_head_t done_wait;
+	unsigned int num_inflight;
+	/* no. of pages in flight, accounted against writeback limit */
+	unsigned long nr_pending;
+};
+
+static void release_wb_req(struct zram_wb_req *req)
+{
+	unsigned int i;
+
+	for (i = 0; i < ZRAM_WB_REQ_PAGES; i++) {
+		if (req->pages[i])
+			__free_page(req->pages[i]);
+	}
+	kfree(req);
+}
+
+static void release_wb_ctl(struct zram_wb_ctl *wb_ctl)
+{
+	struct zram_wb_req *req, *tmp;
+
+	if (!wb_ctl)
+		return;
+
+	/* all requests must be completed and finished by now */
+	WARN_ON_ONCE(wb_ctl->num_inflight);
+	list_for_each_entry_safe(req, tmp, &wb_ctl->idle_reqs, entry) {
+		list_del(&req->entry);
+		release_wb_req(req);
+	}
+	kfree(wb_ctl);
+}
+
+static struct zram_wb_ctl *init_wb_ctl(u32 batch_size)
+{
+	struct zram_wb_ctl *wb_ctl;
+	unsigned int i, j;
+
+	wb_ctl = kzalloc(sizeof(*wb_ctl), GFP_KERNEL);
+	if (!wb_ctl)
+		return NULL;
+
+	INIT_LIST_HEAD(&wb_ctl->idle_reqs);
+	INIT_LIST_HEAD(&wb_ctl->done_reqs);
+	spin_lock_init(&wb_ctl->done_lock);
+	init_waitqueue_head(&wb_ctl->done_wait);
+
+	for (i = 0; i < batch_size; i++) {
+		struct zram_wb_req *req;
+
+		req = kzalloc(sizeof(*req), GFP_KERNEL);
+		if (!req)
+			break;
+
+		for (j = 0; j < ZRAM_WB_REQ_PAGES; j++) {
+			req->pages[j] = alloc_page(GFP_KERNEL);
+			if (!req->pages[j])
+				break;
+		}
+		if (j < ZRAM_WB_REQ_PAGES) {
+			release_wb_req(req);
+			break;
+		}
+
+		req->wb_ctl = wb_ctl;
+		list_add(&req->entry, &wb_ctl->idle_reqs);
+	}
+
+	/* We can live with fewer requests in flight, but need at least one */
+	if (list_empty(&wb_ctl->idle_reqs)) {
+		kfree(wb_ctl);
+		return NULL;
+	}
+	return wb_ctl;
+}
+
+/*
+ * Reserves up to @nr contiguous backing device blocks. Falls back to
+ * shorter runs when the bitmap is fragmented. Allocations are serialized
+ * by pp_in_progress; frees can happen concurrently, hence atomic bitops.
+ */
+static unsigned long alloc_block_bdev_range(struct zram *zram,
+					    unsigned int *nr)
+{
+	unsigned long blk_idx, i;
+
+	for (; *nr; *nr /= 2) {
+		/* skip 0 bit to confuse zram.handle = 0 */
+		blk_idx = bitmap_find_next_zero_area(zram->bitmap,
+						     zram->nr_pages, 1,
+						     *nr, 0);
+		if (blk_idx >= zram->nr_pages)
+			continue;
+
+		for (i = 0; i < *nr; i++)
+			set_bit(blk_idx + i, zram->bitmap);
+		atomic64_add(*nr, &zram->stats.bd_count);
+		return blk_idx;
+	}
+
+	return 0;
+}
+
+static void zram_writeback_endio(struct bio *bio)
+{
+	struct zram_wb_req *req = bio->bi_private;
+	struct zram_wb_ctl *wb_ctl = req->wb_ctl;
+	unsigned long flags;
+
+	/*
+	 * Slot locks are not irq safe, slot state transitions are handled
+	 * by the submitter in process context.
+	 */
+	spin_lock_irqsave(&wb_ctl->done_lock, flags);
+	list_add_tail(&req->entry, &wb_ctl->done_reqs);
+	/*
+	 * Wake up under done_lock: the submitter takes it to collect the
+	 * request, so wb_ctl can't be freed before we are done with it.
+	 */
+	wake_up(&wb_ctl->done_wait);
+	spin_unlock_irqrestore(&wb_ctl->done_lock, flags);
+}
+
+static void zram_submit_wb_req(struct zram *zram, struct zram_wb_ctl *wb_ctl,
+			       struct zram_wb_req *req)
+{
+	unsigned int i;
+
+	/* Return the blocks that we could not fill */
+	for (i = req->nr_pages; i < req->nr_blks; i++)
+		free_block_bdev(zram, req->blk_idx + i);
+	req->nr_blks = req->nr_pages;
+
+	bio_init(&req->bio, zram->bdev, req->bio_vec, ZRAM_WB_REQ_PAGES,
+		 REQ_OP_WRITE);
+	req->bio.bi_iter.bi_sector = req->blk_idx * (PAGE_SIZE >> 9);
+	req->bio.bi_end_io = zram_writeback_endio;
+	req->bio.bi_private = req;
+	for (i = 0; i < req->nr_pages; i++)
+		__bio_add_page(&req->bio, req->pages[i], PAGE_SIZE, 0);
+
+	wb_ctl->num_inflight++;
+	submit_bio(&req->bio);
+}
+
+/*
+ * Moves written back slots to ZRAM_WB state. Returns the bio error, if
+ * any; BIO errors are not fatal, the remaining objects are still
+ * written back.
+ */
+static int zram_finish_wb_req(struct zram *zram, struct zram_wb_ctl *wb_ctl,
+			      struct zram_wb_req *req)
+{
+	int err = blk_status_to_errno(req->bio.bi_status);
+	unsigned int i;
+
+	for (i = 0; i < req->nr_pages; i++) {
+		unsigned long blk_idx = req->blk_idx + i;
+		struct zram_pp_slot *pps = req->pps[i];
+		u32 index = pps->index;
+
+		if (err) {
+			free_block_bdev(zram, blk_idx);
+			release_pp_slot(zram, pps);
+			continue;
+		}
+
+		atomic64_inc(&zram->stats.bd_writes);
+		zram_slot_lock(zram, index);
+		/*
+		 * We release slot lock during writeback so slot can change
+		 * under us: slot_free() or slot_free() and reallocation
+		 * (zram_write_page()). In both cases slot loses ZRAM_PP_SLOT
+		 * flag. No concurrent post-processing can set ZRAM_PP_SLOT
+		 * on such slots until current post-processing finishes.
+		 */
+		if (!zram_test_flag(zram, index, ZRAM_PP_SLOT)) {
+			zram_slot_unlock(zram, index);
+			free_block_bdev(zram, blk_idx);
+			release_pp_slot(zram, pps);
+			continue;
+		}
+
+		zram_free_page(zram, index);
+		zram_set_flag(zram, index, ZRAM_WB);
+		zram_set_element(zram, index, blk_idx);
+		atomic64_inc(&zram->stats.pages_stored);
+		spin_lock(&zram->wb_limit_lock);
+		if (zram->wb_limit_enable && zram->bd_wb_limit > 0)
+			zram->bd_wb_limit -=  1UL << (PAGE_SHIFT - 12);
+		spin_unlock(&zram->wb_limit_lock);
+		zram_slot_unlock(zram, index);
+		release_pp_slot(zram, pps);
+	}
+
+	wb_ctl->nr_pending -= req->nr_pages;
+	req->nr_pages = 0;
+	req->nr_blks = 0;
+	return err;
+}
+
+/*
+ * Finishes completed requests, waits for at least one completion first
+ * if @wait is set and there are requests in flight.
+ */
+static int zram_complete_wb_reqs(struct zram *zram,
+				 struct zram_wb_ctl *wb_ctl, bool wait)
+{
+	struct zram_wb_req *req, *tmp;
+	LIST_HEAD(done);
+	int ret = 0, err;
+
+	if (wait && wb_ctl->num_inflight)
+		wait_event(wb_ctl->done_wait,
+			   !list_empty_careful(&wb_ctl->done_reqs));
+
+	spin_lock_irq(&wb_ctl->done_lock);
+	list_splice_init(&wb_ctl->done_reqs, &done);
+	spin_unlock_irq(&wb_ctl->done_lock);
+
+	list_for_each_entry_safe(req, tmp, &done, entry) {
+		list_del(&req->entry);
+		wb_ctl->num_inflight--;
+
+		err = zram_finish_wb_req(zram, wb_ctl, req);
+		if (err)
+			ret = err;
+		list_add(&req->entry, &wb_ctl->idle_reqs);
+	}
+
+	return ret;
+}
+
+static bool zram_wb_limit_reached(struct zram *zram, unsigned long nr_pending)
+{
+	bool reached;
+
+	spin_lock(&zram->wb_limit_lock);
+	reached = zram->wb_limit_enable &&
+		  zram->bd_wb_limit <= (u64)nr_pending << (PAGE_SHIFT - 12);
+	spin_unlock(&zram->wb_limit_lock);
+
+	return reached;
+}
+
 static ssize_t writeback_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t len)
 {
 	struct zram *zram = dev_to_zram(dev);
 	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
+	struct zram_wb_ctl *wb_ctl = NULL;
 	struct zram_pp_ctl *ctl = NULL;
+	struct zram_wb_req *req = NULL;
 	struct zram_pp_slot *pps;
 	unsigned long index = 0;
-	struct bio bio;
-	struct bio_vec bio_vec;
-	struct page *page;
 	ssize_t ret = len;
 	int mode, err;
-	unsigned long blk_idx = 0;
 
 	if (sysfs_streq(buf, "idle"))
 		mode = IDLE_WRITEBACK;
@@ -792,8 +1163,8 @@ static ssize_t writeback_store(struct device *dev,
 		goto release_init_lock;
 	}
 
-	page = alloc_page(GFP_KERNEL);
-	if (!page) {
+	wb_ctl = init_wb_ctl(READ_ONCE(zram->wb_batch_size));
+	if (!wb_ctl) {
 		ret = -ENOMEM;
 		goto release_init_lock;
 	}
@@ -807,20 +1178,28 @@ static ssize_t writeback_store(struct device *dev,
 	scan_slots_for_writeback(zram, mode, nr_pages, index, ctl);
 
 	while ((pps = select_pp_slot(ctl))) {
-		spin_lock(&zram->wb_limit_lock);
-		if (zram->wb_limit_enable && !zram->bd_wb_limit) {
-			spin_unlock(&zram->wb_limit_lock);
+		if (zram_wb_limit_reached(zram, wb_ctl->nr_pending)) {
 			ret = -EIO;
 			break;
 		}
-		spin_unlock(&zram->wb_limit_lock);
 
-		if (!blk_idx) {
-			blk_idx = alloc_block_bdev(zram);
-			if (!blk_idx) {
+		if (!req) {
+			err = zram_complete_wb_reqs(zram, wb_ctl,
+					list_empty(&wb_ctl->idle_reqs));
+			if (err)
+				ret = err;
+
+			req = list_first_entry(&wb_ctl->idle_reqs,
+					       struct zram_wb_req, entry);
+			req->nr_blks = ZRAM_WB_REQ_PAGES;
+			req->blk_idx = alloc_block_bdev_range(zram,
+							      &req->nr_blks);
+			if (!req->blk_idx) {
+				req = NULL;
 				ret = -ENOSPC;
 				break;
 			}
+			list_del(&req->entry);
 		}
 
 		index = pps->index;
@@ -831,71 +1210,45 @@ static ssize_t writeback_store(struct device *dev,
 		 * freed they lose ZRAM_PP_SLOT flag and hence we don't
 		 * post-process them.
 		 */
-		if (!zram_test_flag(zram, index, ZRAM_PP_SLOT))
-			goto next;
-		zram_slot_unlock(zram, index);
-
-		if (zram_read_page(zram, page, index, NULL)) {
+		if (!zram_test_flag(zram, index, ZRAM_PP_SLOT)) {
+			zram_slot_unlock(zram, index);
 			release_pp_slot(zram, pps);
 			continue;
 		}
+		zram_slot_unlock(zram, index);
 
-		bio_init(&bio, zram->bdev, &bio_vec, 1,
-			 REQ_OP_WRITE | REQ_SYNC);
-		bio.bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
-		__bio_add_page(&bio, page, PAGE_SIZE, 0);
-
-		/*
-		 * XXX: A single page IO would be inefficient for write
-		 * but it would be not bad as starter.
-		 */
-		err = submit_bio_wait(&bio);
-		if (err) {
+		if (zram_read_page(zram, req->pages[req->nr_pages], index,
+				   NULL)) {
 			release_pp_slot(zram, pps);
-			/*
-			 * BIO errors are not fatal, we continue and simply
-			 * attempt to writeback the remaining objects (pages).
-			 * At the same time we need to signal user-space that
-			 * some writes (at least one, but also could be all of
-			 * them) were not successful and we do so by returning
-			 * the most recent BIO error.
-			 */
-			ret = err;
 			continue;
 		}
 
-		atomic64_inc(&zram->stats.bd_writes);
-		zram_slot_lock(zram, index);
-		/*
-		 * Same as above, we release slot lock during writeback so
-		 * slot can change under us: slot_free() or slot_free() and
-		 * reallocation (zram_write_page()). In both cases slot loses
-		 * ZRAM_PP_SLOT flag. No concurrent post-processing can set
-		 * ZRAM_PP_SLOT on such slots until current post-processing
-		 * finishes.
-		 */
-		if (!zram_test_flag(zram, index, ZRAM_PP_SLOT))
-			goto next;
+		/* The slot is owned by the request from now on */
+		list_del_init(&pps->entry);
+		req->pps[req->nr_pages++] = pps;
+		wb_ctl->nr_pending++;
+		if (req->nr_pages == req->nr_blks) {
+			zram_submit_wb_req(zram, wb_ctl, req);
+			req = NULL;
+		}
+	}
 
-		zram_free_page(zram, index);
-		zram_set_flag(zram, index, ZRAM_WB);
-		zram_set_element(zram, index, blk_idx);
-		blk_idx = 0;
-		atomic64_inc(&zram->stats.pages_stored);
-		spin_lock(&zram->wb_limit_lock);
-		if (zram->wb_limit_enable && zram->bd_wb_limit > 0)
-			zram->bd_wb_limit -=  1UL << (PAGE_SHIFT - 12);
-		spin_unlock(&zram->wb_limit_lock);
-next:
-		zram_slot_unlock(zram, index);
-		release_pp_slot(zram, pps);
+	if (req && req->nr_pages) {
+		zram_submit_wb_req(zram, wb_ctl, req);
+	} else if (req) {
+		while (req->nr_blks)
+			free_block_bdev(zram, req->blk_idx + --req->nr_blks);
+		list_add(&req->entry, &wb_ctl->idle_reqs);
 	}
 
-	if (blk_idx)
-		free_block_bdev(zram, blk_idx);
-	__free_page(page);
+	while (wb_ctl->num_inflight) {
+		err = zram_complete_wb_reqs(zram, wb_ctl, true);
+		if (err)
+			ret = err;
+	}
 release_init_lock:
 	release_pp_ctl(zram, ctl);
+	release_wb_ctl(wb_ctl);
 	atomic_set(&zram->pp_in_progress, 0);
 	up_read(&zram->init_lock);
 
@@ -967,7 +1320,7 @@ static int read_from_bdev(struct zram *zram, struct page *page,
 static void free_block_bdev(struct zram *zram, unsigned long blk_idx) {};
 #endif
 
-#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+#if defined CONFIG_ZRAM_MEMORY_TRACKING || defined CONFIG_ZRAM_HISTOGRAM
 
 static struct dentry *zram_debugfs_root;
 
@@ -980,7 +1333,9 @@ static void zram_debugfs_destroy(void)
 {
 	debugfs_remove_recursive(zram_debugfs_root);
 }
+#endif
 
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
 static ssize_t read_block_state(struct file *file, char __user *buf,
 				size_t count, loff_t *ppos)
 {
@@ -1045,40 +1400,161 @@ static const struct file_operations proc_zram_block_state_op = {
 	.read = read_block_state,
 	.llseek = default_llseek,
 };
+#endif
+
+#ifdef CONFIG_ZRAM_HISTOGRAM
+static const char * const zram_hist_names[NR_ZRAM_HISTS] = {
+	[ZRAM_HIST_COMP_NS]	= "comp_ns",
+	[ZRAM_HIST_DECOMP_NS]	= "decomp_ns",
+	[ZRAM_HIST_COMP_SIZE]	= "comp_size",
+};
 
-static void zram_debugfs_register(struct zram *zram)
+static void zram_hist_record(struct zram *zram, enum zram_hist_type type,
+			     u32 prio, u64 val)
 {
-	if (!zram_debugfs_root)
-		return;
+	unsigned int bucket;
 
-	zram->debugfs_dir = debugfs_create_dir(zram->disk->disk_name,
-						zram_debugfs_root);
-	debugfs_create_file("block_state", 0400, zram->debugfs_dir,
-				zram, &proc_zram_block_state_op);
+	bucket = min_t(unsigned int, fls64(val), ZRAM_HIST_BUCKETS - 1);
+	this_cpu_inc(zram->hist->buckets[type][prio][bucket]);
 }
 
-static void zram_debugfs_unregister(struct zram *zram)
+static inline u64 zram_hist_start(void)
 {
-	debugfs_remove_recursive(zram->debugfs_dir);
+	return ktime_get_ns();
 }
-#else
-static void zram_debugfs_create(void) {};
-static void zram_debugfs_destroy(void) {};
-static void zram_debugfs_register(struct zram *zram) {};
-static void zram_debugfs_unregister(struct zram *zram) {};
-#endif
 
-/*
- * We switched to per-cpu streams and this attr is not needed anymore.
- * However, we will keep it around for some time, because:
- * a) we may revert per-cpu streams in the future
- * b) it's visible to user space and we need to follow our 2 years
- *    retirement rule; but we already have a number of 'soon to be
- *    altered' attrs, so max_comp_streams need to wait for the next
- *    layoff cycle.
- */
-static ssize_t max_comp_streams_show(struct device *dev,
-		struct device_attribute *attr, char *buf)
+static inline u64 zram_hist_elapsed(u64 start)
+{
+	return ktime_get_ns() - start;
+}
+
+static void zram_hist_reset(struct zram *zram)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(zram->hist, cpu), 0,
+		       sizeof(struct zram_hist));
+}
+
+static int zram_hist_show(struct seq_file *m, void *v)
+{
+	struct zram *zram = m->private;
+	u64 sum[ZRAM_HIST_BUCKETS];
+	u32 type, prio, i;
+	int cpu;
+
+	down_read(&zram->init_lock);
+	for (type = 0; type < NR_ZRAM_HISTS; type++) {
+		for (prio = ZRAM_PRIMARY_COMP; prio < ZRAM_MAX_COMPS; prio++) {
+			if (!zram->comp_algs[prio])
+				continue;
+
+			memset(sum, 0, sizeof(sum));
+			for_each_possible_cpu(cpu) {
+				struct zram_hist *hist;
+
+				hist = per_cpu_ptr(zram->hist, cpu);
+				for (i = 0; i < ZRAM_HIST_BUCKETS; i++)
+					sum[i] += hist->buckets[type][prio][i];
+			}
+
+			seq_printf(m, "%-10s %u %-8s", zram_hist_names[type],
+				   prio, zram->comp_algs[prio]);
+			for (i = 0; i < ZRAM_HIST_BUCKETS; i++)
+				seq_printf(m, " %llu", sum[i]);
+			seq_putc(m, '\n');
+		}
+	}
+	up_read(&zram->init_lock);
+
+	return 0;
+}
+
+static int zram_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, zram_hist_show, inode->i_private);
+}
+
+static ssize_t zram_hist_write(struct file *file, const char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+
+	zram_hist_reset(m->private);
+	return count;
+}
+
+static const struct file_operations zram_hist_fops = {
+	.open = zram_hist_open,
+	.read = seq_read,
+	.write = zram_hist_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int zram_hist_alloc(struct zram *zram)
+{
+	zram->hist = alloc_percpu(struct zram_hist);
+	return zram->hist ? 0 : -ENOMEM;
+}
+
+static void zram_hist_free(struct zram *zram)
+{
+	free_percpu(zram->hist);
+	zram->hist = NULL;
+}
+#else
+static inline void zram_hist_record(struct zram *zram,
+				    enum zram_hist_type type, u32 prio,
+				    u64 val) {};
+static inline u64 zram_hist_start(void) { return 0; }
+static inline u64 zram_hist_elapsed(u64 start) { return 0; }
+static inline void zram_hist_reset(struct zram *zram) {};
+static inline int zram_hist_alloc(struct zram *zram) { return 0; }
+static inline void zram_hist_free(struct zram *zram) {};
+#endif
+
+#if defined CONFIG_ZRAM_MEMORY_TRACKING || defined CONFIG_ZRAM_HISTOGRAM
+static void zram_debugfs_register(struct zram *zram)
+{
+	if (!zram_debugfs_root)
+		return;
+
+	zram->debugfs_dir = debugfs_create_dir(zram->disk->disk_name,
+						zram_debugfs_root);
+#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+	debugfs_create_file("block_state", 0400, zram->debugfs_dir,
+				zram, &proc_zram_block_state_op);
+#endif
+#ifdef CONFIG_ZRAM_HISTOGRAM
+	debugfs_create_file("histograms", 0600, zram->debugfs_dir,
+				zram, &zram_hist_fops);
+#endif
+}
+
+static void zram_debugfs_unregister(struct zram *zram)
+{
+	debugfs_remove_recursive(zram->debugfs_dir);
+}
+#else
+static void zram_debugfs_create(void) {};
+static void zram_debugfs_destroy(void) {};
+static void zram_debugfs_register(struct zram *zram) {};
+static void zram_debugfs_unregister(struct zram *zram) {};
+#endif
+
+/*
+ * We switched to per-cpu streams and this attr is not needed anymore.
+ * However, we will keep it around for some time, because:
+ * a) we may revert per-cpu streams in the future
+ * b) it's visible to user space and we need to follow our 2 years
+ *    retirement rule; but we already have a number of 'soon to be
+ *    altered' attrs, so max_comp_streams need to wait for the next
+ *    layoff cycle.
+ */
+static ssize_t max_comp_streams_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
 {
 	return scnprintf(buf, PAGE_SIZE, "%d\n", num_online_cpus());
 }
@@ -1432,6 +1908,240 @@ static ssize_t debug_stat_show(struct device *dev,
 	return ret;
 }
 
+#ifdef CONFIG_ZRAM_DEDUP
+static ssize_t use_dedup_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	bool val;
+
+	down_read(&zram->init_lock);
+	val = zram->use_dedup;
+	up_read(&zram->init_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", (int)val);
+}
+
+static ssize_t use_dedup_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	bool val;
+
+	if (kstrtobool(buf, &val))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change dedup usage for initialized device\n");
+		return -EBUSY;
+	}
+	zram->use_dedup = val;
+	up_write(&zram->init_lock);
+	return len;
+}
+
+static ssize_t dedup_stat_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	ssize_t ret;
+
+	down_read(&zram->init_lock);
+	ret = scnprintf(buf, PAGE_SIZE,
+			"%8llu %8llu %8llu\n",
+			(u64)atomic64_read(&zram->stats.dup_pages),
+			(u64)atomic64_read(&zram->stats.dup_data_size),
+			(u64)atomic64_read(&zram->stats.meta_data_size));
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+
+static DEVICE_ATTR_RW(use_dedup);
+static DEVICE_ATTR_RO(dedup_stat);
+#endif
+
+#ifdef CONFIG_ZRAM_READ_AHEAD
+#define ZRAM_RA_MAX_PAGES	64
+
+static ssize_t read_ahead_pages_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	u32 val;
+
+	down_read(&zram->init_lock);
+	val = zram->ra_pages;
+	up_read(&zram->init_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", val);
+}
+
+static ssize_t read_ahead_pages_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	u32 val;
+
+	if (kstrtou32(buf, 10, &val) || val > ZRAM_RA_MAX_PAGES)
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change read-ahead window for initialized device\n");
+		return -EBUSY;
+	}
+	zram->ra_pages = val;
+	up_write(&zram->init_lock);
+	return len;
+}
+
+static ssize_t read_ahead_stat_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	ssize_t ret;
+
+	down_read(&zram->init_lock);
+	ret = scnprintf(buf, PAGE_SIZE,
+			"%8llu %8llu\n",
+			(u64)atomic64_read(&zram->stats.ra_decomp),
+			(u64)atomic64_read(&zram->stats.ra_hits));
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+
+static DEVICE_ATTR_RW(read_ahead_pages);
+static DEVICE_ATTR_RO(read_ahead_stat);
+
+static void zram_ra_fini(struct zram *zram)
+{
+	u32 i;
+
+	if (!zram->ra_cache)
+		return;
+
+	for (i = 0; i < zram->ra_pages * 2; i++) {
+		if (zram->ra_cache[i].page)
+			__free_page(zram->ra_cache[i].page);
+	}
+	kfree(zram->ra_cache);
+	zram->ra_cache = NULL;
+	zram->ra_cache_size = 0;
+}
+
+/*
+ * The cache holds two windows worth of pages: the one being consumed by
+ * the reader and the one being decompressed ahead of it.
+ */
+static int zram_ra_init(struct zram *zram)
+{
+	u32 i, size = zram->ra_pages * 2;
+
+	if (!size)
+		return 0;
+
+	zram->ra_cache = kcalloc(size, sizeof(*zram->ra_cache), GFP_KERNEL);
+	if (!zram->ra_cache)
+		return -ENOMEM;
+
+	for (i = 0; i < size; i++) {
+		zram->ra_cache[i].page = alloc_page(GFP_KERNEL);
+		if (!zram->ra_cache[i].page) {
+			zram_ra_fini(zram);
+			return -ENOMEM;
+		}
+	}
+
+	zram->ra_hand = 0;
+	zram->ra_last = 0;
+	zram->ra_begin = 0;
+	zram->ra_start = 0;
+	zram->ra_end = 0;
+	zram->ra_cache_size = size;
+	return 0;
+}
+
+static void zram_ra_stop(struct zram *zram)
+{
+	if (zram->ra_cache_size)
+		cancel_work_sync(&zram->ra_work);
+}
+
+static struct zram_ra_entry *zram_ra_lookup(struct zram *zram, u32 index)
+{
+	u32 i;
+
+	lockdep_assert_held(&zram->ra_lock);
+	for (i = 0; i < zram->ra_cache_size; i++) {
+		if (zram->ra_cache[i].valid && zram->ra_cache[i].index == index)
+			return &zram->ra_cache[i];
+	}
+	return NULL;
+}
+
+/*
+ * A cache entry for a slot is valid iff the slot has ZRAM_RA_CACHED set,
+ * both are changed under the slot lock. Must be called with the slot locked.
+ */
+static void zram_ra_invalidate(struct zram *zram, u32 index)
+{
+	struct zram_ra_entry *entry;
+
+	if (!zram_test_flag(zram, index, ZRAM_RA_CACHED))
+		return;
+
+	zram_clear_flag(zram, index, ZRAM_RA_CACHED);
+	spin_lock(&zram->ra_lock);
+	entry = zram_ra_lookup(zram, index);
+	if (entry)
+		entry->valid = false;
+	spin_unlock(&zram->ra_lock);
+}
+
+/*
+ * Copies the slot's decompressed page from the cache, if there is one, and
+ * drops the entry: sequential readers do not come back for the same slot.
+ * Must be called with the slot locked.
+ */
+static bool zram_ra_read(struct zram *zram, struct page *page, u32 index)
+{
+	struct zram_ra_entry *entry;
+	bool hit = false;
+
+	if (!zram_test_flag(zram, index, ZRAM_RA_CACHED))
+		return false;
+
+	zram_clear_flag(zram, index, ZRAM_RA_CACHED);
+	spin_lock(&zram->ra_lock);
+	entry = zram_ra_lookup(zram, index);
+	if (entry) {
+		copy_highpage(page, entry->page);
+		entry->valid = false;
+		hit = true;
+	}
+	spin_unlock(&zram->ra_lock);
+
+	if (hit)
+		atomic64_inc(&zram->stats.ra_hits);
+	return hit;
+}
+#else
+static inline int zram_ra_init(struct zram *zram) { return 0; }
+static inline void zram_ra_fini(struct zram *zram) {}
+static inline void zram_ra_stop(struct zram *zram) {}
+static inline void zram_ra_invalidate(struct zram *zram, u32 index) {}
+static inline bool zram_ra_read(struct zram *zram, struct page *page,
+				u32 index)
+{
+	return false;
+}
+#endif
+
 static DEVICE_ATTR_RO(io_stat);
 static DEVICE_ATTR_RO(mm_stat);
 #ifdef CONFIG_ZRAM_WRITEBACK
@@ -1447,10 +2157,14 @@ static void zram_meta_free(struct zram *zram, u64 disksize)
 	if (!zram->table)
 		return;
 
+	zram_ra_stop(zram);
+
 	/* Free all pages that are still in this zram device */
 	for (index = 0; index < num_pages; index++)
 		zram_free_page(zram, index);
 
+	zram_ra_fini(zram);
+	zram_dedup_fini(zram);
 	zs_destroy_pool(zram->mem_pool);
 	vfree(zram->table);
 	zram->table = NULL;
@@ -1472,6 +2186,21 @@ static bool zram_meta_alloc(struct zram *zram, u64 disksize)
 		return false;
 	}
 
+	if (zram_dedup_init(zram, num_pages)) {
+		zs_destroy_pool(zram->mem_pool);
+		vfree(zram->table);
+		zram->table = NULL;
+		return false;
+	}
+
+	if (zram_ra_init(zram)) {
+		zram_dedup_fini(zram);
+		zs_destroy_pool(zram->mem_pool);
+		vfree(zram->table);
+		zram->table = NULL;
+		return false;
+	}
+
 	if (!huge_class_size)
 		huge_class_size = zs_huge_class_size(zram->mem_pool);
 
@@ -1493,6 +2222,8 @@ static void zram_free_page(struct zram *zram, size_t index)
 	zram->table[index].ac_time = 0;
 #endif
 
+	zram_ra_invalidate(zram, index);
+	zram_clear_dict_gen(zram, index);
 	zram_clear_flag(zram, index, ZRAM_IDLE);
 	zram_clear_flag(zram, index, ZRAM_INCOMPRESSIBLE);
 	zram_clear_flag(zram, index, ZRAM_PP_SLOT);
@@ -1519,6 +2250,12 @@ static void zram_free_page(struct zram *zram, size_t index)
 		goto out;
 	}
 
+	if (zram_test_flag(zram, index, ZRAM_DEDUP)) {
+		zram_dedup_put(zram, zram_get_entry(zram, index));
+		zram_clear_flag(zram, index, ZRAM_DEDUP);
+		goto out;
+	}
+
 	handle = zram_get_handle(zram, index);
 	if (!handle)
 		return;
@@ -1543,8 +2280,8 @@ static int zram_read_from_zspool(struct zram *zram, struct page *page,
 	struct zcomp_strm *zstrm;
 	unsigned long handle;
 	unsigned int size;
+	struct zcomp *comp;
 	void *src, *dst;
-	u32 prio;
 	int ret;
 
 	handle = zram_get_handle(zram, index);
@@ -1562,8 +2299,8 @@ static int zram_read_from_zspool(struct zram *zram, struct page *page,
 	size = zram_get_obj_size(zram, index);
 
 	if (size != PAGE_SIZE) {
-		prio = zram_get_priority(zram, index);
-		zstrm = zcomp_stream_get(zram->comps[prio]);
+		comp = zram_slot_comp(zram, index);
+		zstrm = zcomp_stream_get(comp);
 	}
 
 	src = zs_map_object(zram->mem_pool, handle, ZS_MM_RO);
@@ -1573,11 +2310,15 @@ static int zram_read_from_zspool(struct zram *zram, struct page *page,
 		kunmap_local(dst);
 		ret = 0;
 	} else {
+		u64 start = zram_hist_start();
+
 		dst = kmap_local_page(page);
-		ret = zcomp_decompress(zram->comps[prio], zstrm,
-				       src, size, dst);
+		ret = zcomp_decompress(comp, zstrm, src, size, dst);
 		kunmap_local(dst);
-		zcomp_stream_put(zram->comps[prio]);
+		zcomp_stream_put(comp);
+		zram_hist_record(zram, ZRAM_HIST_DECOMP_NS,
+				 zram_get_priority(zram, index),
+				 zram_hist_elapsed(start));
 	}
 	zs_unmap_object(zram->mem_pool, handle);
 	return ret;
@@ -1586,12 +2327,21 @@ static int zram_read_from_zspool(struct zram *zram, struct page *page,
 static int zram_read_page(struct zram *zram, struct page *page, u32 index,
 			  struct bio *parent)
 {
+	unsigned int size = 0;
+	bool wb = true;
+	u32 prio = 0;
 	int ret;
 
 	zram_slot_lock(zram, index);
 	if (!zram_test_flag(zram, index, ZRAM_WB)) {
+		size = zram_get_obj_size(zram, index);
+		prio = zram_get_priority(zram, index);
+		wb = false;
 		/* Slot should be locked through out the function call */
-		ret = zram_read_from_zspool(zram, page, index);
+		if (zram_ra_read(zram, page, index))
+			ret = 0;
+		else
+			ret = zram_read_from_zspool(zram, page, index);
 		zram_slot_unlock(zram, index);
 	} else {
 		/*
@@ -1600,16 +2350,140 @@ static int zram_read_page(struct zram *zram, struct page *page, u32 index,
 		 */
 		zram_slot_unlock(zram, index);
 
-		ret = read_from_bdev(zram, page, zram_get_element(zram, index),
-				     parent);
+		ret = read_from_bdev(zram, page, zram_get_element(zram, index),
+				     parent);
+	}
+
+	trace_zram_read_page(zram, index, size, prio, wb, ret);
+
+	/* Should NEVER happen. Return bio error if it does. */
+	if (WARN_ON(ret < 0))
+		pr_err("Decompression failed! err=%d, page=%u\n", ret, index);
+
+	return ret;
+}
+
+#ifdef CONFIG_ZRAM_READ_AHEAD
+/*
+ * Returns a free cache entry, evicting the oldest one if needed. The victim
+ * slot is locked on its own, the caller must not hold any slot lock.
+ */
+static struct zram_ra_entry *zram_ra_get_entry(struct zram *zram)
+{
+	u32 i, tries;
+
+	for (tries = 0; tries <= zram->ra_cache_size; tries++) {
+		u32 victim;
+
+		spin_lock(&zram->ra_lock);
+		for (i = 0; i < zram->ra_cache_size; i++) {
+			if (!zram->ra_cache[i].valid) {
+				spin_unlock(&zram->ra_lock);
+				return &zram->ra_cache[i];
+			}
+		}
+		victim = zram->ra_cache[zram->ra_hand].index;
+		zram->ra_hand = (zram->ra_hand + 1) % zram->ra_cache_size;
+		spin_unlock(&zram->ra_lock);
+
+		zram_slot_lock(zram, victim);
+		zram_ra_invalidate(zram, victim);
+		zram_slot_unlock(zram, victim);
+	}
+	return NULL;
+}
+
+static void zram_ra_work(struct work_struct *work)
+{
+	struct zram *zram = container_of(work, struct zram, ra_work);
+	u32 index, end;
+
+	spin_lock(&zram->ra_lock);
+	index = zram->ra_start;
+	end = zram->ra_end;
+	spin_unlock(&zram->ra_lock);
+
+	for (; index < end; index++) {
+		struct zram_ra_entry *entry;
+
+		entry = zram_ra_get_entry(zram);
+		if (!entry)
+			break;
+
+		zram_slot_lock(zram, index);
+		/*
+		 * Only compressed objects are worth caching: same-filled and
+		 * huge slots are served as cheaply as a copy from the cache.
+		 */
+		if (!zram_allocated(zram, index) ||
+		    zram_test_flag(zram, index, ZRAM_WB) ||
+		    zram_test_flag(zram, index, ZRAM_SAME) ||
+		    zram_test_flag(zram, index, ZRAM_RA_CACHED) ||
+		    zram_get_obj_size(zram, index) == PAGE_SIZE ||
+		    zram_read_from_zspool(zram, entry->page, index)) {
+			zram_slot_unlock(zram, index);
+			continue;
+		}
+
+		/*
+		 * The entry can only be claimed by this worker, the ring is
+		 * never refilled concurrently.
+		 */
+		spin_lock(&zram->ra_lock);
+		entry->index = index;
+		entry->valid = true;
+		spin_unlock(&zram->ra_lock);
+		zram_set_flag(zram, index, ZRAM_RA_CACHED);
+		zram_slot_unlock(zram, index);
+
+		atomic64_inc(&zram->stats.ra_decomp);
+		cond_resched();
+	}
+}
+
+/*
+ * Called for every read slot. Once two consecutive slots have been read,
+ * the next ra_pages slots are decompressed ahead into the cache, and the
+ * window is moved forward when the reader crosses its middle.
+ */
+static void zram_ra_trigger(struct zram *zram, u32 index)
+{
+	u32 nr_pages = zram->disksize >> PAGE_SHIFT;
+	u32 last = READ_ONCE(zram->ra_last);
+	bool queue = false;
+
+	WRITE_ONCE(zram->ra_last, index);
+	if (!zram->ra_cache_size || index != last + 1)
+		return;
+
+	spin_lock(&zram->ra_lock);
+	if (index < zram->ra_begin || index >= zram->ra_end) {
+		/* A new sequential stream */
+		zram->ra_begin = index + 1;
+		zram->ra_start = index + 1;
+	} else if (index + zram->ra_pages / 2 < zram->ra_end) {
+		goto out;
+	} else {
+		zram->ra_start = zram->ra_end;
 	}
+	zram->ra_end = min(index + 1 + zram->ra_pages, nr_pages);
+	queue = zram->ra_start < zram->ra_end;
+out:
+	spin_unlock(&zram->ra_lock);
 
-	/* Should NEVER happen. Return bio error if it does. */
-	if (WARN_ON(ret < 0))
-		pr_err("Decompression failed! err=%d, page=%u\n", ret, index);
+	if (queue)
+		queue_work(system_unbound_wq, &zram->ra_work);
+}
 
-	return ret;
+static void zram_ra_setup(struct zram *zram)
+{
+	spin_lock_init(&zram->ra_lock);
+	INIT_WORK(&zram->ra_work, zram_ra_work);
 }
+#else
+static inline void zram_ra_trigger(struct zram *zram, u32 index) {}
+static inline void zram_ra_setup(struct zram *zram) {}
+#endif
 
 /*
  * Use a temporary buffer to decompress the page, as the decompressor
@@ -1638,43 +2512,125 @@ static int zram_bvec_read(struct zram *zram, struct bio_vec *bvec,
 	return zram_read_page(zram, bvec->bv_page, index, bio);
 }
 
+/*
+ * Stores a new object in the slot, releasing whatever the slot held
+ * before. @handle is a zram_entry for deduplicated objects. Takes the
+ * slot lock, so must not be called with a zcomp stream held.
+ */
+static void zram_write_slot(struct zram *zram, u32 index,
+			    unsigned long handle, unsigned int comp_len,
+			    u32 gen, bool dedup)
+{
+	/*
+	 * Free memory associated with this sector
+	 * before overwriting unused sectors.
+	 */
+	zram_slot_lock(zram, index);
+	zram_free_page(zram, index);
+
+	if (comp_len == PAGE_SIZE) {
+		zram_set_flag(zram, index, ZRAM_HUGE);
+		atomic64_inc(&zram->stats.huge_pages);
+		atomic64_inc(&zram->stats.huge_pages_since);
+	}
+
+	zram_set_handle(zram, index, handle);
+	zram_set_obj_size(zram, index, comp_len);
+	if (dedup)
+		zram_set_flag(zram, index, ZRAM_DEDUP);
+	if (comp_len != PAGE_SIZE)
+		zram_set_dict_gen(zram, index, gen);
+	zram_slot_unlock(zram, index);
+
+	trace_zram_write_page(zram, index, comp_len, false, dedup);
+
+	/* Update stats */
+	atomic64_inc(&zram->stats.pages_stored);
+}
+
+static bool zram_write_same_filled_page(struct zram *zram, struct page *page,
+					u32 index)
+{
+	unsigned long element = 0;
+	void *mem;
+	bool same;
+
+	mem = kmap_local_page(page);
+	same = page_same_filled(mem, &element);
+	kunmap_local(mem);
+	if (!same)
+		return false;
+
+	/* Free memory associated with this sector now. */
+	zram_slot_lock(zram, index);
+	zram_free_page(zram, index);
+	zram_set_flag(zram, index, ZRAM_SAME);
+	zram_set_element(zram, index, element);
+	zram_slot_unlock(zram, index);
+
+	trace_zram_write_page(zram, index, 0, true, false);
+
+	atomic64_inc(&zram->stats.same_pages);
+	atomic64_inc(&zram->stats.pages_stored);
+	return true;
+}
+
 static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 {
 	int ret = 0;
 	unsigned long alloced_pages;
 	unsigned long handle = -ENOMEM;
 	unsigned int comp_len = 0;
-	void *src, *dst, *mem;
+	void *src, *dst;
 	struct zcomp_strm *zstrm;
-	unsigned long element = 0;
-	enum zram_pageflags flags = 0;
+	struct zram_entry *entry;
+	struct zcomp *comp;
+	u64 checksum = 0;
+	int dict_idx;
+	u64 start;
+	u32 gen;
 
-	mem = kmap_local_page(page);
-	if (page_same_filled(mem, &element)) {
-		kunmap_local(mem);
-		/* Free memory associated with this sector now. */
-		flags = ZRAM_SAME;
-		atomic64_inc(&zram->stats.same_pages);
-		goto out;
-	}
-	kunmap_local(mem);
+	if (zram_write_same_filled_page(zram, page, index))
+		return 0;
+
+	if (zram_dedup_enabled(zram))
+		checksum = zram_dedup_checksum(page);
+
+	dict_idx = zram_dict_read_lock();
+	gen = zram_dict_gen(zram);
+	comp = zram_dict_comp(zram, gen);
 
 compress_again:
-	zstrm = zcomp_stream_get(zram->comps[ZRAM_PRIMARY_COMP]);
+	zstrm = zcomp_stream_get(comp);
+	start = zram_hist_start();
 	src = kmap_local_page(page);
-	ret = zcomp_compress(zram->comps[ZRAM_PRIMARY_COMP], zstrm,
-			     src, &comp_len);
+	ret = zcomp_compress(comp, zstrm, src, &comp_len);
 	kunmap_local(src);
+	zram_hist_record(zram, ZRAM_HIST_COMP_NS, ZRAM_PRIMARY_COMP,
+			 zram_hist_elapsed(start));
 
 	if (unlikely(ret)) {
-		zcomp_stream_put(zram->comps[ZRAM_PRIMARY_COMP]);
+		zcomp_stream_put(comp);
 		pr_err("Compression failed! err=%d\n", ret);
 		zs_free(zram->mem_pool, handle);
-		return ret;
+		goto out;
 	}
 
+	zram_hist_record(zram, ZRAM_HIST_COMP_SIZE, ZRAM_PRIMARY_COMP, comp_len);
 	if (comp_len >= huge_class_size)
 		comp_len = PAGE_SIZE;
+
+	entry = zram_dedup_find(zram, checksum, page, zstrm->buffer,
+				comp_len, gen);
+	if (entry) {
+		zcomp_stream_put(comp);
+		if (!IS_ERR_VALUE(handle))
+			zs_free(zram->mem_pool, handle);
+		zram_write_slot(zram, index, (unsigned long)entry, comp_len,
+				gen, true);
+		goto out;
+	}
+
 	/*
 	 * handle allocation has 2 paths:
 	 * a) fast path is executed with preemption disabled (for
@@ -1695,13 +2651,15 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 				__GFP_HIGHMEM |
 				__GFP_MOVABLE);
 	if (IS_ERR_VALUE(handle)) {
-		zcomp_stream_put(zram->comps[ZRAM_PRIMARY_COMP]);
+		zcomp_stream_put(comp);
 		atomic64_inc(&zram->stats.writestall);
 		handle = zs_malloc(zram->mem_pool, comp_len,
 				GFP_NOIO | __GFP_HIGHMEM |
 				__GFP_MOVABLE);
-		if (IS_ERR_VALUE(handle))
-			return PTR_ERR((void *)handle);
+		if (IS_ERR_VALUE(handle)) {
+			ret = PTR_ERR((void *)handle);
+			goto out;
+		}
 
 		if (comp_len != PAGE_SIZE)
 			goto compress_again;
@@ -1712,16 +2670,17 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 		 * zstrm buffer back. It is necessary that the dereferencing
 		 * of the zstrm variable below occurs correctly.
 		 */
-		zstrm = zcomp_stream_get(zram->comps[ZRAM_PRIMARY_COMP]);
+		zstrm = zcomp_stream_get(comp);
 	}
 
 	alloced_pages = zs_get_total_pages(zram->mem_pool);
 	update_used_max(zram, alloced_pages);
 
 	if (zram->limit_pages && alloced_pages > zram->limit_pages) {
-		zcomp_stream_put(zram->comps[ZRAM_PRIMARY_COMP]);
+		zcomp_stream_put(comp);
 		zs_free(zram->mem_pool, handle);
-		return -ENOMEM;
+		ret = -ENOMEM;
+		goto out;
 	}
 
 	dst = zs_map_object(zram->mem_pool, handle, ZS_MM_WO);
@@ -1733,34 +2692,162 @@ static int zram_write_page(struct zram *zram, struct page *page, u32 index)
 	if (comp_len == PAGE_SIZE)
 		kunmap_local(src);
 
-	zcomp_stream_put(zram->comps[ZRAM_PRIMARY_COMP]);
+	zcomp_stream_put(comp);
 	zs_unmap_object(zram->mem_pool, handle);
 	atomic64_add(comp_len, &zram->stats.compr_data_size);
+
+	entry = zram_dedup_insert(zram, checksum, handle, comp_len, gen);
+	if (entry)
+		zram_write_slot(zram, index, (unsigned long)entry, comp_len,
+				gen, true);
+	else
+		zram_write_slot(zram, index, handle, comp_len, gen, false);
 out:
-	/*
-	 * Free memory associated with this sector
-	 * before overwriting unused sectors.
-	 */
-	zram_slot_lock(zram, index);
-	zram_free_page(zram, index);
+	zram_dict_read_unlock(dict_idx);
+	return ret;
+}
 
-	if (comp_len == PAGE_SIZE) {
-		zram_set_flag(zram, index, ZRAM_HUGE);
-		atomic64_inc(&zram->stats.huge_pages);
-		atomic64_inc(&zram->stats.huge_pages_since);
+/*
+ * Writes @nr full pages to consecutive slots starting at @index. Pages
+ * are compressed as one batch on a single per-CPU stream, which saves
+ * stream get/put round trips per page. Handles are allocated on the
+ * fast path only; the first page that needs the slow path (direct
+ * reclaim) is handed over to zram_write_page() and the batch continues
+ * with the rest.
+ */
+static int zram_write_pages(struct zram *zram, struct page **pages,
+			    u32 index, unsigned int nr)
+{
+	struct zram_entry *entries[ZCOMP_BATCH_PAGES];
+	unsigned long handles[ZCOMP_BATCH_PAGES];
+	unsigned int comp_len[ZCOMP_BATCH_PAGES];
+	struct page *batch[ZCOMP_BATCH_PAGES];
+	u64 checksums[ZCOMP_BATCH_PAGES];
+	u32 slots[ZCOMP_BATCH_PAGES];
+	unsigned int i, n = 0, done = 0;
+	unsigned long alloced_pages;
+	struct zcomp_strm *zstrm;
+	struct zcomp *comp;
+	int dict_idx, ret = 0;
+	u32 gen;
+
+	for (i = 0; i < nr; i++) {
+		if (zram_write_same_filled_page(zram, pages[i], index + i))
+			continue;
+		checksums[n] = 0;
+		if (zram_dedup_enabled(zram))
+			checksums[n] = zram_dedup_checksum(pages[i]);
+		batch[n] = pages[i];
+		slots[n++] = index + i;
 	}
 
-	if (flags) {
-		zram_set_flag(zram, index, flags);
-		zram_set_element(zram, index, element);
-	}  else {
-		zram_set_handle(zram, index, handle);
-		zram_set_obj_size(zram, index, comp_len);
+	dict_idx = zram_dict_read_lock();
+	gen = zram_dict_gen(zram);
+	comp = zram_dict_comp(zram, gen);
+
+	while (done < n) {
+		unsigned int off = 0, nr_comp;
+		u64 start, elapsed;
+
+		zstrm = zcomp_stream_get(comp);
+		start = zram_hist_start();
+		ret = zcomp_compress_batch(comp, zstrm, batch + done,
+					   n - done, comp_len);
+		if (unlikely(ret < 0)) {
+			zcomp_stream_put(comp);
+			pr_err("Compression failed! err=%d\n", ret);
+			break;
+		}
+
+		nr_comp = ret;
+		ret = 0;
+		/* Batch latency is accounted evenly to the batched pages */
+		elapsed = div_u64(zram_hist_elapsed(start), nr_comp);
+		for (i = 0; i < nr_comp; i++) {
+			unsigned int len = comp_len[i];
+			void *src, *dst;
+
+			zram_hist_record(zram, ZRAM_HIST_COMP_NS,
+					 ZRAM_PRIMARY_COMP, elapsed);
+			zram_hist_record(zram, ZRAM_HIST_COMP_SIZE,
+					 ZRAM_PRIMARY_COMP, len);
+
+			src = zstrm->buffer + off;
+			off += len;
+			if (len >= huge_class_size)
+				len = PAGE_SIZE;
+			comp_len[i] = len;
+
+			entries[i] = zram_dedup_find(zram, checksums[done + i],
+						     batch[done + i], src, len,
+						     gen);
+			if (entries[i])
+				continue;
+
+			handles[i] = zs_malloc(zram->mem_pool, len,
+					       __GFP_KSWAPD_RECLAIM |
+					       __GFP_NOWARN |
+					       __GFP_HIGHMEM |
+					       __GFP_MOVABLE);
+			if (IS_ERR_VALUE(handles[i]))
+				break;
+
+			alloced_pages = zs_get_total_pages(zram->mem_pool);
+			update_used_max(zram, alloced_pages);
+
+			if (zram->limit_pages &&
+			    alloced_pages > zram->limit_pages) {
+				zs_free(zram->mem_pool, handles[i]);
+				ret = -ENOMEM;
+				break;
+			}
+
+			dst = zs_map_object(zram->mem_pool, handles[i],
+					    ZS_MM_WO);
+			if (len == PAGE_SIZE)
+				src = kmap_local_page(batch[done + i]);
+			memcpy(dst, src, len);
+			if (len == PAGE_SIZE)
+				kunmap_local(src);
+			zs_unmap_object(zram->mem_pool, handles[i]);
+
+			atomic64_add(len, &zram->stats.compr_data_size);
+		}
+		zcomp_stream_put(comp);
+
+		nr_comp = i;
+		for (i = 0; i < nr_comp; i++) {
+			if (!entries[i])
+				entries[i] = zram_dedup_insert(zram,
+						checksums[done + i], handles[i],
+						comp_len[i], gen);
+			if (entries[i])
+				zram_write_slot(zram, slots[done + i],
+						(unsigned long)entries[i],
+						comp_len[i], gen, true);
+			else
+				zram_write_slot(zram, slots[done + i],
+						handles[i], comp_len[i], gen,
+						false);
+		}
+		done += nr_comp;
+
+		if (ret)
+			break;
+
+		/*
+		 * Fast path handle allocation failed, the slow path
+		 * recompresses the page once the handle is allocated.
+		 */
+		if (done < n && !nr_comp) {
+			ret = zram_write_page(zram, batch[done], slots[done]);
+			if (ret)
+				break;
+			done++;
+		}
 	}
-	zram_slot_unlock(zram, index);
 
-	/* Update stats */
-	atomic64_inc(&zram->stats.pages_stored);
+	zram_dict_read_unlock(dict_idx);
 	return ret;
 }
 
@@ -1860,6 +2947,7 @@ static int recompress_slot(struct zram *zram, u32 index, struct page *page,
 	unsigned int class_index_new;
 	u32 num_recomps = 0;
 	void *src, *dst;
+	u64 start;
 	int ret;
 
 	handle_old = zram_get_handle(zram, index);
@@ -1902,10 +2990,16 @@ static int recompress_slot(struct zram *zram, u32 index, struct page *page,
 
 		num_recomps++;
 		zstrm = zcomp_stream_get(zram->comps[prio]);
+		start = zram_hist_start();
 		src = kmap_local_page(page);
 		ret = zcomp_compress(zram->comps[prio], zstrm,
 				     src, &comp_len_new);
 		kunmap_local(src);
+		zram_hist_record(zram, ZRAM_HIST_COMP_NS, prio,
+				 zram_hist_elapsed(start));
+		if (!ret)
+			zram_hist_record(zram, ZRAM_HIST_COMP_SIZE, prio,
+					 comp_len_new);
 
 		if (ret) {
 			zcomp_stream_put(zram->comps[prio]);
@@ -2153,6 +3247,194 @@ static ssize_t recompress_store(struct device *dev,
 }
 #endif
 
+#ifdef CONFIG_ZRAM_DICT_TRAINING
+#define ZRAM_DICT_MAX_SAMPLES	32
+
+/*
+ * Samples up to @nr_samples stored pages, evenly spread across the
+ * device, and concatenates them into @dict. The result is used as a raw
+ * content dictionary.
+ *
+ * Returns the number of sampled pages.
+ */
+static int zram_sample_dict(struct zram *zram, void *dict, u32 nr_samples,
+			    struct page *page)
+{
+	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
+	unsigned long stride = max(nr_pages / nr_samples, 1UL);
+	unsigned long index, end;
+	u32 n = 0;
+	int ret;
+
+	for (index = 0; index < nr_pages && n < nr_samples; index = end) {
+		end = min(index + stride, nr_pages);
+
+		for (; index < end; index++) {
+			zram_slot_lock(zram, index);
+			if (!zram_allocated(zram, index) ||
+			    zram_test_flag(zram, index, ZRAM_WB) ||
+			    zram_test_flag(zram, index, ZRAM_SAME)) {
+				zram_slot_unlock(zram, index);
+				continue;
+			}
+
+			ret = zram_read_from_zspool(zram, page, index);
+			zram_slot_unlock(zram, index);
+			if (ret)
+				return ret;
+
+			memcpy_from_page(dict + n * PAGE_SIZE, page, 0,
+					 PAGE_SIZE);
+			n++;
+			break;
+		}
+		cond_resched();
+	}
+
+	return n;
+}
+
+static ssize_t train_dict_show(struct device *dev,
+			       struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	ssize_t ret;
+	u32 gen;
+
+	down_read(&zram->init_lock);
+	gen = zram->dict_gen;
+	ret = scnprintf(buf, PAGE_SIZE,
+			"%8u %8zu %8llu %8llu\n",
+			gen,
+			zram->dict_params[gen & 1].dict_sz,
+			(u64)atomic64_read(&zram->dict_pages[gen & 1]),
+			(u64)atomic64_read(&zram->dict_pages[!(gen & 1)]));
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+
+/*
+ * Builds a new dictionary out of stored pages and switches the primary
+ * compression algorithm over to it. The previous generation is kept
+ * around for objects that were compressed with it. Only two generations
+ * can be alive at a time, so a new dictionary cannot be installed while
+ * objects of the generation before the previous one still exist.
+ */
+static ssize_t train_dict_store(struct device *dev,
+				struct device_attribute *attr,
+				const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct zcomp_params *params;
+	struct page *page = NULL;
+	void *dict = NULL;
+	struct zcomp *comp;
+	u32 nr_samples, gen;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 10, &nr_samples);
+	if (ret)
+		return ret;
+
+	if (!nr_samples || nr_samples > ZRAM_DICT_MAX_SAMPLES)
+		return -EINVAL;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		ret = -EINVAL;
+		goto release_init_lock;
+	}
+
+	/* Do not permit concurrent post-processing actions. */
+	if (atomic_xchg(&zram->pp_in_progress, 1)) {
+		up_read(&zram->init_lock);
+		return -EAGAIN;
+	}
+
+	gen = zram->dict_gen + 1;
+	if (atomic64_read(&zram->dict_pages[gen & 1])) {
+		ret = -EBUSY;
+		goto release_pp;
+	}
+
+	page = alloc_page(GFP_KERNEL);
+	dict = vmalloc(nr_samples * PAGE_SIZE);
+	if (!page || !dict) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	ret = zram_sample_dict(zram, dict, nr_samples, page);
+	if (ret <= 0) {
+		ret = ret ?: -ENODATA;
+		goto out;
+	}
+
+	/*
+	 * No objects depend on the generation we are about to replace and
+	 * writers were done with it before the current generation has been
+	 * installed, so its backend can go.
+	 */
+	comp = zram->dict_comps[gen & 1];
+	zram->dict_comps[gen & 1] = NULL;
+	if (comp)
+		zcomp_destroy(comp);
+
+	params = &zram->dict_params[gen & 1];
+	vfree(params->dict);
+	params->dict = dict;
+	params->dict_sz = ret * PAGE_SIZE;
+	params->level = zram->params[ZRAM_PRIMARY_COMP].level;
+	dict = NULL;
+
+	comp = zcomp_create(zram->comp_algs[ZRAM_PRIMARY_COMP], params);
+	if (IS_ERR(comp)) {
+		pr_err("Cannot initialise %s compressing backend\n",
+		       zram->comp_algs[ZRAM_PRIMARY_COMP]);
+		ret = PTR_ERR(comp);
+		goto out;
+	}
+
+	WRITE_ONCE(zram->dict_comps[gen & 1], comp);
+	smp_store_release(&zram->dict_gen, gen);
+	/* Wait for writers that still compress with the previous generation */
+	synchronize_srcu(&zram_dict_srcu);
+	ret = len;
+
+out:
+	vfree(dict);
+	if (page)
+		__free_page(page);
+release_pp:
+	atomic_set(&zram->pp_in_progress, 0);
+release_init_lock:
+	up_read(&zram->init_lock);
+	return ret;
+}
+
+static void zram_destroy_dict_comps(struct zram *zram)
+{
+	u32 i;
+
+	for (i = 0; i < ARRAY_SIZE(zram->dict_comps); i++) {
+		struct zcomp_params *params = &zram->dict_params[i];
+
+		if (zram->dict_comps[i])
+			zcomp_destroy(zram->dict_comps[i]);
+		zram->dict_comps[i] = NULL;
+
+		vfree(params->dict);
+		params->dict = NULL;
+		params->dict_sz = 0;
+		atomic64_set(&zram->dict_pages[i], 0);
+	}
+	zram->dict_gen = 0;
+}
+#else
+static void zram_destroy_dict_comps(struct zram *zram) {};
+#endif
+
 static void zram_bio_discard(struct zram *zram, struct bio *bio)
 {
 	size_t n = bio->bi_iter.bi_size;
@@ -2214,6 +3496,9 @@ static void zram_bio_read(struct zram *zram, struct bio *bio)
 		zram_accessed(zram, index);
 		zram_slot_unlock(zram, index);
 
+		if (offset + bv.bv_len == PAGE_SIZE)
+			zram_ra_trigger(zram, index);
+
 		bio_advance_iter_single(bio, &iter, bv.bv_len);
 	} while (iter.bi_size);
 
@@ -2221,10 +3506,37 @@ static void zram_bio_read(struct zram *zram, struct bio *bio)
 	bio_endio(bio);
 }
 
+static int zram_bio_write_batch(struct zram *zram, struct page **pages,
+				u32 index, unsigned int nr)
+{
+	unsigned int i;
+	int ret;
+
+	if (!nr)
+		return 0;
+
+	if (nr == 1)
+		ret = zram_write_page(zram, pages[0], index);
+	else
+		ret = zram_write_pages(zram, pages, index, nr);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < nr; i++) {
+		zram_slot_lock(zram, index + i);
+		zram_accessed(zram, index + i);
+		zram_slot_unlock(zram, index + i);
+	}
+	return 0;
+}
+
 static void zram_bio_write(struct zram *zram, struct bio *bio)
 {
 	unsigned long start_time = bio_start_io_acct(bio);
 	struct bvec_iter iter = bio->bi_iter;
+	struct page *pages[ZCOMP_BATCH_PAGES];
+	unsigned int nr = 0;
+	u32 first = 0;
 
 	do {
 		u32 index = iter.bi_sector >> SECTORS_PER_PAGE_SHIFT;
@@ -2234,12 +3546,31 @@ static void zram_bio_write(struct zram *zram, struct bio *bio)
 
 		bv.bv_len = min_t(u32, bv.bv_len, PAGE_SIZE - offset);
 
-		if (zram_bvec_write(zram, &bv, index, offset, bio) < 0) {
-			atomic64_inc(&zram->stats.failed_writes);
-			bio->bi_status = BLK_STS_IOERR;
-			break;
+		/*
+		 * Full pages of the bio are collected and compressed as
+		 * a batch, partial IO goes through the single page path.
+		 */
+		if (!is_partial_io(&bv)) {
+			pages[nr++] = bv.bv_page;
+			if (nr == 1)
+				first = index;
+			if (nr == ZCOMP_BATCH_PAGES) {
+				if (zram_bio_write_batch(zram, pages, first,
+							 nr) < 0)
+					goto err;
+				nr = 0;
+			}
+			bio_advance_iter_single(bio, &iter, bv.bv_len);
+			continue;
 		}
 
+		if (zram_bio_write_batch(zram, pages, first, nr) < 0)
+			goto err;
+		nr = 0;
+
+		if (zram_bvec_write(zram, &bv, index, offset, bio) < 0)
+			goto err;
+
 		zram_slot_lock(zram, index);
 		zram_accessed(zram, index);
 		zram_slot_unlock(zram, index);
@@ -2247,6 +3578,14 @@ static void zram_bio_write(struct zram *zram, struct bio *bio)
 		bio_advance_iter_single(bio, &iter, bv.bv_len);
 	} while (iter.bi_size);
 
+	if (zram_bio_write_batch(zram, pages, first, nr) < 0)
+		goto err;
+	goto out;
+
+err:
+	atomic64_inc(&zram->stats.failed_writes);
+	bio->bi_status = BLK_STS_IOERR;
+out:
 	bio_end_io_acct(bio, start_time);
 	bio_endio(bio);
 }
@@ -2322,6 +3661,7 @@ static void zram_destroy_comps(struct zram *zram)
 		zram->comp_algs[prio] = NULL;
 	}
 
+	zram_destroy_dict_comps(zram);
 	zram_comp_params_reset(zram);
 }
 
@@ -2339,6 +3679,7 @@ static void zram_reset_device(struct zram *zram)
 	zram->disksize = 0;
 	zram_destroy_comps(zram);
 	memset(&zram->stats, 0, sizeof(zram->stats));
+	zram_hist_reset(zram);
 	atomic_set(&zram->pp_in_progress, 0);
 	reset_bdev(zram);
 
@@ -2475,11 +3816,15 @@ static DEVICE_ATTR_RW(backing_dev);
 static DEVICE_ATTR_WO(writeback);
 static DEVICE_ATTR_RW(writeback_limit);
 static DEVICE_ATTR_RW(writeback_limit_enable);
+static DEVICE_ATTR_RW(writeback_batch_size);
 #endif
 #ifdef CONFIG_ZRAM_MULTI_COMP
 static DEVICE_ATTR_RW(recomp_algorithm);
 static DEVICE_ATTR_WO(recompress);
 #endif
+#ifdef CONFIG_ZRAM_DICT_TRAINING
+static DEVICE_ATTR_RW(train_dict);
+#endif
 static DEVICE_ATTR_WO(algorithm_params);
 
 static struct attribute *zram_disk_attrs[] = {
@@ -2497,6 +3842,7 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_writeback.attr,
 	&dev_attr_writeback_limit.attr,
 	&dev_attr_writeback_limit_enable.attr,
+	&dev_attr_writeback_batch_size.attr,
 #endif
 	&dev_attr_io_stat.attr,
 	&dev_attr_mm_stat.attr,
@@ -2504,9 +3850,20 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_bd_stat.attr,
 #endif
 	&dev_attr_debug_stat.attr,
+#ifdef CONFIG_ZRAM_DEDUP
+	&dev_attr_use_dedup.attr,
+	&dev_attr_dedup_stat.attr,
+#endif
+#ifdef CONFIG_ZRAM_READ_AHEAD
+	&dev_attr_read_ahead_pages.attr,
+	&dev_attr_read_ahead_stat.attr,
+#endif
 #ifdef CONFIG_ZRAM_MULTI_COMP
 	&dev_attr_recomp_algorithm.attr,
 	&dev_attr_recompress.attr,
+#endif
+#ifdef CONFIG_ZRAM_DICT_TRAINING
+	&dev_attr_train_dict.attr,
 #endif
 	&dev_attr_algorithm_params.attr,
 	NULL,
@@ -2556,10 +3913,16 @@ static int zram_add(void)
 		goto out_free_dev;
 	device_id = ret;
 
+	ret = zram_hist_alloc(zram);
+	if (ret)
+		goto out_free_idr;
+
 	init_rwsem(&zram->init_lock);
 #ifdef CONFIG_ZRAM_WRITEBACK
 	spin_lock_init(&zram->wb_limit_lock);
+	zram->wb_batch_size = ZRAM_WB_BATCH_SIZE;
 #endif
+	zram_ra_setup(zram);
 
 	/* gendisk structure */
 	zram->disk = blk_alloc_disk(&lim, NUMA_NO_NODE);
@@ -2567,7 +3930,7 @@ static int zram_add(void)
 		pr_err("Error allocating disk structure for device %d\n",
 			device_id);
 		ret = PTR_ERR(zram->disk);
-		goto out_free_idr;
+		goto out_free_hist;
 	}
 
 	zram->disk->major = zram_major;
@@ -2593,6 +3956,8 @@ static int zram_add(void)
 
 out_cleanup_disk:
 	put_disk(zram->disk);
+out_free_hist:
+	zram_hist_free(zram);
 out_free_idr:
 	idr_remove(&zram_index_idr, device_id);
 out_free_dev:
@@ -2644,6 +4009,7 @@ static int zram_remove(struct zram *zram)
 	zram_reset_device(zram);
 
 	put_disk(zram->disk);
+	zram_hist_free(zram);
 	kfree(zram);
 	return 0;
 }
@@ -20,6 +20,7 @@
 #include <linux/crypto.h>
 
 #include "zcomp.h"
+#include "zram_dedup.h"
 
 #define SECTORS_PER_PAGE_SHIFT	(PAGE_SHIFT - SECTOR_SHIFT)
 #define SECTORS_PER_PAGE	(1 << SECTORS_PER_PAGE_SHIFT)
@@ -54,6 +55,9 @@ enum zram_pageflags {
 
 	ZRAM_COMP_PRIORITY_BIT1, /* First bit of comp priority index */
 	ZRAM_COMP_PRIORITY_BIT2, /* Second bit of comp priority index */
+	ZRAM_DICT_GEN,	/* parity of the dictionary generation of the object */
+	ZRAM_DEDUP,	/* handle points to a shared zram_entry */
+	ZRAM_RA_CACHED,	/* decompressed copy is in the read-ahead cache */
 
 	__NR_ZRAM_PAGEFLAGS,
 };
@@ -90,6 +94,15 @@ struct zram_stats {
 	atomic64_t bd_reads;		/* no. of reads from backing device */
 	atomic64_t bd_writes;		/* no. of writes from backing device */
 #endif
+#ifdef CONFIG_ZRAM_READ_AHEAD
+	atomic64_t ra_decomp;		/* no. of pages decompressed ahead */
+	atomic64_t ra_hits;		/* no. of reads served from the cache */
+#endif
+#ifdef CONFIG_ZRAM_DEDUP
+	atomic64_t dup_data_size;	/* compressed size of pages duplicated */
+	atomic64_t dup_pages;		/* no. of duplicated pages */
+	atomic64_t meta_data_size;	/* size of dedup metadata */
+#endif
 };
 
 #ifdef CONFIG_ZRAM_MULTI_COMP
@@ -102,6 +115,30 @@ struct zram_stats {
 #define ZRAM_MAX_COMPS	1U
 #endif
 
+enum zram_hist_type {
+	ZRAM_HIST_COMP_NS,
+	ZRAM_HIST_DECOMP_NS,
+	ZRAM_HIST_COMP_SIZE,
+	NR_ZRAM_HISTS,
+};
+
+#ifdef CONFIG_ZRAM_HISTOGRAM
+/* Bucket i counts values in [2^(i-1), 2^i), bucket 0 counts zeroes */
+#define ZRAM_HIST_BUCKETS	32
+
+struct zram_hist {
+	u64 buckets[NR_ZRAM_HISTS][ZRAM_MAX_COMPS][ZRAM_HIST_BUCKETS];
+};
+#endif
+
+#ifdef CONFIG_ZRAM_READ_AHEAD
+struct zram_ra_entry {
+	struct page *page;
+	u32 index;
+	bool valid;
+};
+#endif
+
 struct zram {
 	struct zram_table_entry *table;
 	struct zs_pool *mem_pool;
@@ -132,13 +169,58 @@ struct zram {
 	spinlock_t wb_limit_lock;
 	bool wb_limit_enable;
 	u64 bd_wb_limit;
+	u32 wb_batch_size;
 	struct block_device *bdev;
 	unsigned long *bitmap;
 	unsigned long nr_pages;
 #endif
-#ifdef CONFIG_ZRAM_MEMORY_TRACKING
+#if defined CONFIG_ZRAM_MEMORY_TRACKING || defined CONFIG_ZRAM_HISTOGRAM
 	struct dentry *debugfs_dir;
+#endif
+#ifdef CONFIG_ZRAM_HISTOGRAM
+	struct zram_hist __percpu *hist;
+#endif
+#ifdef CONFIG_ZRAM_DICT_TRAINING
+	/*
+	 * Primary compression backends of the two most recent dictionary
+	 * generations, indexed by generation parity. NULL means that the
+	 * generation uses comps[ZRAM_PRIMARY_COMP].
+	 */
+	struct zcomp *dict_comps[2];
+	struct zcomp_params dict_params[2];
+	/* no. of objects that need each generation for decompression */
+	atomic64_t dict_pages[2];
+	u32 dict_gen;
+#endif
+#ifdef CONFIG_ZRAM_READ_AHEAD
+	/* decompress-ahead window in pages, 0 disables decompress-ahead */
+	u32 ra_pages;
+	struct zram_ra_entry *ra_cache;
+	u32 ra_cache_size;
+	u32 ra_hand;
+	/* last read slot, updated locklessly */
+	u32 ra_last;
+	/* current window and the range to decompress, under ra_lock */
+	u32 ra_begin;
+	u32 ra_start;
+	u32 ra_end;
+	spinlock_t ra_lock;
+	struct work_struct ra_work;
+#endif
+#ifdef CONFIG_ZRAM_DEDUP
+	bool use_dedup;
+	struct zram_hash *hash;
+	size_t hash_size;
 #endif
 	atomic_t pp_in_progress;
 };
+
+static inline bool zram_dedup_enabled(struct zram *zram)
+{
+#ifdef CONFIG_ZRAM_DEDUP
+	return zram->use_dedup;
+#else
+	return false;
+#endif
+}
 #endif
@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * zram tracepoints.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM zram
+
+#if !defined(_TRACE_ZRAM_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_ZRAM_H
+
+#include <linux/tracepoint.h>
+
+#include "zram_drv.h"
+
+TRACE_EVENT(zram_read_page,
+	    TP_PROTO(struct zram *zram, u32 index, unsigned int size,
+		     u32 prio, bool wb, int ret),
+	    TP_ARGS(zram, index, size, prio, wb, ret),
+	    TP_STRUCT__entry(
+		__string(disk, zram->disk->disk_name)
+		__field(u32, index)
+		__field(unsigned int, size)
+		__field(u32, prio)
+		__field(bool, wb)
+		__field(int, ret)
+	    ),
+	    TP_fast_assign(
+		__assign_str(disk);
+		__entry->index = index;
+		__entry->size = size;
+		__entry->prio = prio;
+		__entry->wb = wb;
+		__entry->ret = ret;
+	    ),
+	    TP_printk("%s index=%u size=%u prio=%u wb=%d ret=%d",
+		      __get_str(disk), __entry->index, __entry->size,
+		      __entry->prio, __entry->wb, __entry->ret)
+);
+
+TRACE_EVENT(zram_write_page,
+	    TP_PROTO(struct zram *zram, u32 index, unsigned int size,
+		     bool same, bool dedup),
+	    TP_ARGS(zram, index, size, same, dedup),
+	    TP_STRUCT__entry(
+		__string(disk, zram->disk->disk_name)
+		__field(u32, index)
+		__field(unsigned int, size)
+		__field(bool, same)
+		__field(bool, dedup)
+	    ),
+	    TP_fast_assign(
+		__assign_str(disk);
+		__entry->index = index;
+		__entry->size = size;
+		__entry->same = same;
+		__entry->dedup = dedup;
+	    ),
+	    TP_printk("%s index=%u size=%u same=%d dedup=%d",
+		      __get_str(disk), __entry->index, __entry->size,
+		      __entry->same, __entry->dedup)
+);
+
+#endif /* _TRACE_ZRAM_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE zram_trace
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
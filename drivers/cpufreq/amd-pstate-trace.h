@@ -88,6 +88,37 @@ TRACE_EVENT(amd_pstate_perf,
 		 )
 );
 
+TRACE_EVENT(amd_pstate_prefcore_ranking,
+
+	TP_PROTO(unsigned int cpu_id,
+		 u32 prev_ranking,
+		 u32 ranking
+		 ),
+
+	TP_ARGS(cpu_id,
+		prev_ranking,
+		ranking
+		),
+
+	TP_STRUCT__entry(
+		__field(unsigned int, cpu_id)
+		__field(u32, prev_ranking)
+		__field(u32, ranking)
+		),
+
+	TP_fast_assign(
+		__entry->cpu_id = cpu_id;
+		__entry->prev_ranking = prev_ranking;
+		__entry->ranking = ranking;
+		),
+
+	TP_printk("cpu_id=%u prev_ranking=%u ranking=%u",
+		  (unsigned int)__entry->cpu_id,
+		  (unsigned int)__entry->prev_ranking,
+		  (unsigned int)__entry->ranking
+		 )
+);
+
 #endif /* _AMD_PSTATE_TRACE_H */
 
 /* This part must be outside protection */
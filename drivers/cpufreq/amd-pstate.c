@@ -809,20 +809,21 @@ static void amd_pstate_init_prefcore(struct amd_cpudata *cpudata)
 
 static void amd_pstate_update_limits(unsigned int cpu)
 {
-	struct cpufreq_policy *policy = cpufreq_cpu_get(cpu);
+	struct cpufreq_policy *policy;
 	struct amd_cpudata *cpudata;
 	u32 prev_high = 0, cur_high = 0;
 	int ret;
 	bool highest_perf_changed = false;
 
+	if (!amd_pstate_prefcore)
+		return;
+
+	policy = cpufreq_cpu_get(cpu);
 	if (!policy)
 		return;
 
 	cpudata = policy->driver_data;
 
-	if (!amd_pstate_prefcore)
-		return;
-
 	mutex_lock(&amd_pstate_driver_lock);
 	ret = amd_get_highest_perf(cpu, &cur_high);
 	if (ret)
@@ -832,6 +833,9 @@ static void amd_pstate_update_limits(unsigned int cpu)
 	highest_perf_changed = (prev_high != cur_high);
 	if (highest_perf_changed) {
 		WRITE_ONCE(cpudata->prefcore_ranking, cur_high);
+		WRITE_ONCE(cpudata->prefcore_updates,
+			   cpudata->prefcore_updates + 1);
+		trace_amd_pstate_prefcore_ranking(cpu, prev_high, cur_high);
 
 		if (cur_high < CPPC_MAX_PERF)
 			sched_set_itmt_core_prio((int)cur_high, cpu);
@@ -1127,6 +1131,14 @@ static ssize_t show_amd_pstate_prefcore_ranking(struct cpufreq_policy *policy,
 	return sysfs_emit(buf, "%u\n", perf);
 }
 
+static ssize_t show_amd_pstate_prefcore_updates(struct cpufreq_policy *policy,
+						char *buf)
+{
+	struct amd_cpudata *cpudata = policy->driver_data;
+
+	return sysfs_emit(buf, "%u\n", READ_ONCE(cpudata->prefcore_updates));
+}
+
 static ssize_t show_amd_pstate_hw_prefcore(struct cpufreq_policy *policy,
 					   char *buf)
 {
@@ -1373,6 +1385,7 @@ cpufreq_freq_attr_ro(amd_pstate_lowest_nonlinear_freq);
 
 cpufreq_freq_attr_ro(amd_pstate_highest_perf);
 cpufreq_freq_attr_ro(amd_pstate_prefcore_ranking);
+cpufreq_freq_attr_ro(amd_pstate_prefcore_updates);
 cpufreq_freq_attr_ro(amd_pstate_hw_prefcore);
 cpufreq_freq_attr_rw(energy_performance_preference);
 cpufreq_freq_attr_ro(energy_performance_available_preferences);
@@ -1384,6 +1397,7 @@ static struct freq_attr *amd_pstate_attr[] = {
 	&amd_pstate_lowest_nonlinear_freq,
 	&amd_pstate_highest_perf,
 	&amd_pstate_prefcore_ranking,
+	&amd_pstate_prefcore_updates,
 	&amd_pstate_hw_prefcore,
 	NULL,
 };
@@ -1393,6 +1407,7 @@ static struct freq_attr *amd_pstate_epp_attr[] = {
 	&amd_pstate_lowest_nonlinear_freq,
 	&amd_pstate_highest_perf,
 	&amd_pstate_prefcore_ranking,
+	&amd_pstate_prefcore_updates,
 	&amd_pstate_hw_prefcore,
 	&energy_performance_preference,
 	&energy_performance_available_preferences,
@@ -42,6 +42,7 @@ struct amd_aperf_mperf {
  * @lowest_perf: the absolute lowest performance level of the processor
  * @prefcore_ranking: the preferred core ranking, the higher value indicates a higher
  * 		  priority.
+ * @prefcore_updates: number of times the preferred core ranking changed
  * @min_limit_perf: Cached value of the performance corresponding to policy->min
  * @max_limit_perf: Cached value of the performance corresponding to policy->max
  * @min_limit_freq: Cached value of policy->min (in khz)
@@ -76,6 +77,7 @@ struct amd_cpudata {
 	u32	lowest_nonlinear_perf;
 	u32	lowest_perf;
 	u32     prefcore_ranking;
+	u32     prefcore_updates;
 	u32     min_limit_perf;
 	u32     max_limit_perf;
 	u32     min_limit_freq;
@@ -0,0 +1,359 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ *  drivers/cpufreq/cpufreq_history.c
+ *
+ *  History based dynamic cpufreq governor.
+ *
+ *  The governor keeps an exponentially weighted moving average of the load
+ *  reported by dbs_update() for every policy and selects the frequency from
+ *  that average rather than from the last sample alone.  A sample that
+ *  exceeds the average by more than burst_threshold is treated as a burst and
+ *  takes the policy straight to its maximum frequency.  Sustained high load
+ *  ramps the frequency so that the whole min..max range is covered within
+ *  ramp_latency_us, independently of the sampling rate.
+ */
+
+#include <linux/math64.h>
+#include <linux/slab.h>
+#include "cpufreq_governor.h"
+
+/* Load averages are kept in percent scaled by 2^HIST_LOAD_SHIFT */
+#define HIST_LOAD_SHIFT				10
+
+struct hist_policy_dbs_info {
+	struct policy_dbs_info policy_dbs;
+	unsigned int ewma_load;
+	unsigned int down_skip;
+	unsigned int requested_freq;
+};
+
+static inline struct hist_policy_dbs_info *to_dbs_info(struct policy_dbs_info *policy_dbs)
+{
+	return container_of(policy_dbs, struct hist_policy_dbs_info, policy_dbs);
+}
+
+struct hist_dbs_tuners {
+	unsigned int ewma_weight;
+	unsigned int burst_threshold;
+	unsigned int ramp_latency_us;
+};
+
+/* History governor macros */
+#define DEF_FREQUENCY_UP_THRESHOLD		(80)
+#define DEF_SAMPLING_DOWN_FACTOR		(1)
+#define MAX_SAMPLING_DOWN_FACTOR		(100000)
+#define DEF_EWMA_WEIGHT				(25)
+#define DEF_BURST_THRESHOLD			(40)
+#define DEF_RAMP_LATENCY_US			(20000)
+/* Idle periods beyond this leave next to nothing of the old average */
+#define MAX_IDLE_DECAY				(16)
+
+static unsigned int hist_ewma(unsigned int avg, unsigned int load,
+			      unsigned int weight)
+{
+	int delta = (int)(load << HIST_LOAD_SHIFT) - (int)avg;
+
+	return avg + delta * (int)weight / 100;
+}
+
+static unsigned int hist_ramp_step(struct hist_dbs_tuners *hist_tuners,
+				   struct dbs_data *dbs_data,
+				   struct cpufreq_policy *policy)
+{
+	unsigned int range = policy->max - policy->min;
+
+	if (hist_tuners->ramp_latency_us <= dbs_data->sampling_rate)
+		return range;
+
+	return max_t(unsigned int, 1,
+		     div_u64((u64)range * dbs_data->sampling_rate,
+			     hist_tuners->ramp_latency_us));
+}
+
+/*
+ * Every sampling_rate the load of the policy is folded into the moving
+ * average.  A burst (the new sample exceeding the average by more than
+ * burst_threshold) selects the maximum frequency right away.  Load above
+ * up_threshold raises the frequency by at least one ramp step, and
+ * otherwise the frequency follows the average proportionally.  Decreases
+ * are only applied every sampling_down_factor samples.
+ */
+static unsigned int hist_dbs_update(struct cpufreq_policy *policy)
+{
+	struct policy_dbs_info *policy_dbs = policy->governor_data;
+	struct hist_policy_dbs_info *dbs_info = to_dbs_info(policy_dbs);
+	struct dbs_data *dbs_data = policy_dbs->dbs_data;
+	struct hist_dbs_tuners *hist_tuners = dbs_data->tuners;
+	unsigned int requested_freq = dbs_info->requested_freq;
+	unsigned int load = dbs_update(policy);
+	unsigned int avg, freq_next;
+
+	if (requested_freq > policy->max || requested_freq < policy->min) {
+		requested_freq = policy->cur;
+		dbs_info->requested_freq = requested_freq;
+	}
+
+	/* Decay the average for the sampling periods spent idle. */
+	if (policy_dbs->idle_periods < UINT_MAX) {
+		unsigned int n = min_t(unsigned int, policy_dbs->idle_periods,
+				       MAX_IDLE_DECAY);
+
+		while (n--)
+			dbs_info->ewma_load = hist_ewma(dbs_info->ewma_load, 0,
+							hist_tuners->ewma_weight);
+
+		policy_dbs->idle_periods = UINT_MAX;
+	}
+
+	avg = dbs_info->ewma_load >> HIST_LOAD_SHIFT;
+	dbs_info->ewma_load = hist_ewma(dbs_info->ewma_load, load,
+					hist_tuners->ewma_weight);
+
+	/* Burst on top of the history: go to the maximum right away. */
+	if (load >= avg + hist_tuners->burst_threshold) {
+		dbs_info->down_skip = 0;
+		freq_next = policy->max;
+		goto set_freq;
+	}
+
+	avg = dbs_info->ewma_load >> HIST_LOAD_SHIFT;
+	freq_next = policy->min + (policy->max - policy->min) * avg / 100;
+
+	if (load > dbs_data->up_threshold) {
+		dbs_info->down_skip = 0;
+		freq_next = max(freq_next, requested_freq +
+				hist_ramp_step(hist_tuners, dbs_data, policy));
+		goto set_freq;
+	}
+
+	if (freq_next >= requested_freq) {
+		dbs_info->down_skip = 0;
+		goto set_freq;
+	}
+
+	/* if sampling_down_factor is active break out early */
+	if (++dbs_info->down_skip < dbs_data->sampling_down_factor)
+		goto out;
+	dbs_info->down_skip = 0;
+
+set_freq:
+	freq_next = clamp(freq_next, policy->min, policy->max);
+	if (freq_next == requested_freq)
+		goto out;
+
+	__cpufreq_driver_target(policy, freq_next, freq_next > requested_freq ?
+				CPUFREQ_RELATION_H : CPUFREQ_RELATION_L);
+	dbs_info->requested_freq = freq_next;
+
+ out:
+	return dbs_data->sampling_rate;
+}
+
+/************************** sysfs interface ************************/
+
+static ssize_t sampling_down_factor_store(struct gov_attr_set *attr_set,
+					  const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1 || input > MAX_SAMPLING_DOWN_FACTOR || input < 1)
+		return -EINVAL;
+
+	dbs_data->sampling_down_factor = input;
+	return count;
+}
+
+static ssize_t up_threshold_store(struct gov_attr_set *attr_set,
+				  const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1 || input > 100 || input < 1)
+		return -EINVAL;
+
+	dbs_data->up_threshold = input;
+	return count;
+}
+
+static ssize_t ignore_nice_load_store(struct gov_attr_set *attr_set,
+				      const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1)
+		return -EINVAL;
+
+	if (input > 1)
+		input = 1;
+
+	if (input == dbs_data->ignore_nice_load) /* nothing to do */
+		return count;
+
+	dbs_data->ignore_nice_load = input;
+
+	/* we need to re-evaluate prev_cpu_idle */
+	gov_update_cpu_data(dbs_data);
+
+	return count;
+}
+
+static ssize_t ewma_weight_store(struct gov_attr_set *attr_set,
+				 const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct hist_dbs_tuners *hist_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	/* a weight of 0 would freeze the average */
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1 || input < 1 || input > 100)
+		return -EINVAL;
+
+	hist_tuners->ewma_weight = input;
+	return count;
+}
+
+static ssize_t burst_threshold_store(struct gov_attr_set *attr_set,
+				     const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct hist_dbs_tuners *hist_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	/* values above 100 disable burst detection */
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1 || input < 1)
+		return -EINVAL;
+
+	hist_tuners->burst_threshold = min(input, 101U);
+	return count;
+}
+
+static ssize_t ramp_latency_us_store(struct gov_attr_set *attr_set,
+				     const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct hist_dbs_tuners *hist_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1)
+		return -EINVAL;
+
+	hist_tuners->ramp_latency_us = input;
+	return count;
+}
+
+gov_show_one_common(sampling_rate);
+gov_show_one_common(sampling_down_factor);
+gov_show_one_common(up_threshold);
+gov_show_one_common(ignore_nice_load);
+gov_show_one(hist, ewma_weight);
+gov_show_one(hist, burst_threshold);
+gov_show_one(hist, ramp_latency_us);
+
+gov_attr_rw(sampling_rate);
+gov_attr_rw(sampling_down_factor);
+gov_attr_rw(up_threshold);
+gov_attr_rw(ignore_nice_load);
+gov_attr_rw(ewma_weight);
+gov_attr_rw(burst_threshold);
+gov_attr_rw(ramp_latency_us);
+
+static struct attribute *hist_attrs[] = {
+	&sampling_rate.attr,
+	&sampling_down_factor.attr,
+	&up_threshold.attr,
+	&ignore_nice_load.attr,
+	&ewma_weight.attr,
+	&burst_threshold.attr,
+	&ramp_latency_us.attr,
+	NULL
+};
+ATTRIBUTE_GROUPS(hist);
+
+/************************** sysfs end ************************/
+
+static struct policy_dbs_info *hist_alloc(void)
+{
+	struct hist_policy_dbs_info *dbs_info;
+
+	dbs_info = kzalloc(sizeof(*dbs_info), GFP_KERNEL);
+	return dbs_info ? &dbs_info->policy_dbs : NULL;
+}
+
+static void hist_free(struct policy_dbs_info *policy_dbs)
+{
+	kfree(to_dbs_info(policy_dbs));
+}
+
+static int hist_init(struct dbs_data *dbs_data)
+{
+	struct hist_dbs_tuners *tuners;
+
+	tuners = kzalloc(sizeof(*tuners), GFP_KERNEL);
+	if (!tuners)
+		return -ENOMEM;
+
+	tuners->ewma_weight = DEF_EWMA_WEIGHT;
+	tuners->burst_threshold = DEF_BURST_THRESHOLD;
+	tuners->ramp_latency_us = DEF_RAMP_LATENCY_US;
+	dbs_data->up_threshold = DEF_FREQUENCY_UP_THRESHOLD;
+	dbs_data->sampling_down_factor = DEF_SAMPLING_DOWN_FACTOR;
+	dbs_data->ignore_nice_load = 0;
+	dbs_data->tuners = tuners;
+
+	return 0;
+}
+
+static void hist_exit(struct dbs_data *dbs_data)
+{
+	kfree(dbs_data->tuners);
+}
+
+static void hist_start(struct cpufreq_policy *policy)
+{
+	struct hist_policy_dbs_info *dbs_info = to_dbs_info(policy->governor_data);
+	unsigned int range = policy->max - policy->min;
+	unsigned int load = 0;
+
+	/* Seed the history with the load implied by the current frequency. */
+	if (range && policy->cur > policy->min)
+		load = min(100U, 100 * (policy->cur - policy->min) / range);
+
+	dbs_info->ewma_load = load << HIST_LOAD_SHIFT;
+	dbs_info->down_skip = 0;
+	dbs_info->requested_freq = policy->cur;
+}
+
+static struct dbs_governor hist_governor = {
+	.gov = CPUFREQ_DBS_GOVERNOR_INITIALIZER("history"),
+	.kobj_type = { .default_groups = hist_groups },
+	.gov_dbs_update = hist_dbs_update,
+	.alloc = hist_alloc,
+	.free = hist_free,
+	.init = hist_init,
+	.exit = hist_exit,
+	.start = hist_start,
+};
+
+#define CPU_FREQ_GOV_HISTORY	(hist_governor.gov)
+
+MODULE_DESCRIPTION("'cpufreq_history' - A dynamic cpufreq governor using "
+		"per-policy load history with burst detection");
+MODULE_LICENSE("GPL");
+
+cpufreq_governor_init(CPU_FREQ_GOV_HISTORY);
+cpufreq_governor_exit(CPU_FREQ_GOV_HISTORY);
@@ -298,6 +298,7 @@ static int hwp_mode_bdw __ro_after_init;
 static bool per_cpu_limits __ro_after_init;
 static bool hwp_forced __ro_after_init;
 static bool hwp_boost __read_mostly;
+static bool hwp_uclamp_epp __read_mostly;
 static bool hwp_is_hybrid;
 
 static struct cpufreq_driver *intel_pstate_driver __read_mostly;
@@ -1693,6 +1694,28 @@ static ssize_t store_hwp_dynamic_boost(struct kobject *a,
 	return count;
 }
 
+static ssize_t show_hwp_uclamp_epp(struct kobject *kobj,
+				  struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", hwp_uclamp_epp);
+}
+
+static ssize_t store_hwp_uclamp_epp(struct kobject *a,
+				   struct kobj_attribute *b,
+				   const char *buf, size_t count)
+{
+	bool input;
+	int ret;
+
+	ret = kstrtobool(buf, &input);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(hwp_uclamp_epp, input);
+
+	return count;
+}
+
 static ssize_t show_energy_efficiency(struct kobject *kobj, struct kobj_attribute *attr,
 				      char *buf)
 {
@@ -1729,6 +1752,7 @@ define_one_global_rw(min_perf_pct);
 define_one_global_ro(turbo_pct);
 define_one_global_ro(num_pstates);
 define_one_global_rw(hwp_dynamic_boost);
+define_one_global_rw(hwp_uclamp_epp);
 define_one_global_rw(energy_efficiency);
 
 static struct attribute *intel_pstate_attributes[] = {
@@ -1769,6 +1793,11 @@ static void __init intel_pstate_sysfs_expose_params(void)
 		WARN_ON(rc);
 	}
 
+	if (hwp_active && boot_cpu_has(X86_FEATURE_HWP_EPP)) {
+		rc = sysfs_create_file(intel_pstate_kobject, &hwp_uclamp_epp.attr);
+		WARN_ON(rc);
+	}
+
 	/*
 	 * If per cpu limits are enforced there are no global limits, so
 	 * return without creating max/min_perf_pct attributes
@@ -1800,6 +1829,9 @@ static void __init intel_pstate_sysfs_remove(void)
 		sysfs_remove_file(intel_pstate_kobject, &turbo_pct.attr);
 	}
 
+	if (hwp_active && boot_cpu_has(X86_FEATURE_HWP_EPP))
+		sysfs_remove_file(intel_pstate_kobject, &hwp_uclamp_epp.attr);
+
 	if (!per_cpu_limits) {
 		sysfs_remove_file(intel_pstate_kobject, &max_perf_pct.attr);
 		sysfs_remove_file(intel_pstate_kobject, &min_perf_pct.attr);
@@ -3080,10 +3112,15 @@ static void intel_cpufreq_trace(struct cpudata *cpu, unsigned int trace_type, in
 }
 
 static void intel_cpufreq_hwp_update(struct cpudata *cpu, u32 min, u32 max,
-				     u32 desired, bool fast_switch)
+				     u32 desired, int epp, bool fast_switch)
 {
 	u64 prev = READ_ONCE(cpu->hwp_req_cached), value = prev;
 
+	if (epp >= 0) {
+		value &= ~GENMASK_ULL(31, 24);
+		value |= HWP_ENERGY_PERF_PREFERENCE(epp);
+	}
+
 	value &= ~HWP_MIN_PERF(~0L);
 	value |= HWP_MIN_PERF(min);
 
@@ -3125,7 +3162,7 @@ static int intel_cpufreq_update_pstate(struct cpufreq_policy *policy,
 		int max_pstate = policy->strict_target ?
 					target_pstate : cpu->max_perf_ratio;
 
-		intel_cpufreq_hwp_update(cpu, target_pstate, max_pstate, 0,
+		intel_cpufreq_hwp_update(cpu, target_pstate, max_pstate, 0, -1,
 					 fast_switch);
 	} else if (target_pstate != old_pstate) {
 		intel_cpufreq_perf_ctl_update(cpu, target_pstate, fast_switch);
@@ -3175,6 +3212,30 @@ static unsigned int intel_cpufreq_fast_switch(struct cpufreq_policy *policy,
 	return target_pstate * cpu->pstate.scaling;
 }
 
+/*
+ * With hwp_uclamp_epp set, move EPP from the configured value towards
+ * "performance" in proportion to the minimum performance requested by the
+ * governor.  That includes the uclamp.min of the tasks (and cgroups) runnable
+ * on the CPU, as well as deadline bandwidth, so latency-critical tasks get a
+ * more aggressive EPP only while they are there.
+ */
+static int intel_cpufreq_uclamp_epp(struct cpudata *cpu, unsigned long min_perf,
+				    unsigned long capacity)
+{
+	int epp = cpu->epp_cached;
+
+	if (!boot_cpu_has(X86_FEATURE_HWP_EPP) || epp < 0)
+		return -1;
+
+	if (!READ_ONCE(hwp_uclamp_epp))
+		return epp;
+
+	if (min_perf >= capacity)
+		return HWP_EPP_PERFORMANCE;
+
+	return epp - div_u64((u64)epp * min_perf, capacity);
+}
+
 static void intel_cpufreq_adjust_perf(unsigned int cpunum,
 				      unsigned long min_perf,
 				      unsigned long target_perf,
@@ -3214,7 +3275,9 @@ static void intel_cpufreq_adjust_perf(unsigned int cpunum,
 
 	target_pstate = clamp_t(int, target_pstate, min_pstate, max_pstate);
 
-	intel_cpufreq_hwp_update(cpu, min_pstate, max_pstate, target_pstate, true);
+	intel_cpufreq_hwp_update(cpu, min_pstate, max_pstate, target_pstate,
+				 intel_cpufreq_uclamp_epp(cpu, min_perf, capacity),
+				 true);
 
 	cpu->pstate.current_pstate = target_pstate;
 	intel_cpufreq_trace(cpu, INTEL_PSTATE_TRACE_FAST_SWITCH, old_pstate);
@@ -291,6 +291,7 @@ noinstr int cpuidle_enter_state(struct cpuidle_device *dev,
 
 	if (entered_state >= 0) {
 		s64 diff, delay = drv->states[entered_state].exit_latency_ns;
+		struct cpuidle_state_usage *usage;
 		int i;
 
 		/*
@@ -301,8 +302,21 @@ noinstr int cpuidle_enter_state(struct cpuidle_device *dev,
 		diff = ktime_sub(time_end, time_start);
 
 		dev->last_residency_ns = diff;
-		dev->states_usage[entered_state].time_ns += diff;
-		dev->states_usage[entered_state].usage++;
+		usage = &dev->states_usage[entered_state];
+		usage->time_ns += diff;
+		usage->usage++;
+
+		i = min(fls64(diff >> CPUIDLE_RESIDENCY_HIST_SHIFT),
+			CPUIDLE_RESIDENCY_HIST_BUCKETS - 1);
+		usage->residency_hist[i]++;
+
+		if (dev->predicted_ns) {
+			usage->predicted++;
+			usage->pred_error_ns += abs_diff((u64)diff,
+							 dev->predicted_ns);
+		}
+		trace_cpu_idle_residency(dev->cpu, entered_state, diff,
+					 dev->predicted_ns);
 
 		if (diff < drv->states[entered_state].target_residency_ns) {
 			for (i = entered_state - 1; i >= 0; i--) {
@@ -357,6 +371,9 @@ noinstr int cpuidle_enter_state(struct cpuidle_device *dev,
 int cpuidle_select(struct cpuidle_driver *drv, struct cpuidle_device *dev,
 		   bool *stop_tick)
 {
+	/* Governors providing an idle duration prediction will set this. */
+	dev->predicted_ns = 0;
+
 	return cpuidle_curr_governor->select(drv, dev, stop_tick);
 }
 
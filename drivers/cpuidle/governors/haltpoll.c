@@ -40,6 +40,37 @@ module_param(guest_halt_poll_grow_start, uint, 0644);
 static bool guest_halt_poll_allow_shrink __read_mostly = true;
 module_param(guest_halt_poll_allow_shrink, bool, 0644);
 
+/*
+ * percentage of wakeups to catch while polling, sizing the per-cpu poll
+ * window from a histogram of wakeup times instead of the grow/shrink rules
+ * above (0 disables)
+ */
+static unsigned int guest_halt_poll_target __read_mostly;
+module_param(guest_halt_poll_target, uint, 0644);
+
+/* max percentage of idle time spent polling for missed wakeups */
+static unsigned int guest_halt_poll_max_waste __read_mostly = 10;
+module_param(guest_halt_poll_max_waste, uint, 0644);
+
+/*
+ * Wakeup time histogram: bucket 0 counts wakeups below 1 << HIST_MIN_SHIFT ns,
+ * every following bucket doubles the upper bound, the last one also counts
+ * everything beyond it.
+ */
+#define HIST_BUCKETS	16
+#define HIST_MIN_SHIFT	10
+/* number of wakeups between poll window updates */
+#define HIST_WINDOW	64
+
+struct haltpoll_hist {
+	unsigned int buckets[HIST_BUCKETS];
+	unsigned int samples;
+	u64 idle_ns;
+	u64 poll_ns;
+};
+
+static DEFINE_PER_CPU(struct haltpoll_hist, haltpoll_hists);
+
 /**
  * haltpoll_select - selects the next idle state to enter
  * @drv: cpuidle driver containing state data
@@ -112,6 +143,74 @@ static void adjust_poll_limit(struct cpuidle_device *dev, u64 block_ns)
 	}
 }
 
+/*
+ * Pick the shortest poll window that catches guest_halt_poll_target percent
+ * of the recorded wakeups, unless the time spent polling for the wakeups it
+ * misses would exceed guest_halt_poll_max_waste percent of the idle time, in
+ * which case take the longest window below that.
+ */
+static void hist_update_poll_limit(struct cpuidle_device *dev,
+				   struct haltpoll_hist *hist)
+{
+	unsigned int total = 0, caught = 0;
+	u64 limit = 0, val;
+	int b;
+
+	for (b = 0; b < HIST_BUCKETS; b++)
+		total += hist->buckets[b];
+
+	for (b = 0; b < HIST_BUCKETS - 1; b++) {
+		val = 1ULL << (b + HIST_MIN_SHIFT);
+		if (val > guest_halt_poll_ns)
+			break;
+
+		caught += hist->buckets[b];
+		if (100 * (total - caught) * val >
+		    (u64)guest_halt_poll_max_waste * hist->idle_ns)
+			break;
+
+		limit = val;
+		if (100 * caught >= guest_halt_poll_target * total)
+			break;
+	}
+
+	if (limit != dev->poll_limit_ns) {
+		if (limit > dev->poll_limit_ns)
+			trace_guest_halt_poll_ns_grow(limit, dev->poll_limit_ns);
+		else
+			trace_guest_halt_poll_ns_shrink(limit, dev->poll_limit_ns);
+		dev->poll_limit_ns = limit;
+	}
+
+	/* Age the history so that the window follows changing workloads */
+	for (b = 0; b < HIST_BUCKETS; b++)
+		hist->buckets[b] >>= 1;
+	hist->idle_ns >>= 1;
+}
+
+static void hist_reflect(struct cpuidle_device *dev, int index)
+{
+	struct haltpoll_hist *hist = per_cpu_ptr(&haltpoll_hists, dev->cpu);
+	u64 block_ns = hist->poll_ns + dev->last_residency_ns;
+	int b;
+
+	/* A poll that timed out is followed by halt, count both as one wakeup */
+	if (index == 0 && dev->poll_time_limit) {
+		hist->poll_ns = block_ns;
+		return;
+	}
+	hist->poll_ns = 0;
+
+	b = min(fls64(block_ns >> HIST_MIN_SHIFT), HIST_BUCKETS - 1);
+	hist->buckets[b]++;
+	hist->idle_ns += block_ns;
+
+	if (++hist->samples >= HIST_WINDOW) {
+		hist->samples = 0;
+		hist_update_poll_limit(dev, hist);
+	}
+}
+
 /**
  * haltpoll_reflect - update variables and update poll time
  * @dev: the CPU
@@ -121,7 +220,9 @@ static void haltpoll_reflect(struct cpuidle_device *dev, int index)
 {
 	dev->last_state_idx = index;
 
-	if (index != 0)
+	if (guest_halt_poll_target)
+		hist_reflect(dev, index);
+	else if (index != 0)
 		adjust_poll_limit(dev, dev->last_residency_ns);
 }
 
@@ -134,6 +235,8 @@ static int haltpoll_enable_device(struct cpuidle_driver *drv,
 				  struct cpuidle_device *dev)
 {
 	dev->poll_limit_ns = 0;
+	memset(per_cpu_ptr(&haltpoll_hists, dev->cpu), 0,
+	       sizeof(struct haltpoll_hist));
 
 	return 0;
 }
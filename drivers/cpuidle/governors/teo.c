@@ -95,11 +95,24 @@
  * 4. Obtain the sleep length value and check if it is below the target
  *    residency of the current candidate state, in which case a new shallower
  *    candidate state needs to be found, so look for it.
+ *
+ * In addition to that, the part of the "intercepts" metric coming from device
+ * interrupts is tracked separately for each bin.  A wakeup is attributed to a
+ * device interrupt if the CPU's interrupt count has changed between the
+ * wakeup and the next idle state selection, which is an approximation, but a
+ * good one for CPUs that spend most of their time idle.  Timer and IPI
+ * wakeups are not accounted for by this metric (except on architectures where
+ * IPIs are regular interrupts).  If device interrupts have caused at least a
+ * quarter of all recent wakeups, step 2 is repeated using the device
+ * interrupt part of the "intercepts" metric alone, so a CPU handling frequent
+ * device interrupts is kept in shallow idle states even if timer wakeups are
+ * the majority, while a CPU woken up by timers only is not affected.
  */
 
 #include <linux/cpuidle.h>
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
+#include <linux/kernel_stat.h>
 #include <linux/sched/clock.h>
 #include <linux/tick.h>
 
@@ -115,10 +128,12 @@
 /**
  * struct teo_bin - Metrics used by the TEO cpuidle governor.
  * @intercepts: The "intercepts" metric.
+ * @irq_intercepts: The part of @intercepts caused by device interrupts.
  * @hits: The "hits" metric.
  */
 struct teo_bin {
 	unsigned int intercepts;
+	unsigned int irq_intercepts;
 	unsigned int hits;
 };
 
@@ -129,6 +144,7 @@ struct teo_bin {
  * @state_bins: Idle state data bins for this CPU.
  * @total: Grand total of the "intercepts" and "hits" metrics for all bins.
  * @tick_hits: Number of "hits" after TICK_NSEC.
+ * @irq_count: CPU interrupt count at the last wakeup.
  */
 struct teo_cpu {
 	s64 time_span_ns;
@@ -136,6 +152,7 @@ struct teo_cpu {
 	struct teo_bin state_bins[CPUIDLE_STATE_MAX];
 	unsigned int total;
 	unsigned int tick_hits;
+	unsigned long irq_count;
 };
 
 static DEFINE_PER_CPU(struct teo_cpu, teo_cpus);
@@ -194,6 +211,7 @@ static void teo_update(struct cpuidle_driver *drv, struct cpuidle_device *dev)
 
 		bin->hits -= bin->hits >> DECAY_SHIFT;
 		bin->intercepts -= bin->intercepts >> DECAY_SHIFT;
+		bin->irq_intercepts -= bin->irq_intercepts >> DECAY_SHIFT;
 
 		cpu_data->total += bin->hits + bin->intercepts;
 
@@ -232,10 +250,13 @@ static void teo_update(struct cpuidle_driver *drv, struct cpuidle_device *dev)
 	 * Otherwise, update the "intercepts" metric for the bin fallen into by
 	 * the measured idle duration.
 	 */
-	if (idx_timer == idx_duration)
+	if (idx_timer == idx_duration) {
 		cpu_data->state_bins[idx_timer].hits += PULSE;
-	else
+	} else {
 		cpu_data->state_bins[idx_duration].intercepts += PULSE;
+		if (kstat_cpu_irqs_sum(dev->cpu) != cpu_data->irq_count)
+			cpu_data->state_bins[idx_duration].irq_intercepts += PULSE;
+	}
 
 end:
 	cpu_data->total += PULSE;
@@ -273,6 +294,51 @@ static int teo_find_shallower_state(struct cpuidle_driver *drv,
 	return state_idx;
 }
 
+/**
+ * teo_find_irq_state - Find idle state matching device interrupt wakeups.
+ * @drv: cpuidle driver containing state data.
+ * @dev: Target CPU.
+ * @cpu_data: Governor data for the target CPU.
+ * @state_idx: Index of the current candidate idle state.
+ *
+ * Repeat the intercepts check from teo_select() using the device interrupt
+ * part of the "intercepts" metric alone.
+ */
+static int teo_find_irq_state(struct cpuidle_driver *drv,
+			      struct cpuidle_device *dev,
+			      struct teo_cpu *cpu_data, int state_idx)
+{
+	unsigned int irq_total = 0, irq_sum = 0, sum = 0;
+	bool found = false;
+	int i;
+
+	for (i = 0; i < drv->state_count; i++) {
+		irq_total += cpu_data->state_bins[i].irq_intercepts;
+		if (i < state_idx)
+			irq_sum += cpu_data->state_bins[i].irq_intercepts;
+	}
+
+	/*
+	 * Skip this unless device interrupts have caused a significant part of
+	 * recent wakeups and most of them have occurred before the target
+	 * residency of the current candidate state.
+	 */
+	if (4 * irq_total <= cpu_data->total || 2 * irq_sum <= irq_total)
+		return state_idx;
+
+	for (i = state_idx - 1; i >= 0; i--) {
+		sum += cpu_data->state_bins[i].irq_intercepts;
+		if (2 * sum > irq_sum)
+			found = true;
+
+		if (found && !dev->states_usage[i].disable &&
+		    teo_state_ok(i, drv))
+			return i;
+	}
+
+	return state_idx;
+}
+
 /**
  * teo_select - Selects the next idle state to enter.
  * @drv: cpuidle driver containing state data.
@@ -422,6 +488,9 @@ static int teo_select(struct cpuidle_driver *drv, struct cpuidle_device *dev,
 			first_suitable_idx = i;
 		}
 	}
+	if (idx)
+		idx = teo_find_irq_state(drv, dev, cpu_data, idx);
+
 	if (!idx && prev_intercept_idx) {
 		/*
 		 * We have to query the sleep length here otherwise we don't
@@ -523,6 +592,7 @@ static void teo_reflect(struct cpuidle_device *dev, int state)
 	} else {
 		cpu_data->time_span_ns = local_clock() - cpu_data->time_span_ns;
 	}
+	cpu_data->irq_count = kstat_cpu_irqs_sum(dev->cpu);
 }
 
 /**
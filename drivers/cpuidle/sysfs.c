@@ -268,6 +268,7 @@ define_show_state_str_function(name)
 define_show_state_str_function(desc)
 define_show_state_ull_function(above)
 define_show_state_ull_function(below)
+define_show_state_ull_function(predicted)
 
 static ssize_t show_state_time(struct cpuidle_state *state,
 			       struct cpuidle_state_usage *state_usage,
@@ -276,6 +277,26 @@ static ssize_t show_state_time(struct cpuidle_state *state,
 	return sprintf(buf, "%llu\n", ktime_to_us(state_usage->time_ns));
 }
 
+static ssize_t show_state_pred_error(struct cpuidle_state *state,
+				    struct cpuidle_state_usage *state_usage,
+				    char *buf)
+{
+	return sprintf(buf, "%llu\n", ktime_to_us(state_usage->pred_error_ns));
+}
+
+static ssize_t show_state_residency_hist(struct cpuidle_state *state,
+					 struct cpuidle_state_usage *state_usage,
+					 char *buf)
+{
+	int i, len = 0;
+
+	for (i = 0; i < CPUIDLE_RESIDENCY_HIST_BUCKETS; i++)
+		len += sysfs_emit_at(buf, len, "%s%llu", i ? " " : "",
+				     state_usage->residency_hist[i]);
+
+	return len + sysfs_emit_at(buf, len, "\n");
+}
+
 static ssize_t show_state_disable(struct cpuidle_state *state,
 				  struct cpuidle_state_usage *state_usage,
 				  char *buf)
@@ -325,6 +346,9 @@ define_one_state_ro(time, show_state_time);
 define_one_state_rw(disable, show_state_disable, store_state_disable);
 define_one_state_ro(above, show_state_above);
 define_one_state_ro(below, show_state_below);
+define_one_state_ro(predicted, show_state_predicted);
+define_one_state_ro(pred_error, show_state_pred_error);
+define_one_state_ro(residency_hist, show_state_residency_hist);
 define_one_state_ro(default_status, show_state_default_status);
 
 static struct attribute *cpuidle_state_default_attrs[] = {
@@ -339,6 +363,9 @@ static struct attribute *cpuidle_state_default_attrs[] = {
 	&attr_disable.attr,
 	&attr_above.attr,
 	&attr_below.attr,
+	&attr_predicted.attr,
+	&attr_pred_error.attr,
+	&attr_residency_hist.attr,
 	&attr_default_status.attr,
 	NULL
 };
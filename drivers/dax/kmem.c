@@ -23,6 +23,32 @@
  */
 #define MEMTIER_DEFAULT_DAX_ADISTANCE	(MEMTIER_ADISTANCE_DRAM * 5)
 
+static int default_adistance = MEMTIER_DEFAULT_DAX_ADISTANCE;
+
+static int default_adistance_set(const char *val, const struct kernel_param *kp)
+{
+	int rc, adist;
+
+	rc = kstrtoint(val, 0, &adist);
+	if (rc)
+		return rc;
+
+	/* Memory without performance data is never promoted above DRAM. */
+	if (adist < MEMTIER_ADISTANCE_DRAM)
+		return -EINVAL;
+
+	WRITE_ONCE(default_adistance, adist);
+	return 0;
+}
+
+static const struct kernel_param_ops default_adistance_ops = {
+	.set = default_adistance_set,
+	.get = param_get_int,
+};
+module_param_cb(default_adistance, &default_adistance_ops, &default_adistance, 0644);
+MODULE_PARM_DESC(default_adistance,
+		 "Abstract distance of nodes without performance data (default: 5x DRAM)");
+
 /* Memory resource name used for add_memory_driver_managed(). */
 static const char *kmem_name;
 /* Set if any memory will remain added when the driver will be unloaded. */
@@ -74,7 +100,7 @@ static int dev_dax_kmem_probe(struct dev_dax *dev_dax)
 	int i, rc, mapped = 0;
 	mhp_t mhp_flags;
 	int numa_node;
-	int adist = MEMTIER_DEFAULT_DAX_ADISTANCE;
+	int adist = READ_ONCE(default_adistance);
 
 	/*
 	 * Ensure good NUMA information for the persistent memory.
@@ -89,7 +115,15 @@ static int dev_dax_kmem_probe(struct dev_dax *dev_dax)
 		return -EINVAL;
 	}
 
-	mt_calc_adistance(numa_node, &adist);
+	/*
+	 * HMAT (or CXL CDAT via HMAT) provides the performance data, which
+	 * also gets published in the node's access attributes once the
+	 * memory is online. Without it, the node lands in a tier only by
+	 * the default guess, so tell the admin.
+	 */
+	if (mt_calc_adistance(numa_node, &adist) != NOTIFY_STOP)
+		dev_info(dev, "node%d: no performance data, using abstract distance %d\n",
+			 numa_node, adist);
 	mtype = kmem_find_alloc_memory_type(adist);
 	if (IS_ERR(mtype))
 		return PTR_ERR(mtype);
@@ -11,6 +11,7 @@
  */
 
 #include <linux/dma-buf.h>
+#include <linux/dma-map-ops.h>
 #include <linux/dma-mapping.h>
 #include <linux/dma-heap.h>
 #include <linux/err.h>
@@ -18,25 +19,37 @@
 #include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/scatterlist.h>
+#include <linux/shrinker.h>
 #include <linux/slab.h>
+#include <linux/spinlock.h>
 #include <linux/vmalloc.h>
+#include <linux/workqueue.h>
 
 static struct dma_heap *sys_heap;
+static struct dma_heap *sys_uncached_heap;
 
 struct system_heap_buffer {
 	struct dma_heap *heap;
-	struct list_head attachments;
+	struct list_head mappings;
 	struct mutex lock;
 	unsigned long len;
 	struct sg_table sg_table;
 	int vmap_cnt;
 	void *vaddr;
+	bool uncached;
 };
 
-struct dma_heap_attachment {
+/*
+ * The DMA mapping of a buffer for one device. It is shared by all attachments
+ * of that device and stays mapped from the first map until the last of them
+ * is detached, so that mapping the buffer again, e.g. once per frame, only
+ * costs the cache maintenance instead of a new IOMMU mapping.
+ */
+struct system_heap_mapping {
 	struct device *dev;
 	struct sg_table *table;
 	struct list_head list;
+	unsigned int attach_cnt;
 	bool mapped;
 };
 
@@ -54,6 +67,147 @@ static gfp_t order_flags[] = {HIGH_ORDER_GFP, HIGH_ORDER_GFP, LOW_ORDER_GFP};
 static const unsigned int orders[] = {8, 4, 0};
 #define NUM_ORDERS ARRAY_SIZE(orders)
 
+/*
+ * Freed pages are kept in per order pools, up to page_pool_size MiB, instead
+ * of going back to the page allocator. A worker zeroes them in the background,
+ * so that allocations can mostly be served with already cleared pages. The
+ * pools are given back to the system by a shrinker under memory pressure.
+ */
+static unsigned long page_pool_size;
+module_param(page_pool_size, ulong, 0644);
+MODULE_PARM_DESC(page_pool_size, "Max MiB of freed pages to keep for reuse (0 = disabled)");
+
+struct system_heap_pool {
+	spinlock_t lock;
+	struct list_head zeroed;
+	struct list_head dirty;
+};
+
+static struct system_heap_pool pools[NUM_ORDERS];
+static atomic_long_t pool_pages = ATOMIC_LONG_INIT(0);
+static struct shrinker *pool_shrinker;
+
+static void pool_zero_work_fn(struct work_struct *work);
+static DECLARE_WORK(pool_zero_work, pool_zero_work_fn);
+
+static struct system_heap_pool *pool_for_order(unsigned int order)
+{
+	int i;
+
+	for (i = 0; i < NUM_ORDERS; i++)
+		if (orders[i] == order)
+			return &pools[i];
+	return NULL;
+}
+
+static void clear_pool_page(struct page *page)
+{
+	unsigned int i;
+
+	for (i = 0; i < (1U << compound_order(page)); i++) {
+		clear_highpage(page + i);
+		cond_resched();
+	}
+}
+
+static struct page *pool_get_page(struct system_heap_pool *pool, bool *zeroed)
+{
+	struct page *page;
+
+	spin_lock(&pool->lock);
+	page = list_first_entry_or_null(&pool->zeroed, struct page, lru);
+	*zeroed = page;
+	if (!page)
+		page = list_first_entry_or_null(&pool->dirty, struct page, lru);
+	if (page)
+		list_del(&page->lru);
+	spin_unlock(&pool->lock);
+
+	if (page)
+		atomic_long_sub(1 << compound_order(page), &pool_pages);
+	return page;
+}
+
+static void system_heap_free_page(struct page *page)
+{
+	unsigned int order = compound_order(page);
+	unsigned long max = READ_ONCE(page_pool_size) << (20 - PAGE_SHIFT);
+	struct system_heap_pool *pool = pool_for_order(order);
+
+	if (!pool_shrinker || !pool)
+		goto free;
+
+	if (atomic_long_add_return(1 << order, &pool_pages) > max) {
+		atomic_long_sub(1 << order, &pool_pages);
+		goto free;
+	}
+
+	spin_lock(&pool->lock);
+	list_add_tail(&page->lru, &pool->dirty);
+	spin_unlock(&pool->lock);
+
+	queue_work(system_unbound_wq, &pool_zero_work);
+	return;
+
+free:
+	__free_pages(page, order);
+}
+
+static void pool_zero_work_fn(struct work_struct *work)
+{
+	struct page *page;
+	int i;
+
+	for (i = 0; i < NUM_ORDERS; i++) {
+		struct system_heap_pool *pool = &pools[i];
+
+		for (;;) {
+			spin_lock(&pool->lock);
+			page = list_first_entry_or_null(&pool->dirty,
+							struct page, lru);
+			if (page)
+				list_del(&page->lru);
+			spin_unlock(&pool->lock);
+			if (!page)
+				break;
+
+			clear_pool_page(page);
+
+			spin_lock(&pool->lock);
+			list_add_tail(&page->lru, &pool->zeroed);
+			spin_unlock(&pool->lock);
+		}
+	}
+}
+
+static unsigned long pool_shrink_count(struct shrinker *shrink,
+				       struct shrink_control *sc)
+{
+	unsigned long count = atomic_long_read(&pool_pages);
+
+	return count ?: SHRINK_EMPTY;
+}
+
+static unsigned long pool_shrink_scan(struct shrinker *shrink,
+				      struct shrink_control *sc)
+{
+	unsigned long freed = 0;
+	struct page *page;
+	bool zeroed;
+	int i;
+
+	/* Start with the low orders, which are the cheapest to get back */
+	for (i = NUM_ORDERS - 1; i >= 0 && freed < sc->nr_to_scan; i--) {
+		while (freed < sc->nr_to_scan &&
+		       (page = pool_get_page(&pools[i], &zeroed))) {
+			freed += 1 << compound_order(page);
+			__free_pages(page, compound_order(page));
+		}
+	}
+
+	return freed ?: SHRINK_STOP;
+}
+
 static struct sg_table *dup_sg_table(struct sg_table *table)
 {
 	struct sg_table *new_table;
@@ -83,88 +237,123 @@ static int system_heap_attach(struct dma_buf *dmabuf,
 			      struct dma_buf_attachment *attachment)
 {
 	struct system_heap_buffer *buffer = dmabuf->priv;
-	struct dma_heap_attachment *a;
+	struct system_heap_mapping *m;
 	struct sg_table *table;
+	int ret = 0;
 
-	a = kzalloc(sizeof(*a), GFP_KERNEL);
-	if (!a)
-		return -ENOMEM;
+	mutex_lock(&buffer->lock);
+	list_for_each_entry(m, &buffer->mappings, list) {
+		if (m->dev == attachment->dev)
+			goto out;
+	}
+
+	m = kzalloc(sizeof(*m), GFP_KERNEL);
+	if (!m) {
+		ret = -ENOMEM;
+		goto unlock;
+	}
 
 	table = dup_sg_table(&buffer->sg_table);
 	if (IS_ERR(table)) {
-		kfree(a);
-		return -ENOMEM;
+		kfree(m);
+		ret = -ENOMEM;
+		goto unlock;
 	}
 
-	a->table = table;
-	a->dev = attachment->dev;
-	INIT_LIST_HEAD(&a->list);
-	a->mapped = false;
-
-	attachment->priv = a;
-
-	mutex_lock(&buffer->lock);
-	list_add(&a->list, &buffer->attachments);
+	m->table = table;
+	m->dev = attachment->dev;
+	list_add(&m->list, &buffer->mappings);
+out:
+	m->attach_cnt++;
+	attachment->priv = m;
+unlock:
 	mutex_unlock(&buffer->lock);
 
-	return 0;
+	return ret;
+}
+
+static unsigned long system_heap_dma_attrs(struct system_heap_buffer *buffer)
+{
+	return buffer->uncached ? DMA_ATTR_SKIP_CPU_SYNC : 0;
 }
 
 static void system_heap_detach(struct dma_buf *dmabuf,
 			       struct dma_buf_attachment *attachment)
 {
 	struct system_heap_buffer *buffer = dmabuf->priv;
-	struct dma_heap_attachment *a = attachment->priv;
+	struct system_heap_mapping *m = attachment->priv;
 
 	mutex_lock(&buffer->lock);
-	list_del(&a->list);
+	if (--m->attach_cnt) {
+		mutex_unlock(&buffer->lock);
+		return;
+	}
+	list_del(&m->list);
 	mutex_unlock(&buffer->lock);
 
-	sg_free_table(a->table);
-	kfree(a->table);
-	kfree(a);
+	if (m->mapped)
+		dma_unmap_sgtable(m->dev, m->table, DMA_BIDIRECTIONAL,
+				  system_heap_dma_attrs(buffer));
+	sg_free_table(m->table);
+	kfree(m->table);
+	kfree(m);
 }
 
 static struct sg_table *system_heap_map_dma_buf(struct dma_buf_attachment *attachment,
 						enum dma_data_direction direction)
 {
-	struct dma_heap_attachment *a = attachment->priv;
-	struct sg_table *table = a->table;
-	int ret;
+	struct system_heap_buffer *buffer = attachment->dmabuf->priv;
+	struct system_heap_mapping *m = attachment->priv;
+	int ret = 0;
 
-	ret = dma_map_sgtable(attachment->dev, table, direction, 0);
-	if (ret)
-		return ERR_PTR(ret);
+	mutex_lock(&buffer->lock);
+	if (m->mapped) {
+		/* What dma_map_sgtable() would do besides the mapping */
+		if (!buffer->uncached)
+			dma_sync_sgtable_for_device(m->dev, m->table, direction);
+	} else {
+		/* Mapped for both directions, as later users may differ */
+		ret = dma_map_sgtable(m->dev, m->table, DMA_BIDIRECTIONAL,
+				      system_heap_dma_attrs(buffer));
+		if (!ret)
+			m->mapped = true;
+	}
+	mutex_unlock(&buffer->lock);
 
-	a->mapped = true;
-	return table;
+	return ret ? ERR_PTR(ret) : m->table;
 }
 
 static void system_heap_unmap_dma_buf(struct dma_buf_attachment *attachment,
 				      struct sg_table *table,
 				      enum dma_data_direction direction)
 {
-	struct dma_heap_attachment *a = attachment->priv;
+	struct system_heap_buffer *buffer = attachment->dmabuf->priv;
+	struct system_heap_mapping *m = attachment->priv;
 
-	a->mapped = false;
-	dma_unmap_sgtable(attachment->dev, table, direction, 0);
+	/* Keep the mapping for the next map, see struct system_heap_mapping */
+	if (!buffer->uncached)
+		dma_sync_sgtable_for_cpu(m->dev, table, direction);
 }
 
 static int system_heap_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
 						enum dma_data_direction direction)
 {
 	struct system_heap_buffer *buffer = dmabuf->priv;
-	struct dma_heap_attachment *a;
+	struct system_heap_mapping *m;
+
+	/* CPU access to uncached buffers needs no cache maintenance */
+	if (buffer->uncached)
+		return 0;
 
 	mutex_lock(&buffer->lock);
 
 	if (buffer->vmap_cnt)
 		invalidate_kernel_vmap_range(buffer->vaddr, buffer->len);
 
-	list_for_each_entry(a, &buffer->attachments, list) {
-		if (!a->mapped)
+	list_for_each_entry(m, &buffer->mappings, list) {
+		if (!m->mapped)
 			continue;
-		dma_sync_sgtable_for_cpu(a->dev, a->table, direction);
+		dma_sync_sgtable_for_cpu(m->dev, m->table, direction);
 	}
 	mutex_unlock(&buffer->lock);
 
@@ -175,17 +364,20 @@ static int system_heap_dma_buf_end_cpu_access(struct dma_buf *dmabuf,
 					      enum dma_data_direction direction)
 {
 	struct system_heap_buffer *buffer = dmabuf->priv;
-	struct dma_heap_attachment *a;
+	struct system_heap_mapping *m;
+
+	if (buffer->uncached)
+		return 0;
 
 	mutex_lock(&buffer->lock);
 
 	if (buffer->vmap_cnt)
 		flush_kernel_vmap_range(buffer->vaddr, buffer->len);
 
-	list_for_each_entry(a, &buffer->attachments, list) {
-		if (!a->mapped)
+	list_for_each_entry(m, &buffer->mappings, list) {
+		if (!m->mapped)
 			continue;
-		dma_sync_sgtable_for_device(a->dev, a->table, direction);
+		dma_sync_sgtable_for_device(m->dev, m->table, direction);
 	}
 	mutex_unlock(&buffer->lock);
 
@@ -200,6 +392,9 @@ static int system_heap_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma)
 	struct sg_page_iter piter;
 	int ret;
 
+	if (buffer->uncached)
+		vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+
 	for_each_sgtable_page(table, &piter, vma->vm_pgoff) {
 		struct page *page = sg_page_iter_page(&piter);
 
@@ -221,6 +416,7 @@ static void *system_heap_do_vmap(struct system_heap_buffer *buffer)
 	struct page **pages = vmalloc(sizeof(struct page *) * npages);
 	struct page **tmp = pages;
 	struct sg_page_iter piter;
+	pgprot_t pgprot = PAGE_KERNEL;
 	void *vaddr;
 
 	if (!pages)
@@ -231,7 +427,10 @@ static void *system_heap_do_vmap(struct system_heap_buffer *buffer)
 		*tmp++ = sg_page_iter_page(&piter);
 	}
 
-	vaddr = vmap(pages, npages, VM_MAP, PAGE_KERNEL);
+	if (buffer->uncached)
+		pgprot = pgprot_writecombine(PAGE_KERNEL);
+
+	vaddr = vmap(pages, npages, VM_MAP, pgprot);
 	vfree(pages);
 
 	if (!vaddr)
@@ -289,11 +488,8 @@ static void system_heap_dma_buf_release(struct dma_buf *dmabuf)
 	int i;
 
 	table = &buffer->sg_table;
-	for_each_sgtable_sg(table, sg, i) {
-		struct page *page = sg_page(sg);
-
-		__free_pages(page, compound_order(page));
-	}
+	for_each_sgtable_sg(table, sg, i)
+		system_heap_free_page(sg_page(sg));
 	sg_free_table(table);
 	kfree(buffer);
 }
@@ -315,6 +511,7 @@ static struct page *alloc_largest_available(unsigned long size,
 					    unsigned int max_order)
 {
 	struct page *page;
+	bool zeroed;
 	int i;
 
 	for (i = 0; i < NUM_ORDERS; i++) {
@@ -323,6 +520,14 @@ static struct page *alloc_largest_available(unsigned long size,
 		if (max_order < orders[i])
 			continue;
 
+		page = pool_get_page(&pools[i], &zeroed);
+		if (page) {
+			/* Not yet reached by the worker, clear it now */
+			if (!zeroed)
+				clear_pool_page(page);
+			return page;
+		}
+
 		page = alloc_pages(order_flags[i], orders[i]);
 		if (!page)
 			continue;
@@ -331,10 +536,11 @@ static struct page *alloc_largest_available(unsigned long size,
 	return NULL;
 }
 
-static struct dma_buf *system_heap_allocate(struct dma_heap *heap,
-					    unsigned long len,
-					    u32 fd_flags,
-					    u64 heap_flags)
+static struct dma_buf *system_heap_do_allocate(struct dma_heap *heap,
+					       unsigned long len,
+					       u32 fd_flags,
+					       u64 heap_flags,
+					       bool uncached)
 {
 	struct system_heap_buffer *buffer;
 	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
@@ -351,10 +557,11 @@ static struct dma_buf *system_heap_allocate(struct dma_heap *heap,
 	if (!buffer)
 		return ERR_PTR(-ENOMEM);
 
-	INIT_LIST_HEAD(&buffer->attachments);
+	INIT_LIST_HEAD(&buffer->mappings);
 	mutex_init(&buffer->lock);
 	buffer->heap = heap;
 	buffer->len = len;
+	buffer->uncached = uncached;
 
 	INIT_LIST_HEAD(&pages);
 	i = 0;
@@ -389,6 +596,15 @@ static struct dma_buf *system_heap_allocate(struct dma_heap *heap,
 		list_del(&page->lru);
 	}
 
+	/*
+	 * Write back and invalidate the cache lines left by zeroing, they
+	 * must not be evicted over data written through uncached mappings.
+	 */
+	if (uncached) {
+		for_each_sgtable_sg(table, sg, i)
+			arch_dma_prep_coherent(sg_page(sg), sg->length);
+	}
+
 	/* create the dmabuf */
 	exp_info.exp_name = dma_heap_get_name(heap);
 	exp_info.ops = &system_heap_buf_ops;
@@ -417,13 +633,52 @@ static struct dma_buf *system_heap_allocate(struct dma_heap *heap,
 	return ERR_PTR(ret);
 }
 
+static struct dma_buf *system_heap_allocate(struct dma_heap *heap,
+					    unsigned long len,
+					    u32 fd_flags,
+					    u64 heap_flags)
+{
+	return system_heap_do_allocate(heap, len, fd_flags, heap_flags, false);
+}
+
+static struct dma_buf *system_uncached_heap_allocate(struct dma_heap *heap,
+						     unsigned long len,
+						     u32 fd_flags,
+						     u64 heap_flags)
+{
+	return system_heap_do_allocate(heap, len, fd_flags, heap_flags, true);
+}
+
 static const struct dma_heap_ops system_heap_ops = {
 	.allocate = system_heap_allocate,
 };
 
+static const struct dma_heap_ops system_uncached_heap_ops = {
+	.allocate = system_uncached_heap_allocate,
+};
+
 static int __init system_heap_create(void)
 {
 	struct dma_heap_export_info exp_info;
+	struct shrinker *shrinker;
+	int i;
+
+	for (i = 0; i < NUM_ORDERS; i++) {
+		spin_lock_init(&pools[i].lock);
+		INIT_LIST_HEAD(&pools[i].zeroed);
+		INIT_LIST_HEAD(&pools[i].dirty);
+	}
+
+	shrinker = shrinker_alloc(0, "dmabuf-system-heap-pool");
+	if (shrinker) {
+		shrinker->count_objects = pool_shrink_count;
+		shrinker->scan_objects = pool_shrink_scan;
+		shrinker_register(shrinker);
+		pool_shrinker = shrinker;
+	} else {
+		/* Not fatal, freed pages just go back to the system */
+		pr_warn("system_heap: failed to allocate pool shrinker\n");
+	}
 
 	exp_info.name = "system";
 	exp_info.ops = &system_heap_ops;
@@ -433,6 +688,21 @@ static int __init system_heap_create(void)
 	if (IS_ERR(sys_heap))
 		return PTR_ERR(sys_heap);
 
+	/*
+	 * Uncached buffers need their cache lines flushed once at allocation,
+	 * which only architectures with arch_dma_prep_coherent() can do.
+	 */
+	if (!IS_ENABLED(CONFIG_ARCH_HAS_DMA_PREP_COHERENT))
+		return 0;
+
+	exp_info.name = "system-uncached";
+	exp_info.ops = &system_uncached_heap_ops;
+	exp_info.priv = NULL;
+
+	sys_uncached_heap = dma_heap_add(&exp_info);
+	if (IS_ERR(sys_uncached_heap))
+		return PTR_ERR(sys_uncached_heap);
+
 	return 0;
 }
 module_init(system_heap_create);
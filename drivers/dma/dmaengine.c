@@ -60,6 +60,32 @@ static DEFINE_IDA(dma_ida);
 static LIST_HEAD(dma_device_list);
 static long dmaengine_ref_count;
 
+/*
+ * Number of submitted but not yet completed descriptors above which
+ * dma_find_channel() looks for a less loaded channel.
+ */
+#define DMA_CHAN_BUSY_DEPTH	64
+
+/**
+ * dma_chan_inflight - number of descriptors submitted but not completed
+ * @chan:	DMA channel to test
+ *
+ * Derived from the cookie counters, so it is only meaningful for drivers
+ * that retire descriptors with dma_cookie_complete(). The result is racy and
+ * must only be used as a hint.
+ */
+static u32 dma_chan_inflight(struct dma_chan *chan)
+{
+	dma_cookie_t issued = READ_ONCE(chan->cookie);
+	dma_cookie_t done = READ_ONCE(chan->completed_cookie);
+
+	if (issued >= done)
+		return issued - done;
+
+	/* dma_cookie_assign() wrapped from INT_MAX back to DMA_MIN_COOKIE */
+	return (INT_MAX - done) + (issued - DMA_MIN_COOKIE + 1);
+}
+
 /* --- debugfs implementation --- */
 #ifdef CONFIG_DEBUG_FS
 #include <linux/debugfs.h>
@@ -123,6 +149,31 @@ static int dmaengine_summary_show(struct seq_file *s, void *data)
 }
 DEFINE_SHOW_ATTRIBUTE(dmaengine_summary);
 
+static int dmaengine_inflight_show(struct seq_file *s, void *data)
+{
+	struct dma_device *dma_dev;
+	struct dma_chan *chan;
+
+	mutex_lock(&dma_list_mutex);
+	list_for_each_entry(dma_dev, &dma_device_list, global_node) {
+		if (dma_has_cap(DMA_PRIVATE, dma_dev->cap_mask))
+			continue;
+
+		list_for_each_entry(chan, &dma_dev->channels, device_node) {
+			if (!chan->client_count)
+				continue;
+
+			seq_printf(s, "%-13s node %d cpus %d inflight %u\n",
+				   dma_chan_name(chan), dev_to_node(dma_dev->dev),
+				   chan->table_count, dma_chan_inflight(chan));
+		}
+	}
+	mutex_unlock(&dma_list_mutex);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(dmaengine_inflight);
+
 static void __init dmaengine_debugfs_init(void)
 {
 	rootdir = debugfs_create_dir("dmaengine", NULL);
@@ -130,6 +181,10 @@ static void __init dmaengine_debugfs_init(void)
 	/* /sys/kernel/debug/dmaengine/summary */
 	debugfs_create_file("summary", 0444, rootdir, NULL,
 			    &dmaengine_summary_fops);
+
+	/* /sys/kernel/debug/dmaengine/inflight */
+	debugfs_create_file("inflight", 0444, rootdir, NULL,
+			    &dmaengine_inflight_fops);
 }
 #else
 static inline void dmaengine_debugfs_init(void) { }
@@ -538,13 +593,71 @@ enum dma_status dma_sync_wait(struct dma_chan *chan, dma_cookie_t cookie)
 }
 EXPORT_SYMBOL(dma_sync_wait);
 
+/**
+ * dma_find_spill_channel - find a less loaded channel than @busy
+ * @tx_type:	transaction type
+ * @busy:	channel from the allocation table that is saturated
+ *
+ * Prefer the least loaded unsaturated channel in the NUMA-node of the
+ * current CPU and only spill to a remote channel if all local ones are
+ * saturated as well. Returns @busy if no better channel is found.
+ */
+static struct dma_chan *dma_find_spill_channel(enum dma_transaction_type tx_type,
+					       struct dma_chan *busy)
+{
+	struct dma_chan *local = NULL, *remote = NULL;
+	u32 local_depth = DMA_CHAN_BUSY_DEPTH;
+	u32 remote_depth = DMA_CHAN_BUSY_DEPTH;
+	int cpu = raw_smp_processor_id();
+	struct dma_device *device;
+	struct dma_chan *chan;
+	u32 depth;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(device, &dma_device_list, global_node) {
+		if (!dma_has_cap(tx_type, device->cap_mask) ||
+		    dma_has_cap(DMA_PRIVATE, device->cap_mask))
+			continue;
+		list_for_each_entry(chan, &device->channels, device_node) {
+			if (!chan->client_count)
+				continue;
+
+			depth = dma_chan_inflight(chan);
+			if (dma_chan_is_local(chan, cpu)) {
+				if (depth < local_depth) {
+					local = chan;
+					local_depth = depth;
+				}
+			} else if (depth < remote_depth) {
+				remote = chan;
+				remote_depth = depth;
+			}
+		}
+	}
+	rcu_read_unlock();
+
+	if (local)
+		return local;
+
+	return remote ?: busy;
+}
+
 /**
  * dma_find_channel - find a channel to carry out the operation
  * @tx_type:	transaction type
+ *
+ * Returns the channel assigned to the current CPU by the allocation table,
+ * unless that channel has more than %DMA_CHAN_BUSY_DEPTH descriptors in
+ * flight, in which case a less loaded channel is picked, local ones first.
  */
 struct dma_chan *dma_find_channel(enum dma_transaction_type tx_type)
 {
-	return this_cpu_read(channel_table[tx_type]->chan);
+	struct dma_chan *chan = this_cpu_read(channel_table[tx_type]->chan);
+
+	if (chan && unlikely(dma_chan_inflight(chan) >= DMA_CHAN_BUSY_DEPTH))
+		chan = dma_find_spill_channel(tx_type, chan);
+
+	return chan;
 }
 EXPORT_SYMBOL(dma_find_channel);
 
@@ -92,6 +92,10 @@ static bool polled;
 module_param(polled, bool, 0644);
 MODULE_PARM_DESC(polled, "Use polling for completion instead of interrupts");
 
+static bool latency;
+module_param(latency, bool, 0644);
+MODULE_PARM_DESC(latency, "Record per-transfer completion latency and report percentiles (default: off)");
+
 /**
  * struct dmatest_params - test parameters.
  * @nobounce:		prevent using swiotlb buffer
@@ -109,6 +113,7 @@ MODULE_PARM_DESC(polled, "Use polling for completion instead of interrupts");
  * @alignment:		custom data address alignment taken as 2^alignment
  * @transfer_size:	custom transfer size in bytes
  * @polled:		use polling for completion instead of interrupts
+ * @latency:		record per-transfer completion latency
  */
 struct dmatest_params {
 	bool		nobounce;
@@ -126,6 +131,7 @@ struct dmatest_params {
 	int		alignment;
 	unsigned int	transfer_size;
 	bool		polled;
+	bool		latency;
 };
 
 /**
@@ -215,9 +221,27 @@ MODULE_PARM_DESC(test_list, "Print current test list");
 /* poor man's completion - we want to use wait_event_freezable() on it */
 struct dmatest_done {
 	bool			done;
+	ktime_t			end;
 	wait_queue_head_t	*wait;
 };
 
+/*
+ * Completion latency histogram: log2 buckets of nanoseconds, each split into
+ * 2^LAT_SUB_BITS linear sub-buckets, which bounds the error of a reported
+ * percentile to 1/2^LAT_SUB_BITS of its value.
+ */
+#define LAT_SUB_BITS		3
+#define LAT_SUB_COUNT		(1 << LAT_SUB_BITS)
+#define LAT_BUCKETS		((64 - LAT_SUB_BITS + 1) * LAT_SUB_COUNT)
+
+struct dmatest_lat {
+	u64			count;
+	u64			min;
+	u64			max;
+	u64			sum;
+	u32			buckets[LAT_BUCKETS];
+};
+
 struct dmatest_data {
 	u8		**raw;
 	u8		**aligned;
@@ -437,6 +461,7 @@ static void dmatest_callback(void *arg)
 	struct dmatest_thread *thread =
 		container_of(done, struct dmatest_thread, test_done);
 	if (!thread->done) {
+		done->end = ktime_get();
 		done->done = true;
 		wake_up_all(done->wait);
 	} else {
@@ -510,6 +535,70 @@ static unsigned long long dmatest_KBs(s64 runtime, unsigned long long len)
 	return FIXPT_TO_INT(dmatest_persec(runtime, len >> 10));
 }
 
+static unsigned int dmatest_lat_bucket(u64 ns)
+{
+	unsigned int shift;
+
+	if (ns < LAT_SUB_COUNT)
+		return ns;
+
+	shift = fls64(ns) - 1 - LAT_SUB_BITS;
+	return ((shift + 1) << LAT_SUB_BITS) | ((ns >> shift) & (LAT_SUB_COUNT - 1));
+}
+
+/* Upper bound of the latencies accounted in @bucket */
+static u64 dmatest_lat_bucket_max(unsigned int bucket)
+{
+	unsigned int shift = bucket >> LAT_SUB_BITS;
+	u64 sub = bucket & (LAT_SUB_COUNT - 1);
+
+	if (!shift)
+		return sub;
+
+	shift--;
+	return (((LAT_SUB_COUNT | sub) + 1) << shift) - 1;
+}
+
+static void dmatest_lat_add(struct dmatest_lat *lat, ktime_t start, ktime_t end)
+{
+	u64 ns = ktime_to_ns(ktime_sub(end, start));
+
+	if (!lat->count || ns < lat->min)
+		lat->min = ns;
+	if (ns > lat->max)
+		lat->max = ns;
+	lat->sum += ns;
+	lat->count++;
+	lat->buckets[dmatest_lat_bucket(ns)]++;
+}
+
+/* Latency in ns at or below which @permille of the transfers completed */
+static u64 dmatest_lat_percentile(struct dmatest_lat *lat, unsigned int permille)
+{
+	u64 target = div_u64(lat->count * permille + 999, 1000);
+	u64 seen = 0;
+	unsigned int i;
+
+	for (i = 0; i < LAT_BUCKETS; i++) {
+		seen += lat->buckets[i];
+		if (seen >= target)
+			return min(dmatest_lat_bucket_max(i), lat->max);
+	}
+
+	return lat->max;
+}
+
+static void dmatest_lat_report(struct dmatest_lat *lat)
+{
+	if (!lat->count)
+		return;
+
+	pr_info("%s: latency_ns count=%llu min=%llu avg=%llu p50=%llu p99=%llu p999=%llu max=%llu\n",
+		current->comm, lat->count, lat->min, div64_u64(lat->sum, lat->count),
+		dmatest_lat_percentile(lat, 500), dmatest_lat_percentile(lat, 990),
+		dmatest_lat_percentile(lat, 999), lat->max);
+}
+
 static void __dmatest_free_test_data(struct dmatest_data *d, unsigned int cnt)
 {
 	unsigned int i;
@@ -602,6 +691,8 @@ static int dmatest_func(void *data)
 	bool			is_memset = false;
 	dma_addr_t		*srcs;
 	dma_addr_t		*dma_pq;
+	struct dmatest_lat	*lat = NULL;
+	ktime_t			submit_time;
 
 	set_freezable();
 
@@ -685,6 +776,12 @@ static int dmatest_func(void *data)
 	if (!dma_pq)
 		goto err_srcs_array;
 
+	if (params->latency) {
+		lat = kvzalloc(sizeof(*lat), GFP_KERNEL);
+		if (!lat)
+			goto err_pq_array;
+	}
+
 	/*
 	 * src and dst buffers are freed by ourselves below
 	 */
@@ -824,6 +921,7 @@ static int dmatest_func(void *data)
 			tx->callback = dmatest_callback;
 			tx->callback_param = done;
 		}
+		submit_time = ktime_get();
 		cookie = tx->tx_submit(tx);
 
 		if (dma_submit_error(cookie)) {
@@ -835,6 +933,7 @@ static int dmatest_func(void *data)
 
 		if (params->polled) {
 			status = dma_sync_wait(chan, cookie);
+			done->end = ktime_get();
 			dmaengine_terminate_sync(chan);
 			if (status == DMA_COMPLETE)
 				done->done = true;
@@ -866,6 +965,9 @@ static int dmatest_func(void *data)
 
 		dmaengine_unmap_put(um);
 
+		if (lat)
+			dmatest_lat_add(lat, submit_time, done->end);
+
 		if (params->noverify) {
 			verbose_result("test passed", total_tests, src->off,
 				       dst->off, len, 0);
@@ -919,6 +1021,11 @@ static int dmatest_func(void *data)
 	runtime = ktime_to_us(ktime);
 
 	ret = 0;
+	if (lat) {
+		dmatest_lat_report(lat);
+		kvfree(lat);
+	}
+err_pq_array:
 	kfree(dma_pq);
 err_srcs_array:
 	kfree(srcs);
@@ -1122,6 +1229,7 @@ static void add_threaded_test(struct dmatest_info *info)
 	params->alignment = alignment;
 	params->transfer_size = transfer_size;
 	params->polled = polled;
+	params->latency = latency;
 
 	request_channels(info, DMA_MEMCPY);
 	request_channels(info, DMA_MEMSET);
@@ -22,6 +22,13 @@
 #include "../dmaengine.h"
 #include "../virt-dma.h"
 
+/*
+ * Transfers needing at most this many bursts get all of them from a single
+ * allocation made with the descriptor; larger ones allocate them one by one
+ * so a GFP_NOWAIT prep doesn't depend on a large contiguous allocation.
+ */
+#define DW_EDMA_BURST_POOL_MAX	256
+
 static inline
 struct device *dchan2dev(struct dma_chan *dchan)
 {
@@ -51,13 +58,20 @@ u64 dw_edma_get_pci_address(struct dw_edma_chan *chan, phys_addr_t cpu_addr)
 	return cpu_addr;
 }
 
-static struct dw_edma_burst *dw_edma_alloc_burst(struct dw_edma_chunk *chunk)
+static struct dw_edma_burst *dw_edma_alloc_burst(struct dw_edma_desc *desc,
+						 struct dw_edma_chunk *chunk)
 {
 	struct dw_edma_burst *burst;
 
-	burst = kzalloc(sizeof(*burst), GFP_NOWAIT);
-	if (unlikely(!burst))
-		return NULL;
+	if (desc->burst_pool) {
+		if (unlikely(desc->burst_pool_used == desc->burst_pool_sz))
+			return NULL;
+		burst = &desc->burst_pool[desc->burst_pool_used++];
+	} else {
+		burst = kzalloc(sizeof(*burst), GFP_NOWAIT);
+		if (unlikely(!burst))
+			return NULL;
+	}
 
 	INIT_LIST_HEAD(&burst->list);
 	if (chunk->burst) {
@@ -102,7 +116,7 @@ static struct dw_edma_chunk *dw_edma_alloc_chunk(struct dw_edma_desc *desc)
 
 	if (desc->chunk) {
 		/* Create and add new element into the linked list */
-		if (!dw_edma_alloc_burst(chunk)) {
+		if (!dw_edma_alloc_burst(desc, chunk)) {
 			kfree(chunk);
 			return NULL;
 		}
@@ -118,16 +132,29 @@ static struct dw_edma_chunk *dw_edma_alloc_chunk(struct dw_edma_desc *desc)
 	return chunk;
 }
 
-static struct dw_edma_desc *dw_edma_alloc_desc(struct dw_edma_chan *chan)
+static struct dw_edma_desc *dw_edma_alloc_desc(struct dw_edma_chan *chan,
+					       u32 cnt)
 {
 	struct dw_edma_desc *desc;
+	u32 nr_bursts;
 
 	desc = kzalloc(sizeof(*desc), GFP_NOWAIT);
 	if (unlikely(!desc))
 		return NULL;
 
 	desc->chan = chan;
+
+	/* One burst per element plus the list head of each chunk */
+	nr_bursts = cnt + DIV_ROUND_UP(cnt, max(chan->ll_max, 1U));
+	if (nr_bursts <= DW_EDMA_BURST_POOL_MAX) {
+		desc->burst_pool = kcalloc(nr_bursts, sizeof(*desc->burst_pool),
+					   GFP_NOWAIT);
+		if (desc->burst_pool)
+			desc->burst_pool_sz = nr_bursts;
+	}
+
 	if (!dw_edma_alloc_chunk(desc)) {
+		kfree(desc->burst_pool);
 		kfree(desc);
 		return NULL;
 	}
@@ -135,10 +162,18 @@ static struct dw_edma_desc *dw_edma_alloc_desc(struct dw_edma_chan *chan)
 	return desc;
 }
 
-static void dw_edma_free_burst(struct dw_edma_chunk *chunk)
+static void dw_edma_free_burst(struct dw_edma_desc *desc,
+			       struct dw_edma_chunk *chunk)
 {
 	struct dw_edma_burst *child, *_next;
 
+	/* Pooled bursts are released together with the descriptor */
+	if (desc->burst_pool) {
+		chunk->bursts_alloc = 0;
+		chunk->burst = NULL;
+		return;
+	}
+
 	/* Remove all the list elements */
 	list_for_each_entry_safe(child, _next, &chunk->burst->list, list) {
 		list_del(&child->list);
@@ -160,7 +195,7 @@ static void dw_edma_free_chunk(struct dw_edma_desc *desc)
 
 	/* Remove all the list elements */
 	list_for_each_entry_safe(child, _next, &desc->chunk->list, list) {
-		dw_edma_free_burst(child);
+		dw_edma_free_burst(desc, child);
 		list_del(&child->list);
 		kfree(child);
 		desc->chunks_alloc--;
@@ -174,6 +209,7 @@ static void dw_edma_free_chunk(struct dw_edma_desc *desc)
 static void dw_edma_free_desc(struct dw_edma_desc *desc)
 {
 	dw_edma_free_chunk(desc);
+	kfree(desc->burst_pool);
 	kfree(desc);
 }
 
@@ -204,7 +240,7 @@ static int dw_edma_start_transfer(struct dw_edma_chan *chan)
 
 	dw_edma_core_start(dw, child, !desc->xfer_sz);
 	desc->xfer_sz += child->ll_region.sz;
-	dw_edma_free_burst(child);
+	dw_edma_free_burst(desc, child);
 	list_del(&child->list);
 	kfree(child);
 	desc->chunks_alloc--;
@@ -426,7 +462,17 @@ dw_edma_device_transfer(struct dw_edma_transfer *xfer)
 		return NULL;
 	}
 
-	desc = dw_edma_alloc_desc(chan);
+	if (xfer->type == EDMA_XFER_CYCLIC) {
+		cnt = xfer->xfer.cyclic.cnt;
+	} else if (xfer->type == EDMA_XFER_SCATTER_GATHER) {
+		cnt = xfer->xfer.sg.len;
+		sg = xfer->xfer.sg.sgl;
+	} else if (xfer->type == EDMA_XFER_INTERLEAVED) {
+		cnt = xfer->xfer.il->numf * xfer->xfer.il->frame_size;
+		fsz = xfer->xfer.il->frame_size;
+	}
+
+	desc = dw_edma_alloc_desc(chan, cnt);
 	if (unlikely(!desc))
 		goto err_alloc;
 
@@ -447,16 +493,6 @@ dw_edma_device_transfer(struct dw_edma_transfer *xfer)
 	else
 		dst_addr = dw_edma_get_pci_address(chan, (phys_addr_t)dst_addr);
 
-	if (xfer->type == EDMA_XFER_CYCLIC) {
-		cnt = xfer->xfer.cyclic.cnt;
-	} else if (xfer->type == EDMA_XFER_SCATTER_GATHER) {
-		cnt = xfer->xfer.sg.len;
-		sg = xfer->xfer.sg.sgl;
-	} else if (xfer->type == EDMA_XFER_INTERLEAVED) {
-		cnt = xfer->xfer.il->numf * xfer->xfer.il->frame_size;
-		fsz = xfer->xfer.il->frame_size;
-	}
-
 	for (i = 0; i < cnt; i++) {
 		if (xfer->type == EDMA_XFER_SCATTER_GATHER && !sg)
 			break;
@@ -467,7 +503,7 @@ dw_edma_device_transfer(struct dw_edma_transfer *xfer)
 				goto err_alloc;
 		}
 
-		burst = dw_edma_alloc_burst(chunk);
+		burst = dw_edma_alloc_burst(desc, chunk);
 		if (unlikely(!burst))
 			goto err_alloc;
 
@@ -67,6 +67,11 @@ struct dw_edma_desc {
 
 	u32				chunks_alloc;
 
+	/* Preallocated bursts of the transfer, NULL if allocated one by one */
+	struct dw_edma_burst		*burst_pool;
+	u32				burst_pool_sz;
+	u32				burst_pool_used;
+
 	u32				alloc_sz;
 	u32				xfer_sz;
 };
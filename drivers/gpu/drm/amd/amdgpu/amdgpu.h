@@ -217,6 +217,7 @@ extern bool amdgpu_ignore_bad_page_threshold;
 extern struct amdgpu_watchdog_timer amdgpu_watchdog_timer;
 extern int amdgpu_async_gfx_ring;
 extern int amdgpu_mcbp;
+extern uint amdgpu_mcbp_timeslice;
 extern int amdgpu_discovery;
 extern int amdgpu_mes;
 extern int amdgpu_mes_log_enable;
@@ -527,6 +528,7 @@ void amdgpu_device_wb_free(struct amdgpu_device *adev, u32 wb);
  * Benchmarking
  */
 int amdgpu_benchmark(struct amdgpu_device *adev, int test_number);
+void amdgpu_benchmark_results(struct amdgpu_device *adev, struct seq_file *m);
 
 /*
  * ASIC specific register table accessible by UMD
@@ -1168,6 +1170,9 @@ struct amdgpu_device {
 	struct amdgpu_reset_domain	*reset_domain;
 
 	struct mutex			benchmark_mutex;
+	/* machine readable results of the last benchmark */
+	char				*benchmark_results;
+	size_t				benchmark_results_len;
 
 	bool                            scpm_enabled;
 	uint32_t                        scpm_status;
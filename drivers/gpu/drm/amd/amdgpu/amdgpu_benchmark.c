@@ -22,14 +22,38 @@
  * Authors: Jerome Glisse
  */
 
+#include <linux/seq_file.h>
+
 #include <drm/amdgpu_drm.h>
 #include "amdgpu.h"
 
 #define AMDGPU_BENCHMARK_ITERATIONS 1024
 #define AMDGPU_BENCHMARK_COMMON_MODES_N 17
+#define AMDGPU_BENCHMARK_RESULTS_SIZE (16 * 1024)
+
+/*
+ * Every result is also recorded as one line of space separated key=value
+ * pairs, readable through the amdgpu_benchmark_results debugfs file until the
+ * next benchmark is started.
+ */
+static __printf(2, 3) void amdgpu_benchmark_record(struct amdgpu_device *adev,
+						   const char *fmt, ...)
+{
+	va_list args;
+
+	if (!adev->benchmark_results)
+		return;
+
+	va_start(args, fmt);
+	adev->benchmark_results_len +=
+		vscnprintf(adev->benchmark_results + adev->benchmark_results_len,
+			   AMDGPU_BENCHMARK_RESULTS_SIZE - adev->benchmark_results_len,
+			   fmt, args);
+	va_end(args);
+}
 
 static int amdgpu_benchmark_do_move(struct amdgpu_device *adev, unsigned size,
-				    uint64_t saddr, uint64_t daddr, int n, s64 *time_ms)
+				    uint64_t saddr, uint64_t daddr, int n, s64 *time_us)
 {
 	ktime_t stime, etime;
 	struct dma_fence *fence;
@@ -50,7 +74,7 @@ static int amdgpu_benchmark_do_move(struct amdgpu_device *adev, unsigned size,
 
 exit_do_move:
 	etime = ktime_get();
-	*time_ms = ktime_ms_delta(etime, stime);
+	*time_us = max_t(s64, ktime_us_delta(etime, stime), 1);
 
 	return r;
 }
@@ -58,18 +82,21 @@ static int amdgpu_benchmark_do_move(struct amdgpu_device *adev, unsigned size,
 
 static void amdgpu_benchmark_log_results(struct amdgpu_device *adev,
 					 int n, unsigned size,
-					 s64 time_ms,
+					 s64 time_us,
 					 unsigned sdomain, unsigned ddomain,
 					 char *kind)
 {
-	s64 throughput = (n * (size >> 10));
-
-	throughput = div64_s64(throughput, time_ms);
+	/* bytes per us are MB/s */
+	s64 throughput = div64_s64((s64)n * size, time_us);
 
 	dev_info(adev->dev, "amdgpu: %s %u bo moves of %u kB from"
-		 " %d to %d in %lld ms, throughput: %lld Mb/s or %lld MB/s\n",
-		 kind, n, size >> 10, sdomain, ddomain, time_ms,
+		 " %d to %d in %lld us, throughput: %lld Mb/s or %lld MB/s\n",
+		 kind, n, size >> 10, sdomain, ddomain, time_us,
 		 throughput * 8, throughput);
+	amdgpu_benchmark_record(adev,
+				"kind=%s src=%u dst=%u size=%u n=%d time_us=%lld mbps=%lld\n",
+				kind, sdomain, ddomain, size, n, time_us,
+				throughput);
 }
 
 static int amdgpu_benchmark_move(struct amdgpu_device *adev, unsigned size,
@@ -78,7 +105,7 @@ static int amdgpu_benchmark_move(struct amdgpu_device *adev, unsigned size,
 	struct amdgpu_bo *dobj = NULL;
 	struct amdgpu_bo *sobj = NULL;
 	uint64_t saddr, daddr;
-	s64 time_ms;
+	s64 time_us;
 	int r, n;
 
 	n = AMDGPU_BENCHMARK_ITERATIONS;
@@ -99,11 +126,11 @@ static int amdgpu_benchmark_move(struct amdgpu_device *adev, unsigned size,
 		goto out_cleanup;
 
 	if (adev->mman.buffer_funcs) {
-		r = amdgpu_benchmark_do_move(adev, size, saddr, daddr, n, &time_ms);
+		r = amdgpu_benchmark_do_move(adev, size, saddr, daddr, n, &time_us);
 		if (r)
 			goto out_cleanup;
 		else
-			amdgpu_benchmark_log_results(adev, n, size, time_ms,
+			amdgpu_benchmark_log_results(adev, n, size, time_us,
 						     sdomain, ddomain, "dma");
 	}
 
@@ -119,7 +146,193 @@ static int amdgpu_benchmark_move(struct amdgpu_device *adev, unsigned size,
 	return r;
 }
 
-int amdgpu_benchmark(struct amdgpu_device *adev, int test_number)
+/* Fill a buffer with the buffer functions ring */
+static int amdgpu_benchmark_fill(struct amdgpu_device *adev, unsigned size,
+				 unsigned domain)
+{
+	struct amdgpu_bo *bo = NULL;
+	struct dma_fence *fence;
+	ktime_t stime;
+	s64 time_us;
+	int i, r, n;
+
+	if (!adev->mman.buffer_funcs_enabled)
+		return 0;
+
+	n = AMDGPU_BENCHMARK_ITERATIONS;
+
+	r = amdgpu_bo_create_kernel(adev, size, PAGE_SIZE, domain, &bo,
+				    NULL, NULL);
+	if (r)
+		goto out_cleanup;
+
+	stime = ktime_get();
+	for (i = 0; i < n; i++) {
+		r = amdgpu_fill_buffer(bo, 0, NULL, &fence, false);
+		if (r)
+			goto out_cleanup;
+		r = dma_fence_wait(fence, false);
+		dma_fence_put(fence);
+		if (r)
+			goto out_cleanup;
+	}
+	time_us = max_t(s64, ktime_us_delta(ktime_get(), stime), 1);
+
+	amdgpu_benchmark_log_results(adev, n, size, time_us, domain, domain,
+				     "fill");
+
+out_cleanup:
+	if (r < 0)
+		dev_info(adev->dev, "Error while benchmarking BO fill.\n");
+
+	if (bo)
+		amdgpu_bo_free_kernel(&bo, NULL, NULL);
+	return r;
+}
+
+/*
+ * Measure how many small copies can be submitted per second when only the
+ * last one is waited for, and the time from a fence signaling until a waiter
+ * on it returns when every copy is waited for.
+ */
+static int amdgpu_benchmark_submit(struct amdgpu_device *adev)
+{
+	struct amdgpu_ring *ring = adev->mman.buffer_funcs_ring;
+	struct dma_fence *fence = NULL, *next;
+	s64 time_us, latency_us, total_us = 0, max_us = 0;
+	struct amdgpu_bo *bo = NULL;
+	uint64_t addr;
+	ktime_t stime;
+	int i, r, n;
+
+	if (!adev->mman.buffer_funcs)
+		return 0;
+
+	n = AMDGPU_BENCHMARK_ITERATIONS;
+
+	r = amdgpu_bo_create_kernel(adev, 2 * PAGE_SIZE, PAGE_SIZE,
+				    AMDGPU_GEM_DOMAIN_GTT, &bo, &addr, NULL);
+	if (r)
+		goto out_cleanup;
+
+	stime = ktime_get();
+	for (i = 0; i < n; i++) {
+		r = amdgpu_copy_buffer(ring, addr, addr + PAGE_SIZE, PAGE_SIZE,
+				       NULL, &next, false, false, 0);
+		if (r)
+			goto out_cleanup;
+		dma_fence_put(fence);
+		fence = next;
+	}
+	r = dma_fence_wait(fence, false);
+	if (r)
+		goto out_cleanup;
+	time_us = max_t(s64, ktime_us_delta(ktime_get(), stime), 1);
+
+	dev_info(adev->dev, "amdgpu: %d submissions in %lld us, %lld per second\n",
+		 n, time_us, div64_s64((s64)n * USEC_PER_SEC, time_us));
+	amdgpu_benchmark_record(adev, "kind=submit n=%d time_us=%lld rate=%lld\n",
+				n, time_us,
+				div64_s64((s64)n * USEC_PER_SEC, time_us));
+
+	for (i = 0; i < n; i++) {
+		dma_fence_put(fence);
+		fence = NULL;
+		r = amdgpu_copy_buffer(ring, addr, addr + PAGE_SIZE, PAGE_SIZE,
+				       NULL, &fence, false, false, 0);
+		if (r)
+			goto out_cleanup;
+		r = dma_fence_wait(fence, false);
+		if (r)
+			goto out_cleanup;
+
+		if (!test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &fence->flags))
+			continue;
+		latency_us = max_t(s64, ktime_us_delta(ktime_get(),
+						       fence->timestamp), 0);
+		total_us += latency_us;
+		max_us = max(max_us, latency_us);
+	}
+
+	dev_info(adev->dev, "amdgpu: fence signal to wakeup latency avg %lld us, max %lld us\n",
+		 div64_s64(total_us, n), max_us);
+	amdgpu_benchmark_record(adev, "kind=fence n=%d avg_us=%lld max_us=%lld\n",
+				n, div64_s64(total_us, n), max_us);
+
+out_cleanup:
+	if (r < 0)
+		dev_info(adev->dev, "Error while benchmarking submissions.\n");
+
+	dma_fence_put(fence);
+	if (bo)
+		amdgpu_bo_free_kernel(&bo, &addr, NULL);
+	return r;
+}
+
+/* Rewrite the GART entries of a GTT buffer and flush the GART TLB */
+static int amdgpu_benchmark_gart(struct amdgpu_device *adev, unsigned size)
+{
+	struct amdgpu_bo *bo = NULL;
+	uint64_t addr, flags;
+	ktime_t stime;
+	s64 time_us;
+	int i, r, n;
+
+	if (!adev->gart.ptr)
+		return 0;
+
+	n = AMDGPU_BENCHMARK_ITERATIONS;
+
+	r = amdgpu_bo_create_kernel(adev, size, PAGE_SIZE,
+				    AMDGPU_GEM_DOMAIN_GTT, &bo, &addr, NULL);
+	if (r)
+		goto out_cleanup;
+
+	flags = amdgpu_ttm_tt_pte_flags(adev, bo->tbo.ttm, bo->tbo.resource);
+	addr -= adev->gmc.gart_start;
+
+	stime = ktime_get();
+	for (i = 0; i < n; i++) {
+		amdgpu_gart_bind(adev, addr, bo->tbo.ttm->num_pages,
+				 bo->tbo.ttm->dma_address, flags);
+		amdgpu_gart_invalidate_tlb(adev);
+	}
+	time_us = max_t(s64, ktime_us_delta(ktime_get(), stime), 1);
+
+	dev_info(adev->dev, "amdgpu: %d GART updates of %u kB in %lld us, %lld pages per second\n",
+		 n, size >> 10, time_us,
+		 div64_s64((s64)n * (size >> PAGE_SHIFT) * USEC_PER_SEC, time_us));
+	amdgpu_benchmark_record(adev, "kind=gart size=%u n=%d time_us=%lld pps=%lld\n",
+				size, n, time_us,
+				div64_s64((s64)n * (size >> PAGE_SHIFT) *
+					  USEC_PER_SEC, time_us));
+
+out_cleanup:
+	if (r < 0)
+		dev_info(adev->dev, "Error while benchmarking GART updates.\n");
+
+	if (bo)
+		amdgpu_bo_free_kernel(&bo, NULL, NULL);
+	return r;
+}
+
+/**
+ * amdgpu_benchmark_results - print the results of the last benchmark
+ *
+ * @adev: amdgpu_device pointer
+ * @m: seq_file to print to
+ */
+void amdgpu_benchmark_results(struct amdgpu_device *adev, struct seq_file *m)
+{
+	mutex_lock(&adev->benchmark_mutex);
+	if (adev->benchmark_results)
+		seq_write(m, adev->benchmark_results,
+			  adev->benchmark_results_len);
+	mutex_unlock(&adev->benchmark_mutex);
+}
+
+/* Called with the benchmark mutex held */
+static int amdgpu_benchmark_run(struct amdgpu_device *adev, int test_number)
 {
 	int i, r;
 	static const int common_modes[AMDGPU_BENCHMARK_COMMON_MODES_N] = {
@@ -142,7 +355,8 @@ int amdgpu_benchmark(struct amdgpu_device *adev, int test_number)
 		1920 * 1200 * 4
 	};
 
-	mutex_lock(&adev->benchmark_mutex);
+	amdgpu_benchmark_record(adev, "test=%d\n", test_number);
+
 	switch (test_number) {
 	case 1:
 		dev_info(adev->dev,
@@ -246,6 +460,52 @@ int amdgpu_benchmark(struct amdgpu_device *adev, int test_number)
 				goto done;
 		}
 		break;
+	case 9:
+		dev_info(adev->dev,
+			 "benchmark test: %d (VRAM and GTT fill, buffer size sweep, powers of 2)\n",
+			 test_number);
+		/* VRAM and GTT fill, buffer size sweep, powers of 2 */
+		for (i = 1; i <= 16384; i <<= 1) {
+			r = amdgpu_benchmark_fill(adev, i * AMDGPU_GPU_PAGE_SIZE,
+						  AMDGPU_GEM_DOMAIN_VRAM);
+			if (r)
+				goto done;
+			r = amdgpu_benchmark_fill(adev, i * AMDGPU_GPU_PAGE_SIZE,
+						  AMDGPU_GEM_DOMAIN_GTT);
+			if (r)
+				goto done;
+		}
+		break;
+	case 10:
+		dev_info(adev->dev,
+			 "benchmark test: %d (submission rate and fence latency)\n",
+			 test_number);
+		/* submission rate and fence latency */
+		r = amdgpu_benchmark_submit(adev);
+		if (r)
+			goto done;
+		break;
+	case 11:
+		dev_info(adev->dev,
+			 "benchmark test: %d (GART update, buffer size sweep, powers of 2)\n",
+			 test_number);
+		/* GART update, buffer size sweep, powers of 2 */
+		for (i = 1; i <= 16384; i <<= 1) {
+			r = amdgpu_benchmark_gart(adev, i * PAGE_SIZE);
+			if (r)
+				goto done;
+		}
+		break;
+	case 12:
+		dev_info(adev->dev,
+			 "benchmark test: %d (all of the above)\n", test_number);
+		/* all of the above, for regression tracking */
+		for (i = 1; i <= 11; i++) {
+			r = amdgpu_benchmark_run(adev, i);
+			if (r)
+				goto done;
+		}
+		break;
 
 	default:
 		dev_info(adev->dev, "Unknown benchmark %d\n", test_number);
@@ -254,6 +514,20 @@ int amdgpu_benchmark(struct amdgpu_device *adev, int test_number)
 	}
 
 done:
+	return r;
+}
+
+int amdgpu_benchmark(struct amdgpu_device *adev, int test_number)
+{
+	int r;
+
+	mutex_lock(&adev->benchmark_mutex);
+	if (!adev->benchmark_results)
+		adev->benchmark_results = kvmalloc(AMDGPU_BENCHMARK_RESULTS_SIZE,
+						   GFP_KERNEL);
+	adev->benchmark_results_len = 0;
+
+	r = amdgpu_benchmark_run(adev, test_number);
 	mutex_unlock(&adev->benchmark_mutex);
 
 	return r;
@@ -795,6 +795,18 @@ static int amdgpu_cs_bo_validate(void *param, struct amdgpu_bo *bo)
 	if (bo->tbo.pin_count)
 		return 0;
 
+	/*
+	 * Still where the last submission put it, nothing to do. Not every
+	 * placement change goes through amdgpu_bo_move_notify(), e.g. pipeline
+	 * gutting and dma-buf invalidation don't, so check the placement too.
+	 */
+	if (bo->validated_seq == bo->move_seq &&
+	    bo->validated_domains == bo->preferred_domains &&
+	    bo->tbo.resource &&
+	    (amdgpu_mem_type_to_domain(bo->tbo.resource->mem_type) &
+	     bo->preferred_domains))
+		return 0;
+
 	/* Don't move this buffer if we have depleted our allowance
 	 * to move it. Don't move anything if the threshold is zero.
 	 */
@@ -832,6 +844,11 @@ static int amdgpu_cs_bo_validate(void *param, struct amdgpu_bo *bo)
 		goto retry;
 	}
 
+	if (!r && domain == bo->preferred_domains) {
+		bo->validated_seq = bo->move_seq;
+		bo->validated_domains = domain;
+	}
+
 	return r;
 }
 
@@ -1365,6 +1382,7 @@ static int amdgpu_cs_submit(struct amdgpu_cs_parser *p,
 	for (i = 0; i < p->gang_size; ++i) {
 		amdgpu_job_free_resources(p->jobs[i]);
 		trace_amdgpu_cs_ioctl(p->jobs[i]);
+		amdgpu_job_stats_queued(p->jobs[i]);
 		drm_sched_entity_push_job(&p->jobs[i]->base);
 		p->jobs[i] = NULL;
 	}
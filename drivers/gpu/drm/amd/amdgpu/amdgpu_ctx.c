@@ -187,6 +187,34 @@ static ktime_t amdgpu_ctx_fence_time(struct dma_fence *fence)
 			 s_fence->scheduled.timestamp);
 }
 
+/*
+ * Account the time from the submission until the fence's job was handed to
+ * the hardware, once the fence leaves the ring of fences of the entity.
+ */
+static void amdgpu_ctx_fence_latency(struct amdgpu_ctx_mgr *mgr, u32 hw_ip,
+				     struct dma_fence *fence, ktime_t submit_ts)
+{
+	struct drm_sched_fence *s_fence;
+	s64 ns, max;
+
+	if (!fence)
+		return;
+
+	s_fence = to_drm_sched_fence(fence);
+	if (!test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &s_fence->scheduled.flags))
+		return;
+
+	ns = max_t(s64, ktime_to_ns(ktime_sub(s_fence->scheduled.timestamp,
+					      submit_ts)), 0);
+	atomic64_inc(&mgr->jobs[hw_ip]);
+	atomic64_add(ns, &mgr->latency[hw_ip]);
+
+	max = atomic64_read(&mgr->latency_max[hw_ip]);
+	while (ns > max &&
+	       !atomic64_try_cmpxchg(&mgr->latency_max[hw_ip], &max, ns))
+		;
+}
+
 static ktime_t amdgpu_ctx_entity_time(struct amdgpu_ctx *ctx,
 				      struct amdgpu_ctx_entity *centity)
 {
@@ -217,6 +245,13 @@ static int amdgpu_ctx_init_entity(struct amdgpu_ctx *ctx, u32 hw_ip,
 	if (!entity)
 		return  -ENOMEM;
 
+	entity->submit_ts = kcalloc(amdgpu_sched_jobs,
+				    sizeof(*entity->submit_ts), GFP_KERNEL);
+	if (!entity->submit_ts) {
+		kfree(entity);
+		return -ENOMEM;
+	}
+
 	ctx_prio = (ctx->override_priority == AMDGPU_CTX_PRIORITY_UNSET) ?
 			ctx->init_priority : ctx->override_priority;
 	entity->hw_ip = hw_ip;
@@ -264,12 +299,13 @@ static int amdgpu_ctx_init_entity(struct amdgpu_ctx *ctx, u32 hw_ip,
 	drm_sched_entity_fini(&entity->entity);
 
 error_free_entity:
+	kfree(entity->submit_ts);
 	kfree(entity);
 
 	return r;
 }
 
-static ktime_t amdgpu_ctx_fini_entity(struct amdgpu_device *adev,
+static ktime_t amdgpu_ctx_fini_entity(struct amdgpu_ctx_mgr *mgr,
 				  struct amdgpu_ctx_entity *entity)
 {
 	ktime_t res = ns_to_ktime(0);
@@ -280,11 +316,14 @@ static ktime_t amdgpu_ctx_fini_entity(struct amdgpu_device *adev,
 
 	for (i = 0; i < amdgpu_sched_jobs; ++i) {
 		res = ktime_add(res, amdgpu_ctx_fence_time(entity->fences[i]));
+		amdgpu_ctx_fence_latency(mgr, entity->hw_ip, entity->fences[i],
+					 entity->submit_ts[i]);
 		dma_fence_put(entity->fences[i]);
 	}
 
-	amdgpu_xcp_release_sched(adev, entity);
+	amdgpu_xcp_release_sched(mgr->adev, entity);
 
+	kfree(entity->submit_ts);
 	kfree(entity);
 	return res;
 }
@@ -418,7 +457,7 @@ static void amdgpu_ctx_fini(struct kref *ref)
 		for (j = 0; j < AMDGPU_MAX_ENTITY_NUM; ++j) {
 			ktime_t spend;
 
-			spend = amdgpu_ctx_fini_entity(adev, ctx->entities[i][j]);
+			spend = amdgpu_ctx_fini_entity(mgr, ctx->entities[i][j]);
 			atomic64_add(ktime_to_ns(spend), &mgr->time_spend[i]);
 		}
 	}
@@ -762,6 +801,7 @@ uint64_t amdgpu_ctx_add_fence(struct amdgpu_ctx *ctx,
 	uint64_t seq = centity->sequence;
 	struct dma_fence *other = NULL;
 	unsigned idx = 0;
+	ktime_t submit_ts;
 
 	idx = seq & (amdgpu_sched_jobs - 1);
 	other = centity->fences[idx];
@@ -771,11 +811,14 @@ uint64_t amdgpu_ctx_add_fence(struct amdgpu_ctx *ctx,
 
 	spin_lock(&ctx->ring_lock);
 	centity->fences[idx] = fence;
+	submit_ts = centity->submit_ts[idx];
+	centity->submit_ts[idx] = ktime_get();
 	centity->sequence++;
 	spin_unlock(&ctx->ring_lock);
 
 	atomic64_add(ktime_to_ns(amdgpu_ctx_fence_time(other)),
 		     &ctx->mgr->time_spend[centity->hw_ip]);
+	amdgpu_ctx_fence_latency(ctx->mgr, centity->hw_ip, other, submit_ts);
 
 	dma_fence_put(other);
 	return seq;
@@ -889,8 +932,12 @@ void amdgpu_ctx_mgr_init(struct amdgpu_ctx_mgr *mgr,
 	mutex_init(&mgr->lock);
 	idr_init_base(&mgr->ctx_handles, 1);
 
-	for (i = 0; i < AMDGPU_HW_IP_NUM; ++i)
+	for (i = 0; i < AMDGPU_HW_IP_NUM; ++i) {
 		atomic64_set(&mgr->time_spend[i], 0);
+		atomic64_set(&mgr->jobs[i], 0);
+		atomic64_set(&mgr->latency[i], 0);
+		atomic64_set(&mgr->latency_max[i], 0);
+	}
 }
 
 long amdgpu_ctx_mgr_entity_flush(struct amdgpu_ctx_mgr *mgr, long timeout)
@@ -38,6 +38,8 @@ struct amdgpu_ctx_mgr;
 struct amdgpu_ctx_entity {
 	uint32_t		hw_ip;
 	uint64_t		sequence;
+	/* submission time of each of the fences */
+	ktime_t			*submit_ts;
 	struct drm_sched_entity	entity;
 	struct dma_fence	*fences[];
 };
@@ -66,6 +68,10 @@ struct amdgpu_ctx_mgr {
 	/* protected by lock */
 	struct idr		ctx_handles;
 	atomic64_t		time_spend[AMDGPU_HW_IP_NUM];
+	/* submissions which started, and their submit to start latency */
+	atomic64_t		jobs[AMDGPU_HW_IP_NUM];
+	atomic64_t		latency[AMDGPU_HW_IP_NUM];
+	atomic64_t		latency_max[AMDGPU_HW_IP_NUM];
 };
 
 extern const unsigned int amdgpu_ctx_num_entities[AMDGPU_HW_IP_NUM];
@@ -1768,6 +1768,12 @@ static int amdgpu_debugfs_benchmark(void *data, u64 val)
 	return r;
 }
 
+static int amdgpu_debugfs_benchmark_results_show(struct seq_file *m, void *unused)
+{
+	amdgpu_benchmark_results(m->private, m);
+	return 0;
+}
+
 static int amdgpu_debugfs_vm_info_show(struct seq_file *m, void *unused)
 {
 	struct amdgpu_device *adev = m->private;
@@ -1804,6 +1810,7 @@ static int amdgpu_debugfs_vm_info_show(struct seq_file *m, void *unused)
 
 DEFINE_SHOW_ATTRIBUTE(amdgpu_debugfs_test_ib);
 DEFINE_SHOW_ATTRIBUTE(amdgpu_debugfs_vm_info);
+DEFINE_SHOW_ATTRIBUTE(amdgpu_debugfs_benchmark_results);
 DEFINE_DEBUGFS_ATTRIBUTE(amdgpu_evict_vram_fops, amdgpu_debugfs_evict_vram,
 			 NULL, "%lld\n");
 DEFINE_DEBUGFS_ATTRIBUTE(amdgpu_evict_gtt_fops, amdgpu_debugfs_evict_gtt,
@@ -2115,6 +2122,8 @@ int amdgpu_debugfs_init(struct amdgpu_device *adev)
 			    &amdgpu_debugfs_vm_info_fops);
 	debugfs_create_file("amdgpu_benchmark", 0200, root, adev,
 			    &amdgpu_benchmark_fops);
+	debugfs_create_file("amdgpu_benchmark_results", 0444, root, adev,
+			    &amdgpu_debugfs_benchmark_results_fops);
 
 	adev->debugfs_vbios_blob.data = adev->bios;
 	adev->debugfs_vbios_blob.size = adev->bios_size;
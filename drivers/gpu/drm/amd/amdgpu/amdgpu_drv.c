@@ -208,6 +208,7 @@ uint amdgpu_dc_debug_mask;
 uint amdgpu_dc_visual_confirm;
 int amdgpu_async_gfx_ring = 1;
 int amdgpu_mcbp = -1;
+uint amdgpu_mcbp_timeslice = 10000;
 int amdgpu_discovery = -1;
 int amdgpu_mes;
 int amdgpu_mes_log_enable = 0;
@@ -669,6 +670,17 @@ MODULE_PARM_DESC(mcbp,
 	"Enable Mid-command buffer preemption (0 = disabled, 1 = enabled), -1 = auto (default)");
 module_param_named(mcbp, amdgpu_mcbp, int, 0444);
 
+/**
+ * DOC: mcbp_timeslice (uint)
+ * Time in microseconds low priority gfx work may run before it is preempted in favour of
+ * high priority gfx work when mid command buffer preemption is enabled. High priority work
+ * arriving while the low priority work is within its time slice is deferred until the time
+ * slice expired. The default is 10000.
+ */
+MODULE_PARM_DESC(mcbp_timeslice,
+	"Time slice of low priority gfx work before preemption by high priority work in us (default 10000)");
+module_param_named(mcbp_timeslice, amdgpu_mcbp_timeslice, uint, 0644);
+
 /**
  * DOC: discovery (int)
  * Allow driver to discover hardware IP information from IP Discovery table at the top of VRAM.
@@ -819,6 +831,19 @@ int queue_preemption_timeout_ms = 9000;
 module_param(queue_preemption_timeout_ms, int, 0644);
 MODULE_PARM_DESC(queue_preemption_timeout_ms, "queue preemption timeout in ms (1 = Minimum, 9000 = default)");
 
+/**
+ * DOC: hws_idle_unmap_ms (int)
+ * Interval in ms at which the read and write pointers of user mode queues are
+ * sampled with the HW scheduler. A queue whose write pointer did not move and
+ * that had no pending work for two intervals is left out of the runlist while
+ * the runlist is over subscribed, and mapped back once its write pointer
+ * moves, so that the firmware only round-robins between busy queues. The
+ * samples also provide the runnable_ms queue statistic. 0 = disabled (default)
+ */
+int hws_idle_unmap_ms;
+module_param(hws_idle_unmap_ms, int, 0644);
+MODULE_PARM_DESC(hws_idle_unmap_ms, "Sample queue activity and unmap idle queues of an over subscribed runlist at this interval in ms (0 = disabled (default))");
+
 /**
  * DOC: debug_evictions(bool)
  * Enable extra debug messages to help determine the cause of evictions
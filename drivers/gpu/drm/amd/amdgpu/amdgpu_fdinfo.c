@@ -125,4 +125,27 @@ void amdgpu_show_fdinfo(struct drm_printer *p, struct drm_file *file)
 		drm_printf(p, "drm-engine-%s:\t%lld ns\n", amdgpu_ip_name[hw_ip],
 			   ktime_to_ns(usage[hw_ip]));
 	}
+
+	/*
+	 * Amdgpu specific submission latency keys: time from submission to
+	 * the job being handed to the hardware, including the wait for its
+	 * dependencies, of the submissions which are no longer tracked in
+	 * the contexts' fence rings.
+	 */
+	for (hw_ip = 0; hw_ip < AMDGPU_HW_IP_NUM; ++hw_ip) {
+		struct amdgpu_ctx_mgr *mgr = &fpriv->ctx_mgr;
+		u64 jobs = atomic64_read(&mgr->jobs[hw_ip]);
+
+		if (!jobs)
+			continue;
+
+		drm_printf(p, "amd-jobs-%s:\t%llu\n", amdgpu_ip_name[hw_ip],
+			   jobs);
+		drm_printf(p, "amd-latency-%s:\t%lld ns\n",
+			   amdgpu_ip_name[hw_ip],
+			   atomic64_read(&mgr->latency[hw_ip]));
+		drm_printf(p, "amd-latency-max-%s:\t%lld ns\n",
+			   amdgpu_ip_name[hw_ip],
+			   atomic64_read(&mgr->latency_max[hw_ip]));
+	}
 }
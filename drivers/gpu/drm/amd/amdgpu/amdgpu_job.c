@@ -270,10 +270,90 @@ void amdgpu_job_free_resources(struct amdgpu_job *job)
 		amdgpu_ib_free(NULL, &job->ibs[i], f);
 }
 
+/**
+ * amdgpu_job_stats_queued - account a job pushed to the scheduler
+ *
+ * @job: the armed job
+ *
+ * Counts the job as queued on the ring it was armed for until it is run or
+ * freed.
+ */
+void amdgpu_job_stats_queued(struct amdgpu_job *job)
+{
+	struct amdgpu_ring *ring = to_amdgpu_ring(job->base.sched);
+
+	job->stats_queued = true;
+	atomic_inc(&ring->stats.queued);
+}
+
+static void amdgpu_job_stats_dequeue(struct amdgpu_ring *ring,
+				     struct amdgpu_job *job)
+{
+	if (job->stats_queued) {
+		job->stats_queued = false;
+		atomic_dec(&ring->stats.queued);
+	}
+}
+
+/*
+ * Split the time the job waited before being run into waiting for its
+ * dependencies, i.e. until the last of them signaled, and waiting for the
+ * scheduler and ring after that.
+ */
+static void amdgpu_job_stats_start(struct amdgpu_ring *ring,
+				   struct amdgpu_job *job)
+{
+	ktime_t submit = job->base.submit_ts;
+	ktime_t ready = submit, now = ktime_get();
+	struct dma_fence *f;
+	unsigned long index;
+
+	amdgpu_job_stats_dequeue(ring, job);
+	if (job->job_run_counter)
+		return;
+
+	xa_for_each(&job->base.dependencies, index, f) {
+		if (test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &f->flags) &&
+		    ktime_after(f->timestamp, ready))
+			ready = f->timestamp;
+	}
+	if (ktime_after(ready, now))
+		ready = now;
+
+	atomic64_inc(&ring->stats.jobs);
+	atomic64_add(ktime_to_ns(ktime_sub(ready, submit)),
+		     &ring->stats.dep_wait_ns);
+	atomic64_add(ktime_to_ns(ktime_sub(now, ready)),
+		     &ring->stats.sched_wait_ns);
+}
+
+static void amdgpu_job_stats_done(struct amdgpu_ring *ring,
+				  struct amdgpu_job *job)
+{
+	struct drm_sched_fence *s_fence = job->base.s_fence;
+	unsigned int bucket;
+	u64 ns;
+
+	amdgpu_job_stats_dequeue(ring, job);
+	if (!s_fence ||
+	    !test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &s_fence->scheduled.flags) ||
+	    !test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &s_fence->finished.flags))
+		return;
+
+	ns = ktime_to_ns(ktime_sub(s_fence->finished.timestamp,
+				   s_fence->scheduled.timestamp));
+	bucket = min_t(unsigned int, fls64(div_u64(ns, NSEC_PER_USEC)),
+		       AMDGPU_RING_STATS_BUCKETS - 1);
+
+	atomic64_add(ns, &ring->stats.runtime_ns);
+	atomic64_inc(&ring->stats.runtime_hist[bucket]);
+}
+
 static void amdgpu_job_free_cb(struct drm_sched_job *s_job)
 {
 	struct amdgpu_job *job = to_amdgpu_job(s_job);
 
+	amdgpu_job_stats_done(to_amdgpu_ring(s_job->sched), job);
 	drm_sched_job_cleanup(s_job);
 
 	amdgpu_sync_free(&job->explicit_sync);
@@ -324,6 +404,7 @@ struct dma_fence *amdgpu_job_submit(struct amdgpu_job *job)
 	drm_sched_job_arm(&job->base);
 	f = dma_fence_get(&job->base.s_fence->finished);
 	amdgpu_job_free_resources(job);
+	amdgpu_job_stats_queued(job);
 	drm_sched_entity_push_job(&job->base);
 
 	return f;
@@ -387,6 +468,7 @@ static struct dma_fence *amdgpu_job_run(struct drm_sched_job *sched_job)
 	finished = &job->base.s_fence->finished;
 
 	trace_amdgpu_sched_run_job(job);
+	amdgpu_job_stats_start(ring, job);
 
 	/* Skip job if VRAM is lost and never resubmit gangs */
 	if (job->generation != amdgpu_vm_generation(adev, job->vm) ||
@@ -79,6 +79,9 @@ struct amdgpu_job {
 	/* enforce isolation */
 	bool			enforce_isolation;
 
+	/* counted in the queued jobs of its ring */
+	bool			stats_queued;
+
 	uint32_t		num_ibs;
 	struct amdgpu_ib	ibs[];
 };
@@ -101,6 +104,7 @@ void amdgpu_job_free_resources(struct amdgpu_job *job);
 void amdgpu_job_set_gang_leader(struct amdgpu_job *job,
 				struct amdgpu_job *leader);
 void amdgpu_job_free(struct amdgpu_job *job);
+void amdgpu_job_stats_queued(struct amdgpu_job *job);
 struct dma_fence *amdgpu_job_submit(struct amdgpu_job *job);
 int amdgpu_job_submit_direct(struct amdgpu_job *job, struct amdgpu_ring *ring,
 			     struct dma_fence **fence);
@@ -112,6 +112,16 @@ struct amdgpu_bo {
 	/* Constant after initialization */
 	struct amdgpu_bo		*parent;
 
+	/*
+	 * Protected by tbo.reserved. @move_seq is bumped on every move, CS
+	 * stores it in @validated_seq once the BO was validated into
+	 * @validated_domains, and skips validating it again as long as neither
+	 * the BO moved nor its preferred domains changed.
+	 */
+	u32				move_seq;
+	u32				validated_seq;
+	u32				validated_domains;
+
 #ifdef CONFIG_MMU_NOTIFIER
 	struct mmu_interval_notifier	notifier;
 #endif
@@ -615,6 +615,30 @@ static int amdgpu_debugfs_ring_error(void *data, u64 val)
 DEFINE_DEBUGFS_ATTRIBUTE_SIGNED(amdgpu_debugfs_error_fops, NULL,
 				amdgpu_debugfs_ring_error, "%lld\n");
 
+static int amdgpu_debugfs_ring_stats_show(struct seq_file *m, void *unused)
+{
+	struct amdgpu_ring *ring = m->private;
+	struct amdgpu_ring_stats *stats = &ring->stats;
+	unsigned int i;
+
+	seq_printf(m, "queued: %d\n", atomic_read(&stats->queued));
+	seq_printf(m, "hw_queued: %d\n",
+		   ring->no_scheduler ? 0 : atomic_read(&ring->sched.credit_count));
+	seq_printf(m, "jobs: %lld\n", atomic64_read(&stats->jobs));
+	seq_printf(m, "dep_wait_ns: %lld\n", atomic64_read(&stats->dep_wait_ns));
+	seq_printf(m, "sched_wait_ns: %lld\n",
+		   atomic64_read(&stats->sched_wait_ns));
+	seq_printf(m, "runtime_ns: %lld\n", atomic64_read(&stats->runtime_ns));
+
+	seq_puts(m, "runtime_hist_us:");
+	for (i = 0; i < AMDGPU_RING_STATS_BUCKETS; i++)
+		seq_printf(m, " %lld", atomic64_read(&stats->runtime_hist[i]));
+	seq_putc(m, '\n');
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(amdgpu_debugfs_ring_stats);
+
 #endif
 
 void amdgpu_debugfs_ring_init(struct amdgpu_device *adev,
@@ -641,6 +665,10 @@ void amdgpu_debugfs_ring_init(struct amdgpu_device *adev,
 	debugfs_create_file(name, 0200, root, ring,
 			    &amdgpu_debugfs_error_fops);
 
+	sprintf(name, "amdgpu_stats_%s", ring->name);
+	debugfs_create_file(name, 0444, root, ring,
+			    &amdgpu_debugfs_ring_stats_fops);
+
 #endif
 }
 
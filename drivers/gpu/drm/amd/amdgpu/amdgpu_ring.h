@@ -239,6 +239,27 @@ struct amdgpu_ring_funcs {
 	void (*emit_cleaner_shader)(struct amdgpu_ring *ring);
 };
 
+/*
+ * Job runtimes are counted in power of two buckets of microseconds, from
+ * below 1us up to 2^(AMDGPU_RING_STATS_BUCKETS - 2)us and above.
+ */
+#define AMDGPU_RING_STATS_BUCKETS	20
+
+/* Software side timing of the jobs submitted through the scheduler */
+struct amdgpu_ring_stats {
+	/* jobs pushed to the scheduler but not run yet */
+	atomic_t		queued;
+	/* jobs run so far */
+	atomic64_t		jobs;
+	/* time from submission until the last dependency signaled */
+	atomic64_t		dep_wait_ns;
+	/* time from then until the job was handed to the ring */
+	atomic64_t		sched_wait_ns;
+	/* time from being handed to the ring until completion */
+	atomic64_t		runtime_ns;
+	atomic64_t		runtime_hist[AMDGPU_RING_STATS_BUCKETS];
+};
+
 struct amdgpu_ring {
 	struct amdgpu_device		*adev;
 	const struct amdgpu_ring_funcs	*funcs;
@@ -307,6 +328,7 @@ struct amdgpu_ring {
 	bool            is_sw_ring;
 	unsigned int    entry_index;
 
+	struct amdgpu_ring_stats	stats;
 };
 
 #define amdgpu_ring_parse_cs(r, p, job, ib) ((r)->funcs->parse_cs((p), (job), (ib)))
@@ -28,7 +28,6 @@
 #include "amdgpu.h"
 
 #define AMDGPU_MUX_RESUBMIT_JIFFIES_TIMEOUT (HZ / 2)
-#define AMDGPU_MAX_LAST_UNSIGNALED_THRESHOLD_US 10000
 
 static const struct ring_info {
 	unsigned int hw_pio;
@@ -40,6 +39,8 @@ static const struct ring_info {
 
 static struct kmem_cache *amdgpu_mux_chunk_slab;
 
+static void amdgpu_mcbp_timeslice_work(struct work_struct *work);
+
 static inline struct amdgpu_mux_entry *amdgpu_ring_mux_sw_entry(struct amdgpu_ring_mux *mux,
 								struct amdgpu_ring *ring)
 {
@@ -151,6 +152,7 @@ int amdgpu_ring_mux_init(struct amdgpu_ring_mux *mux, struct amdgpu_ring *ring,
 {
 	mux->real_ring = ring;
 	mux->num_ring_entries = 0;
+	INIT_DELAYED_WORK(&mux->timeslice_work, amdgpu_mcbp_timeslice_work);
 
 	mux->ring_entry = kcalloc(entry_size, sizeof(struct amdgpu_mux_entry), GFP_KERNEL);
 	if (!mux->ring_entry)
@@ -177,6 +179,7 @@ void amdgpu_ring_mux_fini(struct amdgpu_ring_mux *mux)
 	struct amdgpu_mux_chunk *chunk, *chunk2;
 	int i;
 
+	cancel_delayed_work_sync(&mux->timeslice_work);
 	for (i = 0; i < mux->num_ring_entries; i++) {
 		e = &mux->ring_entry[i];
 		list_for_each_entry_safe(chunk, chunk2, &e->list, entry) {
@@ -357,23 +360,36 @@ unsigned int amdgpu_sw_ring_priority(int idx)
 		sw_ring_info[idx].hw_pio : AMDGPU_RING_PRIO_DEFAULT;
 }
 
-/*Scan on low prio rings to have unsignaled fence and high ring has no fence.*/
-static int amdgpu_mcbp_scan(struct amdgpu_ring_mux *mux)
+/*
+ * Scan on low prio rings to have unsignaled fence exceeding their time slice
+ * and high ring has no more than @high_fences fences. If the low prio work is
+ * still within its time slice, return the time left in @left_us.
+ */
+static int amdgpu_mcbp_scan(struct amdgpu_ring_mux *mux, unsigned int high_fences,
+			    u64 *left_us)
 {
+	u64 timeslice = READ_ONCE(amdgpu_mcbp_timeslice);
 	struct amdgpu_ring *ring;
 	int i, need_preempt;
+	u64 delta;
 
 	need_preempt = 0;
+	*left_us = 0;
 	for (i = 0; i < mux->num_ring_entries; i++) {
 		ring = mux->ring_entry[i].ring;
 		if (ring->hw_prio > AMDGPU_RING_PRIO_DEFAULT &&
-		    amdgpu_fence_count_emitted(ring) > 0)
+		    amdgpu_fence_count_emitted(ring) > high_fences)
 			return 0;
-		if (ring->hw_prio <= AMDGPU_RING_PRIO_DEFAULT &&
-		    amdgpu_fence_last_unsignaled_time_us(ring) >
-		    AMDGPU_MAX_LAST_UNSIGNALED_THRESHOLD_US)
-			need_preempt = 1;
+		if (ring->hw_prio <= AMDGPU_RING_PRIO_DEFAULT) {
+			delta = amdgpu_fence_last_unsignaled_time_us(ring);
+			if (delta > timeslice)
+				need_preempt = 1;
+			else if (delta)
+				*left_us = max(*left_us, timeslice - delta + 1);
+		}
 	}
+	if (need_preempt)
+		*left_us = 0;
 	return need_preempt && !mux->s_resubmit;
 }
 
@@ -389,15 +405,72 @@ static int amdgpu_mcbp_trigger_preempt(struct amdgpu_ring_mux *mux)
 	return r;
 }
 
+/* Returns true if the real ring didn't start on the last copy of @e yet */
+static bool amdgpu_ring_mux_entry_waiting(struct amdgpu_ring_mux *mux,
+					  struct amdgpu_mux_entry *e)
+{
+	struct amdgpu_ring *real_ring = mux->real_ring;
+	u64 wptr, rptr, start;
+
+	spin_lock(&mux->lock);
+	wptr = real_ring->wptr & real_ring->buf_mask;
+	start = e->start_ptr_in_hw_ring & real_ring->buf_mask;
+	spin_unlock(&mux->lock);
+
+	rptr = amdgpu_ring_get_rptr(real_ring) & real_ring->buf_mask;
+	return ((wptr - rptr) & real_ring->buf_mask) >
+		((wptr - start) & real_ring->buf_mask);
+}
+
+/*
+ * High priority work was submitted while the low priority work ahead of it
+ * was still within its time slice. Preempt the low priority work now if the
+ * high priority submission is still waiting behind it.
+ */
+static void amdgpu_mcbp_timeslice_work(struct work_struct *work)
+{
+	struct amdgpu_ring_mux *mux = container_of(work, struct amdgpu_ring_mux,
+						   timeslice_work.work);
+	struct amdgpu_mux_entry *e = NULL;
+	u64 left_us;
+	int i;
+
+	for (i = 0; i < mux->num_ring_entries; i++) {
+		if (mux->ring_entry[i].ring->hw_prio > AMDGPU_RING_PRIO_DEFAULT) {
+			e = &mux->ring_entry[i];
+			break;
+		}
+	}
+
+	/*
+	 * Only with a single high priority submission outstanding can we tell
+	 * that the real ring is still busy with low priority work.
+	 */
+	if (!e || READ_ONCE(mux->pending_trailing_fence_signaled) ||
+	    amdgpu_fence_count_emitted(e->ring) != 1 ||
+	    !amdgpu_ring_mux_entry_waiting(mux, e))
+		return;
+
+	if (amdgpu_mcbp_scan(mux, 1, &left_us) > 0)
+		amdgpu_mcbp_trigger_preempt(mux);
+	else if (left_us)
+		mod_delayed_work(system_highpri_wq, &mux->timeslice_work,
+				 usecs_to_jiffies(left_us));
+}
+
 void amdgpu_sw_ring_ib_begin(struct amdgpu_ring *ring)
 {
 	struct amdgpu_device *adev = ring->adev;
 	struct amdgpu_ring_mux *mux = &adev->gfx.muxer;
+	u64 left_us;
 
 	WARN_ON(!ring->is_sw_ring);
 	if (adev->gfx.mcbp && ring->hw_prio > AMDGPU_RING_PRIO_DEFAULT) {
-		if (amdgpu_mcbp_scan(mux) > 0)
+		if (amdgpu_mcbp_scan(mux, 0, &left_us) > 0)
 			amdgpu_mcbp_trigger_preempt(mux);
+		else if (left_us)
+			mod_delayed_work(system_highpri_wq, &mux->timeslice_work,
+					 usecs_to_jiffies(left_us));
 		return;
 	}
 
@@ -26,6 +26,7 @@
 
 #include <linux/timer.h>
 #include <linux/spinlock.h>
+#include <linux/workqueue.h>
 #include "amdgpu_ring.h"
 
 struct amdgpu_ring;
@@ -77,6 +78,8 @@ struct amdgpu_ring_mux {
 	uint32_t                seqno_to_resubmit;
 	u64                     wptr_resubmit;
 	struct timer_list       resubmit_timer;
+	/* preempts low priority work once its time slice expired */
+	struct delayed_work     timeslice_work;
 
 	bool                    pending_trailing_fence_signaled;
 };
@@ -927,76 +927,65 @@ amdgpu_vm_tlb_flush(struct amdgpu_vm_update_params *params,
 }
 
 /**
- * amdgpu_vm_update_range - update a range in the vm page table
+ * amdgpu_vm_update_begin - start a batch of page table updates
  *
+ * @params: update parameters to initialize
  * @adev: amdgpu_device pointer to use for commands
- * @vm: the VM to update the range
+ * @vm: the VM to update
  * @immediate: immediate submission in a page fault
  * @unlocked: unlocked invalidation during MM callback
- * @flush_tlb: trigger tlb invalidation after update completed
- * @allow_override: change MTYPE for local NUMA nodes
  * @sync: fences we need to sync to
- * @start: start of mapped range
- * @last: last mapped entry
- * @flags: flags for the entries
- * @offset: offset into nodes and pages_addr
- * @vram_base: base for vram mappings
- * @res: ttm_resource to map
- * @pages_addr: DMA addresses to use for mapping
- * @fence: optional resulting fence
  *
- * Fill in the page table entries between @start and @last.
+ * Prepare a single submission into which any number of ranges can then be
+ * written with amdgpu_vm_update_add(). The batch must be finished with either
+ * amdgpu_vm_update_commit() or amdgpu_vm_update_abort(), the VM eviction lock
+ * is held in between.
+ *
+ * Accumulating the ranges this way means that they share the IBs, only need
+ * to sync to @sync once and result in at most one TLB flush.
  *
  * Returns:
  * 0 for success, negative erro code for failure.
  */
-int amdgpu_vm_update_range(struct amdgpu_device *adev, struct amdgpu_vm *vm,
-			   bool immediate, bool unlocked, bool flush_tlb,
-			   bool allow_override, struct amdgpu_sync *sync,
-			   uint64_t start, uint64_t last, uint64_t flags,
-			   uint64_t offset, uint64_t vram_base,
-			   struct ttm_resource *res, dma_addr_t *pages_addr,
-			   struct dma_fence **fence)
+int amdgpu_vm_update_begin(struct amdgpu_vm_update_params *params,
+			   struct amdgpu_device *adev, struct amdgpu_vm *vm,
+			   bool immediate, bool unlocked,
+			   struct amdgpu_sync *sync)
 {
-	struct amdgpu_vm_tlb_seq_struct *tlb_cb;
-	struct amdgpu_vm_update_params params;
-	struct amdgpu_res_cursor cursor;
-	int r, idx;
+	int r;
 
-	if (!drm_dev_enter(adev_to_drm(adev), &idx))
+	memset(params, 0, sizeof(*params));
+	if (!drm_dev_enter(adev_to_drm(adev), &params->dev_idx))
 		return -ENODEV;
 
-	tlb_cb = kmalloc(sizeof(*tlb_cb), GFP_KERNEL);
-	if (!tlb_cb) {
-		drm_dev_exit(idx);
+	params->tlb_cb = kmalloc(sizeof(*params->tlb_cb), GFP_KERNEL);
+	if (!params->tlb_cb) {
+		drm_dev_exit(params->dev_idx);
 		return -ENOMEM;
 	}
 
+	params->adev = adev;
+	params->vm = vm;
+	params->immediate = immediate;
+	params->unlocked = unlocked;
+	INIT_LIST_HEAD(&params->tlb_flush_waitlist);
+
 	/* Vega20+XGMI where PTEs get inadvertently cached in L2 texture cache,
 	 * heavy-weight flush TLB unconditionally.
 	 */
-	flush_tlb |= adev->gmc.xgmi.num_physical_nodes &&
-		     amdgpu_ip_version(adev, GC_HWIP, 0) == IP_VERSION(9, 4, 0);
+	params->needs_flush = adev->gmc.xgmi.num_physical_nodes &&
+		amdgpu_ip_version(adev, GC_HWIP, 0) == IP_VERSION(9, 4, 0);
 
 	/*
 	 * On GFX8 and older any 8 PTE block with a valid bit set enters the TLB
 	 */
-	flush_tlb |= amdgpu_ip_version(adev, GC_HWIP, 0) < IP_VERSION(9, 0, 0);
-
-	memset(&params, 0, sizeof(params));
-	params.adev = adev;
-	params.vm = vm;
-	params.immediate = immediate;
-	params.pages_addr = pages_addr;
-	params.unlocked = unlocked;
-	params.needs_flush = flush_tlb;
-	params.allow_override = allow_override;
-	INIT_LIST_HEAD(&params.tlb_flush_waitlist);
+	params->needs_flush |=
+		amdgpu_ip_version(adev, GC_HWIP, 0) < IP_VERSION(9, 0, 0);
 
 	amdgpu_vm_eviction_lock(vm);
 	if (vm->evicting) {
 		r = -EBUSY;
-		goto error_free;
+		goto error_unlock;
 	}
 
 	if (!unlocked && !dma_fence_is_signaled(vm->last_unlocked)) {
@@ -1007,9 +996,52 @@ int amdgpu_vm_update_range(struct amdgpu_device *adev, struct amdgpu_vm *vm,
 		dma_fence_put(tmp);
 	}
 
-	r = vm->update_funcs->prepare(&params, sync);
+	r = vm->update_funcs->prepare(params, sync);
 	if (r)
-		goto error_free;
+		goto error_unlock;
+
+	return 0;
+
+error_unlock:
+	amdgpu_vm_update_abort(params);
+	return r;
+}
+
+/**
+ * amdgpu_vm_update_add - add a range to a batch of page table updates
+ *
+ * @params: update parameters from amdgpu_vm_update_begin()
+ * @flush_tlb: trigger tlb invalidation after the batch completed
+ * @allow_override: change MTYPE for local NUMA nodes
+ * @start: start of mapped range
+ * @last: last mapped entry
+ * @flags: flags for the entries
+ * @offset: offset into nodes and pages_addr
+ * @vram_base: base for vram mappings
+ * @res: ttm_resource to map
+ * @pages_addr: DMA addresses to use for mapping
+ *
+ * Fill in the page table entries between @start and @last. The entries are
+ * written to the IB right away, so @res and @pages_addr are not accessed
+ * after this returns.
+ *
+ * Returns:
+ * 0 for success, negative erro code for failure. On failure the batch must
+ * be aborted.
+ */
+int amdgpu_vm_update_add(struct amdgpu_vm_update_params *params,
+			 bool flush_tlb, bool allow_override,
+			 uint64_t start, uint64_t last, uint64_t flags,
+			 uint64_t offset, uint64_t vram_base,
+			 struct ttm_resource *res, dma_addr_t *pages_addr)
+{
+	struct amdgpu_device *adev = params->adev;
+	struct amdgpu_res_cursor cursor;
+	int r;
+
+	params->pages_addr = pages_addr;
+	params->needs_flush |= flush_tlb;
+	params->allow_override = allow_override;
 
 	amdgpu_res_first(pages_addr ? NULL : res, offset,
 			 (last - start + 1) * AMDGPU_GPU_PAGE_SIZE, &cursor);
@@ -1044,10 +1076,10 @@ int amdgpu_vm_update_range(struct amdgpu_device *adev, struct amdgpu_vm *vm,
 
 			if (!contiguous) {
 				addr = cursor.start;
-				params.pages_addr = pages_addr;
+				params->pages_addr = pages_addr;
 			} else {
 				addr = pages_addr[cursor.start >> PAGE_SHIFT];
-				params.pages_addr = NULL;
+				params->pages_addr = NULL;
 			}
 
 		} else if (flags & (AMDGPU_PTE_VALID | AMDGPU_PTE_PRT_FLAG(adev))) {
@@ -1057,32 +1089,130 @@ int amdgpu_vm_update_range(struct amdgpu_device *adev, struct amdgpu_vm *vm,
 		}
 
 		tmp = start + num_entries;
-		r = amdgpu_vm_ptes_update(&params, start, tmp, addr, flags);
+		r = amdgpu_vm_ptes_update(params, start, tmp, addr, flags);
 		if (r)
-			goto error_free;
+			return r;
 
 		amdgpu_res_next(&cursor, num_entries * AMDGPU_GPU_PAGE_SIZE);
 		start = tmp;
 	}
 
-	r = vm->update_funcs->commit(&params, fence);
+	params->num_ranges++;
+	return 0;
+}
+
+/**
+ * amdgpu_vm_update_commit - submit a batch of page table updates
+ *
+ * @params: update parameters from amdgpu_vm_update_begin()
+ * @fence: optional resulting fence
+ *
+ * Submit everything added to the batch and, if any of the ranges asked for
+ * it, prepare a single TLB flush once the submission completed. An empty
+ * batch is dropped without touching the hardware.
+ *
+ * Returns:
+ * 0 for success, negative erro code for failure.
+ */
+int amdgpu_vm_update_commit(struct amdgpu_vm_update_params *params,
+			    struct dma_fence **fence)
+{
+	struct amdgpu_vm *vm = params->vm;
+	int r;
+
+	if (!params->num_ranges) {
+		amdgpu_vm_update_abort(params);
+		return 0;
+	}
+
+	r = vm->update_funcs->commit(params, fence);
 	if (r)
 		goto error_free;
 
-	if (params.needs_flush) {
-		amdgpu_vm_tlb_flush(&params, fence, tlb_cb);
-		tlb_cb = NULL;
+	if (params->needs_flush) {
+		amdgpu_vm_tlb_flush(params, fence, params->tlb_cb);
+		params->tlb_cb = NULL;
 	}
 
-	amdgpu_vm_pt_free_list(adev, &params);
+	amdgpu_vm_pt_free_list(params->adev, params);
 
 error_free:
-	kfree(tlb_cb);
-	amdgpu_vm_eviction_unlock(vm);
-	drm_dev_exit(idx);
+	amdgpu_vm_update_abort(params);
 	return r;
 }
 
+/**
+ * amdgpu_vm_update_abort - end a batch of page table updates
+ *
+ * @params: update parameters from amdgpu_vm_update_begin()
+ *
+ * Release what amdgpu_vm_update_begin() acquired without submitting the
+ * batch, including a job which has not been submitted yet.
+ */
+void amdgpu_vm_update_abort(struct amdgpu_vm_update_params *params)
+{
+	if (params->job) {
+		amdgpu_job_free(params->job);
+		params->job = NULL;
+	}
+	kfree(params->tlb_cb);
+	params->tlb_cb = NULL;
+	amdgpu_vm_eviction_unlock(params->vm);
+	drm_dev_exit(params->dev_idx);
+}
+
+/**
+ * amdgpu_vm_update_range - update a range in the vm page table
+ *
+ * @adev: amdgpu_device pointer to use for commands
+ * @vm: the VM to update the range
+ * @immediate: immediate submission in a page fault
+ * @unlocked: unlocked invalidation during MM callback
+ * @flush_tlb: trigger tlb invalidation after update completed
+ * @allow_override: change MTYPE for local NUMA nodes
+ * @sync: fences we need to sync to
+ * @start: start of mapped range
+ * @last: last mapped entry
+ * @flags: flags for the entries
+ * @offset: offset into nodes and pages_addr
+ * @vram_base: base for vram mappings
+ * @res: ttm_resource to map
+ * @pages_addr: DMA addresses to use for mapping
+ * @fence: optional resulting fence
+ *
+ * Fill in the page table entries between @start and @last, as a batch of one
+ * range.
+ *
+ * Returns:
+ * 0 for success, negative erro code for failure.
+ */
+int amdgpu_vm_update_range(struct amdgpu_device *adev, struct amdgpu_vm *vm,
+			   bool immediate, bool unlocked, bool flush_tlb,
+			   bool allow_override, struct amdgpu_sync *sync,
+			   uint64_t start, uint64_t last, uint64_t flags,
+			   uint64_t offset, uint64_t vram_base,
+			   struct ttm_resource *res, dma_addr_t *pages_addr,
+			   struct dma_fence **fence)
+{
+	struct amdgpu_vm_update_params params;
+	int r;
+
+	r = amdgpu_vm_update_begin(&params, adev, vm, immediate, unlocked,
+				   sync);
+	if (r)
+		return r;
+
+	r = amdgpu_vm_update_add(&params, flush_tlb, allow_override, start,
+				 last, flags, offset, vram_base, res,
+				 pages_addr);
+	if (r) {
+		amdgpu_vm_update_abort(&params);
+		return r;
+	}
+
+	return amdgpu_vm_update_commit(&params, fence);
+}
+
 static void amdgpu_vm_bo_get_memory(struct amdgpu_bo_va *bo_va,
 				    struct amdgpu_mem_stats *stats,
 				    unsigned int size)
@@ -1150,6 +1280,7 @@ int amdgpu_vm_bo_update(struct amdgpu_device *adev, struct amdgpu_bo_va *bo_va,
 {
 	struct amdgpu_bo *bo = bo_va->base.bo;
 	struct amdgpu_vm *vm = bo_va->base.vm;
+	struct amdgpu_vm_update_params params;
 	struct amdgpu_bo_va_mapping *mapping;
 	struct dma_fence **last_update;
 	dma_addr_t *pages_addr = NULL;
@@ -1236,6 +1367,14 @@ int amdgpu_vm_bo_update(struct amdgpu_device *adev, struct amdgpu_bo_va *bo_va,
 		list_splice_init(&bo_va->valids, &bo_va->invalids);
 	}
 
+	/* Write all mappings of the BO with a single submission */
+	if (!list_empty(&bo_va->invalids)) {
+		r = amdgpu_vm_update_begin(&params, adev, vm, false, false,
+					   &sync);
+		if (r)
+			goto error_free;
+	}
+
 	list_for_each_entry(mapping, &bo_va->invalids, list) {
 		uint64_t update_flags = flags;
 
@@ -1252,11 +1391,18 @@ int amdgpu_vm_bo_update(struct amdgpu_device *adev, struct amdgpu_bo_va *bo_va,
 
 		trace_amdgpu_vm_bo_update(mapping);
 
-		r = amdgpu_vm_update_range(adev, vm, false, false, flush_tlb,
-					   !uncached, &sync, mapping->start,
-					   mapping->last, update_flags,
-					   mapping->offset, vram_base, mem,
-					   pages_addr, last_update);
+		r = amdgpu_vm_update_add(&params, flush_tlb, !uncached,
+					 mapping->start, mapping->last,
+					 update_flags, mapping->offset,
+					 vram_base, mem, pages_addr);
+		if (r) {
+			amdgpu_vm_update_abort(&params);
+			goto error_free;
+		}
+	}
+
+	if (!list_empty(&bo_va->invalids)) {
+		r = amdgpu_vm_update_commit(&params, last_update);
 		if (r)
 			goto error_free;
 	}
@@ -1434,11 +1580,14 @@ int amdgpu_vm_clear_freed(struct amdgpu_device *adev,
 			  struct amdgpu_vm *vm,
 			  struct dma_fence **fence)
 {
-	struct amdgpu_bo_va_mapping *mapping;
+	struct amdgpu_bo_va_mapping *mapping, *tmp;
+	struct amdgpu_vm_update_params params;
 	struct dma_fence *f = NULL;
 	struct amdgpu_sync sync;
 	int r;
 
+	if (list_empty(&vm->freed))
+		return 0;
 
 	/*
 	 * Implicitly sync to command submissions in the same VM before
@@ -1450,21 +1599,33 @@ int amdgpu_vm_clear_freed(struct amdgpu_device *adev,
 	if (r)
 		goto error_free;
 
-	while (!list_empty(&vm->freed)) {
-		mapping = list_first_entry(&vm->freed,
-			struct amdgpu_bo_va_mapping, list);
-		list_del(&mapping->list);
+	/*
+	 * Clear all freed ranges with a single submission and TLB flush. On
+	 * failure the mappings stay on the freed list and are cleared again
+	 * next time.
+	 */
+	r = amdgpu_vm_update_begin(&params, adev, vm, false, false, &sync);
+	if (r)
+		goto error_free;
 
-		r = amdgpu_vm_update_range(adev, vm, false, false, true, false,
-					   &sync, mapping->start, mapping->last,
-					   0, 0, 0, NULL, NULL, &f);
-		amdgpu_vm_free_mapping(adev, vm, mapping, f);
+	list_for_each_entry(mapping, &vm->freed, list) {
+		r = amdgpu_vm_update_add(&params, true, false, mapping->start,
+					 mapping->last, 0, 0, 0, NULL, NULL);
 		if (r) {
-			dma_fence_put(f);
+			amdgpu_vm_update_abort(&params);
 			goto error_free;
 		}
 	}
 
+	r = amdgpu_vm_update_commit(&params, &f);
+	if (r)
+		goto error_free;
+
+	list_for_each_entry_safe(mapping, tmp, &vm->freed, list) {
+		list_del(&mapping->list);
+		amdgpu_vm_free_mapping(adev, vm, mapping, f);
+	}
+
 	if (fence && f) {
 		dma_fence_put(*fence);
 		*fence = f;
@@ -42,6 +42,7 @@ struct amdgpu_bo_va;
 struct amdgpu_job;
 struct amdgpu_bo_list_entry;
 struct amdgpu_bo_vm;
+struct amdgpu_vm_tlb_seq_struct;
 
 /*
  * GPUVM handling
@@ -299,6 +300,21 @@ struct amdgpu_vm_update_params {
 	 * @tlb_flush_waitlist: temporary storage for BOs until tlb_flush
 	 */
 	struct list_head tlb_flush_waitlist;
+
+	/**
+	 * @tlb_cb: preallocated callback for the TLB flush of the batch
+	 */
+	struct amdgpu_vm_tlb_seq_struct *tlb_cb;
+
+	/**
+	 * @num_ranges: number of ranges added to the batch
+	 */
+	unsigned int num_ranges;
+
+	/**
+	 * @dev_idx: drm_dev_enter() cookie held for the batch
+	 */
+	int dev_idx;
 };
 
 struct amdgpu_vm_update_funcs {
@@ -513,6 +529,18 @@ int amdgpu_vm_flush_compute_tlb(struct amdgpu_device *adev,
 				uint32_t xcc_mask);
 void amdgpu_vm_bo_base_init(struct amdgpu_vm_bo_base *base,
 			    struct amdgpu_vm *vm, struct amdgpu_bo *bo);
+int amdgpu_vm_update_begin(struct amdgpu_vm_update_params *params,
+			   struct amdgpu_device *adev, struct amdgpu_vm *vm,
+			   bool immediate, bool unlocked,
+			   struct amdgpu_sync *sync);
+int amdgpu_vm_update_add(struct amdgpu_vm_update_params *params,
+			 bool flush_tlb, bool allow_override,
+			 uint64_t start, uint64_t last, uint64_t flags,
+			 uint64_t offset, uint64_t vram_base,
+			 struct ttm_resource *res, dma_addr_t *pages_addr);
+int amdgpu_vm_update_commit(struct amdgpu_vm_update_params *params,
+			    struct dma_fence **fence);
+void amdgpu_vm_update_abort(struct amdgpu_vm_update_params *params);
 int amdgpu_vm_update_range(struct amdgpu_device *adev, struct amdgpu_vm *vm,
 			   bool immediate, bool unlocked, bool flush_tlb,
 			   bool allow_override, struct amdgpu_sync *sync,
@@ -57,8 +57,10 @@ static int amdgpu_vm_sdma_alloc_job(struct amdgpu_vm_update_params *p,
 
 	r = amdgpu_job_alloc_with_ib(p->adev, entity, AMDGPU_FENCE_OWNER_VM,
 				     ndw * 4, pool, &p->job);
-	if (r)
+	if (r) {
+		p->job = NULL;
 		return r;
+	}
 
 	p->num_dw_left = ndw;
 	return 0;
@@ -89,6 +91,7 @@ static int amdgpu_vm_sdma_prepare(struct amdgpu_vm_update_params *p,
 	if (r) {
 		p->num_dw_left = 0;
 		amdgpu_job_free(p->job);
+		p->job = NULL;
 	}
 	return r;
 }
@@ -120,6 +123,7 @@ static int amdgpu_vm_sdma_commit(struct amdgpu_vm_update_params *p,
 
 	WARN_ON(ib->length_dw > p->num_dw_left);
 	f = amdgpu_job_submit(p->job);
+	p->job = NULL;
 
 	if (p->unlocked) {
 		struct dma_fence *tmp = dma_fence_get(f);
@@ -435,6 +435,48 @@ static int amdgpu_dummy_vram_mgr_new(struct ttm_resource_manager *man,
 	return -ENOSPC;
 }
 
+/*
+ * Contiguous allocations can fail with plenty of VRAM free once it is
+ * fragmented. Free up a block of the failed size in the background by
+ * evicting the BOs of the window which has the most free memory already, so
+ * that later allocations of that size succeed.
+ */
+static void amdgpu_vram_mgr_compact_work(struct work_struct *work)
+{
+	struct amdgpu_vram_mgr *mgr =
+		container_of(work, struct amdgpu_vram_mgr, compact_work);
+	struct amdgpu_device *adev = to_amdgpu_device(mgr);
+	struct ttm_operation_ctx ctx = { .interruptible = false };
+	struct ttm_place place = { .mem_type = TTM_PL_VRAM };
+	struct drm_buddy_compact cc;
+	int r;
+
+	mutex_lock(&mgr->lock);
+	r = drm_buddy_compact_begin(&mgr->mm, READ_ONCE(mgr->compact_order),
+				    &cc);
+	mutex_unlock(&mgr->lock);
+	if (r)
+		return;
+
+	place.fpfn = cc.start >> PAGE_SHIFT;
+	place.lpfn = (cc.start + cc.size) >> PAGE_SHIFT;
+	r = ttm_bo_evict_range(&adev->mman.bdev, &mgr->manager, &place, &ctx);
+	if (r)
+		dev_dbg(adev->dev, "VRAM compaction failed (%d)\n", r);
+
+	mutex_lock(&mgr->lock);
+	drm_buddy_compact_end(&mgr->mm, &cc);
+	mutex_unlock(&mgr->lock);
+}
+
+static void amdgpu_vram_mgr_queue_compact(struct amdgpu_vram_mgr *mgr,
+					  u64 size)
+{
+	WRITE_ONCE(mgr->compact_order, ilog2(roundup_pow_of_two(size)) -
+		   ilog2(mgr->mm.chunk_size));
+	queue_work(system_unbound_wq, &mgr->compact_work);
+}
+
 /**
  * amdgpu_vram_mgr_new - allocate new ranges
  *
@@ -559,8 +601,14 @@ static int amdgpu_vram_mgr_new(struct ttm_resource_manager *man,
 			continue;
 		}
 
-		if (unlikely(r))
+		if (unlikely(r)) {
+			if (r == -ENOSPC &&
+			    (vres->flags & DRM_BUDDY_CONTIGUOUS_ALLOCATION) &&
+			    !(vres->flags & DRM_BUDDY_RANGE_ALLOCATION) &&
+			    mm->avail >= size)
+				amdgpu_vram_mgr_queue_compact(mgr, size);
 			goto error_free_blocks;
+		}
 
 		if (size > remaining_size)
 			remaining_size = 0;
@@ -915,6 +963,7 @@ int amdgpu_vram_mgr_init(struct amdgpu_device *adev)
 	INIT_LIST_HEAD(&mgr->reservations_pending);
 	INIT_LIST_HEAD(&mgr->reserved_pages);
 	mgr->default_page_size = PAGE_SIZE;
+	INIT_WORK(&mgr->compact_work, amdgpu_vram_mgr_compact_work);
 
 	if (!adev->gmc.is_app_apu) {
 		man->func = &amdgpu_vram_mgr_func;
@@ -948,6 +997,7 @@ void amdgpu_vram_mgr_fini(struct amdgpu_device *adev)
 	struct amdgpu_vram_reservation *rsv, *temp;
 
 	ttm_resource_manager_set_used(man, false);
+	cancel_work_sync(&mgr->compact_work);
 
 	ret = ttm_resource_manager_evict_all(&adev->mman.bdev, man);
 	if (ret)
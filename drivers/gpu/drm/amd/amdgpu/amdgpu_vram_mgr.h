@@ -35,6 +35,9 @@ struct amdgpu_vram_mgr {
 	struct list_head reserved_pages;
 	atomic64_t vis_usage;
 	u64 default_page_size;
+	/* frees up a block of compact_order after contiguous allocations failed */
+	struct work_struct compact_work;
+	unsigned int compact_order;
 };
 
 struct amdgpu_vram_mgr_resource {
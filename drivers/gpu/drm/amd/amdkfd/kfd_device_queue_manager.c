@@ -67,6 +67,7 @@ static int allocate_hqd(struct device_queue_manager *dqm, struct queue *q);
 static int allocate_sdma_queue(struct device_queue_manager *dqm,
 				struct queue *q, const uint32_t *restore_sdma_id);
 static void kfd_process_hw_exception(struct work_struct *work);
+static void dqm_idle_work(struct work_struct *work);
 
 static inline
 enum KFD_MQD_TYPE get_mqd_type_from_queue_type(enum kfd_queue_type type)
@@ -1754,6 +1755,7 @@ static int initialize_cpsch(struct device_queue_manager *dqm)
 	dqm->gws_queue_count = 0;
 	dqm->active_runlist = false;
 	INIT_WORK(&dqm->hw_exception_work, kfd_process_hw_exception);
+	INIT_DELAYED_WORK(&dqm->idle_work, dqm_idle_work);
 	dqm->trap_debug_vmid = 0;
 
 	init_sdma_bitmaps(dqm);
@@ -1919,6 +1921,8 @@ static int stop_cpsch(struct device_queue_manager *dqm)
 		remove_all_kfd_queues_mes(dqm);
 
 	dqm->sched_running = false;
+	/* It takes the dqm lock, so is flushed below */
+	cancel_delayed_work(&dqm->idle_work);
 
 	if (!dqm->dev->kfd->shared_resources.enable_mes)
 		pm_release_ib(&dqm->packet_mgr);
@@ -1930,6 +1934,9 @@ static int stop_cpsch(struct device_queue_manager *dqm)
 	dqm->detect_hang_info = NULL;
 	dqm_unlock(dqm);
 
+	/* Once running, it sees !sched_running and doesn't requeue itself */
+	flush_delayed_work(&dqm->idle_work);
+
 	return 0;
 }
 
@@ -2121,19 +2128,92 @@ int amdkfd_fence_wait_timeout(struct device_queue_manager *dqm,
 	return 0;
 }
 
+/*
+ * Count the queues dqm_idle_work marked to be left out of the runlist, and
+ * leave out the processes that only have such queues.
+ */
+static void dqm_update_runlist_skip(struct device_queue_manager *dqm)
+{
+	struct device_process_node *cur;
+	struct qcm_process_device *qpd;
+	struct kernel_queue *kq;
+	bool busy, skipped;
+	struct queue *q;
+
+	dqm->runlist_skip_processes = 0;
+	dqm->runlist_skip_queues = 0;
+	dqm->runlist_skip_cp_queues = 0;
+
+	list_for_each_entry(cur, &dqm->queues, list) {
+		qpd = cur->qpd;
+		busy = qpd->is_debug;
+		skipped = false;
+
+		list_for_each_entry(kq, &qpd->priv_queue_list, list)
+			if (kq->queue->properties.is_active)
+				busy = true;
+
+		list_for_each_entry(q, &qpd->queues_list, list) {
+			if (!q->properties.is_active)
+				continue;
+			if (!q->runlist_skip) {
+				busy = true;
+				continue;
+			}
+
+			skipped = true;
+			dqm->runlist_skip_queues++;
+			if (q->properties.type == KFD_QUEUE_TYPE_COMPUTE)
+				dqm->runlist_skip_cp_queues++;
+		}
+
+		qpd->runlist_skip = skipped && !busy;
+		if (qpd->runlist_skip)
+			dqm->runlist_skip_processes++;
+	}
+}
+
+/* Account the time queues spend in the runlist for the mapped_ms statistic */
+static void dqm_runlist_mapped(struct device_queue_manager *dqm, bool mapped)
+{
+	struct device_process_node *cur;
+	ktime_t now = ktime_get();
+	struct queue *q;
+
+	list_for_each_entry(cur, &dqm->queues, list) {
+		list_for_each_entry(q, &cur->qpd->queues_list, list) {
+			if (mapped) {
+				if (q->properties.is_active && !q->runlist_skip)
+					WRITE_ONCE(q->mapped_since, now);
+			} else if (q->mapped_since) {
+				WRITE_ONCE(q->mapped_ns, q->mapped_ns +
+					   ktime_to_ns(ktime_sub(now, q->mapped_since)));
+				WRITE_ONCE(q->mapped_since, 0);
+			}
+		}
+	}
+}
+
 /* dqm->lock mutex has to be locked before calling this function */
 static int map_queues_cpsch(struct device_queue_manager *dqm)
 {
 	struct device *dev = dqm->dev->adev->dev;
+	int period = READ_ONCE(hws_idle_unmap_ms);
 	int retval;
 
 	if (!dqm->sched_running || dqm->sched_halt)
 		return 0;
 	if (dqm->active_queue_count <= 0 || dqm->processes_count <= 0)
 		return 0;
+	if (period > 0)
+		schedule_delayed_work(&dqm->idle_work, msecs_to_jiffies(period));
 	if (dqm->active_runlist)
 		return 0;
 
+	dqm_update_runlist_skip(dqm);
+	if (dqm->runlist_skip_processes == dqm->processes_count)
+		return 0;
+
 	retval = pm_send_runlist(&dqm->packet_mgr, &dqm->queues);
 	pr_debug("%s sent runlist\n", __func__);
 	if (retval) {
@@ -2141,6 +2221,7 @@ static int map_queues_cpsch(struct device_queue_manager *dqm)
 		return retval;
 	}
 	dqm->active_runlist = true;
+	dqm_runlist_mapped(dqm, true);
 
 	return retval;
 }
@@ -2344,6 +2425,7 @@ static int unmap_queues_cpsch(struct device_queue_manager *dqm,
 
 	pm_release_ib(&dqm->packet_mgr);
 	dqm->active_runlist = false;
+	dqm_runlist_mapped(dqm, false);
 
 out:
 	up_read(&dqm->dev->adev->reset_domain->sem);
@@ -2381,6 +2463,151 @@ static int execute_queues_cpsch(struct device_queue_manager *dqm,
 	return retval;
 }
 
+/*
+ * Sample the read and write pointers of a user mode queue. Only AQL and
+ * SOC15 SDMA queues, whose pointers are 64 bit and in the same unit, are
+ * sampled.
+ *
+ * The read pointer of an AQL queue catches up with the write pointer once
+ * the last packet is dispatched, not once it completes, so equal pointers
+ * don't mean the queue is idle. dqm_check_saved_waves() takes care of that
+ * after the queue is unmapped.
+ *
+ * Return: false if the queue could not be sampled, otherwise true with @busy
+ * telling if the write pointer moved since the last sample or packets are
+ * pending
+ */
+static bool dqm_sample_queue(struct queue *q, struct mm_struct *mm, bool *busy)
+{
+	uint64_t __user *rptr_user = q->properties.read_ptr;
+	uint64_t __user *wptr_user = q->properties.write_ptr;
+	uint64_t rptr, wptr;
+
+	if (q->properties.format != KFD_QUEUE_FORMAT_AQL &&
+	    !(KFD_IS_SOC15(q->device) &&
+	      (q->properties.type == KFD_QUEUE_TYPE_SDMA ||
+	       q->properties.type == KFD_QUEUE_TYPE_SDMA_XGMI)))
+		return false;
+
+	if (!read_user_wptr(mm, wptr_user, wptr) ||
+	    !read_user_wptr(mm, rptr_user, rptr))
+		return false;
+
+	*busy = wptr != rptr || wptr != q->last_wptr;
+	q->last_wptr = wptr;
+	return true;
+}
+
+/*
+ * Preempting a queue saves its waves in flight to the context save area, to
+ * be resumed when it is mapped again. A queue left out of the runlist with
+ * saved waves, e.g. one running a long kernel with no further packets, would
+ * never get its write pointer moving and so never be mapped again. Map such
+ * queues back.
+ *
+ * Return: true if any queue was put back into the runlist
+ */
+static bool dqm_check_saved_waves(struct device_queue_manager *dqm)
+{
+	struct mqd_manager *mqd_mgr = dqm->mqd_mgrs[KFD_MQD_TYPE_CP];
+	struct device_process_node *cur;
+	bool changed = false;
+	struct queue *q;
+
+	if (!dqm->dev->kfd->cwsr_enabled || !mqd_mgr->has_saved_waves)
+		return false;
+
+	list_for_each_entry(cur, &dqm->queues, list) {
+		list_for_each_entry(q, &cur->qpd->queues_list, list) {
+			if (!q->runlist_skip ||
+			    q->properties.type != KFD_QUEUE_TYPE_COMPUTE ||
+			    !mqd_mgr->has_saved_waves(mqd_mgr, q->mqd,
+						      &q->properties))
+				continue;
+
+			q->runlist_skip = false;
+			q->idle_samples = 0;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+/*
+ * With an over subscribed runlist the firmware round-robins between all the
+ * mapped queues, idle or not. Every hws_idle_unmap_ms, leave the queues that
+ * had no work for two samples out of the runlist, and map them back as soon
+ * as their write pointer moves. Work submitted to such a queue waits for at
+ * most one interval to be picked up.
+ */
+static void dqm_idle_work(struct work_struct *work)
+{
+	struct device_queue_manager *dqm = container_of(to_delayed_work(work),
+					struct device_queue_manager, idle_work);
+	int period = READ_ONCE(hws_idle_unmap_ms);
+	struct device_process_node *cur;
+	struct qcm_process_device *qpd;
+	bool over, busy, skip, changed = false;
+	struct mm_struct *mm;
+	struct queue *q;
+	ktime_t now;
+
+	dqm_lock(dqm);
+	if (!dqm->sched_running || dqm->sched_halt || dqm->is_hws_hang)
+		goto out;
+
+	now = ktime_get();
+	over = period > 0 && pm_is_over_subscribed(&dqm->packet_mgr);
+
+	list_for_each_entry(cur, &dqm->queues, list) {
+		qpd = cur->qpd;
+		/* mmput_async as the last reference would take the dqm lock */
+		mm = qpd_to_pdd(qpd)->process->mm;
+		if (mm && !mmget_not_zero(mm))
+			mm = NULL;
+
+		list_for_each_entry(q, &qpd->queues_list, list) {
+			if (!q->properties.is_active || period <= 0 ||
+			    !dqm_sample_queue(q, mm, &busy)) {
+				q->last_sample = 0;
+				q->idle_samples = 0;
+			} else if (busy) {
+				if (q->last_sample)
+					WRITE_ONCE(q->runnable_ns, q->runnable_ns +
+						   ktime_to_ns(ktime_sub(now, q->last_sample)));
+				q->last_sample = now;
+				q->idle_samples = 0;
+			} else {
+				q->last_sample = now;
+				if (q->idle_samples < 2)
+					q->idle_samples++;
+			}
+
+			skip = over && q->idle_samples >= 2;
+			if (skip != q->runlist_skip) {
+				q->runlist_skip = skip;
+				changed = true;
+			}
+		}
+
+		if (mm)
+			mmput_async(mm);
+	}
+
+	if (changed &&
+	    !execute_queues_cpsch(dqm, KFD_UNMAP_QUEUES_FILTER_DYNAMIC_QUEUES, 0,
+				  USE_DEFAULT_GRACE_PERIOD) &&
+	    dqm_check_saved_waves(dqm))
+		execute_queues_cpsch(dqm, KFD_UNMAP_QUEUES_FILTER_DYNAMIC_QUEUES, 0,
+				     USE_DEFAULT_GRACE_PERIOD);
+
+	if (period > 0 && dqm->active_queue_count > 0)
+		schedule_delayed_work(&dqm->idle_work, msecs_to_jiffies(period));
+out:
+	dqm_unlock(dqm);
+}
+
 static int wait_on_destroy_queue(struct device_queue_manager *dqm,
 				 struct queue *q)
 {
@@ -285,6 +285,12 @@ struct device_queue_manager {
 	struct dqm_detect_hang_info *detect_hang_info;
 	size_t detect_hang_info_size;
 	int detect_hang_count;
+
+	/* idle queues left out of the runlist, see hws_idle_unmap_ms */
+	struct delayed_work	idle_work;
+	unsigned int		runlist_skip_processes;
+	unsigned int		runlist_skip_queues;
+	unsigned int		runlist_skip_cp_queues;
 };
 
 void device_queue_manager_init_cik(
@@ -472,7 +472,7 @@ svm_migrate_vma_to_vram(struct kfd_node *node, struct svm_range *prange,
  * @mm: the process mm structure
  * @trigger: reason of migration
  *
- * Context: Process context, caller hold mmap read lock, svms lock, prange lock
+ * Context: Process context, caller hold mmap read lock and prange lock
  *
  * Return:
  * 0 - OK, otherwise error code
@@ -865,7 +865,7 @@ int svm_migrate_vram_to_ram(struct svm_range *prange, struct mm_struct *mm,
  * @mm: process mm, use current->mm if NULL
  * @trigger: reason of migration
  *
- * Context: Process context, caller hold mmap read lock, svms lock, prange lock
+ * Context: Process context, caller hold mmap read lock and prange lock
  *
  * migrate all vram pages in prange to sys ram, then migrate
  * [start, last] pages from sys ram to gpu node best_loc.
@@ -955,7 +955,7 @@ static vm_fault_t svm_migrate_to_ram(struct vm_fault *vmf)
 		r = VM_FAULT_SIGBUS;
 		goto out_mmput;
 	}
-	if (READ_ONCE(p->svms.faulting_task) == current) {
+	if (svm_range_is_faulting_task(&p->svms)) {
 		pr_debug("skipping ram migration\n");
 		r = 0;
 		goto out_unref_process;
@@ -969,11 +969,14 @@ static vm_fault_t svm_migrate_to_ram(struct vm_fault *vmf)
 	prange = svm_range_from_addr(&p->svms, addr, NULL);
 	if (!prange) {
 		pr_debug("failed get range svms 0x%p addr 0x%lx\n", &p->svms, addr);
+		mutex_unlock(&p->svms.lock);
 		r = -EFAULT;
-		goto out_unlock_svms;
+		goto out_unref_process;
 	}
 
 	mutex_lock(&prange->migrate_mutex);
+	/* The mmap read lock keeps prange alive, see svm_range_restore_pages */
+	mutex_unlock(&p->svms.lock);
 
 	if (!prange->actual_loc)
 		goto out_unlock_prange;
@@ -991,8 +994,6 @@ static vm_fault_t svm_migrate_to_ram(struct vm_fault *vmf)
 
 out_unlock_prange:
 	mutex_unlock(&prange->migrate_mutex);
-out_unlock_svms:
-	mutex_unlock(&p->svms.lock);
 out_unref_process:
 	pr_debug("CPU fault svms 0x%p address 0x%lx done\n", &p->svms, addr);
 	kfd_unref_process(p);
@@ -50,6 +50,9 @@
  * @get_wave_state: Retrieves context save state and optionally copies the
  * control stack, if kept in the MQD, to the given userspace address.
  *
+ * @has_saved_waves: Checks if waves were saved to the context save area when
+ * the queue was last preempted.
+ *
  * @mqd_mutex: Mqd manager mutex.
  *
  * @dev: The kfd device structure coupled with this module.
@@ -102,6 +105,9 @@ struct mqd_manager {
 				  u32 *ctl_stack_used_size,
 				  u32 *save_area_used_size);
 
+	bool	(*has_saved_waves)(struct mqd_manager *mm, void *mqd,
+				   struct queue_properties *q);
+
 	void	(*get_checkpoint_info)(struct mqd_manager *mm, void *mqd, uint32_t *ctl_stack_size);
 
 	void	(*checkpoint_mqd)(struct mqd_manager *mm,
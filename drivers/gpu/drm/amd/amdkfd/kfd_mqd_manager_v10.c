@@ -231,6 +231,14 @@ static bool check_preemption_failed(struct mqd_manager *mm, void *mqd)
 	return kfd_check_hiq_mqd_doorbell_id(mm->dev, m->queue_doorbell_id0, 0);
 }
 
+static bool has_saved_waves(struct mqd_manager *mm, void *mqd,
+			    struct queue_properties *q)
+{
+	struct v10_compute_mqd *m = get_mqd(mqd);
+
+	return m->cp_hqd_cntl_stack_offset != m->cp_hqd_cntl_stack_size;
+}
+
 static int get_wave_state(struct mqd_manager *mm, void *mqd,
 			  struct queue_properties *q,
 			  void __user *ctl_stack,
@@ -466,6 +474,7 @@ struct mqd_manager *mqd_manager_init_v10(enum KFD_MQD_TYPE type,
 		mqd->is_occupied = kfd_is_occupied_cp;
 		mqd->mqd_size = sizeof(struct v10_compute_mqd);
 		mqd->get_wave_state = get_wave_state;
+		mqd->has_saved_waves = has_saved_waves;
 		mqd->checkpoint_mqd = checkpoint_mqd;
 		mqd->restore_mqd = restore_mqd;
 		mqd->mqd_stride = kfd_mqd_stride;
@@ -328,6 +328,14 @@ static bool check_preemption_failed(struct mqd_manager *mm, void *mqd)
 	return kfd_check_hiq_mqd_doorbell_id(mm->dev, doorbell_id, 0);
 }
 
+static bool has_saved_waves(struct mqd_manager *mm, void *mqd,
+			    struct queue_properties *q)
+{
+	struct v9_mqd *m = get_mqd(mqd);
+
+	return m->cp_hqd_cntl_stack_offset != m->cp_hqd_cntl_stack_size;
+}
+
 static int get_wave_state(struct mqd_manager *mm, void *mqd,
 			  struct queue_properties *q,
 			  void __user *ctl_stack,
@@ -799,6 +807,19 @@ static int load_mqd_v9_4_3(struct mqd_manager *mm, void *mqd,
 	return err;
 }
 
+static bool has_saved_waves_v9_4_3(struct mqd_manager *mm, void *mqd,
+				   struct queue_properties *q)
+{
+	uint64_t mqd_stride_size = mm->mqd_stride(mm, q);
+	int xcc;
+
+	for (xcc = 0; xcc < NUM_XCC(mm->dev->xcc_mask); xcc++)
+		if (has_saved_waves(mm, mqd + mqd_stride_size * xcc, q))
+			return true;
+
+	return false;
+}
+
 static int get_wave_state_v9_4_3(struct mqd_manager *mm, void *mqd,
 				 struct queue_properties *q,
 				 void __user *ctl_stack,
@@ -891,12 +912,14 @@ struct mqd_manager *mqd_manager_init_v9(enum KFD_MQD_TYPE type,
 			mqd->update_mqd = update_mqd_v9_4_3;
 			mqd->destroy_mqd = destroy_mqd_v9_4_3;
 			mqd->get_wave_state = get_wave_state_v9_4_3;
+			mqd->has_saved_waves = has_saved_waves_v9_4_3;
 		} else {
 			mqd->init_mqd = init_mqd;
 			mqd->load_mqd = load_mqd;
 			mqd->update_mqd = update_mqd;
 			mqd->destroy_mqd = kfd_destroy_mqd_cp;
 			mqd->get_wave_state = get_wave_state;
+			mqd->has_saved_waves = has_saved_waves;
 		}
 		break;
 	case KFD_MQD_TYPE_HIQ:
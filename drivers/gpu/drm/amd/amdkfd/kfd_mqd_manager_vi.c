@@ -251,6 +251,14 @@ static void update_mqd(struct mqd_manager *mm, void *mqd,
 	__update_mqd(mm, mqd, q, minfo, MTYPE_UC, 0);
 }
 
+static bool has_saved_waves(struct mqd_manager *mm, void *mqd,
+			    struct queue_properties *q)
+{
+	struct vi_mqd *m = get_mqd(mqd);
+
+	return m->cp_hqd_cntl_stack_offset != m->cp_hqd_cntl_stack_size;
+}
+
 static int get_wave_state(struct mqd_manager *mm, void *mqd,
 			  struct queue_properties *q,
 			  void __user *ctl_stack,
@@ -461,6 +469,7 @@ struct mqd_manager *mqd_manager_init_vi(enum KFD_MQD_TYPE type,
 		mqd->destroy_mqd = kfd_destroy_mqd_cp;
 		mqd->is_occupied = kfd_is_occupied_cp;
 		mqd->get_wave_state = get_wave_state;
+		mqd->has_saved_waves = has_saved_waves;
 		mqd->get_checkpoint_info = get_checkpoint_info;
 		mqd->checkpoint_mqd = checkpoint_mqd;
 		mqd->restore_mqd = restore_mqd;
@@ -38,37 +38,54 @@ static inline void inc_wptr(unsigned int *wptr, unsigned int increment_bytes,
 	*wptr = temp;
 }
 
-static void pm_calc_rlib_size(struct packet_manager *pm,
-				unsigned int *rlib_size,
-				bool *over_subscription)
+static bool pm_over_subscription(struct packet_manager *pm,
+				 unsigned int process_count,
+				 unsigned int compute_queue_count)
 {
-	unsigned int process_count, queue_count, compute_queue_count, gws_queue_count;
-	unsigned int map_queue_size;
 	unsigned int max_proc_per_quantum = 1;
 	struct kfd_node *node = pm->dqm->dev;
-	struct device *dev = node->adev->dev;
-
-	process_count = pm->dqm->processes_count;
-	queue_count = pm->dqm->active_queue_count;
-	compute_queue_count = pm->dqm->active_cp_queue_count;
-	gws_queue_count = pm->dqm->gws_queue_count;
 
-	/* check if there is over subscription
-	 * Note: the arbitration between the number of VMIDs and
+	/* Note: the arbitration between the number of VMIDs and
 	 * hws_max_conc_proc has been done in
 	 * kgd2kfd_device_init().
 	 */
-	*over_subscription = false;
-
 	if (node->max_proc_per_quantum > 1)
 		max_proc_per_quantum = node->max_proc_per_quantum;
 
-	if ((process_count > max_proc_per_quantum) ||
-	    compute_queue_count > get_cp_queues_num(pm->dqm) ||
-	    gws_queue_count > 1) {
-		*over_subscription = true;
+	return process_count > max_proc_per_quantum ||
+	       compute_queue_count > get_cp_queues_num(pm->dqm) ||
+	       pm->dqm->gws_queue_count > 1;
+}
+
+/* Whether a runlist of all active queues would be over subscribed */
+bool pm_is_over_subscribed(struct packet_manager *pm)
+{
+	return pm_over_subscription(pm, pm->dqm->processes_count,
+				    pm->dqm->active_cp_queue_count);
+}
+
+static void pm_calc_rlib_size(struct packet_manager *pm,
+				unsigned int *rlib_size,
+				bool *over_subscription)
+{
+	unsigned int process_count, queue_count, compute_queue_count;
+	unsigned int map_queue_size;
+	struct kfd_node *node = pm->dqm->dev;
+	struct device *dev = node->adev->dev;
+
+	/* Processes and queues left out of the runlist while idle */
+	process_count = pm->dqm->processes_count -
+			pm->dqm->runlist_skip_processes;
+	queue_count = pm->dqm->active_queue_count -
+		      pm->dqm->runlist_skip_queues;
+	compute_queue_count = pm->dqm->active_cp_queue_count -
+			      pm->dqm->runlist_skip_cp_queues;
+
+	/* check if there is over subscription */
+	*over_subscription = pm_over_subscription(pm, process_count,
+						  compute_queue_count);
+	if (*over_subscription)
 		dev_dbg(dev, "Over subscribed runlist\n");
-	}
 
 	map_queue_size = pm->pmf->map_queues_size;
 	/* calculate run list ib allocation size */
@@ -152,6 +169,9 @@ static int pm_create_runlist_ib(struct packet_manager *pm,
 	/* build the run list ib packet */
 	list_for_each_entry(cur, queues, list) {
 		qpd = cur->qpd;
+		if (qpd->runlist_skip)
+			continue;
+
 		/* build map process packet */
 		if (processes_mapped >= pm->dqm->processes_count) {
 			dev_dbg(dev, "Not enough space left in runlist IB\n");
@@ -188,7 +208,7 @@ static int pm_create_runlist_ib(struct packet_manager *pm,
 		}
 
 		list_for_each_entry(q, &qpd->queues_list, list) {
-			if (!q->properties.is_active)
+			if (!q->properties.is_active || q->runlist_skip)
 				continue;
 
 			dev_dbg(dev,
@@ -187,6 +187,9 @@ extern bool hws_gws_support;
 /* Queue preemption timeout in ms */
 extern int queue_preemption_timeout_ms;
 
+/* Interval in ms to sample queue activity and unmap idle queues at */
+extern int hws_idle_unmap_ms;
+
 /*
  * Don't evict process queues on vm fault
  */
@@ -614,6 +617,15 @@ struct queue {
 	void *gang_ctx_cpu_ptr;
 
 	struct amdgpu_bo *wptr_bo_gart;
+
+	/* HWS runlist policy and statistics, see hws_idle_unmap_ms */
+	bool runlist_skip;
+	unsigned int idle_samples;
+	uint64_t last_wptr;
+	ktime_t last_sample;
+	ktime_t mapped_since;
+	uint64_t mapped_ns;
+	uint64_t runnable_ns;
 };
 
 enum KFD_MQD_TYPE {
@@ -659,6 +671,8 @@ struct qcm_process_device {
 	unsigned int vmid;
 	bool is_debug;
 	unsigned int evicted; /* eviction counter, 0=active */
+	/* all active queues are idle and left out of the runlist */
+	bool runlist_skip;
 
 	/* This flag tells if we should reset all wavefronts on
 	 * process termination
@@ -865,7 +879,9 @@ struct svm_range_list {
 	atomic_t			drain_pagefaults;
 	struct delayed_work		restore_work;
 	DECLARE_BITMAP(bitmap_supported, MAX_GPU_INSTANCE);
-	struct task_struct		*faulting_task;
+	/* tasks inside hmm_range_fault, see svm_range_is_faulting_task */
+	struct list_head		faulting_tasks;
+	spinlock_t			faulting_lock;
 	/* check point ts decides if page fault recovery need be dropped */
 	uint64_t			checkpoint_ts[MAX_GPU_INSTANCE];
 
@@ -1439,6 +1455,7 @@ void pm_uninit(struct packet_manager *pm);
 int pm_send_set_resources(struct packet_manager *pm,
 				struct scheduling_resources *res);
 int pm_send_runlist(struct packet_manager *pm, struct list_head *dqm_queues);
+bool pm_is_over_subscribed(struct packet_manager *pm);
 int pm_send_query_status(struct packet_manager *pm, uint64_t fence_address,
 				uint64_t fence_value);
 
@@ -415,6 +415,16 @@ static ssize_t kfd_procfs_queue_show(struct kobject *kobj,
 		return snprintf(buffer, PAGE_SIZE, "%d", q->properties.type);
 	else if (!strcmp(attr->name, "gpuid"))
 		return snprintf(buffer, PAGE_SIZE, "%u", q->device->id);
+	else if (!strcmp(attr->name, "mapped_ms")) {
+		ktime_t since = READ_ONCE(q->mapped_since);
+		uint64_t ns = READ_ONCE(q->mapped_ns);
+
+		if (since)
+			ns += ktime_to_ns(ktime_sub(ktime_get(), since));
+		return snprintf(buffer, PAGE_SIZE, "%llu", div_u64(ns, NSEC_PER_MSEC));
+	} else if (!strcmp(attr->name, "runnable_ms"))
+		return snprintf(buffer, PAGE_SIZE, "%llu",
+				div_u64(READ_ONCE(q->runnable_ns), NSEC_PER_MSEC));
 	else
 		pr_err("Invalid attribute");
 
@@ -485,10 +495,24 @@ static struct attribute attr_queue_gpuid = {
 	.mode = KFD_SYSFS_FILE_MODE
 };
 
+/* Time spent in the HWS runlist */
+static struct attribute attr_queue_mapped_ms = {
+	.name = "mapped_ms",
+	.mode = KFD_SYSFS_FILE_MODE
+};
+
+/* Time with pending work, sampled every hws_idle_unmap_ms */
+static struct attribute attr_queue_runnable_ms = {
+	.name = "runnable_ms",
+	.mode = KFD_SYSFS_FILE_MODE
+};
+
 static struct attribute *procfs_queue_attrs[] = {
 	&attr_queue_size,
 	&attr_queue_type,
 	&attr_queue_gpuid,
+	&attr_queue_mapped_ms,
+	&attr_queue_runnable_ms,
 	NULL
 };
 ATTRIBUTE_GROUPS(procfs_queue);
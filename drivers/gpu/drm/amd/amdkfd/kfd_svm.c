@@ -49,6 +49,9 @@
  * page table is updated.
  */
 #define AMDGPU_SVM_RANGE_RETRY_FAULT_PENDING	(2UL * NSEC_PER_MSEC)
+
+/* Streaming faults grow the migration window up to 2^N times the granularity */
+#define SVM_RANGE_PREFETCH_MAX_ORDER	5
 #if IS_ENABLED(CONFIG_DYNAMIC_DEBUG)
 #define dynamic_svm_range_dump(svms) \
 	_dynamic_func_call_no_desc("svm_range_dump", svm_range_debug_dump, svms)
@@ -1384,6 +1387,7 @@ svm_range_map_to_gpu(struct kfd_process_device *pdd, struct svm_range *prange,
 {
 	struct amdgpu_device *adev = pdd->dev->adev;
 	struct amdgpu_vm *vm = drm_priv_to_vm(pdd->drm_priv);
+	struct amdgpu_vm_update_params params;
 	uint64_t pte_flags;
 	unsigned long last_start;
 	int last_domain;
@@ -1395,6 +1399,11 @@ svm_range_map_to_gpu(struct kfd_process_device *pdd, struct svm_range *prange,
 	pr_debug("svms 0x%p [0x%lx 0x%lx] readonly %d\n", prange->svms,
 		 last_start, last_start + npages - 1, readonly);
 
+	/* All the chunks of the range go into one page table update */
+	r = amdgpu_vm_update_begin(&params, adev, vm, false, false, NULL);
+	if (r)
+		return r;
+
 	for (i = offset; i < offset + npages; i++) {
 		last_domain = dma_addr[i] & SVM_RANGE_VRAM_DOMAIN;
 		dma_addr[i] &= ~SVM_RANGE_VRAM_DOMAIN;
@@ -1422,23 +1431,29 @@ svm_range_map_to_gpu(struct kfd_process_device *pdd, struct svm_range *prange,
 		 * different memory partition based on fpfn/lpfn, we should use
 		 * same vm_manager.vram_base_offset regardless memory partition.
 		 */
-		r = amdgpu_vm_update_range(adev, vm, false, false, flush_tlb, true,
-					   NULL, last_start, prange->start + i,
-					   pte_flags,
-					   (last_start - prange->start) << PAGE_SHIFT,
-					   bo_adev ? bo_adev->vm_manager.vram_base_offset : 0,
-					   NULL, dma_addr, &vm->last_update);
+		r = amdgpu_vm_update_add(&params, flush_tlb, true, last_start,
+					 prange->start + i, pte_flags,
+					 (last_start - prange->start) << PAGE_SHIFT,
+					 bo_adev ? bo_adev->vm_manager.vram_base_offset : 0,
+					 NULL, dma_addr);
 
 		for (j = last_start - prange->start; j <= i; j++)
 			dma_addr[j] |= last_domain;
 
 		if (r) {
 			pr_debug("failed %d to map to gpu 0x%lx\n", r, prange->start);
+			amdgpu_vm_update_abort(&params);
 			goto out;
 		}
 		last_start = prange->start + i + 1;
 	}
 
+	r = amdgpu_vm_update_commit(&params, &vm->last_update);
+	if (r) {
+		pr_debug("failed %d to map to gpu 0x%lx\n", r, prange->start);
+		goto out;
+	}
+
 	r = amdgpu_vm_update_pdes(adev, vm, false);
 	if (r) {
 		pr_debug("failed %d to update directories 0x%lx\n", r,
@@ -1585,11 +1600,43 @@ static void *kfd_svm_page_owner(struct kfd_process *p, int32_t gpuidx)
 	return SVM_ADEV_PGMAP_OWNER(pdd->dev->adev);
 }
 
+struct svm_faulting_task {
+	struct list_head list;
+	struct task_struct *task;
+};
+
+/**
+ * svm_range_is_faulting_task - check if current is getting pages of a range
+ * @svms: svm range list of the process
+ *
+ * hmm_range_fault may trigger a CPU fault on a VRAM page of a range whose
+ * migrate_mutex the task already holds. Faults of several GPUs are handled
+ * concurrently, so every task inside hmm_range_fault is tracked.
+ *
+ * Return: true if svm_migrate_to_ram must not migrate for current task
+ */
+bool svm_range_is_faulting_task(struct svm_range_list *svms)
+{
+	struct svm_faulting_task *ft;
+	bool found = false;
+
+	spin_lock(&svms->faulting_lock);
+	list_for_each_entry(ft, &svms->faulting_tasks, list) {
+		if (ft->task == current) {
+			found = true;
+			break;
+		}
+	}
+	spin_unlock(&svms->faulting_lock);
+
+	return found;
+}
+
 /*
  * Validation+GPU mapping with concurrent invalidation (MMU notifiers)
  *
  * To prevent concurrent destruction or change of range attributes, the
- * svm_read_lock must be held. The caller must not hold the svm_write_lock
+ * mmap read lock must be held, svms->lock is not needed. The caller must not hold the svm_write_lock
  * because that would block concurrent evictions and lead to deadlocks. To
  * serialize concurrent migrations or validations of the same range, the
  * prange->migrate_mutex must be held.
@@ -1707,15 +1754,21 @@ static int svm_range_validate_and_map(struct mm_struct *mm,
 
 		vma = vma_lookup(mm, addr);
 		if (vma) {
+			struct svm_faulting_task ft = { .task = current };
+
 			readonly = !(vma->vm_flags & VM_WRITE);
 
 			next = min(vma->vm_end, end);
 			npages = (next - addr) >> PAGE_SHIFT;
-			WRITE_ONCE(p->svms.faulting_task, current);
+			spin_lock(&p->svms.faulting_lock);
+			list_add(&ft.list, &p->svms.faulting_tasks);
+			spin_unlock(&p->svms.faulting_lock);
 			r = amdgpu_hmm_range_get_pages(&prange->notifier, addr, npages,
 						       readonly, owner, NULL,
 						       &hmm_range);
-			WRITE_ONCE(p->svms.faulting_task, NULL);
+			spin_lock(&p->svms.faulting_lock);
+			list_del(&ft.list);
+			spin_unlock(&p->svms.faulting_lock);
 			if (r)
 				pr_debug("failed %d to get svm range pages\n", r);
 		} else {
@@ -2642,6 +2695,37 @@ svm_range_from_addr(struct svm_range_list *svms, unsigned long addr,
 	return NULL;
 }
 
+/* svm_range_fault_window - decide the pages to restore for a GPU vm fault
+ * @prange: svm range structure, its migrate_mutex held
+ * @addr: faulting page
+ * @start: returns the first page to restore
+ * @last: returns the last page to restore
+ *
+ * Normally the granularity aligned block around @addr is restored. If the
+ * fault hits the block right after the window restored on the previous fault,
+ * the access is streaming through the range and the window is doubled, up to
+ * 2^SVM_RANGE_PREFETCH_MAX_ORDER blocks, so that fewer and larger migrations
+ * are done. Any other fault resets the window to a single block.
+ */
+static void
+svm_range_fault_window(struct svm_range *prange, unsigned long addr,
+		       unsigned long *start, unsigned long *last)
+{
+	unsigned long size = 1UL << prange->granularity;
+	unsigned long base = ALIGN_DOWN(addr, size);
+
+	if (prange->fault_next && base == prange->fault_next)
+		prange->fault_order = min_t(uint8_t, prange->fault_order + 1,
+					    SVM_RANGE_PREFETCH_MAX_ORDER);
+	else
+		prange->fault_order = 0;
+
+	*start = max_t(unsigned long, base, prange->start);
+	*last = min_t(unsigned long, base + (size << prange->fault_order) - 1,
+		      prange->last);
+	prange->fault_next = ALIGN(*last + 1, size);
+}
+
 /* svm_range_best_restore_location - decide the best fault restore location
  * @prange: svm range structure
  * @adev: the GPU on which vm fault happened
@@ -2950,7 +3034,7 @@ svm_range_restore_pages(struct amdgpu_device *adev, unsigned int pasid,
 			uint32_t vmid, uint32_t node_id,
 			uint64_t addr, uint64_t ts, bool write_fault)
 {
-	unsigned long start, last, size;
+	unsigned long start, last;
 	struct mm_struct *mm = NULL;
 	struct svm_range_list *svms;
 	struct svm_range *prange;
@@ -3049,9 +3133,10 @@ svm_range_restore_pages(struct amdgpu_device *adev, unsigned int pasid,
 		if (!prange) {
 			pr_debug("failed to create unregistered range svms 0x%p address [0x%llx]\n",
 				 svms, addr);
+			mutex_unlock(&svms->lock);
 			mmap_write_downgrade(mm);
 			r = -EFAULT;
-			goto out_unlock_svms;
+			goto out_unlock_mm;
 		}
 	}
 	if (write_locked)
@@ -3059,6 +3144,13 @@ svm_range_restore_pages(struct amdgpu_device *adev, unsigned int pasid,
 
 	mutex_lock(&prange->migrate_mutex);
 
+	/* Ranges are only added, split or removed with the mmap write lock
+	 * held, so the mmap read lock keeps prange alive, and migrate_mutex
+	 * serializes with other faults on it. Drop svms->lock to let faults
+	 * of other GPUs and on other ranges proceed in parallel.
+	 */
+	mutex_unlock(&svms->lock);
+
 	if (svm_range_skip_recover(prange)) {
 		amdgpu_gmc_filter_faults_remove(node->adev, addr, pasid);
 		r = 0;
@@ -3107,9 +3199,7 @@ svm_range_restore_pages(struct amdgpu_device *adev, unsigned int pasid,
 				       write_fault, timestamp);
 
 	/* Align migration range start and size to granularity size */
-	size = 1UL << prange->granularity;
-	start = max_t(unsigned long, ALIGN_DOWN(addr, size), prange->start);
-	last = min_t(unsigned long, ALIGN(addr + 1, size) - 1, prange->last);
+	svm_range_fault_window(prange, addr, &start, &last);
 	if (prange->actual_loc != 0 || best_loc != 0) {
 		if (best_loc) {
 			r = svm_migrate_to_vram(prange, best_loc, start, last,
@@ -3151,8 +3241,7 @@ svm_range_restore_pages(struct amdgpu_device *adev, unsigned int pasid,
 
 out_unlock_range:
 	mutex_unlock(&prange->migrate_mutex);
-out_unlock_svms:
-	mutex_unlock(&svms->lock);
+out_unlock_mm:
 	mmap_read_unlock(mm);
 
 	svm_range_count_fault(node, p, gpuidx);
@@ -3273,6 +3362,8 @@ int svm_range_list_init(struct kfd_process *p)
 	INIT_LIST_HEAD(&svms->deferred_range_list);
 	INIT_LIST_HEAD(&svms->criu_svm_metadata_list);
 	spin_lock_init(&svms->deferred_list_lock);
+	INIT_LIST_HEAD(&svms->faulting_tasks);
+	spin_lock_init(&svms->faulting_lock);
 
 	for (i = 0; i < p->n_pdds; i++)
 		if (KFD_IS_SVM_API_SUPPORTED(p->pdds[i]->dev->adev))
@@ -128,6 +128,9 @@ struct svm_range {
 	uint32_t			prefetch_loc;
 	uint32_t			actual_loc;
 	uint8_t				granularity;
+	/* streaming fault detection, see svm_range_fault_window() */
+	uint8_t				fault_order;
+	unsigned long			fault_next;
 	atomic_t			invalid;
 	ktime_t				validate_timestamp;
 	struct mmu_interval_notifier	notifier;
@@ -162,6 +165,7 @@ static inline struct svm_range_bo *svm_range_bo_ref(struct svm_range_bo *svm_bo)
 
 int svm_range_list_init(struct kfd_process *p);
 void svm_range_list_fini(struct kfd_process *p);
+bool svm_range_is_faulting_task(struct svm_range_list *svms);
 int svm_ioctl(struct kfd_process *p, enum kfd_ioctl_svm_op op, uint64_t start,
 	      uint64_t size, uint32_t nattrs,
 	      struct kfd_ioctl_svm_attribute *attrs);
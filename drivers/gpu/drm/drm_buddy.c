@@ -4,6 +4,7 @@
  */
 
 #include <linux/kmemleak.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/sizes.h>
 
@@ -38,23 +39,100 @@ static void drm_block_free(struct drm_buddy *mm,
 	kmem_cache_free(slab_blocks, block);
 }
 
-static void list_insert_sorted(struct drm_buddy *mm,
-			       struct drm_buddy_block *block)
+static inline enum drm_buddy_free_tree
+get_block_tree(struct drm_buddy_block *block)
 {
-	struct drm_buddy_block *node;
-	struct list_head *head;
+	return drm_buddy_block_is_clear(block) ?
+	       DRM_BUDDY_CLEAR_TREE : DRM_BUDDY_DIRTY_TREE;
+}
+
+static inline struct rb_root *
+get_root(struct drm_buddy *mm, unsigned int order,
+	 enum drm_buddy_free_tree tree)
+{
+	return &mm->free_trees[tree][order];
+}
+
+static inline struct drm_buddy_block *
+rbtree_get_free_block(const struct rb_node *node)
+{
+	return node ? rb_entry(node, struct drm_buddy_block, rb) : NULL;
+}
+
+static bool rbtree_block_offset_less(struct rb_node *block,
+				     const struct rb_node *node)
+{
+	return drm_buddy_block_offset(rbtree_get_free_block(block)) <
+	       drm_buddy_block_offset(rbtree_get_free_block(node));
+}
+
+/*
+ * The clear state of a block must not change while it is on a free tree, as
+ * it selects the tree the block is removed from.
+ */
+static void rbtree_insert(struct drm_buddy *mm,
+			  struct drm_buddy_block *block)
+{
+	rb_add(&block->rb,
+	       get_root(mm, drm_buddy_block_order(block),
+			get_block_tree(block)),
+	       rbtree_block_offset_less);
+}
 
-	head = &mm->free_list[drm_buddy_block_order(block)];
-	if (list_empty(head)) {
-		list_add(&block->link, head);
-		return;
+static void rbtree_remove(struct drm_buddy *mm,
+			  struct drm_buddy_block *block)
+{
+	rb_erase(&block->rb,
+		 get_root(mm, drm_buddy_block_order(block),
+			  get_block_tree(block)));
+	RB_CLEAR_NODE(&block->rb);
+}
+
+static inline struct drm_buddy_block *
+rbtree_last_entry(struct drm_buddy *mm, unsigned int order,
+		  enum drm_buddy_free_tree tree)
+{
+	return rbtree_get_free_block(rb_last(get_root(mm, order, tree)));
+}
+
+/* Return the free block of lowest offset at or above @offset */
+static struct drm_buddy_block *
+rbtree_find_from(struct rb_root *root, u64 offset)
+{
+	struct rb_node *node = root->rb_node;
+	struct drm_buddy_block *block, *found = NULL;
+
+	while (node) {
+		block = rbtree_get_free_block(node);
+		if (drm_buddy_block_offset(block) >= offset) {
+			found = block;
+			node = node->rb_left;
+		} else {
+			node = node->rb_right;
+		}
 	}
 
-	list_for_each_entry(node, head, link)
-		if (drm_buddy_block_offset(block) < drm_buddy_block_offset(node))
-			break;
+	return found;
+}
 
-	__list_add(&block->link, node->link.prev, &node->link);
+/* Return the free block of highest offset below @offset */
+static struct drm_buddy_block *
+rbtree_find_below(struct rb_root *root, u64 offset)
+{
+	struct rb_node *node = root->rb_node;
+	struct drm_buddy_block *block, *found = NULL;
+
+	while (node) {
+		block = rbtree_get_free_block(node);
+		if (drm_buddy_block_offset(block) < offset) {
+			found = block;
+			node = node->rb_right;
+		} else {
+			node = node->rb_left;
+		}
+	}
+
+	return found;
 }
 
 static void clear_reset(struct drm_buddy_block *block)
@@ -67,12 +145,13 @@ static void mark_cleared(struct drm_buddy_block *block)
 	block->header |= DRM_BUDDY_HEADER_CLEAR;
 }
 
-static void mark_allocated(struct drm_buddy_block *block)
+static void mark_allocated(struct drm_buddy *mm,
+			   struct drm_buddy_block *block)
 {
+	rbtree_remove(mm, block);
+
 	block->header &= ~DRM_BUDDY_HEADER_STATE;
 	block->header |= DRM_BUDDY_ALLOCATED;
-
-	list_del(&block->link);
 }
 
 static void mark_free(struct drm_buddy *mm,
@@ -81,15 +160,16 @@ static void mark_free(struct drm_buddy *mm,
 	block->header &= ~DRM_BUDDY_HEADER_STATE;
 	block->header |= DRM_BUDDY_FREE;
 
-	list_insert_sorted(mm, block);
+	rbtree_insert(mm, block);
 }
 
-static void mark_split(struct drm_buddy_block *block)
+static void mark_split(struct drm_buddy *mm,
+		       struct drm_buddy_block *block)
 {
+	rbtree_remove(mm, block);
+
 	block->header &= ~DRM_BUDDY_HEADER_STATE;
 	block->header |= DRM_BUDDY_SPLIT;
-
-	list_del(&block->link);
 }
 
 static inline bool overlaps(u64 s1, u64 e1, u64 s2, u64 e2)
@@ -145,7 +225,7 @@ static unsigned int __drm_buddy_free(struct drm_buddy *mm,
 				mark_cleared(parent);
 		}
 
-		list_del(&buddy->link);
+		rbtree_remove(mm, buddy);
 		if (force_merge && drm_buddy_block_is_clear(buddy))
 			mm->clear_avail -= drm_buddy_block_size(mm, buddy);
 
@@ -166,6 +246,7 @@ static int __force_merge(struct drm_buddy *mm,
 			 u64 end,
 			 unsigned int min_order)
 {
+	enum drm_buddy_free_tree tree;
 	unsigned int order;
 	int i;
 
@@ -176,43 +257,48 @@ static int __force_merge(struct drm_buddy *mm,
 		return -EINVAL;
 
 	for (i = min_order - 1; i >= 0; i--) {
-		struct drm_buddy_block *block, *prev;
+		for (tree = 0; tree < DRM_BUDDY_MAX_FREE_TREES; tree++) {
+			struct rb_node *iter = rb_last(get_root(mm, i, tree));
 
-		list_for_each_entry_safe_reverse(block, prev, &mm->free_list[i], link) {
-			struct drm_buddy_block *buddy;
-			u64 block_start, block_end;
+			while (iter) {
+				struct drm_buddy_block *block, *buddy;
+				u64 block_start, block_end;
 
-			if (!block->parent)
-				continue;
+				block = rbtree_get_free_block(iter);
+				iter = rb_prev(iter);
 
-			block_start = drm_buddy_block_offset(block);
-			block_end = block_start + drm_buddy_block_size(mm, block) - 1;
+				if (!block->parent)
+					continue;
 
-			if (!contains(start, end, block_start, block_end))
-				continue;
+				block_start = drm_buddy_block_offset(block);
+				block_end = block_start + drm_buddy_block_size(mm, block) - 1;
 
-			buddy = __get_buddy(block);
-			if (!drm_buddy_block_is_free(buddy))
-				continue;
+				if (!contains(start, end, block_start, block_end))
+					continue;
 
-			WARN_ON(drm_buddy_block_is_clear(block) ==
-				drm_buddy_block_is_clear(buddy));
+				buddy = __get_buddy(block);
+				if (!drm_buddy_block_is_free(buddy))
+					continue;
 
-			/*
-			 * If the prev block is same as buddy, don't access the
-			 * block in the next iteration as we would free the
-			 * buddy block as part of the free function.
-			 */
-			if (prev == buddy)
-				prev = list_prev_entry(prev, link);
+				WARN_ON(drm_buddy_block_is_clear(block) ==
+					drm_buddy_block_is_clear(buddy));
 
-			list_del(&block->link);
-			if (drm_buddy_block_is_clear(block))
-				mm->clear_avail -= drm_buddy_block_size(mm, block);
+				/*
+				 * If the prev block is same as buddy, don't access the
+				 * block in the next iteration as we would free the
+				 * buddy block as part of the free function.
+				 */
+				if (iter == &buddy->rb)
+					iter = rb_prev(iter);
 
-			order = __drm_buddy_free(mm, block, true);
-			if (order >= min_order)
-				return 0;
+				rbtree_remove(mm, block);
+				if (drm_buddy_block_is_clear(block))
+					mm->clear_avail -= drm_buddy_block_size(mm, block);
+
+				order = __drm_buddy_free(mm, block, true);
+				if (order >= min_order)
+					return 0;
+			}
 		}
 	}
 
@@ -233,7 +319,7 @@ static int __force_merge(struct drm_buddy *mm,
  */
 int drm_buddy_init(struct drm_buddy *mm, u64 size, u64 chunk_size)
 {
-	unsigned int i;
+	unsigned int i, j;
 	u64 offset;
 
 	if (size < chunk_size)
@@ -255,14 +341,16 @@ int drm_buddy_init(struct drm_buddy *mm, u64 size, u64 chunk_size)
 
 	BUG_ON(mm->max_order > DRM_BUDDY_MAX_ORDER);
 
-	mm->free_list = kmalloc_array(mm->max_order + 1,
-				      sizeof(struct list_head),
-				      GFP_KERNEL);
-	if (!mm->free_list)
-		return -ENOMEM;
+	for (i = 0; i < DRM_BUDDY_MAX_FREE_TREES; ++i) {
+		mm->free_trees[i] = kmalloc_array(mm->max_order + 1,
+						  sizeof(struct rb_root),
+						  GFP_KERNEL);
+		if (!mm->free_trees[i])
+			goto out_free_tree;
 
-	for (i = 0; i <= mm->max_order; ++i)
-		INIT_LIST_HEAD(&mm->free_list[i]);
+		for (j = 0; j <= mm->max_order; ++j)
+			mm->free_trees[i][j] = RB_ROOT;
+	}
 
 	mm->n_roots = hweight64(size);
 
@@ -270,7 +358,7 @@ int drm_buddy_init(struct drm_buddy *mm, u64 size, u64 chunk_size)
 				  sizeof(struct drm_buddy_block *),
 				  GFP_KERNEL);
 	if (!mm->roots)
-		goto out_free_list;
+		goto out_free_tree;
 
 	offset = 0;
 	i = 0;
@@ -309,8 +397,9 @@ int drm_buddy_init(struct drm_buddy *mm, u64 size, u64 chunk_size)
 	while (i--)
 		drm_block_free(mm, mm->roots[i]);
 	kfree(mm->roots);
-out_free_list:
-	kfree(mm->free_list);
+out_free_tree:
+	for (i = 0; i < DRM_BUDDY_MAX_FREE_TREES; ++i)
+		kfree(mm->free_trees[i]);
 	return -ENOMEM;
 }
 EXPORT_SYMBOL(drm_buddy_init);
@@ -344,7 +433,8 @@ void drm_buddy_fini(struct drm_buddy *mm)
 	WARN_ON(mm->avail != mm->size);
 
 	kfree(mm->roots);
-	kfree(mm->free_list);
+	for (i = 0; i < DRM_BUDDY_MAX_FREE_TREES; ++i)
+		kfree(mm->free_trees[i]);
 }
 EXPORT_SYMBOL(drm_buddy_fini);
 
@@ -368,16 +458,16 @@ static int split_block(struct drm_buddy *mm,
 		return -ENOMEM;
 	}
 
-	mark_free(mm, block->left);
-	mark_free(mm, block->right);
-
 	if (drm_buddy_block_is_clear(block)) {
 		mark_cleared(block->left);
 		mark_cleared(block->right);
-		clear_reset(block);
 	}
 
-	mark_split(block);
+	mark_free(mm, block->left);
+	mark_free(mm, block->right);
+
+	mark_split(mm, block);
+	clear_reset(block);
 
 	return 0;
 }
@@ -465,11 +555,47 @@ void drm_buddy_free_list(struct drm_buddy *mm,
 }
 EXPORT_SYMBOL(drm_buddy_free_list);
 
-static bool block_incompatible(struct drm_buddy_block *block, unsigned int flags)
+/* Whether @block has a naturally aligned @req_size chunk in [@start, @end] */
+static bool block_fits_range(struct drm_buddy *mm,
+			     struct drm_buddy_block *block,
+			     u64 start, u64 end, u64 req_size)
 {
-	bool needs_clear = flags & DRM_BUDDY_CLEAR_ALLOCATION;
+	u64 block_start = drm_buddy_block_offset(block);
+	u64 block_end = block_start + drm_buddy_block_size(mm, block) - 1;
+	u64 adjusted_start = max(block_start, start);
+	u64 adjusted_end = min(block_end, end);
+
+	if (adjusted_start > adjusted_end)
+		return false;
+
+	return round_down(adjusted_end + 1, req_size) >
+	       round_up(adjusted_start, req_size);
+}
+
+/*
+ * Return the free block of lowest offset in @root which has room for @req_size
+ * in [@start, @end]. Only the blocks straddling @start or @end can fail to
+ * fit, so this looks at no more than a few blocks after the tree search.
+ */
+static struct drm_buddy_block *
+find_block_in_range(struct drm_buddy *mm, struct rb_root *root,
+		    unsigned int order, u64 start, u64 end, u64 req_size)
+{
+	u64 block_size = mm->chunk_size << order;
+	struct drm_buddy_block *block;
+	struct rb_node *node;
+
+	block = rbtree_find_from(root, round_down(start, block_size));
+	for (node = block ? &block->rb : NULL; node; node = rb_next(node)) {
+		block = rbtree_get_free_block(node);
+		if (drm_buddy_block_offset(block) > end)
+			break;
 
-	return needs_clear != drm_buddy_block_is_clear(block);
+		if (block_fits_range(mm, block, start, end, req_size))
+			return block;
+	}
+
+	return NULL;
 }
 
 static struct drm_buddy_block *
@@ -479,76 +605,51 @@ __alloc_range_bias(struct drm_buddy *mm,
 		   unsigned long flags,
 		   bool fallback)
 {
+	enum drm_buddy_free_tree want = (flags & DRM_BUDDY_CLEAR_ALLOCATION) ?
+		DRM_BUDDY_CLEAR_TREE : DRM_BUDDY_DIRTY_TREE;
 	u64 req_size = mm->chunk_size << order;
-	struct drm_buddy_block *block;
+	struct drm_buddy_block *block = NULL;
 	struct drm_buddy_block *buddy;
-	LIST_HEAD(dfs);
+	enum drm_buddy_free_tree tree;
+	unsigned int i;
 	int err;
-	int i;
 
 	end = end - 1;
 
-	for (i = 0; i < mm->n_roots; ++i)
-		list_add_tail(&mm->roots[i]->tmp_link, &dfs);
-
-	do {
-		u64 block_start;
-		u64 block_end;
-
-		block = list_first_entry_or_null(&dfs,
-						 struct drm_buddy_block,
-						 tmp_link);
-		if (!block)
-			break;
-
-		list_del(&block->tmp_link);
-
-		if (drm_buddy_block_order(block) < order)
-			continue;
-
-		block_start = drm_buddy_block_offset(block);
-		block_end = block_start + drm_buddy_block_size(mm, block) - 1;
-
-		if (!overlaps(start, end, block_start, block_end))
-			continue;
-
-		if (drm_buddy_block_is_allocated(block))
-			continue;
-
-		if (block_start < start || block_end > end) {
-			u64 adjusted_start = max(block_start, start);
-			u64 adjusted_end = min(block_end, end);
+	/*
+	 * Take the smallest free block with room for the request, to split as
+	 * little as possible, and at the lowest offset among those.
+	 */
+	for (i = order; i <= mm->max_order && !block; ++i) {
+		for (tree = 0; tree < DRM_BUDDY_MAX_FREE_TREES; tree++) {
+			struct drm_buddy_block *tmp;
 
-			if (round_down(adjusted_end + 1, req_size) <=
-			    round_up(adjusted_start, req_size))
+			if (!fallback && tree != want)
 				continue;
-		}
 
-		if (!fallback && block_incompatible(block, flags))
-			continue;
-
-		if (contains(start, end, block_start, block_end) &&
-		    order == drm_buddy_block_order(block)) {
-			/*
-			 * Find the free block within the range.
-			 */
-			if (drm_buddy_block_is_free(block))
-				return block;
-
-			continue;
+			tmp = find_block_in_range(mm, get_root(mm, i, tree), i,
+						  start, end, req_size);
+			if (tmp && (!block || drm_buddy_block_offset(tmp) <
+					      drm_buddy_block_offset(block)))
+				block = tmp;
 		}
+	}
 
-		if (!drm_buddy_block_is_split(block)) {
-			err = split_block(mm, block);
-			if (unlikely(err))
-				goto err_undo;
-		}
+	if (!block)
+		return ERR_PTR(-ENOSPC);
 
-		list_add(&block->right->tmp_link, &dfs);
-		list_add(&block->left->tmp_link, &dfs);
-	} while (1);
+	while (drm_buddy_block_order(block) > order) {
+		err = split_block(mm, block);
+		if (unlikely(err))
+			goto err_undo;
 
-	return ERR_PTR(-ENOSPC);
+		if (block_fits_range(mm, block->left, start, end, req_size))
+			block = block->left;
+		else
+			block = block->right;
+	}
+
+	return block;
 
 err_undo:
 	/*
@@ -559,8 +660,10 @@ __alloc_range_bias(struct drm_buddy *mm,
 	buddy = __get_buddy(block);
 	if (buddy &&
 	    (drm_buddy_block_is_free(block) &&
-	     drm_buddy_block_is_free(buddy)))
+	     drm_buddy_block_is_free(buddy))) {
+		rbtree_remove(mm, block);
 		__drm_buddy_free(mm, block, false);
+	}
 	return ERR_PTR(err);
 }
 
@@ -584,34 +687,20 @@ __drm_buddy_alloc_range_bias(struct drm_buddy *mm,
 
 static struct drm_buddy_block *
 get_maxblock(struct drm_buddy *mm, unsigned int order,
-	     unsigned long flags)
+	     enum drm_buddy_free_tree tree)
 {
-	struct drm_buddy_block *max_block = NULL, *block = NULL;
+	struct drm_buddy_block *max_block = NULL, *block;
 	unsigned int i;
 
 	for (i = order; i <= mm->max_order; ++i) {
-		struct drm_buddy_block *tmp_block;
-
-		list_for_each_entry_reverse(tmp_block, &mm->free_list[i], link) {
-			if (block_incompatible(tmp_block, flags))
-				continue;
-
-			block = tmp_block;
-			break;
-		}
-
+		block = rbtree_last_entry(mm, i, tree);
 		if (!block)
 			continue;
 
-		if (!max_block) {
-			max_block = block;
-			continue;
-		}
-
-		if (drm_buddy_block_offset(block) >
-		    drm_buddy_block_offset(max_block)) {
+		if (!max_block ||
+		    drm_buddy_block_offset(block) >
+		    drm_buddy_block_offset(max_block))
 			max_block = block;
-		}
 	}
 
 	return max_block;
@@ -622,27 +711,21 @@ alloc_from_freelist(struct drm_buddy *mm,
 		    unsigned int order,
 		    unsigned long flags)
 {
+	enum drm_buddy_free_tree tree = (flags & DRM_BUDDY_CLEAR_ALLOCATION) ?
+		DRM_BUDDY_CLEAR_TREE : DRM_BUDDY_DIRTY_TREE;
 	struct drm_buddy_block *block = NULL;
 	unsigned int tmp;
 	int err;
 
 	if (flags & DRM_BUDDY_TOPDOWN_ALLOCATION) {
-		block = get_maxblock(mm, order, flags);
+		block = get_maxblock(mm, order, tree);
 		if (block)
 			/* Store the obtained block order */
 			tmp = drm_buddy_block_order(block);
 	} else {
 		for (tmp = order; tmp <= mm->max_order; ++tmp) {
-			struct drm_buddy_block *tmp_block;
-
-			list_for_each_entry_reverse(tmp_block, &mm->free_list[tmp], link) {
-				if (block_incompatible(tmp_block, flags))
-					continue;
-
-				block = tmp_block;
-				break;
-			}
-
+			/* Get RHS tree block */
+			block = rbtree_last_entry(mm, tmp, tree);
 			if (block)
 				break;
 		}
@@ -650,14 +733,13 @@ alloc_from_freelist(struct drm_buddy *mm,
 
 	if (!block) {
 		/* Fallback method */
+		tree = (tree == DRM_BUDDY_CLEAR_TREE) ?
+			DRM_BUDDY_DIRTY_TREE : DRM_BUDDY_CLEAR_TREE;
+
 		for (tmp = order; tmp <= mm->max_order; ++tmp) {
-			if (!list_empty(&mm->free_list[tmp])) {
-				block = list_last_entry(&mm->free_list[tmp],
-							struct drm_buddy_block,
-							link);
-				if (block)
-					break;
-			}
+			block = rbtree_last_entry(mm, tmp, tree);
+			if (block)
+				break;
 		}
 
 		if (!block)
@@ -677,8 +759,10 @@ alloc_from_freelist(struct drm_buddy *mm,
 	return block;
 
 err_undo:
-	if (tmp != order)
+	if (tmp != order) {
+		rbtree_remove(mm, block);
 		__drm_buddy_free(mm, block, false);
+	}
 	return ERR_PTR(err);
 }
 
@@ -722,7 +806,7 @@ static int __alloc_range(struct drm_buddy *mm,
 
 		if (contains(start, end, block_start, block_end)) {
 			if (drm_buddy_block_is_free(block)) {
-				mark_allocated(block);
+				mark_allocated(mm, block);
 				total_allocated += drm_buddy_block_size(mm, block);
 				mm->avail -= drm_buddy_block_size(mm, block);
 				if (drm_buddy_block_is_clear(block))
@@ -763,8 +847,10 @@ static int __alloc_range(struct drm_buddy *mm,
 	buddy = __get_buddy(block);
 	if (buddy &&
 	    (drm_buddy_block_is_free(block) &&
-	     drm_buddy_block_is_free(buddy)))
+	     drm_buddy_block_is_free(buddy))) {
+		rbtree_remove(mm, block);
 		__drm_buddy_free(mm, block, false);
+	}
 
 err_free:
 	if (err == -ENOSPC && total_allocated_on_err) {
@@ -799,8 +885,8 @@ static int __alloc_contig_try_harder(struct drm_buddy *mm,
 				     struct list_head *blocks)
 {
 	u64 rhs_offset, lhs_offset, lhs_size, filled;
+	enum drm_buddy_free_tree tree;
 	struct drm_buddy_block *block;
-	struct list_head *list;
 	LIST_HEAD(blocks_lhs);
 	unsigned long pages;
 	unsigned int order;
@@ -813,11 +899,25 @@ static int __alloc_contig_try_harder(struct drm_buddy *mm,
 	if (order == 0)
 		return -ENOSPC;
 
-	list = &mm->free_list[order];
-	if (list_empty(list))
-		return -ENOSPC;
+	/*
+	 * Try the free blocks of the order from the top down, in both clear
+	 * states. They are looked up again after each attempt, as failed
+	 * attempts split and merge blocks.
+	 */
+	for (rhs_offset = U64_MAX; ; ) {
+		block = NULL;
+		for (tree = 0; tree < DRM_BUDDY_MAX_FREE_TREES; tree++) {
+			struct drm_buddy_block *tmp;
+
+			tmp = rbtree_find_below(get_root(mm, order, tree),
+						rhs_offset);
+			if (tmp && (!block || drm_buddy_block_offset(tmp) >
+					      drm_buddy_block_offset(block)))
+				block = tmp;
+		}
+		if (!block)
+			break;
 
-	list_for_each_entry_reverse(block, list, link) {
 		/* Allocate blocks traversing RHS */
 		rhs_offset = drm_buddy_block_offset(block);
 		err =  __drm_buddy_alloc_range(mm, rhs_offset, size,
@@ -830,7 +930,7 @@ static int __alloc_contig_try_harder(struct drm_buddy *mm,
 			lhs_size = round_up(lhs_size, min_block_size);
 
 		/* Allocate blocks traversing LHS */
-		lhs_offset = drm_buddy_block_offset(block) - lhs_size;
+		lhs_offset = rhs_offset - lhs_size;
 		err =  __drm_buddy_alloc_range(mm, lhs_offset, lhs_size,
 					       NULL, &blocks_lhs);
 		if (!err) {
@@ -927,7 +1027,7 @@ int drm_buddy_block_trim(struct drm_buddy *mm,
 	list_add(&block->tmp_link, &dfs);
 	err =  __alloc_range(mm, &dfs, new_start, new_size, blocks, NULL);
 	if (err) {
-		mark_allocated(block);
+		mark_allocated(mm, block);
 		mm->avail -= drm_buddy_block_size(mm, block);
 		if (drm_buddy_block_is_clear(block))
 			mm->clear_avail -= drm_buddy_block_size(mm, block);
@@ -1071,7 +1171,7 @@ int drm_buddy_alloc_blocks(struct drm_buddy *mm,
 			}
 		} while (1);
 
-		mark_allocated(block);
+		mark_allocated(mm, block);
 		mm->avail -= drm_buddy_block_size(mm, block);
 		if (drm_buddy_block_is_clear(block))
 			mm->clear_avail -= drm_buddy_block_size(mm, block);
@@ -1120,6 +1220,176 @@ int drm_buddy_alloc_blocks(struct drm_buddy *mm,
 }
 EXPORT_SYMBOL(drm_buddy_alloc_blocks);
 
+/**
+ * drm_buddy_fragmentation - how unusable free memory is for an order
+ *
+ * @mm: DRM buddy manager
+ * @order: order of the allocation
+ *
+ * Returns:
+ * The share of the free memory, in thousandths, which is in blocks smaller
+ * than @order and so can't be used for an allocation of that order without
+ * moving allocated blocks away first.
+ */
+unsigned int drm_buddy_fragmentation(struct drm_buddy *mm, unsigned int order)
+{
+	enum drm_buddy_free_tree tree;
+	u64 unusable = 0;
+	unsigned int i;
+
+	if (!mm->avail)
+		return 0;
+
+	for (i = 0; i < min(order, mm->max_order + 1); ++i) {
+		for (tree = 0; tree < DRM_BUDDY_MAX_FREE_TREES; tree++) {
+			struct rb_node *iter;
+
+			for (iter = rb_first(get_root(mm, i, tree)); iter;
+			     iter = rb_next(iter))
+				unusable += mm->chunk_size << i;
+		}
+	}
+
+	return div64_u64(unusable * 1000, mm->avail);
+}
+EXPORT_SYMBOL(drm_buddy_fragmentation);
+
+/*
+ * Call @fn on the free blocks below @block, which is split or allocated.
+ * Returns the number of free bytes.
+ */
+static u64 for_each_free_below(struct drm_buddy *mm,
+			       struct drm_buddy_block *block,
+			       void (*fn)(struct drm_buddy *mm,
+					  struct drm_buddy_block *block,
+					  struct list_head *list),
+			       struct list_head *list)
+{
+	LIST_HEAD(dfs);
+	u64 free = 0;
+
+	list_add(&block->tmp_link, &dfs);
+	while ((block = list_first_entry_or_null(&dfs, struct drm_buddy_block,
+						 tmp_link))) {
+		list_del(&block->tmp_link);
+
+		if (drm_buddy_block_is_split(block)) {
+			list_add(&block->right->tmp_link, &dfs);
+			list_add(&block->left->tmp_link, &dfs);
+			continue;
+		}
+
+		if (drm_buddy_block_is_free(block)) {
+			free += drm_buddy_block_size(mm, block);
+			if (fn)
+				fn(mm, block, list);
+		}
+	}
+
+	return free;
+}
+
+static void reserve_free_block(struct drm_buddy *mm,
+			       struct drm_buddy_block *block,
+			       struct list_head *list)
+{
+	mark_allocated(mm, block);
+	mm->avail -= drm_buddy_block_size(mm, block);
+	if (drm_buddy_block_is_clear(block))
+		mm->clear_avail -= drm_buddy_block_size(mm, block);
+	list_add_tail(&block->link, list);
+}
+
+/**
+ * drm_buddy_compact_begin - start freeing up a block of an order
+ *
+ * @mm: DRM buddy manager
+ * @order: order of the block to free up
+ * @cc: compaction state to initialize
+ *
+ * Picks the naturally aligned window of @order which has the most free memory
+ * and reserves that free memory, so that it isn't handed out again. The caller
+ * then relocates the allocations intersecting [@cc->start, @cc->start +
+ * @cc->size), e.g. by evicting the buffer objects using them, and finally
+ * calls drm_buddy_compact_end(). If all of them moved away, the window is
+ * free in one block afterwards.
+ *
+ * Like allocations, this must be called with the lock of the user held. The
+ * lock doesn't need to be held while the caller relocates.
+ *
+ * Returns:
+ * 0 on success, -EALREADY if a block of @order is free already, -ENOSPC if
+ * no window has free memory, or -EINVAL.
+ */
+int drm_buddy_compact_begin(struct drm_buddy *mm, unsigned int order,
+			    struct drm_buddy_compact *cc)
+{
+	struct drm_buddy_block *block, *best = NULL;
+	enum drm_buddy_free_tree tree;
+	u64 free, best_free = 0;
+	LIST_HEAD(dfs);
+	unsigned int i;
+
+	if (order > mm->max_order)
+		return -EINVAL;
+
+	for (i = order; i <= mm->max_order; ++i)
+		for (tree = 0; tree < DRM_BUDDY_MAX_FREE_TREES; tree++)
+			if (!RB_EMPTY_ROOT(get_root(mm, i, tree)))
+				return -EALREADY;
+
+	/* So all the blocks of @order or above are split or allocated */
+	for (i = 0; i < mm->n_roots; ++i)
+		if (drm_buddy_block_order(mm->roots[i]) >= order)
+			list_add_tail(&mm->roots[i]->tmp_link, &dfs);
+
+	while ((block = list_first_entry_or_null(&dfs, struct drm_buddy_block,
+						 tmp_link))) {
+		list_del(&block->tmp_link);
+
+		if (!drm_buddy_block_is_split(block))
+			continue;
+
+		if (drm_buddy_block_order(block) > order) {
+			list_add(&block->right->tmp_link, &dfs);
+			list_add(&block->left->tmp_link, &dfs);
+			continue;
+		}
+
+		free = for_each_free_below(mm, block, NULL, NULL);
+		if (free > best_free) {
+			best = block;
+			best_free = free;
+		}
+	}
+
+	if (!best)
+		return -ENOSPC;
+
+	cc->start = drm_buddy_block_offset(best);
+	cc->size = drm_buddy_block_size(mm, best);
+	INIT_LIST_HEAD(&cc->reserved);
+	for_each_free_below(mm, best, reserve_free_block, &cc->reserved);
+
+	return 0;
+}
+EXPORT_SYMBOL(drm_buddy_compact_begin);
+
+/**
+ * drm_buddy_compact_end - finish a compaction attempt
+ *
+ * @mm: DRM buddy manager
+ * @cc: compaction state from drm_buddy_compact_begin()
+ *
+ * Gives back the memory reserved by drm_buddy_compact_begin(), keeping its
+ * clear state.
+ */
+void drm_buddy_compact_end(struct drm_buddy *mm, struct drm_buddy_compact *cc)
+{
+	drm_buddy_free_list_internal(mm, &cc->reserved);
+}
+EXPORT_SYMBOL(drm_buddy_compact_end);
+
 /**
  * drm_buddy_block_print - print block information
  *
@@ -1152,12 +1422,17 @@ void drm_buddy_print(struct drm_buddy *mm, struct drm_printer *p)
 		   mm->chunk_size >> 10, mm->size >> 20, mm->avail >> 20, mm->clear_avail >> 20);
 
 	for (order = mm->max_order; order >= 0; order--) {
-		struct drm_buddy_block *block;
+		enum drm_buddy_free_tree tree;
 		u64 count = 0, free;
 
-		list_for_each_entry(block, &mm->free_list[order], link) {
-			BUG_ON(!drm_buddy_block_is_free(block));
-			count++;
+		for (tree = 0; tree < DRM_BUDDY_MAX_FREE_TREES; tree++) {
+			struct rb_node *iter;
+
+			for (iter = rb_first(get_root(mm, order, tree)); iter;
+			     iter = rb_next(iter)) {
+				BUG_ON(!drm_buddy_block_is_free(rbtree_get_free_block(iter)));
+				count++;
+			}
 		}
 
 		drm_printf(p, "order-%2d ", order);
@@ -1168,7 +1443,8 @@ void drm_buddy_print(struct drm_buddy *mm, struct drm_printer *p)
 		else
 			drm_printf(p, "free: %8llu MiB", free >> 20);
 
-		drm_printf(p, ", blocks: %llu\n", count);
+		drm_printf(p, ", blocks: %llu, fragmentation: %u\n", count,
+			   drm_buddy_fragmentation(mm, order));
 	}
 }
 EXPORT_SYMBOL(drm_buddy_print);
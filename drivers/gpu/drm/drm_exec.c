@@ -45,6 +45,16 @@
  *	drm_exec_fini(&exec);
  *
  * See struct dma_exec for more details.
+ *
+ * Submissions locking large, mostly identical sets of objects tend to run into
+ * the same contention each time. A &struct drm_exec_hint attached with
+ * drm_exec_set_hint() remembers the contended object across submissions, so
+ * that it is locked first the next time. &drm_exec.num_retries counts the
+ * times locking was restarted.
+ *
+ * With DRM_EXEC_IGNORE_DUPLICATES, objects sharing a dma_resv object which is
+ * already locked by this context, e.g. BOs private to a VM sharing the VM's
+ * reservation object, are skipped without touching the ww_mutex.
  */
 
 /* Dummy value used to initially enter the retry loop */
@@ -89,9 +99,24 @@ void drm_exec_init(struct drm_exec *exec, u32 flags, unsigned nr)
 	exec->num_objects = 0;
 	exec->contended = DRM_EXEC_DUMMY;
 	exec->prelocked = NULL;
+	exec->hint = NULL;
+	exec->num_retries = 0;
 }
 EXPORT_SYMBOL(drm_exec_init);
 
+/**
+ * drm_exec_hint_fini - finalize a drm_exec_hint object
+ * @hint: the drm_exec_hint object to finalize
+ *
+ * Drop the reference to the remembered contended object.
+ */
+void drm_exec_hint_fini(struct drm_exec_hint *hint)
+{
+	drm_gem_object_put(hint->obj);
+	hint->obj = NULL;
+}
+EXPORT_SYMBOL(drm_exec_hint_fini);
+
 /**
  * drm_exec_fini - finalize a drm_exec object
  * @exec: the drm_exec object to finalize
@@ -110,6 +135,54 @@ void drm_exec_fini(struct drm_exec *exec)
 }
 EXPORT_SYMBOL(drm_exec_fini);
 
+static int drm_exec_obj_locked(struct drm_exec *exec,
+			       struct drm_gem_object *obj);
+
+/*
+ * Lock the object contended during a previous use of the hint first. Nothing
+ * is locked yet, so this can't deadlock; on failure just go without it.
+ */
+static void drm_exec_lock_hint(struct drm_exec *exec)
+{
+	struct drm_gem_object *obj = exec->hint ? exec->hint->obj : NULL;
+	int ret;
+
+	if (!obj)
+		return;
+
+	if (exec->flags & DRM_EXEC_INTERRUPTIBLE_WAIT)
+		ret = dma_resv_lock_interruptible(obj->resv, &exec->ticket);
+	else
+		ret = dma_resv_lock(obj->resv, &exec->ticket);
+	if (ret)
+		return;
+
+	if (drm_exec_obj_locked(exec, obj)) {
+		dma_resv_unlock(obj->resv);
+		return;
+	}
+
+	drm_gem_object_get(obj);
+	exec->prelocked = obj;
+}
+
+/* Remember the contended object for the next user of the hint */
+static void drm_exec_update_hint(struct drm_exec *exec)
+{
+	struct drm_exec_hint *hint = exec->hint;
+
+	exec->num_retries++;
+	if (!hint)
+		return;
+
+	hint->contentions++;
+	if (hint->obj != exec->contended) {
+		drm_gem_object_get(exec->contended);
+		drm_gem_object_put(hint->obj);
+		hint->obj = exec->contended;
+	}
+}
+
 /**
  * drm_exec_cleanup - cleanup when contention is detected
  * @exec: the drm_exec object to cleanup
@@ -121,6 +194,12 @@ EXPORT_SYMBOL(drm_exec_fini);
 bool drm_exec_cleanup(struct drm_exec *exec)
 {
 	if (likely(!exec->contended)) {
+		/* Don't keep a prelocked object the driver didn't ask for */
+		if (unlikely(exec->prelocked)) {
+			drm_exec_unlock_obj(exec, exec->prelocked);
+			drm_gem_object_put(exec->prelocked);
+			exec->prelocked = NULL;
+		}
 		ww_acquire_done(&exec->ticket);
 		return false;
 	}
@@ -128,9 +207,11 @@ bool drm_exec_cleanup(struct drm_exec *exec)
 	if (likely(exec->contended == DRM_EXEC_DUMMY)) {
 		exec->contended = NULL;
 		ww_acquire_init(&exec->ticket, &reservation_ww_class);
+		drm_exec_lock_hint(exec);
 		return true;
 	}
 
+	drm_exec_update_hint(exec);
 	drm_exec_unlock_all(exec);
 	exec->num_objects = 0;
 	return true;
@@ -193,6 +274,28 @@ static int drm_exec_lock_contended(struct drm_exec *exec)
 	return ret;
 }
 
+/* Track @obj instead of the prelocked object sharing its reservation object */
+static void drm_exec_transfer_prelocked(struct drm_exec *exec,
+					struct drm_gem_object *obj)
+{
+	struct drm_gem_object *prelocked = exec->prelocked;
+	unsigned int i;
+
+	for (i = exec->num_objects; i--;) {
+		if (exec->objects[i] == prelocked) {
+			drm_gem_object_get(obj);
+			exec->objects[i] = obj;
+			/* the reference held by the array */
+			drm_gem_object_put(prelocked);
+			break;
+		}
+	}
+
+	/* the reference held by exec->prelocked */
+	drm_gem_object_put(prelocked);
+	exec->prelocked = NULL;
+}
+
 /**
  * drm_exec_lock_obj - lock a GEM object for use
  * @exec: the drm_exec object with the state
@@ -218,6 +321,21 @@ int drm_exec_lock_obj(struct drm_exec *exec, struct drm_gem_object *obj)
 		return 0;
 	}
 
+	/*
+	 * The prelocked object shares its reservation object with this one,
+	 * e.g. a hinted BO private to the same VM. Hand the lock over, so that
+	 * it's tracked as this object's and not dropped again in cleanup.
+	 */
+	if (unlikely(exec->prelocked && exec->prelocked->resv == obj->resv)) {
+		drm_exec_transfer_prelocked(exec, obj);
+		return 0;
+	}
+
+	/* Fast path for objects sharing an already locked reservation object */
+	if (exec->flags & DRM_EXEC_IGNORE_DUPLICATES &&
+	    dma_resv_locking_ctx(obj->resv) == &exec->ticket)
+		return 0;
+
 	if (exec->flags & DRM_EXEC_INTERRUPTIBLE_WAIT)
 		ret = dma_resv_lock_interruptible(obj->resv, &exec->ticket);
 	else
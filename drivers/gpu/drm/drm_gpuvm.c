@@ -29,6 +29,7 @@
 
 #include <linux/interval_tree_generic.h>
 #include <linux/mm.h>
+#include <linux/sort.h>
 
 /**
  * DOC: Overview
@@ -149,6 +150,15 @@
  * are only partically located within the given range, remap operations are
  * created such that those mappings are split up and re-mapped partically.
  *
+ * A VM_BIND array can be processed as a whole with drm_gpuvm_sm_batch(). It
+ * issues the same callbacks as calling drm_gpuvm_sm_map() and
+ * drm_gpuvm_sm_unmap() for each request in turn, except for requests whose
+ * range is entirely covered by a later request of the batch, e.g. an unmap
+ * followed by a map of the same range, since their effect would be undone
+ * anyway. In addition it collects the ranges of GPU VA space the callbacks
+ * changed and coalesces them, such that the driver can issue a single page
+ * table update job and a single TLB invalidation for the whole batch.
+ *
  * As an alternative to drm_gpuvm_sm_map() and drm_gpuvm_sm_unmap(),
  * drm_gpuvm_sm_map_ops_create() and drm_gpuvm_sm_unmap_ops_create() can be used
  * to directly obtain an instance of struct drm_gpuva_ops containing a list of
@@ -458,6 +468,16 @@
  * the corresponding lockdep checks are enabled. This is an optimization for
  * drivers which are capable of taking the corresponding &dma_resv locks and
  * hence do not require internal locking.
+ *
+ * Paths which must not wait for the VM lock, such as GPU page fault handlers
+ * racing with VM_BIND, can look up &drm_gpuva entries under rcu_read_lock()
+ * with drm_gpuva_find_rcu() and drm_gpuva_find_first_rcu() if the &drm_gpuvm
+ * was created with &DRM_GPUVM_RCU_LOOKUP. Those lookups may miss a mapping
+ * which is concurrently being remapped, so callers must be prepared to fall
+ * back to taking the VM lock or to retry. The &drm_gpuva found is only
+ * guaranteed to stay allocated until rcu_read_unlock(); its backing
+ * &drm_gem_object must be referenced with kref_get_unless_zero() before it is
+ * used outside of the RCU read side critical section.
  */
 
 /**
@@ -878,7 +898,7 @@ INTERVAL_TREE_DEFINE(struct drm_gpuva, rb.node, u64, rb.__subtree_last,
 		     drm_gpuva_it)
 
 static int __drm_gpuva_insert(struct drm_gpuvm *gpuvm,
-			      struct drm_gpuva *va);
+			      struct drm_gpuva *va, gfp_t gfp);
 static void __drm_gpuva_remove(struct drm_gpuva *va);
 
 static bool
@@ -1005,6 +1025,8 @@ drm_gpuvm_init(struct drm_gpuvm *gpuvm, const char *name,
 	gpuvm->rb.tree = RB_ROOT_CACHED;
 	INIT_LIST_HEAD(&gpuvm->rb.list);
 
+	mt_init_flags(&gpuvm->mt, MT_FLAGS_USE_RCU);
+
 	INIT_LIST_HEAD(&gpuvm->extobj.list);
 	spin_lock_init(&gpuvm->extobj.lock);
 
@@ -1025,14 +1047,21 @@ drm_gpuvm_init(struct drm_gpuvm *gpuvm, const char *name,
 	gpuvm->mm_start = start_offset;
 	gpuvm->mm_range = range;
 
+	/* The maple tree is indexed by unsigned long. */
+	if (drm_WARN_ON(drm, (flags & DRM_GPUVM_RCU_LOOKUP) &&
+			     start_offset + range - 1 > ULONG_MAX))
+		gpuvm->flags &= ~DRM_GPUVM_RCU_LOOKUP;
+
 	memset(&gpuvm->kernel_alloc_node, 0, sizeof(struct drm_gpuva));
 	if (reserve_range) {
 		gpuvm->kernel_alloc_node.va.addr = reserve_offset;
 		gpuvm->kernel_alloc_node.va.range = reserve_range;
 
+		/* drm_gpuvm_fini() expects the reserved node to be inserted */
 		if (likely(!drm_gpuvm_warn_check_overflow(gpuvm, reserve_offset,
 							  reserve_range)))
-			__drm_gpuva_insert(gpuvm, &gpuvm->kernel_alloc_node);
+			__drm_gpuva_insert(gpuvm, &gpuvm->kernel_alloc_node,
+					   GFP_KERNEL | __GFP_NOFAIL);
 	}
 }
 EXPORT_SYMBOL_GPL(drm_gpuvm_init);
@@ -1047,6 +1076,7 @@ drm_gpuvm_fini(struct drm_gpuvm *gpuvm)
 
 	drm_WARN(gpuvm->drm, !RB_EMPTY_ROOT(&gpuvm->rb.tree.rb_root),
 		 "GPUVA tree is not empty, potentially leaking memory.\n");
+	mtree_destroy(&gpuvm->mt);
 
 	drm_WARN(gpuvm->drm, !list_empty(&gpuvm->extobj.list),
 		 "Extobj list should be empty.\n");
@@ -1713,18 +1743,13 @@ drm_gpuvm_bo_evict(struct drm_gpuvm_bo *vm_bo, bool evict)
 }
 EXPORT_SYMBOL_GPL(drm_gpuvm_bo_evict);
 
-static int
-__drm_gpuva_insert(struct drm_gpuvm *gpuvm,
-		   struct drm_gpuva *va)
+static void
+__drm_gpuva_link_rb(struct drm_gpuvm *gpuvm,
+		    struct drm_gpuva *va)
 {
 	struct rb_node *node;
 	struct list_head *head;
 
-	if (drm_gpuva_it_iter_first(&gpuvm->rb.tree,
-				    GPUVA_START(va),
-				    GPUVA_LAST(va)))
-		return -EEXIST;
-
 	va->vm = gpuvm;
 
 	drm_gpuva_it_insert(va, &gpuvm->rb.tree);
@@ -1736,6 +1761,36 @@ __drm_gpuva_insert(struct drm_gpuvm *gpuvm,
 		head = &gpuvm->rb.list;
 
 	list_add(&va->rb.entry, head);
+}
+
+static void
+__drm_gpuva_unlink_rb(struct drm_gpuva *va)
+{
+	struct drm_gpuvm *gpuvm = va->vm;
+
+	drm_gpuva_it_remove(va, &gpuvm->rb.tree);
+	list_del_init(&va->rb.entry);
+}
+
+static int
+__drm_gpuva_insert(struct drm_gpuvm *gpuvm,
+		   struct drm_gpuva *va, gfp_t gfp)
+{
+	int ret;
+
+	if (drm_gpuva_it_iter_first(&gpuvm->rb.tree,
+				    GPUVA_START(va),
+				    GPUVA_LAST(va)))
+		return -EEXIST;
+
+	if (gpuvm->flags & DRM_GPUVM_RCU_LOOKUP) {
+		ret = mtree_insert_range(&gpuvm->mt, GPUVA_START(va),
+					 GPUVA_LAST(va), va, gfp);
+		if (ret)
+			return ret;
+	}
+
+	__drm_gpuva_link_rb(gpuvm, va);
 
 	return 0;
 }
@@ -1765,7 +1820,7 @@ drm_gpuva_insert(struct drm_gpuvm *gpuvm,
 	if (unlikely(!drm_gpuvm_range_valid(gpuvm, addr, range)))
 		return -EINVAL;
 
-	ret = __drm_gpuva_insert(gpuvm, va);
+	ret = __drm_gpuva_insert(gpuvm, va, GFP_KERNEL);
 	if (likely(!ret))
 		/* Take a reference of the GPUVM for the successfully inserted
 		 * drm_gpuva. We can't take the reference in
@@ -1781,8 +1836,12 @@ EXPORT_SYMBOL_GPL(drm_gpuva_insert);
 static void
 __drm_gpuva_remove(struct drm_gpuva *va)
 {
-	drm_gpuva_it_remove(va, &va->vm->rb.tree);
-	list_del_init(&va->rb.entry);
+	struct drm_gpuvm *gpuvm = va->vm;
+
+	if (gpuvm->flags & DRM_GPUVM_RCU_LOOKUP)
+		mtree_erase(&gpuvm->mt, GPUVA_START(va));
+
+	__drm_gpuva_unlink_rb(va);
 }
 
 /**
@@ -1926,6 +1985,63 @@ drm_gpuva_find(struct drm_gpuvm *gpuvm,
 }
 EXPORT_SYMBOL_GPL(drm_gpuva_find);
 
+/**
+ * drm_gpuva_find_first_rcu() - find the first &drm_gpuva in the given range
+ * without holding the VM lock
+ * @gpuvm: the &drm_gpuvm to search in, created with &DRM_GPUVM_RCU_LOOKUP
+ * @addr: the &drm_gpuvas address
+ * @range: the &drm_gpuvas range
+ *
+ * Must be called under rcu_read_lock(). The returned &drm_gpuva may already be
+ * removed from the &drm_gpuvm, but stays allocated until rcu_read_unlock().
+ *
+ * Returns: the first &drm_gpuva within the given range
+ */
+struct drm_gpuva *
+drm_gpuva_find_first_rcu(struct drm_gpuvm *gpuvm,
+			 u64 addr, u64 range)
+{
+	unsigned long index = addr;
+
+	RCU_LOCKDEP_WARN(!rcu_read_lock_held(),
+			 "drm_gpuva_find_first_rcu() needs rcu_read_lock()");
+
+	if (drm_WARN_ON_ONCE(gpuvm->drm,
+			     !(gpuvm->flags & DRM_GPUVM_RCU_LOOKUP)))
+		return NULL;
+
+	return mt_find(&gpuvm->mt, &index, addr + range - 1);
+}
+EXPORT_SYMBOL_GPL(drm_gpuva_find_first_rcu);
+
+/**
+ * drm_gpuva_find_rcu() - find a &drm_gpuva without holding the VM lock
+ * @gpuvm: the &drm_gpuvm to search in, created with &DRM_GPUVM_RCU_LOOKUP
+ * @addr: the &drm_gpuvas address
+ * @range: the &drm_gpuvas range
+ *
+ * Must be called under rcu_read_lock(), see drm_gpuva_find_first_rcu().
+ *
+ * Returns: the &drm_gpuva at a given &addr and with a given &range
+ */
+struct drm_gpuva *
+drm_gpuva_find_rcu(struct drm_gpuvm *gpuvm,
+		   u64 addr, u64 range)
+{
+	struct drm_gpuva *va;
+
+	va = drm_gpuva_find_first_rcu(gpuvm, addr, range);
+	if (!va)
+		return NULL;
+
+	if (READ_ONCE(va->va.addr) != addr ||
+	    READ_ONCE(va->va.range) != range)
+		return NULL;
+
+	return va;
+}
+EXPORT_SYMBOL_GPL(drm_gpuva_find_rcu);
+
 /**
  * drm_gpuva_find_prev() - find the &drm_gpuva before the given address
  * @gpuvm: the &drm_gpuvm to search in
@@ -1986,6 +2102,49 @@ drm_gpuvm_interval_empty(struct drm_gpuvm *gpuvm, u64 addr, u64 range)
 }
 EXPORT_SYMBOL_GPL(drm_gpuvm_interval_empty);
 
+/*
+ * Replace @va in the maple tree by @prev and @next, either of which may be
+ * NULL, and clear the part of its range that neither of them covers. On
+ * failure @va is restored over its whole range.
+ */
+static int
+drm_gpuva_remap_mt(struct drm_gpuvm *gpuvm, struct drm_gpuva *va,
+		   struct drm_gpuva *prev, struct drm_gpuva *next)
+{
+	u64 first = prev ? GPUVA_LAST(prev) + 1 : GPUVA_START(va);
+	u64 last = next ? GPUVA_START(next) - 1 : GPUVA_LAST(va);
+	int ret;
+
+	if (prev) {
+		ret = mtree_store_range(&gpuvm->mt, GPUVA_START(prev),
+					GPUVA_LAST(prev), prev, GFP_KERNEL);
+		if (ret)
+			goto err_restore;
+	}
+
+	if (next) {
+		ret = mtree_store_range(&gpuvm->mt, GPUVA_START(next),
+					GPUVA_LAST(next), next, GFP_KERNEL);
+		if (ret)
+			goto err_restore;
+	}
+
+	if (first <= last) {
+		ret = mtree_store_range(&gpuvm->mt, first, last, NULL,
+					GFP_KERNEL);
+		if (ret)
+			goto err_restore;
+	}
+
+	return 0;
+
+err_restore:
+	/* Storing over a range that got split can still need new nodes. */
+	mtree_store_range(&gpuvm->mt, GPUVA_START(va), GPUVA_LAST(va), va,
+			  GFP_KERNEL | __GFP_NOFAIL);
+	return ret;
+}
+
 /**
  * drm_gpuva_map() - helper to insert a &drm_gpuva according to a
  * &drm_gpuva_op_map
@@ -1994,14 +2153,18 @@ EXPORT_SYMBOL_GPL(drm_gpuvm_interval_empty);
  * @op: the &drm_gpuva_op_map to initialize @va with
  *
  * Initializes the @va from the @op and inserts it into the given @gpuvm.
+ *
+ * Returns: 0 on success, negative error code on failure. Only a &drm_gpuvm
+ * with &DRM_GPUVM_RCU_LOOKUP set can fail, with -ENOMEM, in which case @va
+ * was not inserted.
  */
-void
+int
 drm_gpuva_map(struct drm_gpuvm *gpuvm,
 	      struct drm_gpuva *va,
 	      struct drm_gpuva_op_map *op)
 {
 	drm_gpuva_init_from_op(va, op);
-	drm_gpuva_insert(gpuvm, va);
+	return drm_gpuva_insert(gpuvm, va);
 }
 EXPORT_SYMBOL_GPL(drm_gpuva_map);
 
@@ -2014,26 +2177,53 @@ EXPORT_SYMBOL_GPL(drm_gpuva_map);
  *
  * Removes the currently mapped &drm_gpuva and remaps it using @prev and/or
  * @next.
+ *
+ * Returns: 0 on success, negative error code on failure. Only a &drm_gpuvm
+ * with &DRM_GPUVM_RCU_LOOKUP set can fail, with -ENOMEM, in which case the
+ * &drm_gpuvm is left unchanged.
  */
-void
+int
 drm_gpuva_remap(struct drm_gpuva *prev,
 		struct drm_gpuva *next,
 		struct drm_gpuva_op_remap *op)
 {
 	struct drm_gpuva *va = op->unmap->va;
 	struct drm_gpuvm *gpuvm = va->vm;
+	int ret;
 
-	drm_gpuva_remove(va);
+	if (unlikely(va == &gpuvm->kernel_alloc_node)) {
+		drm_WARN(gpuvm->drm, 1,
+			 "Can't destroy kernel reserved node.\n");
+		return -EINVAL;
+	}
 
-	if (op->prev) {
+	if (op->prev)
 		drm_gpuva_init_from_op(prev, op->prev);
-		drm_gpuva_insert(gpuvm, prev);
+	if (op->next)
+		drm_gpuva_init_from_op(next, op->next);
+
+	/* Update the maple tree first, it is the only part that can fail. */
+	if (gpuvm->flags & DRM_GPUVM_RCU_LOOKUP) {
+		ret = drm_gpuva_remap_mt(gpuvm, va, op->prev ? prev : NULL,
+					 op->next ? next : NULL);
+		if (ret)
+			return ret;
+	}
+
+	__drm_gpuva_unlink_rb(va);
+	drm_gpuvm_put(gpuvm);
+
+	if (op->prev) {
+		__drm_gpuva_link_rb(gpuvm, prev);
+		drm_gpuvm_get(gpuvm);
 	}
 
 	if (op->next) {
-		drm_gpuva_init_from_op(next, op->next);
-		drm_gpuva_insert(gpuvm, next);
+		__drm_gpuva_link_rb(gpuvm, next);
+		drm_gpuvm_get(gpuvm);
 	}
+
+	return 0;
 }
 EXPORT_SYMBOL_GPL(drm_gpuva_remap);
 
@@ -2390,6 +2580,253 @@ drm_gpuvm_sm_unmap(struct drm_gpuvm *gpuvm, void *priv,
 }
 EXPORT_SYMBOL_GPL(drm_gpuvm_sm_unmap);
 
+struct drm_gpuvm_batch_args {
+	const struct drm_gpuvm_ops *fn;
+	void *priv;
+	struct drm_gpuvm_batch *batch;
+};
+
+static int
+drm_gpuvm_batch_add_range(struct drm_gpuvm_batch *batch,
+			  u64 addr, u64 range)
+{
+	struct drm_gpuvm_range *r;
+
+	if (!range)
+		return 0;
+
+	/* Extend the last range if the steps walk the VA space upwards. */
+	if (batch->num_ranges) {
+		r = &batch->ranges[batch->num_ranges - 1];
+		if (addr >= r->addr && addr <= r->addr + r->range) {
+			r->range = max(r->addr + r->range, addr + range) -
+				   r->addr;
+			return 0;
+		}
+	}
+
+	if (batch->num_ranges == batch->max_ranges) {
+		unsigned int max = max(2 * batch->max_ranges, 8U);
+
+		r = krealloc_array(batch->ranges, max, sizeof(*r), GFP_KERNEL);
+		if (!r)
+			return -ENOMEM;
+
+		batch->ranges = r;
+		batch->max_ranges = max;
+	}
+
+	r = &batch->ranges[batch->num_ranges++];
+	r->addr = addr;
+	r->range = range;
+
+	return 0;
+}
+
+/*
+ * Record the range a step changes before handing it to the driver, which may
+ * free the &drm_gpuva to unmap from within the callback.
+ */
+static int
+drm_gpuvm_batch_step(struct drm_gpuva_op *op, void *priv)
+{
+	struct drm_gpuvm_batch_args *args = priv;
+	const struct drm_gpuvm_ops *fn = args->fn;
+	u64 addr, range;
+	int ret;
+
+	switch (op->op) {
+	case DRM_GPUVA_OP_MAP:
+		addr = op->map.va.addr;
+		range = op->map.va.range;
+		break;
+	case DRM_GPUVA_OP_REMAP:
+		drm_gpuva_op_remap_to_unmap_range(&op->remap, &addr, &range);
+		break;
+	case DRM_GPUVA_OP_UNMAP:
+		addr = op->unmap.va->va.addr;
+		range = op->unmap.va->va.range;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	ret = drm_gpuvm_batch_add_range(args->batch, addr, range);
+	if (ret)
+		return ret;
+
+	switch (op->op) {
+	case DRM_GPUVA_OP_MAP:
+		return fn->sm_step_map(op, args->priv);
+	case DRM_GPUVA_OP_REMAP:
+		return fn->sm_step_remap(op, args->priv);
+	default:
+		return fn->sm_step_unmap(op, args->priv);
+	}
+}
+
+static const struct drm_gpuvm_ops gpuvm_batch_ops = {
+	.sm_step_map = drm_gpuvm_batch_step,
+	.sm_step_remap = drm_gpuvm_batch_step,
+	.sm_step_unmap = drm_gpuvm_batch_step,
+};
+
+static int
+drm_gpuvm_range_cmp(const void *a, const void *b)
+{
+	const struct drm_gpuvm_range *ra = a, *rb = b;
+
+	if (ra->addr < rb->addr)
+		return -1;
+
+	return ra->addr > rb->addr;
+}
+
+static void
+drm_gpuvm_batch_coalesce(struct drm_gpuvm_batch *batch)
+{
+	struct drm_gpuvm_range *r = batch->ranges;
+	unsigned int i, n = 0;
+
+	if (!batch->num_ranges)
+		return;
+
+	sort(r, batch->num_ranges, sizeof(*r), drm_gpuvm_range_cmp, NULL);
+
+	for (i = 1; i < batch->num_ranges; i++) {
+		u64 end = r[n].addr + r[n].range;
+
+		if (r[i].addr <= end)
+			r[n].range = max(end, r[i].addr + r[i].range) -
+				     r[n].addr;
+		else
+			r[++n] = r[i];
+	}
+
+	batch->num_ranges = n + 1;
+}
+
+/*
+ * A request whose range is covered by a later one has no effect on the final
+ * state of the VA space: whatever it maps or unmaps lies within its own range
+ * and is replaced or unmapped again by the later request, and the splits it
+ * causes at its boundaries are inside the later request's range as well.
+ */
+static bool
+drm_gpuvm_bind_superseded(const struct drm_gpuvm_bind_op *binds,
+			  unsigned int num_binds, unsigned int idx)
+{
+	u64 addr = binds[idx].addr;
+	u64 end = addr + binds[idx].range;
+	unsigned int i;
+
+	for (i = idx + 1; i < num_binds; i++) {
+		if (binds[i].addr <= addr &&
+		    binds[i].addr + binds[i].range >= end)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * drm_gpuvm_sm_batch() - creates the &drm_gpuva_op steps for a batch of binds
+ * @gpuvm: the &drm_gpuvm representing the GPU VA space
+ * @priv: pointer to a driver private data structure
+ * @binds: the array of map and unmap requests, processed in array order
+ * @num_binds: the number of entries in @binds
+ * @batch: the zero initialized &drm_gpuvm_batch to store the changed ranges in
+ *
+ * This function calls back into the driver through the &drm_gpuvm_ops the same
+ * way as calling drm_gpuvm_sm_map() or drm_gpuvm_sm_unmap() for each entry of
+ * @binds in turn would. Requests whose range is entirely covered by a later
+ * request are skipped, since the later request undoes their effect anyway.
+ *
+ * Since the requests may overlap each other, each request is split against
+ * the GPU VA space left behind by the previous ones. Therefore the driver must
+ * update the &drm_gpuvm's view of the GPU VA space right away within the
+ * callbacks, e.g. using drm_gpuva_map(), drm_gpuva_remap() and
+ * drm_gpuva_unmap(), while it may defer the actual page table updates.
+ *
+ * On return @batch contains the sorted and coalesced ranges of GPU VA space
+ * whose page table entries are changed by the steps, such that the driver can
+ * update the page tables with a single job and issue a single TLB
+ * invalidation covering them. The ranges remain valid until
+ * drm_gpuvm_batch_fini() is called.
+ *
+ * If an error is returned, the steps issued so far have been applied and must
+ * be unwound by the driver just like for a failing drm_gpuvm_sm_map().
+ *
+ * Returns: 0 on success or a negative error code
+ */
+int
+drm_gpuvm_sm_batch(struct drm_gpuvm *gpuvm, void *priv,
+		   const struct drm_gpuvm_bind_op *binds,
+		   unsigned int num_binds,
+		   struct drm_gpuvm_batch *batch)
+{
+	const struct drm_gpuvm_ops *ops = gpuvm->ops;
+	struct drm_gpuvm_batch_args args = {
+		.fn = ops,
+		.priv = priv,
+		.batch = batch,
+	};
+	unsigned int i;
+	int ret = 0;
+
+	if (unlikely(!(ops && ops->sm_step_map &&
+		       ops->sm_step_remap &&
+		       ops->sm_step_unmap)))
+		return -EINVAL;
+
+	for (i = 0; i < num_binds; i++) {
+		const struct drm_gpuvm_bind_op *b = &binds[i];
+
+		if (unlikely(b->op != DRM_GPUVA_OP_MAP &&
+			     b->op != DRM_GPUVA_OP_UNMAP))
+			return -EINVAL;
+
+		if (unlikely(!drm_gpuvm_range_valid(gpuvm, b->addr, b->range)))
+			return -EINVAL;
+	}
+
+	for (i = 0; i < num_binds; i++) {
+		const struct drm_gpuvm_bind_op *b = &binds[i];
+
+		if (drm_gpuvm_bind_superseded(binds, num_binds, i)) {
+			batch->num_skipped++;
+			continue;
+		}
+
+		if (b->op == DRM_GPUVA_OP_MAP)
+			ret = __drm_gpuvm_sm_map(gpuvm, &gpuvm_batch_ops, &args,
+						 b->addr, b->range,
+						 b->obj, b->offset);
+		else
+			ret = __drm_gpuvm_sm_unmap(gpuvm, &gpuvm_batch_ops,
+						   &args, b->addr, b->range);
+		if (ret)
+			break;
+	}
+
+	drm_gpuvm_batch_coalesce(batch);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(drm_gpuvm_sm_batch);
+
+/**
+ * drm_gpuvm_batch_fini() - release the ranges of a &drm_gpuvm_batch
+ * @batch: the &drm_gpuvm_batch filled in by drm_gpuvm_sm_batch()
+ */
+void
+drm_gpuvm_batch_fini(struct drm_gpuvm_batch *batch)
+{
+	kfree(batch->ranges);
+	memset(batch, 0, sizeof(*batch));
+}
+EXPORT_SYMBOL_GPL(drm_gpuvm_batch_fini);
+
 static struct drm_gpuva_op *
 gpuva_op_alloc(struct drm_gpuvm *gpuvm)
 {
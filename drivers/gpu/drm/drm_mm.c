@@ -678,6 +678,12 @@ EXPORT_SYMBOL(drm_mm_remove_node);
  * O(scanned_objects). So like the free stack which needs to be walked before a
  * scan operation even begins this is linear in the number of objects. It
  * doesn't seem to hurt too badly.
+ *
+ * On large, fragmented address spaces walking the LRU can add a great many
+ * objects before their holes happen to line up. drm_mm_scan_window() uses the
+ * hole size augmentation of the address tree to suggest the window of the
+ * scan range around its largest hole, whose nodes the driver can add first,
+ * e.g. using drm_mm_for_each_node_in_range(), before falling back to the LRU.
  */
 
 /**
@@ -917,6 +923,90 @@ struct drm_mm_node *drm_mm_scan_color_evict(struct drm_mm_scan *scan)
 }
 EXPORT_SYMBOL(drm_mm_scan_color_evict);
 
+/*
+ * Find the hole with the largest part within [start, end). Holes don't
+ * overlap, so all holes in the left subtree end before the node's hole starts
+ * and all holes in the right subtree start after it ends.
+ */
+static void largest_hole_in_range(struct rb_node *rb, u64 start, u64 end,
+				  struct drm_mm_node **best, u64 *best_size)
+{
+	while (rb) {
+		struct drm_mm_node *node = rb_hole_addr_to_node(rb);
+		u64 hole_start, hole_end;
+
+		if (node->subtree_max_hole <= *best_size)
+			return;
+
+		hole_start = __drm_mm_hole_node_start(node);
+		hole_end = hole_start + node->hole_size;
+
+		if (hole_start >= end) {
+			rb = rb->rb_left;
+			continue;
+		}
+
+		if (hole_end > start) {
+			u64 size = min(hole_end, end) - max(hole_start, start);
+
+			if (size > *best_size) {
+				*best = node;
+				*best_size = size;
+			}
+		}
+
+		if (hole_start > start)
+			largest_hole_in_range(rb->rb_left, start, end,
+					      best, best_size);
+		rb = rb->rb_right;
+	}
+}
+
+/**
+ * drm_mm_scan_window - suggest where to look for eviction candidates
+ * @scan: the initialized drm_mm scanner
+ * @start: returns the start of the window
+ * @end: returns the end of the window
+ *
+ * Find the largest hole within the scan range and return the window of the
+ * scan size, extended by the alignment, which covers it from the side the scan
+ * mode allocates from. Evicting the nodes overlapping this window is the least
+ * eviction needed to make room that can be found without looking at the
+ * individual nodes, so drivers should add them to the scan first. Only the
+ * holes, not the nodes, are visited, pruned by their size.
+ *
+ * Returns:
+ * True if a window was found, false if there's no hole in the scan range.
+ */
+bool drm_mm_scan_window(const struct drm_mm_scan *scan, u64 *start, u64 *end)
+{
+	u64 range_start = scan->range_start, range_end = scan->range_end;
+	u64 size = min(scan->size + scan->alignment, range_end - range_start);
+	struct drm_mm_node *best = NULL;
+	u64 best_size = 0;
+	u64 hole_start;
+
+	largest_hole_in_range(scan->mm->holes_addr.rb_node,
+			      range_start, range_end, &best, &best_size);
+	if (!best)
+		return false;
+
+	hole_start = __drm_mm_hole_node_start(best);
+	if (scan->mode == DRM_MM_INSERT_HIGH) {
+		*end = min(hole_start + best->hole_size, range_end);
+		if (*end - range_start < size)
+			*end = range_start + size;
+		*start = *end - size;
+	} else {
+		*start = max(hole_start, range_start);
+		*end = min(*start + size, range_end);
+		*start = *end - size;
+	}
+
+	return true;
+}
+EXPORT_SYMBOL(drm_mm_scan_window);
+
 /**
  * drm_mm_init - initialize a drm-mm allocator
  * @mm: the drm_mm structure to initialize
@@ -76,9 +76,13 @@ struct drm_i915_gem_object_ops {
 	 * example might have aync migrations going on, which don't use any
 	 * i915_vma to track the active GTT binding, and hence having an unbound
 	 * object might not be enough.
+	 *
+	 * I915_GEM_OBJECT_SHRINK_ASYNC - Only start the writeback, leaving it
+	 * to a worker rather than the reclaiming thread, if supported.
 	 */
 #define I915_GEM_OBJECT_SHRINK_WRITEBACK   BIT(0)
 #define I915_GEM_OBJECT_SHRINK_NO_GPU_WAIT BIT(1)
+#define I915_GEM_OBJECT_SHRINK_ASYNC       BIT(2)
 	int (*shrink)(struct drm_i915_gem_object *obj, unsigned int flags);
 
 	int (*pread)(struct drm_i915_gem_object *obj,
@@ -619,6 +623,14 @@ struct drm_i915_gem_object {
 		 */
 		bool ttm_shrinkable;
 
+		/**
+		 * @referenced: Set whenever the GPU uses the object, cleared
+		 * by the shrinker. A referenced object on the shrink list
+		 * gets a second pass around it before being reclaimed, so
+		 * the list ages like an active/inactive LRU.
+		 */
+		bool referenced;
+
 		/**
 		 * @unknown_state: Indicate that the object is effectively
 		 * borked. This is write-once and set if we somehow encounter a
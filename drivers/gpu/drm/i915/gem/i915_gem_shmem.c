@@ -4,6 +4,7 @@
  * Copyright © 2014-2016 Intel Corporation
  */
 
+#include <linux/file.h>
 #include <linux/pagevec.h>
 #include <linux/shmem_fs.h>
 #include <linux/swap.h>
@@ -342,9 +343,45 @@ void __shmem_writeback(size_t size, struct address_space *mapping)
 	}
 }
 
+struct shmem_writeback_work {
+	struct work_struct work;
+	struct file *filp;
+	size_t size;
+};
+
+static void shmem_writeback_work(struct work_struct *work)
+{
+	struct shmem_writeback_work *wb =
+		container_of(work, typeof(*wb), work);
+
+	__shmem_writeback(wb->size, wb->filp->f_mapping);
+	fput(wb->filp);
+	kfree(wb);
+}
+
 static void
-shmem_writeback(struct drm_i915_gem_object *obj)
+shmem_writeback(struct drm_i915_gem_object *obj, bool async)
 {
+	struct shmem_writeback_work *wb;
+
+	/*
+	 * Walking and writing out every page of a large object from direct
+	 * reclaim stalls whoever triggered it. The pages have already been
+	 * released by the object, so the writeback only needs the backing
+	 * file and can happen from a worker instead.
+	 */
+	if (async) {
+		wb = kmalloc(sizeof(*wb), GFP_NOWAIT | __GFP_NOWARN);
+		if (wb) {
+			INIT_WORK(&wb->work, shmem_writeback_work);
+			wb->filp = get_file(obj->base.filp);
+			wb->size = obj->base.size;
+			queue_work(to_i915(obj->base.dev)->unordered_wq,
+				   &wb->work);
+			return;
+		}
+	}
+
 	__shmem_writeback(obj->base.size, obj->base.filp->f_mapping);
 }
 
@@ -358,7 +395,7 @@ static int shmem_shrink(struct drm_i915_gem_object *obj, unsigned int flags)
 	}
 
 	if (flags & I915_GEM_OBJECT_SHRINK_WRITEBACK)
-		shmem_writeback(obj);
+		shmem_writeback(obj, flags & I915_GEM_OBJECT_SHRINK_ASYNC);
 
 	return 0;
 }
@@ -67,6 +67,9 @@ static int try_to_writeback(struct drm_i915_gem_object *obj, unsigned int flags)
 		if (flags & I915_SHRINK_WRITEBACK)
 			shrink_flags |= I915_GEM_OBJECT_SHRINK_WRITEBACK;
 
+		if (flags & I915_SHRINK_ASYNC)
+			shrink_flags |= I915_GEM_OBJECT_SHRINK_ASYNC;
+
 		return obj->ops->shrink(obj, shrink_flags);
 	}
 
@@ -209,6 +212,18 @@ i915_gem_shrink(struct i915_gem_ww_ctx *ww,
 			if (!can_release_pages(obj))
 				continue;
 
+			/*
+			 * Give recently used objects another trip around the
+			 * list, so that we reclaim the idle ones first. Purgeable
+			 * objects are fair game regardless.
+			 */
+			if (shrink & I915_SHRINK_AGE &&
+			    phase->list == &i915->mm.shrink_list &&
+			    READ_ONCE(obj->mm.referenced)) {
+				WRITE_ONCE(obj->mm.referenced, false);
+				continue;
+			}
+
 			if (!kref_get_unless_zero(&obj->base.refcount))
 				continue;
 
@@ -325,7 +340,8 @@ i915_gem_shrinker_scan(struct shrinker *shrinker, struct shrink_control *sc)
 				sc->nr_to_scan,
 				&sc->nr_scanned,
 				I915_SHRINK_BOUND |
-				I915_SHRINK_UNBOUND);
+				I915_SHRINK_UNBOUND |
+				I915_SHRINK_AGE);
 	if (sc->nr_scanned < sc->nr_to_scan && current_is_kswapd()) {
 		intel_wakeref_t wakeref;
 
@@ -336,7 +352,8 @@ i915_gem_shrinker_scan(struct shrinker *shrinker, struct shrink_control *sc)
 						 I915_SHRINK_ACTIVE |
 						 I915_SHRINK_BOUND |
 						 I915_SHRINK_UNBOUND |
-						 I915_SHRINK_WRITEBACK);
+						 I915_SHRINK_WRITEBACK |
+						 I915_SHRINK_ASYNC);
 		}
 	}
 
@@ -23,6 +23,8 @@ unsigned long i915_gem_shrink(struct i915_gem_ww_ctx *ww,
 #define I915_SHRINK_ACTIVE	BIT(2)
 #define I915_SHRINK_VMAPS	BIT(3)
 #define I915_SHRINK_WRITEBACK	BIT(4)
+#define I915_SHRINK_AGE		BIT(5)
+#define I915_SHRINK_ASYNC	BIT(6)
 
 unsigned long i915_gem_shrink_all(struct drm_i915_private *i915);
 void i915_gem_driver_register__shrinker(struct drm_i915_private *i915);
@@ -167,49 +167,25 @@ slist_add(struct llist_node *node, struct llist_node *head)
 	return node;
 }
 
-static void signal_irq_work(struct irq_work *work)
+/*
+ * Upper bound on the requests signaled by the kthread before it briefly
+ * reenables interrupts, keeping each irq-off stretch short.
+ */
+#define SIGNAL_BATCH 32
+
+static bool signal_contexts(struct intel_breadcrumbs *b,
+			    struct llist_node **signal,
+			    unsigned int per_context,
+			    unsigned int *budget)
 {
-	struct intel_breadcrumbs *b = container_of(work, typeof(*b), irq_work);
-	const ktime_t timestamp = ktime_get();
-	struct llist_node *signal, *sn;
 	struct intel_context *ce;
-
-	signal = NULL;
-	if (unlikely(!llist_empty(&b->signaled_requests)))
-		signal = llist_del_all(&b->signaled_requests);
-
-	/*
-	 * Keep the irq armed until the interrupt after all listeners are gone.
-	 *
-	 * Enabling/disabling the interrupt is rather costly, roughly a couple
-	 * of hundred microseconds. If we are proactive and enable/disable
-	 * the interrupt around every request that wants a breadcrumb, we
-	 * quickly drown in the extra orders of magnitude of latency imposed
-	 * on request submission.
-	 *
-	 * So we try to be lazy, and keep the interrupts enabled until no
-	 * more listeners appear within a breadcrumb interrupt interval (that
-	 * is until a request completes that no one cares about). The
-	 * observation is that listeners come in batches, and will often
-	 * listen to a bunch of requests in succession. Though note on icl+,
-	 * interrupts are always enabled due to concerns with rc6 being
-	 * dysfunctional with per-engine interrupt masking.
-	 *
-	 * We also try to avoid raising too many interrupts, as they may
-	 * be generated by userspace batches and it is unfortunately rather
-	 * too easy to drown the CPU under a flood of GPU interrupts. Thus
-	 * whenever no one appears to be listening, we turn off the interrupts.
-	 * Fewer interrupts should conserve power -- at the very least, fewer
-	 * interrupt draw less ire from other users of the system and tools
-	 * like powertop.
-	 */
-	if (!signal && READ_ONCE(b->irq_armed) && list_empty(&b->signalers))
-		intel_breadcrumbs_disarm_irq(b);
+	bool more = false;
 
 	rcu_read_lock();
 	atomic_inc(&b->signaler_active);
 	list_for_each_entry_rcu(ce, &b->signalers, signal_link) {
 		struct i915_request *rq;
+		unsigned int count = 0;
 
 		list_for_each_entry_rcu(rq, &ce->signals, signal_link) {
 			bool release;
@@ -217,6 +193,11 @@ static void signal_irq_work(struct irq_work *work)
 			if (!__i915_request_is_complete(rq))
 				break;
 
+			if (count == per_context || !*budget) {
+				more = true;
+				break;
+			}
+
 			if (!test_and_clear_bit(I915_FENCE_FLAG_SIGNAL,
 						&rq->fence.flags))
 				break;
@@ -238,14 +219,24 @@ static void signal_irq_work(struct irq_work *work)
 
 			if (__dma_fence_signal(&rq->fence))
 				/* We own signal_node now, xfer to local list */
-				signal = slist_add(&rq->signal_node, signal);
+				*signal = slist_add(&rq->signal_node, *signal);
 			else
 				i915_request_put(rq);
+
+			count++;
+			(*budget)--;
 		}
 	}
 	atomic_dec(&b->signaler_active);
 	rcu_read_unlock();
 
+	return more;
+}
+
+static void signal_requests(struct llist_node *signal, const ktime_t timestamp)
+{
+	struct llist_node *sn;
+
 	llist_for_each_safe(signal, sn, signal) {
 		struct i915_request *rq =
 			llist_entry(signal, typeof(*rq), signal_node);
@@ -262,6 +253,58 @@ static void signal_irq_work(struct irq_work *work)
 
 		i915_request_put(rq);
 	}
+}
+
+static void signal_irq_work(struct irq_work *work)
+{
+	struct intel_breadcrumbs *b = container_of(work, typeof(*b), irq_work);
+	const ktime_t timestamp = ktime_get();
+	unsigned int budget = UINT_MAX;
+	struct llist_node *signal;
+	bool more;
+
+	signal = NULL;
+	if (unlikely(!llist_empty(&b->signaled_requests)))
+		signal = llist_del_all(&b->signaled_requests);
+
+	/*
+	 * Keep the irq armed until the interrupt after all listeners are gone.
+	 *
+	 * Enabling/disabling the interrupt is rather costly, roughly a couple
+	 * of hundred microseconds. If we are proactive and enable/disable
+	 * the interrupt around every request that wants a breadcrumb, we
+	 * quickly drown in the extra orders of magnitude of latency imposed
+	 * on request submission.
+	 *
+	 * So we try to be lazy, and keep the interrupts enabled until no
+	 * more listeners appear within a breadcrumb interrupt interval (that
+	 * is until a request completes that no one cares about). The
+	 * observation is that listeners come in batches, and will often
+	 * listen to a bunch of requests in succession. Though note on icl+,
+	 * interrupts are always enabled due to concerns with rc6 being
+	 * dysfunctional with per-engine interrupt masking.
+	 *
+	 * We also try to avoid raising too many interrupts, as they may
+	 * be generated by userspace batches and it is unfortunately rather
+	 * too easy to drown the CPU under a flood of GPU interrupts. Thus
+	 * whenever no one appears to be listening, we turn off the interrupts.
+	 * Fewer interrupts should conserve power -- at the very least, fewer
+	 * interrupt draw less ire from other users of the system and tools
+	 * like powertop.
+	 */
+	if (!signal && READ_ONCE(b->irq_armed) && list_empty(&b->signalers))
+		intel_breadcrumbs_disarm_irq(b);
+
+	/*
+	 * With a signal worker, only the oldest completed request of each
+	 * context is signaled from the interrupt, so the first waiter sees
+	 * no extra latency; the backlog is left for the kthread.
+	 */
+	more = signal_contexts(b, &signal, b->signal_worker ? 1 : UINT_MAX,
+			       &budget);
+	signal_requests(signal, timestamp);
+	if (more)
+		kthread_queue_work(b->signal_worker, &b->signal_work);
 
 	/* Lazy irq enabling after HW submission */
 	if (!READ_ONCE(b->irq_armed) && !list_empty(&b->signalers))
@@ -272,6 +315,42 @@ static void signal_irq_work(struct irq_work *work)
 		intel_breadcrumbs_disarm_irq(b);
 }
 
+static void signal_kthread_work(struct kthread_work *work)
+{
+	struct intel_breadcrumbs *b = container_of(work, typeof(*b), signal_work);
+	bool more;
+
+	do {
+		unsigned int budget = SIGNAL_BATCH;
+		struct llist_node *signal = NULL;
+
+		local_irq_disable();
+		more = signal_contexts(b, &signal, UINT_MAX, &budget);
+		signal_requests(signal, ktime_get());
+		local_irq_enable();
+
+		cond_resched();
+	} while (more);
+}
+
+static void signal_worker_init(struct intel_breadcrumbs *b)
+{
+	struct intel_engine_cs *engine = b->irq_engine;
+	struct kthread_worker *worker;
+
+	kthread_init_work(&b->signal_work, signal_kthread_work);
+
+	if (!engine || !engine->i915->params.threaded_signal)
+		return;
+
+	worker = kthread_create_worker(0, "i915-signal/%s", engine->name);
+	if (IS_ERR(worker))
+		return; /* fall back to signaling everything from the irq */
+
+	sched_set_fifo(worker->task);
+	b->signal_worker = worker;
+}
+
 struct intel_breadcrumbs *
 intel_breadcrumbs_create(struct intel_engine_cs *irq_engine)
 {
@@ -294,6 +373,8 @@ intel_breadcrumbs_create(struct intel_engine_cs *irq_engine)
 	b->irq_enable = irq_enable;
 	b->irq_disable = irq_disable;
 
+	signal_worker_init(b);
+
 	return b;
 }
 
@@ -328,6 +409,8 @@ void intel_breadcrumbs_free(struct kref *kref)
 	struct intel_breadcrumbs *b = container_of(kref, typeof(*b), ref);
 
 	irq_work_sync(&b->irq_work);
+	if (b->signal_worker)
+		kthread_destroy_worker(b->signal_worker);
 	GEM_BUG_ON(!list_empty(&b->signalers));
 	GEM_BUG_ON(b->irq_armed);
 
@@ -8,6 +8,7 @@
 
 #include <linux/irq_work.h>
 #include <linux/kref.h>
+#include <linux/kthread.h>
 #include <linux/list.h>
 #include <linux/spinlock.h>
 #include <linux/types.h>
@@ -46,6 +47,10 @@ struct intel_breadcrumbs {
 	unsigned int irq_enabled;
 	intel_wakeref_t irq_armed;
 
+	/* Optional bottom-half for signaling beyond the first waiter */
+	struct kthread_worker *signal_worker;
+	struct kthread_work signal_work;
+
 	/* Not all breadcrumbs are attached to physical HW */
 	intel_engine_mask_t	engine_mask;
 	struct intel_engine_cs *irq_engine;
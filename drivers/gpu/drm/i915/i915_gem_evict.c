@@ -120,6 +120,49 @@ static bool defer_evict(struct i915_vma *vma)
 	return false;
 }
 
+/*
+ * Before walking the whole LRU, try the idle vmas around the largest hole in
+ * the range drm_mm suggests. On a large, fragmented GGTT this finds a hole
+ * after adding a handful of nodes, instead of however many the LRU takes
+ * until some of them happen to be neighbours.
+ */
+static bool
+mark_free_window(struct drm_mm_scan *scan,
+		 struct i915_gem_ww_ctx *ww,
+		 unsigned int flags,
+		 struct list_head *unwind)
+{
+	struct i915_vma *vma, *next;
+	struct drm_mm_node *node;
+	u64 start, end;
+
+	if (!drm_mm_scan_window(scan, &start, &end))
+		return false;
+
+	drm_mm_for_each_node_in_range(node, scan->mm, start, end) {
+		/* If we find any non-objects (!vma), we cannot evict them */
+		if (node->color == I915_COLOR_UNEVICTABLE)
+			break;
+
+		vma = container_of(node, typeof(*vma), node);
+		if (defer_evict(vma))
+			break;
+
+		if (mark_free(scan, ww, vma, flags, unwind))
+			return true;
+	}
+
+	list_for_each_entry_safe(vma, next, unwind, evict_link) {
+		bool ret = drm_mm_scan_remove_block(scan, &vma->node);
+
+		BUG_ON(ret);
+		ungrab_vma(vma);
+	}
+	INIT_LIST_HEAD(unwind);
+
+	return false;
+}
+
 /**
  * i915_gem_evict_something - Evict vmas to make room for binding a new one
  * @vm: address space to evict from
@@ -193,6 +236,10 @@ i915_gem_evict_something(struct i915_address_space *vm,
 		intel_gt_retire_requests(vm->gt);
 	}
 
+	INIT_LIST_HEAD(&eviction_list);
+	if (mark_free_window(&scan, ww, flags, &eviction_list))
+		goto found;
+
 search_again:
 	active = NULL;
 	INIT_LIST_HEAD(&eviction_list);
@@ -135,6 +135,11 @@ i915_param_named(enable_debug_only_api, bool, 0400,
 		 "Enable support for unstable debug only userspace API. (default:false)");
 #endif
 
+i915_param_named(threaded_signal, bool, 0400,
+	"Signal all but the first completed request of each context from a "
+	"per-engine kthread instead of the interrupt handler, bounding the "
+	"time spent with interrupts off (default: false)");
+
 static void _param_print_bool(struct drm_printer *p, const char *name,
 			      bool val)
 {
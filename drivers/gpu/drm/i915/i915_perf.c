@@ -69,7 +69,9 @@
  * pairs, instead of a fixed struct with multiple miscellaneous config members,
  * interleaved with event-type specific members.
  *
- * i915 perf doesn't support exposing metrics via an mmap'd circular buffer.
+ * i915 perf exposes metrics primarily through read() rather than an mmap'd
+ * circular buffer, though unfiltered OA streams may also be mapped read-only
+ * for privileged, low overhead sampling (see I915_PERF_IOCTL_BUF_PTRS).
  * The supported metrics are being written to memory by the GPU unsynchronized
  * with the CPU, using HW specific packing formats for counter sets. Sometimes
  * the constraints on HW configuration require reports to be filtered before it
@@ -219,6 +221,7 @@
 #include "i915_perf.h"
 #include "i915_perf_oa_regs.h"
 #include "i915_reg.h"
+#include "i915_scatterlist.h"
 
 /* HW requires this to be a power of two, between 128k and 16M, though driver
  * is currently generally designed assuming the largest 16M size is used such
@@ -700,6 +703,56 @@ static int append_oa_sample(struct i915_perf_stream *stream,
 	return 0;
 }
 
+static void gen8_consume_oa_report(struct i915_perf_stream *stream, u8 *report)
+{
+	int report_size = stream->oa_buffer.format->size;
+	u32 *report32 = (void *)report;
+
+	if (is_power_of_2(report_size)) {
+		/*
+		 * Clear out the report id and timestamp as a means
+		 * to detect unlanded reports.
+		 */
+		oa_report_id_clear(stream, report32);
+		oa_timestamp_clear(stream, report32);
+	} else {
+		u8 *oa_buf_base = stream->oa_buffer.vaddr;
+		u8 *oa_buf_end = oa_buf_base + OA_BUFFER_SIZE;
+		u32 part = oa_buf_end - report;
+
+		/* Zero out the entire report */
+		if (report_size <= part) {
+			memset(report, 0, report_size);
+		} else {
+			memset(report, 0, part);
+			memset(oa_buf_base, 0, report_size - part);
+		}
+	}
+}
+
+static void gen8_update_oa_head(struct i915_perf_stream *stream, u32 head)
+{
+	u32 gtt_offset = i915_ggtt_offset(stream->oa_buffer.vma);
+	i915_reg_t oaheadptr;
+	unsigned long flags;
+
+	oaheadptr = GRAPHICS_VER(stream->perf->i915) == 12 ?
+		    __oa_regs(stream)->oa_head_ptr :
+		    GEN8_OAHEADPTR;
+
+	spin_lock_irqsave(&stream->oa_buffer.ptr_lock, flags);
+
+	/*
+	 * Callers index relative to the OA buffer's CPU mapping, so put the
+	 * gtt_offset back here...
+	 */
+	intel_uncore_write(stream->uncore, oaheadptr,
+			   (head + gtt_offset) & GEN12_OAG_OAHEADPTR_MASK);
+	stream->oa_buffer.head = head;
+
+	spin_unlock_irqrestore(&stream->oa_buffer.ptr_lock, flags);
+}
+
 /**
  * gen8_append_oa_reports - Copies all buffered OA reports into
  *			    userspace read() buffer.
@@ -729,7 +782,6 @@ static int gen8_append_oa_reports(struct i915_perf_stream *stream,
 	struct intel_uncore *uncore = stream->uncore;
 	int report_size = stream->oa_buffer.format->size;
 	u8 *oa_buf_base = stream->oa_buffer.vaddr;
-	u32 gtt_offset = i915_ggtt_offset(stream->oa_buffer.vma);
 	u32 mask = (OA_BUFFER_SIZE - 1);
 	size_t start_offset = *offset;
 	unsigned long flags;
@@ -875,47 +927,11 @@ static int gen8_append_oa_reports(struct i915_perf_stream *stream,
 			stream->oa_buffer.last_ctx_id = ctx_id;
 		}
 
-		if (is_power_of_2(report_size)) {
-			/*
-			 * Clear out the report id and timestamp as a means
-			 * to detect unlanded reports.
-			 */
-			oa_report_id_clear(stream, report32);
-			oa_timestamp_clear(stream, report32);
-		} else {
-			u8 *oa_buf_end = stream->oa_buffer.vaddr +
-					 OA_BUFFER_SIZE;
-			u32 part = oa_buf_end - (u8 *)report32;
-
-			/* Zero out the entire report */
-			if (report_size <= part) {
-				memset(report32, 0, report_size);
-			} else {
-				memset(report32, 0, part);
-				memset(oa_buf_base, 0, report_size - part);
-			}
-		}
+		gen8_consume_oa_report(stream, report);
 	}
 
-	if (start_offset != *offset) {
-		i915_reg_t oaheadptr;
-
-		oaheadptr = GRAPHICS_VER(stream->perf->i915) == 12 ?
-			    __oa_regs(stream)->oa_head_ptr :
-			    GEN8_OAHEADPTR;
-
-		spin_lock_irqsave(&stream->oa_buffer.ptr_lock, flags);
-
-		/*
-		 * We removed the gtt_offset for the copy loop above, indexing
-		 * relative to oa_buf_base so put back here...
-		 */
-		intel_uncore_write(uncore, oaheadptr,
-				   (head + gtt_offset) & GEN12_OAG_OAHEADPTR_MASK);
-		stream->oa_buffer.head = head;
-
-		spin_unlock_irqrestore(&stream->oa_buffer.ptr_lock, flags);
-	}
+	if (start_offset != *offset)
+		gen8_update_oa_head(stream, head);
 
 	return ret;
 }
@@ -3640,6 +3656,72 @@ static long i915_perf_config_locked(struct i915_perf_stream *stream,
 	return ret;
 }
 
+/**
+ * i915_perf_buf_ptrs_locked - handle `I915_PERF_IOCTL_BUF_PTRS` ioctl
+ * @stream: An i915 perf stream
+ * @arg: pointer to a struct drm_i915_perf_buf_ptrs
+ *
+ * Reports the landed region of the OA buffer of an mmap'd stream and
+ * optionally releases the part userspace has consumed back to the OA unit.
+ *
+ * Returns: zero on success or a negative error code.
+ */
+static long i915_perf_buf_ptrs_locked(struct i915_perf_stream *stream,
+				      unsigned long arg)
+{
+	void __user *uaddr = (void __user *)arg;
+	struct drm_i915_perf_buf_ptrs ptrs;
+	unsigned long flags;
+	int report_size;
+	u32 head, tail;
+
+	if (!stream->oa_buffer.vaddr ||
+	    GRAPHICS_VER(stream->perf->i915) < 8)
+		return -ENODEV;
+
+	if (copy_from_user(&ptrs, uaddr, sizeof(ptrs)))
+		return -EFAULT;
+
+	if (ptrs.pad || ptrs.flags & ~I915_PERF_BUF_PTRS_SET_HEAD)
+		return -EINVAL;
+
+	if (!stream->enabled)
+		return -EIO;
+
+	report_size = stream->oa_buffer.format->size;
+	oa_buffer_check_unlocked(stream);
+
+	spin_lock_irqsave(&stream->oa_buffer.ptr_lock, flags);
+	head = stream->oa_buffer.head;
+	tail = stream->oa_buffer.tail;
+	spin_unlock_irqrestore(&stream->oa_buffer.ptr_lock, flags);
+
+	if (ptrs.flags & I915_PERF_BUF_PTRS_SET_HEAD) {
+		u32 new_head = ptrs.head;
+
+		/* The new head must be a report boundary within [head, tail] */
+		if (new_head >= OA_BUFFER_SIZE ||
+		    OA_TAKEN(new_head, head) % report_size ||
+		    OA_TAKEN(new_head, head) > OA_TAKEN(tail, head))
+			return -EINVAL;
+
+		if (new_head != head) {
+			for (; head != new_head;
+			     head = (head + report_size) & (OA_BUFFER_SIZE - 1))
+				gen8_consume_oa_report(stream,
+						       stream->oa_buffer.vaddr + head);
+			gen8_update_oa_head(stream, head);
+		}
+	}
+
+	ptrs.head = head;
+	ptrs.tail = tail;
+	if (copy_to_user(uaddr, &ptrs, sizeof(ptrs)))
+		return -EFAULT;
+
+	return 0;
+}
+
 /**
  * i915_perf_ioctl_locked - support ioctl() usage with i915 perf stream FDs
  * @stream: An i915 perf stream
@@ -3662,6 +3744,8 @@ static long i915_perf_ioctl_locked(struct i915_perf_stream *stream,
 		return 0;
 	case I915_PERF_IOCTL_CONFIG:
 		return i915_perf_config_locked(stream, arg);
+	case I915_PERF_IOCTL_BUF_PTRS:
+		return i915_perf_buf_ptrs_locked(stream, arg);
 	}
 
 	return -EINVAL;
@@ -3747,7 +3831,62 @@ static int i915_perf_release(struct inode *inode, struct file *file)
 
 	return 0;
 }
+/**
+ * i915_perf_mmap - map the OA buffer of a stream read-only into userspace
+ * @file: An i915 perf stream file
+ * @vma: the userspace mapping
+ *
+ * The whole OA buffer must be mapped at once. Reports are exposed unfiltered,
+ * so without CAP_PERFMON this is only allowed for streams that aren't
+ * filtered to a single context and only when the paranoid sysctl is off.
+ *
+ * Returns: zero on success or a negative error code.
+ */
+static int i915_perf_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct i915_perf_stream *stream = file->private_data;
+	struct drm_i915_private *i915 = stream->perf->i915;
+	unsigned long start = vma->vm_start;
+	struct sgt_iter iter;
+	struct page *page;
+	int ret = 0;
+
+	if (!stream->oa_buffer.vaddr || GRAPHICS_VER(i915) < 8)
+		return -ENODEV;
 
+	if ((i915_perf_stream_paranoid || stream->ctx) && !perfmon_capable()) {
+		drm_dbg(&i915->drm, "Insufficient privilege to map OA buffer\n");
+		return -EACCES;
+	}
+
+	/* Can mmap the entire OA buffer or nothing (no partial OA buffer mmaps) */
+	if (vma->vm_end - vma->vm_start != OA_BUFFER_SIZE) {
+		drm_dbg(&i915->drm, "Wrong mmap size, must be OA buffer size\n");
+		return -EINVAL;
+	}
+
+	/*
+	 * Only support VM_READ, enforce MAP_PRIVATE by checking for
+	 * VM_MAYSHARE, don't copy the vma on fork
+	 */
+	if (vma->vm_flags & (VM_WRITE | VM_EXEC | VM_SHARED | VM_MAYSHARE)) {
+		drm_dbg(&i915->drm, "mmap must be read only\n");
+		return -EINVAL;
+	}
+	vm_flags_mod(vma, VM_PFNMAP | VM_DONTEXPAND | VM_DONTDUMP | VM_DONTCOPY,
+		     VM_MAYWRITE | VM_MAYEXEC);
+
+	for_each_sgt_page(page, iter, stream->oa_buffer.vma->obj->mm.pages) {
+		ret = remap_pfn_range(vma, start, page_to_pfn(page),
+				      PAGE_SIZE, vma->vm_page_prot);
+		if (ret)
+			break;
+
+		start += PAGE_SIZE;
+	}
+
+	return ret;
+}
 
 static const struct file_operations fops = {
 	.owner		= THIS_MODULE,
@@ -3755,10 +3894,12 @@ static const struct file_operations fops = {
 	.poll		= i915_perf_poll,
 	.read		= i915_perf_read,
 	.unlocked_ioctl	= i915_perf_ioctl,
-	/* Our ioctl have no arguments, so it's safe to use the same function
-	 * to handle 32bits compatibility.
+	/* Our ioctl arguments are either plain integers or pointers to structs
+	 * with the same layout on 32 and 64 bits, so it's safe to use the same
+	 * function to handle 32bits compatibility.
 	 */
 	.compat_ioctl   = i915_perf_ioctl,
+	.mmap		= i915_perf_mmap,
 };
 
 
@@ -5250,6 +5391,8 @@ int i915_perf_ioctl_version(struct drm_i915_private *i915)
 	 *    DRM_I915_PERF_PROP_OA_ENGINE_INSTANCE
 	 *
 	 * 7: Add support for video decode and enhancement classes.
+	 *
+	 * 8: Add mmap of the OA buffer and I915_PERF_IOCTL_BUF_PTRS.
 	 */
 
 	/*
@@ -5261,7 +5404,7 @@ int i915_perf_ioctl_version(struct drm_i915_private *i915)
 	    intel_check_bios_c6_setup(&i915->media_gt->rc6))
 		return 6;
 
-	return 7;
+	return 8;
 }
 
 #if IS_ENABLED(CONFIG_DRM_I915_SELFTEST)
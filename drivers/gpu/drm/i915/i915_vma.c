@@ -1954,6 +1954,8 @@ int _i915_vma_move_to_active(struct i915_vma *vma,
 	if (unlikely(err))
 		return err;
 
+	WRITE_ONCE(obj->mm.referenced, true);
+
 	/*
 	 * Reserve fences slot early to prevent an allocation after preparing
 	 * the workload and associating fences with dma_resv.
@@ -275,10 +275,15 @@ nouveau_dmem_chunk_alloc(struct nouveau_drm *drm, struct page **ppage)
 	list_add(&chunk->list, &drm->dmem->chunks);
 	mutex_unlock(&drm->dmem->mutex);
 
+	/*
+	 * Push the pages in descending order so they are handed out in
+	 * ascending order, letting batched migrations coalesce the copies
+	 * into contiguous VRAM.
+	 */
 	pfn_first = chunk->pagemap.range.start >> PAGE_SHIFT;
-	page = pfn_to_page(pfn_first);
+	page = pfn_to_page(pfn_first + DMEM_CHUNK_NPAGES - 1);
 	spin_lock(&drm->dmem->lock);
-	for (i = 0; i < DMEM_CHUNK_NPAGES - 1; ++i, ++page) {
+	for (i = 0; i < DMEM_CHUNK_NPAGES - 1; ++i, --page) {
 		page->zone_device_data = drm->dmem->free_pages;
 		drm->dmem->free_pages = page;
 	}
@@ -612,7 +617,7 @@ nouveau_dmem_init(struct nouveau_drm *drm)
 	}
 }
 
-static unsigned long nouveau_dmem_migrate_copy_one(struct nouveau_drm *drm,
+static unsigned long nouveau_dmem_migrate_prepare_one(struct nouveau_drm *drm,
 		struct nouveau_svmm *svmm, unsigned long src,
 		dma_addr_t *dma_addr, u64 *pfn)
 {
@@ -620,6 +625,7 @@ static unsigned long nouveau_dmem_migrate_copy_one(struct nouveau_drm *drm,
 	struct page *dpage, *spage;
 	unsigned long paddr;
 
+	*dma_addr = DMA_MAPPING_ERROR;
 	spage = migrate_pfn_to_page(src);
 	if (!(src & MIGRATE_PFN_MIGRATE))
 		goto out;
@@ -630,18 +636,10 @@ static unsigned long nouveau_dmem_migrate_copy_one(struct nouveau_drm *drm,
 
 	paddr = nouveau_dmem_page_addr(dpage);
 	if (spage) {
-		*dma_addr = dma_map_page(dev, spage, 0, page_size(spage),
+		*dma_addr = dma_map_page(dev, spage, 0, PAGE_SIZE,
 					 DMA_BIDIRECTIONAL);
 		if (dma_mapping_error(dev, *dma_addr))
 			goto out_free_page;
-		if (drm->dmem->migrate.copy_func(drm, 1,
-			NOUVEAU_APER_VRAM, paddr, NOUVEAU_APER_HOST, *dma_addr))
-			goto out_dma_unmap;
-	} else {
-		*dma_addr = DMA_MAPPING_ERROR;
-		if (drm->dmem->migrate.clear_func(drm, page_size(dpage),
-			NOUVEAU_APER_VRAM, paddr))
-			goto out_free_page;
 	}
 
 	dpage->zone_device_data = svmm;
@@ -651,38 +649,138 @@ static unsigned long nouveau_dmem_migrate_copy_one(struct nouveau_drm *drm,
 		*pfn |= NVIF_VMM_PFNMAP_V0_W;
 	return migrate_pfn(page_to_pfn(dpage));
 
-out_dma_unmap:
-	dma_unmap_page(dev, *dma_addr, PAGE_SIZE, DMA_BIDIRECTIONAL);
 out_free_page:
+	*dma_addr = DMA_MAPPING_ERROR;
 	nouveau_dmem_page_free_locked(drm, dpage);
 out:
 	*pfn = NVIF_VMM_PFNMAP_V0_NONE;
 	return 0;
 }
 
+static void nouveau_dmem_migrate_abort(struct nouveau_drm *drm,
+		struct migrate_vma *args, dma_addr_t *dma_addrs, u64 *pfns,
+		unsigned long first, unsigned long last)
+{
+	struct device *dev = drm->dev->dev;
+	unsigned long i;
+
+	for (i = first; i < last; i++) {
+		if (!args->dst[i])
+			continue;
+
+		if (!dma_mapping_error(dev, dma_addrs[i])) {
+			dma_unmap_page(dev, dma_addrs[i], PAGE_SIZE,
+				       DMA_BIDIRECTIONAL);
+			dma_addrs[i] = DMA_MAPPING_ERROR;
+		}
+		nouveau_dmem_page_free_locked(drm,
+				migrate_pfn_to_page(args->dst[i]));
+		args->dst[i] = 0;
+		pfns[i] = NVIF_VMM_PFNMAP_V0_NONE;
+	}
+}
+
+struct nouveau_dmem_run {
+	unsigned long first;
+	unsigned long npages;
+	u64 dst;
+	u64 src;
+	bool clear;
+};
+
+static void nouveau_dmem_run_flush(struct nouveau_drm *drm,
+		struct migrate_vma *args, dma_addr_t *dma_addrs, u64 *pfns,
+		struct nouveau_dmem_run *run, unsigned long end)
+{
+	struct nouveau_dmem_migrate *migrate = &drm->dmem->migrate;
+	int ret;
+
+	if (!run->npages)
+		return;
+
+	if (run->clear)
+		ret = migrate->clear_func(drm, run->npages * PAGE_SIZE,
+					  NOUVEAU_APER_VRAM, run->dst);
+	else
+		ret = migrate->copy_func(drm, run->npages,
+					 NOUVEAU_APER_VRAM, run->dst,
+					 NOUVEAU_APER_HOST, run->src);
+	if (ret)
+		nouveau_dmem_migrate_abort(drm, args, dma_addrs, pfns,
+					   run->first, end);
+	run->npages = 0;
+}
+
+/*
+ * Emit the copies (or clears, for pages without a source) for a whole
+ * migration chunk, coalescing every run of pages that is contiguous on
+ * both sides into a single multi-line copy engine launch. Fresh chunks
+ * hand out device pages in ascending order, so the VRAM side is mostly
+ * contiguous; the system side is whenever the pages happen to be or an
+ * IOMMU maps them so.
+ */
+static void nouveau_dmem_migrate_copy(struct nouveau_drm *drm,
+		struct migrate_vma *args, dma_addr_t *dma_addrs, u64 *pfns,
+		unsigned long npages)
+{
+	struct device *dev = drm->dev->dev;
+	struct nouveau_dmem_run run = {};
+	unsigned long i;
+
+	for (i = 0; i < npages; i++) {
+		u64 offset = run.npages * PAGE_SIZE;
+		bool clear;
+		u64 dst;
+
+		if (!args->dst[i])
+			continue;
+
+		dst = nouveau_dmem_page_addr(migrate_pfn_to_page(args->dst[i]));
+		clear = dma_mapping_error(dev, dma_addrs[i]);
+
+		if (run.npages && run.clear == clear &&
+		    run.dst + offset == dst &&
+		    (clear || run.src + offset == dma_addrs[i])) {
+			run.npages++;
+			continue;
+		}
+
+		nouveau_dmem_run_flush(drm, args, dma_addrs, pfns, &run, i);
+		run.first = i;
+		run.npages = 1;
+		run.dst = dst;
+		run.src = clear ? 0 : dma_addrs[i];
+		run.clear = clear;
+	}
+
+	nouveau_dmem_run_flush(drm, args, dma_addrs, pfns, &run, npages);
+}
+
 static void nouveau_dmem_migrate_chunk(struct nouveau_drm *drm,
 		struct nouveau_svmm *svmm, struct migrate_vma *args,
 		dma_addr_t *dma_addrs, u64 *pfns)
 {
 	struct nouveau_fence *fence;
-	unsigned long addr = args->start, nr_dma = 0, i;
+	unsigned long addr = args->start, i, npages;
 
 	for (i = 0; addr < args->end; i++) {
-		args->dst[i] = nouveau_dmem_migrate_copy_one(drm, svmm,
-				args->src[i], dma_addrs + nr_dma, pfns + i);
-		if (!dma_mapping_error(drm->dev->dev, dma_addrs[nr_dma]))
-			nr_dma++;
+		args->dst[i] = nouveau_dmem_migrate_prepare_one(drm, svmm,
+				args->src[i], dma_addrs + i, pfns + i);
 		addr += PAGE_SIZE;
 	}
+	npages = i;
+
+	nouveau_dmem_migrate_copy(drm, args, dma_addrs, pfns, npages);
 
 	nouveau_fence_new(&fence, drm->dmem->migrate.chan);
 	migrate_vma_pages(args);
 	nouveau_dmem_fence_done(&fence);
-	nouveau_pfns_map(svmm, args->vma->vm_mm, args->start, pfns, i);
+	nouveau_pfns_map(svmm, args->vma->vm_mm, args->start, pfns, npages);
 
-	while (nr_dma--) {
-		dma_unmap_page(drm->dev->dev, dma_addrs[nr_dma], PAGE_SIZE,
-				DMA_BIDIRECTIONAL);
+	for (i = 0; i < npages; i++) {
+		if (!dma_mapping_error(drm->dev->dev, dma_addrs[i]))
+			dma_unmap_page(drm->dev->dev, dma_addrs[i], PAGE_SIZE,
+				       DMA_BIDIRECTIONAL);
 	}
 	migrate_vma_finalize(args);
 }
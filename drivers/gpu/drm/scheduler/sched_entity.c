@@ -62,10 +62,20 @@ int drm_sched_entity_init(struct drm_sched_entity *entity,
 			  unsigned int num_sched_list,
 			  atomic_t *guilty)
 {
+	struct drm_sched_entity_stats *stats;
+
 	if (!(entity && sched_list && (num_sched_list == 0 || sched_list[0])))
 		return -EINVAL;
 
+	stats = kzalloc(sizeof(*stats), GFP_KERNEL);
+	if (!stats)
+		return -ENOMEM;
+	kref_init(&stats->kref);
+	stats->weight = DRM_SCHED_WEIGHT_DEFAULT;
+	stats->avg_runtime = 100 * NSEC_PER_USEC;
+
 	memset(entity, 0, sizeof(struct drm_sched_entity));
+	entity->stats = stats;
 	INIT_LIST_HEAD(&entity->list);
 	entity->rq = NULL;
 	entity->guilty = guilty;
@@ -343,6 +353,11 @@ void drm_sched_entity_fini(struct drm_sched_entity *entity)
 
 	dma_fence_put(rcu_dereference_check(entity->last_scheduled, true));
 	RCU_INIT_POINTER(entity->last_scheduled, NULL);
+
+	if (entity->stats) {
+		kref_put(&entity->stats->kref, drm_sched_entity_stats_release);
+		entity->stats = NULL;
+	}
 }
 EXPORT_SYMBOL(drm_sched_entity_fini);
 
@@ -402,6 +417,32 @@ void drm_sched_entity_set_priority(struct drm_sched_entity *entity,
 }
 EXPORT_SYMBOL(drm_sched_entity_set_priority);
 
+/**
+ * drm_sched_entity_set_weight - Sets the GPU time share of the entity
+ *
+ * @entity: scheduler entity
+ * @weight: share relative to DRM_SCHED_WEIGHT_DEFAULT
+ *
+ * With the FAIR policy, entities of a run queue get GPU time in proportion
+ * to their weights. Drivers can expose this per context, e.g. through a
+ * context parameter. Only applies to jobs completing from now on.
+ */
+void drm_sched_entity_set_weight(struct drm_sched_entity *entity, u32 weight)
+{
+	WRITE_ONCE(entity->stats->weight,
+		   clamp_t(u32, weight, 1, DRM_SCHED_WEIGHT_MAX));
+}
+EXPORT_SYMBOL(drm_sched_entity_set_weight);
+
+void drm_sched_entity_stats_release(struct kref *kref)
+{
+	struct drm_sched_entity_stats *stats =
+		container_of(kref, typeof(*stats), kref);
+
+	kfree(stats);
+}
+EXPORT_SYMBOL(drm_sched_entity_stats_release);
+
 /*
  * Add a callback to the current dependency of the entity to wake up the
  * scheduler when the entity becomes available.
@@ -423,6 +464,12 @@ static bool drm_sched_entity_add_dependency_cb(struct drm_sched_entity *entity)
 		return false;
 	}
 
+	/* Signaled since it was added, don't bother with a callback */
+	if (dma_fence_is_signaled(fence)) {
+		dma_fence_put(entity->dependency);
+		return false;
+	}
+
 	s_fence = to_drm_sched_fence(fence);
 	if (!fence->error && s_fence && s_fence->sched == sched &&
 	    !test_bit(DRM_SCHED_FENCE_DONT_PIPELINE, &fence->flags)) {
@@ -459,9 +506,10 @@ drm_sched_job_dependency(struct drm_sched_job *job,
 
 	/* We keep the fence around, so we can iterate over all dependencies
 	 * in drm_sched_entity_kill_jobs_cb() to ensure all deps are signaled
-	 * before killing the job.
+	 * before killing the job. Pruning at arm time may have left holes.
 	 */
-	f = xa_load(&job->dependencies, job->last_dependency);
+	f = xa_find(&job->dependencies, &job->last_dependency, ULONG_MAX,
+		    XA_PRESENT);
 	if (f) {
 		job->last_dependency++;
 		return dma_fence_get(f);
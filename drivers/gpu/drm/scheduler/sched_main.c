@@ -102,7 +102,7 @@ int drm_sched_policy = DRM_SCHED_POLICY_FIFO;
  * DOC: sched_policy (int)
  * Used to override default entities scheduling policy in a run queue.
  */
-MODULE_PARM_DESC(sched_policy, "Specify the scheduling policy for entities on a run-queue, " __stringify(DRM_SCHED_POLICY_RR) " = Round Robin, " __stringify(DRM_SCHED_POLICY_FIFO) " = FIFO (default).");
+MODULE_PARM_DESC(sched_policy, "Specify the scheduling policy for entities on a run-queue, " __stringify(DRM_SCHED_POLICY_RR) " = Round Robin, " __stringify(DRM_SCHED_POLICY_FIFO) " = FIFO (default), " __stringify(DRM_SCHED_POLICY_FAIR) " = Weighted fair share of GPU time.");
 module_param_named(sched_policy, drm_sched_policy, int, 0444);
 
 static u32 drm_sched_available_credits(struct drm_gpu_scheduler *sched)
@@ -225,6 +225,14 @@ void drm_sched_rq_add_entity(struct drm_sched_rq *rq,
 
 	atomic_inc(rq->sched->score);
 	list_add_tail(&entity->list, &rq->entities);
+
+	/*
+	 * An entity which was idle does not get to catch up on the GPU time
+	 * it did not use, or it would starve the others for as long.
+	 */
+	if (drm_sched_policy == DRM_SCHED_POLICY_FAIR &&
+	    atomic64_read(&entity->stats->vruntime) < rq->min_vruntime)
+		atomic64_set(&entity->stats->vruntime, rq->min_vruntime);
 }
 
 /**
@@ -363,6 +371,110 @@ drm_sched_rq_select_entity_fifo(struct drm_gpu_scheduler *sched,
 	return rb ? rb_entry(rb, struct drm_sched_entity, rb_tree_node) : NULL;
 }
 
+/**
+ * drm_sched_rq_select_entity_fair - Select an entity which provides a job to run
+ *
+ * @sched: the gpu scheduler
+ * @rq: scheduler run queue to check.
+ *
+ * Find the ready entity which got the least GPU time for its weight.
+ *
+ * Return an entity if one is found; return an error-pointer (!NULL) if an
+ * entity was ready, but the scheduler had insufficient credits to accommodate
+ * its job; return NULL, if no ready entity was found.
+ */
+static struct drm_sched_entity *
+drm_sched_rq_select_entity_fair(struct drm_gpu_scheduler *sched,
+				struct drm_sched_rq *rq)
+{
+	struct drm_sched_entity *entity, *best = NULL;
+	u64 vruntime, best_vruntime = U64_MAX;
+
+	spin_lock(&rq->lock);
+	list_for_each_entry(entity, &rq->entities, list) {
+		if (!drm_sched_entity_is_ready(entity))
+			continue;
+
+		vruntime = atomic64_read(&entity->stats->vruntime);
+		if (vruntime < best_vruntime) {
+			best = entity;
+			best_vruntime = vruntime;
+		}
+	}
+
+	if (best) {
+		/* If we can't queue yet, keep the others from overtaking it. */
+		if (!drm_sched_can_queue(sched, best)) {
+			spin_unlock(&rq->lock);
+			return ERR_PTR(-ENOSPC);
+		}
+
+		rq->min_vruntime = max(rq->min_vruntime, best_vruntime);
+		reinit_completion(&best->entity_idle);
+	}
+	spin_unlock(&rq->lock);
+
+	return best;
+}
+
+/* Scale GPU time by the entity's weight */
+static u64 drm_sched_vruntime(struct drm_sched_entity_stats *stats, u64 ns)
+{
+	return div_u64(ns * DRM_SCHED_WEIGHT_DEFAULT, READ_ONCE(stats->weight));
+}
+
+/*
+ * Charge the entity for a job it is about to run, before it has consumed any
+ * GPU time, so that one entity queuing many jobs does not get all of them
+ * picked before the first completes.
+ */
+static void drm_sched_fair_charge_job(struct drm_sched_job *s_job)
+{
+	struct drm_sched_entity_stats *stats = s_job->entity_stats;
+
+	if (drm_sched_policy != DRM_SCHED_POLICY_FAIR || !stats)
+		return;
+
+	s_job->vcharge = drm_sched_vruntime(stats, READ_ONCE(stats->avg_runtime));
+	atomic64_add(s_job->vcharge, &stats->vruntime);
+}
+
+/*
+ * Account the GPU time used by a completed job: from when it was handed to
+ * the hardware, or when the job ahead of it completed, to its completion.
+ */
+static void drm_sched_fair_account_job(struct drm_sched_job *s_job)
+{
+	struct drm_sched_entity_stats *stats = s_job->entity_stats;
+	struct drm_sched_fence *s_fence = s_job->s_fence;
+	struct drm_gpu_scheduler *sched = s_fence->sched;
+	ktime_t start, end, last;
+	u64 ns;
+
+	if (drm_sched_policy != DRM_SCHED_POLICY_FAIR || !stats)
+		return;
+
+	if (!test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &s_fence->scheduled.flags) ||
+	    !test_bit(DMA_FENCE_FLAG_TIMESTAMP_BIT, &s_fence->finished.flags))
+		return;
+
+	start = s_fence->scheduled.timestamp;
+	end = s_fence->finished.timestamp;
+	last = READ_ONCE(sched->last_done);
+	if (ktime_after(last, start))
+		start = last;
+	if (ktime_after(end, last))
+		WRITE_ONCE(sched->last_done, end);
+	ns = ktime_after(end, start) ? ktime_to_ns(ktime_sub(end, start)) : 0;
+
+	/* Moving average over 8 jobs, for the up front charge. */
+	WRITE_ONCE(stats->avg_runtime,
+		   (READ_ONCE(stats->avg_runtime) * 7 + ns) / 8);
+
+	atomic64_add(drm_sched_vruntime(stats, ns) - s_job->vcharge,
+		     &stats->vruntime);
+}
+
 /**
  * drm_sched_run_job_queue - enqueue run-job work
  * @sched: scheduler instance
@@ -415,6 +527,9 @@ static void drm_sched_job_done(struct drm_sched_job *s_job, int result)
 
 	trace_drm_sched_process_job(s_fence);
 
+	/* Once finished is signaled, the job may be freed under us */
+	drm_sched_fair_account_job(s_job);
+
 	dma_fence_get(&s_fence->finished);
 	drm_sched_fence_finished(s_fence, result);
 	dma_fence_put(&s_fence->finished);
@@ -834,6 +949,26 @@ int drm_sched_job_init(struct drm_sched_job *job,
 }
 EXPORT_SYMBOL(drm_sched_job_init);
 
+/*
+ * Drop the dependencies which signaled since they were added, which would
+ * otherwise cost a trip through drm_sched_entity_pop_job(). Unsignaled ones
+ * must stay, drm_sched_entity_kill_jobs_cb() relies on the array to wait for
+ * all of them before a killed job is freed.
+ */
+static void drm_sched_job_prune_dependencies(struct drm_sched_job *job)
+{
+	struct dma_fence *fence;
+	unsigned long index;
+
+	xa_for_each(&job->dependencies, index, fence) {
+		if (!dma_fence_is_signaled(fence))
+			continue;
+
+		xa_erase(&job->dependencies, index);
+		dma_fence_put(fence);
+	}
+}
+
 /**
  * drm_sched_job_arm - arm a scheduler job for execution
  * @job: scheduler job to arm
@@ -859,7 +994,12 @@ void drm_sched_job_arm(struct drm_sched_job *job)
 	job->sched = sched;
 	job->s_priority = entity->priority;
 	job->id = atomic64_inc_return(&sched->job_id_count);
+	if (entity->stats) {
+		kref_get(&entity->stats->kref);
+		job->entity_stats = entity->stats;
+	}
 
+	drm_sched_job_prune_dependencies(job);
 	drm_sched_fence_init(job->s_fence, job->entity);
 }
 EXPORT_SYMBOL(drm_sched_job_arm);
@@ -885,6 +1025,12 @@ int drm_sched_job_add_dependency(struct drm_sched_job *job,
 	if (!fence)
 		return 0;
 
+	/* Nothing to wait for, don't make the scheduler look at it. */
+	if (dma_fence_is_signaled(fence)) {
+		dma_fence_put(fence);
+		return 0;
+	}
+
 	/* Deduplicate if we already depend on a fence from the same context.
 	 * This lets the size of the array of deps scale with the number of
 	 * engines involved, rather than the number of BOs.
@@ -1030,6 +1176,12 @@ void drm_sched_job_cleanup(struct drm_sched_job *job)
 	}
 	xa_destroy(&job->dependencies);
 
+	if (job->entity_stats) {
+		kref_put(&job->entity_stats->kref,
+			 drm_sched_entity_stats_release);
+		job->entity_stats = NULL;
+	}
+
 }
 EXPORT_SYMBOL(drm_sched_job_cleanup);
 
@@ -1064,9 +1216,17 @@ drm_sched_select_entity(struct drm_gpu_scheduler *sched)
 	/* Start with the highest priority.
 	 */
 	for (i = DRM_SCHED_PRIORITY_KERNEL; i < sched->num_rqs; i++) {
-		entity = drm_sched_policy == DRM_SCHED_POLICY_FIFO ?
-			drm_sched_rq_select_entity_fifo(sched, sched->sched_rq[i]) :
-			drm_sched_rq_select_entity_rr(sched, sched->sched_rq[i]);
+		switch (drm_sched_policy) {
+		case DRM_SCHED_POLICY_FIFO:
+			entity = drm_sched_rq_select_entity_fifo(sched, sched->sched_rq[i]);
+			break;
+		case DRM_SCHED_POLICY_FAIR:
+			entity = drm_sched_rq_select_entity_fair(sched, sched->sched_rq[i]);
+			break;
+		default:
+			entity = drm_sched_rq_select_entity_rr(sched, sched->sched_rq[i]);
+			break;
+		}
 		if (entity)
 			break;
 	}
@@ -1178,38 +1338,22 @@ static void drm_sched_free_job_work(struct work_struct *w)
 }
 
 /**
- * drm_sched_run_job_work - worker to call run_job
+ * drm_sched_run_job - push one job to the hardware
  *
- * @w: run job work
+ * @sched: scheduler instance
+ * @entity: the entity the job was popped from
+ * @sched_job: the job
  */
-static void drm_sched_run_job_work(struct work_struct *w)
+static void drm_sched_run_job(struct drm_gpu_scheduler *sched,
+			      struct drm_sched_entity *entity,
+			      struct drm_sched_job *sched_job)
 {
-	struct drm_gpu_scheduler *sched =
-		container_of(w, struct drm_gpu_scheduler, work_run_job);
-	struct drm_sched_entity *entity;
+	struct drm_sched_fence *s_fence = sched_job->s_fence;
 	struct dma_fence *fence;
-	struct drm_sched_fence *s_fence;
-	struct drm_sched_job *sched_job;
 	int r;
 
-	if (READ_ONCE(sched->pause_submit))
-		return;
-
-	/* Find entity with a ready job */
-	entity = drm_sched_select_entity(sched);
-	if (!entity)
-		return;	/* No more work */
-
-	sched_job = drm_sched_entity_pop_job(entity);
-	if (!sched_job) {
-		complete_all(&entity->entity_idle);
-		drm_sched_run_job_queue(sched);
-		return;
-	}
-
-	s_fence = sched_job->s_fence;
-
 	atomic_add(sched_job->credits, &sched->credit_count);
+	drm_sched_fair_charge_job(sched_job);
 	drm_sched_job_begin(sched_job);
 
 	trace_drm_run_job(sched_job, entity);
@@ -1231,9 +1375,52 @@ static void drm_sched_run_job_work(struct work_struct *w)
 		drm_sched_job_done(sched_job, IS_ERR(fence) ?
 				   PTR_ERR(fence) : 0);
 	}
+}
 
-	wake_up(&sched->job_scheduled);
-	drm_sched_run_job_queue(sched);
+/**
+ * drm_sched_run_job_work - worker to call run_job
+ *
+ * @w: run job work
+ *
+ * Runs one job, or with &drm_sched_backend_ops.commit_jobs a batch of jobs,
+ * picking the entity again for each so that priorities and credits are
+ * respected.
+ */
+static void drm_sched_run_job_work(struct work_struct *w)
+{
+	struct drm_gpu_scheduler *sched =
+		container_of(w, struct drm_gpu_scheduler, work_run_job);
+	unsigned int batch = sched->ops->commit_jobs ? DRM_SCHED_RUN_BATCH : 1;
+	struct drm_sched_entity *entity;
+	struct drm_sched_job *sched_job;
+	unsigned int i, ran = 0;
+
+	for (i = 0; i < batch; i++) {
+		if (READ_ONCE(sched->pause_submit))
+			break;
+
+		/* Find entity with a ready job */
+		entity = drm_sched_select_entity(sched);
+		if (!entity)
+			break;	/* No more work */
+
+		sched_job = drm_sched_entity_pop_job(entity);
+		if (!sched_job) {
+			complete_all(&entity->entity_idle);
+			continue;
+		}
+
+		drm_sched_run_job(sched, entity, sched_job);
+		ran++;
+	}
+
+	if (ran && sched->ops->commit_jobs)
+		sched->ops->commit_jobs(sched);
+
+	if (ran)
+		wake_up(&sched->job_scheduled);
+	if (i)
+		drm_sched_run_job_queue(sched);
 }
 
 /**
@@ -125,6 +125,77 @@ static void test_duplicates(struct kunit *test)
 	drm_exec_fini(&exec);
 }
 
+static void test_hint(struct kunit *test)
+{
+	struct drm_exec_priv *priv = test->priv;
+	struct drm_gem_object gobj1 = { };
+	struct drm_gem_object gobj2 = { };
+	struct drm_exec_hint hint = { };
+	struct drm_exec exec;
+	int ret;
+
+	drm_gem_private_object_init(priv->drm, &gobj1, PAGE_SIZE);
+	drm_gem_private_object_init(priv->drm, &gobj2, PAGE_SIZE);
+
+	drm_gem_object_get(&gobj2);
+	hint.obj = &gobj2;
+
+	/* The hinted object is locked first and kept once asked for */
+	drm_exec_init(&exec, DRM_EXEC_INTERRUPTIBLE_WAIT, 0);
+	drm_exec_set_hint(&exec, &hint);
+	drm_exec_until_all_locked(&exec) {
+		ret = drm_exec_lock_obj(&exec, &gobj1);
+		drm_exec_retry_on_contention(&exec);
+		KUNIT_EXPECT_EQ(test, ret, 0);
+		if (ret)
+			break;
+
+		ret = drm_exec_lock_obj(&exec, &gobj2);
+		drm_exec_retry_on_contention(&exec);
+		KUNIT_EXPECT_EQ(test, ret, 0);
+		if (ret)
+			break;
+	}
+	KUNIT_EXPECT_EQ(test, exec.num_objects, 2);
+	KUNIT_EXPECT_PTR_EQ(test, exec.objects[0], &gobj2);
+	KUNIT_EXPECT_EQ(test, exec.num_retries, 0);
+	drm_exec_fini(&exec);
+
+	/* ... and dropped again if not */
+	drm_exec_init(&exec, DRM_EXEC_INTERRUPTIBLE_WAIT, 0);
+	drm_exec_set_hint(&exec, &hint);
+	drm_exec_until_all_locked(&exec) {
+		ret = drm_exec_lock_obj(&exec, &gobj1);
+		drm_exec_retry_on_contention(&exec);
+		KUNIT_EXPECT_EQ(test, ret, 0);
+		if (ret)
+			break;
+	}
+	KUNIT_EXPECT_EQ(test, exec.num_objects, 1);
+	KUNIT_EXPECT_PTR_EQ(test, exec.objects[0], &gobj1);
+	KUNIT_EXPECT_NULL(test, dma_resv_locking_ctx(gobj2.resv));
+	drm_exec_fini(&exec);
+
+	/* ... and handed over to an object sharing its reservation object */
+	gobj1.resv = gobj2.resv;
+	drm_exec_init(&exec, DRM_EXEC_INTERRUPTIBLE_WAIT, 0);
+	drm_exec_set_hint(&exec, &hint);
+	drm_exec_until_all_locked(&exec) {
+		ret = drm_exec_lock_obj(&exec, &gobj1);
+		drm_exec_retry_on_contention(&exec);
+		KUNIT_EXPECT_EQ(test, ret, 0);
+		if (ret)
+			break;
+	}
+	KUNIT_EXPECT_EQ(test, exec.num_objects, 1);
+	KUNIT_EXPECT_PTR_EQ(test, exec.objects[0], &gobj1);
+	KUNIT_EXPECT_PTR_EQ(test, dma_resv_locking_ctx(gobj1.resv), &exec.ticket);
+	drm_exec_fini(&exec);
+	gobj1.resv = &gobj1._resv;
+
+	drm_exec_hint_fini(&hint);
+}
+
 static void test_prepare(struct kunit *test)
 {
 	struct drm_exec_priv *priv = test->priv;
@@ -195,6 +266,7 @@ static struct kunit_case drm_exec_tests[] = {
 	KUNIT_CASE(test_lock),
 	KUNIT_CASE(test_lock_unlock),
 	KUNIT_CASE(test_duplicates),
+	KUNIT_CASE(test_hint),
 	KUNIT_CASE(test_prepare),
 	KUNIT_CASE(test_prepare_array),
 	KUNIT_CASE(test_multiple_loops),
@@ -580,6 +580,38 @@ static int ttm_bo_evict_alloc(struct ttm_device *bdev,
 	return 0;
 }
 
+/**
+ * ttm_bo_evict_range() - Evict all buffer objects intersecting a place.
+ * @bdev: The ttm device.
+ * @man: The manager whose bos to evict.
+ * @place: The range to free up.
+ * @ctx: The TTM operation ctx governing the eviction.
+ *
+ * Used to move buffer objects out of a range of a manager, e.g. to
+ * defragment it. Buffer objects which are pinned, which the driver doesn't
+ * consider valuable to evict or which can't be locked right away are skipped.
+ *
+ * Return: 0 if successful, negative error code on error.
+ */
+int ttm_bo_evict_range(struct ttm_device *bdev, struct ttm_resource_manager *man,
+		       const struct ttm_place *place, struct ttm_operation_ctx *ctx)
+{
+	struct ttm_bo_evict_walk evict_walk = {
+		.walk = {
+			.ops = &ttm_evict_walk_ops,
+			.ctx = ctx,
+			.trylock_only = true,
+		},
+		.place = place,
+	};
+	s64 lret;
+
+	lret = ttm_lru_walk_for_evict(&evict_walk.walk, bdev, man, S64_MAX);
+
+	return lret < 0 ? lret : 0;
+}
+EXPORT_SYMBOL(ttm_bo_evict_range);
+
 /**
  * ttm_bo_pin - Pin the buffer object.
  * @bo: The buffer object to pin
@@ -35,9 +35,11 @@
 
 struct dentry;
 struct ttm_device;
+struct ttm_operation_ctx;
 
 extern struct dentry *ttm_debugfs_root;
 
 void ttm_sys_man_init(struct ttm_device *bdev);
+int ttm_global_shrink(struct ttm_operation_ctx *ctx, gfp_t gfp_flags);
 
 #endif /* _TTM_MODULE_H_ */
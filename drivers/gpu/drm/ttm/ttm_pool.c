@@ -29,6 +29,10 @@
  *
  * Additional to that allocations from the DMA coherent API are pooled as well
  * cause they are rather slow compared to alloc_pages+map.
+ *
+ * The global WC/UC pools are kept per NUMA node, so that pages are handed out
+ * on the node they are allocated on. Optionally a worker keeps them filled to
+ * a watermark, so that allocations don't have to wait for the caching change.
  */
 
 #include <linux/module.h>
@@ -36,6 +40,7 @@
 #include <linux/debugfs.h>
 #include <linux/highmem.h>
 #include <linux/sched/mm.h>
+#include <linux/workqueue.h>
 
 #ifdef CONFIG_X86
 #include <asm/set_memory.h>
@@ -58,15 +63,40 @@ struct ttm_pool_dma {
 	unsigned long vaddr;
 };
 
+/**
+ * struct ttm_pool_node - Global pools of a NUMA node
+ *
+ * @nid: the node
+ * @write_combined: pools for each order of WC pages
+ * @uncached: pools for each order of UC pages
+ * @refill_work: keeps the pools at the refill watermark
+ */
+struct ttm_pool_node {
+	int nid;
+	struct ttm_pool_type write_combined[NR_PAGE_ORDERS];
+	struct ttm_pool_type uncached[NR_PAGE_ORDERS];
+	struct work_struct refill_work;
+};
+
+/* The orders kept filled by the refill worker: single pages and 2MiB */
+#define TTM_POOL_REFILL_ORDER	min_t(unsigned int, MAX_PAGE_ORDER, 9)
+
+/* Number of 4K pages the refill worker changes the caching of at once */
+#define TTM_POOL_REFILL_BATCH	512
+
 static unsigned long page_pool_size;
 
 MODULE_PARM_DESC(page_pool_size, "Number of pages in the WC/UC/DMA pool");
 module_param(page_pool_size, ulong, 0644);
 
+static unsigned long page_pool_refill;
+
+MODULE_PARM_DESC(page_pool_refill, "Number of pages kept ready in the WC and UC pools of each node, per order refilled (0 = disabled)");
+module_param(page_pool_refill, ulong, 0644);
+
 static atomic_long_t allocated_pages;
 
-static struct ttm_pool_type global_write_combined[NR_PAGE_ORDERS];
-static struct ttm_pool_type global_uncached[NR_PAGE_ORDERS];
+static struct ttm_pool_node *global_nodes;
 
 static struct ttm_pool_type global_dma32_write_combined[NR_PAGE_ORDERS];
 static struct ttm_pool_type global_dma32_uncached[NR_PAGE_ORDERS];
@@ -235,6 +265,7 @@ static void ttm_pool_type_give(struct ttm_pool_type *pt, struct page *p)
 
 	spin_lock(&pt->lock);
 	list_add(&p->lru, &pt->pages);
+	pt->nr_pages++;
 	spin_unlock(&pt->lock);
 	atomic_long_add(1 << pt->order, &allocated_pages);
 }
@@ -249,6 +280,7 @@ static struct page *ttm_pool_type_take(struct ttm_pool_type *pt)
 	if (p) {
 		atomic_long_sub(1 << pt->order, &allocated_pages);
 		list_del(&p->lru);
+		pt->nr_pages--;
 	}
 	spin_unlock(&pt->lock);
 
@@ -264,6 +296,7 @@ static void ttm_pool_type_init(struct ttm_pool_type *pt, struct ttm_pool *pool,
 	pt->order = order;
 	spin_lock_init(&pt->lock);
 	INIT_LIST_HEAD(&pt->pages);
+	pt->nr_pages = 0;
 
 	spin_lock(&shrinker_lock);
 	list_add_tail(&pt->shrinker_list, &shrinker_list);
@@ -283,10 +316,22 @@ static void ttm_pool_type_fini(struct ttm_pool_type *pt)
 		ttm_pool_free_page(pt->pool, pt->caching, pt->order, p);
 }
 
-/* Return the pool_type to use for the given caching and order */
+/* Return the global pools of a node, the local one for NUMA_NO_NODE */
+static struct ttm_pool_node *ttm_pool_node(int nid)
+{
+	if (nid == NUMA_NO_NODE)
+		nid = numa_node_id();
+
+	return &global_nodes[nid];
+}
+
+/*
+ * Return the pool_type to use for the given caching and order, for pages of
+ * node @nid if the pool isn't bound to a node.
+ */
 static struct ttm_pool_type *ttm_pool_select_type(struct ttm_pool *pool,
 						  enum ttm_caching caching,
-						  unsigned int order)
+						  unsigned int order, int nid)
 {
 	if (pool->use_dma_alloc)
 		return &pool->caching[caching].orders[order];
@@ -300,7 +345,7 @@ static struct ttm_pool_type *ttm_pool_select_type(struct ttm_pool *pool,
 		if (pool->use_dma32)
 			return &global_dma32_write_combined[order];
 
-		return &global_write_combined[order];
+		return &ttm_pool_node(nid)->write_combined[order];
 	case ttm_uncached:
 		if (pool->nid != NUMA_NO_NODE)
 			return &pool->caching[caching].orders[order];
@@ -308,7 +353,7 @@ static struct ttm_pool_type *ttm_pool_select_type(struct ttm_pool *pool,
 		if (pool->use_dma32)
 			return &global_dma32_uncached[order];
 
-		return &global_uncached[order];
+		return &ttm_pool_node(nid)->uncached[order];
 	default:
 		break;
 	}
@@ -317,6 +362,101 @@ static struct ttm_pool_type *ttm_pool_select_type(struct ttm_pool *pool,
 	return NULL;
 }
 
+/* Pages are missing from one of the refilled pools of the node */
+static bool ttm_pool_node_needs_refill(struct ttm_pool_node *node)
+{
+	unsigned int orders[] = { 0, TTM_POOL_REFILL_ORDER };
+	unsigned long watermark = READ_ONCE(page_pool_refill);
+	unsigned int i;
+
+	/* Only the WC/UC pools of x86 are global */
+	if (!IS_ENABLED(CONFIG_X86) || !watermark)
+		return false;
+
+	if (atomic_long_read(&allocated_pages) >= page_pool_size)
+		return false;
+
+	for (i = 0; i < ARRAY_SIZE(orders); ++i) {
+		if ((READ_ONCE(node->write_combined[orders[i]].nr_pages)
+		     << orders[i]) < watermark ||
+		    (READ_ONCE(node->uncached[orders[i]].nr_pages)
+		     << orders[i]) < watermark)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Fill a pool up to the watermark. The caching of the new pages is changed in
+ * batches, so that the expensive TLB flush is done once per batch instead of
+ * once per allocation. Returns false if no more pages could be allocated.
+ */
+static bool ttm_pool_refill_type(struct ttm_pool_node *node,
+				 struct ttm_pool_type *pt, struct page **batch)
+{
+	gfp_t gfp = GFP_HIGHUSER | __GFP_THISNODE | __GFP_NORETRY |
+		__GFP_NOWARN | __GFP_NOMEMALLOC;
+	unsigned int i, j, count, num_pages = 1 << pt->order;
+	unsigned long watermark = READ_ONCE(page_pool_refill);
+	struct page *p;
+
+	while ((READ_ONCE(pt->nr_pages) << pt->order) < watermark &&
+	       atomic_long_read(&allocated_pages) < page_pool_size) {
+		for (count = 0; count + num_pages <= TTM_POOL_REFILL_BATCH &&
+		     ((READ_ONCE(pt->nr_pages) << pt->order) + count) < watermark;
+		     count += num_pages) {
+			p = alloc_pages_node(node->nid, gfp, pt->order);
+			if (!p)
+				break;
+
+			p->private = pt->order;
+			for (j = 0; j < num_pages; ++j)
+				batch[count + j] = p + j;
+		}
+
+		if (!count)
+			return false;
+
+		if (ttm_pool_apply_caching(batch, batch + count, pt->caching)) {
+			for (i = 0; i < count; i += num_pages)
+				__free_pages(batch[i], pt->order);
+			return false;
+		}
+
+		for (i = 0; i < count; i += num_pages)
+			ttm_pool_type_give(pt, batch[i]);
+
+		cond_resched();
+	}
+
+	return true;
+}
+
+static void ttm_pool_refill_work(struct work_struct *work)
+{
+	struct ttm_pool_node *node =
+		container_of(work, struct ttm_pool_node, refill_work);
+	unsigned int orders[] = { TTM_POOL_REFILL_ORDER, 0 };
+	struct page **batch;
+	unsigned int i;
+
+	batch = kvmalloc_array(TTM_POOL_REFILL_BATCH, sizeof(*batch),
+			       GFP_KERNEL);
+	if (!batch)
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(orders); ++i) {
+		if (!ttm_pool_refill_type(node, &node->write_combined[orders[i]],
+					  batch) ||
+		    !ttm_pool_refill_type(node, &node->uncached[orders[i]],
+					  batch))
+			break;
+	}
+
+	kvfree(batch);
+}
+
 /* Free pages using the global shrinker list */
 static unsigned int ttm_pool_shrink(void)
 {
@@ -405,7 +545,8 @@ static void ttm_pool_free_range(struct ttm_pool *pool, struct ttm_tt *tt,
 		if (tt->dma_address)
 			ttm_pool_unmap(pool, tt->dma_address[i], nr);
 
-		pt = ttm_pool_select_type(pool, caching, order);
+		pt = ttm_pool_select_type(pool, caching, order,
+					  page_to_nid(*pages));
 		if (pt)
 			ttm_pool_type_give(pt, *pages);
 		else
@@ -435,6 +576,7 @@ int ttm_pool_alloc(struct ttm_pool *pool, struct ttm_tt *tt,
 	enum ttm_caching page_caching;
 	gfp_t gfp_flags = GFP_USER;
 	pgoff_t caching_divide;
+	int nid = numa_node_id();
 	unsigned int order;
 	struct page *p;
 	int r;
@@ -459,7 +601,7 @@ int ttm_pool_alloc(struct ttm_pool *pool, struct ttm_tt *tt,
 		struct ttm_pool_type *pt;
 
 		page_caching = tt->caching;
-		pt = ttm_pool_select_type(pool, tt->caching, order);
+		pt = ttm_pool_select_type(pool, tt->caching, order, nid);
 		p = pt ? ttm_pool_type_take(pt) : NULL;
 		if (p) {
 			r = ttm_pool_apply_caching(caching, pages,
@@ -517,6 +659,12 @@ int ttm_pool_alloc(struct ttm_pool *pool, struct ttm_tt *tt,
 	if (r)
 		goto error_free_all;
 
+	if (tt->caching != ttm_cached && !pool->use_dma_alloc &&
+	    !pool->use_dma32 && pool->nid == NUMA_NO_NODE &&
+	    ttm_pool_node_needs_refill(&global_nodes[nid]))
+		queue_work_node(nid, system_unbound_wq,
+				&global_nodes[nid].refill_work);
+
 	return 0;
 
 error_free_page:
@@ -577,7 +725,7 @@ void ttm_pool_init(struct ttm_pool *pool, struct device *dev,
 			struct ttm_pool_type *pt;
 
 			/* Initialize only pool types which are actually used */
-			pt = ttm_pool_select_type(pool, i, j);
+			pt = ttm_pool_select_type(pool, i, j, NUMA_NO_NODE);
 			if (pt != &pool->caching[i].orders[j])
 				continue;
 
@@ -615,7 +763,7 @@ void ttm_pool_fini(struct ttm_pool *pool)
 		for (j = 0; j < NR_PAGE_ORDERS; ++j) {
 			struct ttm_pool_type *pt;
 
-			pt = ttm_pool_select_type(pool, i, j);
+			pt = ttm_pool_select_type(pool, i, j, NUMA_NO_NODE);
 			if (pt != &pool->caching[i].orders[j])
 				continue;
 
@@ -700,13 +848,17 @@ static void ttm_pool_debugfs_footer(struct seq_file *m)
 /* Dump the information for the global pools */
 static int ttm_pool_debugfs_globals_show(struct seq_file *m, void *data)
 {
+	int nid;
+
 	ttm_pool_debugfs_header(m);
 
 	spin_lock(&shrinker_lock);
-	seq_puts(m, "wc\t:");
-	ttm_pool_debugfs_orders(global_write_combined, m);
-	seq_puts(m, "uc\t:");
-	ttm_pool_debugfs_orders(global_uncached, m);
+	for_each_online_node(nid) {
+		seq_printf(m, "wc N%d\t:", nid);
+		ttm_pool_debugfs_orders(global_nodes[nid].write_combined, m);
+		seq_printf(m, "uc N%d\t:", nid);
+		ttm_pool_debugfs_orders(global_nodes[nid].uncached, m);
+	}
 	seq_puts(m, "wc 32\t:");
 	ttm_pool_debugfs_orders(global_dma32_write_combined, m);
 	seq_puts(m, "uc 32\t:");
@@ -787,6 +939,7 @@ DEFINE_SHOW_ATTRIBUTE(ttm_pool_debugfs_shrink);
 int ttm_pool_mgr_init(unsigned long num_pages)
 {
 	unsigned int i;
+	int nid;
 
 	if (!page_pool_size)
 		page_pool_size = num_pages;
@@ -794,11 +947,24 @@ int ttm_pool_mgr_init(unsigned long num_pages)
 	spin_lock_init(&shrinker_lock);
 	INIT_LIST_HEAD(&shrinker_list);
 
-	for (i = 0; i < NR_PAGE_ORDERS; ++i) {
-		ttm_pool_type_init(&global_write_combined[i], NULL,
-				   ttm_write_combined, i);
-		ttm_pool_type_init(&global_uncached[i], NULL, ttm_uncached, i);
+	global_nodes = kcalloc(nr_node_ids, sizeof(*global_nodes), GFP_KERNEL);
+	if (!global_nodes)
+		return -ENOMEM;
+
+	for_each_node(nid) {
+		struct ttm_pool_node *node = &global_nodes[nid];
+
+		node->nid = nid;
+		INIT_WORK(&node->refill_work, ttm_pool_refill_work);
+		for (i = 0; i < NR_PAGE_ORDERS; ++i) {
+			ttm_pool_type_init(&node->write_combined[i], NULL,
+					   ttm_write_combined, i);
+			ttm_pool_type_init(&node->uncached[i], NULL,
+					   ttm_uncached, i);
+		}
+	}
 
+	for (i = 0; i < NR_PAGE_ORDERS; ++i) {
 		ttm_pool_type_init(&global_dma32_write_combined[i], NULL,
 				   ttm_write_combined, i);
 		ttm_pool_type_init(&global_dma32_uncached[i], NULL,
@@ -813,8 +979,10 @@ int ttm_pool_mgr_init(unsigned long num_pages)
 #endif
 
 	mm_shrinker = shrinker_alloc(0, "drm-ttm_pool");
-	if (!mm_shrinker)
+	if (!mm_shrinker) {
+		ttm_pool_mgr_fini();
 		return -ENOMEM;
+	}
 
 	mm_shrinker->count_objects = ttm_pool_shrinker_count;
 	mm_shrinker->scan_objects = ttm_pool_shrinker_scan;
@@ -833,11 +1001,20 @@ int ttm_pool_mgr_init(unsigned long num_pages)
 void ttm_pool_mgr_fini(void)
 {
 	unsigned int i;
+	int nid;
 
-	for (i = 0; i < NR_PAGE_ORDERS; ++i) {
-		ttm_pool_type_fini(&global_write_combined[i]);
-		ttm_pool_type_fini(&global_uncached[i]);
+	for_each_node(nid) {
+		struct ttm_pool_node *node = &global_nodes[nid];
 
+		cancel_work_sync(&node->refill_work);
+		for (i = 0; i < NR_PAGE_ORDERS; ++i) {
+			ttm_pool_type_fini(&node->write_combined[i]);
+			ttm_pool_type_fini(&node->uncached[i]);
+		}
+	}
+	kfree(global_nodes);
+
+	for (i = 0; i < NR_PAGE_ORDERS; ++i) {
 		ttm_pool_type_fini(&global_dma32_write_combined[i]);
 		ttm_pool_type_fini(&global_dma32_uncached[i]);
 	}
@@ -37,6 +37,7 @@
 #include <linux/module.h>
 #include <linux/sched.h>
 #include <linux/shmem_fs.h>
+#include <linux/shrinker.h>
 #include <drm/drm_cache.h>
 #include <drm/drm_device.h>
 #include <drm/drm_util.h>
@@ -55,8 +56,14 @@ static unsigned long ttm_dma32_pages_limit;
 MODULE_PARM_DESC(dma32_pages_limit, "Limit for the allocated DMA32 pages");
 module_param_named(dma32_pages_limit, ttm_dma32_pages_limit, ulong, 0644);
 
+static bool ttm_shrink_idle;
+
+MODULE_PARM_DESC(shrink_idle, "Swap idle buffer objects out to shmem under memory pressure");
+module_param_named(shrink_idle, ttm_shrink_idle, bool, 0644);
+
 static atomic_long_t ttm_pages_allocated;
 static atomic_long_t ttm_dma32_pages_allocated;
+static struct shrinker *ttm_tt_shrinker;
 
 /*
  * Allocates a ttm structure for the given BO.
@@ -409,6 +416,49 @@ DEFINE_SHOW_ATTRIBUTE(ttm_tt_debugfs_shrink);
 
 
 /*
+ * With shrink_idle set, populated TTs count as reclaimable. Under memory
+ * pressure the idle, unpinned BOs backing them are swapped out to shmem, as
+ * when the pages limit is hit, and from there the core MM can write them to
+ * swap or zswap. They are swapped back in when next validated.
+ */
+static unsigned long ttm_tt_shrinker_count(struct shrinker *shrink,
+					   struct shrink_control *sc)
+{
+	unsigned long num_pages;
+
+	if (!READ_ONCE(ttm_shrink_idle))
+		return 0;
+
+	num_pages = atomic_long_read(&ttm_pages_allocated);
+	return num_pages ? num_pages : SHRINK_EMPTY;
+}
+
+static unsigned long ttm_tt_shrinker_scan(struct shrinker *shrink,
+					  struct shrink_control *sc)
+{
+	/* Busy BOs are skipped, never waited for */
+	struct ttm_operation_ctx ctx = {
+		.interruptible = false,
+		.no_wait_gpu = true,
+	};
+	unsigned long freed = 0;
+	int ret;
+
+	/* Swapping out needs to allocate shmem pages and may start writeback */
+	if ((sc->gfp_mask & (__GFP_FS | __GFP_IO)) != (__GFP_FS | __GFP_IO))
+		return SHRINK_STOP;
+
+	while (freed < sc->nr_to_scan) {
+		ret = ttm_global_shrink(&ctx, GFP_KERNEL | __GFP_NOWARN);
+		if (ret <= 0)
+			break;
+		freed += ret;
+	}
+
+	return freed ? freed : SHRINK_STOP;
+}
+
+/**
  * ttm_tt_mgr_init - register with the MM shrinker
  *
  * Register with the MM shrinker for swapping out BOs.
@@ -425,6 +475,27 @@ void ttm_tt_mgr_init(unsigned long num_pages, unsigned long num_dma32_pages)
 
 	if (!ttm_dma32_pages_limit)
 		ttm_dma32_pages_limit = num_dma32_pages;
+
+	ttm_tt_shrinker = shrinker_alloc(0, "drm-ttm_tt");
+	if (!ttm_tt_shrinker) {
+		/* Not fatal, only the pages limit will trigger swapout */
+		pr_warn("Failed allocating the TT shrinker\n");
+		return;
+	}
+
+	ttm_tt_shrinker->count_objects = ttm_tt_shrinker_count;
+	ttm_tt_shrinker->scan_objects = ttm_tt_shrinker_scan;
+	ttm_tt_shrinker->seeks = DEFAULT_SEEKS;
+	shrinker_register(ttm_tt_shrinker);
+}
+
+/**
+ * ttm_tt_mgr_fini - unregister from the MM shrinker
+ */
+void ttm_tt_mgr_fini(void)
+{
+	shrinker_free(ttm_tt_shrinker);
+	ttm_tt_shrinker = NULL;
 }
 
 static void ttm_kmap_iter_tt_map_local(struct ttm_kmap_iter *iter,
@@ -81,6 +81,12 @@ struct xe_bo {
 	 * from default
 	 */
 	u64 min_align;
+
+	/**
+	 * @acc_promoted: jiffies of the last access counter driven promotion
+	 * to VRAM, 0 if never promoted. Protected by the BO's dma-resv.
+	 */
+	unsigned long acc_promoted;
 };
 
 #endif
@@ -15,6 +15,7 @@
 #include "abi/guc_actions_abi.h"
 #include "xe_bo.h"
 #include "xe_gt.h"
+#include "xe_gt_stats.h"
 #include "xe_gt_tlb_invalidation.h"
 #include "xe_guc.h"
 #include "xe_guc_ct.h"
@@ -200,76 +201,164 @@ static struct xe_vm *asid_to_vm(struct xe_device *xe, u32 asid)
 	return vm;
 }
 
-static int handle_pagefault(struct xe_gt *gt, struct pagefault *pf)
+static void print_pagefault(struct xe_device *xe, struct pagefault *pf)
 {
-	struct xe_device *xe = gt_to_xe(gt);
-	struct xe_tile *tile = gt_to_tile(gt);
-	struct xe_vm *vm;
-	struct xe_vma *vma = NULL;
-	int err;
+	drm_dbg(&xe->drm, "\n\tASID: %d\n"
+		 "\tVFID: %d\n"
+		 "\tPDATA: 0x%04x\n"
+		 "\tFaulted Address: 0x%08x%08x\n"
+		 "\tFaultType: %d\n"
+		 "\tAccessType: %d\n"
+		 "\tFaultLevel: %d\n"
+		 "\tEngineClass: %d\n"
+		 "\tEngineInstance: %d\n",
+		 pf->asid, pf->vfid, pf->pdata, upper_32_bits(pf->page_addr),
+		 lower_32_bits(pf->page_addr),
+		 pf->fault_type, pf->access_type, pf->fault_level,
+		 pf->engine_class, pf->engine_instance);
+}
 
-	/* SW isn't expected to handle TRTT faults */
-	if (pf->trva_fault)
-		return -EFAULT;
+/*
+ * Largest neighbouring VMA that is bound ahead of the GPU touching it. A
+ * kernel streaming through fresh memory faults on every VMA in turn, so
+ * binding the next one while its neighbour's locks are held saves a full
+ * fault round trip through the GuC.
+ */
+#define PF_PREFETCH_MAX_SIZE	SZ_2M
 
-	vm = asid_to_vm(xe, pf->asid);
-	if (IS_ERR(vm))
-		return PTR_ERR(vm);
+static void prefetch_next_vma(struct xe_tile *tile, struct xe_vm *vm,
+			      struct xe_vma *vma)
+{
+	struct pagefault pf = { .access_type = ACCESS_TYPE_READ };
+	struct xe_vma *next;
 
-	/*
-	 * TODO: Change to read lock? Using write lock for simplicity.
-	 */
-	down_write(&vm->lock);
+	if (xe_vma_end(vma) + SZ_4K > vm->size)
+		return;
 
-	if (xe_vm_is_closed(vm)) {
-		err = -ENOENT;
-		goto unlock_vm;
-	}
+	next = xe_vm_find_overlapping_vma(vm, xe_vma_end(vma), SZ_4K);
+	if (!next || xe_vma_is_userptr(next) || xe_vma_is_null(next) ||
+	    xe_vma_size(next) > PF_PREFETCH_MAX_SIZE ||
+	    vma_is_valid(tile, next))
+		return;
+
+	/* Best effort, the GPU faults on it normally if this fails */
+	handle_vma_pagefault(tile, &pf, next);
+}
+
+static int handle_pagefault(struct xe_gt *gt, struct xe_vm *vm,
+			    struct pagefault *pf)
+{
+	struct xe_tile *tile = gt_to_tile(gt);
+	struct xe_vma *vma;
+	bool was_valid;
+	int err;
+
+	lockdep_assert_held_write(&vm->lock);
+
+	if (xe_vm_is_closed(vm))
+		return -ENOENT;
 
 	vma = lookup_vma(vm, pf->page_addr);
-	if (!vma) {
-		err = -EINVAL;
-		goto unlock_vm;
-	}
+	if (!vma)
+		return -EINVAL;
 
+	was_valid = vma_is_valid(tile, vma);
 	err = handle_vma_pagefault(tile, pf, vma);
+	if (err)
+		return err;
 
-unlock_vm:
-	if (!err)
-		vm->usm.last_fault_vma = vma;
-	up_write(&vm->lock);
-	xe_vm_put(vm);
+	vm->usm.last_fault_vma = vma;
+	if (!was_valid && !access_is_atomic(pf->access_type))
+		prefetch_next_vma(tile, vm, vma);
 
-	return err;
+	return 0;
 }
 
-static int send_pagefault_reply(struct xe_guc *guc,
-				struct xe_guc_pagefault_reply *reply)
+/*
+ * Faults from one ASID tend to arrive in bursts, so consecutive faults of a
+ * batch against the same VM share a single VM lookup and lock acquisition.
+ * Faults landing in a VMA bound earlier in the batch resolve through the
+ * last_fault_vma fast path without touching the page tables again.
+ */
+static void handle_pagefaults(struct xe_gt *gt, struct pagefault *pfs,
+			      int count)
 {
-	u32 action[] = {
-		XE_GUC_ACTION_PAGE_FAULT_RES_DESC,
-		reply->dw0,
-		reply->dw1,
-	};
+	struct xe_device *xe = gt_to_xe(gt);
+	struct xe_vm *vm = NULL;
+	u32 asid = 0;
+	int i, err;
 
-	return xe_guc_ct_send(&guc->ct, action, ARRAY_SIZE(action), 0, 0);
+	for (i = 0; i < count; ++i) {
+		struct pagefault *pf = &pfs[i];
+
+		/* SW isn't expected to handle TRTT faults */
+		if (pf->trva_fault) {
+			err = -EFAULT;
+			goto out;
+		}
+
+		if (!vm || pf->asid != asid) {
+			if (vm) {
+				up_write(&vm->lock);
+				xe_vm_put(vm);
+			}
+
+			asid = pf->asid;
+			vm = asid_to_vm(xe, asid);
+			if (IS_ERR(vm)) {
+				err = PTR_ERR(vm);
+				vm = NULL;
+				goto out;
+			}
+
+			/*
+			 * TODO: Change to read lock? Using write lock for
+			 * simplicity.
+			 */
+			down_write(&vm->lock);
+		}
+
+		err = handle_pagefault(gt, vm, pf);
+out:
+		if (unlikely(err)) {
+			print_pagefault(xe, pf);
+			pf->fault_unsuccessful = 1;
+			drm_dbg(&xe->drm, "Fault response: Unsuccessful %d\n", err);
+		}
+	}
+
+	if (vm) {
+		up_write(&vm->lock);
+		xe_vm_put(vm);
+	}
 }
 
-static void print_pagefault(struct xe_device *xe, struct pagefault *pf)
+static void send_pagefault_replies(struct xe_guc *guc, struct pagefault *pfs,
+				   int count)
 {
-	drm_dbg(&xe->drm, "\n\tASID: %d\n"
-		 "\tVFID: %d\n"
-		 "\tPDATA: 0x%04x\n"
-		 "\tFaulted Address: 0x%08x%08x\n"
-		 "\tFaultType: %d\n"
-		 "\tAccessType: %d\n"
-		 "\tFaultLevel: %d\n"
-		 "\tEngineClass: %d\n"
-		 "\tEngineInstance: %d\n",
-		 pf->asid, pf->vfid, pf->pdata, upper_32_bits(pf->page_addr),
-		 lower_32_bits(pf->page_addr),
-		 pf->fault_type, pf->access_type, pf->fault_level,
-		 pf->engine_class, pf->engine_instance);
+	struct xe_guc_ct *ct = &guc->ct;
+	int i;
+
+	/* One CT lock round trip for the whole batch */
+	mutex_lock(&ct->lock);
+	for (i = 0; i < count; ++i) {
+		struct pagefault *pf = &pfs[i];
+		u32 action[] = {
+			XE_GUC_ACTION_PAGE_FAULT_RES_DESC,
+			FIELD_PREP(PFR_VALID, 1) |
+			FIELD_PREP(PFR_SUCCESS, pf->fault_unsuccessful) |
+			FIELD_PREP(PFR_REPLY, PFR_ACCESS) |
+			FIELD_PREP(PFR_DESC_TYPE, FAULT_RESPONSE_DESC) |
+			FIELD_PREP(PFR_ASID, pf->asid),
+			FIELD_PREP(PFR_VFID, pf->vfid) |
+			FIELD_PREP(PFR_ENG_INSTANCE, pf->engine_instance) |
+			FIELD_PREP(PFR_ENG_CLASS, pf->engine_class) |
+			FIELD_PREP(PFR_PDATA, pf->pdata),
+		};
+
+		xe_guc_ct_send_locked(ct, action, ARRAY_SIZE(action), 0, 0);
+	}
+	mutex_unlock(&ct->lock);
 }
 
 #define PF_MSG_LEN_DW	4
@@ -355,38 +444,32 @@ int xe_guc_pagefault_handler(struct xe_guc *guc, u32 *msg, u32 len)
 
 #define USM_QUEUE_MAX_RUNTIME_MS	20
 
+/* Faults pulled off a queue and replied to in one go */
+#define PF_BATCH_SIZE	8
+
 static void pf_queue_work_func(struct work_struct *w)
 {
 	struct pf_queue *pf_queue = container_of(w, struct pf_queue, worker);
 	struct xe_gt *gt = pf_queue->gt;
-	struct xe_device *xe = gt_to_xe(gt);
-	struct xe_guc_pagefault_reply reply = {};
-	struct pagefault pf = {};
+	struct pagefault pfs[PF_BATCH_SIZE];
 	unsigned long threshold;
-	int ret;
+	int count;
 
 	threshold = jiffies + msecs_to_jiffies(USM_QUEUE_MAX_RUNTIME_MS);
 
-	while (get_pagefault(pf_queue, &pf)) {
-		ret = handle_pagefault(gt, &pf);
-		if (unlikely(ret)) {
-			print_pagefault(xe, &pf);
-			pf.fault_unsuccessful = 1;
-			drm_dbg(&xe->drm, "Fault response: Unsuccessful %d\n", ret);
+	for (;;) {
+		count = 0;
+		while (count < PF_BATCH_SIZE) {
+			pfs[count] = (struct pagefault){};
+			if (!get_pagefault(pf_queue, &pfs[count]))
+				break;
+			count++;
 		}
+		if (!count)
+			break;
 
-		reply.dw0 = FIELD_PREP(PFR_VALID, 1) |
-			FIELD_PREP(PFR_SUCCESS, pf.fault_unsuccessful) |
-			FIELD_PREP(PFR_REPLY, PFR_ACCESS) |
-			FIELD_PREP(PFR_DESC_TYPE, FAULT_RESPONSE_DESC) |
-			FIELD_PREP(PFR_ASID, pf.asid);
-
-		reply.dw1 = FIELD_PREP(PFR_VFID, pf.vfid) |
-			FIELD_PREP(PFR_ENG_INSTANCE, pf.engine_instance) |
-			FIELD_PREP(PFR_ENG_CLASS, pf.engine_class) |
-			FIELD_PREP(PFR_PDATA, pf.pdata);
-
-		send_pagefault_reply(&gt->uc.guc, &reply);
+		handle_pagefaults(gt, pfs, count);
+		send_pagefault_replies(&gt->uc.guc, pfs, count);
 
 		if (time_after(jiffies, threshold) &&
 		    pf_queue->tail != pf_queue->head) {
@@ -543,10 +626,90 @@ static struct xe_vma *get_acc_vma(struct xe_vm *vm, struct acc *acc)
 	return xe_vm_find_overlapping_vma(vm, page_va, SZ_4K);
 }
 
+/*
+ * Under oversubscription a BO promoted by the access counters can be evicted
+ * again by someone else's promotion. Don't promote the same BO twice within
+ * this window, or the two would keep bouncing each other out of VRAM.
+ */
+#define ACC_PROMOTE_COOLDOWN_MS		500
+
+/* Bytes a single VM may promote to VRAM per budget window */
+#define ACC_VM_BUDGET_BYTES		SZ_512M
+#define ACC_VM_BUDGET_WINDOW_MS		100
+
+static bool acc_budget_charge(struct xe_vm *vm, u64 size)
+{
+	unsigned long window = msecs_to_jiffies(ACC_VM_BUDGET_WINDOW_MS);
+	bool ret = false;
+
+	spin_lock(&vm->usm.acc_budget.lock);
+	if (time_after(jiffies, vm->usm.acc_budget.window_start + window)) {
+		vm->usm.acc_budget.window_start = jiffies;
+		vm->usm.acc_budget.used = 0;
+	}
+	if (vm->usm.acc_budget.used + size <= ACC_VM_BUDGET_BYTES) {
+		vm->usm.acc_budget.used += size;
+		ret = true;
+	}
+	spin_unlock(&vm->usm.acc_budget.lock);
+
+	return ret;
+}
+
+static void acc_budget_refund(struct xe_vm *vm, u64 size)
+{
+	spin_lock(&vm->usm.acc_budget.lock);
+	vm->usm.acc_budget.used -= min(size, vm->usm.acc_budget.used);
+	spin_unlock(&vm->usm.acc_budget.lock);
+}
+
+static int acc_promote(struct xe_gt *gt, struct drm_exec *exec,
+		       struct xe_vma *vma)
+{
+	struct xe_tile *tile = gt_to_tile(gt);
+	struct xe_bo *bo = xe_vma_bo(vma);
+	struct xe_vm *vm = xe_vma_vm(vma);
+	u64 size = bo->size;
+	int err;
+
+	err = xe_vm_lock_vma(exec, vma);
+	if (err)
+		return err;
+
+	if (xe_bo_is_vram(bo)) {
+		xe_gt_stats_incr(gt, XE_GT_STATS_ID_ACC_SKIP_RESIDENT, 1);
+		return 0;
+	}
+
+	if (bo->acc_promoted &&
+	    time_before(jiffies, bo->acc_promoted +
+			msecs_to_jiffies(ACC_PROMOTE_COOLDOWN_MS))) {
+		xe_gt_stats_incr(gt, XE_GT_STATS_ID_ACC_SKIP_HYSTERESIS, 1);
+		return 0;
+	}
+
+	if (!acc_budget_charge(vm, size)) {
+		xe_gt_stats_incr(gt, XE_GT_STATS_ID_ACC_SKIP_BUDGET, 1);
+		return 0;
+	}
+
+	/* Migrate to VRAM, move should invalidate the VMA first */
+	err = xe_bo_migrate(bo, XE_PL_VRAM0 + tile->id);
+	if (err) {
+		acc_budget_refund(vm, size);
+		return err;
+	}
+
+	bo->acc_promoted = jiffies ?: 1;
+	xe_gt_stats_incr(gt, XE_GT_STATS_ID_ACC_PROMOTE, 1);
+	xe_gt_stats_incr(gt, XE_GT_STATS_ID_ACC_PROMOTE_KB, size / SZ_1K);
+
+	return 0;
+}
+
 static int handle_acc(struct xe_gt *gt, struct acc *acc)
 {
 	struct xe_device *xe = gt_to_xe(gt);
-	struct xe_tile *tile = gt_to_tile(gt);
 	struct drm_exec exec;
 	struct xe_vm *vm;
 	struct xe_vma *vma;
@@ -572,13 +735,13 @@ static int handle_acc(struct xe_gt *gt, struct acc *acc)
 	trace_xe_vma_acc(vma);
 
 	/* Userptr or null can't be migrated, nothing to do */
-	if (xe_vma_has_no_bo(vma))
+	if (xe_vma_has_no_bo(vma) || !IS_DGFX(xe))
 		goto unlock_vm;
 
 	/* Lock VM and BOs dma-resv */
 	drm_exec_init(&exec, 0, 0);
 	drm_exec_until_all_locked(&exec) {
-		ret = xe_pf_begin(&exec, vma, true, tile->id);
+		ret = acc_promote(gt, &exec, vma);
 		drm_exec_retry_on_contention(&exec);
 		if (ret)
 			break;
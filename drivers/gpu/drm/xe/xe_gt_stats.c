@@ -28,6 +28,12 @@ void xe_gt_stats_incr(struct xe_gt *gt, const enum xe_gt_stats_id id, int incr)
 
 static const char *const stat_description[__XE_GT_STATS_NUM_IDS] = {
 	"tlb_inval_count",
+	"tlb_inval_coalesced_count",
+	"acc_promote_count",
+	"acc_promote_kb",
+	"acc_skip_resident_count",
+	"acc_skip_hysteresis_count",
+	"acc_skip_budget_count",
 };
 
 /**
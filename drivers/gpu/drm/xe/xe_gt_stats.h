@@ -11,6 +11,12 @@ struct drm_printer;
 
 enum xe_gt_stats_id {
 	XE_GT_STATS_ID_TLB_INVAL,
+	XE_GT_STATS_ID_TLB_INVAL_COALESCED,
+	XE_GT_STATS_ID_ACC_PROMOTE,
+	XE_GT_STATS_ID_ACC_PROMOTE_KB,
+	XE_GT_STATS_ID_ACC_SKIP_RESIDENT,
+	XE_GT_STATS_ID_ACC_SKIP_HYSTERESIS,
+	XE_GT_STATS_ID_ACC_SKIP_BUDGET,
 	/* must be the last entry */
 	__XE_GT_STATS_NUM_IDS,
 };
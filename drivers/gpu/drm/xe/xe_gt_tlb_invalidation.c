@@ -5,6 +5,10 @@
 
 #include "xe_gt_tlb_invalidation.h"
 
+#include <linux/sched/mm.h>
+
+#include <drm/drm_managed.h>
+
 #include "abi/guc_actions_abi.h"
 #include "xe_device.h"
 #include "xe_force_wake.h"
@@ -105,6 +109,28 @@ static void xe_gt_tlb_fence_timeout(struct work_struct *work)
 	spin_unlock_irq(&gt->tlb_invalidation.pending_lock);
 }
 
+static void xe_gt_tlb_invalidation_batch_work(struct work_struct *work)
+{
+	struct xe_gt *gt = container_of(work, struct xe_gt,
+					tlb_invalidation.batch.work);
+	int err;
+
+	/* The fences carry the error to their waiters */
+	err = xe_gt_tlb_invalidation_flush(gt);
+	if (err)
+		xe_gt_err(gt, "batched TLB invalidation failed: %pe\n",
+			  ERR_PTR(err));
+}
+
+static void xe_gt_tlb_invalidation_fini(struct drm_device *drm, void *arg)
+{
+	struct xe_gt *gt = arg;
+
+	flush_work(&gt->tlb_invalidation.batch.work);
+	xe_gt_tlb_invalidation_flush(gt);
+	mutex_destroy(&gt->tlb_invalidation.batch.lock);
+}
+
 /**
  * xe_gt_tlb_invalidation_init_early - Initialize GT TLB invalidation state
  * @gt: graphics tile
@@ -116,6 +142,8 @@ static void xe_gt_tlb_fence_timeout(struct work_struct *work)
  */
 int xe_gt_tlb_invalidation_init_early(struct xe_gt *gt)
 {
+	int i;
+
 	gt->tlb_invalidation.seqno = 1;
 	INIT_LIST_HEAD(&gt->tlb_invalidation.pending_fences);
 	spin_lock_init(&gt->tlb_invalidation.pending_lock);
@@ -123,7 +151,19 @@ int xe_gt_tlb_invalidation_init_early(struct xe_gt *gt)
 	INIT_DELAYED_WORK(&gt->tlb_invalidation.fence_tdr,
 			  xe_gt_tlb_fence_timeout);
 
-	return 0;
+	mutex_init(&gt->tlb_invalidation.batch.lock);
+	for (i = 0; i < XE_GT_TLB_INVALIDATION_BATCH_SIZE; i++)
+		INIT_LIST_HEAD(&gt->tlb_invalidation.batch.ranges[i].fences);
+	INIT_WORK(&gt->tlb_invalidation.batch.work,
+		  xe_gt_tlb_invalidation_batch_work);
+
+	/* Invalidations are issued from the MMU notifier */
+	fs_reclaim_acquire(GFP_KERNEL);
+	might_lock(&gt->tlb_invalidation.batch.lock);
+	fs_reclaim_release(GFP_KERNEL);
+
+	return drmm_add_action_or_reset(&gt_to_xe(gt)->drm,
+					xe_gt_tlb_invalidation_fini, gt);
 }
 
 /**
@@ -178,16 +218,37 @@ static bool tlb_invalidation_seqno_past(struct xe_gt *gt, int seqno)
 	return seqno_recv >= seqno;
 }
 
-static int send_tlb_invalidation(struct xe_guc *guc,
-				 struct xe_gt_tlb_invalidation_fence *fence,
-				 u32 *action, int len)
+/*
+ * Signal all of @fences, linked by their link, with @err after their TLB
+ * invalidation could not be sent.
+ */
+static void signal_tlb_invalidation_fences(struct xe_device *xe,
+					   struct list_head *fences, int err)
+{
+	struct xe_gt_tlb_invalidation_fence *fence, *next;
+
+	list_for_each_entry_safe(fence, next, fences, link) {
+		fence->base.error = err;
+		invalidation_fence_signal(xe, fence);
+	}
+}
+
+/*
+ * Send one TLB invalidation and signal all of @fences, linked by their link,
+ * once it completes. On success @fences is empty on return, on error it is
+ * left to the caller.
+ */
+static int send_tlb_invalidation_fences(struct xe_guc *guc,
+					struct list_head *fences,
+					u32 *action, int len)
 {
 	struct xe_gt *gt = guc_to_gt(guc);
 	struct xe_device *xe = gt_to_xe(gt);
+	struct xe_gt_tlb_invalidation_fence *fence, *next;
 	int seqno;
 	int ret;
 
-	xe_gt_assert(gt, fence);
+	xe_gt_assert(gt, !list_empty(fences));
 
 	/*
 	 * XXX: The seqno algorithm relies on TLB invalidation being processed
@@ -197,34 +258,40 @@ static int send_tlb_invalidation(struct xe_guc *guc,
 
 	mutex_lock(&guc->ct.lock);
 	seqno = gt->tlb_invalidation.seqno;
-	fence->seqno = seqno;
-	trace_xe_gt_tlb_invalidation_fence_send(xe, fence);
+	list_for_each_entry(fence, fences, link) {
+		fence->seqno = seqno;
+		trace_xe_gt_tlb_invalidation_fence_send(xe, fence);
+	}
 	action[1] = seqno;
 	ret = xe_guc_ct_send_locked(&guc->ct, action, len,
 				    G2H_LEN_DW_TLB_INVALIDATE, 1);
 	if (!ret) {
 		spin_lock_irq(&gt->tlb_invalidation.pending_lock);
 		/*
-		 * We haven't actually published the TLB fence as per
+		 * We haven't actually published the TLB fences as per
 		 * pending_fences, but in theory our seqno could have already
 		 * been written as we acquired the pending_lock. In such a case
-		 * we can just go ahead and signal the fence here.
+		 * we can just go ahead and signal the fences here.
 		 */
 		if (tlb_invalidation_seqno_past(gt, seqno)) {
-			__invalidation_fence_signal(xe, fence);
+			list_for_each_entry_safe(fence, next, fences, link)
+				invalidation_fence_signal(xe, fence);
 		} else {
-			fence->invalidation_time = ktime_get();
-			list_add_tail(&fence->link,
-				      &gt->tlb_invalidation.pending_fences);
+			bool was_empty =
+				list_empty(&gt->tlb_invalidation.pending_fences);
+			ktime_t now = ktime_get();
+
+			list_for_each_entry(fence, fences, link)
+				fence->invalidation_time = now;
+			list_splice_tail_init(fences,
+					      &gt->tlb_invalidation.pending_fences);
 
-			if (list_is_singular(&gt->tlb_invalidation.pending_fences))
+			if (was_empty)
 				queue_delayed_work(system_wq,
 						   &gt->tlb_invalidation.fence_tdr,
 						   tlb_timeout_jiffies(gt));
 		}
 		spin_unlock_irq(&gt->tlb_invalidation.pending_lock);
-	} else {
-		__invalidation_fence_signal(xe, fence);
 	}
 	if (!ret) {
 		gt->tlb_invalidation.seqno = (gt->tlb_invalidation.seqno + 1) %
@@ -238,6 +305,24 @@ static int send_tlb_invalidation(struct xe_guc *guc,
 	return ret;
 }
 
+static int send_tlb_invalidation(struct xe_guc *guc,
+				 struct xe_gt_tlb_invalidation_fence *fence,
+				 u32 *action, int len)
+{
+	LIST_HEAD(fences);
+	int ret;
+
+	xe_gt_assert(guc_to_gt(guc), fence);
+
+	list_add_tail(&fence->link, &fences);
+
+	ret = send_tlb_invalidation_fences(guc, &fences, action, len);
+	if (ret)
+		signal_tlb_invalidation_fences(guc_to_xe(guc), &fences, ret);
+
+	return ret;
+}
+
 #define MAKE_INVAL_OP(type)	((type << XE_GUC_TLB_INVAL_TYPE_SHIFT) | \
 		XE_GUC_TLB_INVAL_MODE_HEAVY << XE_GUC_TLB_INVAL_MODE_SHIFT | \
 		XE_GUC_TLB_INVAL_FLUSH_CACHE)
@@ -313,39 +398,16 @@ int xe_gt_tlb_invalidation_ggtt(struct xe_gt *gt)
 	return 0;
 }
 
-/**
- * xe_gt_tlb_invalidation_range - Issue a TLB invalidation on this GT for an
- * address range
- *
- * @gt: graphics tile
- * @fence: invalidation fence which will be signal on TLB invalidation
- * completion
- * @start: start address
- * @end: end address
- * @asid: address space id
- *
- * Issue a range based TLB invalidation if supported, if not fallback to a full
- * TLB invalidation. Completion of TLB is asynchronous and caller can use
- * the invalidation fence to wait for completion.
- *
- * Return: Negative error code on error, 0 on success
- */
-int xe_gt_tlb_invalidation_range(struct xe_gt *gt,
-				 struct xe_gt_tlb_invalidation_fence *fence,
-				 u64 start, u64 end, u32 asid)
+static int send_tlb_invalidation_range(struct xe_gt *gt,
+				       struct xe_gt_tlb_invalidation_range *range)
 {
 	struct xe_device *xe = gt_to_xe(gt);
 #define MAX_TLB_INVALIDATION_LEN	7
 	u32 action[MAX_TLB_INVALIDATION_LEN];
+	u64 start = range->start, end = range->end;
+	u32 asid = range->asid;
 	int len = 0;
-
-	xe_gt_assert(gt, fence);
-
-	/* Execlists not supported */
-	if (gt_to_xe(gt)->info.force_execlist) {
-		__invalidation_fence_signal(xe, fence);
-		return 0;
-	}
+	int ret;
 
 	action[len++] = XE_GUC_ACTION_TLB_INVALIDATION;
 	action[len++] = 0; /* seqno, replaced in send_tlb_invalidation */
@@ -398,7 +460,187 @@ int xe_gt_tlb_invalidation_range(struct xe_gt *gt,
 
 	xe_gt_assert(gt, len <= MAX_TLB_INVALIDATION_LEN);
 
-	return send_tlb_invalidation(&gt->uc.guc, fence, action, len);
+	ret = send_tlb_invalidation_fences(&gt->uc.guc, &range->fences,
+					   action, len);
+	if (ret && len > 3) {
+		/* Fall back to a full invalidation covering the range */
+		action[2] = MAKE_INVAL_OP(XE_GUC_TLB_INVAL_FULL);
+		ret = send_tlb_invalidation_fences(&gt->uc.guc, &range->fences,
+						   action, 3);
+	}
+	if (ret)
+		signal_tlb_invalidation_fences(xe, &range->fences, ret);
+
+	return ret;
+}
+
+/* Called with batch.lock held */
+static int __xe_gt_tlb_invalidation_flush(struct xe_gt *gt)
+{
+	struct xe_gt_tlb_invalidation_range *range;
+	int i, err, ret = 0;
+
+	lockdep_assert_held(&gt->tlb_invalidation.batch.lock);
+
+	for (i = 0; i < gt->tlb_invalidation.batch.count; i++) {
+		range = &gt->tlb_invalidation.batch.ranges[i];
+		err = send_tlb_invalidation_range(gt, range);
+		if (err && !ret)
+			ret = err;
+	}
+	gt->tlb_invalidation.batch.count = 0;
+
+	return ret;
+}
+
+/**
+ * xe_gt_tlb_invalidation_flush - Send the batched range TLB invalidations
+ * @gt: graphics tile
+ *
+ * Send the range invalidations coalesced so far right away instead of from the
+ * batch worker, e.g. before waiting for their fences. The fences of an
+ * invalidation that could not be sent are signaled with the error.
+ *
+ * Return: 0 on success, the first error if any invalidation failed
+ */
+int xe_gt_tlb_invalidation_flush(struct xe_gt *gt)
+{
+	int ret;
+
+	mutex_lock(&gt->tlb_invalidation.batch.lock);
+	ret = __xe_gt_tlb_invalidation_flush(gt);
+	mutex_unlock(&gt->tlb_invalidation.batch.lock);
+
+	return ret;
+}
+
+static bool tlb_invalidation_range_merge(struct xe_gt_tlb_invalidation_range *range,
+					 u64 start, u64 end, u32 asid)
+{
+	if (range->asid != asid || start > range->end || end < range->start)
+		return false;
+
+	range->start = min(range->start, start);
+	range->end = max(range->end, end);
+	return true;
+}
+
+/**
+ * xe_gt_tlb_invalidation_range - Issue a TLB invalidation on this GT for an
+ * address range
+ *
+ * @gt: graphics tile
+ * @fence: invalidation fence which will be signal on TLB invalidation
+ * completion
+ * @start: start address
+ * @end: end address
+ * @asid: address space id
+ *
+ * Issue a range based TLB invalidation if supported, if not fallback to a full
+ * TLB invalidation. Completion of TLB is asynchronous and caller can use
+ * the invalidation fence to wait for completion.
+ *
+ * The invalidation is not sent right away but added to a batch sent by a
+ * worker, or by xe_gt_tlb_invalidation_flush(). Ranges of the same ASID that
+ * overlap or are adjacent are merged and sent as one invalidation, all
+ * without range invalidation support are merged into one full invalidation.
+ * When the batch is full, the ranges of the ASID are merged into an
+ * invalidation of the whole ASID, or the batch is sent if the ASID has none.
+ *
+ * Return: Negative error code on error, 0 on success
+ */
+int xe_gt_tlb_invalidation_range(struct xe_gt *gt,
+				 struct xe_gt_tlb_invalidation_fence *fence,
+				 u64 start, u64 end, u32 asid)
+{
+	struct xe_device *xe = gt_to_xe(gt);
+	struct xe_gt_tlb_invalidation_range *range = NULL;
+	bool queue;
+	int i;
+
+	xe_gt_assert(gt, fence);
+
+	/* Execlists not supported */
+	if (gt_to_xe(gt)->info.force_execlist) {
+		__invalidation_fence_signal(xe, fence);
+		return 0;
+	}
+
+	/* All full invalidations are the same */
+	if (!xe->info.has_range_tlb_invalidation) {
+		start = 0;
+		end = 0;
+		asid = 0;
+	}
+
+	mutex_lock(&gt->tlb_invalidation.batch.lock);
+	queue = !gt->tlb_invalidation.batch.count;
+
+	for (i = 0; i < gt->tlb_invalidation.batch.count; i++) {
+		if (tlb_invalidation_range_merge(&gt->tlb_invalidation.batch.ranges[i],
+						 start, end, asid)) {
+			range = &gt->tlb_invalidation.batch.ranges[i];
+			break;
+		}
+	}
+
+	if (!range && gt->tlb_invalidation.batch.count ==
+	    XE_GT_TLB_INVALIDATION_BATCH_SIZE) {
+		/* Escalate to the whole ASID, merging all its ranges */
+		for (i = 0; i < gt->tlb_invalidation.batch.count; i++) {
+			struct xe_gt_tlb_invalidation_range *r =
+				&gt->tlb_invalidation.batch.ranges[i];
+			struct xe_gt_tlb_invalidation_range *last;
+
+			if (r->asid != asid)
+				continue;
+
+			if (!range) {
+				range = r;
+				range->start = 0;
+				range->end = BIT_ULL(xe->info.va_bits);
+				continue;
+			}
+
+			/* Fill the hole with the last range and look again */
+			list_splice_tail_init(&r->fences, &range->fences);
+			last = &gt->tlb_invalidation.batch.ranges[--gt->tlb_invalidation.batch.count];
+			if (last != r) {
+				list_splice_tail_init(&last->fences, &r->fences);
+				r->start = last->start;
+				r->end = last->end;
+				r->asid = last->asid;
+				i--;
+			}
+		}
+	}
+
+	if (range) {
+		xe_gt_stats_incr(gt, XE_GT_STATS_ID_TLB_INVAL_COALESCED, 1);
+	} else {
+		if (gt->tlb_invalidation.batch.count ==
+		    XE_GT_TLB_INVALIDATION_BATCH_SIZE) {
+			/*
+			 * Flush without dropping the lock, so that the batch
+			 * can't fill up again before we add our range. Errors
+			 * reach the waiters through the flushed fences.
+			 */
+			__xe_gt_tlb_invalidation_flush(gt);
+			queue = true;
+		}
+
+		range = &gt->tlb_invalidation.batch.ranges[gt->tlb_invalidation.batch.count++];
+		range->start = start;
+		range->end = end;
+		range->asid = asid;
+	}
+	list_add_tail(&fence->link, &range->fences);
+	mutex_unlock(&gt->tlb_invalidation.batch.lock);
+
+	if (queue)
+		queue_work(system_wq, &gt->tlb_invalidation.batch.work);
+
+	return 0;
 }
 
 /**
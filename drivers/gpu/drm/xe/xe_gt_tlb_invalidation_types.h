@@ -29,4 +29,21 @@ struct xe_gt_tlb_invalidation_fence {
 	ktime_t invalidation_time;
 };
 
+/**
+ * struct xe_gt_tlb_invalidation_range - Coalesced range TLB invalidation
+ *
+ * Range invalidations of the same ASID that overlap or are adjacent are
+ * merged into one of these while waiting in the batch of the GT.
+ */
+struct xe_gt_tlb_invalidation_range {
+	/** @fences: invalidation fences to signal once the range is invalidated */
+	struct list_head fences;
+	/** @start: start address */
+	u64 start;
+	/** @end: end address */
+	u64 end;
+	/** @asid: address space id */
+	u32 asid;
+};
+
 #endif
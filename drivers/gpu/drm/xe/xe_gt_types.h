@@ -12,6 +12,7 @@
 #include "xe_gt_sriov_pf_types.h"
 #include "xe_gt_sriov_vf_types.h"
 #include "xe_gt_stats.h"
+#include "xe_gt_tlb_invalidation_types.h"
 #include "xe_hw_engine_types.h"
 #include "xe_hw_fence_types.h"
 #include "xe_oa.h"
@@ -210,6 +211,25 @@ struct xe_gt {
 		struct delayed_work fence_tdr;
 		/** @tlb_invalidation.lock: protects TLB invalidation fences */
 		spinlock_t lock;
+		/**
+		 * @tlb_invalidation.batch: range invalidations waiting to be
+		 * coalesced and sent
+		 */
+		struct {
+			/**
+			 * @tlb_invalidation.batch.lock: protects the batch, held
+			 * while it is sent
+			 */
+			struct mutex lock;
+#define XE_GT_TLB_INVALIDATION_BATCH_SIZE	8
+			/** @tlb_invalidation.batch.ranges: coalesced ranges */
+			struct xe_gt_tlb_invalidation_range
+				ranges[XE_GT_TLB_INVALIDATION_BATCH_SIZE];
+			/** @tlb_invalidation.batch.count: number of used ranges */
+			int count;
+			/** @tlb_invalidation.batch.work: sends the batch */
+			struct work_struct work;
+		} batch;
 	} tlb_invalidation;
 
 	/**
@@ -271,7 +291,7 @@ struct xe_gt {
 			spinlock_t lock;
 			/** @usm.pf_queue.worker: to process page faults */
 			struct work_struct worker;
-#define NUM_PF_QUEUE	4
+#define NUM_PF_QUEUE	8
 		} pf_queue[NUM_PF_QUEUE];
 		/**
 		 * @usm.acc_queue: Same as page fault queue, cannot process access
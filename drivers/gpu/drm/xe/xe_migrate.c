@@ -6,6 +6,7 @@
 #include "xe_migrate.h"
 
 #include <linux/bitfield.h>
+#include <linux/dma-fence-array.h>
 #include <linux/sizes.h>
 
 #include <drm/drm_managed.h>
@@ -35,12 +36,23 @@
 #include "xe_trace_bo.h"
 #include "xe_vm.h"
 
+#define MAX_MIGRATE_LANES 4
+
 /**
  * struct xe_migrate - migrate context.
  */
 struct xe_migrate {
 	/** @q: Default exec queue used for migration */
 	struct xe_exec_queue *q;
+	/**
+	 * @lane_q: Exec queues of the other copy engines, copies and clears
+	 * are spread over @q and these. See xe_migrate_lane_q().
+	 */
+	struct xe_exec_queue *lane_q[MAX_MIGRATE_LANES - 1];
+	/** @num_lanes: Number of exec queues, including @q */
+	u32 num_lanes;
+	/** @lane_pts: Number of kernel PT slots each lane uses */
+	u32 lane_pts;
 	/** @tile: Backpointer to the tile this struct xe_migrate belongs to. */
 	struct xe_tile *tile;
 	/** @job_mutex: Timeline mutex for @eng. */
@@ -58,6 +70,11 @@ struct xe_migrate {
 	 * Protected by @job_mutex.
 	 */
 	struct dma_fence *fence;
+	/**
+	 * @lane_fence: dma-fences representing the last job of each of
+	 * @lane_q. Protected by @job_mutex.
+	 */
+	struct dma_fence *lane_fence[MAX_MIGRATE_LANES - 1];
 	/**
 	 * @vm_update_sa: For integrated, used to suballocate page-tables
 	 * out of the pt_bo.
@@ -100,11 +117,16 @@ struct xe_exec_queue *xe_tile_migrate_exec_queue(struct xe_tile *tile)
 static void xe_migrate_fini(struct drm_device *dev, void *arg)
 {
 	struct xe_migrate *m = arg;
+	u32 i;
 
 	xe_vm_lock(m->q->vm, false);
 	xe_bo_unpin(m->pt_bo);
 	xe_vm_unlock(m->q->vm);
 
+	for (i = 0; i < m->num_lanes - 1; i++) {
+		dma_fence_put(m->lane_fence[i]);
+		xe_exec_queue_put(m->lane_q[i]);
+	}
 	dma_fence_put(m->fence);
 	xe_bo_put(m->pt_bo);
 	drm_suballoc_manager_fini(&m->vm_update_sa);
@@ -387,6 +409,127 @@ static bool xe_migrate_needs_ccs_emit(struct xe_device *xe)
 	return xe_device_has_flat_ccs(xe) && !(GRAPHICS_VER(xe) >= 20 && IS_DGFX(xe));
 }
 
+/*
+ * Without page faults there is no need for a reserved copy engine, and copies
+ * and clears can be spread over all of them. Pin the default exec queue to the
+ * first copy engine and create one exec queue per other copy engine, each
+ * using its own range of the kernel PT slots. Sharing the slots between more
+ * lanes makes the chunks of each lane smaller, but the engines process them
+ * in parallel and one lane writes the PTEs of its chunk while the others copy.
+ */
+static struct xe_exec_queue *xe_migrate_create_lanes(struct xe_migrate *m,
+						     struct xe_gt *gt,
+						     struct xe_vm *vm)
+{
+	u32 flags = EXEC_QUEUE_FLAG_KERNEL | EXEC_QUEUE_FLAG_PERMANENT;
+	struct xe_hw_engine *hwe, *engines[MAX_MIGRATE_LANES];
+	struct xe_device *xe = gt_to_xe(gt);
+	struct xe_exec_queue *q;
+	enum xe_hw_engine_id id;
+	u32 num_engines = 0, i;
+
+	for_each_hw_engine(hwe, gt, id) {
+		if (hwe->class != XE_ENGINE_CLASS_COPY ||
+		    xe_hw_engine_is_reserved(hwe))
+			continue;
+
+		if (num_engines < MAX_MIGRATE_LANES)
+			engines[num_engines++] = hwe;
+	}
+
+	if (num_engines < 2)
+		return xe_exec_queue_create_class(xe, gt, vm,
+						  XE_ENGINE_CLASS_COPY, flags, 0);
+
+	q = xe_exec_queue_create(xe, vm, BIT(engines[0]->logical_instance), 1,
+				 engines[0], flags, 0);
+	if (IS_ERR(q))
+		return q;
+
+	for (i = 1; i < num_engines; i++) {
+		struct xe_exec_queue *lane_q;
+
+		lane_q = xe_exec_queue_create(xe, vm,
+					      BIT(engines[i]->logical_instance),
+					      1, engines[i], flags, 0);
+		/* Not fatal, use the lanes created so far */
+		if (IS_ERR(lane_q))
+			break;
+
+		m->lane_q[m->num_lanes++ - 1] = lane_q;
+	}
+
+	return q;
+}
+
+static struct xe_exec_queue *xe_migrate_lane_q(struct xe_migrate *m, u32 lane)
+{
+	return lane ? m->lane_q[lane - 1] : m->q;
+}
+
+/* Track the last job of a lane, with the job_mutex held */
+static void xe_migrate_set_lane_fence(struct xe_migrate *m, u32 lane,
+				      struct dma_fence *fence)
+{
+	struct dma_fence **last = lane ? &m->lane_fence[lane - 1] : &m->fence;
+
+	lockdep_assert_held(&m->job_mutex);
+
+	dma_fence_put(*last);
+	*last = dma_fence_get(fence);
+}
+
+/*
+ * Return a fence signaling when the last jobs of a copy or clear on all the
+ * lanes it used completed, consuming the references in @fences. Lanes are
+ * used in order, so the used ones are the first ones.
+ */
+static struct dma_fence *xe_migrate_lanes_fence(struct xe_migrate *m,
+						struct dma_fence **fences)
+{
+	struct dma_fence_array *cf;
+	struct dma_fence **array;
+	u32 num_fences = 0, i;
+
+	while (num_fences < m->num_lanes && fences[num_fences])
+		num_fences++;
+	if (num_fences <= 1)
+		return fences[0];
+
+	array = kmemdup(fences, num_fences * sizeof(*fences), GFP_KERNEL);
+	if (array) {
+		cf = dma_fence_array_create(num_fences, array,
+					    dma_fence_context_alloc(1), 1,
+					    false);
+		if (cf)
+			return &cf->base;
+		kfree(array);
+	}
+
+	/* Out of memory, wait for the other lanes instead */
+	for (i = 1; i < num_fences; i++) {
+		dma_fence_wait(fences[i], false);
+		dma_fence_put(fences[i]);
+	}
+
+	return fences[0];
+}
+
+/* Sync a partial copy or clear and drop the references in @fences */
+static void xe_migrate_lanes_sync(struct xe_migrate *m,
+				  struct dma_fence **fences)
+{
+	u32 i;
+
+	for (i = 0; i < m->num_lanes; i++) {
+		if (!fences[i])
+			continue;
+
+		dma_fence_wait(fences[i], false);
+		dma_fence_put(fences[i]);
+	}
+}
+
 /**
  * xe_migrate_init() - Initialize a migrate context
  * @tile: Back-pointer to the tile we're initializing for.
@@ -406,6 +549,7 @@ struct xe_migrate *xe_migrate_init(struct xe_tile *tile)
 		return ERR_PTR(-ENOMEM);
 
 	m->tile = tile;
+	m->num_lanes = 1;
 
 	/* Special layout, prepared below.. */
 	vm = xe_vm_create(xe, XE_VM_FLAG_MIGRATION |
@@ -440,16 +584,18 @@ struct xe_migrate *xe_migrate_init(struct xe_tile *tile)
 					    EXEC_QUEUE_FLAG_PERMANENT |
 					    EXEC_QUEUE_FLAG_HIGH_PRIORITY, 0);
 	} else {
-		m->q = xe_exec_queue_create_class(xe, primary_gt, vm,
-						  XE_ENGINE_CLASS_COPY,
-						  EXEC_QUEUE_FLAG_KERNEL |
-						  EXEC_QUEUE_FLAG_PERMANENT, 0);
+		m->q = xe_migrate_create_lanes(m, primary_gt, vm);
 	}
 	if (IS_ERR(m->q)) {
 		xe_vm_close_and_put(vm);
 		return ERR_CAST(m->q);
 	}
 
+	/* The last kernel PT slot is reserved for the 4KiB page table updates */
+	m->lane_pts = (NUM_KERNEL_PDE - 1) / m->num_lanes;
+	if (m->num_lanes > 1)
+		drm_dbg(&xe->drm, "Migrate uses %u copy engines\n", m->num_lanes);
+
 	mutex_init(&m->job_mutex);
 	fs_reclaim_acquire(GFP_KERNEL);
 	might_lock(&m->job_mutex);
@@ -767,9 +913,10 @@ struct dma_fence *xe_migrate_copy(struct xe_migrate *m,
 {
 	struct xe_gt *gt = m->tile->primary_gt;
 	struct xe_device *xe = gt_to_xe(gt);
-	struct dma_fence *fence = NULL;
+	struct dma_fence *fences[MAX_MIGRATE_LANES] = {};
 	u64 size = src_bo->size;
 	struct xe_res_cursor src_it, dst_it, ccs_it;
+	u32 lane = 0;
 	u64 src_L0_ofs, dst_L0_ofs;
 	u32 src_L0_pt, dst_L0_pt;
 	u64 src_L0, dst_L0;
@@ -817,7 +964,10 @@ struct dma_fence *xe_migrate_copy(struct xe_migrate *m,
 		u32 pte_flags;
 
 		bool usm = xe->info.has_usm;
-		u32 avail_pts = max_mem_transfer_per_pass(xe) / LEVEL0_PAGE_TABLE_ENCODE_SIZE;
+		u32 pt_base = lane * m->lane_pts;
+		u32 avail_pts = min_t(u32, max_mem_transfer_per_pass(xe) /
+				      LEVEL0_PAGE_TABLE_ENCODE_SIZE,
+				      m->lane_pts / 3);
 
 		src_L0 = xe_migrate_res_sizes(m, &src_it);
 		dst_L0 = xe_migrate_res_sizes(m, &dst_it);
@@ -830,19 +980,19 @@ struct dma_fence *xe_migrate_copy(struct xe_migrate *m,
 		pte_flags = src_is_vram ? PTE_UPDATE_FLAG_IS_VRAM : 0;
 		pte_flags |= use_comp_pat ? PTE_UPDATE_FLAG_IS_COMP_PTE : 0;
 		batch_size += pte_update_size(m, pte_flags, src, &src_it, &src_L0,
-					      &src_L0_ofs, &src_L0_pt, 0, 0,
+					      &src_L0_ofs, &src_L0_pt, 0, pt_base,
 					      avail_pts);
 
 		pte_flags = dst_is_vram ? PTE_UPDATE_FLAG_IS_VRAM : 0;
 		batch_size += pte_update_size(m, pte_flags, dst, &dst_it, &src_L0,
 					      &dst_L0_ofs, &dst_L0_pt, 0,
-					      avail_pts, avail_pts);
+					      pt_base + avail_pts, avail_pts);
 
 		if (copy_system_ccs) {
 			ccs_size = xe_device_ccs_bytes(xe, src_L0);
 			batch_size += pte_update_size(m, 0, NULL, &ccs_it, &ccs_size,
 						      &ccs_ofs, &ccs_pt, 0,
-						      2 * avail_pts,
+						      pt_base + 2 * avail_pts,
 						      avail_pts);
 			xe_assert(xe, IS_ALIGNED(ccs_it.start, PAGE_SIZE));
 		}
@@ -885,7 +1035,7 @@ struct dma_fence *xe_migrate_copy(struct xe_migrate *m,
 							  IS_DGFX(xe) ? dst_is_vram : dst_is_pltt,
 							  src_L0, ccs_ofs, copy_ccs);
 
-		job = xe_bb_create_migration_job(m->q, bb,
+		job = xe_bb_create_migration_job(xe_migrate_lane_q(m, lane), bb,
 						 xe_migrate_batch_base(m, usm),
 						 update_idx);
 		if (IS_ERR(job)) {
@@ -894,7 +1044,7 @@ struct dma_fence *xe_migrate_copy(struct xe_migrate *m,
 		}
 
 		xe_sched_job_add_migrate_flush(job, flush_flags);
-		if (!fence) {
+		if (!fences[lane]) {
 			err = xe_sched_job_add_deps(job, src_bo->ttm.base.resv,
 						    DMA_RESV_USAGE_BOOKKEEP);
 			if (!err && src_bo != dst_bo)
@@ -906,17 +1056,17 @@ struct dma_fence *xe_migrate_copy(struct xe_migrate *m,
 
 		mutex_lock(&m->job_mutex);
 		xe_sched_job_arm(job);
-		dma_fence_put(fence);
-		fence = dma_fence_get(&job->drm.s_fence->finished);
+		dma_fence_put(fences[lane]);
+		fences[lane] = dma_fence_get(&job->drm.s_fence->finished);
 		xe_sched_job_push(job);
 
-		dma_fence_put(m->fence);
-		m->fence = dma_fence_get(fence);
+		xe_migrate_set_lane_fence(m, lane, fences[lane]);
 
 		mutex_unlock(&m->job_mutex);
 
-		xe_bb_free(bb, fence);
+		xe_bb_free(bb, fences[lane]);
 		size -= src_L0;
+		lane = (lane + 1) % m->num_lanes;
 		continue;
 
 err_job:
@@ -926,15 +1076,12 @@ struct dma_fence *xe_migrate_copy(struct xe_migrate *m,
 
 err_sync:
 		/* Sync partial copy if any. FIXME: under job_mutex? */
-		if (fence) {
-			dma_fence_wait(fence, false);
-			dma_fence_put(fence);
-		}
+		xe_migrate_lanes_sync(m, fences);
 
 		return ERR_PTR(err);
 	}
 
-	return fence;
+	return xe_migrate_lanes_fence(m, fences);
 }
 
 static void emit_clear_link_copy(struct xe_gt *gt, struct xe_bb *bb, u64 src_ofs,
@@ -1060,10 +1207,11 @@ struct dma_fence *xe_migrate_clear(struct xe_migrate *m,
 	struct xe_gt *gt = m->tile->primary_gt;
 	struct xe_device *xe = gt_to_xe(gt);
 	bool clear_only_system_ccs = false;
-	struct dma_fence *fence = NULL;
+	struct dma_fence *fences[MAX_MIGRATE_LANES] = {};
 	u64 size = bo->size;
 	struct xe_res_cursor src_it;
 	struct ttm_resource *src = dst;
+	u32 lane = 0;
 	int err;
 
 	if (WARN_ON(!clear_bo_data && !clear_ccs))
@@ -1088,7 +1236,9 @@ struct dma_fence *xe_migrate_clear(struct xe_migrate *m,
 		u32 pte_flags;
 
 		bool usm = xe->info.has_usm;
-		u32 avail_pts = max_mem_transfer_per_pass(xe) / LEVEL0_PAGE_TABLE_ENCODE_SIZE;
+		u32 avail_pts = min_t(u32, max_mem_transfer_per_pass(xe) /
+				      LEVEL0_PAGE_TABLE_ENCODE_SIZE,
+				      m->lane_pts);
 
 		clear_L0 = xe_migrate_res_sizes(m, &src_it);
 
@@ -1097,8 +1247,8 @@ struct dma_fence *xe_migrate_clear(struct xe_migrate *m,
 		batch_size = 2 +
 			pte_update_size(m, pte_flags, src, &src_it,
 					&clear_L0, &clear_L0_ofs, &clear_L0_pt,
-					clear_bo_data ? emit_clear_cmd_len(gt) : 0, 0,
-					avail_pts);
+					clear_bo_data ? emit_clear_cmd_len(gt) : 0,
+					lane * m->lane_pts, avail_pts);
 
 		if (xe_migrate_needs_ccs_emit(xe))
 			batch_size += EMIT_COPY_CCS_DW;
@@ -1134,7 +1284,7 @@ struct dma_fence *xe_migrate_clear(struct xe_migrate *m,
 			flush_flags = MI_FLUSH_DW_CCS;
 		}
 
-		job = xe_bb_create_migration_job(m->q, bb,
+		job = xe_bb_create_migration_job(xe_migrate_lane_q(m, lane), bb,
 						 xe_migrate_batch_base(m, usm),
 						 update_idx);
 		if (IS_ERR(job)) {
@@ -1143,7 +1293,7 @@ struct dma_fence *xe_migrate_clear(struct xe_migrate *m,
 		}
 
 		xe_sched_job_add_migrate_flush(job, flush_flags);
-		if (!fence) {
+		if (!fences[lane]) {
 			/*
 			 * There can't be anything userspace related at this
 			 * point, so we just need to respect any potential move
@@ -1158,16 +1308,16 @@ struct dma_fence *xe_migrate_clear(struct xe_migrate *m,
 
 		mutex_lock(&m->job_mutex);
 		xe_sched_job_arm(job);
-		dma_fence_put(fence);
-		fence = dma_fence_get(&job->drm.s_fence->finished);
+		dma_fence_put(fences[lane]);
+		fences[lane] = dma_fence_get(&job->drm.s_fence->finished);
 		xe_sched_job_push(job);
 
-		dma_fence_put(m->fence);
-		m->fence = dma_fence_get(fence);
+		xe_migrate_set_lane_fence(m, lane, fences[lane]);
 
 		mutex_unlock(&m->job_mutex);
 
-		xe_bb_free(bb, fence);
+		xe_bb_free(bb, fences[lane]);
+		lane = (lane + 1) % m->num_lanes;
 		continue;
 
 err_job:
@@ -1176,10 +1326,7 @@ struct dma_fence *xe_migrate_clear(struct xe_migrate *m,
 		xe_bb_free(bb, NULL);
 err_sync:
 		/* Sync partial copies if any. FIXME: job_mutex? */
-		if (fence) {
-			dma_fence_wait(m->fence, false);
-			dma_fence_put(fence);
-		}
+		xe_migrate_lanes_sync(m, fences);
 
 		return ERR_PTR(err);
 	}
@@ -1187,7 +1334,7 @@ struct dma_fence *xe_migrate_clear(struct xe_migrate *m,
 	if (clear_ccs)
 		bo->ccs_cleared = true;
 
-	return fence;
+	return xe_migrate_lanes_fence(m, fences);
 }
 
 static void write_pgtable(struct xe_tile *tile, struct xe_bb *bb, u64 ppgtt_ofs,
@@ -1534,14 +1681,19 @@ xe_migrate_update_pgtables(struct xe_migrate *m,
  * xe_migrate_wait() - Complete all operations using the xe_migrate context
  * @m: Migrate context to wait for.
  *
- * Waits until the GPU no longer uses the migrate context's default engine
- * or its page-table objects. FIXME: What about separate page-table update
- * engines?
+ * Waits until the GPU no longer uses the migrate context's engines or its
+ * page-table objects. FIXME: What about separate page-table update engines?
  */
 void xe_migrate_wait(struct xe_migrate *m)
 {
+	u32 i;
+
 	if (m->fence)
 		dma_fence_wait(m->fence, false);
+
+	for (i = 0; i < m->num_lanes - 1; i++)
+		if (m->lane_fence[i])
+			dma_fence_wait(m->lane_fence[i], false);
 }
 
 #if IS_ENABLED(CONFIG_DRM_XE_KUNIT_TEST)
@@ -337,12 +337,47 @@ static int xe_oa_append_report(struct xe_oa_stream *stream, char __user *buf,
 	return 0;
 }
 
+static void xe_oa_consume_report(struct xe_oa_stream *stream, u8 *report)
+{
+	int report_size = stream->oa_buffer.format->size;
+
+	if (!(stream->oa_buffer.circ_size % report_size)) {
+		/* Clear out report id and timestamp to detect unlanded reports */
+		oa_report_id_clear(stream, (void *)report);
+		oa_timestamp_clear(stream, (void *)report);
+	} else {
+		u8 *oa_buf_base = stream->oa_buffer.vaddr;
+		u8 *oa_buf_end = oa_buf_base + stream->oa_buffer.circ_size;
+		u32 part = oa_buf_end - report;
+
+		/* Zero out the entire report */
+		if (report_size <= part) {
+			memset(report, 0, report_size);
+		} else {
+			memset(report, 0, part);
+			memset(oa_buf_base, 0, report_size - part);
+		}
+	}
+}
+
+static void xe_oa_update_head(struct xe_oa_stream *stream, u32 head)
+{
+	struct xe_reg oaheadptr = __oa_regs(stream)->oa_head_ptr;
+	u32 gtt_offset = xe_bo_ggtt_addr(stream->oa_buffer.bo);
+	unsigned long flags;
+
+	spin_lock_irqsave(&stream->oa_buffer.ptr_lock, flags);
+	xe_mmio_write32(&stream->gt->mmio, oaheadptr,
+			(head + gtt_offset) & OAG_OAHEADPTR_MASK);
+	stream->oa_buffer.head = head;
+	spin_unlock_irqrestore(&stream->oa_buffer.ptr_lock, flags);
+}
+
 static int xe_oa_append_reports(struct xe_oa_stream *stream, char __user *buf,
 				size_t count, size_t *offset)
 {
 	int report_size = stream->oa_buffer.format->size;
 	u8 *oa_buf_base = stream->oa_buffer.vaddr;
-	u32 gtt_offset = xe_bo_ggtt_addr(stream->oa_buffer.bo);
 	size_t start_offset = *offset;
 	unsigned long flags;
 	u32 head, tail;
@@ -364,33 +399,11 @@ static int xe_oa_append_reports(struct xe_oa_stream *stream, char __user *buf,
 		if (ret)
 			break;
 
-		if (!(stream->oa_buffer.circ_size % report_size)) {
-			/* Clear out report id and timestamp to detect unlanded reports */
-			oa_report_id_clear(stream, (void *)report);
-			oa_timestamp_clear(stream, (void *)report);
-		} else {
-			u8 *oa_buf_end = stream->oa_buffer.vaddr + stream->oa_buffer.circ_size;
-			u32 part = oa_buf_end - report;
-
-			/* Zero out the entire report */
-			if (report_size <= part) {
-				memset(report, 0, report_size);
-			} else {
-				memset(report, 0, part);
-				memset(oa_buf_base, 0, report_size - part);
-			}
-		}
+		xe_oa_consume_report(stream, report);
 	}
 
-	if (start_offset != *offset) {
-		struct xe_reg oaheadptr = __oa_regs(stream)->oa_head_ptr;
-
-		spin_lock_irqsave(&stream->oa_buffer.ptr_lock, flags);
-		xe_mmio_write32(&stream->gt->mmio, oaheadptr,
-				(head + gtt_offset) & OAG_OAHEADPTR_MASK);
-		stream->oa_buffer.head = head;
-		spin_unlock_irqrestore(&stream->oa_buffer.ptr_lock, flags);
-	}
+	if (start_offset != *offset)
+		xe_oa_update_head(stream, head);
 
 	return ret;
 }
@@ -1518,6 +1531,57 @@ static long xe_oa_info_locked(struct xe_oa_stream *stream, unsigned long arg)
 	return 0;
 }
 
+static long xe_oa_buf_ptrs_locked(struct xe_oa_stream *stream, unsigned long arg)
+{
+	int report_size = stream->oa_buffer.format->size;
+	void __user *uaddr = (void __user *)arg;
+	struct drm_xe_oa_buf_ptrs ptrs;
+	unsigned long flags;
+	u32 head, tail;
+
+	if (copy_from_user(&ptrs, uaddr, sizeof(ptrs)))
+		return -EFAULT;
+
+	if (XE_IOCTL_DBG(stream->oa->xe, ptrs.extensions || ptrs.pad ||
+			 ptrs.reserved[0] || ptrs.reserved[1] ||
+			 ptrs.flags & ~DRM_XE_OA_BUF_PTRS_SET_HEAD))
+		return -EINVAL;
+
+	xe_oa_buffer_check_unlocked(stream);
+
+	spin_lock_irqsave(&stream->oa_buffer.ptr_lock, flags);
+	head = stream->oa_buffer.head;
+	tail = stream->oa_buffer.tail;
+	spin_unlock_irqrestore(&stream->oa_buffer.ptr_lock, flags);
+
+	if (ptrs.flags & DRM_XE_OA_BUF_PTRS_SET_HEAD) {
+		u32 new_head = ptrs.head;
+
+		/* The new head must be a report boundary within [head, tail] */
+		if (XE_IOCTL_DBG(stream->oa->xe,
+				 new_head >= stream->oa_buffer.circ_size ||
+				 xe_oa_circ_diff(stream, new_head, head) % report_size ||
+				 xe_oa_circ_diff(stream, new_head, head) >
+				 xe_oa_circ_diff(stream, tail, head)))
+			return -EINVAL;
+
+		if (new_head != head) {
+			for (; head != new_head;
+			     head = xe_oa_circ_incr(stream, head, report_size))
+				xe_oa_consume_report(stream,
+						     stream->oa_buffer.vaddr + head);
+			xe_oa_update_head(stream, head);
+		}
+	}
+
+	ptrs.head = head;
+	ptrs.tail = tail;
+	if (copy_to_user(uaddr, &ptrs, sizeof(ptrs)))
+		return -EFAULT;
+
+	return 0;
+}
+
 static long xe_oa_ioctl_locked(struct xe_oa_stream *stream,
 			       unsigned int cmd,
 			       unsigned long arg)
@@ -1533,6 +1597,8 @@ static long xe_oa_ioctl_locked(struct xe_oa_stream *stream,
 		return xe_oa_status_locked(stream, arg);
 	case DRM_XE_OBSERVATION_IOCTL_INFO:
 		return xe_oa_info_locked(stream, arg);
+	case DRM_XE_OBSERVATION_IOCTL_BUF_PTRS:
+		return xe_oa_buf_ptrs_locked(stream, arg);
 	}
 
 	return -EINVAL;
@@ -1400,6 +1400,8 @@ struct xe_vm *xe_vm_create(struct xe_device *xe, u32 flags)
 	INIT_LIST_HEAD(&vm->userptr.invalidated);
 	init_rwsem(&vm->userptr.notifier_lock);
 	spin_lock_init(&vm->userptr.invalidated_lock);
+	spin_lock_init(&vm->usm.acc_budget.lock);
+	vm->usm.acc_budget.window_start = jiffies;
 
 	ttm_lru_bulk_move_init(&vm->lru_bulk_move);
 
@@ -3219,8 +3221,18 @@ int xe_vm_invalidate_vma(struct xe_vma *vma)
 	}
 
 wait:
-	for (id = 0; id < fence_id; ++id)
+	/* Don't leave the invalidations we are about to wait for batched */
+	for (id = 0; id < fence_id; ++id) {
+		int err = xe_gt_tlb_invalidation_flush(fence[id].gt);
+
+		if (err && !ret)
+			ret = err;
+	}
+	for (id = 0; id < fence_id; ++id) {
 		xe_gt_tlb_invalidation_fence_wait(&fence[id]);
+		if (fence[id].base.error && !ret)
+			ret = fence[id].base.error;
+	}
 
 	vma->tile_invalidated = vma->tile_mask;
 
@@ -265,6 +265,19 @@ struct xe_vm {
 		 * get a flood of faults to the same VMA
 		 */
 		struct xe_vma *last_fault_vma;
+		/**
+		 * @usm.acc_budget: budget for access counter driven promotions
+		 * to VRAM, so a single VM can't monopolise the copy engines or
+		 * evict everyone else's working set.
+		 */
+		struct {
+			/** @usm.acc_budget.lock: protects the budget */
+			spinlock_t lock;
+			/** @usm.acc_budget.window_start: start of the window, jiffies */
+			unsigned long window_start;
+			/** @usm.acc_budget.used: bytes promoted in the window */
+			u64 used;
+		} acc_budget;
 	} usm;
 
 	/** @error_capture: allow to track errors */
@@ -113,6 +113,11 @@ bool iser_pi_enable = false;
 module_param_named(pi_enable, iser_pi_enable, bool, S_IRUGO);
 MODULE_PARM_DESC(pi_enable, "Enable T10-PI offload support (default:disabled)");
 
+bool iser_use_inline = true;
+module_param_named(use_inline, iser_use_inline, bool, S_IRUGO);
+MODULE_PARM_DESC(use_inline,
+		 "Send header only PDUs inline with the work request (default:enabled)");
+
 static int iscsi_iser_set(const char *val, const struct kernel_param *kp)
 {
 	int ret;
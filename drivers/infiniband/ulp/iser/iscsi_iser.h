@@ -359,6 +359,7 @@ struct iser_fr_pool {
  * @qp:                  Connection Queue-pair
  * @cq:                  Connection completion queue
  * @cq_size:             The number of max outstanding completions
+ * @max_inline:          Max bytes the QP can send inline with a work request
  * @device:              reference to iser device
  * @fr_pool:             connection fast registration pool
  * @pi_support:          Indicate device T10-PI support
@@ -369,6 +370,7 @@ struct ib_conn {
 	struct ib_qp	            *qp;
 	struct ib_cq		    *cq;
 	u32			    cq_size;
+	u32			    max_inline;
 	struct iser_device          *device;
 	struct iser_fr_pool          fr_pool;
 	bool			     pi_support;
@@ -469,6 +471,7 @@ extern int iser_debug_level;
 extern bool iser_pi_enable;
 extern unsigned int iser_max_sectors;
 extern bool iser_always_reg;
+extern bool iser_use_inline;
 
 int iser_send_control(struct iscsi_conn *conn,
 		      struct iscsi_task *task);
@@ -268,15 +268,23 @@ static int iser_create_ib_conn_res(struct ib_conn *ib_conn)
 	init_attr.sq_sig_type = IB_SIGNAL_REQ_WR;
 	init_attr.qp_type = IB_QPT_RC;
 	init_attr.cap.max_send_wr = max_send_wr;
+	if (iser_use_inline)
+		init_attr.cap.max_inline_data = ISER_HEADERS_LEN;
 	if (ib_conn->pi_support)
 		init_attr.create_flags |= IB_QP_CREATE_INTEGRITY_EN;
 	iser_conn->max_cmds = ISER_GET_MAX_XMIT_CMDS(max_send_wr - 1);
 
 	ret = rdma_create_qp(ib_conn->cma_id, device->pd, &init_attr);
+	if (ret && init_attr.cap.max_inline_data) {
+		/* inline sends are an optimization only */
+		init_attr.cap.max_inline_data = 0;
+		ret = rdma_create_qp(ib_conn->cma_id, device->pd, &init_attr);
+	}
 	if (ret)
 		goto out_err;
 
 	ib_conn->qp = ib_conn->cma_id->qp;
+	ib_conn->max_inline = init_attr.cap.max_inline_data;
 	iser_info("setting conn %p cma_id %p qp %p max_send_wr %d\n", ib_conn,
 		  ib_conn->cma_id, ib_conn->cma_id->qp, max_send_wr);
 	return ret;
@@ -858,12 +866,9 @@ int iser_post_send(struct ib_conn *ib_conn, struct iser_tx_desc *tx_desc)
 {
 	struct ib_send_wr *wr = &tx_desc->send_wr;
 	struct ib_send_wr *first_wr;
+	struct ib_sge inline_sge;
 	int ret;
 
-	ib_dma_sync_single_for_device(ib_conn->device->ib_device,
-				      tx_desc->dma_addr, ISER_HEADERS_LEN,
-				      DMA_TO_DEVICE);
-
 	wr->next = NULL;
 	wr->wr_cqe = &tx_desc->cqe;
 	wr->sg_list = tx_desc->tx_sg;
@@ -871,6 +876,23 @@ int iser_post_send(struct ib_conn *ib_conn, struct iser_tx_desc *tx_desc)
 	wr->opcode = IB_WR_SEND;
 	wr->send_flags = IB_SEND_SIGNALED;
 
+	/*
+	 * Header only PDUs, e.g. read commands, are copied into the work
+	 * request, which saves the HCA a DMA read of the headers. Inline
+	 * sges carry kernel virtual addresses.
+	 */
+	if (tx_desc->num_sge == 1 && ib_conn->max_inline >= ISER_HEADERS_LEN) {
+		inline_sge.addr = (uintptr_t)&tx_desc->iser_header;
+		inline_sge.length = ISER_HEADERS_LEN;
+		inline_sge.lkey = 0;
+		wr->sg_list = &inline_sge;
+		wr->send_flags |= IB_SEND_INLINE;
+	} else {
+		ib_dma_sync_single_for_device(ib_conn->device->ib_device,
+					      tx_desc->dma_addr,
+					      ISER_HEADERS_LEN, DMA_TO_DEVICE);
+	}
+
 	if (tx_desc->inv_wr.next)
 		first_wr = &tx_desc->inv_wr;
 	else if (tx_desc->reg_wr.wr.next)
@@ -10,7 +10,9 @@
 
 #include <linux/acpi_iort.h>
 #include <linux/atomic.h>
+#include <linux/bvec.h>
 #include <linux/crash_dump.h>
+#include <linux/debugfs.h>
 #include <linux/device.h>
 #include <linux/dma-direct.h>
 #include <linux/dma-map-ops.h>
@@ -27,9 +29,11 @@
 #include <linux/of_iommu.h>
 #include <linux/pci.h>
 #include <linux/scatterlist.h>
+#include <linux/seq_file.h>
 #include <linux/spinlock.h>
 #include <linux/swiotlb.h>
 #include <linux/vmalloc.h>
+#include <linux/workqueue.h>
 #include <trace/events/swiotlb.h>
 
 #include "dma-iommu.h"
@@ -54,6 +58,7 @@ enum iommu_dma_queue_type {
 struct iommu_dma_options {
 	enum iommu_dma_queue_type qt;
 	size_t		fq_size;
+	size_t		fq_max_size;
 	unsigned int	fq_timeout;
 };
 
@@ -76,6 +81,16 @@ struct iommu_dma_cookie {
 			struct timer_list	fq_timer;
 			/* 1 when timer is active, 0 when not */
 			atomic_t		fq_timer_on;
+			/* Current timeout, adjusted by the resize work */
+			unsigned int		fq_timeout;
+			/* Number of flushes forced by a full queue */
+			atomic64_t		fq_full_cnt;
+			/* Number of flush queue resizes */
+			atomic64_t		fq_resize_cnt;
+			struct delayed_work	fq_resize_work;
+			/* Link in iommu_dma_fq_cookies, for debugfs */
+			struct list_head	fq_list;
+			char			fq_dev_name[32];
 		};
 		/* Trivial linear page allocator for IOMMU_DMA_MSI_COOKIE */
 		dma_addr_t		msi_iova;
@@ -102,14 +117,27 @@ static int __init iommu_dma_forcedac_setup(char *str)
 }
 early_param("iommu.forcedac", iommu_dma_forcedac_setup);
 
-/* Number of entries per flush queue */
-#define IOVA_DEFAULT_FQ_SIZE	256
-#define IOVA_SINGLE_FQ_SIZE	32768
+/*
+ * Flush queues start small and are resized by iommu_dma_fq_resize_work():
+ * a queue that filled up, forcing a synchronous flush, is doubled up to
+ * fq_max_size, and a queue that stayed mostly empty is halved back down to
+ * fq_size.  While queues keep filling up at their maximum size, the flush
+ * timeout is halved as well, and it is restored once they stop.
+ */
+
+/* Number of entries per flush queue, initial and maximum */
+#define IOVA_DEFAULT_FQ_SIZE	32
+#define IOVA_DEFAULT_FQ_MAX_SIZE	4096
+#define IOVA_SINGLE_FQ_SIZE	4096
+#define IOVA_SINGLE_FQ_MAX_SIZE	131072
 
 /* Timeout (in ms) after which entries are flushed from the queue */
 #define IOVA_DEFAULT_FQ_TIMEOUT	10
 #define IOVA_SINGLE_FQ_TIMEOUT	1000
 
+/* Interval between resize checks while any queue is above its minimum */
+#define IOVA_FQ_RESIZE_DELAY	msecs_to_jiffies(1000)
+
 /* Flush queue entry for deferred flushing */
 struct iova_fq_entry {
 	unsigned long iova_pfn;
@@ -123,12 +151,24 @@ struct iova_fq {
 	spinlock_t lock;
 	unsigned int head, tail;
 	unsigned int mod_mask;
-	struct iova_fq_entry entries[];
+	/* Highest number of entries in use since the last resize check */
+	unsigned int peak;
+	/* Whether the queue filled up since the last resize check */
+	bool overflowed;
+	struct iova_fq_entry *entries;
 };
 
+static LIST_HEAD(iommu_dma_fq_cookies);
+static DEFINE_MUTEX(iommu_dma_fq_cookies_lock);
+
 #define fq_ring_for_each(i, fq) \
 	for ((i) = (fq)->head; (i) != (fq)->tail; (i) = ((i) + 1) & (fq)->mod_mask)
 
+static inline unsigned int fq_used(struct iova_fq *fq)
+{
+	return (fq->tail - fq->head) & fq->mod_mask;
+}
+
 static inline bool fq_full(struct iova_fq *fq)
 {
 	assert_spin_locked(&fq->lock);
@@ -233,6 +273,12 @@ static void queue_iova(struct iommu_dma_cookie *cookie,
 	if (fq_full(fq)) {
 		fq_flush_iotlb(cookie);
 		fq_ring_free_locked(cookie, fq);
+		atomic64_inc(&cookie->fq_full_cnt);
+		if (!fq->overflowed) {
+			fq->overflowed = true;
+			mod_delayed_work(system_unbound_wq,
+					 &cookie->fq_resize_work, 0);
+		}
 	}
 
 	idx = fq_ring_add(fq);
@@ -241,6 +287,7 @@ static void queue_iova(struct iommu_dma_cookie *cookie,
 	fq->entries[idx].pages    = pages;
 	fq->entries[idx].counter  = atomic64_read(&cookie->fq_flush_start_cnt);
 	list_splice(freelist, &fq->entries[idx].freelist);
+	fq->peak = max(fq->peak, fq_used(fq));
 
 	spin_unlock_irqrestore(&fq->lock, flags);
 
@@ -248,29 +295,162 @@ static void queue_iova(struct iommu_dma_cookie *cookie,
 	if (!atomic_read(&cookie->fq_timer_on) &&
 	    !atomic_xchg(&cookie->fq_timer_on, 1))
 		mod_timer(&cookie->fq_timer,
-			  jiffies + msecs_to_jiffies(cookie->options.fq_timeout));
+			  jiffies + msecs_to_jiffies(READ_ONCE(cookie->fq_timeout)));
 }
 
-static void iommu_dma_free_fq_single(struct iova_fq *fq)
+static struct iova_fq_entry *iommu_dma_alloc_fq_entries(size_t fq_size,
+							 int node)
+{
+	struct iova_fq_entry *entries;
+	int i;
+
+	entries = kvcalloc_node(fq_size, sizeof(*entries), GFP_KERNEL, node);
+	if (!entries)
+		return NULL;
+
+	for (i = 0; i < fq_size; i++)
+		INIT_LIST_HEAD(&entries[i].freelist);
+	return entries;
+}
+
+/*
+ * Move the pending entries of @fq to a ring of @fq_size entries.  Fails if
+ * they don't fit, for a queue that filled up again since the resize check.
+ */
+static bool iommu_dma_resize_one_fq(struct iommu_dma_cookie *cookie,
+				    struct iova_fq *fq, size_t fq_size,
+				    int node)
+{
+	struct iova_fq_entry *entries, *old;
+	unsigned int idx, used = 0;
+	unsigned long flags;
+
+	entries = iommu_dma_alloc_fq_entries(fq_size, node);
+	if (!entries)
+		return false;
+
+	spin_lock_irqsave(&fq->lock, flags);
+	fq_ring_free_locked(cookie, fq);
+	if (fq_used(fq) >= fq_size) {
+		spin_unlock_irqrestore(&fq->lock, flags);
+		kvfree(entries);
+		return false;
+	}
+
+	fq_ring_for_each(idx, fq) {
+		entries[used].iova_pfn = fq->entries[idx].iova_pfn;
+		entries[used].pages = fq->entries[idx].pages;
+		entries[used].counter = fq->entries[idx].counter;
+		list_splice(&fq->entries[idx].freelist,
+			    &entries[used].freelist);
+		used++;
+	}
+	old = fq->entries;
+	fq->entries = entries;
+	fq->head = 0;
+	fq->tail = used;
+	WRITE_ONCE(fq->mod_mask, fq_size - 1);
+	spin_unlock_irqrestore(&fq->lock, flags);
+
+	kvfree(old);
+	return true;
+}
+
+/*
+ * Resize check for one queue.  Returns true if it is still above its
+ * minimum size, and sets *@saturated if it filled up at its maximum.
+ */
+static bool iommu_dma_check_one_fq(struct iommu_dma_cookie *cookie,
+				   struct iova_fq *fq, int node,
+				   bool *saturated)
+{
+	size_t size, new_size;
+	unsigned long flags;
+	bool overflowed;
+	unsigned int peak;
+
+	spin_lock_irqsave(&fq->lock, flags);
+	size = fq->mod_mask + 1;
+	overflowed = fq->overflowed;
+	peak = fq->peak;
+	fq->overflowed = false;
+	fq->peak = 0;
+	spin_unlock_irqrestore(&fq->lock, flags);
+
+	new_size = size;
+	if (overflowed && size < cookie->options.fq_max_size)
+		new_size = size * 2;
+	else if (overflowed)
+		*saturated = true;
+	else if (peak < size / 4 && size > cookie->options.fq_size)
+		new_size = size / 2;
+
+	if (new_size != size) {
+		if (iommu_dma_resize_one_fq(cookie, fq, new_size, node)) {
+			atomic64_inc(&cookie->fq_resize_cnt);
+			size = new_size;
+		} else if (new_size > size) {
+			/* Try again at the next check */
+			spin_lock_irqsave(&fq->lock, flags);
+			fq->overflowed = true;
+			spin_unlock_irqrestore(&fq->lock, flags);
+		}
+	}
+
+	return size > cookie->options.fq_size;
+}
+
+static void iommu_dma_fq_resize_work(struct work_struct *work)
+{
+	struct iommu_dma_cookie *cookie = container_of(to_delayed_work(work),
+			struct iommu_dma_cookie, fq_resize_work);
+	unsigned int timeout = cookie->fq_timeout;
+	bool saturated = false, grown = false;
+	int cpu;
+
+	if (cookie->options.qt == IOMMU_DMA_OPTS_SINGLE_QUEUE) {
+		grown = iommu_dma_check_one_fq(cookie, cookie->single_fq,
+					       NUMA_NO_NODE, &saturated);
+	} else {
+		for_each_possible_cpu(cpu)
+			grown |= iommu_dma_check_one_fq(cookie,
+					per_cpu_ptr(cookie->percpu_fq, cpu),
+					cpu_to_node(cpu), &saturated);
+	}
+
+	if (saturated)
+		timeout = max(timeout / 2, 1U);
+	else
+		timeout = min(timeout * 2, cookie->options.fq_timeout);
+	WRITE_ONCE(cookie->fq_timeout, timeout);
+
+	if (grown || timeout != cookie->options.fq_timeout)
+		queue_delayed_work(system_unbound_wq, &cookie->fq_resize_work,
+				   IOVA_FQ_RESIZE_DELAY);
+}
+
+static void iommu_dma_free_one_fq(struct iova_fq *fq)
 {
 	int idx;
 
+	/* The IOVAs will be torn down separately, so just free our queued pages */
 	fq_ring_for_each(idx, fq)
 		iommu_put_pages_list(&fq->entries[idx].freelist);
-	vfree(fq);
+	kvfree(fq->entries);
 }
 
-static void iommu_dma_free_fq_percpu(struct iova_fq __percpu *percpu_fq)
+static void iommu_dma_free_fq_single(struct iova_fq *fq)
 {
-	int cpu, idx;
+	iommu_dma_free_one_fq(fq);
+	kfree(fq);
+}
 
-	/* The IOVAs will be torn down separately, so just free our queued pages */
-	for_each_possible_cpu(cpu) {
-		struct iova_fq *fq = per_cpu_ptr(percpu_fq, cpu);
+static void iommu_dma_free_fq_percpu(struct iova_fq __percpu *percpu_fq)
+{
+	int cpu;
 
-		fq_ring_for_each(idx, fq)
-			iommu_put_pages_list(&fq->entries[idx].freelist);
-	}
+	for_each_possible_cpu(cpu)
+		iommu_dma_free_one_fq(per_cpu_ptr(percpu_fq, cpu));
 
 	free_percpu(percpu_fq);
 }
@@ -280,25 +460,32 @@ static void iommu_dma_free_fq(struct iommu_dma_cookie *cookie)
 	if (!cookie->fq_domain)
 		return;
 
+	mutex_lock(&iommu_dma_fq_cookies_lock);
+	list_del(&cookie->fq_list);
+	mutex_unlock(&iommu_dma_fq_cookies_lock);
+
 	del_timer_sync(&cookie->fq_timer);
+	cancel_delayed_work_sync(&cookie->fq_resize_work);
 	if (cookie->options.qt == IOMMU_DMA_OPTS_SINGLE_QUEUE)
 		iommu_dma_free_fq_single(cookie->single_fq);
 	else
 		iommu_dma_free_fq_percpu(cookie->percpu_fq);
 }
 
-static void iommu_dma_init_one_fq(struct iova_fq *fq, size_t fq_size)
+static int iommu_dma_init_one_fq(struct iova_fq *fq, size_t fq_size, int node)
 {
-	int i;
+	fq->entries = iommu_dma_alloc_fq_entries(fq_size, node);
+	if (!fq->entries)
+		return -ENOMEM;
 
 	fq->head = 0;
 	fq->tail = 0;
 	fq->mod_mask = fq_size - 1;
+	fq->peak = 0;
+	fq->overflowed = false;
 
 	spin_lock_init(&fq->lock);
-
-	for (i = 0; i < fq_size; i++)
-		INIT_LIST_HEAD(&fq->entries[i].freelist);
+	return 0;
 }
 
 static int iommu_dma_init_fq_single(struct iommu_dma_cookie *cookie)
@@ -306,10 +493,13 @@ static int iommu_dma_init_fq_single(struct iommu_dma_cookie *cookie)
 	size_t fq_size = cookie->options.fq_size;
 	struct iova_fq *queue;
 
-	queue = vmalloc(struct_size(queue, entries, fq_size));
+	queue = kzalloc(sizeof(*queue), GFP_KERNEL);
 	if (!queue)
 		return -ENOMEM;
-	iommu_dma_init_one_fq(queue, fq_size);
+	if (iommu_dma_init_one_fq(queue, fq_size, NUMA_NO_NODE)) {
+		kfree(queue);
+		return -ENOMEM;
+	}
 	cookie->single_fq = queue;
 
 	return 0;
@@ -321,13 +511,18 @@ static int iommu_dma_init_fq_percpu(struct iommu_dma_cookie *cookie)
 	struct iova_fq __percpu *queue;
 	int cpu;
 
-	queue = __alloc_percpu(struct_size(queue, entries, fq_size),
-			       __alignof__(*queue));
+	queue = alloc_percpu(struct iova_fq);
 	if (!queue)
 		return -ENOMEM;
 
-	for_each_possible_cpu(cpu)
-		iommu_dma_init_one_fq(per_cpu_ptr(queue, cpu), fq_size);
+	for_each_possible_cpu(cpu) {
+		if (iommu_dma_init_one_fq(per_cpu_ptr(queue, cpu), fq_size,
+					  cpu_to_node(cpu))) {
+			/* Zeroed, so the rest have no entries to free */
+			iommu_dma_free_fq_percpu(queue);
+			return -ENOMEM;
+		}
+	}
 	cookie->percpu_fq = queue;
 	return 0;
 }
@@ -343,6 +538,10 @@ int iommu_dma_init_fq(struct iommu_domain *domain)
 
 	atomic64_set(&cookie->fq_flush_start_cnt,  0);
 	atomic64_set(&cookie->fq_flush_finish_cnt, 0);
+	atomic64_set(&cookie->fq_full_cnt, 0);
+	atomic64_set(&cookie->fq_resize_cnt, 0);
+	cookie->fq_timeout = cookie->options.fq_timeout;
+	INIT_DELAYED_WORK(&cookie->fq_resize_work, iommu_dma_fq_resize_work);
 
 	if (cookie->options.qt == IOMMU_DMA_OPTS_SINGLE_QUEUE)
 		rc = iommu_dma_init_fq_single(cookie);
@@ -356,6 +555,11 @@ int iommu_dma_init_fq(struct iommu_domain *domain)
 
 	timer_setup(&cookie->fq_timer, fq_flush_timeout, 0);
 	atomic_set(&cookie->fq_timer_on, 0);
+
+	mutex_lock(&iommu_dma_fq_cookies_lock);
+	list_add_tail(&cookie->fq_list, &iommu_dma_fq_cookies);
+	mutex_unlock(&iommu_dma_fq_cookies_lock);
+
 	/*
 	 * Prevent incomplete fq state being observable. Pairs with path from
 	 * __iommu_dma_unmap() through iommu_dma_free_iova() to queue_iova()
@@ -365,6 +569,57 @@ int iommu_dma_init_fq(struct iommu_domain *domain)
 	return 0;
 }
 
+#ifdef CONFIG_IOMMU_DEBUGFS
+static int iommu_dma_fq_stats_show(struct seq_file *m, void *unused)
+{
+	struct iommu_dma_cookie *cookie;
+	unsigned int size, min_size, max_size;
+	int cpu;
+
+	seq_puts(m, "device queue size(min-max) timeout_ms flushes full resizes\n");
+
+	mutex_lock(&iommu_dma_fq_cookies_lock);
+	list_for_each_entry(cookie, &iommu_dma_fq_cookies, fq_list) {
+		if (cookie->options.qt == IOMMU_DMA_OPTS_SINGLE_QUEUE) {
+			min_size = READ_ONCE(cookie->single_fq->mod_mask) + 1;
+			max_size = min_size;
+		} else {
+			min_size = UINT_MAX;
+			max_size = 0;
+			for_each_possible_cpu(cpu) {
+				struct iova_fq *fq;
+
+				fq = per_cpu_ptr(cookie->percpu_fq, cpu);
+				size = READ_ONCE(fq->mod_mask) + 1;
+				min_size = min(min_size, size);
+				max_size = max(max_size, size);
+			}
+		}
+
+		seq_printf(m, "%s %s %u-%u %u %llu %llu %llu\n",
+			   cookie->fq_dev_name,
+			   cookie->options.qt == IOMMU_DMA_OPTS_SINGLE_QUEUE ?
+			   "single" : "percpu",
+			   min_size, max_size, READ_ONCE(cookie->fq_timeout),
+			   atomic64_read(&cookie->fq_flush_finish_cnt),
+			   atomic64_read(&cookie->fq_full_cnt),
+			   atomic64_read(&cookie->fq_resize_cnt));
+	}
+	mutex_unlock(&iommu_dma_fq_cookies_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(iommu_dma_fq_stats);
+
+static void iommu_dma_debugfs_init(void)
+{
+	debugfs_create_file("dma_flush_queues", 0400, iommu_debugfs_dir, NULL,
+			    &iommu_dma_fq_stats_fops);
+}
+#else
+static inline void iommu_dma_debugfs_init(void) {}
+#endif
+
 static inline size_t cookie_msi_granule(struct iommu_dma_cookie *cookie)
 {
 	if (cookie->type == IOMMU_DMA_IOVA_COOKIE)
@@ -652,9 +907,11 @@ static void iommu_dma_init_options(struct iommu_dma_options *options,
 		options->qt = IOMMU_DMA_OPTS_SINGLE_QUEUE;
 		options->fq_timeout = IOVA_SINGLE_FQ_TIMEOUT;
 		options->fq_size = IOVA_SINGLE_FQ_SIZE;
+		options->fq_max_size = IOVA_SINGLE_FQ_MAX_SIZE;
 	} else {
 		options->qt = IOMMU_DMA_OPTS_PER_CPU_QUEUE;
 		options->fq_size = IOVA_DEFAULT_FQ_SIZE;
+		options->fq_max_size = IOVA_DEFAULT_FQ_MAX_SIZE;
 		options->fq_timeout = IOVA_DEFAULT_FQ_TIMEOUT;
 	}
 }
@@ -717,6 +974,8 @@ static int iommu_dma_init_domain(struct iommu_domain *domain, struct device *dev
 		goto done_unlock;
 
 	iommu_dma_init_options(&cookie->options, dev);
+	if (!cookie->fq_dev_name[0])
+		strscpy(cookie->fq_dev_name, dev_name(dev));
 
 	/* If the FQ fails we can simply fall back to strict mode */
 	if (domain->type == IOMMU_DOMAIN_DMA_FQ &&
@@ -1238,6 +1497,227 @@ void iommu_dma_unmap_page(struct device *dev, dma_addr_t dma_handle,
 	swiotlb_tbl_unmap_single(dev, phys, size, dir, attrs);
 }
 
+/*
+ * Whether some buffer of a batch may have to be bounced.  Bouncing is done
+ * buffer by buffer, so the batch calls then fall back to the single ones.
+ */
+static bool dev_use_batch_swiotlb(struct device *dev,
+				  enum dma_data_direction dir)
+{
+	return IS_ENABLED(CONFIG_SWIOTLB) &&
+		(dev_is_untrusted(dev) || !dma_kmalloc_safe(dev, dir));
+}
+
+/**
+ * iommu_dma_map_batch - map several buffers with one IOVA allocation
+ * @dev: device to map for
+ * @bv: buffers to map
+ * @nr: number of buffers
+ * @dma_addrs: returns the DMA address of each buffer
+ * @dir: DMA direction
+ * @attrs: DMA_ATTR_* flags
+ *
+ * The buffers are laid out one after the other, each starting on a new IOVA
+ * granule, in a single IOVA allocation, and the IOMMU is synced once for all
+ * of them.  The batch must be unmapped as a whole by iommu_dma_unmap_batch()
+ * with the same @bv and @dma_addrs.
+ *
+ * Returns 0 or a negative errno, in which case nothing is left mapped.
+ */
+int iommu_dma_map_batch(struct device *dev, const struct bio_vec *bv, int nr,
+		dma_addr_t *dma_addrs, enum dma_data_direction dir,
+		unsigned long attrs)
+{
+	struct iommu_domain *domain = iommu_get_dma_domain(dev);
+	struct iommu_dma_cookie *cookie = domain->iova_cookie;
+	struct iova_domain *iovad = &cookie->iovad;
+	bool coherent = dev_is_dma_coherent(dev);
+	int prot = dma_info_to_prot(dir, coherent, attrs);
+	size_t size = 0, mapped = 0;
+	dma_addr_t iova;
+	int i, ret;
+
+	if (!nr)
+		return 0;
+
+	if (static_branch_unlikely(&iommu_deferred_attach_enabled)) {
+		ret = iommu_deferred_attach(dev, domain);
+		if (ret)
+			return ret;
+	}
+
+	if (dev_use_batch_swiotlb(dev, dir)) {
+		for (i = 0; i < nr; i++) {
+			dma_addrs[i] = iommu_dma_map_page(dev, bv[i].bv_page,
+					bv[i].bv_offset, bv[i].bv_len, dir,
+					attrs);
+			if (dma_addrs[i] == DMA_MAPPING_ERROR)
+				goto out_unmap_pages;
+		}
+		return 0;
+	}
+
+	/* If anyone ever wants this we'd need support in the IOVA allocator */
+	if (dev_WARN_ONCE(dev, dma_get_min_align_mask(dev) > iova_mask(iovad),
+	    "Unsupported alignment constraint\n"))
+		return -EINVAL;
+
+	for (i = 0; i < nr; i++) {
+		phys_addr_t phys = bvec_phys(&bv[i]);
+
+		size += iova_align(iovad, bv[i].bv_len +
+				   iova_offset(iovad, phys));
+	}
+
+	iova = iommu_dma_alloc_iova(domain, size, dma_get_mask(dev), dev);
+	if (!iova)
+		return -ENOMEM;
+
+	for (i = 0; i < nr; i++) {
+		phys_addr_t phys = bvec_phys(&bv[i]);
+		size_t iova_off = iova_offset(iovad, phys);
+		size_t len = iova_align(iovad, bv[i].bv_len + iova_off);
+
+		if (!coherent && !(attrs & DMA_ATTR_SKIP_CPU_SYNC))
+			arch_sync_dma_for_device(phys, bv[i].bv_len, dir);
+
+		ret = iommu_map_nosync(domain, iova + mapped, phys - iova_off,
+				       len, prot, GFP_ATOMIC);
+		if (ret)
+			goto out_unmap;
+
+		dma_addrs[i] = iova + mapped + iova_off;
+		mapped += len;
+	}
+
+	ret = iommu_sync_map(domain, iova, size);
+	if (ret)
+		goto out_unmap;
+	return 0;
+
+out_unmap:
+	if (mapped)
+		iommu_unmap(domain, iova, mapped);
+	iommu_dma_free_iova(cookie, iova, size, NULL);
+	return ret;
+
+out_unmap_pages:
+	while (i--)
+		iommu_dma_unmap_page(dev, dma_addrs[i], bv[i].bv_len, dir, attrs);
+	return -ENOMEM;
+}
+
+/**
+ * iommu_dma_unmap_batch - unmap buffers mapped by iommu_dma_map_batch()
+ * @dev: device the buffers were mapped for
+ * @bv: the buffers, as passed to iommu_dma_map_batch()
+ * @nr: number of buffers
+ * @dma_addrs: the DMA addresses returned by iommu_dma_map_batch()
+ * @dir: DMA direction
+ * @attrs: DMA_ATTR_* flags
+ *
+ * The whole batch is unmapped with a single IOTLB invalidation, also in
+ * strict mode.
+ */
+void iommu_dma_unmap_batch(struct device *dev, const struct bio_vec *bv,
+		int nr, const dma_addr_t *dma_addrs,
+		enum dma_data_direction dir, unsigned long attrs)
+{
+	struct iommu_domain *domain = iommu_get_dma_domain(dev);
+	struct iommu_dma_cookie *cookie = domain->iova_cookie;
+	struct iova_domain *iovad = &cookie->iovad;
+	bool coherent = dev_is_dma_coherent(dev);
+	size_t size = 0;
+	int i;
+
+	if (!nr)
+		return;
+
+	if (dev_use_batch_swiotlb(dev, dir)) {
+		for (i = 0; i < nr; i++)
+			iommu_dma_unmap_page(dev, dma_addrs[i], bv[i].bv_len,
+					     dir, attrs);
+		return;
+	}
+
+	for (i = 0; i < nr; i++) {
+		phys_addr_t phys = bvec_phys(&bv[i]);
+
+		if (!coherent && !(attrs & DMA_ATTR_SKIP_CPU_SYNC))
+			arch_sync_dma_for_cpu(phys, bv[i].bv_len, dir);
+		size += iova_align(iovad, bv[i].bv_len +
+				   iova_offset(iovad, phys));
+	}
+
+	__iommu_dma_unmap(dev, dma_addrs[0] - iova_offset(iovad, dma_addrs[0]),
+			  size);
+}
+
+/**
+ * iommu_dma_unmap_page_batch - unmap several single mappings at once
+ * @dev: device the buffers were mapped for
+ * @dma_handles: addresses returned by iommu_dma_map_page()
+ * @sizes: sizes passed to iommu_dma_map_page()
+ * @nr: number of mappings
+ * @dir: DMA direction
+ * @attrs: DMA_ATTR_* flags
+ *
+ * Equivalent to calling iommu_dma_unmap_page() on each mapping, except that
+ * the IOTLB is invalidated once for all of them, and only then are their
+ * IOVAs freed.  Whether the IOMMU driver can gather disjoint ranges into a
+ * single invalidation is up to it; at worst it invalidates early.
+ */
+void iommu_dma_unmap_page_batch(struct device *dev,
+		const dma_addr_t *dma_handles, const size_t *sizes, int nr,
+		enum dma_data_direction dir, unsigned long attrs)
+{
+	struct iommu_domain *domain = iommu_get_dma_domain(dev);
+	struct iommu_dma_cookie *cookie = domain->iova_cookie;
+	struct iova_domain *iovad = &cookie->iovad;
+	bool coherent = dev_is_dma_coherent(dev);
+	struct iommu_iotlb_gather iotlb_gather;
+	size_t unmapped;
+	int i;
+
+	if (dev_use_batch_swiotlb(dev, dir)) {
+		for (i = 0; i < nr; i++)
+			iommu_dma_unmap_page(dev, dma_handles[i], sizes[i], dir,
+					     attrs);
+		return;
+	}
+
+	iommu_iotlb_gather_init(&iotlb_gather);
+	iotlb_gather.queued = READ_ONCE(cookie->fq_domain);
+
+	for (i = 0; i < nr; i++) {
+		size_t iova_off = iova_offset(iovad, dma_handles[i]);
+		size_t size = iova_align(iovad, sizes[i] + iova_off);
+
+		if (!coherent && !(attrs & DMA_ATTR_SKIP_CPU_SYNC)) {
+			phys_addr_t phys;
+
+			phys = iommu_iova_to_phys(domain, dma_handles[i]);
+			if (!WARN_ON(!phys))
+				arch_sync_dma_for_cpu(phys, sizes[i], dir);
+		}
+
+		unmapped = iommu_unmap_fast(domain, dma_handles[i] - iova_off,
+					    size, &iotlb_gather);
+		WARN_ON(unmapped != size);
+	}
+
+	if (!iotlb_gather.queued)
+		iommu_iotlb_sync(domain, &iotlb_gather);
+
+	for (i = 0; i < nr; i++) {
+		size_t iova_off = iova_offset(iovad, dma_handles[i]);
+
+		iommu_dma_free_iova(cookie, dma_handles[i] - iova_off,
+				    iova_align(iovad, sizes[i] + iova_off),
+				    &iotlb_gather);
+	}
+}
+
 /*
  * Prepare a successfully-mapped scatterlist to give back to the caller.
  *
@@ -1861,6 +2341,7 @@ static int iommu_dma_init(void)
 	if (is_kdump_kernel())
 		static_branch_enable(&iommu_deferred_attach_enabled);
 
+	iommu_dma_debugfs_init();
 	return iova_cache_get();
 }
 arch_initcall(iommu_dma_init);
@@ -13,6 +13,25 @@
 
 #include "iommu-priv.h"
 
+/* Maximum number of fault groups handled concurrently per queue, 0 = default */
+static unsigned int iopf_workers;
+
+static int __init iopf_workers_setup(char *str)
+{
+	return kstrtouint(str, 0, &iopf_workers);
+}
+early_param("iommu.iopf_workers", iopf_workers_setup);
+
+/* Maximum number of responses passed to ops->page_response_batch() at once */
+#define IOPF_RESPONSE_BATCH	16
+
+/* A response queued for ops->page_response_batch() */
+struct iopf_response {
+	struct list_head list;
+	struct iopf_fault evt;
+	struct iommu_page_response msg;
+};
+
 /*
  * Return the fault parameter of a device if it exists. Otherwise, return NULL.
  * On a successful return, the caller takes a reference of this parameter and
@@ -283,6 +302,74 @@ int iommu_report_device_fault(struct device *dev, struct iopf_fault *evt)
 }
 EXPORT_SYMBOL_GPL(iommu_report_device_fault);
 
+/* Called with resp_lock held */
+static void iopf_send_batch(struct iommu_fault_param *fault_param,
+			    struct list_head *batch)
+{
+	const struct iommu_ops *ops = dev_iommu_ops(fault_param->dev);
+	struct iommu_page_response msgs[IOPF_RESPONSE_BATCH];
+	struct iopf_fault *evts[IOPF_RESPONSE_BATCH];
+	struct iopf_response *resp, *next;
+	unsigned int nr = 0;
+
+	list_for_each_entry(resp, batch, list) {
+		evts[nr] = &resp->evt;
+		msgs[nr] = resp->msg;
+		if (++nr == IOPF_RESPONSE_BATCH || list_is_last(&resp->list, batch)) {
+			ops->page_response_batch(fault_param->dev, evts, msgs, nr);
+			nr = 0;
+		}
+	}
+
+	list_for_each_entry_safe(resp, next, batch, list)
+		kfree(resp);
+	INIT_LIST_HEAD(batch);
+}
+
+/*
+ * Send the queued responses of a device. Whoever finds another thread already
+ * sending leaves its response to it, so that under a fault storm responses are
+ * combined without ever being delayed.
+ */
+static void iopf_send_responses(struct iommu_fault_param *fault_param)
+{
+	LIST_HEAD(batch);
+	bool more;
+
+	while (mutex_trylock(&fault_param->resp_lock)) {
+		mutex_lock(&fault_param->lock);
+		list_splice_init(&fault_param->responses, &batch);
+		mutex_unlock(&fault_param->lock);
+
+		iopf_send_batch(fault_param, &batch);
+		mutex_unlock(&fault_param->resp_lock);
+
+		/* Pick up responses queued while we held resp_lock */
+		mutex_lock(&fault_param->lock);
+		more = !list_empty(&fault_param->responses);
+		mutex_unlock(&fault_param->lock);
+		if (!more)
+			break;
+	}
+}
+
+/* Wait until all responses queued so far have been sent */
+static void iopf_flush_responses(struct iommu_fault_param *fault_param)
+{
+	LIST_HEAD(batch);
+
+	mutex_lock(&fault_param->resp_lock);
+	mutex_lock(&fault_param->lock);
+	list_splice_init(&fault_param->responses, &batch);
+	mutex_unlock(&fault_param->lock);
+
+	iopf_send_batch(fault_param, &batch);
+	mutex_unlock(&fault_param->resp_lock);
+
+	/* Others may have queued theirs and found us sending */
+	iopf_send_responses(fault_param);
+}
+
 /**
  * iopf_queue_flush_dev - Ensure that all queued faults have been processed
  * @dev: the endpoint whose faults need to be flushed.
@@ -309,6 +396,7 @@ int iopf_queue_flush_dev(struct device *dev)
 		return -ENODEV;
 
 	flush_workqueue(iopf_param->queue->wq);
+	iopf_flush_responses(iopf_param);
 
 	return 0;
 }
@@ -331,14 +419,33 @@ void iopf_group_response(struct iopf_group *group,
 		.grpid = iopf->fault.prm.grpid,
 		.code = status,
 	};
+	struct iopf_response *queued = NULL;
+
+	/* The group is freed on return, so the fault is copied */
+	if (ops->page_response_batch) {
+		queued = kmalloc(sizeof(*queued), GFP_KERNEL);
+		if (queued) {
+			queued->evt = group->last_fault;
+			queued->msg = resp;
+		}
+	}
 
 	/* Only send response if there is a fault report pending */
 	mutex_lock(&fault_param->lock);
 	if (!list_empty(&group->pending_node)) {
-		ops->page_response(dev, &group->last_fault, &resp);
+		if (queued)
+			list_add_tail(&queued->list, &fault_param->responses);
+		else
+			ops->page_response(dev, &group->last_fault, &resp);
 		list_del_init(&group->pending_node);
+	} else if (queued) {
+		kfree(queued);
+		queued = NULL;
 	}
 	mutex_unlock(&fault_param->lock);
+
+	if (queued)
+		iopf_send_responses(fault_param);
 }
 EXPORT_SYMBOL_GPL(iopf_group_response);
 
@@ -409,6 +516,8 @@ int iopf_queue_add_device(struct iopf_queue *queue, struct device *dev)
 	mutex_init(&fault_param->lock);
 	INIT_LIST_HEAD(&fault_param->faults);
 	INIT_LIST_HEAD(&fault_param->partial);
+	mutex_init(&fault_param->resp_lock);
+	INIT_LIST_HEAD(&fault_param->responses);
 	fault_param->dev = dev;
 	refcount_set(&fault_param->users, 1);
 	list_add(&fault_param->queue_list, &queue->devices);
@@ -481,6 +590,12 @@ void iopf_queue_remove_device(struct iopf_queue *queue, struct device *dev)
 	}
 	mutex_unlock(&fault_param->lock);
 
+	/*
+	 * Nothing can be queued anymore now that no fault is pending. Send
+	 * what was before PRI gets disabled.
+	 */
+	iopf_flush_responses(fault_param);
+
 	list_del(&fault_param->queue_list);
 
 	/* dec the ref owned by iopf_queue_add_device() */
@@ -510,9 +625,11 @@ struct iopf_queue *iopf_queue_alloc(const char *name)
 	 * The WQ is unordered because the low-level handler enqueues faults by
 	 * group. PRI requests within a group have to be ordered, but once
 	 * that's dealt with, the high-level function can handle groups out of
-	 * order.
+	 * order. Groups of all devices and PASIDs on the queue are therefore
+	 * handled in parallel, by up to iommu.iopf_workers at a time.
 	 */
-	queue->wq = alloc_workqueue("iopf_queue/%s", WQ_UNBOUND, 0, name);
+	queue->wq = alloc_workqueue("iopf_queue/%s", WQ_UNBOUND, iopf_workers,
+				    name);
 	if (!queue->wq) {
 		kfree(queue);
 		return NULL;
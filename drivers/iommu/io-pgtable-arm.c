@@ -15,6 +15,7 @@
 #include <linux/kernel.h>
 #include <linux/sizes.h>
 #include <linux/slab.h>
+#include <linux/spinlock.h>
 #include <linux/types.h>
 #include <linux/dma-mapping.h>
 
@@ -76,7 +77,10 @@
 
 #define ARM_LPAE_PTE_NSTABLE		(((arm_lpae_iopte)1) << 63)
 #define ARM_LPAE_PTE_XN			(((arm_lpae_iopte)3) << 53)
-#define ARM_LPAE_PTE_DBM		(((arm_lpae_iopte)1) << 51)
+#define ARM_LPAE_PTE_CONT_BIT		52
+#define ARM_LPAE_PTE_CONT		(((arm_lpae_iopte)1) << ARM_LPAE_PTE_CONT_BIT)
+#define ARM_LPAE_PTE_DBM_BIT		51
+#define ARM_LPAE_PTE_DBM		(((arm_lpae_iopte)1) << ARM_LPAE_PTE_DBM_BIT)
 #define ARM_LPAE_PTE_AF			(((arm_lpae_iopte)1) << 10)
 #define ARM_LPAE_PTE_SH_NS		(((arm_lpae_iopte)0) << 8)
 #define ARM_LPAE_PTE_SH_OS		(((arm_lpae_iopte)2) << 8)
@@ -162,12 +166,19 @@
 #define iopte_set_writeable_clean(ptep)				\
 	set_bit(ARM_LPAE_PTE_AP_RDONLY_BIT, (unsigned long *)(ptep))
 
+#define iopte_clear_cont(ptep)					\
+	clear_bit(ARM_LPAE_PTE_CONT_BIT, (unsigned long *)(ptep))
+
 struct arm_lpae_io_pgtable {
 	struct io_pgtable	iop;
 
 	int			pgd_bits;
 	int			start_level;
 	int			bits_per_level;
+	/* log2 of the number of entries in a contiguous run, 0 if unused */
+	int			cont_bits[ARM_LPAE_MAX_LEVELS];
+	/* Held for write while promoting, for read while unmapping */
+	rwlock_t		promote_lock;
 
 	void			*pgd;
 };
@@ -223,6 +234,25 @@ static inline int arm_lpae_max_entries(int i, struct arm_lpae_io_pgtable *data)
 	return ptes_per_table - (i & (ptes_per_table - 1));
 }
 
+static inline int arm_lpae_cont_entries(struct arm_lpae_io_pgtable *data,
+					int lvl)
+{
+	return data->cont_bits[lvl] ? 1 << data->cont_bits[lvl] : 0;
+}
+
+/*
+ * Whether @pte is a leaf with the same attributes as @first and mapping
+ * @paddr, so that both can be part of the same contiguous run or block.
+ */
+static inline bool arm_lpae_pte_follows(struct arm_lpae_io_pgtable *data,
+					int lvl, arm_lpae_iopte first,
+					arm_lpae_iopte pte, phys_addr_t paddr)
+{
+	return iopte_leaf(pte, lvl, data->iop.fmt) &&
+	       !((pte ^ first) & ~(ARM_LPAE_PTE_ADDR_MASK | ARM_LPAE_PTE_CONT)) &&
+	       iopte_to_paddr(pte, data) == paddr;
+}
+
 static bool selftest_running = false;
 
 static dma_addr_t __arm_lpae_dma_addr(void *pages)
@@ -313,21 +343,41 @@ static size_t __arm_lpae_unmap(struct arm_lpae_io_pgtable *data,
 			       int lvl, arm_lpae_iopte *ptep);
 
 static void __arm_lpae_init_pte(struct arm_lpae_io_pgtable *data,
-				phys_addr_t paddr, arm_lpae_iopte prot,
-				int lvl, int num_entries, arm_lpae_iopte *ptep)
+				unsigned long iova, phys_addr_t paddr,
+				arm_lpae_iopte prot, int lvl, int num_entries,
+				arm_lpae_iopte *ptep)
 {
 	arm_lpae_iopte pte = prot;
 	struct io_pgtable_cfg *cfg = &data->iop.cfg;
 	size_t sz = ARM_LPAE_BLOCK_SIZE(lvl, data);
-	int i;
+	int cont = arm_lpae_cont_entries(data, lvl);
+	int i, cont_start = 0, cont_end = 0;
 
 	if (data->iop.fmt != ARM_MALI_LPAE && lvl == ARM_LPAE_MAX_LEVELS - 1)
 		pte |= ARM_LPAE_PTE_TYPE_PAGE;
 	else
 		pte |= ARM_LPAE_PTE_TYPE_BLOCK;
 
-	for (i = 0; i < num_entries; i++)
+	/*
+	 * Hint the runs we map completely. The entries were invalid, so
+	 * nothing can have cached them and there is no need to break before
+	 * make. Within a run the iova and paddr offsets are the same, so if
+	 * the first run is misaligned in paddr then so are all others.
+	 */
+	if (cont) {
+		cont_start = ALIGN(iova, cont * sz) - iova;
+		cont_start /= sz;
+		if (cont_start < num_entries &&
+		    IS_ALIGNED(paddr + cont_start * sz, cont * sz))
+			cont_end = cont_start +
+				   round_down(num_entries - cont_start, cont);
+	}
+
+	for (i = 0; i < num_entries; i++) {
 		ptep[i] = pte | paddr_to_iopte(paddr + i * sz, data);
+		if (i >= cont_start && i < cont_end)
+			ptep[i] |= ARM_LPAE_PTE_CONT;
+	}
 
 	if (!cfg->coherent_walk)
 		__arm_lpae_sync_pte(ptep, num_entries, cfg);
@@ -361,10 +411,155 @@ static int arm_lpae_init_pte(struct arm_lpae_io_pgtable *data,
 			}
 		}
 
-	__arm_lpae_init_pte(data, paddr, prot, lvl, num_entries, ptep);
+	__arm_lpae_init_pte(data, iova, paddr, prot, lvl, num_entries, ptep);
 	return 0;
 }
 
+/*
+ * Set the contiguous hint on the run starting at @ptep if a map call made it
+ * fully populated. Called with the promote lock held for write, so that no
+ * entry of the run can be unmapped meanwhile. The previously cached, unhinted
+ * translations remain correct and may coexist with hinted ones on hardware
+ * with BBML2, so no invalidation is needed.
+ */
+static void arm_lpae_promote_cont(struct arm_lpae_io_pgtable *data, int lvl,
+				  arm_lpae_iopte *ptep)
+{
+	struct io_pgtable_cfg *cfg = &data->iop.cfg;
+	int i, cont = arm_lpae_cont_entries(data, lvl);
+	size_t sz = ARM_LPAE_BLOCK_SIZE(lvl, data);
+	arm_lpae_iopte first = READ_ONCE(ptep[0]);
+	phys_addr_t paddr;
+
+	if (!iopte_leaf(first, lvl, data->iop.fmt) || (first & ARM_LPAE_PTE_CONT))
+		return;
+
+	paddr = iopte_to_paddr(first, data);
+	if (!IS_ALIGNED(paddr, cont * sz))
+		return;
+
+	for (i = 1; i < cont; i++)
+		if (!arm_lpae_pte_follows(data, lvl, first, READ_ONCE(ptep[i]),
+					  paddr + i * sz))
+			return;
+
+	for (i = 0; i < cont; i++)
+		WRITE_ONCE(ptep[i], ptep[i] | ARM_LPAE_PTE_CONT);
+
+	if (!cfg->coherent_walk)
+		__arm_lpae_sync_pte(ptep, cont, cfg);
+}
+
+/*
+ * Try to hint the runs at either end of @num_entries entries just mapped at
+ * @ptep, which the map call only covered partially and so may have completed.
+ */
+static void arm_lpae_promote_cont_ends(struct arm_lpae_io_pgtable *data,
+				       unsigned long iova, int lvl,
+				       int num_entries, arm_lpae_iopte *ptep)
+{
+	int cont = arm_lpae_cont_entries(data, lvl);
+	int idx = ARM_LPAE_LVL_IDX(iova, lvl, data);
+	int head = round_down(idx, cont);
+	int tail = round_down(idx + num_entries - 1, cont);
+	unsigned long flags;
+
+	if (!cont || (IS_ALIGNED(idx, cont) &&
+		      IS_ALIGNED(idx + num_entries, cont)))
+		return;
+
+	if (!write_trylock_irqsave(&data->promote_lock, flags))
+		return;
+
+	if (!IS_ALIGNED(idx, cont))
+		arm_lpae_promote_cont(data, lvl, ptep - (idx - head));
+	if (!IS_ALIGNED(idx + num_entries, cont) &&
+	    (tail != head || IS_ALIGNED(idx, cont)))
+		arm_lpae_promote_cont(data, lvl, ptep + (tail - idx));
+
+	write_unlock_irqrestore(&data->promote_lock, flags);
+}
+
+/*
+ * Replace the table that @ptep points to with a block if a map call made it
+ * fully populated with leaves mapping a physically contiguous, block aligned
+ * range with the same attributes. Without BBML2 this would need the table
+ * entry to be invalidated first, faulting any DMA in flight to the range.
+ */
+static void arm_lpae_collapse_table(struct arm_lpae_io_pgtable *data,
+				    unsigned long iova, int lvl,
+				    arm_lpae_iopte *ptep)
+{
+	struct io_pgtable_cfg *cfg = &data->iop.cfg;
+	size_t block_size = ARM_LPAE_BLOCK_SIZE(lvl, data);
+	size_t sz = ARM_LPAE_BLOCK_SIZE(lvl + 1, data);
+	int i, n = ARM_LPAE_PTES_PER_TABLE(data);
+	int cont = arm_lpae_cont_entries(data, lvl);
+	arm_lpae_iopte table, first, *cptep;
+	unsigned long flags;
+	phys_addr_t paddr;
+
+	if (!(cfg->pgsize_bitmap & block_size))
+		return;
+
+	table = READ_ONCE(*ptep);
+	if (!table || iopte_leaf(table, lvl, data->iop.fmt))
+		return;
+
+	/* Looking at both ends rules out most tables cheaply */
+	cptep = iopte_deref(table, data);
+	first = READ_ONCE(cptep[0]);
+	paddr = iopte_to_paddr(first, data);
+	if (!iopte_leaf(first, lvl + 1, data->iop.fmt) ||
+	    !IS_ALIGNED(paddr, block_size) ||
+	    !arm_lpae_pte_follows(data, lvl + 1, first, READ_ONCE(cptep[n - 1]),
+				  paddr + (n - 1) * sz))
+		return;
+
+	if (!write_trylock_irqsave(&data->promote_lock, flags))
+		return;
+
+	/* Any of it may have been unmapped before we got the lock */
+	if (READ_ONCE(*ptep) != table)
+		goto out_unlock;
+
+	first = READ_ONCE(cptep[0]);
+	if (!iopte_leaf(first, lvl + 1, data->iop.fmt) ||
+	    iopte_to_paddr(first, data) != paddr)
+		goto out_unlock;
+
+	for (i = 1; i < n; i++)
+		if (!arm_lpae_pte_follows(data, lvl + 1, first,
+					  READ_ONCE(cptep[i]), paddr + i * sz))
+			goto out_unlock;
+
+	first &= ~(ARM_LPAE_PTE_ADDR_MASK | ARM_LPAE_PTE_CONT |
+		   ARM_LPAE_PTE_TYPE_MASK);
+	WRITE_ONCE(*ptep, first | ARM_LPAE_PTE_TYPE_BLOCK |
+			  paddr_to_iopte(paddr, data));
+	if (!cfg->coherent_walk)
+		__arm_lpae_sync_pte(ptep, 1, cfg);
+
+	/*
+	 * Walk caches may still point to the table. Software walkers can't,
+	 * they hold the promote lock for read while they look at tables that
+	 * are not theirs.
+	 */
+	io_pgtable_tlb_flush_walk(&data->iop, iova & ~(block_size - 1),
+				  block_size, ARM_LPAE_GRANULE(data));
+	__arm_lpae_free_pages(cptep, ARM_LPAE_GRANULE(data), cfg,
+			      data->iop.cookie);
+
+	/* The new block may in turn complete a run at this level */
+	if (cont) {
+		i = ARM_LPAE_LVL_IDX(iova, lvl, data);
+		arm_lpae_promote_cont(data, lvl, ptep - (i & (cont - 1)));
+	}
+
+out_unlock:
+	write_unlock_irqrestore(&data->promote_lock, flags);
+}
+
 static arm_lpae_iopte arm_lpae_install_table(arm_lpae_iopte *table,
 					     arm_lpae_iopte *ptep,
 					     arm_lpae_iopte curr,
@@ -417,8 +612,12 @@ static int __arm_lpae_map(struct arm_lpae_io_pgtable *data, unsigned long iova,
 		max_entries = arm_lpae_max_entries(map_idx_start, data);
 		num_entries = min_t(int, pgcount, max_entries);
 		ret = arm_lpae_init_pte(data, iova, paddr, prot, lvl, num_entries, ptep);
-		if (!ret)
+		if (!ret) {
 			*mapped += num_entries * size;
+			if (cfg->quirks & IO_PGTABLE_QUIRK_ARM_BBML2)
+				arm_lpae_promote_cont_ends(data, iova, lvl,
+							   num_entries, ptep);
+		}
 
 		return ret;
 	}
@@ -450,8 +649,12 @@ static int __arm_lpae_map(struct arm_lpae_io_pgtable *data, unsigned long iova,
 	}
 
 	/* Rinse, repeat */
-	return __arm_lpae_map(data, iova, paddr, size, pgcount, prot, lvl + 1,
-			      cptep, gfp, mapped);
+	ret = __arm_lpae_map(data, iova, paddr, size, pgcount, prot, lvl + 1,
+			     cptep, gfp, mapped);
+	if (!ret && (cfg->quirks & IO_PGTABLE_QUIRK_ARM_BBML2))
+		arm_lpae_collapse_table(data, iova, lvl, ptep);
+
+	return ret;
 }
 
 static arm_lpae_iopte arm_lpae_prot_to_pte(struct arm_lpae_io_pgtable *data,
@@ -597,6 +800,49 @@ static void arm_lpae_free_pgtable(struct io_pgtable *iop)
 	kfree(data);
 }
 
+/*
+ * Drop the contiguous hint from the runs at either end of @num_entries
+ * entries about to be unmapped at @ptep, which would otherwise keep hinting a
+ * translation for the entries left mapped. The ones still cached become
+ * unhinted once the unmapped range is invalidated, which hits any contiguous
+ * TLB entry covering it.
+ */
+static void arm_lpae_split_cont_ends(struct arm_lpae_io_pgtable *data,
+				     unsigned long iova, int lvl,
+				     int num_entries, arm_lpae_iopte *ptep)
+{
+	struct io_pgtable_cfg *cfg = &data->iop.cfg;
+	int i, cont = arm_lpae_cont_entries(data, lvl);
+	int idx = ARM_LPAE_LVL_IDX(iova, lvl, data);
+	int head = round_down(idx, cont);
+	int tail = round_down(idx + num_entries - 1, cont);
+	arm_lpae_iopte *runp[2] = {};
+
+	if (!IS_ALIGNED(idx, cont))
+		runp[0] = ptep - (idx - head);
+	if (!IS_ALIGNED(idx + num_entries, cont) &&
+	    (tail != head || IS_ALIGNED(idx, cont)))
+		runp[1] = ptep + (tail - idx);
+
+	for (int r = 0; r < ARRAY_SIZE(runp); r++) {
+		if (!runp[r] || !(READ_ONCE(*runp[r]) & ARM_LPAE_PTE_CONT))
+			continue;
+
+		/* Atomically, as other parts of the run may be unmapped too */
+		for (i = 0; i < cont; i++)
+			iopte_clear_cont(&runp[r][i]);
+
+		if (!cfg->coherent_walk)
+			__arm_lpae_sync_pte(runp[r], cont, cfg);
+	}
+}
+
+static size_t arm_lpae_split_blk_unmap(struct arm_lpae_io_pgtable *data,
+				       struct iommu_iotlb_gather *gather,
+				       unsigned long iova, size_t size,
+				       arm_lpae_iopte blk_pte, int lvl,
+				       arm_lpae_iopte *ptep, size_t pgcount);
+
 static size_t __arm_lpae_unmap(struct arm_lpae_io_pgtable *data,
 			       struct iommu_iotlb_gather *gather,
 			       unsigned long iova, size_t size, size_t pgcount,
@@ -621,6 +867,9 @@ static size_t __arm_lpae_unmap(struct arm_lpae_io_pgtable *data,
 		max_entries = arm_lpae_max_entries(unmap_idx_start, data);
 		num_entries = min_t(int, pgcount, max_entries);
 
+		if (arm_lpae_cont_entries(data, lvl))
+			arm_lpae_split_cont_ends(data, iova, lvl, num_entries, ptep);
+
 		/* Find and handle non-leaf entries */
 		for (i = 0; i < num_entries; i++) {
 			pte = READ_ONCE(ptep[i]);
@@ -646,6 +895,15 @@ static size_t __arm_lpae_unmap(struct arm_lpae_io_pgtable *data,
 
 		return i * size;
 	} else if (iopte_leaf(pte, lvl, iop->fmt)) {
+		/* Blocks may only have been promoted on hardware with BBML2 */
+		if (iop->cfg.quirks & IO_PGTABLE_QUIRK_ARM_BBML2) {
+			if (arm_lpae_cont_entries(data, lvl))
+				arm_lpae_split_cont_ends(data, iova, lvl, 1, ptep);
+			return arm_lpae_split_blk_unmap(data, gather, iova, size,
+							pte, lvl + 1, ptep,
+							pgcount);
+		}
+
 		WARN_ONCE(true, "Unmap of a partial large IOPTE is not allowed");
 		return 0;
 	}
@@ -655,6 +913,77 @@ static size_t __arm_lpae_unmap(struct arm_lpae_io_pgtable *data,
 	return __arm_lpae_unmap(data, gather, iova, size, pgcount, lvl + 1, ptep);
 }
 
+/*
+ * Replace the block @blk_pte at @ptep with a table at level @lvl mapping all
+ * of it but the range being unmapped. Only valid with BBML2, as the block is
+ * replaced without being invalidated first: the TLB may keep the block cached
+ * until the unmapped range is invalidated.
+ */
+static size_t arm_lpae_split_blk_unmap(struct arm_lpae_io_pgtable *data,
+				       struct iommu_iotlb_gather *gather,
+				       unsigned long iova, size_t size,
+				       arm_lpae_iopte blk_pte, int lvl,
+				       arm_lpae_iopte *ptep, size_t pgcount)
+{
+	struct io_pgtable_cfg *cfg = &data->iop.cfg;
+	arm_lpae_iopte pte, *tablep;
+	phys_addr_t blk_paddr;
+	size_t tablesz = ARM_LPAE_GRANULE(data);
+	size_t split_sz = ARM_LPAE_BLOCK_SIZE(lvl, data);
+	unsigned long blk_iova = iova & ~(ARM_LPAE_BLOCK_SIZE(lvl - 1, data) - 1);
+	int ptes_per_table = ARM_LPAE_PTES_PER_TABLE(data);
+	int i, unmap_idx_start = -1, num_entries = 0;
+
+	if (WARN_ON(lvl == ARM_LPAE_MAX_LEVELS))
+		return 0;
+
+	tablep = __arm_lpae_alloc_pages(tablesz, GFP_ATOMIC, cfg, data->iop.cookie);
+	if (!tablep)
+		return 0; /* Bytes unmapped */
+
+	if (size == split_sz) {
+		unmap_idx_start = ARM_LPAE_LVL_IDX(iova, lvl, data);
+		num_entries = min_t(int, pgcount,
+				    ptes_per_table - unmap_idx_start);
+	}
+
+	blk_paddr = iopte_to_paddr(blk_pte, data);
+	pte = iopte_prot(blk_pte);
+
+	for (i = 0; i < ptes_per_table; i++) {
+		/* Unmap! */
+		if (i >= unmap_idx_start && i < unmap_idx_start + num_entries)
+			continue;
+
+		__arm_lpae_init_pte(data, blk_iova + i * split_sz,
+				    blk_paddr + i * split_sz, pte, lvl, 1,
+				    &tablep[i]);
+	}
+
+	pte = arm_lpae_install_table(tablep, ptep, blk_pte, data);
+	if (pte != blk_pte) {
+		__arm_lpae_free_pages(tablep, tablesz, cfg, data->iop.cookie);
+		/*
+		 * We may race against someone unmapping another part of this
+		 * block, but anything else is invalid. We can't misinterpret
+		 * a page entry here since we're never at the last level.
+		 */
+		if (iopte_type(pte) != ARM_LPAE_PTE_TYPE_TABLE)
+			return 0;
+
+		tablep = iopte_deref(pte, data);
+	} else if (unmap_idx_start >= 0) {
+		if (gather && !iommu_iotlb_gather_queued(gather))
+			for (i = 0; i < num_entries; i++)
+				io_pgtable_tlb_add_page(&data->iop, gather,
+							iova + i * size, size);
+
+		return num_entries * size;
+	}
+
+	return __arm_lpae_unmap(data, gather, iova, size, pgcount, lvl, tablep);
+}
+
 static size_t arm_lpae_unmap_pages(struct io_pgtable_ops *ops, unsigned long iova,
 				   size_t pgsize, size_t pgcount,
 				   struct iommu_iotlb_gather *gather)
@@ -663,6 +992,7 @@ static size_t arm_lpae_unmap_pages(struct io_pgtable_ops *ops, unsigned long iov
 	struct io_pgtable_cfg *cfg = &data->iop.cfg;
 	arm_lpae_iopte *ptep = data->pgd;
 	long iaext = (s64)iova >> cfg->ias;
+	size_t unmapped;
 
 	if (WARN_ON(!pgsize || (pgsize & cfg->pgsize_bitmap) != pgsize || !pgcount))
 		return 0;
@@ -672,14 +1002,22 @@ static size_t arm_lpae_unmap_pages(struct io_pgtable_ops *ops, unsigned long iov
 	if (WARN_ON(iaext))
 		return 0;
 
-	return __arm_lpae_unmap(data, gather, iova, pgsize, pgcount,
-				data->start_level, ptep);
+	if (!(cfg->quirks & IO_PGTABLE_QUIRK_ARM_BBML2))
+		return __arm_lpae_unmap(data, gather, iova, pgsize, pgcount,
+					data->start_level, ptep);
+
+	/* Keep promotion from looking at entries we are about to clear */
+	read_lock(&data->promote_lock);
+	unmapped = __arm_lpae_unmap(data, gather, iova, pgsize, pgcount,
+				    data->start_level, ptep);
+	read_unlock(&data->promote_lock);
+
+	return unmapped;
 }
 
-static phys_addr_t arm_lpae_iova_to_phys(struct io_pgtable_ops *ops,
-					 unsigned long iova)
+static phys_addr_t __arm_lpae_iova_to_phys(struct arm_lpae_io_pgtable *data,
+					   unsigned long iova)
 {
-	struct arm_lpae_io_pgtable *data = io_pgtable_ops_to_data(ops);
 	arm_lpae_iopte pte, *ptep = data->pgd;
 	int lvl = data->start_level;
 
@@ -712,43 +1050,75 @@ static phys_addr_t arm_lpae_iova_to_phys(struct io_pgtable_ops *ops,
 	return iopte_to_paddr(pte, data) | iova;
 }
 
+static phys_addr_t arm_lpae_iova_to_phys(struct io_pgtable_ops *ops,
+					 unsigned long iova)
+{
+	struct arm_lpae_io_pgtable *data = io_pgtable_ops_to_data(ops);
+	phys_addr_t phys;
+
+	if (!(data->iop.cfg.quirks & IO_PGTABLE_QUIRK_ARM_BBML2))
+		return __arm_lpae_iova_to_phys(data, iova);
+
+	/* Promotion may free a table we walk through */
+	read_lock(&data->promote_lock);
+	phys = __arm_lpae_iova_to_phys(data, iova);
+	read_unlock(&data->promote_lock);
+
+	return phys;
+}
+
 struct io_pgtable_walk_data {
 	struct iommu_dirty_bitmap	*dirty;
 	unsigned long			flags;
 	u64				addr;
 	const u64			end;
+	/* Run of dirty leaves not recorded yet */
+	u64				dirty_start;
+	u64				dirty_end;
 };
 
-static int __arm_lpae_iopte_walk_dirty(struct arm_lpae_io_pgtable *data,
-				       struct io_pgtable_walk_data *walk_data,
-				       arm_lpae_iopte *ptep,
-				       int lvl);
-
-static int io_pgtable_visit_dirty(struct arm_lpae_io_pgtable *data,
-				  struct io_pgtable_walk_data *walk_data,
-				  arm_lpae_iopte *ptep, int lvl)
+static void io_pgtable_flush_dirty(struct io_pgtable_walk_data *walk_data)
 {
-	struct io_pgtable *iop = &data->iop;
-	arm_lpae_iopte pte = READ_ONCE(*ptep);
-
-	if (iopte_leaf(pte, lvl, iop->fmt)) {
-		size_t size = ARM_LPAE_BLOCK_SIZE(lvl, data);
+	if (walk_data->dirty_end != walk_data->dirty_start)
+		iommu_dirty_bitmap_record(walk_data->dirty,
+					  walk_data->dirty_start,
+					  walk_data->dirty_end -
+					  walk_data->dirty_start);
+	walk_data->dirty_start = walk_data->dirty_end = 0;
+}
 
-		if (iopte_writeable_dirty(pte)) {
-			iommu_dirty_bitmap_record(walk_data->dirty,
-						  walk_data->addr, size);
-			if (!(walk_data->flags & IOMMU_DIRTY_NO_CLEAR))
-				iopte_set_writeable_clean(ptep);
-		}
-		walk_data->addr += size;
-		return 0;
+/*
+ * Adjacent dirty leaves are recorded as one range, so that the bitmap and the
+ * IOTLB gather are updated once per run rather than once per leaf.
+ */
+static void io_pgtable_record_dirty(struct io_pgtable_walk_data *walk_data,
+				    u64 addr, size_t size)
+{
+	if (walk_data->dirty_end == walk_data->dirty_start ||
+	    walk_data->dirty_end != addr) {
+		io_pgtable_flush_dirty(walk_data);
+		walk_data->dirty_start = addr;
 	}
+	walk_data->dirty_end = addr + size;
+}
 
-	if (WARN_ON(!iopte_table(pte, lvl)))
-		return -EINVAL;
+/*
+ * Whether any of @num_entries leaves or invalid entries is writeable-dirty,
+ * i.e. has DBM set and AP[2] clear. This is branch-free, and only a snapshot
+ * of the table as the walker may dirty entries meanwhile, which are then
+ * reported by the next call anyway.
+ */
+static bool arm_lpae_ptes_have_dirty(const arm_lpae_iopte *ptep,
+				     int num_entries)
+{
+	const int shift = ARM_LPAE_PTE_DBM_BIT - ARM_LPAE_PTE_AP_RDONLY_BIT;
+	arm_lpae_iopte acc = 0;
+	int i;
 
-	ptep = iopte_deref(pte, data);
-	return __arm_lpae_iopte_walk_dirty(data, walk_data, ptep, lvl + 1);
+	for (i = 0; i < num_entries; i++)
+		acc |= ptep[i] & ~(ptep[i] << shift);
+
+	return acc & ARM_LPAE_PTE_DBM;
 }
 
 static int __arm_lpae_iopte_walk_dirty(struct arm_lpae_io_pgtable *data,
@@ -756,8 +1126,12 @@ static int __arm_lpae_iopte_walk_dirty(struct arm_lpae_io_pgtable *data,
 				       arm_lpae_iopte *ptep,
 				       int lvl)
 {
-	u32 idx;
+	struct io_pgtable *iop = &data->iop;
+	size_t size = ARM_LPAE_BLOCK_SIZE(lvl, data);
 	int max_entries, ret;
+	arm_lpae_iopte pte;
+	u64 next;
+	u32 idx;
 
 	if (WARN_ON(lvl == ARM_LPAE_MAX_LEVELS))
 		return -EINVAL;
@@ -767,11 +1141,47 @@ static int __arm_lpae_iopte_walk_dirty(struct arm_lpae_io_pgtable *data,
 	else
 		max_entries = ARM_LPAE_PTES_PER_TABLE(data);
 
-	for (idx = ARM_LPAE_LVL_IDX(walk_data->addr, lvl, data);
-	     (idx < max_entries) && (walk_data->addr < walk_data->end); ++idx) {
-		ret = io_pgtable_visit_dirty(data, walk_data, ptep + idx, lvl);
-		if (ret)
-			return ret;
+	idx = ARM_LPAE_LVL_IDX(walk_data->addr, lvl, data);
+
+	/*
+	 * Last level tables only hold leaves, so most of them, being clean,
+	 * can be skipped by a single pass without visiting each entry.
+	 */
+	if (lvl == ARM_LPAE_MAX_LEVELS - 1) {
+		u64 base = walk_data->addr & ~(u64)(size - 1);
+		int num_entries = min_t(u64, max_entries - idx,
+					DIV_ROUND_UP(walk_data->end - base, size));
+
+		if (!arm_lpae_ptes_have_dirty(ptep + idx, num_entries)) {
+			walk_data->addr = base + num_entries * size;
+			return 0;
+		}
+	}
+
+	for (; idx < max_entries && walk_data->addr < walk_data->end; ++idx) {
+		pte = READ_ONCE(ptep[idx]);
+
+		if (pte && !iopte_leaf(pte, lvl, iop->fmt)) {
+			if (WARN_ON(!iopte_table(pte, lvl)))
+				return -EINVAL;
+
+			ret = __arm_lpae_iopte_walk_dirty(data, walk_data,
+							  iopte_deref(pte, data),
+							  lvl + 1);
+			if (ret)
+				return ret;
+			continue;
+		}
+
+		/* Holes are skipped, the range may span several mappings */
+		next = (walk_data->addr | (size - 1)) + 1;
+		if (pte && iopte_writeable_dirty(pte)) {
+			io_pgtable_record_dirty(walk_data, walk_data->addr,
+						next - walk_data->addr);
+			if (!(walk_data->flags & IOMMU_DIRTY_NO_CLEAR))
+				iopte_set_writeable_clean(ptep + idx);
+		}
+		walk_data->addr = next;
 	}
 
 	return 0;
@@ -792,6 +1202,7 @@ static int arm_lpae_read_and_clear_dirty(struct io_pgtable_ops *ops,
 	};
 	arm_lpae_iopte *ptep = data->pgd;
 	int lvl = data->start_level;
+	int ret;
 
 	if (WARN_ON(!size))
 		return -EINVAL;
@@ -800,7 +1211,14 @@ static int arm_lpae_read_and_clear_dirty(struct io_pgtable_ops *ops,
 	if (data->iop.fmt != ARM_64_LPAE_S1)
 		return -EINVAL;
 
-	return __arm_lpae_iopte_walk_dirty(data, &walk_data, ptep, lvl);
+	if (cfg->quirks & IO_PGTABLE_QUIRK_ARM_BBML2)
+		read_lock(&data->promote_lock);
+	ret = __arm_lpae_iopte_walk_dirty(data, &walk_data, ptep, lvl);
+	if (cfg->quirks & IO_PGTABLE_QUIRK_ARM_BBML2)
+		read_unlock(&data->promote_lock);
+	io_pgtable_flush_dirty(&walk_data);
+
+	return ret;
 }
 
 static void arm_lpae_restrict_pgsizes(struct io_pgtable_cfg *cfg)
@@ -877,6 +1295,9 @@ arm_lpae_alloc_pgtable(struct io_pgtable_cfg *cfg)
 	/* Calculate the actual size of our pgd (without concatenation) */
 	data->pgd_bits = va_bits - (data->bits_per_level * (levels - 1));
 
+	memset(data->cont_bits, 0, sizeof(data->cont_bits));
+	rwlock_init(&data->promote_lock);
+
 	data->iop.ops = (struct io_pgtable_ops) {
 		.map_pages	= arm_lpae_map_pages,
 		.unmap_pages	= arm_lpae_unmap_pages,
@@ -887,6 +1308,27 @@ arm_lpae_alloc_pgtable(struct io_pgtable_cfg *cfg)
 	return data;
 }
 
+/*
+ * Number of entries the contiguous hint applies to at the levels it is
+ * defined for with each granule. Only used with BBML2, since partial unmaps
+ * have to drop the hint from live entries.
+ */
+static void arm_lpae_init_cont(struct arm_lpae_io_pgtable *data)
+{
+	switch (ARM_LPAE_GRANULE(data)) {
+	case SZ_4K:
+		data->cont_bits[2] = data->cont_bits[3] = 4;
+		break;
+	case SZ_16K:
+		data->cont_bits[2] = 5;
+		data->cont_bits[3] = 7;
+		break;
+	case SZ_64K:
+		data->cont_bits[2] = data->cont_bits[3] = 5;
+		break;
+	}
+}
+
 static struct io_pgtable *
 arm_64_lpae_alloc_pgtable_s1(struct io_pgtable_cfg *cfg, void *cookie)
 {
@@ -898,13 +1340,19 @@ arm_64_lpae_alloc_pgtable_s1(struct io_pgtable_cfg *cfg, void *cookie)
 	if (cfg->quirks & ~(IO_PGTABLE_QUIRK_ARM_NS |
 			    IO_PGTABLE_QUIRK_ARM_TTBR1 |
 			    IO_PGTABLE_QUIRK_ARM_OUTER_WBWA |
-			    IO_PGTABLE_QUIRK_ARM_HD))
+			    IO_PGTABLE_QUIRK_ARM_HD |
+			    IO_PGTABLE_QUIRK_ARM_BBML2))
 		return NULL;
 
 	data = arm_lpae_alloc_pgtable(cfg);
 	if (!data)
 		return NULL;
 
+	/* Dirty state is tracked per entry, so is not shared by runs */
+	if ((cfg->quirks & IO_PGTABLE_QUIRK_ARM_BBML2) &&
+	    !(cfg->quirks & IO_PGTABLE_QUIRK_ARM_HD))
+		arm_lpae_init_cont(data);
+
 	/* TCR */
 	if (cfg->coherent_walk) {
 		tcr->sh = ARM_LPAE_TCR_SH_IS;
@@ -999,13 +1447,17 @@ arm_64_lpae_alloc_pgtable_s2(struct io_pgtable_cfg *cfg, void *cookie)
 	struct arm_lpae_io_pgtable *data;
 	typeof(&cfg->arm_lpae_s2_cfg.vtcr) vtcr = &cfg->arm_lpae_s2_cfg.vtcr;
 
-	if (cfg->quirks & ~(IO_PGTABLE_QUIRK_ARM_S2FWB))
+	if (cfg->quirks & ~(IO_PGTABLE_QUIRK_ARM_S2FWB |
+			    IO_PGTABLE_QUIRK_ARM_BBML2))
 		return NULL;
 
 	data = arm_lpae_alloc_pgtable(cfg);
 	if (!data)
 		return NULL;
 
+	if (cfg->quirks & IO_PGTABLE_QUIRK_ARM_BBML2)
+		arm_lpae_init_cont(data);
+
 	/*
 	 * Concatenate PGDs at level 1 if possible in order to reduce
 	 * the depth of the stage-2 walk.
@@ -2,6 +2,7 @@
 /*
  * Helpers for IOMMU drivers implementing SVA
  */
+#include <linux/mm.h>
 #include <linux/mmu_context.h>
 #include <linux/mutex.h>
 #include <linux/sched/mm.h>
@@ -191,6 +192,72 @@ u32 iommu_sva_get_pasid(struct iommu_sva *handle)
 }
 EXPORT_SYMBOL_GPL(iommu_sva_get_pasid);
 
+/**
+ * iommu_sva_prefault() - Populate the device view of a range of a bound mm
+ * @handle: the device-mm bond
+ * @addr: start of the range
+ * @size: size of the range
+ * @write: whether the device is going to write to the range
+ *
+ * With SVA the IOMMU walks the CPU page tables, so faulting in the pages of a
+ * range the device is known to access spares its first accesses the page
+ * request round trip. Where supported the IOMMU TLBs are then preloaded as
+ * well. The pages are not pinned: if they are later reclaimed or migrated,
+ * device accesses fault as usual.
+ *
+ * Return: 0 on success, -EFAULT if part of the range isn't mapped with the
+ * required permissions, or another negative error.
+ */
+int iommu_sva_prefault(struct iommu_sva *handle, unsigned long addr,
+		       size_t size, bool write)
+{
+	struct iommu_domain *domain = handle->handle.domain;
+	unsigned int gup_flags = write ? FOLL_WRITE : 0;
+	struct mm_struct *mm = domain->mm;
+	unsigned long start = addr & PAGE_MASK;
+	unsigned long nr_pages;
+	int locked = 1;
+	long ret = 0;
+
+	if (!size || addr + size < addr)
+		return -EINVAL;
+	nr_pages = (PAGE_ALIGN(addr + size) - start) >> PAGE_SHIFT;
+
+	if (!mmget_not_zero(mm))
+		return -ESRCH;
+
+	mmap_read_lock(mm);
+	while (nr_pages) {
+		/* No pages are returned, so none are pinned */
+		ret = get_user_pages_remote(mm, start, nr_pages, gup_flags,
+					    NULL, &locked);
+		if (ret <= 0)
+			break;
+
+		start += ret << PAGE_SHIFT;
+		nr_pages -= ret;
+		if (!locked) {
+			mmap_read_lock(mm);
+			locked = 1;
+		}
+	}
+	if (locked)
+		mmap_read_unlock(mm);
+	mmput(mm);
+
+	if (ret < 0)
+		return ret;
+	if (nr_pages)
+		return -EFAULT;
+
+	if (domain->ops->prefetch)
+		domain->ops->prefetch(domain, handle->dev,
+				      mm_get_enqcmd_pasid(mm), addr, size);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(iommu_sva_prefault);
+
 void mm_pasid_drop(struct mm_struct *mm)
 {
 	struct iommu_mm_data *iommu_mm = mm->iommu_mm;
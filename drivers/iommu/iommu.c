@@ -2475,12 +2475,22 @@ static int __iommu_map(struct iommu_domain *domain, unsigned long iova,
 	return ret;
 }
 
-int iommu_map(struct iommu_domain *domain, unsigned long iova,
-	      phys_addr_t paddr, size_t size, int prot, gfp_t gfp)
+/**
+ * iommu_map_nosync() - Map a range without syncing it to the IOMMU
+ * @domain: Domain to manipulate
+ * @iova: IO virtual address to map at
+ * @paddr: Physical address to map
+ * @size: Length of the range
+ * @prot: IOMMU_* protection flags
+ * @gfp: Allocation flags for the page tables
+ *
+ * Like iommu_map(), but the mapping is not guaranteed to be visible to the
+ * IOMMU until iommu_sync_map() has been called on a range covering it.  This
+ * allows several ranges to be mapped with a single sync.
+ */
+int iommu_map_nosync(struct iommu_domain *domain, unsigned long iova,
+		     phys_addr_t paddr, size_t size, int prot, gfp_t gfp)
 {
-	const struct iommu_domain_ops *ops = domain->ops;
-	int ret;
-
 	might_sleep_if(gfpflags_allow_blocking(gfp));
 
 	/* Discourage passing strange GFP flags */
@@ -2488,18 +2498,34 @@ int iommu_map(struct iommu_domain *domain, unsigned long iova,
 				__GFP_HIGHMEM)))
 		return -EINVAL;
 
-	ret = __iommu_map(domain, iova, paddr, size, prot, gfp);
-	if (ret == 0 && ops->iotlb_sync_map) {
-		ret = ops->iotlb_sync_map(domain, iova, size);
-		if (ret)
-			goto out_err;
-	}
+	return __iommu_map(domain, iova, paddr, size, prot, gfp);
+}
+EXPORT_SYMBOL_GPL(iommu_map_nosync);
 
-	return ret;
+int iommu_sync_map(struct iommu_domain *domain, unsigned long iova,
+		   size_t size)
+{
+	const struct iommu_domain_ops *ops = domain->ops;
 
-out_err:
-	/* undo mappings already done */
-	iommu_unmap(domain, iova, size);
+	if (!ops->iotlb_sync_map)
+		return 0;
+	return ops->iotlb_sync_map(domain, iova, size);
+}
+EXPORT_SYMBOL_GPL(iommu_sync_map);
+
+int iommu_map(struct iommu_domain *domain, unsigned long iova,
+	      phys_addr_t paddr, size_t size, int prot, gfp_t gfp)
+{
+	int ret;
+
+	ret = iommu_map_nosync(domain, iova, paddr, size, prot, gfp);
+	if (ret)
+		return ret;
+
+	ret = iommu_sync_map(domain, iova, size);
+	if (ret)
+		/* undo mappings already done */
+		iommu_unmap(domain, iova, size);
 
 	return ret;
 }
@@ -8,16 +8,19 @@
 #include <linux/iova.h>
 #include <linux/kmemleak.h>
 #include <linux/module.h>
+#include <linux/nodemask.h>
 #include <linux/slab.h>
 #include <linux/smp.h>
 #include <linux/bitops.h>
 #include <linux/cpu.h>
+#include <linux/topology.h>
 #include <linux/workqueue.h>
 
 /* The anchor node sits above the top of the usable address space */
 #define IOVA_ANCHOR	~0UL
 
-#define IOVA_RANGE_CACHE_MAX_SIZE 6	/* log of max cached IOVA range size (in pages) */
+#define IOVA_RANGE_CACHE_MAX_SIZE 9	/* log of max cached IOVA range size (in pages) */
+#define IOVA_RANGE_CACHE_DEFAULT_SIZE 6	/* same, for the ranges cached from the start */
 
 static bool iova_rcache_insert(struct iova_domain *iovad,
 			       unsigned long pfn,
@@ -384,7 +387,9 @@ alloc_iova_fast(struct iova_domain *iovad, unsigned long size,
 	 * Freeing non-power-of-two-sized allocations back into the IOVA caches
 	 * will come back to bite us badly, so we have to waste a bit of space
 	 * rounding up anything cacheable to make sure that can't happen. The
-	 * order of the unadjusted size will still match upon freeing.
+	 * order of the unadjusted size will still match upon freeing.  This
+	 * includes the sizes whose cache is not populated yet, as it may be
+	 * by the time the range is freed.
 	 */
 	if (size < (1 << (IOVA_RANGE_CACHE_MAX_SIZE - 1)))
 		size = roundup_pow_of_two(size);
@@ -555,6 +560,17 @@ EXPORT_SYMBOL_GPL(reserve_iova);
  * Allocator to Many CPUs and Arbitrary Resources" by Bonwick and Adams.
  * For simplicity, we use a static magazine size and don't implement the
  * dynamic size tuning described in the paper.
+ *
+ * The depot of full magazines is split per NUMA node, so that magazines
+ * freed on one node are preferably reused there rather than bouncing the
+ * depot lock and the magazines between sockets.  Other nodes' depots are
+ * only looked at when the local one is empty.
+ *
+ * Ranges of up to 2^(IOVA_RANGE_CACHE_DEFAULT_SIZE - 1) pages are always
+ * cached.  The buckets for larger ranges, up to
+ * 2^(IOVA_RANGE_CACHE_MAX_SIZE - 1) pages, cost two magazines per CPU each,
+ * so they are only populated once a domain has fallen back to the rbtree
+ * IOVA_RCACHE_ENABLE_MISSES times for that size.
  */
 
 /*
@@ -567,6 +583,8 @@ EXPORT_SYMBOL_GPL(reserve_iova);
 
 #define IOVA_DEPOT_DELAY msecs_to_jiffies(100)
 
+#define IOVA_RCACHE_ENABLE_MISSES 1024
+
 struct iova_magazine {
 	union {
 		unsigned long size;
@@ -582,20 +600,26 @@ struct iova_cpu_rcache {
 	struct iova_magazine *prev;
 };
 
-struct iova_rcache {
+struct iova_depot {
 	spinlock_t lock;
-	unsigned int depot_size;
-	struct iova_magazine *depot;
+	unsigned int size;
+	struct iova_magazine *head;
+} ____cacheline_aligned_in_smp;
+
+struct iova_rcache {
+	struct iova_depot **depots;
 	struct iova_cpu_rcache __percpu *cpu_rcaches;
 	struct iova_domain *iovad;
 	struct delayed_work work;
+	struct work_struct enable_work;
+	atomic_t misses;
 };
 
 static struct kmem_cache *iova_magazine_cache;
 
 unsigned long iova_rcache_range(void)
 {
-	return PAGE_SIZE << (IOVA_RANGE_CACHE_MAX_SIZE - 1);
+	return PAGE_SIZE << (IOVA_RANGE_CACHE_DEFAULT_SIZE - 1);
 }
 
 static struct iova_magazine *iova_magazine_alloc(gfp_t flags)
@@ -670,50 +694,143 @@ static void iova_magazine_push(struct iova_magazine *mag, unsigned long pfn)
 	mag->pfns[mag->size++] = pfn;
 }
 
-static struct iova_magazine *iova_depot_pop(struct iova_rcache *rcache)
+static struct iova_magazine *iova_depot_pop(struct iova_depot *depot)
 {
-	struct iova_magazine *mag = rcache->depot;
+	struct iova_magazine *mag = depot->head;
 
 	/*
-	 * As the mag->next pointer is moved to rcache->depot and reset via
+	 * As the mag->next pointer is moved to depot->head and reset via
 	 * the mag->size assignment, mark it as a transient false positive.
 	 */
 	kmemleak_transient_leak(mag->next);
-	rcache->depot = mag->next;
+	depot->head = mag->next;
 	mag->size = IOVA_MAG_SIZE;
-	rcache->depot_size--;
+	depot->size--;
 	return mag;
 }
 
-static void iova_depot_push(struct iova_rcache *rcache, struct iova_magazine *mag)
+static void iova_depot_push(struct iova_depot *depot, struct iova_magazine *mag)
+{
+	mag->next = depot->head;
+	depot->head = mag;
+	depot->size++;
+}
+
+/*
+ * Take a full magazine from the depot of the local node, or from any other
+ * node's if that one is empty.  Called with IRQs disabled.
+ */
+static struct iova_magazine *iova_rcache_depot_pop(struct iova_rcache *rcache)
 {
-	mag->next = rcache->depot;
-	rcache->depot = mag;
-	rcache->depot_size++;
+	int local = numa_node_id(), node = local;
+	struct iova_magazine *mag = NULL;
+	struct iova_depot *depot;
+
+	do {
+		depot = rcache->depots[node];
+		if (READ_ONCE(depot->head)) {
+			spin_lock(&depot->lock);
+			if (depot->head)
+				mag = iova_depot_pop(depot);
+			spin_unlock(&depot->lock);
+		}
+		node = next_node_in(node, node_possible_map);
+	} while (!mag && node != local);
+
+	return mag;
 }
 
 static void iova_depot_work_func(struct work_struct *work)
 {
 	struct iova_rcache *rcache = container_of(work, typeof(*rcache), work.work);
-	struct iova_magazine *mag = NULL;
+	struct iova_magazine *mag;
+	bool again = false;
 	unsigned long flags;
+	int node;
+
+	/*
+	 * Trim each depot by one magazine per run, down to about one magazine
+	 * per CPU of its node.
+	 */
+	for_each_node(node) {
+		struct iova_depot *depot = rcache->depots[node];
 
-	spin_lock_irqsave(&rcache->lock, flags);
-	if (rcache->depot_size > num_online_cpus())
-		mag = iova_depot_pop(rcache);
-	spin_unlock_irqrestore(&rcache->lock, flags);
+		mag = NULL;
+		spin_lock_irqsave(&depot->lock, flags);
+		if (depot->size > max(nr_cpus_node(node), 1))
+			mag = iova_depot_pop(depot);
+		spin_unlock_irqrestore(&depot->lock, flags);
 
-	if (mag) {
-		iova_magazine_free_pfns(mag, rcache->iovad);
-		iova_magazine_free(mag);
+		if (mag) {
+			iova_magazine_free_pfns(mag, rcache->iovad);
+			iova_magazine_free(mag);
+			again = true;
+		}
+	}
+
+	if (again)
 		schedule_delayed_work(&rcache->work, IOVA_DEPOT_DELAY);
+}
+
+static void iova_rcache_free_cpu_rcaches(struct iova_cpu_rcache __percpu *cpu_rcaches)
+{
+	struct iova_cpu_rcache *cpu_rcache;
+	unsigned int cpu;
+
+	for_each_possible_cpu(cpu) {
+		cpu_rcache = per_cpu_ptr(cpu_rcaches, cpu);
+		iova_magazine_free(cpu_rcache->loaded);
+		iova_magazine_free(cpu_rcache->prev);
 	}
+	free_percpu(cpu_rcaches);
 }
 
-int iova_domain_init_rcaches(struct iova_domain *iovad)
+static struct iova_cpu_rcache __percpu *iova_rcache_alloc_cpu_rcaches(void)
 {
+	struct iova_cpu_rcache __percpu *cpu_rcaches;
+	struct iova_cpu_rcache *cpu_rcache;
 	unsigned int cpu;
-	int i, ret;
+
+	cpu_rcaches = __alloc_percpu(sizeof(*cpu_rcache), cache_line_size());
+	if (!cpu_rcaches)
+		return NULL;
+
+	for_each_possible_cpu(cpu) {
+		cpu_rcache = per_cpu_ptr(cpu_rcaches, cpu);
+
+		spin_lock_init(&cpu_rcache->lock);
+		cpu_rcache->loaded = iova_magazine_alloc(GFP_KERNEL);
+		cpu_rcache->prev = iova_magazine_alloc(GFP_KERNEL);
+		if (!cpu_rcache->loaded || !cpu_rcache->prev) {
+			iova_rcache_free_cpu_rcaches(cpu_rcaches);
+			return NULL;
+		}
+	}
+
+	return cpu_rcaches;
+}
+
+/* Populate a bucket for large ranges, after it has seen enough misses. */
+static void iova_rcache_enable_work_func(struct work_struct *work)
+{
+	struct iova_rcache *rcache = container_of(work, typeof(*rcache),
+						  enable_work);
+	struct iova_cpu_rcache __percpu *cpu_rcaches;
+
+	cpu_rcaches = iova_rcache_alloc_cpu_rcaches();
+	if (!cpu_rcaches) {
+		/* Try again after another round of misses */
+		atomic_set(&rcache->misses, 0);
+		return;
+	}
+
+	/* Pairs with smp_load_acquire() in the insert and get paths */
+	smp_store_release(&rcache->cpu_rcaches, cpu_rcaches);
+}
+
+int iova_domain_init_rcaches(struct iova_domain *iovad)
+{
+	int i, node, ret = -ENOMEM;
 
 	iovad->rcaches = kcalloc(IOVA_RANGE_CACHE_MAX_SIZE,
 				 sizeof(struct iova_rcache),
@@ -722,30 +839,35 @@ int iova_domain_init_rcaches(struct iova_domain *iovad)
 		return -ENOMEM;
 
 	for (i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; ++i) {
-		struct iova_cpu_rcache *cpu_rcache;
-		struct iova_rcache *rcache;
+		struct iova_rcache *rcache = &iovad->rcaches[i];
 
-		rcache = &iovad->rcaches[i];
-		spin_lock_init(&rcache->lock);
 		rcache->iovad = iovad;
 		INIT_DELAYED_WORK(&rcache->work, iova_depot_work_func);
-		rcache->cpu_rcaches = __alloc_percpu(sizeof(*cpu_rcache),
-						     cache_line_size());
-		if (!rcache->cpu_rcaches) {
-			ret = -ENOMEM;
+		INIT_WORK(&rcache->enable_work, iova_rcache_enable_work_func);
+	}
+
+	for (i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; ++i) {
+		struct iova_rcache *rcache = &iovad->rcaches[i];
+
+		rcache->depots = kcalloc(nr_node_ids, sizeof(*rcache->depots),
+					 GFP_KERNEL);
+		if (!rcache->depots)
 			goto out_err;
-		}
-		for_each_possible_cpu(cpu) {
-			cpu_rcache = per_cpu_ptr(rcache->cpu_rcaches, cpu);
-
-			spin_lock_init(&cpu_rcache->lock);
-			cpu_rcache->loaded = iova_magazine_alloc(GFP_KERNEL);
-			cpu_rcache->prev = iova_magazine_alloc(GFP_KERNEL);
-			if (!cpu_rcache->loaded || !cpu_rcache->prev) {
-				ret = -ENOMEM;
+		for_each_node(node) {
+			struct iova_depot *depot;
+
+			depot = kzalloc_node(sizeof(*depot), GFP_KERNEL, node);
+			if (!depot)
 				goto out_err;
-			}
+			spin_lock_init(&depot->lock);
+			rcache->depots[node] = depot;
 		}
+
+		if (i >= IOVA_RANGE_CACHE_DEFAULT_SIZE)
+			continue;
+		rcache->cpu_rcaches = iova_rcache_alloc_cpu_rcaches();
+		if (!rcache->cpu_rcaches)
+			goto out_err;
 	}
 
 	ret = cpuhp_state_add_instance_nocalls(CPUHP_IOMMU_IOVA_DEAD,
@@ -770,11 +892,16 @@ static bool __iova_rcache_insert(struct iova_domain *iovad,
 				 struct iova_rcache *rcache,
 				 unsigned long iova_pfn)
 {
+	struct iova_cpu_rcache __percpu *cpu_rcaches;
 	struct iova_cpu_rcache *cpu_rcache;
 	bool can_insert = false;
 	unsigned long flags;
 
-	cpu_rcache = raw_cpu_ptr(rcache->cpu_rcaches);
+	cpu_rcaches = smp_load_acquire(&rcache->cpu_rcaches);
+	if (!cpu_rcaches)
+		return false;
+
+	cpu_rcache = raw_cpu_ptr(cpu_rcaches);
 	spin_lock_irqsave(&cpu_rcache->lock, flags);
 
 	if (!iova_magazine_full(cpu_rcache->loaded)) {
@@ -786,9 +913,11 @@ static bool __iova_rcache_insert(struct iova_domain *iovad,
 		struct iova_magazine *new_mag = iova_magazine_alloc(GFP_ATOMIC);
 
 		if (new_mag) {
-			spin_lock(&rcache->lock);
-			iova_depot_push(rcache, cpu_rcache->loaded);
-			spin_unlock(&rcache->lock);
+			struct iova_depot *depot = rcache->depots[numa_node_id()];
+
+			spin_lock(&depot->lock);
+			iova_depot_push(depot, cpu_rcache->loaded);
+			spin_unlock(&depot->lock);
 			schedule_delayed_work(&rcache->work, IOVA_DEPOT_DELAY);
 
 			cpu_rcache->loaded = new_mag;
@@ -823,12 +952,20 @@ static bool iova_rcache_insert(struct iova_domain *iovad, unsigned long pfn,
 static unsigned long __iova_rcache_get(struct iova_rcache *rcache,
 				       unsigned long limit_pfn)
 {
+	struct iova_cpu_rcache __percpu *cpu_rcaches;
 	struct iova_cpu_rcache *cpu_rcache;
 	unsigned long iova_pfn = 0;
 	bool has_pfn = false;
 	unsigned long flags;
 
-	cpu_rcache = raw_cpu_ptr(rcache->cpu_rcaches);
+	cpu_rcaches = smp_load_acquire(&rcache->cpu_rcaches);
+	if (!cpu_rcaches) {
+		if (atomic_inc_return(&rcache->misses) == IOVA_RCACHE_ENABLE_MISSES)
+			schedule_work(&rcache->enable_work);
+		return 0;
+	}
+
+	cpu_rcache = raw_cpu_ptr(cpu_rcaches);
 	spin_lock_irqsave(&cpu_rcache->lock, flags);
 
 	if (!iova_magazine_empty(cpu_rcache->loaded)) {
@@ -837,13 +974,13 @@ static unsigned long __iova_rcache_get(struct iova_rcache *rcache,
 		swap(cpu_rcache->prev, cpu_rcache->loaded);
 		has_pfn = true;
 	} else {
-		spin_lock(&rcache->lock);
-		if (rcache->depot) {
+		struct iova_magazine *mag = iova_rcache_depot_pop(rcache);
+
+		if (mag) {
 			iova_magazine_free(cpu_rcache->loaded);
-			cpu_rcache->loaded = iova_depot_pop(rcache);
+			cpu_rcache->loaded = mag;
 			has_pfn = true;
 		}
-		spin_unlock(&rcache->lock);
 	}
 
 	if (has_pfn)
@@ -877,22 +1014,26 @@ static unsigned long iova_rcache_get(struct iova_domain *iovad,
 static void free_iova_rcaches(struct iova_domain *iovad)
 {
 	struct iova_rcache *rcache;
-	struct iova_cpu_rcache *cpu_rcache;
-	unsigned int cpu;
+	struct iova_depot *depot;
+	int node;
 
 	for (int i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; ++i) {
 		rcache = &iovad->rcaches[i];
-		if (!rcache->cpu_rcaches)
-			break;
-		for_each_possible_cpu(cpu) {
-			cpu_rcache = per_cpu_ptr(rcache->cpu_rcaches, cpu);
-			iova_magazine_free(cpu_rcache->loaded);
-			iova_magazine_free(cpu_rcache->prev);
-		}
-		free_percpu(rcache->cpu_rcaches);
+		cancel_work_sync(&rcache->enable_work);
 		cancel_delayed_work_sync(&rcache->work);
-		while (rcache->depot)
-			iova_magazine_free(iova_depot_pop(rcache));
+		if (rcache->cpu_rcaches)
+			iova_rcache_free_cpu_rcaches(rcache->cpu_rcaches);
+		if (!rcache->depots)
+			continue;
+		for_each_node(node) {
+			depot = rcache->depots[node];
+			if (!depot)
+				continue;
+			while (depot->head)
+				iova_magazine_free(iova_depot_pop(depot));
+			kfree(depot);
+		}
+		kfree(rcache->depots);
 	}
 
 	kfree(iovad->rcaches);
@@ -904,6 +1045,7 @@ static void free_iova_rcaches(struct iova_domain *iovad)
  */
 static void free_cpu_cached_iovas(unsigned int cpu, struct iova_domain *iovad)
 {
+	struct iova_cpu_rcache __percpu *cpu_rcaches;
 	struct iova_cpu_rcache *cpu_rcache;
 	struct iova_rcache *rcache;
 	unsigned long flags;
@@ -911,7 +1053,10 @@ static void free_cpu_cached_iovas(unsigned int cpu, struct iova_domain *iovad)
 
 	for (i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; ++i) {
 		rcache = &iovad->rcaches[i];
-		cpu_rcache = per_cpu_ptr(rcache->cpu_rcaches, cpu);
+		cpu_rcaches = smp_load_acquire(&rcache->cpu_rcaches);
+		if (!cpu_rcaches)
+			continue;
+		cpu_rcache = per_cpu_ptr(cpu_rcaches, cpu);
 		spin_lock_irqsave(&cpu_rcache->lock, flags);
 		iova_magazine_free_pfns(cpu_rcache->loaded, iovad);
 		iova_magazine_free_pfns(cpu_rcache->prev, iovad);
@@ -925,18 +1070,23 @@ static void free_cpu_cached_iovas(unsigned int cpu, struct iova_domain *iovad)
 static void free_global_cached_iovas(struct iova_domain *iovad)
 {
 	struct iova_rcache *rcache;
+	struct iova_depot *depot;
 	unsigned long flags;
+	int node;
 
 	for (int i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; ++i) {
 		rcache = &iovad->rcaches[i];
-		spin_lock_irqsave(&rcache->lock, flags);
-		while (rcache->depot) {
-			struct iova_magazine *mag = iova_depot_pop(rcache);
-
-			iova_magazine_free_pfns(mag, iovad);
-			iova_magazine_free(mag);
+		for_each_node(node) {
+			depot = rcache->depots[node];
+			spin_lock_irqsave(&depot->lock, flags);
+			while (depot->head) {
+				struct iova_magazine *mag = iova_depot_pop(depot);
+
+				iova_magazine_free_pfns(mag, iovad);
+				iova_magazine_free(mag);
+			}
+			spin_unlock_irqrestore(&depot->lock, flags);
 		}
-		spin_unlock_irqrestore(&rcache->lock, flags);
 	}
 }
 
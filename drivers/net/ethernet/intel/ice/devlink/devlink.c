@@ -1518,10 +1518,210 @@ static int ice_devlink_local_fwd_validate(struct devlink *devlink, u32 id,
 	return 0;
 }
 
+/**
+ * ice_devlink_tc_itr_rc_set - Set interrupt moderation of a ring container.
+ * @rc: ring container of the queue vector serving the queue.
+ * @usecs: fixed ITR in microseconds, 0 to return to adaptive moderation.
+ */
+static void ice_devlink_tc_itr_rc_set(struct ice_ring_container *rc, u16 usecs)
+{
+	if (!usecs) {
+		rc->itr_mode = ITR_DYNAMIC;
+		return;
+	}
+
+	rc->itr_mode = ITR_STATIC;
+	rc->itr_setting = usecs;
+	ice_write_itr(rc, usecs);
+}
+
+/**
+ * ice_devlink_tc_itr_apply - Set interrupt moderation of a traffic class.
+ * @vsi: VSI whose queues are configured.
+ * @tc: traffic class.
+ * @usecs: fixed ITR in microseconds, 0 to return to adaptive moderation.
+ *
+ * Only the queue vectors serving the queues of @tc are touched, so
+ * latency-critical traffic can be steered to a traffic class of its own and
+ * given a low fixed ITR while bulk traffic keeps adaptive moderation.
+ */
+static void ice_devlink_tc_itr_apply(struct ice_vsi *vsi, u8 tc, u16 usecs)
+{
+	struct ice_tc_info *tc_info = &vsi->tc_cfg.tc_info[tc];
+	u16 q;
+
+	for (q = tc_info->qoffset;
+	     q < tc_info->qoffset + tc_info->qcount_rx && q < vsi->num_rxq; q++)
+		if (vsi->rx_rings[q] && vsi->rx_rings[q]->q_vector)
+			ice_devlink_tc_itr_rc_set(&vsi->rx_rings[q]->q_vector->rx,
+						  usecs);
+
+	for (q = tc_info->qoffset;
+	     q < tc_info->qoffset + tc_info->qcount_tx && q < vsi->num_txq; q++)
+		if (vsi->tx_rings[q] && vsi->tx_rings[q]->q_vector)
+			ice_devlink_tc_itr_rc_set(&vsi->tx_rings[q]->q_vector->tx,
+						  usecs);
+}
+
+/**
+ * ice_devlink_tc_itr_get - Get tc_itr parameter.
+ * @devlink: Pointer to the devlink instance.
+ * @id: The parameter ID to get.
+ * @ctx: Context to store the parameter value.
+ *
+ * Reports the traffic classes of the main VSI whose queues use a fixed ITR,
+ * as a comma separated list of "tc:usecs".
+ *
+ * Return: Zero.
+ */
+static int ice_devlink_tc_itr_get(struct devlink *devlink, u32 id,
+				  struct devlink_param_gset_ctx *ctx)
+{
+	struct ice_pf *pf = devlink_priv(devlink);
+	size_t len = sizeof(ctx->val.vstr);
+	char *buf = ctx->val.vstr;
+	struct ice_q_vector *q_vector;
+	struct ice_tc_info *tc_info;
+	struct ice_vsi *vsi;
+	int off = 0;
+	u8 tc;
+
+	buf[0] = '\0';
+
+	rtnl_lock();
+	vsi = ice_get_main_vsi(pf);
+	if (!vsi)
+		goto out;
+
+	ice_for_each_traffic_class(tc) {
+		if (!(vsi->tc_cfg.ena_tc & BIT(tc)))
+			continue;
+
+		tc_info = &vsi->tc_cfg.tc_info[tc];
+		if (!tc_info->qcount_rx || tc_info->qoffset >= vsi->num_rxq)
+			continue;
+
+		q_vector = vsi->rx_rings[tc_info->qoffset]->q_vector;
+		if (!q_vector || ITR_IS_DYNAMIC(&q_vector->rx))
+			continue;
+
+		off += scnprintf(buf + off, len - off, "%s%u:%u",
+				 off ? "," : "", tc, q_vector->rx.itr_setting);
+	}
+out:
+	rtnl_unlock();
+
+	return 0;
+}
+
+/**
+ * ice_devlink_tc_itr_parse - Parse tc_itr parameter value.
+ * @str: value in the form "tc:usecs".
+ * @tc: parsed traffic class.
+ * @usecs: parsed ITR in microseconds.
+ *
+ * Return: Zero on success, -EINVAL if the value is malformed or out of range.
+ */
+static int ice_devlink_tc_itr_parse(const char *str, u8 *tc, u16 *usecs)
+{
+	unsigned int tc_val, usecs_val;
+
+	if (sscanf(str, "%u:%u", &tc_val, &usecs_val) != 2)
+		return -EINVAL;
+
+	if (tc_val >= ICE_MAX_TRAFFIC_CLASS || usecs_val > ICE_ITR_MAX)
+		return -EINVAL;
+
+	*tc = tc_val;
+	*usecs = usecs_val;
+
+	return 0;
+}
+
+/**
+ * ice_devlink_tc_itr_set - Set tc_itr parameter.
+ * @devlink: Pointer to the devlink instance.
+ * @id: The parameter ID to set.
+ * @ctx: Context to get the parameter value.
+ * @extack: Netlink extended ACK structure.
+ *
+ * Applies immediately, without a reset. The setting is kept across VSI
+ * rebuilds together with the rest of the interrupt moderation configuration.
+ *
+ * Return: Zero on success, negative value on error.
+ */
+static int ice_devlink_tc_itr_set(struct devlink *devlink, u32 id,
+				  struct devlink_param_gset_ctx *ctx,
+				  struct netlink_ext_ack *extack)
+{
+	struct ice_pf *pf = devlink_priv(devlink);
+	struct ice_vsi *vsi;
+	u16 usecs;
+	int err;
+	u8 tc;
+
+	err = ice_devlink_tc_itr_parse(ctx->val.vstr, &tc, &usecs);
+	if (err)
+		return err;
+
+	if (ice_is_reset_in_progress(pf->state)) {
+		NL_SET_ERR_MSG_MOD(extack, "Device is resetting");
+		return -EBUSY;
+	}
+
+	rtnl_lock();
+	vsi = ice_get_main_vsi(pf);
+	if (!vsi) {
+		err = -ENODEV;
+		goto out;
+	}
+
+	if (!(vsi->tc_cfg.ena_tc & BIT(tc))) {
+		NL_SET_ERR_MSG_MOD(extack, "Traffic class is not enabled");
+		err = -EINVAL;
+		goto out;
+	}
+
+	ice_devlink_tc_itr_apply(vsi, tc, usecs);
+out:
+	rtnl_unlock();
+
+	return err;
+}
+
+/**
+ * ice_devlink_tc_itr_validate - Validate passed tc_itr parameter value.
+ * @devlink: Unused pointer to devlink instance.
+ * @id: The parameter ID to validate.
+ * @val: Value to validate.
+ * @extack: Netlink extended ACK structure.
+ *
+ * Supported values are "tc:usecs", where usecs of 0 returns the traffic class
+ * to adaptive interrupt moderation.
+ *
+ * Return: Zero when passed parameter value is supported. Negative value on
+ * error.
+ */
+static int ice_devlink_tc_itr_validate(struct devlink *devlink, u32 id,
+				       union devlink_param_value val,
+				       struct netlink_ext_ack *extack)
+{
+	u16 usecs;
+	u8 tc;
+
+	if (ice_devlink_tc_itr_parse(val.vstr, &tc, &usecs)) {
+		NL_SET_ERR_MSG_MOD(extack, "Expected \"tc:usecs\" with tc below 8 and usecs up to 8160");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 enum ice_param_id {
 	ICE_DEVLINK_PARAM_ID_BASE = DEVLINK_PARAM_GENERIC_ID_MAX,
 	ICE_DEVLINK_PARAM_ID_TX_SCHED_LAYERS,
 	ICE_DEVLINK_PARAM_ID_LOCAL_FWD,
+	ICE_DEVLINK_PARAM_ID_TC_ITR,
 };
 
 static const struct devlink_param ice_dvl_rdma_params[] = {
@@ -1535,6 +1735,15 @@ static const struct devlink_param ice_dvl_rdma_params[] = {
 			      ice_devlink_enable_iw_validate),
 };
 
+static const struct devlink_param ice_dvl_coalesce_params[] = {
+	DEVLINK_PARAM_DRIVER(ICE_DEVLINK_PARAM_ID_TC_ITR,
+			     "tc_itr", DEVLINK_PARAM_TYPE_STRING,
+			     BIT(DEVLINK_PARAM_CMODE_RUNTIME),
+			     ice_devlink_tc_itr_get,
+			     ice_devlink_tc_itr_set,
+			     ice_devlink_tc_itr_validate),
+};
+
 static const struct devlink_param ice_dvl_sched_params[] = {
 	DEVLINK_PARAM_DRIVER(ICE_DEVLINK_PARAM_ID_TX_SCHED_LAYERS,
 			     "tx_scheduling_layers",
@@ -1644,10 +1853,26 @@ int ice_devlink_register_params(struct ice_pf *pf)
 	if (status)
 		return status;
 
-	if (hw->func_caps.common_cap.tx_sched_topo_comp_mode_en)
+	status = devl_params_register(devlink, ice_dvl_coalesce_params,
+				      ARRAY_SIZE(ice_dvl_coalesce_params));
+	if (status)
+		goto err_coalesce_params;
+
+	if (hw->func_caps.common_cap.tx_sched_topo_comp_mode_en) {
 		status = devl_params_register(devlink, ice_dvl_sched_params,
 					      ARRAY_SIZE(ice_dvl_sched_params));
+		if (status)
+			goto err_sched_params;
+	}
 
+	return 0;
+
+err_sched_params:
+	devl_params_unregister(devlink, ice_dvl_coalesce_params,
+			       ARRAY_SIZE(ice_dvl_coalesce_params));
+err_coalesce_params:
+	devl_params_unregister(devlink, ice_dvl_rdma_params,
+			       ARRAY_SIZE(ice_dvl_rdma_params));
 	return status;
 }
 
@@ -1658,6 +1883,8 @@ void ice_devlink_unregister_params(struct ice_pf *pf)
 
 	devl_params_unregister(devlink, ice_dvl_rdma_params,
 			       ARRAY_SIZE(ice_dvl_rdma_params));
+	devl_params_unregister(devlink, ice_dvl_coalesce_params,
+			       ARRAY_SIZE(ice_dvl_coalesce_params));
 
 	if (hw->func_caps.common_cap.tx_sched_topo_comp_mode_en)
 		devl_params_unregister(devlink, ice_dvl_sched_params,
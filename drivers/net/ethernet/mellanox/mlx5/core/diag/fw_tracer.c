@@ -29,11 +29,19 @@
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
+#include <linux/debugfs.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
 #define CREATE_TRACE_POINTS
 #include "lib/eq.h"
 #include "fw_tracer.h"
 #include "fw_tracer_tracepoint.h"
 
+static unsigned int fw_tracer_raw_pages;
+module_param(fw_tracer_raw_pages, uint, 0444);
+MODULE_PARM_DESC(fw_tracer_raw_pages,
+		 "Export raw firmware trace blocks through a ring of this many pages instead of parsing them (0 = parse)");
+
 static int mlx5_query_mtrc_caps(struct mlx5_fw_tracer *tracer)
 {
 	u32 *string_db_base_address_out = tracer->str_db.base_address_out;
@@ -688,6 +696,121 @@ static int mlx5_tracer_handle_trace(struct mlx5_fw_tracer *tracer,
 	return 0;
 }
 
+static void mlx5_fw_tracer_raw_free(struct kref *ref)
+{
+	struct mlx5_fw_tracer_raw *raw = container_of(ref, struct mlx5_fw_tracer_raw, ref);
+
+	vfree(raw->hdr);
+	kfree(raw);
+}
+
+static void mlx5_fw_tracer_raw_vm_open(struct vm_area_struct *vma)
+{
+	struct mlx5_fw_tracer_raw *raw = vma->vm_private_data;
+
+	kref_get(&raw->ref);
+}
+
+static void mlx5_fw_tracer_raw_vm_close(struct vm_area_struct *vma)
+{
+	struct mlx5_fw_tracer_raw *raw = vma->vm_private_data;
+
+	kref_put(&raw->ref, mlx5_fw_tracer_raw_free);
+}
+
+static const struct vm_operations_struct mlx5_fw_tracer_raw_vm_ops = {
+	.open = mlx5_fw_tracer_raw_vm_open,
+	.close = mlx5_fw_tracer_raw_vm_close,
+};
+
+static int mlx5_fw_tracer_raw_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct dentry *dentry = file->f_path.dentry;
+	struct mlx5_fw_tracer_raw *raw;
+	int err;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vm_flags_clear(vma, VM_MAYWRITE);
+
+	/* The file is created unsafe as the proxy fops don't forward mmap */
+	err = debugfs_file_get(dentry);
+	if (err)
+		return err;
+
+	raw = file->private_data;
+	err = remap_vmalloc_range(vma, raw->hdr, vma->vm_pgoff);
+	if (!err) {
+		/* The mapping may outlive the tracer */
+		kref_get(&raw->ref);
+		vma->vm_private_data = raw;
+		vma->vm_ops = &mlx5_fw_tracer_raw_vm_ops;
+	}
+
+	debugfs_file_put(dentry);
+	return err;
+}
+
+static const struct file_operations mlx5_fw_tracer_raw_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.mmap = mlx5_fw_tracer_raw_mmap,
+};
+
+static void mlx5_fw_tracer_raw_create(struct mlx5_fw_tracer *tracer)
+{
+	struct mlx5_core_dev *dev = tracer->dev;
+	struct mlx5_fw_tracer_raw *raw;
+
+	if (!fw_tracer_raw_pages)
+		return;
+
+	raw = kzalloc(sizeof(*raw), GFP_KERNEL);
+	if (!raw)
+		goto err;
+
+	raw->hdr = vmalloc_user((size_t)(fw_tracer_raw_pages + 1) * PAGE_SIZE);
+	if (!raw->hdr) {
+		kfree(raw);
+		goto err;
+	}
+
+	kref_init(&raw->ref);
+	raw->blocks = (void *)raw->hdr + PAGE_SIZE;
+	raw->nr_blocks = fw_tracer_raw_pages * (PAGE_SIZE / TRACER_BLOCK_SIZE_BYTE);
+	raw->hdr->block_size = TRACER_BLOCK_SIZE_BYTE;
+	raw->hdr->nr_blocks = raw->nr_blocks;
+	raw->dentry = debugfs_create_file_unsafe("fw_tracer_raw", 0400,
+						 mlx5_debugfs_get_dev_root(dev), raw,
+						 &mlx5_fw_tracer_raw_fops);
+	tracer->raw = raw;
+	return;
+
+err:
+	mlx5_core_warn(dev, "FWTracer: Failed to allocate raw ring, parsing traces\n");
+}
+
+static void mlx5_fw_tracer_raw_destroy(struct mlx5_fw_tracer *tracer)
+{
+	struct mlx5_fw_tracer_raw *raw = tracer->raw;
+
+	if (!raw)
+		return;
+
+	debugfs_remove(raw->dentry);
+	tracer->raw = NULL;
+	kref_put(&raw->ref, mlx5_fw_tracer_raw_free);
+}
+
+static void mlx5_fw_tracer_raw_push(struct mlx5_fw_tracer_raw *raw, const u64 *block)
+{
+	u64 head = raw->hdr->head;
+
+	memcpy(raw->blocks + (head % raw->nr_blocks) * TRACER_BLOCK_SIZE_BYTE, block,
+	       TRACER_BLOCK_SIZE_BYTE);
+	smp_store_release(&raw->hdr->head, head + 1);
+}
+
 static void mlx5_fw_tracer_handle_traces(struct work_struct *work)
 {
 	struct mlx5_fw_tracer *tracer =
@@ -703,7 +826,8 @@ static void mlx5_fw_tracer_handle_traces(struct work_struct *work)
 	if (!tracer->owner)
 		return;
 
-	if (unlikely(!tracer->str_db.loaded))
+	/* Raw blocks are formatted offline, the strings are not needed */
+	if (unlikely(!tracer->str_db.loaded && !tracer->raw))
 		goto arm;
 
 	block_count = tracer->buff.size / TRACER_BLOCK_SIZE_BYTE;
@@ -739,6 +863,9 @@ static void mlx5_fw_tracer_handle_traces(struct work_struct *work)
 			 */
 			if (tracer->last_timestamp != last_block_timestamp) {
 				mlx5_core_warn(dev, "FWTracer: Events were lost\n");
+				if (tracer->raw)
+					WRITE_ONCE(tracer->raw->hdr->lost,
+						   tracer->raw->hdr->lost + 1);
 				tracer->last_timestamp = block_timestamp;
 				tracer->buff.consumer_index =
 					(tracer->buff.consumer_index + 1) & (block_count - 1);
@@ -746,10 +873,14 @@ static void mlx5_fw_tracer_handle_traces(struct work_struct *work)
 			}
 		}
 
-		/* Parse events */
-		for (i = 0; i < TRACES_PER_BLOCK ; i++) {
-			poll_trace(tracer, &tracer_event, &tmp_trace_block[i]);
-			mlx5_tracer_handle_trace(tracer, &tracer_event);
+		if (tracer->raw) {
+			mlx5_fw_tracer_raw_push(tracer->raw, tmp_trace_block);
+		} else {
+			/* Parse events */
+			for (i = 0; i < TRACES_PER_BLOCK ; i++) {
+				poll_trace(tracer, &tracer_event, &tmp_trace_block[i]);
+				mlx5_tracer_handle_trace(tracer, &tracer_event);
+			}
 		}
 
 		tracer->buff.consumer_index =
@@ -991,6 +1122,7 @@ struct mlx5_fw_tracer *mlx5_fw_tracer_create(struct mlx5_core_dev *dev)
 	}
 
 	mlx5_fw_tracer_init_saved_traces_array(tracer);
+	mlx5_fw_tracer_raw_create(tracer);
 	mlx5_core_dbg(dev, "FWTracer: Tracer created\n");
 
 	return tracer;
@@ -1098,6 +1230,7 @@ void mlx5_fw_tracer_destroy(struct mlx5_fw_tracer *tracer)
 	mlx5_core_dbg(tracer->dev, "FWTracer: Destroy\n");
 
 	cancel_work_sync(&tracer->read_fw_strings_work);
+	mlx5_fw_tracer_raw_destroy(tracer);
 	mlx5_fw_tracer_clean_ready_list(tracer);
 	mlx5_fw_tracer_clean_print_hash(tracer);
 	mlx5_fw_tracer_clean_saved_traces_array(tracer);
@@ -56,6 +56,28 @@
 #define MASK_52_7 (0x1FFFFFFFFFFF80)
 #define MASK_6_0  (0x7F)
 
+/* Raw mode ring, exported read-only through the "fw_tracer_raw" debugfs
+ * file. The first page holds struct mlx5_fw_tracer_raw_hdr, followed by
+ * nr_blocks trace blocks of block_size bytes as written by the firmware.
+ * Block n is stored in slot n % nr_blocks and head is the number of blocks
+ * produced; it is updated with release semantics after the block is copied.
+ * Older blocks are overwritten, readers re-check head after copying a slot.
+ */
+struct mlx5_fw_tracer_raw_hdr {
+	u32 block_size;
+	u32 nr_blocks;
+	u64 head;
+	u64 lost;
+};
+
+struct mlx5_fw_tracer_raw {
+	struct kref ref;
+	struct mlx5_fw_tracer_raw_hdr *hdr;
+	void *blocks;
+	u32 nr_blocks;
+	struct dentry *dentry;
+};
+
 struct mlx5_fw_trace_data {
 	u64 timestamp;
 	bool lost;
@@ -112,6 +134,8 @@ struct mlx5_fw_tracer {
 	struct work_struct update_db_work;
 	struct mutex state_lock; /* Synchronize update work with reload flows */
 	unsigned long state;
+	/* Copy blocks to userspace instead of parsing them */
+	struct mlx5_fw_tracer_raw *raw;
 };
 
 struct tracer_string_format {
@@ -4,15 +4,35 @@
 #ifndef __MLX5_EN_TC_CT_FS_H__
 #define __MLX5_EN_TC_CT_FS_H__
 
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+
+struct mlx5_ct_fs;
+struct mlx5_ct_fs_rule;
+
+typedef int (*mlx5_ct_fs_insert_fn)(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_rule *fs_rule,
+				    struct mlx5_flow_spec *spec, struct mlx5_flow_attr *attr);
+
 struct mlx5_ct_fs {
 	const struct net_device *netdev;
 	struct mlx5_core_dev *dev;
 
+	/* Deferred rule insertion, see ct_fs_batch.c */
+	mlx5_ct_fs_insert_fn batch_insert;
+	struct mutex batch_lock; /* Guards batch_pending and rules' pending state */
+	struct list_head batch_pending;
+	struct work_struct batch_work;
+
 	/* private data */
 	void *priv_data[];
 };
 
 struct mlx5_ct_fs_rule {
+	/* Linked on mlx5_ct_fs::batch_pending until the rule reaches steering */
+	struct list_head pending;
+	struct mlx5_flow_spec *spec;
+	struct mlx5_flow_attr *attr;
 };
 
 struct mlx5_ct_fs_ops {
@@ -36,6 +56,14 @@ static inline void *mlx5_ct_fs_priv(struct mlx5_ct_fs *fs)
 	return &fs->priv_data;
 }
 
+void mlx5_ct_fs_batch_init(struct mlx5_ct_fs *fs, mlx5_ct_fs_insert_fn insert);
+void mlx5_ct_fs_batch_cleanup(struct mlx5_ct_fs *fs);
+int mlx5_ct_fs_batch_add(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_rule *fs_rule,
+			 struct mlx5_flow_spec *spec, struct mlx5_flow_attr *attr);
+bool mlx5_ct_fs_batch_del(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_rule *fs_rule);
+bool mlx5_ct_fs_batch_update(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_rule *fs_rule,
+			     struct mlx5_flow_spec *spec, struct mlx5_flow_attr *attr);
+
 struct mlx5_ct_fs_ops *mlx5_ct_fs_dmfs_ops_get(void);
 
 #if IS_ENABLED(CONFIG_MLX5_SW_STEERING)
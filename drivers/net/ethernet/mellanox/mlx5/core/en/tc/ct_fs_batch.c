@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-2.0 OR Linux-OpenIB
+
+/* Deferred insertion of CT offload rules.
+ *
+ * Offloading a connection means at least one steering update per direction,
+ * and connections arrive in bursts. With ct_batch_size set, ct_rule_add only
+ * queues the rule and a worker drains the queue in batches, so the callers
+ * (the flow table offload work) are no longer serialised on steering. A rule
+ * that is deleted or updated before it has been inserted never reaches, or
+ * is inserted once with its final contents into, steering, which is the
+ * common case for short lived connections.
+ *
+ * The rule is published to the caller before it reaches steering, so until
+ * then its packets keep going through software and its counter stays idle;
+ * a failed deferred insertion leaves the connection unoffloaded.
+ */
+
+#include <linux/moduleparam.h>
+
+#include "en_tc.h"
+#include "en/tc/ct_fs.h"
+
+static unsigned int ct_batch_size;
+module_param(ct_batch_size, uint, 0444);
+MODULE_PARM_DESC(ct_batch_size,
+		 "Insert CT offload rules from a worker, up to this many per run (0 = insert synchronously)");
+
+#define ct_dbg(fmt, args...)\
+	netdev_dbg(fs->netdev, "ct_fs_batch debug: " fmt "\n", ##args)
+
+static void mlx5_ct_fs_batch_work(struct work_struct *work)
+{
+	struct mlx5_ct_fs *fs = container_of(work, struct mlx5_ct_fs, batch_work);
+	unsigned int budget = ct_batch_size;
+	struct mlx5_ct_fs_rule *fs_rule;
+	int err;
+
+	while (budget--) {
+		/* The lock is held across the insertion so that del and update
+		 * observe a rule either still pending or fully inserted.
+		 */
+		mutex_lock(&fs->batch_lock);
+		fs_rule = list_first_entry_or_null(&fs->batch_pending,
+						   struct mlx5_ct_fs_rule, pending);
+		if (!fs_rule) {
+			mutex_unlock(&fs->batch_lock);
+			return;
+		}
+
+		list_del_init(&fs_rule->pending);
+		err = fs->batch_insert(fs, fs_rule, fs_rule->spec, fs_rule->attr);
+		if (err)
+			ct_dbg("Failed to insert deferred ct rule, err %d", err);
+
+		kvfree(fs_rule->spec);
+		fs_rule->spec = NULL;
+		mutex_unlock(&fs->batch_lock);
+	}
+
+	mutex_lock(&fs->batch_lock);
+	if (!list_empty(&fs->batch_pending))
+		queue_work(system_unbound_wq, &fs->batch_work);
+	mutex_unlock(&fs->batch_lock);
+}
+
+void mlx5_ct_fs_batch_init(struct mlx5_ct_fs *fs, mlx5_ct_fs_insert_fn insert)
+{
+	fs->batch_insert = insert;
+	mutex_init(&fs->batch_lock);
+	INIT_LIST_HEAD(&fs->batch_pending);
+	INIT_WORK(&fs->batch_work, mlx5_ct_fs_batch_work);
+}
+
+void mlx5_ct_fs_batch_cleanup(struct mlx5_ct_fs *fs)
+{
+	cancel_work_sync(&fs->batch_work);
+	/* All rules are deleted before the fs is destroyed */
+	WARN_ON(!list_empty(&fs->batch_pending));
+	mutex_destroy(&fs->batch_lock);
+}
+
+int mlx5_ct_fs_batch_add(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_rule *fs_rule,
+			 struct mlx5_flow_spec *spec, struct mlx5_flow_attr *attr)
+{
+	INIT_LIST_HEAD(&fs_rule->pending);
+
+	if (!ct_batch_size)
+		return fs->batch_insert(fs, fs_rule, spec, attr);
+
+	/* The caller's spec is on its stack or freed on return, attr lives
+	 * until the rule is deleted or updated.
+	 */
+	fs_rule->spec = kvmalloc(sizeof(*spec), GFP_KERNEL);
+	if (!fs_rule->spec)
+		return -ENOMEM;
+
+	memcpy(fs_rule->spec, spec, sizeof(*spec));
+	fs_rule->attr = attr;
+
+	mutex_lock(&fs->batch_lock);
+	list_add_tail(&fs_rule->pending, &fs->batch_pending);
+	mutex_unlock(&fs->batch_lock);
+
+	queue_work(system_unbound_wq, &fs->batch_work);
+
+	return 0;
+}
+
+/* Returns true if the rule was still pending and is now forgotten, false if
+ * the backend has to remove it from steering.
+ */
+bool mlx5_ct_fs_batch_del(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_rule *fs_rule)
+{
+	bool pending;
+
+	mutex_lock(&fs->batch_lock);
+	pending = !list_empty(&fs_rule->pending);
+	if (pending) {
+		list_del_init(&fs_rule->pending);
+		kvfree(fs_rule->spec);
+		fs_rule->spec = NULL;
+	}
+	mutex_unlock(&fs->batch_lock);
+
+	return pending;
+}
+
+/* Returns true if the rule was still pending and will be inserted with the
+ * new spec and attr, false if the backend has to update steering.
+ */
+bool mlx5_ct_fs_batch_update(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_rule *fs_rule,
+			     struct mlx5_flow_spec *spec, struct mlx5_flow_attr *attr)
+{
+	bool pending;
+
+	mutex_lock(&fs->batch_lock);
+	pending = !list_empty(&fs_rule->pending);
+	if (pending) {
+		memcpy(fs_rule->spec, spec, sizeof(*spec));
+		fs_rule->attr = attr;
+	}
+	mutex_unlock(&fs->batch_lock);
+
+	return pending;
+}
@@ -14,23 +14,47 @@ struct mlx5_ct_fs_dmfs_rule {
 	struct mlx5_flow_attr *attr;
 };
 
+static int
+mlx5_ct_fs_dmfs_ct_rule_insert(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_rule *fs_rule,
+			       struct mlx5_flow_spec *spec, struct mlx5_flow_attr *attr)
+{
+	struct mlx5_ct_fs_dmfs_rule *dmfs_rule = container_of(fs_rule,
+							      struct mlx5_ct_fs_dmfs_rule,
+							      fs_rule);
+	struct mlx5e_priv *priv = netdev_priv(fs->netdev);
+	struct mlx5_flow_handle *rule;
+
+	rule = mlx5_tc_rule_insert(priv, spec, attr);
+	if (IS_ERR(rule)) {
+		ct_dbg("Failed to add ct entry fs rule");
+		return PTR_ERR(rule);
+	}
+
+	dmfs_rule->rule = rule;
+	dmfs_rule->attr = attr;
+
+	return 0;
+}
+
 static int
 mlx5_ct_fs_dmfs_init(struct mlx5_ct_fs *fs, struct mlx5_flow_table *ct,
 		     struct mlx5_flow_table *ct_nat, struct mlx5_flow_table *post_ct)
 {
+	mlx5_ct_fs_batch_init(fs, mlx5_ct_fs_dmfs_ct_rule_insert);
+
 	return 0;
 }
 
 static void
 mlx5_ct_fs_dmfs_destroy(struct mlx5_ct_fs *fs)
 {
+	mlx5_ct_fs_batch_cleanup(fs);
 }
 
 static struct mlx5_ct_fs_rule *
 mlx5_ct_fs_dmfs_ct_rule_add(struct mlx5_ct_fs *fs, struct mlx5_flow_spec *spec,
 			    struct mlx5_flow_attr *attr, struct flow_rule *flow_rule)
 {
-	struct mlx5e_priv *priv = netdev_priv(fs->netdev);
 	struct mlx5_ct_fs_dmfs_rule *dmfs_rule;
 	int err;
 
@@ -38,14 +62,9 @@ mlx5_ct_fs_dmfs_ct_rule_add(struct mlx5_ct_fs *fs, struct mlx5_flow_spec *spec,
 	if (!dmfs_rule)
 		return ERR_PTR(-ENOMEM);
 
-	dmfs_rule->rule = mlx5_tc_rule_insert(priv, spec, attr);
-	if (IS_ERR(dmfs_rule->rule)) {
-		err = PTR_ERR(dmfs_rule->rule);
-		ct_dbg("Failed to add ct entry fs rule");
+	err = mlx5_ct_fs_batch_add(fs, &dmfs_rule->fs_rule, spec, attr);
+	if (err)
 		goto err_insert;
-	}
-
-	dmfs_rule->attr = attr;
 
 	return &dmfs_rule->fs_rule;
 
@@ -61,7 +80,9 @@ mlx5_ct_fs_dmfs_ct_rule_del(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_rule *fs_ru
 							      struct mlx5_ct_fs_dmfs_rule,
 							      fs_rule);
 
-	mlx5_tc_rule_delete(netdev_priv(fs->netdev), dmfs_rule->rule, dmfs_rule->attr);
+	/* A failed deferred insertion leaves no steering rule behind */
+	if (!mlx5_ct_fs_batch_del(fs, fs_rule) && dmfs_rule->rule)
+		mlx5_tc_rule_delete(netdev_priv(fs->netdev), dmfs_rule->rule, dmfs_rule->attr);
 	kfree(dmfs_rule);
 }
 
@@ -74,6 +95,12 @@ static int mlx5_ct_fs_dmfs_ct_rule_update(struct mlx5_ct_fs *fs, struct mlx5_ct_
 	struct mlx5e_priv *priv = netdev_priv(fs->netdev);
 	struct mlx5_flow_handle *rule;
 
+	if (mlx5_ct_fs_batch_update(fs, fs_rule, spec, attr))
+		return 0;
+
+	if (!dmfs_rule->rule)
+		return mlx5_ct_fs_dmfs_ct_rule_insert(fs, fs_rule, spec, attr);
+
 	rule = mlx5_tc_rule_insert(priv, spec, attr);
 	if (IS_ERR(rule))
 		return PTR_ERR(rule);
@@ -179,6 +179,10 @@ mlx5_ct_fs_smfs_matcher_put(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_smfs_matche
 	mutex_unlock(&fs_smfs->lock);
 }
 
+static int
+mlx5_ct_fs_smfs_ct_rule_insert(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_rule *fs_rule,
+			       struct mlx5_flow_spec *spec, struct mlx5_flow_attr *attr);
+
 static int
 mlx5_ct_fs_smfs_init(struct mlx5_ct_fs *fs, struct mlx5_flow_table *ct,
 		     struct mlx5_flow_table *ct_nat, struct mlx5_flow_table *post_ct)
@@ -208,6 +212,7 @@ mlx5_ct_fs_smfs_init(struct mlx5_ct_fs *fs, struct mlx5_flow_table *ct,
 	mutex_init(&fs_smfs->lock);
 	INIT_LIST_HEAD(&fs_smfs->matchers.used);
 	INIT_LIST_HEAD(&fs_smfs->matchers_nat.used);
+	mlx5_ct_fs_batch_init(fs, mlx5_ct_fs_smfs_ct_rule_insert);
 
 	return 0;
 }
@@ -217,6 +222,7 @@ mlx5_ct_fs_smfs_destroy(struct mlx5_ct_fs *fs)
 {
 	struct mlx5_ct_fs_smfs *fs_smfs = mlx5_ct_fs_priv(fs);
 
+	mlx5_ct_fs_batch_cleanup(fs);
 	mlx5_smfs_action_destroy(fs_smfs->fwd_action);
 }
 
@@ -292,32 +298,26 @@ mlx5_ct_fs_smfs_ct_validate_flow_rule(struct mlx5_ct_fs *fs, struct flow_rule *f
 	return true;
 }
 
-static struct mlx5_ct_fs_rule *
-mlx5_ct_fs_smfs_ct_rule_add(struct mlx5_ct_fs *fs, struct mlx5_flow_spec *spec,
-			    struct mlx5_flow_attr *attr, struct flow_rule *flow_rule)
+static int
+mlx5_ct_fs_smfs_ct_rule_insert(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_rule *fs_rule,
+			       struct mlx5_flow_spec *spec, struct mlx5_flow_attr *attr)
 {
+	struct mlx5_ct_fs_smfs_rule *smfs_rule = container_of(fs_rule,
+							      struct mlx5_ct_fs_smfs_rule,
+							      fs_rule);
 	struct mlx5_ct_fs_smfs *fs_smfs = mlx5_ct_fs_priv(fs);
 	struct mlx5_ct_fs_smfs_matcher *smfs_matcher;
-	struct mlx5_ct_fs_smfs_rule *smfs_rule;
 	struct mlx5dr_action *actions[5];
+	struct mlx5dr_action *count_action;
 	struct mlx5dr_rule *rule;
 	int num_actions = 0, err;
 	bool nat, tcp, ipv4, gre;
 
-	if (!mlx5_ct_fs_smfs_ct_validate_flow_rule(fs, flow_rule))
-		return ERR_PTR(-EOPNOTSUPP);
-
-	smfs_rule = kzalloc(sizeof(*smfs_rule), GFP_KERNEL);
-	if (!smfs_rule)
-		return ERR_PTR(-ENOMEM);
-
-	smfs_rule->count_action = mlx5_smfs_action_create_flow_counter(mlx5_fc_id(attr->counter));
-	if (!smfs_rule->count_action) {
-		err = -EINVAL;
-		goto err_count;
-	}
+	count_action = mlx5_smfs_action_create_flow_counter(mlx5_fc_id(attr->counter));
+	if (!count_action)
+		return -EINVAL;
 
-	actions[num_actions++] = smfs_rule->count_action;
+	actions[num_actions++] = count_action;
 	actions[num_actions++] = attr->modify_hdr->fs_dr_action.dr_action;
 	actions[num_actions++] = fs_smfs->fwd_action;
 
@@ -342,17 +342,39 @@ mlx5_ct_fs_smfs_ct_rule_add(struct mlx5_ct_fs *fs, struct mlx5_flow_spec *spec,
 	}
 
 	smfs_rule->rule = rule;
+	smfs_rule->count_action = count_action;
 	smfs_rule->smfs_matcher = smfs_matcher;
 
-	return &smfs_rule->fs_rule;
+	return 0;
 
 err_create:
 	mlx5_ct_fs_smfs_matcher_put(fs, smfs_matcher);
 err_matcher:
-	mlx5_smfs_action_destroy(smfs_rule->count_action);
-err_count:
-	kfree(smfs_rule);
-	return ERR_PTR(err);
+	mlx5_smfs_action_destroy(count_action);
+	return err;
+}
+
+static struct mlx5_ct_fs_rule *
+mlx5_ct_fs_smfs_ct_rule_add(struct mlx5_ct_fs *fs, struct mlx5_flow_spec *spec,
+			    struct mlx5_flow_attr *attr, struct flow_rule *flow_rule)
+{
+	struct mlx5_ct_fs_smfs_rule *smfs_rule;
+	int err;
+
+	if (!mlx5_ct_fs_smfs_ct_validate_flow_rule(fs, flow_rule))
+		return ERR_PTR(-EOPNOTSUPP);
+
+	smfs_rule = kzalloc(sizeof(*smfs_rule), GFP_KERNEL);
+	if (!smfs_rule)
+		return ERR_PTR(-ENOMEM);
+
+	err = mlx5_ct_fs_batch_add(fs, &smfs_rule->fs_rule, spec, attr);
+	if (err) {
+		kfree(smfs_rule);
+		return ERR_PTR(err);
+	}
+
+	return &smfs_rule->fs_rule;
 }
 
 static void
@@ -362,9 +384,12 @@ mlx5_ct_fs_smfs_ct_rule_del(struct mlx5_ct_fs *fs, struct mlx5_ct_fs_rule *fs_ru
 							      struct mlx5_ct_fs_smfs_rule,
 							      fs_rule);
 
-	mlx5_smfs_rule_destroy(smfs_rule->rule);
-	mlx5_ct_fs_smfs_matcher_put(fs, smfs_rule->smfs_matcher);
-	mlx5_smfs_action_destroy(smfs_rule->count_action);
+	/* A failed deferred insertion leaves no steering rule behind */
+	if (!mlx5_ct_fs_batch_del(fs, fs_rule) && smfs_rule->rule) {
+		mlx5_smfs_rule_destroy(smfs_rule->rule);
+		mlx5_ct_fs_smfs_matcher_put(fs, smfs_rule->smfs_matcher);
+		mlx5_smfs_action_destroy(smfs_rule->count_action);
+	}
 	kfree(smfs_rule);
 }
 
@@ -378,6 +403,12 @@ static int mlx5_ct_fs_smfs_ct_rule_update(struct mlx5_ct_fs *fs, struct mlx5_ct_
 	struct mlx5dr_action *actions[3];  /* We only need to create 3 actions, see below. */
 	struct mlx5dr_rule *rule;
 
+	if (mlx5_ct_fs_batch_update(fs, fs_rule, spec, attr))
+		return 0;
+
+	if (!smfs_rule->rule)
+		return mlx5_ct_fs_smfs_ct_rule_insert(fs, fs_rule, spec, attr);
+
 	actions[0] = smfs_rule->count_action;
 	actions[1] = attr->modify_hdr->fs_dr_action.dr_action;
 	actions[2] = fs_smfs->fwd_action;
@@ -270,7 +270,10 @@ struct sk_buff *mlx5e_xsk_skb_from_cqe_mpwrq_linear(struct mlx5e_rq *rq,
 	/* mxbuf->rq is set on allocation, but cqe is per-packet so set it here */
 	mxbuf->cqe = cqe;
 	xsk_buff_set_size(&mxbuf->xdp, cqe_bcnt);
-	xsk_buff_dma_sync_for_cpu(&mxbuf->xdp);
+	/* Only the packet itself was written, which for small frames is a
+	 * fraction of the chunk; don't sync the rest of it.
+	 */
+	xsk_buff_dma_sync_for_cpu_len(&mxbuf->xdp, cqe_bcnt);
 	net_prefetch(mxbuf->xdp.data);
 
 	/* Possible flows:
@@ -319,7 +322,10 @@ struct sk_buff *mlx5e_xsk_skb_from_cqe_linear(struct mlx5e_rq *rq,
 	/* mxbuf->rq is set on allocation, but cqe is per-packet so set it here */
 	mxbuf->cqe = cqe;
 	xsk_buff_set_size(&mxbuf->xdp, cqe_bcnt);
-	xsk_buff_dma_sync_for_cpu(&mxbuf->xdp);
+	/* Only the packet itself was written, which for small frames is a
+	 * fraction of the chunk; don't sync the rest of it.
+	 */
+	xsk_buff_dma_sync_for_cpu_len(&mxbuf->xdp, cqe_bcnt);
 	net_prefetch(mxbuf->xdp.data);
 
 	prog = rcu_dereference(rq->xdp_prog);
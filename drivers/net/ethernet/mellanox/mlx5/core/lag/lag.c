@@ -48,6 +48,11 @@ enum {
 	MLX5_LAG_EGRESS_PORT_2,
 };
 
+static unsigned int lag_rebalance_ms;
+module_param(lag_rebalance_ms, uint, 0444);
+MODULE_PARM_DESC(lag_rebalance_ms,
+		 "Interval in ms for rebalancing hash based LAG port selection by port Tx load, 0 to disable");
+
 /* General purpose, use for short periods of time.
  * Beware of lock dependencies (preferably, no locks should be acquired
  * under it).
@@ -220,6 +225,7 @@ static void mlx5_lag_print_mapping(struct mlx5_core_dev *dev,
 static int mlx5_lag_netdev_event(struct notifier_block *this,
 				 unsigned long event, void *ptr);
 static void mlx5_do_bond_work(struct work_struct *work);
+static void mlx5_lag_rebalance_work(struct work_struct *work);
 
 static void mlx5_ldev_free(struct kref *ref)
 {
@@ -229,6 +235,7 @@ static void mlx5_ldev_free(struct kref *ref)
 		unregister_netdevice_notifier_net(&init_net, &ldev->nb);
 	mlx5_lag_mp_cleanup(ldev);
 	cancel_delayed_work_sync(&ldev->bond_work);
+	cancel_delayed_work_sync(&ldev->rebalance_work);
 	destroy_workqueue(ldev->wq);
 	mutex_destroy(&ldev->lock);
 	kfree(ldev);
@@ -262,6 +269,7 @@ static struct mlx5_lag *mlx5_lag_dev_alloc(struct mlx5_core_dev *dev)
 	kref_init(&ldev->ref);
 	mutex_init(&ldev->lock);
 	INIT_DELAYED_WORK(&ldev->bond_work, mlx5_do_bond_work);
+	INIT_DELAYED_WORK(&ldev->rebalance_work, mlx5_lag_rebalance_work);
 
 	ldev->nb.notifier_call = mlx5_lag_netdev_event;
 	if (register_netdevice_notifier_net(&init_net, &ldev->nb)) {
@@ -531,7 +539,7 @@ static int mlx5_lag_set_port_sel_mode_roce(struct mlx5_lag *ldev,
 		return 0;
 	}
 
-	if (ldev->ports > 2)
+	if (ldev->ports > 2 || lag_rebalance_ms)
 		ldev->buckets = MLX5_LAG_MAX_HASH_BUCKETS;
 
 	set_bit(MLX5_LAG_MODE_FLAG_HASH_BASED, flags);
@@ -551,7 +559,7 @@ static void mlx5_lag_set_port_sel_mode_offloads(struct mlx5_lag *ldev,
 
 	if (MLX5_CAP_PORT_SELECTION(dev0->dev, port_select_flow_table) &&
 	    tracker->tx_type == NETDEV_LAG_TX_TYPE_HASH) {
-		if (ldev->ports > 2)
+		if (ldev->ports > 2 || lag_rebalance_ms)
 			ldev->buckets = MLX5_LAG_MAX_HASH_BUCKETS;
 		set_bit(MLX5_LAG_MODE_FLAG_HASH_BASED, flags);
 	}
@@ -704,6 +712,9 @@ int mlx5_activate_lag(struct mlx5_lag *ldev,
 
 	ldev->mode = mode;
 	ldev->mode_flags = flags;
+	if (test_bit(MLX5_LAG_MODE_FLAG_HASH_BASED, &flags) && lag_rebalance_ms)
+		queue_delayed_work(ldev->wq, &ldev->rebalance_work,
+				   msecs_to_jiffies(lag_rebalance_ms));
 	return 0;
 }
 
@@ -1056,6 +1067,28 @@ static void mlx5_do_bond_work(struct work_struct *work)
 	mlx5_devcom_comp_unlock(devcom);
 }
 
+static void mlx5_lag_rebalance_work(struct work_struct *work)
+{
+	struct delayed_work *delayed_work = to_delayed_work(work);
+	struct mlx5_lag *ldev = container_of(delayed_work, struct mlx5_lag,
+					     rebalance_work);
+
+	mutex_lock(&ldev->lock);
+	if (!__mlx5_lag_is_active(ldev) ||
+	    !test_bit(MLX5_LAG_MODE_FLAG_HASH_BASED, &ldev->mode_flags) ||
+	    ldev->buckets == 1) {
+		mutex_unlock(&ldev->lock);
+		return;
+	}
+
+	if (!ldev->mode_changes_in_progress)
+		mlx5_lag_port_sel_rebalance(ldev);
+	mutex_unlock(&ldev->lock);
+
+	queue_delayed_work(ldev->wq, &ldev->rebalance_work,
+			   msecs_to_jiffies(lag_rebalance_ms));
+}
+
 static int mlx5_handle_changeupper_event(struct mlx5_lag *ldev,
 					 struct lag_tracker *tracker,
 					 struct netdev_notifier_changeupper_info *info)
@@ -621,6 +621,105 @@ int mlx5_lag_port_sel_modify(struct mlx5_lag *ldev, u8 *ports)
 						     ports);
 }
 
+static int mlx5_lag_query_port_tx_bytes(struct mlx5_core_dev *mdev, u64 *bytes)
+{
+	int sz = MLX5_ST_SZ_BYTES(ppcnt_reg);
+	void *in, *out;
+	int err;
+
+	in = kvzalloc(sz, GFP_KERNEL);
+	out = kvzalloc(sz, GFP_KERNEL);
+	if (!in || !out) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	MLX5_SET(ppcnt_reg, in, local_port, 1);
+	MLX5_SET(ppcnt_reg, in, grp, MLX5_IEEE_802_3_COUNTERS_GROUP);
+	err = mlx5_core_access_reg(mdev, in, sz, out, sz, MLX5_REG_PPCNT, 0, 0);
+	if (!err)
+		*bytes = be64_to_cpup(MLX5_ADDR_OF(ppcnt_reg, out,
+						   counter_set.eth_802_3_cntrs_grp_data_layout.a_octets_transmitted_ok_high));
+out:
+	kvfree(out);
+	kvfree(in);
+	return err;
+}
+
+/* Move one hash bucket from the most to the least loaded active port when
+ * the difference in transmitted bytes since the last call is larger than
+ * what moving an average bucket of the busy port would change, so that a
+ * balanced LAG does not oscillate. Buckets of the busy port are tried in
+ * turn, so a bucket carrying an elephant flow is eventually moved as well.
+ * Only the destinations of the existing rules are modified.
+ */
+void mlx5_lag_port_sel_rebalance(struct mlx5_lag *ldev)
+{
+	u8 ports[MLX5_MAX_PORTS * MLX5_LAG_MAX_HASH_BUCKETS];
+	struct mlx5_lag_port_sel *port_sel = &ldev->port_sel;
+	int total = ldev->ports * ldev->buckets;
+	u8 enabled[MLX5_MAX_PORTS] = {};
+	u64 load[MLX5_MAX_PORTS] = {};
+	int hot = -1, cold = -1;
+	int num_enabled;
+	int idx = 0;
+	int nr_hot;
+	u64 bytes;
+	int err;
+	int i;
+
+	for (i = 0; i < ldev->ports; i++) {
+		if (mlx5_lag_query_port_tx_bytes(ldev->pf[i].dev, &bytes))
+			return;
+		load[i] = bytes - port_sel->tx_bytes[i];
+		port_sel->tx_bytes[i] = bytes;
+	}
+
+	if (!port_sel->tx_bytes_valid) {
+		port_sel->tx_bytes_valid = true;
+		return;
+	}
+
+	mlx5_infer_tx_enabled(&ldev->tracker, ldev->ports, enabled,
+			      &num_enabled);
+	if (num_enabled < 2)
+		return;
+
+	for (i = 0; i < num_enabled; i++) {
+		if (hot < 0 || load[enabled[i]] > load[hot])
+			hot = enabled[i];
+		if (cold < 0 || load[enabled[i]] < load[cold])
+			cold = enabled[i];
+	}
+
+	memcpy(ports, ldev->v2p_map, sizeof(ports));
+	nr_hot = 0;
+	for (i = 0; i < total; i++)
+		if (ports[i] == hot + 1)
+			nr_hot++;
+	if (nr_hot <= 1)
+		return;
+
+	if (load[hot] - load[cold] <= 2 * div_u64(load[hot], nr_hot))
+		return;
+
+	for (i = 1; i <= total; i++) {
+		idx = (port_sel->rebalance_idx + i) % total;
+		if (ports[idx] == hot + 1)
+			break;
+	}
+
+	port_sel->rebalance_idx = idx;
+	ports[idx] = cold + 1;
+	err = mlx5_lag_port_sel_modify(ldev, ports);
+	if (err) {
+		mlx5_core_warn(ldev->pf[MLX5_LAG_P1].dev,
+			       "Failed to rebalance LAG port selection (%d)\n", err);
+		return;
+	}
+	memcpy(ldev->v2p_map, ports, sizeof(ports));
+}
+
 void mlx5_lag_port_sel_destroy(struct mlx5_lag *ldev)
 {
 	struct mlx5_lag_port_sel *port_sel = &ldev->port_sel;
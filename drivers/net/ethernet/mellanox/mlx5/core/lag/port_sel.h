@@ -26,11 +26,16 @@ struct mlx5_lag_port_sel {
 	bool   tunnel;
 	struct mlx5_lag_ttc outer;
 	struct mlx5_lag_ttc inner;
+	/* Adaptive rebalancing state, see mlx5_lag_port_sel_rebalance() */
+	u64    tx_bytes[MLX5_MAX_PORTS];
+	bool   tx_bytes_valid;
+	u8     rebalance_idx;
 };
 
 #ifdef CONFIG_MLX5_ESWITCH
 
 int mlx5_lag_port_sel_modify(struct mlx5_lag *ldev, u8 *ports);
+void mlx5_lag_port_sel_rebalance(struct mlx5_lag *ldev);
 void mlx5_lag_port_sel_destroy(struct mlx5_lag *ldev);
 int mlx5_lag_port_sel_create(struct mlx5_lag *ldev,
 			     enum netdev_lag_hash hash_type, u8 *ports);
@@ -48,6 +53,8 @@ static inline int mlx5_lag_port_sel_modify(struct mlx5_lag *ldev, u8 *ports)
 	return 0;
 }
 
+static inline void mlx5_lag_port_sel_rebalance(struct mlx5_lag *ldev) {}
+
 static inline void mlx5_lag_port_sel_destroy(struct mlx5_lag *ldev) {}
 #endif /* CONFIG_MLX5_ESWITCH */
 #endif /* __MLX5_LAG_FS_H__ */
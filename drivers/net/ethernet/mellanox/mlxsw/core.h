@@ -570,6 +570,7 @@ static inline void mlxsw_thermal_fini(struct mlxsw_thermal *thermal)
 enum mlxsw_devlink_param_id {
 	MLXSW_DEVLINK_PARAM_ID_BASE = DEVLINK_PARAM_GENERIC_ID_MAX,
 	MLXSW_DEVLINK_PARAM_ID_ACL_REGION_REHASH_INTERVAL,
+	MLXSW_DEVLINK_PARAM_ID_ACL_REGION_REHASH_CREDITS,
 };
 
 struct mlxsw_cqe_ts {
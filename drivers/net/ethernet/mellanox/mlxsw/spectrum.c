@@ -3715,6 +3715,7 @@ static int mlxsw_sp2_resources_kvd_register(struct mlxsw_core *mlxsw_core)
 	struct devlink *devlink = priv_to_devlink(mlxsw_core);
 	struct devlink_resource_size_params kvd_size_params;
 	u32 kvd_size;
+	int err;
 
 	if (!MLXSW_CORE_RES_VALID(mlxsw_core, KVD_SIZE))
 		return -EIO;
@@ -3724,10 +3725,14 @@ static int mlxsw_sp2_resources_kvd_register(struct mlxsw_core *mlxsw_core)
 					  MLXSW_SP_KVD_GRANULARITY,
 					  DEVLINK_RESOURCE_UNIT_ENTRY);
 
-	return devl_resource_register(devlink, MLXSW_SP_RESOURCE_NAME_KVD,
-				      kvd_size, MLXSW_SP_RESOURCE_KVD,
-				      DEVLINK_RESOURCE_ID_PARENT_TOP,
-				      &kvd_size_params);
+	err = devl_resource_register(devlink, MLXSW_SP_RESOURCE_NAME_KVD,
+				     kvd_size, MLXSW_SP_RESOURCE_KVD,
+				     DEVLINK_RESOURCE_ID_PARENT_TOP,
+				     &kvd_size_params);
+	if (err)
+		return err;
+
+	return mlxsw_sp2_kvdl_resources_register(mlxsw_core);
 }
 
 static int mlxsw_sp_resources_span_register(struct mlxsw_core *mlxsw_core)
@@ -46,6 +46,8 @@
 #define MLXSW_SP_RESOURCE_NAME_KVD_LINEAR_SINGLES "singles"
 #define MLXSW_SP_RESOURCE_NAME_KVD_LINEAR_CHUNKS "chunks"
 #define MLXSW_SP_RESOURCE_NAME_KVD_LINEAR_LARGE_CHUNKS "large_chunks"
+#define MLXSW_SP_RESOURCE_NAME_KVD_ADJ "adj"
+#define MLXSW_SP_RESOURCE_NAME_KVD_ADJ_FRAGMENTED "fragmented"
 
 #define MLXSW_SP_RESOURCE_NAME_SPAN "span_agents"
 
@@ -70,6 +72,8 @@ enum mlxsw_sp_resource_id {
 	MLXSW_SP_RESOURCE_RIF_MAC_PROFILES,
 	MLXSW_SP_RESOURCE_RIFS,
 	MLXSW_SP_RESOURCE_PORT_RANGE_REGISTERS,
+	MLXSW_SP_RESOURCE_KVD_ADJ,
+	MLXSW_SP_RESOURCE_KVD_ADJ_FRAGMENTED,
 };
 
 struct mlxsw_sp_port;
@@ -819,6 +823,14 @@ struct mlxsw_sp_kvdl_ops {
 				enum mlxsw_sp_kvdl_entry_type type,
 				unsigned int entry_count,
 				unsigned int *p_alloc_count);
+	int (*alloc_below)(struct mlxsw_sp *mlxsw_sp, void *priv,
+			   enum mlxsw_sp_kvdl_entry_type type,
+			   unsigned int entry_count, u32 limit_index,
+			   u32 *p_entry_index);
+	void (*frag_query)(struct mlxsw_sp *mlxsw_sp, void *priv,
+			   enum mlxsw_sp_kvdl_entry_type type,
+			   unsigned int *p_free_count,
+			   unsigned int *p_largest_free_count);
 	int (*resources_register)(struct mlxsw_sp *mlxsw_sp, void *priv);
 };
 
@@ -834,6 +846,14 @@ int mlxsw_sp_kvdl_alloc_count_query(struct mlxsw_sp *mlxsw_sp,
 				    enum mlxsw_sp_kvdl_entry_type type,
 				    unsigned int entry_count,
 				    unsigned int *p_alloc_count);
+int mlxsw_sp_kvdl_alloc_below(struct mlxsw_sp *mlxsw_sp,
+			      enum mlxsw_sp_kvdl_entry_type type,
+			      unsigned int entry_count, u32 limit_index,
+			      u32 *p_entry_index);
+int mlxsw_sp_kvdl_frag_query(struct mlxsw_sp *mlxsw_sp,
+			     enum mlxsw_sp_kvdl_entry_type type,
+			     unsigned int *p_free_count,
+			     unsigned int *p_largest_free_count);
 
 /* spectrum1_kvdl.c */
 extern const struct mlxsw_sp_kvdl_ops mlxsw_sp1_kvdl_ops;
@@ -841,6 +861,7 @@ int mlxsw_sp1_kvdl_resources_register(struct mlxsw_core *mlxsw_core);
 
 /* spectrum2_kvdl.c */
 extern const struct mlxsw_sp_kvdl_ops mlxsw_sp2_kvdl_ops;
+int mlxsw_sp2_kvdl_resources_register(struct mlxsw_core *mlxsw_core);
 
 enum mlxsw_sp_acl_mangle_field {
 	MLXSW_SP_ACL_MANGLE_FIELD_IP_DSFIELD,
@@ -104,6 +104,59 @@ static int mlxsw_sp2_kvdl_part_alloc(struct mlxsw_sp2_kvdl_part *part,
 	return 0;
 }
 
+static int mlxsw_sp2_kvdl_part_alloc_below(struct mlxsw_sp2_kvdl_part *part,
+					   unsigned int size, u32 limit_index,
+					   u32 *p_kvdl_index)
+{
+	unsigned int limit_bit;
+	unsigned int bit_count;
+	unsigned int bit = 0;
+	unsigned int next;
+	unsigned int i;
+
+	bit_count = DIV_ROUND_UP(size, part->indexes_per_usage_bit);
+	limit_bit = min(limit_index / part->indexes_per_usage_bit,
+			part->usage_bit_count);
+
+	/* Unlike the regular allocation, which is next-fit so that freed
+	 * indexes are not immediately reused, search first-fit from the start
+	 * of the partition.
+	 */
+	while (true) {
+		bit = find_next_zero_bit(part->usage, limit_bit, bit);
+		if (bit + bit_count > limit_bit)
+			return -ENOBUFS;
+		next = find_next_bit(part->usage, bit + bit_count, bit);
+		if (next == bit + bit_count)
+			break;
+		bit = next;
+	}
+	for (i = 0; i < bit_count; i++)
+		__set_bit(bit + i, part->usage);
+	*p_kvdl_index = bit * part->indexes_per_usage_bit;
+	return 0;
+}
+
+static void mlxsw_sp2_kvdl_part_frag(const struct mlxsw_sp2_kvdl_part *part,
+				     unsigned int *p_free_count,
+				     unsigned int *p_largest_free_count)
+{
+	unsigned int largest_free_bits = 0;
+	unsigned int free_bits = 0;
+	unsigned int bit = 0;
+	unsigned int next;
+
+	while ((bit = find_next_zero_bit(part->usage, part->usage_bit_count,
+					 bit)) < part->usage_bit_count) {
+		next = find_next_bit(part->usage, part->usage_bit_count, bit);
+		free_bits += next - bit;
+		largest_free_bits = max(largest_free_bits, next - bit);
+		bit = next;
+	}
+	*p_free_count = free_bits * part->indexes_per_usage_bit;
+	*p_largest_free_count = largest_free_bits * part->indexes_per_usage_bit;
+}
+
 static int mlxsw_sp2_kvdl_rec_del(struct mlxsw_sp *mlxsw_sp, u8 res_type,
 				  u16 size, u32 kvdl_index)
 {
@@ -166,6 +219,30 @@ static void mlxsw_sp2_kvdl_free(struct mlxsw_sp *mlxsw_sp, void *priv,
 	return mlxsw_sp2_kvdl_part_free(mlxsw_sp, part, size, entry_index);
 }
 
+static int mlxsw_sp2_kvdl_alloc_below(struct mlxsw_sp *mlxsw_sp, void *priv,
+				      enum mlxsw_sp_kvdl_entry_type type,
+				      unsigned int entry_count, u32 limit_index,
+				      u32 *p_entry_index)
+{
+	unsigned int size = entry_count * mlxsw_sp_kvdl_entry_size(type);
+	struct mlxsw_sp2_kvdl *kvdl = priv;
+	struct mlxsw_sp2_kvdl_part *part = kvdl->parts[type];
+
+	return mlxsw_sp2_kvdl_part_alloc_below(part, size, limit_index,
+					       p_entry_index);
+}
+
+static void mlxsw_sp2_kvdl_frag_query(struct mlxsw_sp *mlxsw_sp, void *priv,
+				      enum mlxsw_sp_kvdl_entry_type type,
+				      unsigned int *p_free_count,
+				      unsigned int *p_largest_free_count)
+{
+	struct mlxsw_sp2_kvdl *kvdl = priv;
+
+	mlxsw_sp2_kvdl_part_frag(kvdl->parts[type], p_free_count,
+				 p_largest_free_count);
+}
+
 static int mlxsw_sp2_kvdl_alloc_size_query(struct mlxsw_sp *mlxsw_sp,
 					   void *priv,
 					   enum mlxsw_sp_kvdl_entry_type type,
@@ -249,17 +326,59 @@ static void mlxsw_sp2_kvdl_parts_fini(struct mlxsw_sp2_kvdl *kvdl)
 		mlxsw_sp2_kvdl_part_fini(kvdl->parts[i]);
 }
 
+static u64 mlxsw_sp2_kvdl_adj_occ_get(void *priv)
+{
+	const struct mlxsw_sp2_kvdl *kvdl = priv;
+	struct mlxsw_sp2_kvdl_part *part;
+
+	part = kvdl->parts[MLXSW_SP_KVDL_ENTRY_TYPE_ADJ];
+	return bitmap_weight(part->usage, part->usage_bit_count) *
+	       part->indexes_per_usage_bit;
+}
+
+/* Free entries that are not part of the largest free area, i.e. the part of
+ * the free space that cannot be used by a single large allocation.
+ */
+static u64 mlxsw_sp2_kvdl_adj_fragmented_occ_get(void *priv)
+{
+	const struct mlxsw_sp2_kvdl *kvdl = priv;
+	unsigned int largest_free_count;
+	unsigned int free_count;
+
+	mlxsw_sp2_kvdl_part_frag(kvdl->parts[MLXSW_SP_KVDL_ENTRY_TYPE_ADJ],
+				 &free_count, &largest_free_count);
+	return free_count - largest_free_count;
+}
+
 static int mlxsw_sp2_kvdl_init(struct mlxsw_sp *mlxsw_sp, void *priv)
 {
+	struct devlink *devlink = priv_to_devlink(mlxsw_sp->core);
 	struct mlxsw_sp2_kvdl *kvdl = priv;
+	int err;
 
-	return mlxsw_sp2_kvdl_parts_init(mlxsw_sp, kvdl);
+	err = mlxsw_sp2_kvdl_parts_init(mlxsw_sp, kvdl);
+	if (err)
+		return err;
+	devl_resource_occ_get_register(devlink,
+				       MLXSW_SP_RESOURCE_KVD_ADJ,
+				       mlxsw_sp2_kvdl_adj_occ_get,
+				       kvdl);
+	devl_resource_occ_get_register(devlink,
+				       MLXSW_SP_RESOURCE_KVD_ADJ_FRAGMENTED,
+				       mlxsw_sp2_kvdl_adj_fragmented_occ_get,
+				       kvdl);
+	return 0;
 }
 
 static void mlxsw_sp2_kvdl_fini(struct mlxsw_sp *mlxsw_sp, void *priv)
 {
+	struct devlink *devlink = priv_to_devlink(mlxsw_sp->core);
 	struct mlxsw_sp2_kvdl *kvdl = priv;
 
+	devl_resource_occ_get_unregister(devlink,
+					 MLXSW_SP_RESOURCE_KVD_ADJ_FRAGMENTED);
+	devl_resource_occ_get_unregister(devlink,
+					 MLXSW_SP_RESOURCE_KVD_ADJ);
 	mlxsw_sp2_kvdl_parts_fini(kvdl);
 }
 
@@ -270,4 +389,32 @@ const struct mlxsw_sp_kvdl_ops mlxsw_sp2_kvdl_ops = {
 	.alloc = mlxsw_sp2_kvdl_alloc,
 	.free = mlxsw_sp2_kvdl_free,
 	.alloc_size_query = mlxsw_sp2_kvdl_alloc_size_query,
+	.alloc_below = mlxsw_sp2_kvdl_alloc_below,
+	.frag_query = mlxsw_sp2_kvdl_frag_query,
 };
+
+int mlxsw_sp2_kvdl_resources_register(struct mlxsw_core *mlxsw_core)
+{
+	struct devlink *devlink = priv_to_devlink(mlxsw_core);
+	struct devlink_resource_size_params size_params;
+	u32 adj_size;
+	int err;
+
+	if (!MLXSW_CORE_RES_VALID(mlxsw_core, MAX_KVD_LINEAR_RANGE))
+		return -EIO;
+
+	adj_size = MLXSW_CORE_RES_GET(mlxsw_core, MAX_KVD_LINEAR_RANGE);
+	devlink_resource_size_params_init(&size_params, adj_size, adj_size, 1,
+					  DEVLINK_RESOURCE_UNIT_ENTRY);
+	err = devl_resource_register(devlink, MLXSW_SP_RESOURCE_NAME_KVD_ADJ,
+				     adj_size, MLXSW_SP_RESOURCE_KVD_ADJ,
+				     MLXSW_SP_RESOURCE_KVD, &size_params);
+	if (err)
+		return err;
+
+	return devl_resource_register(devlink,
+				      MLXSW_SP_RESOURCE_NAME_KVD_ADJ_FRAGMENTED,
+				      adj_size,
+				      MLXSW_SP_RESOURCE_KVD_ADJ_FRAGMENTED,
+				      MLXSW_SP_RESOURCE_KVD_ADJ, &size_params);
+}
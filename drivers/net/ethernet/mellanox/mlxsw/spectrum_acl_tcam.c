@@ -716,7 +716,7 @@ static void mlxsw_sp_acl_tcam_vregion_rehash_work(struct work_struct *work)
 	struct mlxsw_sp_acl_tcam_vregion *vregion =
 		container_of(work, struct mlxsw_sp_acl_tcam_vregion,
 			     rehash.dw.work);
-	int credits = MLXSW_SP_ACL_TCAM_VREGION_REHASH_CREDITS;
+	int credits = READ_ONCE(vregion->tcam->vregion_rehash_credits);
 
 	mutex_lock(&vregion->lock);
 	mlxsw_sp_acl_tcam_vregion_rehash(vregion->mlxsw_sp, vregion, &credits);
@@ -1530,6 +1530,51 @@ mlxsw_sp_acl_tcam_region_rehash_intrvl_set(struct devlink *devlink, u32 id,
 	return 0;
 }
 
+static int
+mlxsw_sp_acl_tcam_region_rehash_credits_get(struct devlink *devlink, u32 id,
+					    struct devlink_param_gset_ctx *ctx)
+{
+	struct mlxsw_core *mlxsw_core = devlink_priv(devlink);
+	struct mlxsw_sp_acl_tcam *tcam;
+	struct mlxsw_sp *mlxsw_sp;
+
+	mlxsw_sp = mlxsw_core_driver_priv(mlxsw_core);
+	tcam = mlxsw_sp_acl_to_tcam(mlxsw_sp->acl);
+	ctx->val.vu32 = tcam->vregion_rehash_credits;
+
+	return 0;
+}
+
+static int
+mlxsw_sp_acl_tcam_region_rehash_credits_set(struct devlink *devlink, u32 id,
+					    struct devlink_param_gset_ctx *ctx,
+					    struct netlink_ext_ack *extack)
+{
+	struct mlxsw_core *mlxsw_core = devlink_priv(devlink);
+	struct mlxsw_sp_acl_tcam *tcam;
+	struct mlxsw_sp *mlxsw_sp;
+
+	mlxsw_sp = mlxsw_core_driver_priv(mlxsw_core);
+	tcam = mlxsw_sp_acl_to_tcam(mlxsw_sp->acl);
+	/* Picked up by the next rehash work run */
+	WRITE_ONCE(tcam->vregion_rehash_credits, ctx->val.vu32);
+
+	return 0;
+}
+
+static int
+mlxsw_sp_acl_tcam_region_rehash_credits_validate(struct devlink *devlink, u32 id,
+						 union devlink_param_value val,
+						 struct netlink_ext_ack *extack)
+{
+	if (!val.vu32 || val.vu32 > INT_MAX) {
+		NL_SET_ERR_MSG_MOD(extack, "Rehash credits must be positive");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 static const struct devlink_param mlxsw_sp_acl_tcam_rehash_params[] = {
 	DEVLINK_PARAM_DRIVER(MLXSW_DEVLINK_PARAM_ID_ACL_REGION_REHASH_INTERVAL,
 			     "acl_region_rehash_interval",
@@ -1538,6 +1583,13 @@ static const struct devlink_param mlxsw_sp_acl_tcam_rehash_params[] = {
 			     mlxsw_sp_acl_tcam_region_rehash_intrvl_get,
 			     mlxsw_sp_acl_tcam_region_rehash_intrvl_set,
 			     NULL),
+	DEVLINK_PARAM_DRIVER(MLXSW_DEVLINK_PARAM_ID_ACL_REGION_REHASH_CREDITS,
+			     "acl_region_rehash_credits",
+			     DEVLINK_PARAM_TYPE_U32,
+			     BIT(DEVLINK_PARAM_CMODE_RUNTIME),
+			     mlxsw_sp_acl_tcam_region_rehash_credits_get,
+			     mlxsw_sp_acl_tcam_region_rehash_credits_set,
+			     mlxsw_sp_acl_tcam_region_rehash_credits_validate),
 };
 
 static int mlxsw_sp_acl_tcam_rehash_params_register(struct mlxsw_sp *mlxsw_sp)
@@ -1575,6 +1627,8 @@ int mlxsw_sp_acl_tcam_init(struct mlxsw_sp *mlxsw_sp,
 	mutex_init(&tcam->lock);
 	tcam->vregion_rehash_intrvl =
 			MLXSW_SP_ACL_TCAM_VREGION_REHASH_INTRVL_DFLT;
+	tcam->vregion_rehash_credits =
+			MLXSW_SP_ACL_TCAM_VREGION_REHASH_CREDITS;
 	INIT_LIST_HEAD(&tcam->vregion_list);
 
 	err = mlxsw_sp_acl_tcam_rehash_params_register(mlxsw_sp);
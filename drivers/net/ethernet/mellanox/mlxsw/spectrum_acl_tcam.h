@@ -21,6 +21,7 @@ struct mlxsw_sp_acl_tcam {
 	struct mutex lock; /* guards vregion list */
 	struct list_head vregion_list;
 	u32 vregion_rehash_intrvl;   /* ms */
+	u32 vregion_rehash_credits;  /* entries migrated per work run */
 	unsigned long priv[];
 	/* priv has to be always the last item */
 };
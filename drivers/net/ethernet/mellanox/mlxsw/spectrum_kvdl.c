@@ -85,3 +85,44 @@ int mlxsw_sp_kvdl_alloc_count_query(struct mlxsw_sp *mlxsw_sp,
 	return kvdl->kvdl_ops->alloc_size_query(mlxsw_sp, kvdl->priv, type,
 						entry_count, p_alloc_count);
 }
+
+/* Allocate entry_count entries that end at or before limit_index, lowest
+ * index first. Used to move live entries towards the start of a partition.
+ */
+int mlxsw_sp_kvdl_alloc_below(struct mlxsw_sp *mlxsw_sp,
+			      enum mlxsw_sp_kvdl_entry_type type,
+			      unsigned int entry_count, u32 limit_index,
+			      u32 *p_entry_index)
+{
+	struct mlxsw_sp_kvdl *kvdl = mlxsw_sp->kvdl;
+	int err;
+
+	if (!kvdl->kvdl_ops->alloc_below)
+		return -EOPNOTSUPP;
+
+	mutex_lock(&kvdl->kvdl_lock);
+	err = kvdl->kvdl_ops->alloc_below(mlxsw_sp, kvdl->priv, type,
+					  entry_count, limit_index,
+					  p_entry_index);
+	mutex_unlock(&kvdl->kvdl_lock);
+
+	return err;
+}
+
+int mlxsw_sp_kvdl_frag_query(struct mlxsw_sp *mlxsw_sp,
+			     enum mlxsw_sp_kvdl_entry_type type,
+			     unsigned int *p_free_count,
+			     unsigned int *p_largest_free_count)
+{
+	struct mlxsw_sp_kvdl *kvdl = mlxsw_sp->kvdl;
+
+	if (!kvdl->kvdl_ops->frag_query)
+		return -EOPNOTSUPP;
+
+	mutex_lock(&kvdl->kvdl_lock);
+	kvdl->kvdl_ops->frag_query(mlxsw_sp, kvdl->priv, type, p_free_count,
+				   p_largest_free_count);
+	mutex_unlock(&kvdl->kvdl_lock);
+
+	return 0;
+}
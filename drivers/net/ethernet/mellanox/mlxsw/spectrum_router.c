@@ -4894,6 +4894,137 @@ static void mlxsw_sp_nh_grp_activity_work(struct work_struct *work)
 	mlxsw_sp_nh_grp_activity_work_schedule(router->mlxsw_sp);
 }
 
+#define MLXSW_SP_ADJ_COMPACT_INTERVAL 5000 /* ms */
+#define MLXSW_SP_ADJ_COMPACT_BUDGET 64 /* groups per run */
+
+static void mlxsw_sp_adj_compact_work_schedule(struct mlxsw_sp *mlxsw_sp,
+					       unsigned int interval)
+{
+	mlxsw_core_schedule_dw(&mlxsw_sp->router->adj_compact_dw,
+			       msecs_to_jiffies(interval));
+}
+
+/* The adjacency table is next-fit allocated and groups of different sizes
+ * come and go, so its free space ends up scattered and a large group can fail
+ * to allocate although enough entries are free. Compaction moves groups
+ * towards the start of the table, make-before-break: the entries are written
+ * at their new location and the routes are repointed using RALEU before the
+ * old location is released, so traffic is not disrupted.
+ */
+static int mlxsw_sp_nexthop_group_relocate(struct mlxsw_sp *mlxsw_sp,
+					   struct mlxsw_sp_nexthop_group *nh_grp)
+{
+	struct mlxsw_sp_nexthop_group_info *nhgi = nh_grp->nhgi;
+	u32 old_adj_index = nhgi->adj_index;
+	u32 adj_index;
+	int err;
+
+	err = mlxsw_sp_kvdl_alloc_below(mlxsw_sp, MLXSW_SP_KVDL_ENTRY_TYPE_ADJ,
+					nhgi->ecmp_size, old_adj_index,
+					&adj_index);
+	if (err)
+		return err;
+
+	nhgi->adj_index = adj_index;
+	err = mlxsw_sp_nexthop_group_update(mlxsw_sp, nhgi, true);
+	if (err)
+		goto err_group_update;
+
+	err = mlxsw_sp_adj_index_mass_update(mlxsw_sp, nh_grp, old_adj_index,
+					     nhgi->ecmp_size);
+	if (err)
+		goto err_mass_update;
+
+	mlxsw_sp_kvdl_free(mlxsw_sp, MLXSW_SP_KVDL_ENTRY_TYPE_ADJ,
+			   nhgi->ecmp_size, old_adj_index);
+	return 0;
+
+err_mass_update:
+err_group_update:
+	nhgi->adj_index = old_adj_index;
+	mlxsw_sp_kvdl_free(mlxsw_sp, MLXSW_SP_KVDL_ENTRY_TYPE_ADJ,
+			   nhgi->ecmp_size, adj_index);
+	return err;
+}
+
+static bool
+mlxsw_sp_nexthop_group_relocatable(const struct mlxsw_sp_nexthop_group *nh_grp)
+{
+	const struct mlxsw_sp_nexthop_group_info *nhgi = nh_grp->nhgi;
+
+	/* Resilient groups have their buckets tracked by the kernel and are
+	 * populated bucket by bucket, leave them in place.
+	 */
+	return nhgi->gateway && nhgi->adj_index_valid && !nhgi->is_resilient;
+}
+
+static bool mlxsw_sp_adj_fragmented(struct mlxsw_sp *mlxsw_sp, int *p_err)
+{
+	unsigned int largest_free_count;
+	unsigned int free_count;
+
+	*p_err = mlxsw_sp_kvdl_frag_query(mlxsw_sp,
+					  MLXSW_SP_KVDL_ENTRY_TYPE_ADJ,
+					  &free_count, &largest_free_count);
+	if (*p_err)
+		return false;
+
+	/* Compact once more than a quarter of the free entries are outside
+	 * of the largest free area.
+	 */
+	return (free_count - largest_free_count) * 4 > free_count;
+}
+
+static void mlxsw_sp_adj_compact_work(struct work_struct *work)
+{
+	unsigned int budget = MLXSW_SP_ADJ_COMPACT_BUDGET;
+	struct mlxsw_sp_nexthop_group *nh_grp;
+	struct mlxsw_sp_router *router;
+	struct rhashtable_iter iter;
+	int err;
+
+	router = container_of(work, struct mlxsw_sp_router,
+			      adj_compact_dw.work);
+
+	mutex_lock(&router->lock);
+
+	if (!mlxsw_sp_adj_fragmented(router->mlxsw_sp, &err))
+		goto out;
+
+	rhashtable_walk_enter(&router->nexthop_group_ht, &iter);
+	rhashtable_walk_start(&iter);
+	while (budget && (nh_grp = rhashtable_walk_next(&iter))) {
+		if (IS_ERR(nh_grp))
+			continue;
+		if (!mlxsw_sp_nexthop_group_relocatable(nh_grp))
+			continue;
+
+		/* Relocation sleeps. The group table is only changed under the
+		 * router lock, which is held, so the walk can be resumed.
+		 */
+		rhashtable_walk_stop(&iter);
+		err = mlxsw_sp_nexthop_group_relocate(router->mlxsw_sp, nh_grp);
+		rhashtable_walk_start(&iter);
+		if (!err)
+			budget--;
+		else if (err != -ENOBUFS)
+			dev_warn_ratelimited(router->mlxsw_sp->bus_info->dev, "Failed to relocate nexthop group during adjacency table compaction\n");
+	}
+	rhashtable_walk_stop(&iter);
+	rhashtable_walk_exit(&iter);
+
+out:
+	mutex_unlock(&router->lock);
+
+	/* Spectrum-1 carves the table into fixed size partitions, there is
+	 * nothing to compact there.
+	 */
+	if (err == -EOPNOTSUPP)
+		return;
+	mlxsw_sp_adj_compact_work_schedule(router->mlxsw_sp,
+					   budget ? MLXSW_SP_ADJ_COMPACT_INTERVAL : 0);
+}
+
 static int
 mlxsw_sp_nexthop_obj_single_validate(struct mlxsw_sp *mlxsw_sp,
 				     const struct nh_notifier_single_info *nh,
@@ -6199,6 +6330,60 @@ mlxsw_sp_fib_entry_ralue_pack(char *ralue_pl,
 	}
 }
 
+#define MLXSW_SP_FIB_ENTRY_BULK_MAX 256
+
+static int mlxsw_sp_fib_entry_op_ctx_bulk_wait(struct mlxsw_sp *mlxsw_sp)
+{
+	struct mlxsw_sp_fib_entry_op_ctx *op_ctx = &mlxsw_sp->router->ll_op_ctx;
+
+	op_ctx->bulk_count = 0;
+	return mlxsw_reg_trans_bulk_wait(&op_ctx->bulk_list);
+}
+
+static void mlxsw_sp_fib_entry_op_ctx_bulk_begin(struct mlxsw_sp *mlxsw_sp)
+{
+	mlxsw_sp->router->ll_op_ctx.bulk = true;
+}
+
+static void mlxsw_sp_fib_entry_op_ctx_bulk_end(struct mlxsw_sp *mlxsw_sp)
+{
+	mlxsw_sp->router->ll_op_ctx.bulk = false;
+	if (mlxsw_sp_fib_entry_op_ctx_bulk_wait(mlxsw_sp))
+		dev_warn(mlxsw_sp->bus_info->dev, "Failed to write FIB entries in bulk\n");
+}
+
+/* Within a batch of FIB events the RALUE deletes are pipelined instead of
+ * waiting for each one to complete. EMADs are executed in order, so writes
+ * of other registers issued meanwhile are still seen by the device in
+ * program order. An error of a pipelined delete is only reported when the
+ * bulk is waited for, which is fine as the entry is gone by then anyway.
+ * Other operations are written synchronously, so that a failure reaches
+ * the caller and the entry is marked as failed to offload.
+ */
+static int mlxsw_sp_fib_entry_ralue_write(struct mlxsw_sp *mlxsw_sp,
+					  char *ralue_pl)
+{
+	struct mlxsw_sp_fib_entry_op_ctx *op_ctx = &mlxsw_sp->router->ll_op_ctx;
+	int err;
+
+	if (!op_ctx->bulk ||
+	    mlxsw_reg_ralue_op_get(ralue_pl) != MLXSW_REG_RALUE_OP_WRITE_DELETE)
+		return mlxsw_reg_write(mlxsw_sp->core, MLXSW_REG(ralue),
+				       ralue_pl);
+
+	err = mlxsw_reg_trans_write(mlxsw_sp->core, MLXSW_REG(ralue), ralue_pl,
+				    &op_ctx->bulk_list, NULL, 0);
+	if (err)
+		return err;
+
+	if (++op_ctx->bulk_count < MLXSW_SP_FIB_ENTRY_BULK_MAX)
+		return 0;
+
+	if (mlxsw_sp_fib_entry_op_ctx_bulk_wait(mlxsw_sp))
+		dev_warn(mlxsw_sp->bus_info->dev, "Failed to write FIB entries in bulk\n");
+	return 0;
+}
+
 static int mlxsw_sp_fib_entry_op_remote(struct mlxsw_sp *mlxsw_sp,
 					struct mlxsw_sp_fib_entry *fib_entry,
 					enum mlxsw_reg_ralue_op op)
@@ -6232,7 +6417,7 @@ static int mlxsw_sp_fib_entry_op_remote(struct mlxsw_sp *mlxsw_sp,
 	mlxsw_sp_fib_entry_ralue_pack(ralue_pl, fib_entry, op);
 	mlxsw_reg_ralue_act_remote_pack(ralue_pl, trap_action, trap_id,
 					adjacency_index, ecmp_size);
-	return mlxsw_reg_write(mlxsw_sp->core, MLXSW_REG(ralue), ralue_pl);
+	return mlxsw_sp_fib_entry_ralue_write(mlxsw_sp, ralue_pl);
 }
 
 static int mlxsw_sp_fib_entry_op_local(struct mlxsw_sp *mlxsw_sp,
@@ -6256,7 +6441,7 @@ static int mlxsw_sp_fib_entry_op_local(struct mlxsw_sp *mlxsw_sp,
 	mlxsw_sp_fib_entry_ralue_pack(ralue_pl, fib_entry, op);
 	mlxsw_reg_ralue_act_local_pack(ralue_pl, trap_action, trap_id,
 				       rif_index);
-	return mlxsw_reg_write(mlxsw_sp->core, MLXSW_REG(ralue), ralue_pl);
+	return mlxsw_sp_fib_entry_ralue_write(mlxsw_sp, ralue_pl);
 }
 
 static int mlxsw_sp_fib_entry_op_trap(struct mlxsw_sp *mlxsw_sp,
@@ -6267,7 +6452,7 @@ static int mlxsw_sp_fib_entry_op_trap(struct mlxsw_sp *mlxsw_sp,
 
 	mlxsw_sp_fib_entry_ralue_pack(ralue_pl, fib_entry, op);
 	mlxsw_reg_ralue_act_ip2me_pack(ralue_pl);
-	return mlxsw_reg_write(mlxsw_sp->core, MLXSW_REG(ralue), ralue_pl);
+	return mlxsw_sp_fib_entry_ralue_write(mlxsw_sp, ralue_pl);
 }
 
 static int mlxsw_sp_fib_entry_op_blackhole(struct mlxsw_sp *mlxsw_sp,
@@ -6280,7 +6465,7 @@ static int mlxsw_sp_fib_entry_op_blackhole(struct mlxsw_sp *mlxsw_sp,
 	trap_action = MLXSW_REG_RALUE_TRAP_ACTION_DISCARD_ERROR;
 	mlxsw_sp_fib_entry_ralue_pack(ralue_pl, fib_entry, op);
 	mlxsw_reg_ralue_act_local_pack(ralue_pl, trap_action, 0, 0);
-	return mlxsw_reg_write(mlxsw_sp->core, MLXSW_REG(ralue), ralue_pl);
+	return mlxsw_sp_fib_entry_ralue_write(mlxsw_sp, ralue_pl);
 }
 
 static int
@@ -6297,7 +6482,7 @@ mlxsw_sp_fib_entry_op_unreachable(struct mlxsw_sp *mlxsw_sp,
 
 	mlxsw_sp_fib_entry_ralue_pack(ralue_pl, fib_entry, op);
 	mlxsw_reg_ralue_act_local_pack(ralue_pl, trap_action, trap_id, 0);
-	return mlxsw_reg_write(mlxsw_sp->core, MLXSW_REG(ralue), ralue_pl);
+	return mlxsw_sp_fib_entry_ralue_write(mlxsw_sp, ralue_pl);
 }
 
 static int
@@ -6322,7 +6507,7 @@ mlxsw_sp_fib_entry_op_ipip_decap(struct mlxsw_sp *mlxsw_sp,
 	mlxsw_sp_fib_entry_ralue_pack(ralue_pl, fib_entry, op);
 	mlxsw_reg_ralue_act_ip2me_tun_pack(ralue_pl,
 					   fib_entry->decap.tunnel_index);
-	return mlxsw_reg_write(mlxsw_sp->core, MLXSW_REG(ralue), ralue_pl);
+	return mlxsw_sp_fib_entry_ralue_write(mlxsw_sp, ralue_pl);
 }
 
 static int mlxsw_sp_fib_entry_op_nve_decap(struct mlxsw_sp *mlxsw_sp,
@@ -6334,7 +6519,7 @@ static int mlxsw_sp_fib_entry_op_nve_decap(struct mlxsw_sp *mlxsw_sp,
 	mlxsw_sp_fib_entry_ralue_pack(ralue_pl, fib_entry, op);
 	mlxsw_reg_ralue_act_ip2me_tun_pack(ralue_pl,
 					   fib_entry->decap.tunnel_index);
-	return mlxsw_reg_write(mlxsw_sp->core, MLXSW_REG(ralue), ralue_pl);
+	return mlxsw_sp_fib_entry_ralue_write(mlxsw_sp, ralue_pl);
 }
 
 static int __mlxsw_sp_fib_entry_op(struct mlxsw_sp *mlxsw_sp,
@@ -7798,6 +7983,13 @@ struct mlxsw_sp_fib6_event_work {
 
 struct mlxsw_sp_fib_event_work {
 	struct work_struct work;
+	/* IPv4 and IPv6 events are queued on the router's fib_event_queue */
+	struct list_head list;
+	struct hlist_node ht_node;
+	/* Later REPLACE on the same prefix makes this one redundant */
+	bool coalesced;
+	/* DEL undoing this REPLACE */
+	struct mlxsw_sp_fib_event_work *cancel;
 	netdevice_tracker dev_tracker;
 	union {
 		struct mlxsw_sp_fib6_event_work fib6_work;
@@ -7809,6 +8001,7 @@ struct mlxsw_sp_fib_event_work {
 	};
 	struct mlxsw_sp *mlxsw_sp;
 	unsigned long event;
+	int family;
 };
 
 static int
@@ -7859,18 +8052,41 @@ mlxsw_sp_router_fib6_work_fini(struct mlxsw_sp_fib6_event_work *fib6_work)
 	kfree(fib6_work->rt_arr);
 }
 
-static void mlxsw_sp_router_fib4_event_work(struct work_struct *work)
+static bool mlxsw_sp_fib4_node_exists(struct mlxsw_sp *mlxsw_sp,
+				      const struct fib_entry_notifier_info *fen_info)
 {
-	struct mlxsw_sp_fib_event_work *fib_work =
-		container_of(work, struct mlxsw_sp_fib_event_work, work);
-	struct mlxsw_sp *mlxsw_sp = fib_work->mlxsw_sp;
-	int err;
+	struct mlxsw_sp_fib *fib;
+	struct mlxsw_sp_vr *vr;
 
-	mutex_lock(&mlxsw_sp->router->lock);
-	mlxsw_sp_span_respin(mlxsw_sp);
+	vr = mlxsw_sp_vr_find(mlxsw_sp, fen_info->tb_id);
+	if (!vr)
+		return false;
+	fib = mlxsw_sp_vr_fib(vr, MLXSW_SP_L3_PROTO_IPV4);
+
+	return mlxsw_sp_fib_node_lookup(fib, &fen_info->dst,
+					sizeof(fen_info->dst),
+					fen_info->dst_len);
+}
+
+static void
+mlxsw_sp_router_fib4_event_process(struct mlxsw_sp *mlxsw_sp,
+				   struct mlxsw_sp_fib_event_work *fib_work)
+{
+	int err;
 
 	switch (fib_work->event) {
 	case FIB_EVENT_ENTRY_REPLACE:
+		if (fib_work->coalesced)
+			goto put_fi;
+		/* The kernel only sends a DEL once the prefix has no route
+		 * left in the table, so if the prefix was not programmed
+		 * before this REPLACE, the REPLACE and its DEL cancel out.
+		 */
+		if (fib_work->cancel &&
+		    !mlxsw_sp_fib4_node_exists(mlxsw_sp, &fib_work->fen_info)) {
+			fib_work->cancel->coalesced = true;
+			goto put_fi;
+		}
 		err = mlxsw_sp_router_fib4_replace(mlxsw_sp,
 						   &fib_work->fen_info);
 		if (err) {
@@ -7878,10 +8094,12 @@ static void mlxsw_sp_router_fib4_event_work(struct work_struct *work)
 			mlxsw_sp_fib4_offload_failed_flag_set(mlxsw_sp,
 							      &fib_work->fen_info);
 		}
+put_fi:
 		fib_info_put(fib_work->fen_info.fi);
 		break;
 	case FIB_EVENT_ENTRY_DEL:
-		mlxsw_sp_router_fib4_del(mlxsw_sp, &fib_work->fen_info);
+		if (!fib_work->coalesced)
+			mlxsw_sp_router_fib4_del(mlxsw_sp, &fib_work->fen_info);
 		fib_info_put(fib_work->fen_info.fi);
 		break;
 	case FIB_EVENT_NH_ADD:
@@ -7891,21 +8109,15 @@ static void mlxsw_sp_router_fib4_event_work(struct work_struct *work)
 		fib_info_put(fib_work->fnh_info.fib_nh->nh_parent);
 		break;
 	}
-	mutex_unlock(&mlxsw_sp->router->lock);
-	kfree(fib_work);
 }
 
-static void mlxsw_sp_router_fib6_event_work(struct work_struct *work)
+static void
+mlxsw_sp_router_fib6_event_process(struct mlxsw_sp *mlxsw_sp,
+				   struct mlxsw_sp_fib_event_work *fib_work)
 {
-	struct mlxsw_sp_fib_event_work *fib_work =
-		    container_of(work, struct mlxsw_sp_fib_event_work, work);
 	struct mlxsw_sp_fib6_event_work *fib6_work = &fib_work->fib6_work;
-	struct mlxsw_sp *mlxsw_sp = fib_work->mlxsw_sp;
 	int err;
 
-	mutex_lock(&mlxsw_sp->router->lock);
-	mlxsw_sp_span_respin(mlxsw_sp);
-
 	switch (fib_work->event) {
 	case FIB_EVENT_ENTRY_REPLACE:
 		err = mlxsw_sp_router_fib6_replace(mlxsw_sp,
@@ -7938,8 +8150,111 @@ static void mlxsw_sp_router_fib6_event_work(struct work_struct *work)
 		mlxsw_sp_router_fib6_work_fini(fib6_work);
 		break;
 	}
-	mutex_unlock(&mlxsw_sp->router->lock);
-	kfree(fib_work);
+}
+
+static bool
+mlxsw_sp_fib4_event_same_prefix(const struct fib_entry_notifier_info *a,
+				const struct fib_entry_notifier_info *b)
+{
+	return a->tb_id == b->tb_id && a->dst == b->dst &&
+	       a->dst_len == b->dst_len;
+}
+
+/* Only look at IPv4 REPLACE and DEL events of the batch. A REPLACE that is
+ * followed by another REPLACE of the same prefix is skipped, as the latter
+ * overrides whatever the former programmed. A REPLACE followed by the DEL
+ * of the same route is remembered, whether the pair can be skipped depends
+ * on the router state when the REPLACE is reached.
+ */
+static void
+mlxsw_sp_router_fib4_events_coalesce(struct mlxsw_sp_router *router,
+				     struct list_head *fib_event_queue)
+{
+	struct mlxsw_sp_fib_event_work *fib_work, *prev;
+	struct fib_entry_notifier_info *fen_info;
+	u32 key;
+
+	hash_init(router->fib_event_ht);
+
+	list_for_each_entry(fib_work, fib_event_queue, list) {
+		if (fib_work->family != AF_INET ||
+		    (fib_work->event != FIB_EVENT_ENTRY_REPLACE &&
+		     fib_work->event != FIB_EVENT_ENTRY_DEL))
+			continue;
+
+		fen_info = &fib_work->fen_info;
+		key = jhash_3words(fen_info->dst, fen_info->dst_len,
+				   fen_info->tb_id, 0);
+
+		hash_for_each_possible(router->fib_event_ht, prev, ht_node, key) {
+			if (!mlxsw_sp_fib4_event_same_prefix(&prev->fen_info,
+							     fen_info))
+				continue;
+
+			hash_del(&prev->ht_node);
+			if (prev->event != FIB_EVENT_ENTRY_REPLACE)
+				break;
+
+			if (fib_work->event == FIB_EVENT_ENTRY_REPLACE)
+				prev->coalesced = true;
+			else if (prev->fen_info.fi == fen_info->fi &&
+				 prev->fen_info.type == fen_info->type &&
+				 prev->fen_info.dscp == fen_info->dscp)
+				prev->cancel = fib_work;
+			break;
+		}
+
+		hash_add(router->fib_event_ht, &fib_work->ht_node, key);
+	}
+}
+
+#define MLXSW_SP_FIB_EVENT_BATCH 4096
+
+static void mlxsw_sp_router_fib_event_work(struct work_struct *work)
+{
+	struct mlxsw_sp_router *router =
+		container_of(work, struct mlxsw_sp_router, fib_event_work);
+	struct mlxsw_sp_fib_event_work *fib_work, *tmp;
+	struct mlxsw_sp *mlxsw_sp = router->mlxsw_sp;
+	LIST_HEAD(fib_event_queue);
+	unsigned int count;
+	bool more;
+
+	/* Drain the whole queue from this work item, so that flushing the
+	 * ordered workqueue is enough to get all queued events processed.
+	 */
+	do {
+		count = 0;
+		spin_lock_bh(&router->fib_event_queue_lock);
+		list_for_each_entry_safe(fib_work, tmp, &router->fib_event_queue,
+					 list) {
+			list_move_tail(&fib_work->list, &fib_event_queue);
+			if (++count == MLXSW_SP_FIB_EVENT_BATCH)
+				break;
+		}
+		more = !list_empty(&router->fib_event_queue);
+		spin_unlock_bh(&router->fib_event_queue_lock);
+
+		mutex_lock(&router->lock);
+		mlxsw_sp_router_fib4_events_coalesce(router, &fib_event_queue);
+		mlxsw_sp_span_respin(mlxsw_sp);
+		mlxsw_sp_fib_entry_op_ctx_bulk_begin(mlxsw_sp);
+
+		list_for_each_entry_safe(fib_work, tmp, &fib_event_queue, list) {
+			list_del(&fib_work->list);
+			if (fib_work->family == AF_INET)
+				mlxsw_sp_router_fib4_event_process(mlxsw_sp,
+								   fib_work);
+			else
+				mlxsw_sp_router_fib6_event_process(mlxsw_sp,
+								   fib_work);
+			kfree(fib_work);
+			cond_resched();
+		}
+
+		mlxsw_sp_fib_entry_op_ctx_bulk_end(mlxsw_sp);
+		mutex_unlock(&router->lock);
+	} while (more);
 }
 
 static void mlxsw_sp_router_fibmr_event_work(struct work_struct *work)
@@ -8141,14 +8456,13 @@ static int mlxsw_sp_router_fib_event(struct notifier_block *nb,
 
 	fib_work->mlxsw_sp = router->mlxsw_sp;
 	fib_work->event = event;
+	fib_work->family = info->family;
 
 	switch (info->family) {
 	case AF_INET:
-		INIT_WORK(&fib_work->work, mlxsw_sp_router_fib4_event_work);
 		mlxsw_sp_router_fib4_event(fib_work, info);
 		break;
 	case AF_INET6:
-		INIT_WORK(&fib_work->work, mlxsw_sp_router_fib6_event_work);
 		err = mlxsw_sp_router_fib6_event(fib_work, info);
 		if (err)
 			goto err_fib_event;
@@ -8157,10 +8471,14 @@ static int mlxsw_sp_router_fib_event(struct notifier_block *nb,
 	case RTNL_FAMILY_IPMR:
 		INIT_WORK(&fib_work->work, mlxsw_sp_router_fibmr_event_work);
 		mlxsw_sp_router_fibmr_event(fib_work, info);
-		break;
+		mlxsw_core_schedule_work(&fib_work->work);
+		return NOTIFY_DONE;
 	}
 
-	mlxsw_core_schedule_work(&fib_work->work);
+	spin_lock_bh(&router->fib_event_queue_lock);
+	list_add_tail(&fib_work->list, &router->fib_event_queue);
+	spin_unlock_bh(&router->fib_event_queue_lock);
+	mlxsw_core_schedule_work(&router->fib_event_work);
 
 	return NOTIFY_DONE;
 
@@ -11634,6 +11952,10 @@ int mlxsw_sp_router_init(struct mlxsw_sp *mlxsw_sp,
 	mutex_init(&router->lock);
 	mlxsw_sp->router = router;
 	router->mlxsw_sp = mlxsw_sp;
+	INIT_LIST_HEAD(&router->ll_op_ctx.bulk_list);
+	INIT_LIST_HEAD(&router->fib_event_queue);
+	spin_lock_init(&router->fib_event_queue_lock);
+	INIT_WORK(&router->fib_event_work, mlxsw_sp_router_fib_event_work);
 
 	err = mlxsw_sp->router_ops->init(mlxsw_sp);
 	if (err)
@@ -11642,6 +11964,8 @@ int mlxsw_sp_router_init(struct mlxsw_sp *mlxsw_sp,
 	INIT_LIST_HEAD(&mlxsw_sp->router->nh_res_grp_list);
 	INIT_DELAYED_WORK(&mlxsw_sp->router->nh_grp_activity_dw,
 			  mlxsw_sp_nh_grp_activity_work);
+	INIT_DELAYED_WORK(&mlxsw_sp->router->adj_compact_dw,
+			  mlxsw_sp_adj_compact_work);
 	INIT_LIST_HEAD(&mlxsw_sp->router->nexthop_neighs_list);
 	err = __mlxsw_sp_router_init(mlxsw_sp);
 	if (err)
@@ -11748,6 +12072,9 @@ int mlxsw_sp_router_init(struct mlxsw_sp *mlxsw_sp,
 	if (err)
 		goto err_register_fib_notifier;
 
+	mlxsw_sp_adj_compact_work_schedule(mlxsw_sp,
+					   MLXSW_SP_ADJ_COMPACT_INTERVAL);
+
 	return 0;
 
 err_register_fib_notifier:
@@ -11804,6 +12131,7 @@ void mlxsw_sp_router_fini(struct mlxsw_sp *mlxsw_sp)
 {
 	struct mlxsw_sp_router *router = mlxsw_sp->router;
 
+	cancel_delayed_work_sync(&router->adj_compact_dw);
 	unregister_fib_notifier(mlxsw_sp_net(mlxsw_sp), &router->fib_nb);
 	unregister_nexthop_notifier(mlxsw_sp_net(mlxsw_sp),
 				    &router->nexthop_nb);
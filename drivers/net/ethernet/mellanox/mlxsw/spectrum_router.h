@@ -4,6 +4,8 @@
 #ifndef _MLXSW_ROUTER_H_
 #define _MLXSW_ROUTER_H_
 
+#include <linux/hashtable.h>
+
 #include "spectrum.h"
 #include "reg.h"
 
@@ -15,6 +17,17 @@ struct mlxsw_sp_router_nve_decap {
 	u8 valid:1;
 };
 
+/* While bulk is set, RALUE writes are queued on bulk_list and only waited
+ * for once bulk_count reaches a limit or the batch of FIB events is done.
+ */
+struct mlxsw_sp_fib_entry_op_ctx {
+	struct list_head bulk_list;
+	unsigned int bulk_count;
+	bool bulk;
+};
+
+#define MLXSW_SP_FIB_EVENT_HT_BITS 10
+
 /* gen_pool_alloc() returns 0 when allocation fails, so use an offset */
 #define MLXSW_SP_ROUTER_GENALLOC_OFFSET 0x100
 
@@ -59,12 +72,17 @@ struct mlxsw_sp_router {
 	const struct mlxsw_sp_ipip_ops **ipip_ops_arr;
 	struct mlxsw_sp_router_nve_decap nve_decap_config;
 	struct mutex lock; /* Protects shared router resources */
-	struct mlxsw_sp_fib_entry_op_ctx *ll_op_ctx;
+	struct mlxsw_sp_fib_entry_op_ctx ll_op_ctx;
+	struct list_head fib_event_queue;
+	spinlock_t fib_event_queue_lock; /* Protects fib_event_queue */
+	struct work_struct fib_event_work;
+	DECLARE_HASHTABLE(fib_event_ht, MLXSW_SP_FIB_EVENT_HT_BITS);
 	struct mlxsw_sp_crif *lb_crif;
 	const struct mlxsw_sp_adj_grp_size_range *adj_grp_size_ranges;
 	size_t adj_grp_size_ranges_count;
 	struct delayed_work nh_grp_activity_dw;
 	struct list_head nh_res_grp_list;
+	struct delayed_work adj_compact_dw;
 	bool inc_parsing_depth;
 	refcount_t num_groups;
 	u32 adj_trap_index;
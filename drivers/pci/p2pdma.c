@@ -55,10 +55,8 @@ static ssize_t size_show(struct device *dev, struct device_attribute *attr,
 }
 static DEVICE_ATTR_RO(size);
 
-static ssize_t available_show(struct device *dev, struct device_attribute *attr,
-			      char *buf)
+static size_t pci_p2pmem_available(struct pci_dev *pdev)
 {
-	struct pci_dev *pdev = to_pci_dev(dev);
 	struct pci_p2pdma *p2pdma;
 	size_t avail = 0;
 
@@ -68,7 +66,13 @@ static ssize_t available_show(struct device *dev, struct device_attribute *attr,
 		avail = gen_pool_avail(p2pdma->pool);
 	rcu_read_unlock();
 
-	return sysfs_emit(buf, "%zd\n", avail);
+	return avail;
+}
+
+static ssize_t available_show(struct device *dev, struct device_attribute *attr,
+			      char *buf)
+{
+	return sysfs_emit(buf, "%zd\n", pci_p2pmem_available(to_pci_dev(dev)));
 }
 static DEVICE_ATTR_RO(available);
 
@@ -753,7 +757,9 @@ EXPORT_SYMBOL_GPL(pci_has_p2pmem);
  * client devices in use will be chosen first. (So if one of the providers is
  * the same as one of the clients, that provider will be used ahead of any
  * other providers that are unrelated). If multiple providers are an equal
- * distance away, one will be chosen at random.
+ * distance away, the one with the most unallocated p2pmem is preferred, then
+ * the one with the most available link bandwidth; any remaining tie is broken
+ * at random.
  *
  * Returns a pointer to the PCI device with a reference taken (use pci_dev_put
  * to return the reference) or NULL if no compatible device is found. The
@@ -765,8 +771,10 @@ struct pci_dev *pci_p2pmem_find_many(struct device **clients, int num_clients)
 	int distance;
 	int closest_distance = INT_MAX;
 	struct pci_dev **closest_pdevs;
-	int dev_cnt = 0;
+	int dev_cnt = 0, best_cnt = 0;
 	const int max_devs = PAGE_SIZE / sizeof(*closest_pdevs);
+	size_t avail, best_avail = 0;
+	u32 bw, best_bw = 0;
 	int i;
 
 	closest_pdevs = kmalloc(PAGE_SIZE, GFP_KERNEL);
@@ -796,8 +804,28 @@ struct pci_dev *pci_p2pmem_find_many(struct device **clients, int num_clients)
 		closest_pdevs[dev_cnt++] = pci_dev_get(pdev);
 	}
 
-	if (dev_cnt)
-		pdev = pci_dev_get(closest_pdevs[get_random_u32_below(dev_cnt)]);
+	/*
+	 * Move the providers with the most free memory, and among those the
+	 * widest upstream link, to the front of the array.
+	 */
+	for (i = 0; i < dev_cnt; i++) {
+		avail = pci_p2pmem_available(closest_pdevs[i]);
+		bw = pcie_bandwidth_available(closest_pdevs[i], NULL, NULL, NULL);
+		if (avail < best_avail || (avail == best_avail && bw < best_bw))
+			continue;
+
+		if (avail > best_avail || bw > best_bw) {
+			best_avail = avail;
+			best_bw = bw;
+			best_cnt = 0;
+		}
+
+		swap(closest_pdevs[best_cnt], closest_pdevs[i]);
+		best_cnt++;
+	}
+
+	if (best_cnt)
+		pdev = pci_dev_get(closest_pdevs[get_random_u32_below(best_cnt)]);
 
 	for (i = 0; i < dev_cnt; i++)
 		pci_dev_put(closest_pdevs[i]);
@@ -10,6 +10,8 @@
 #include <linux/pci-acpi.h>
 #include <linux/msi.h>
 #include <linux/bitfield.h>
+#include <linux/interrupt.h>
+#include <linux/irq.h>
 #include <linux/pci-tph.h>
 
 #include "pci.h"
@@ -369,6 +371,136 @@ int pcie_tph_set_st_entry(struct pci_dev *pdev, unsigned int index, u16 tag)
 }
 EXPORT_SYMBOL(pcie_tph_set_st_entry);
 
+/**
+ * pcie_tph_set_cpu_st() - Point an ST table entry at a specific CPU
+ * @pdev: PCI device
+ * @index: ST table entry index
+ * @mem_type: target memory type (volatile or persistent RAM)
+ * @cpu: CPU that consumes the data written through this entry
+ *
+ * Look up the Steering Tag for @cpu and write it into the ST entry pointed
+ * by @index. Drivers that know which CPU will consume a queue, e.g. the CPU
+ * a polling thread currently runs on, can call this whenever that changes.
+ *
+ * Return: 0 if success, otherwise negative value (-errno)
+ */
+int pcie_tph_set_cpu_st(struct pci_dev *pdev, unsigned int index,
+			enum tph_mem_type mem_type, unsigned int cpu)
+{
+	u16 tag;
+	int err;
+
+	err = pcie_tph_get_cpu_st(pdev, mem_type, cpu, &tag);
+	if (err)
+		return err;
+
+	return pcie_tph_set_st_entry(pdev, index, tag);
+}
+EXPORT_SYMBOL(pcie_tph_set_cpu_st);
+
+struct tph_irq_notify {
+	struct irq_affinity_notify notify;
+	struct pci_dev *pdev;
+	unsigned int index;
+	enum tph_mem_type mem_type;
+};
+
+static void tph_irq_affinity_notify(struct irq_affinity_notify *notify,
+				    const cpumask_t *mask)
+{
+	struct tph_irq_notify *tn = container_of(notify, struct tph_irq_notify,
+						 notify);
+	unsigned int cpu = cpumask_first(mask);
+	int err;
+
+	if (cpu >= nr_cpu_ids)
+		return;
+
+	err = pcie_tph_set_cpu_st(tn->pdev, tn->index, tn->mem_type, cpu);
+	if (err)
+		pci_dbg(tn->pdev, "failed to retarget ST entry %u to CPU %u: %d\n",
+			tn->index, cpu, err);
+}
+
+static void tph_irq_affinity_release(struct kref *ref)
+{
+	struct irq_affinity_notify *notify =
+		container_of(ref, struct irq_affinity_notify, kref);
+	struct tph_irq_notify *tn = container_of(notify, struct tph_irq_notify,
+						 notify);
+
+	pci_dev_put(tn->pdev);
+	kfree(tn);
+}
+
+/**
+ * pcie_tph_irq_track_affinity() - Keep an ST entry in sync with IRQ affinity
+ * @pdev: PCI device
+ * @index: ST table entry index
+ * @irq: Linux IRQ number whose affinity the entry should follow
+ * @mem_type: target memory type (volatile or persistent RAM)
+ *
+ * Program the ST entry pointed by @index with the Steering Tag of the first
+ * CPU in the current affinity of @irq, and rewrite it every time the
+ * affinity of @irq changes afterwards, e.g. when irqbalance moves the
+ * interrupt. Typically @index is the MSI-X vector whose interrupt signals
+ * the completion of the DMA writes being steered.
+ *
+ * The tracking must be stopped with pcie_tph_irq_untrack_affinity() before
+ * the IRQ is freed.
+ *
+ * Return: 0 if success, otherwise negative value (-errno)
+ */
+int pcie_tph_irq_track_affinity(struct pci_dev *pdev, unsigned int index,
+				unsigned int irq, enum tph_mem_type mem_type)
+{
+	const struct cpumask *mask;
+	struct tph_irq_notify *tn;
+	int err;
+
+	if (!pdev->tph_enabled)
+		return -EINVAL;
+
+	tn = kzalloc(sizeof(*tn), GFP_KERNEL);
+	if (!tn)
+		return -ENOMEM;
+
+	tn->pdev = pci_dev_get(pdev);
+	tn->index = index;
+	tn->mem_type = mem_type;
+	tn->notify.notify = tph_irq_affinity_notify;
+	tn->notify.release = tph_irq_affinity_release;
+
+	/*
+	 * Program the entry before the notifier is installed so the initial
+	 * write can't race with one issued from the notifier work.
+	 */
+	mask = irq_get_affinity_mask(irq);
+	if (mask)
+		tph_irq_affinity_notify(&tn->notify, mask);
+
+	err = irq_set_affinity_notifier(irq, &tn->notify);
+	if (err) {
+		pci_dev_put(pdev);
+		kfree(tn);
+	}
+
+	return err;
+}
+EXPORT_SYMBOL(pcie_tph_irq_track_affinity);
+
+/**
+ * pcie_tph_irq_untrack_affinity() - Stop following IRQ affinity
+ * @irq: Linux IRQ number passed to pcie_tph_irq_track_affinity()
+ *
+ * The ST entry keeps the last tag written to it.
+ */
+void pcie_tph_irq_untrack_affinity(unsigned int irq)
+{
+	irq_set_affinity_notifier(irq, NULL);
+}
+EXPORT_SYMBOL(pcie_tph_irq_untrack_affinity);
+
 /**
  * pcie_disable_tph - Turn off TPH support for device
  * @pdev: PCI device
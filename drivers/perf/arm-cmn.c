@@ -104,6 +104,7 @@
 #define CMN__PMEVCNT0_GLOBAL_NUM	GENMASK_ULL(18, 16)
 #define CMN__PMEVCNTn_GLOBAL_NUM_SHIFT(n)	((n) * 4)
 #define CMN__PMEVCNT_PAIRED(n)		BIT(4 + (n))
+#define CMN__PMEVCNT_PAIRED_ALL		GENMASK(7, 4)
 #define CMN__PMEVCNT23_COMBINED		BIT(2)
 #define CMN__PMEVCNT01_COMBINED		BIT(1)
 #define CMN_DTM_PMU_CONFIG_PMU_EN	BIT(0)
@@ -1863,6 +1864,37 @@ static void arm_cmn_event_clear(struct arm_cmn *cmn, struct perf_event *event,
 		cmn->dtc[j].counters[idx] = NULL;
 }
 
+/*
+ * Events which don't fit are multiplexed by the core rotating the event
+ * lists, so add() failing is the common case once the mesh is oversubscribed.
+ * Check for free DTM counters and watchpoints up front, so that a mesh-wide
+ * event which is going to fail doesn't program (and then clear again) the
+ * DTMs of every node before it finds a full one. Nodes sharing a DTM are
+ * only counted while they're adjacent, which is all we need for this to
+ * never fail an event which would have fit.
+ */
+static bool arm_cmn_event_fits(struct arm_cmn *cmn, struct perf_event *event)
+{
+	struct arm_cmn_hw_event *hw = to_cmn_hw(event);
+	enum cmn_node_type type = CMN_EVENT_TYPE(event);
+	struct arm_cmn_dtm *dtm, *prev = NULL;
+	struct arm_cmn_node *dn;
+	unsigned int i, needed = 0;
+
+	for_each_hw_dn(hw, dn, i) {
+		dtm = &cmn->dtms[dn->dtm] + hw->dtm_offset;
+		needed = dtm == prev ? needed + 1 : 1;
+		prev = dtm;
+
+		if (needed + hweight32(dtm->pmu_config_low & CMN__PMEVCNT_PAIRED_ALL) >
+		    CMN_DTM_NUM_COUNTERS)
+			return false;
+		if (type == CMN_TYPE_WP && arm_cmn_find_free_wp_idx(dtm, event) < 0)
+			return false;
+	}
+	return true;
+}
+
 static int arm_cmn_event_add(struct perf_event *event, int flags)
 {
 	struct arm_cmn *cmn = to_cmn(event->pmu);
@@ -1884,6 +1916,9 @@ static int arm_cmn_event_add(struct perf_event *event, int flags)
 		return 0;
 	}
 
+	if (!arm_cmn_event_fits(cmn, event))
+		return -ENOSPC;
+
 	/* Grab the global counters first... */
 	for_each_hw_dtc_idx(hw, j, idx) {
 		if (cmn->part == PART_CMN600 && j > 0) {
@@ -19,6 +19,7 @@
 #include <linux/export.h>
 #include <linux/pm_opp.h>
 #include <linux/pm_qos.h>
+#include <linux/sched.h>
 #include <linux/slab.h>
 #include <linux/thermal.h>
 #include <linux/units.h>
@@ -260,6 +261,34 @@ static int cpufreq_get_requested_power(struct thermal_cooling_device *cdev,
 	return 0;
 }
 
+/**
+ * cpufreq_get_requested_perf() - get the performance delivered by the cpus
+ * @cdev:	&thermal_cooling_device pointer
+ * @perf:	pointer in which to store the resulting performance
+ *
+ * Express the work done by the cpus since the last call to
+ * cpufreq_get_requested_power() in capacity units: every cpu running at
+ * full load and the maximum frequency contributes SCHED_CAPACITY_SCALE.
+ *
+ * Return: 0 on success, -EINVAL if the maximum frequency is unknown.
+ */
+static int cpufreq_get_requested_perf(struct thermal_cooling_device *cdev,
+				      u32 *perf)
+{
+	struct cpufreq_cooling_device *cpufreq_cdev = cdev->devdata;
+	struct cpufreq_policy *policy = cpufreq_cdev->policy;
+	unsigned int max_freq = policy->cpuinfo.max_freq;
+	u64 work;
+
+	if (!max_freq)
+		return -EINVAL;
+
+	work = (u64)cpufreq_cdev->last_load * cpufreq_quick_get(policy->cpu);
+	*perf = div_u64(work * SCHED_CAPACITY_SCALE, (u64)max_freq * 100);
+
+	return 0;
+}
+
 /**
  * cpufreq_state2power() - convert a cpu cdev state to power consumed
  * @cdev:	&thermal_cooling_device pointer
@@ -571,6 +600,7 @@ __cpufreq_cooling_register(struct device_node *np,
 		cooling_ops->get_requested_power = cpufreq_get_requested_power;
 		cooling_ops->state2power = cpufreq_state2power;
 		cooling_ops->power2state = cpufreq_power2state;
+		cooling_ops->get_requested_perf = cpufreq_get_requested_perf;
 	} else
 #endif
 	if (policy->freq_table_sorted == CPUFREQ_TABLE_UNSORTED) {
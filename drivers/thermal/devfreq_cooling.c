@@ -262,6 +262,37 @@ static int devfreq_cooling_get_requested_power(struct thermal_cooling_device *cd
 	return res;
 }
 
+static int devfreq_cooling_get_requested_perf(struct thermal_cooling_device *cdev,
+					      u32 *perf)
+{
+	struct devfreq_cooling_device *dfc = cdev->devdata;
+	struct devfreq *df = dfc->devfreq;
+	struct devfreq_dev_status status;
+	struct em_perf_state *table;
+	unsigned long max_freq;
+
+	/* Energy Model frequencies are in kHz */
+	rcu_read_lock();
+	table = em_perf_state_from_pd(dfc->em_pd);
+	max_freq = table[dfc->max_state].frequency * 1000;
+	rcu_read_unlock();
+
+	if (!max_freq)
+		return -EINVAL;
+
+	mutex_lock(&df->lock);
+	status = df->last_status;
+	mutex_unlock(&df->lock);
+
+	/* busy_time is scaled to 1024 for a fully loaded device */
+	_normalize_load(&status);
+
+	*perf = div_u64((u64)status.busy_time * status.current_frequency,
+			max_freq);
+
+	return 0;
+}
+
 static int devfreq_cooling_state2power(struct thermal_cooling_device *cdev,
 				       unsigned long state, u32 *power)
 {
@@ -420,6 +451,7 @@ of_devfreq_cooling_register_power(struct device_node *np, struct devfreq *df,
 			devfreq_cooling_get_requested_power;
 		ops->state2power = devfreq_cooling_state2power;
 		ops->power2state = devfreq_cooling_power2state;
+		ops->get_requested_perf = devfreq_cooling_get_requested_perf;
 
 		dfc->power_ops = dfc_power;
 
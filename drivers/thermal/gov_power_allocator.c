@@ -8,8 +8,10 @@
 
 #define pr_fmt(fmt) "Power allocator: " fmt
 
+#include <linux/moduleparam.h>
 #include <linux/slab.h>
 #include <linux/thermal.h>
+#include <linux/units.h>
 
 #define CREATE_TRACE_POINTS
 #include "thermal_trace_ipa.h"
@@ -20,6 +22,19 @@
 #define int_to_frac(x) ((x) << FRAC_BITS)
 #define frac_to_int(x) ((x) >> FRAC_BITS)
 
+/*
+ * When set, the share of the budget requested by each actor is scaled by
+ * how much performance it delivers per watt compared to the other actors
+ * of the zone, so the least efficient block is throttled first.
+ */
+static bool perf_weighted;
+module_param(perf_weighted, bool, 0644);
+MODULE_PARM_DESC(perf_weighted, "Split the power budget by observed performance per watt");
+
+/* Bounds for the performance per watt scaling of the requested power */
+#define PERF_SCALE_MIN	(int_to_frac(1) / 4)
+#define PERF_SCALE_MAX	int_to_frac(4)
+
 /**
  * mul_frac() - multiply two fixed-point numbers
  * @x:	first multiplicand
@@ -53,6 +68,8 @@ static inline s64 div_frac(s64 x, s64 y)
  * @granted_power:	granted power for this actor
  * @extra_actor_power:	extra power that this actor can receive
  * @weighted_req_power:	weighted requested power as input to IPA
+ * @perf:		delivered performance reported by the cooling device
+ * @efficiency:		@perf per watt of @req_power, 0 if unknown
  */
 struct power_actor {
 	u32 req_power;
@@ -60,6 +77,8 @@ struct power_actor {
 	u32 granted_power;
 	u32 extra_actor_power;
 	u32 weighted_req_power;
+	u32 perf;
+	u32 efficiency;
 };
 
 /**
@@ -337,9 +356,9 @@ power_actor_set_power(struct thermal_cooling_device *cdev,
  *
  * This function divides the total allocated power (@power_range)
  * fairly between the actors.  It first tries to give each actor a
- * share of the @power_range according to how much power it requested
- * compared to the rest of the actors.  For example, if only one actor
- * requests power, then it receives all the @power_range.  If
+ * share of the @power_range according to how much weighted power it
+ * requested compared to the rest of the actors.  For example, if only
+ * one actor requests power, then it receives all the @power_range.  If
  * three actors each requests 1mW, each receives a third of the
  * @power_range.
  *
@@ -370,7 +389,7 @@ static void divvy_up_power(struct power_actor *power, int num_actors,
 
 	for (i = 0; i < num_actors; i++) {
 		struct power_actor *pa = &power[i];
-		u64 req_range = (u64)pa->req_power * power_range;
+		u64 req_range = (u64)pa->weighted_req_power * power_range;
 
 		pa->granted_power = DIV_ROUND_CLOSEST_ULL(req_range,
 							  total_req_power);
@@ -403,6 +422,57 @@ static void divvy_up_power(struct power_actor *power, int num_actors,
 	}
 }
 
+/**
+ * perf_weight_actors() - scale the requested power by performance per watt
+ * @tz:			thermal zone the actors belong to
+ * @power:		buffer for all power actors internal power information
+ * @num_actors:		number of valid entries in @power
+ * @total_req_power:	sum of the weighted requested power, updated in place
+ *
+ * Actors that delivered more performance per watt than the zone average
+ * during the last period get a proportionally larger share of the budget,
+ * and the less efficient ones a smaller one.  Actors that do not report
+ * their performance keep their weighted request.
+ */
+static void perf_weight_actors(struct thermal_zone_device *tz,
+			       struct power_actor *power, int num_actors,
+			       u32 *total_req_power)
+{
+	u64 total_efficiency = 0;
+	u32 mean_efficiency;
+	int i, n = 0;
+
+	for (i = 0; i < num_actors; i++) {
+		if (power[i].efficiency) {
+			total_efficiency += power[i].efficiency;
+			n++;
+		}
+	}
+
+	if (!n)
+		return;
+
+	mean_efficiency = div_u64(total_efficiency, n);
+
+	for (i = 0; i < num_actors; i++) {
+		struct power_actor *pa = &power[i];
+		s64 scale;
+
+		if (!pa->efficiency)
+			continue;
+
+		scale = clamp_t(s64, div_frac(pa->efficiency, mean_efficiency),
+				PERF_SCALE_MIN, PERF_SCALE_MAX);
+
+		*total_req_power -= pa->weighted_req_power;
+		pa->weighted_req_power = frac_to_int(scale * pa->weighted_req_power);
+		*total_req_power += pa->weighted_req_power;
+
+		trace_thermal_power_actor_perf(tz, i, pa->perf, pa->efficiency,
+					       pa->weighted_req_power);
+	}
+}
+
 static void allocate_power(struct thermal_zone_device *tz, int control_temp)
 {
 	struct power_allocator_params *params = tz->governor_data;
@@ -448,6 +518,12 @@ static void allocate_power(struct thermal_zone_device *tz, int control_temp)
 		if (ret)
 			continue;
 
+		if (perf_weighted && pa->req_power &&
+		    cdev->ops->get_requested_perf &&
+		    !cdev->ops->get_requested_perf(cdev, &pa->perf))
+			pa->efficiency = div_u64((u64)pa->perf * MILLIWATT_PER_WATT,
+						 pa->req_power);
+
 		total_req_power += pa->req_power;
 		max_allocatable_power += pa->max_power;
 		total_weighted_req_power += pa->weighted_req_power;
@@ -455,6 +531,9 @@ static void allocate_power(struct thermal_zone_device *tz, int control_temp)
 		i++;
 	}
 
+	if (perf_weighted)
+		perf_weight_actors(tz, power, i, &total_weighted_req_power);
+
 	power_range = pid_controller(tz, control_temp, max_allocatable_power);
 
 	divvy_up_power(power, num_actors, total_weighted_req_power,
@@ -65,6 +65,30 @@ TRACE_EVENT(thermal_power_actor,
 		__entry->granted_power)
 );
 
+TRACE_EVENT(thermal_power_actor_perf,
+	TP_PROTO(struct thermal_zone_device *tz, int actor_id, u32 perf,
+		 u32 efficiency, u32 weighted_req_power),
+	TP_ARGS(tz, actor_id, perf, efficiency, weighted_req_power),
+	TP_STRUCT__entry(
+		__field(int, tz_id)
+		__field(int, actor_id)
+		__field(u32, perf)
+		__field(u32, efficiency)
+		__field(u32, weighted_req_power)
+	),
+	TP_fast_assign(
+		__entry->tz_id = tz->id;
+		__entry->actor_id = actor_id;
+		__entry->perf = perf;
+		__entry->efficiency = efficiency;
+		__entry->weighted_req_power = weighted_req_power;
+	),
+
+	TP_printk("thermal_zone_id=%d actor_id=%d perf=%u efficiency=%u weighted_req_power=%u",
+		__entry->tz_id,	__entry->actor_id, __entry->perf,
+		__entry->efficiency, __entry->weighted_req_power)
+);
+
 TRACE_EVENT(thermal_power_allocator_pid,
 	TP_PROTO(struct thermal_zone_device *tz, s32 err, s32 err_integral,
 		 s64 p, s64 i, s64 d, s32 output),
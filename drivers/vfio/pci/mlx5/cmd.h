@@ -86,7 +86,12 @@ struct mlx5vf_save_work_data {
 	u8 chunk_num;
 };
 
-#define MAX_NUM_CHUNKS 2
+/*
+ * Number of stop_copy chunk buffers. The device can SAVE the next chunk as
+ * long as one of them is free, so this bounds how far it may run ahead of
+ * the user reading the data FD.
+ */
+#define MAX_NUM_CHUNKS 4
 
 struct mlx5_vf_migration_file {
 	struct file *filp;
@@ -1318,6 +1318,10 @@ void virtiovf_set_migratable(struct virtiovf_pci_core_device *virtvdev)
 		VFIO_MIGRATION_P2P |
 		VFIO_MIGRATION_PRE_COPY;
 	virtvdev->core_device.vdev.mig_ops = &virtvdev_pci_mig_ops;
+	/*
+	 * No log_ops: the VIRTIO admin command set has no device write
+	 * recording, so dirty pages must come from IOMMUFD dirty tracking.
+	 */
 }
 
 void virtiovf_open_migration(struct virtiovf_pci_core_device *virtvdev)
@@ -18,6 +18,7 @@
 #include <linux/wait.h>
 #include <linux/mm.h>
 #include <linux/page_reporting.h>
+#include <linux/sizes.h>
 
 /*
  * Balloon device works in 4K page units.  So each page is pointed to by
@@ -25,7 +26,17 @@
  * page units.
  */
 #define VIRTIO_BALLOON_PAGES_PER_PAGE (unsigned int)(PAGE_SIZE >> VIRTIO_BALLOON_PFN_SHIFT)
-#define VIRTIO_BALLOON_ARRAY_PFNS_MAX 256
+#define VIRTIO_BALLOON_ARRAY_PFNS_MAX 4096
+/*
+ * Inflate in 2MB blocks while they can be allocated easily, so that the host
+ * can drop whole huge pages, and report free pages from that order on.
+ */
+#define VIRTIO_BALLOON_HUGE_ORDER min_t(unsigned int, get_order(SZ_2M), \
+					pageblock_order)
+#define VIRTIO_BALLOON_HUGE_PAGES \
+	(VIRTIO_BALLOON_PAGES_PER_PAGE << VIRTIO_BALLOON_HUGE_ORDER)
+#define VIRTIO_BALLOON_HUGE_GFP (GFP_HIGHUSER | __GFP_NOMEMALLOC | \
+				 __GFP_NORETRY | __GFP_NOWARN)
 /* Maximum number of (4k) pages to deflate on OOM notifications. */
 #define VIRTIO_BALLOON_OOM_NR_PAGES 256
 #define VIRTIO_BALLOON_OOM_NOTIFY_PRIORITY 80
@@ -99,6 +110,11 @@ struct virtio_balloon {
 	 * to num_pages above.
 	 */
 	struct balloon_dev_info vb_dev_info;
+	/*
+	 * Blocks of VIRTIO_BALLOON_HUGE_ORDER, not movable, each adding
+	 * VIRTIO_BALLOON_HUGE_PAGES to num_pages. Protected by balloon_lock.
+	 */
+	struct list_head huge_pages;
 
 	/* Synchronize access/update to this struct virtio_balloon elements */
 	struct mutex balloon_lock;
@@ -239,18 +255,40 @@ static void set_page_pfns(struct virtio_balloon *vb,
 					  page_to_balloon_pfn(page) + i);
 }
 
+/* Same for all balloon pfns of a VIRTIO_BALLOON_HUGE_ORDER block */
+static void set_huge_page_pfns(struct virtio_balloon *vb,
+			       __virtio32 pfns[], struct page *page)
+{
+	u32 pfn = page_to_balloon_pfn(page);
+	unsigned int i;
+
+	for (i = 0; i < VIRTIO_BALLOON_HUGE_PAGES; i++)
+		pfns[i] = cpu_to_virtio32(vb->vdev, pfn + i);
+}
+
+
 static unsigned int fill_balloon(struct virtio_balloon *vb, size_t num)
 {
 	unsigned int num_allocated_pages;
 	unsigned int num_pfns;
 	struct page *page;
+	LIST_HEAD(huge_pages);
 	LIST_HEAD(pages);
 
 	/* We can only do one array worth at a time. */
 	num = min(num, ARRAY_SIZE(vb->pfns));
 
-	for (num_pfns = 0; num_pfns < num;
-	     num_pfns += VIRTIO_BALLOON_PAGES_PER_PAGE) {
+	/* Whole blocks first, as long as they come without reclaim. */
+	for (num_pfns = 0; num - num_pfns >= VIRTIO_BALLOON_HUGE_PAGES;
+	     num_pfns += VIRTIO_BALLOON_HUGE_PAGES) {
+		page = alloc_pages(VIRTIO_BALLOON_HUGE_GFP,
+				   VIRTIO_BALLOON_HUGE_ORDER);
+		if (!page)
+			break;
+		list_add(&page->lru, &huge_pages);
+	}
+
+	for (; num_pfns < num; num_pfns += VIRTIO_BALLOON_PAGES_PER_PAGE) {
 		struct page *page = balloon_page_alloc();
 
 		if (!page) {
@@ -269,6 +307,18 @@ static unsigned int fill_balloon(struct virtio_balloon *vb, size_t num)
 
 	vb->num_pfns = 0;
 
+	while ((page = list_first_entry_or_null(&huge_pages, struct page,
+						lru))) {
+		list_move(&page->lru, &vb->huge_pages);
+		set_huge_page_pfns(vb, vb->pfns + vb->num_pfns, page);
+		vb->num_pages += VIRTIO_BALLOON_HUGE_PAGES;
+		if (!virtio_has_feature(vb->vdev,
+					VIRTIO_BALLOON_F_DEFLATE_ON_OOM))
+			adjust_managed_page_count(page,
+					-(1L << VIRTIO_BALLOON_HUGE_ORDER));
+		vb->num_pfns += VIRTIO_BALLOON_HUGE_PAGES;
+	}
+
 	while ((page = balloon_page_pop(&pages))) {
 		balloon_page_enqueue(&vb->vb_dev_info, page);
 
@@ -303,12 +353,28 @@ static void release_pages_balloon(struct virtio_balloon *vb,
 	}
 }
 
+static void release_huge_pages_balloon(struct virtio_balloon *vb,
+				       struct list_head *pages)
+{
+	struct page *page, *next;
+
+	list_for_each_entry_safe(page, next, pages, lru) {
+		if (!virtio_has_feature(vb->vdev,
+					VIRTIO_BALLOON_F_DEFLATE_ON_OOM))
+			adjust_managed_page_count(page,
+						  1L << VIRTIO_BALLOON_HUGE_ORDER);
+		list_del(&page->lru);
+		__free_pages(page, VIRTIO_BALLOON_HUGE_ORDER);
+	}
+}
+
 static unsigned int leak_balloon(struct virtio_balloon *vb, size_t num)
 {
 	unsigned int num_freed_pages;
 	struct page *page;
 	struct balloon_dev_info *vb_dev_info = &vb->vb_dev_info;
 	LIST_HEAD(pages);
+	LIST_HEAD(huge_pages);
 
 	/* We can only do one array worth at a time. */
 	num = min(num, ARRAY_SIZE(vb->pfns));
@@ -316,7 +382,19 @@ static unsigned int leak_balloon(struct virtio_balloon *vb, size_t num)
 	mutex_lock(&vb->balloon_lock);
 	/* We can't release more pages than taken */
 	num = min(num, (size_t)vb->num_pages);
-	for (vb->num_pfns = 0; vb->num_pfns < num;
+	vb->num_pfns = 0;
+
+	/* Give back whole blocks while they fit, they are not movable. */
+	while (num - vb->num_pfns >= VIRTIO_BALLOON_HUGE_PAGES &&
+	       (page = list_first_entry_or_null(&vb->huge_pages, struct page,
+						lru))) {
+		list_move(&page->lru, &huge_pages);
+		set_huge_page_pfns(vb, vb->pfns + vb->num_pfns, page);
+		vb->num_pages -= VIRTIO_BALLOON_HUGE_PAGES;
+		vb->num_pfns += VIRTIO_BALLOON_HUGE_PAGES;
+	}
+
+	for (; vb->num_pfns < num;
 	     vb->num_pfns += VIRTIO_BALLOON_PAGES_PER_PAGE) {
 		page = balloon_page_dequeue(vb_dev_info);
 		if (!page)
@@ -326,6 +404,16 @@ static unsigned int leak_balloon(struct virtio_balloon *vb, size_t num)
 		vb->num_pages -= VIRTIO_BALLOON_PAGES_PER_PAGE;
 	}
 
+	/* Only blocks left: give one back rather than nothing, e.g. on OOM. */
+	if (!vb->num_pfns && num &&
+	    (page = list_first_entry_or_null(&vb->huge_pages, struct page,
+					     lru))) {
+		list_move(&page->lru, &huge_pages);
+		set_huge_page_pfns(vb, vb->pfns, page);
+		vb->num_pages -= VIRTIO_BALLOON_HUGE_PAGES;
+		vb->num_pfns = VIRTIO_BALLOON_HUGE_PAGES;
+	}
+
 	num_freed_pages = vb->num_pfns;
 	/*
 	 * Note that if
@@ -335,6 +423,7 @@ static unsigned int leak_balloon(struct virtio_balloon *vb, size_t num)
 	if (vb->num_pfns != 0)
 		tell_host(vb, vb->deflate_vq);
 	release_pages_balloon(vb, &pages);
+	release_huge_pages_balloon(vb, &huge_pages);
 	mutex_unlock(&vb->balloon_lock);
 	return num_freed_pages;
 }
@@ -966,6 +1055,7 @@ static int virtballoon_probe(struct virtio_device *vdev)
 	spin_lock_init(&vb->stop_update_lock);
 	mutex_init(&vb->balloon_lock);
 	init_waitqueue_head(&vb->acked);
+	INIT_LIST_HEAD(&vb->huge_pages);
 	vb->vdev = vdev;
 
 	balloon_devinfo_init(&vb->vb_dev_info);
@@ -1052,17 +1142,15 @@ static int virtballoon_probe(struct virtio_device *vdev)
 		 * corresponds to 512MB in size on ARM64 when 64KB base page
 		 * size is used. The page reporting won't be triggered if the
 		 * freeing page can't come up with a free area like that huge.
-		 * So we specify the page reporting order to 5, corresponding
-		 * to 2MB. It helps to avoid THP splitting if 4KB base page
+		 * So report from 2MB on, which is @pageblock_order with 4KB
+		 * pages. It helps to avoid THP splitting if 4KB base page
 		 * size is used by host.
 		 *
 		 * Ideally, the page reporting order is selected based on the
 		 * host's base page size. However, it needs more work to report
 		 * that value. The hard-coded order would be fine currently.
 		 */
-#if defined(CONFIG_ARM64) && defined(CONFIG_ARM64_64K_PAGES)
-		vb->pr_dev_info.order = 5;
-#endif
+		vb->pr_dev_info.order = VIRTIO_BALLOON_HUGE_ORDER;
 
 		err = page_reporting_register(&vb->pr_dev_info);
 		if (err)
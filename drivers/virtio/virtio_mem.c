@@ -23,6 +23,8 @@
 #include <linux/log2.h>
 #include <linux/vmalloc.h>
 #include <linux/suspend.h>
+#include <linux/sizes.h>
+#include <linux/topology.h>
 
 #include <acpi/acpi_numa.h>
 
@@ -40,6 +42,11 @@ module_param(bbm_block_size, ulong, 0444);
 MODULE_PARM_DESC(bbm_block_size,
 		 "Big Block size in bytes. Default is 0 (auto-detection).");
 
+static bool prefer_bbm;
+module_param(prefer_bbm, bool, 0444);
+MODULE_PARM_DESC(prefer_bbm,
+		"Prefer Big Block Mode with 1 GiB big blocks if the device region is 1 GiB aligned. Default is 0");
+
 /*
  * virtio-mem currently supports the following modes of operation:
  *
@@ -150,6 +157,12 @@ struct virtio_mem {
 	 * least two offline blocks at a time (whatever is bigger).
 	 */
 #define VIRTIO_MEM_DEFAULT_OFFLINE_THRESHOLD		(1024 * 1024 * 1024)
+
+/*
+ * With prefer_bbm, how much memory may be added at once, and so may be
+ * offline, when growing by many big blocks.
+ */
+#define VIRTIO_MEM_BBM_BATCH_SIZE			SZ_16G
 	atomic64_t offline_size;
 	uint64_t offline_threshold;
 
@@ -1851,6 +1864,142 @@ static int virtio_mem_bbm_plug_and_add_bb(struct virtio_mem *vm,
 	return 0;
 }
 
+struct virtio_mem_add_work {
+	struct virtio_mem *vm;
+	uint64_t addr;
+	uint64_t size;
+};
+
+static long virtio_mem_add_memory_fn(void *arg)
+{
+	struct virtio_mem_add_work *w = arg;
+
+	return virtio_mem_add_memory(w->vm, w->addr, w->size);
+}
+
+/*
+ * See virtio_mem_add_memory(): when the memory gets onlined right away, most
+ * of the time goes into initializing its memmap, which lives on the device's
+ * node. Do that from a CPU of the node if there is one.
+ */
+static int virtio_mem_add_memory_local(struct virtio_mem *vm, uint64_t addr,
+				       uint64_t size)
+{
+	struct virtio_mem_add_work w = {
+		.vm = vm,
+		.addr = addr,
+		.size = size,
+	};
+	unsigned int cpu;
+
+	if (vm->nid == NUMA_NO_NODE || vm->nid == numa_node_id())
+		return virtio_mem_add_memory(vm, addr, size);
+
+	/*
+	 * Not holding the CPU hotplug lock, hotplugging memory takes it. If the
+	 * CPU goes away meanwhile, the work just runs elsewhere.
+	 */
+	cpu = cpumask_any_and(cpumask_of_node(vm->nid), cpu_online_mask);
+	if (cpu >= nr_cpu_ids)
+		return virtio_mem_add_memory(vm, addr, size);
+
+	return work_on_cpu(cpu, virtio_mem_add_memory_fn, &w);
+}
+
+/*
+ * The number of consecutive big blocks that fit into a single (un)plug
+ * request, which carries a 16 bit device block count.
+ */
+static unsigned long virtio_mem_bbm_bbs_per_req(struct virtio_mem *vm)
+{
+	const uint64_t max_size = U16_MAX * vm->device_block_size;
+
+	return max_t(uint64_t, 1, max_size / vm->bbm.bb_size);
+}
+
+/*
+ * Unplug consecutive big blocks, as many per request as possible. Big blocks
+ * that could not be unplugged are left plugged, for the main loop to retry.
+ *
+ * Will modify the state of the big blocks.
+ */
+static void virtio_mem_bbm_unplug_bbs(struct virtio_mem *vm,
+				      unsigned long bb_id, unsigned long count)
+{
+	const unsigned long per_req = virtio_mem_bbm_bbs_per_req(vm);
+	enum virtio_mem_bbm_bb_state state;
+	unsigned long i, j, n;
+
+	for (i = 0; i < count; i += n) {
+		n = min(count - i, per_req);
+		state = virtio_mem_send_unplug_request(vm,
+				virtio_mem_bb_id_to_phys(vm, bb_id + i),
+				n * vm->bbm.bb_size) ?
+			VIRTIO_MEM_BBM_BB_PLUGGED : VIRTIO_MEM_BBM_BB_UNUSED;
+		for (j = i; j < i + n; j++)
+			virtio_mem_bbm_set_bb_state(vm, bb_id + j, state);
+	}
+}
+
+/*
+ * Plug consecutive unused big blocks with as few requests as possible. On
+ * error, the big blocks plugged so far are unplugged again.
+ *
+ * Will modify the state of the big blocks.
+ */
+static int virtio_mem_bbm_plug_bbs(struct virtio_mem *vm, unsigned long bb_id,
+				   unsigned long count)
+{
+	const unsigned long per_req = virtio_mem_bbm_bbs_per_req(vm);
+	unsigned long i, n;
+	int rc;
+
+	for (i = 0; i < count; i += n) {
+		n = min(count - i, per_req);
+		rc = virtio_mem_send_plug_request(vm,
+				virtio_mem_bb_id_to_phys(vm, bb_id + i),
+				n * vm->bbm.bb_size);
+		if (rc) {
+			virtio_mem_bbm_unplug_bbs(vm, bb_id, i);
+			return rc;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Plug consecutive unused big blocks and add them to Linux at once.
+ *
+ * Will modify the state of the big blocks.
+ */
+static int virtio_mem_bbm_plug_and_add_bbs(struct virtio_mem *vm,
+					   unsigned long bb_id,
+					   unsigned long count)
+{
+	const uint64_t addr = virtio_mem_bb_id_to_phys(vm, bb_id);
+	const uint64_t size = count * vm->bbm.bb_size;
+	unsigned long i;
+	int rc;
+
+	if (count == 1)
+		return virtio_mem_bbm_plug_and_add_bb(vm, bb_id);
+
+	rc = virtio_mem_bbm_plug_bbs(vm, bb_id, count);
+	if (rc)
+		return rc;
+	for (i = 0; i < count; i++)
+		virtio_mem_bbm_set_bb_state(vm, bb_id + i,
+					    VIRTIO_MEM_BBM_BB_ADDED);
+
+	rc = virtio_mem_add_memory_local(vm, addr, size);
+	if (rc) {
+		/* If still plugged, retry from the main loop. */
+		virtio_mem_bbm_unplug_bbs(vm, bb_id, count);
+		return rc;
+	}
+	return 0;
+}
+
 /*
  * Prepare tracking data for the next big block.
  */
@@ -1895,19 +2044,33 @@ static int virtio_mem_bbm_plug_request(struct virtio_mem *vm, uint64_t diff)
 		cond_resched();
 	}
 
-	/* Try to prepare, plug and add new big blocks */
+	/*
+	 * Try to prepare, plug and add new big blocks. They are consecutive,
+	 * so plug and add as many at once as may be offline.
+	 */
 	while (nb_bb) {
+		unsigned long first_bb_id = 0, count = 0;
+
 		if (!virtio_mem_could_add_memory(vm, vm->bbm.bb_size))
 			return -ENOSPC;
 
-		rc = virtio_mem_bbm_prepare_next_bb(vm, &bb_id);
-		if (rc)
+		while (count < nb_bb &&
+		       virtio_mem_could_add_memory(vm, (count + 1) *
+						   vm->bbm.bb_size)) {
+			rc = virtio_mem_bbm_prepare_next_bb(vm, &bb_id);
+			if (rc)
+				break;
+			if (!count)
+				first_bb_id = bb_id;
+			count++;
+		}
+		if (!count)
 			return rc;
-		rc = virtio_mem_bbm_plug_and_add_bb(vm, bb_id);
-		if (!rc)
-			nb_bb--;
+
+		rc = virtio_mem_bbm_plug_and_add_bbs(vm, first_bb_id, count);
 		if (rc)
 			return rc;
+		nb_bb -= count;
 		cond_resched();
 	}
 
@@ -2534,6 +2697,7 @@ static int virtio_mem_init_hotplug(struct virtio_mem *vm)
 {
 	const struct range pluggable_range = mhp_get_pluggable_range(true);
 	uint64_t unit_pages, sb_size, addr;
+	bool gigantic;
 	int rc;
 
 	/* bad device setup - warn only */
@@ -2559,7 +2723,16 @@ static int virtio_mem_init_hotplug(struct virtio_mem *vm)
 	sb_size = PAGE_SIZE * pageblock_nr_pages;
 	sb_size = max_t(uint64_t, vm->device_block_size, sb_size);
 
-	if (sb_size < memory_block_size_bytes() && !force_bbm) {
+	/*
+	 * With a 1 GiB aligned region, big blocks of 1 GiB take far fewer
+	 * requests and hotplug operations to grow by a lot of memory.
+	 */
+	gigantic = prefer_bbm && !force_bbm && !bbm_block_size &&
+		   IS_ALIGNED(vm->addr | vm->region_size, SZ_1G) &&
+		   vm->device_block_size <= SZ_1G &&
+		   memory_block_size_bytes() <= SZ_1G;
+
+	if (sb_size < memory_block_size_bytes() && !force_bbm && !gigantic) {
 		/* SBM: At least two subblocks per Linux memory block. */
 		vm->in_sbm = true;
 		vm->sbm.sb_size = sb_size;
@@ -2576,7 +2749,9 @@ static int virtio_mem_init_hotplug(struct virtio_mem *vm)
 		vm->bbm.bb_size = max_t(uint64_t, vm->device_block_size,
 					memory_block_size_bytes());
 
-		if (bbm_block_size) {
+		if (gigantic) {
+			vm->bbm.bb_size = SZ_1G;
+		} else if (bbm_block_size) {
 			if (!is_power_of_2(bbm_block_size)) {
 				dev_warn(&vm->vdev->dev,
 					 "bbm_block_size is not a power of 2");
@@ -2597,6 +2772,10 @@ static int virtio_mem_init_hotplug(struct virtio_mem *vm)
 		/* Make sure we can add two big blocks. */
 		vm->offline_threshold = max_t(uint64_t, 2 * vm->bbm.bb_size,
 					      vm->offline_threshold);
+		if (gigantic)
+			vm->offline_threshold = max_t(uint64_t,
+						      VIRTIO_MEM_BBM_BATCH_SIZE,
+						      vm->offline_threshold);
 	}
 
 	dev_info(&vm->vdev->dev, "memory block size: 0x%lx",
@@ -74,6 +74,8 @@ struct vring_desc_state_split {
 	 * allocated together. So we won't stress more to the memory allocator.
 	 */
 	struct vring_desc *indir_desc;
+	u32 total_in_len;		/* Device writable length, for in order. */
+	u16 num;			/* Descriptors used in the ring. */
 };
 
 struct vring_desc_state_packed {
@@ -83,6 +85,7 @@ struct vring_desc_state_packed {
 	 * allocated together. So we won't stress more to the memory allocator.
 	 */
 	struct vring_packed_desc *indir_desc;
+	u32 total_in_len;		/* Device writable length, for in order. */
 	u16 num;			/* Descriptor list length. */
 	u16 last;			/* The last desc state in a list. */
 };
@@ -180,11 +183,24 @@ struct vring_virtqueue {
 	/* Host publishes avail event idx */
 	bool event;
 
+	/* Host uses buffers in the order they were made available */
+	bool in_order;
+
 	/* Head of free buffer list. */
 	unsigned int free_head;
 	/* Number we've added since last sync. */
 	unsigned int num_added;
 
+	/*
+	 * Inside virtqueue_add_batch(): buffers are made available once at
+	 * the end. For the packed ring, the head flags of the first chain are
+	 * held back in add_batch_head and add_batch_flags.
+	 */
+	bool add_batch;
+	bool add_batch_pending;
+	u16 add_batch_head;
+	__le16 add_batch_flags;
+
 	/* Last used index  we've seen.
 	 * for split ring, it just contains last used index
 	 * for packed ring:
@@ -193,6 +209,17 @@ struct vring_virtqueue {
 	 */
 	u16 last_used_idx;
 
+	/*
+	 * In order only: the id and length of the used entry the device
+	 * wrote for a batch of buffers, which is that of the last one. The
+	 * buffers before it are returned first, with their total device
+	 * writable length. UINT_MAX if no batch is being returned.
+	 */
+	unsigned int batch_last_id;
+	u32 batch_last_len;
+	/* Descriptors of the packed batch returned so far. */
+	u16 batch_descs;
+
 	/* Hint for event idx: already triggered no need to disable. */
 	bool event_triggered;
 
@@ -429,6 +456,8 @@ static void virtqueue_init(struct vring_virtqueue *vq, u32 num)
 
 	vq->event_triggered = false;
 	vq->num_added = 0;
+	vq->batch_last_id = UINT_MAX;
+	vq->batch_descs = 0;
 
 #ifdef DEBUG
 	vq->in_use = false;
@@ -436,6 +465,20 @@ static void virtqueue_init(struct vring_virtqueue *vq, u32 num)
 #endif
 }
 
+/*
+ * In order, descriptors (split) or buffer ids (packed) are taken from the free
+ * list in ring order and given back in the same order, so the free list stays
+ * in ring order and never needs relinking. The oldest buffer in use is then
+ * right after the free ones.
+ */
+static unsigned int in_order_oldest(const struct vring_virtqueue *vq,
+				    unsigned int num)
+{
+	unsigned int id = vq->free_head + vq->vq.num_free;
+
+	return id >= num ? id - num : id;
+}
+
 
 /*
  * Split ring specific functions - *_split().
@@ -541,6 +584,7 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 	struct scatterlist *sg;
 	struct vring_desc *desc;
 	unsigned int i, n, avail, descs_used, prev, err_idx;
+	u32 total_in_len = 0;
 	int head;
 	bool indirect;
 
@@ -621,6 +665,7 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 			if (vring_map_one_sg(vq, sg, DMA_FROM_DEVICE, &addr, &len, premapped))
 				goto unmap_release;
 
+			total_in_len += len;
 			prev = i;
 			/* Note that we trust indirect descriptor
 			 * table since it use stream DMA mapping.
@@ -663,6 +708,8 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 
 	/* Store token and indirect buffer state. */
 	vq->split.desc_state[head].data = data;
+	vq->split.desc_state[head].total_in_len = total_in_len;
+	vq->split.desc_state[head].num = descs_used;
 	if (indirect)
 		vq->split.desc_state[head].indir_desc = desc;
 	else
@@ -672,16 +719,22 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 	 * do sync). */
 	avail = vq->split.avail_idx_shadow & (vq->split.vring.num - 1);
 	vq->split.vring.avail->ring[avail] = cpu_to_virtio16(_vq->vdev, head);
+	vq->split.avail_idx_shadow++;
+	vq->num_added++;
+
+	pr_debug("Added buffer head %i to %p\n", head, vq);
+
+	/* virtqueue_add_batch() exposes all of them at once. */
+	if (vq->add_batch) {
+		END_USE(vq);
+		return 0;
+	}
 
 	/* Descriptors and available array need to be set before we expose the
 	 * new available array entries. */
 	virtio_wmb(vq->weak_barriers);
-	vq->split.avail_idx_shadow++;
 	vq->split.vring.avail->idx = cpu_to_virtio16(_vq->vdev,
 						vq->split.avail_idx_shadow);
-	vq->num_added++;
-
-	pr_debug("Added buffer head %i to %p\n", head, vq);
 	END_USE(vq);
 
 	/* This is very unlikely, but theoretically possible.  Kick
@@ -756,6 +809,15 @@ static void detach_buf_split(struct vring_virtqueue *vq, unsigned int head,
 
 	extra = vq->split.desc_extra;
 
+	if (vq->in_order) {
+		/* The free list stays in ring order, just give them back. */
+		if (vq->use_dma_api)
+			for (j = 0, i = head; j < vq->split.desc_state[head].num; j++)
+				i = vring_unmap_one_split(vq, &extra[i]);
+		vq->vq.num_free += vq->split.desc_state[head].num;
+		goto indirect;
+	}
+
 	/* Put back on free list: unmap first-level descriptors and find end */
 	i = head;
 
@@ -772,6 +834,7 @@ static void detach_buf_split(struct vring_virtqueue *vq, unsigned int head,
 	/* Plus final descriptor */
 	vq->vq.num_free++;
 
+indirect:
 	if (vq->indirect) {
 		struct vring_desc *indir_desc =
 				vq->split.desc_state[head].indir_desc;
@@ -866,6 +929,95 @@ static void *virtqueue_get_buf_ctx_split(struct virtqueue *_vq,
 	return ret;
 }
 
+/*
+ * In order, the device may write a single used entry for a batch of buffers,
+ * and the buffers are always used from the oldest one, so there is no need to
+ * look each of them up.
+ */
+static void *virtqueue_get_buf_ctx_split_in_order(struct virtqueue *_vq,
+						  unsigned int *len,
+						  void **ctx)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+	unsigned int num = vq->split.vring.num;
+	unsigned int head, id;
+	bool consumed = true;
+	u16 last_used;
+	void *ret;
+
+	START_USE(vq);
+
+	if (unlikely(vq->broken)) {
+		END_USE(vq);
+		return NULL;
+	}
+
+	head = in_order_oldest(vq, num);
+
+	if (vq->batch_last_id == UINT_MAX) {
+		if (!more_used_split(vq)) {
+			pr_debug("No more buffers in queue\n");
+			END_USE(vq);
+			return NULL;
+		}
+
+		/* Only get used array entries after they have been exposed by host. */
+		virtio_rmb(vq->weak_barriers);
+
+		last_used = (vq->last_used_idx & (num - 1));
+		id = virtio32_to_cpu(_vq->vdev,
+				vq->split.vring.used->ring[last_used].id);
+		*len = virtio32_to_cpu(_vq->vdev,
+				vq->split.vring.used->ring[last_used].len);
+
+		if (unlikely(id >= num)) {
+			BAD_RING(vq, "id %u out of range\n", id);
+			return NULL;
+		}
+		if (unlikely(!vq->split.desc_state[id].data)) {
+			BAD_RING(vq, "id %u is not a head!\n", id);
+			return NULL;
+		}
+
+		if (id != head) {
+			/* The entry covers all buffers up to id. */
+			vq->batch_last_id = id;
+			vq->batch_last_len = *len;
+			*len = vq->split.desc_state[head].total_in_len;
+			consumed = false;
+		}
+	} else if (head == vq->batch_last_id) {
+		*len = vq->batch_last_len;
+		vq->batch_last_id = UINT_MAX;
+	} else {
+		*len = vq->split.desc_state[head].total_in_len;
+		consumed = false;
+	}
+
+	if (unlikely(!vq->split.desc_state[head].data)) {
+		BAD_RING(vq, "id %u is not in use!\n", head);
+		return NULL;
+	}
+
+	/* detach_buf_split clears data, so grab it now. */
+	ret = vq->split.desc_state[head].data;
+	detach_buf_split(vq, head, ctx);
+
+	/* The used entry of a batch is only done with after its last buffer. */
+	if (consumed) {
+		vq->last_used_idx++;
+		if (!(vq->split.avail_flags_shadow & VRING_AVAIL_F_NO_INTERRUPT))
+			virtio_store_mb(vq->weak_barriers,
+					&vring_used_event(&vq->split.vring),
+					cpu_to_virtio16(_vq->vdev, vq->last_used_idx));
+	}
+
+	LAST_ADD_TIME_INVALID(vq);
+
+	END_USE(vq);
+	return ret;
+}
+
 static void virtqueue_disable_cb_split(struct virtqueue *_vq)
 {
 	struct vring_virtqueue *vq = to_vvq(_vq);
@@ -1163,6 +1315,7 @@ static struct virtqueue *__vring_new_virtqueue_split(unsigned int index,
 	vq->indirect = virtio_has_feature(vdev, VIRTIO_RING_F_INDIRECT_DESC) &&
 		!context;
 	vq->event = virtio_has_feature(vdev, VIRTIO_RING_F_EVENT_IDX);
+	vq->in_order = virtio_has_feature(vdev, VIRTIO_F_IN_ORDER);
 
 	if (virtio_has_feature(vdev, VIRTIO_F_ORDER_PLATFORM))
 		vq->weak_barriers = false;
@@ -1320,6 +1473,31 @@ static struct vring_packed_desc *alloc_indirect_packed(unsigned int total_sg,
 	return desc;
 }
 
+/*
+ * Make a chain available by writing the flags of its head. In a batch only
+ * the first chain's head is held back: the device reads the ring in order, so
+ * the chains after it cannot be seen until it is published.
+ */
+static void vring_publish_head_packed(struct vring_virtqueue *vq, u16 head,
+				      __le16 flags)
+{
+	if (vq->add_batch && !vq->add_batch_pending) {
+		vq->add_batch_pending = true;
+		vq->add_batch_head = head;
+		vq->add_batch_flags = flags;
+		return;
+	}
+
+	/*
+	 * A driver MUST NOT make the first descriptor in the list
+	 * available before all subsequent descriptors comprising
+	 * the list are made available.
+	 */
+	if (!vq->add_batch)
+		virtio_wmb(vq->weak_barriers);
+	vq->packed.vring.desc[head].flags = flags;
+}
+
 static int virtqueue_add_indirect_packed(struct vring_virtqueue *vq,
 					 struct scatterlist *sgs[],
 					 unsigned int total_sg,
@@ -1333,6 +1511,7 @@ static int virtqueue_add_indirect_packed(struct vring_virtqueue *vq,
 	struct vring_packed_desc *desc;
 	struct scatterlist *sg;
 	unsigned int i, n, err_idx, len;
+	u32 total_in_len = 0;
 	u16 head, id;
 	dma_addr_t addr;
 
@@ -1365,6 +1544,8 @@ static int virtqueue_add_indirect_packed(struct vring_virtqueue *vq,
 						0 : VRING_DESC_F_WRITE);
 			desc[i].addr = cpu_to_le64(addr);
 			desc[i].len = cpu_to_le32(len);
+			if (n >= out_sgs)
+				total_in_len += len;
 
 			if (unlikely(vq->use_dma_api)) {
 				extra[i].addr = premapped ? DMA_MAPPING_ERROR : addr;
@@ -1396,14 +1577,9 @@ static int virtqueue_add_indirect_packed(struct vring_virtqueue *vq,
 						  vq->packed.avail_used_flags;
 	}
 
-	/*
-	 * A driver MUST NOT make the first descriptor in the list
-	 * available before all subsequent descriptors comprising
-	 * the list are made available.
-	 */
-	virtio_wmb(vq->weak_barriers);
-	vq->packed.vring.desc[head].flags = cpu_to_le16(VRING_DESC_F_INDIRECT |
-						vq->packed.avail_used_flags);
+	vring_publish_head_packed(vq, head,
+				  cpu_to_le16(VRING_DESC_F_INDIRECT |
+					      vq->packed.avail_used_flags));
 
 	/* We're using some buffers from the free list. */
 	vq->vq.num_free -= 1;
@@ -1423,6 +1599,7 @@ static int virtqueue_add_indirect_packed(struct vring_virtqueue *vq,
 	/* Store token and indirect buffer state. */
 	vq->packed.desc_state[id].num = 1;
 	vq->packed.desc_state[id].data = data;
+	vq->packed.desc_state[id].total_in_len = total_in_len;
 	vq->packed.desc_state[id].indir_desc = desc;
 	vq->packed.desc_state[id].last = id;
 
@@ -1459,6 +1636,7 @@ static inline int virtqueue_add_packed(struct virtqueue *_vq,
 	struct vring_packed_desc *desc;
 	struct scatterlist *sg;
 	unsigned int i, n, c, descs_used, err_idx, len;
+	u32 total_in_len = 0;
 	__le16 head_flags, flags;
 	u16 head, id, prev, curr, avail_used_flags;
 	int err;
@@ -1529,6 +1707,8 @@ static inline int virtqueue_add_packed(struct virtqueue *_vq,
 			desc[i].addr = cpu_to_le64(addr);
 			desc[i].len = cpu_to_le32(len);
 			desc[i].id = cpu_to_le16(id);
+			if (n >= out_sgs)
+				total_in_len += len;
 
 			if (unlikely(vq->use_dma_api)) {
 				vq->packed.desc_extra[curr].addr = premapped ?
@@ -1562,16 +1742,11 @@ static inline int virtqueue_add_packed(struct virtqueue *_vq,
 	/* Store token. */
 	vq->packed.desc_state[id].num = descs_used;
 	vq->packed.desc_state[id].data = data;
+	vq->packed.desc_state[id].total_in_len = total_in_len;
 	vq->packed.desc_state[id].indir_desc = ctx;
 	vq->packed.desc_state[id].last = prev;
 
-	/*
-	 * A driver MUST NOT make the first descriptor in the list
-	 * available before all subsequent descriptors comprising
-	 * the list are made available.
-	 */
-	virtio_wmb(vq->weak_barriers);
-	vq->packed.vring.desc[head].flags = head_flags;
+	vring_publish_head_packed(vq, head, head_flags);
 	vq->num_added += descs_used;
 
 	pr_debug("Added buffer head %i to %p\n", head, vq);
@@ -1661,8 +1836,11 @@ static void detach_buf_packed(struct vring_virtqueue *vq,
 	/* Clear data ptr. */
 	state->data = NULL;
 
-	vq->packed.desc_extra[state->last].next = vq->free_head;
-	vq->free_head = id;
+	/* In order, the free list stays in ring order, see in_order_oldest(). */
+	if (!vq->in_order) {
+		vq->packed.desc_extra[state->last].next = vq->free_head;
+		vq->free_head = id;
+	}
 	vq->vq.num_free += state->num;
 
 	if (unlikely(vq->use_dma_api)) {
@@ -1793,6 +1971,99 @@ static void *virtqueue_get_buf_ctx_packed(struct virtqueue *_vq,
 	return ret;
 }
 
+/*
+ * In order, the device may write a single used descriptor for a batch of
+ * buffers, at the position of the first one. last_used_idx stays there until
+ * the last buffer of the batch has been returned, and then skips the
+ * descriptors of the whole batch.
+ */
+static void *virtqueue_get_buf_ctx_packed_in_order(struct virtqueue *_vq,
+						   unsigned int *len,
+						   void **ctx)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+	unsigned int num = vq->packed.vring.num;
+	u16 last_used, id, last_used_idx;
+	bool used_wrap_counter;
+	void *ret;
+
+	START_USE(vq);
+
+	if (unlikely(vq->broken)) {
+		END_USE(vq);
+		return NULL;
+	}
+
+	id = in_order_oldest(vq, num);
+
+	if (vq->batch_last_id == UINT_MAX) {
+		if (!more_used_packed(vq)) {
+			pr_debug("No more buffers in queue\n");
+			END_USE(vq);
+			return NULL;
+		}
+
+		/* Only get used elements after they have been exposed by host. */
+		virtio_rmb(vq->weak_barriers);
+
+		last_used = packed_last_used(READ_ONCE(vq->last_used_idx));
+		vq->batch_last_id = le16_to_cpu(vq->packed.vring.desc[last_used].id);
+		vq->batch_last_len = le32_to_cpu(vq->packed.vring.desc[last_used].len);
+
+		if (unlikely(vq->batch_last_id >= num)) {
+			BAD_RING(vq, "id %u out of range\n", vq->batch_last_id);
+			return NULL;
+		}
+		if (unlikely(!vq->packed.desc_state[vq->batch_last_id].data)) {
+			BAD_RING(vq, "id %u is not a head!\n", vq->batch_last_id);
+			return NULL;
+		}
+	}
+
+	if (unlikely(!vq->packed.desc_state[id].data)) {
+		BAD_RING(vq, "id %u is not in use!\n", id);
+		return NULL;
+	}
+
+	/* detach_buf_packed clears data, so grab it now. */
+	ret = vq->packed.desc_state[id].data;
+	detach_buf_packed(vq, id, ctx);
+
+	if (id != vq->batch_last_id) {
+		*len = vq->packed.desc_state[id].total_in_len;
+		vq->batch_descs += vq->packed.desc_state[id].num;
+		goto out;
+	}
+
+	*len = vq->batch_last_len;
+	vq->batch_last_id = UINT_MAX;
+
+	last_used_idx = READ_ONCE(vq->last_used_idx);
+	used_wrap_counter = packed_used_wrap_counter(last_used_idx);
+	last_used = packed_last_used(last_used_idx);
+
+	last_used += vq->batch_descs + vq->packed.desc_state[id].num;
+	vq->batch_descs = 0;
+	if (unlikely(last_used >= num)) {
+		last_used -= num;
+		used_wrap_counter ^= 1;
+	}
+
+	last_used = (last_used | (used_wrap_counter << VRING_PACKED_EVENT_F_WRAP_CTR));
+	WRITE_ONCE(vq->last_used_idx, last_used);
+
+	if (vq->packed.event_flags_shadow == VRING_PACKED_EVENT_FLAG_DESC)
+		virtio_store_mb(vq->weak_barriers,
+				&vq->packed.vring.driver->off_wrap,
+				cpu_to_le16(vq->last_used_idx));
+
+out:
+	LAST_ADD_TIME_INVALID(vq);
+
+	END_USE(vq);
+	return ret;
+}
+
 static void virtqueue_disable_cb_packed(struct virtqueue *_vq)
 {
 	struct vring_virtqueue *vq = to_vvq(_vq);
@@ -2141,6 +2412,7 @@ static struct virtqueue *__vring_new_virtqueue_packed(unsigned int index,
 	vq->indirect = virtio_has_feature(vdev, VIRTIO_RING_F_INDIRECT_DESC) &&
 		!context;
 	vq->event = virtio_has_feature(vdev, VIRTIO_RING_F_EVENT_IDX);
+	vq->in_order = virtio_has_feature(vdev, VIRTIO_F_IN_ORDER);
 
 	if (virtio_has_feature(vdev, VIRTIO_F_ORDER_PLATFORM))
 		vq->weak_barriers = false;
@@ -2318,6 +2590,123 @@ int virtqueue_add_sgs(struct virtqueue *_vq,
 }
 EXPORT_SYMBOL_GPL(virtqueue_add_sgs);
 
+/**
+ * virtqueue_add_sgs_premapped - expose pre-mapped buffers to other end
+ * @_vq: the struct virtqueue we're talking about.
+ * @sgs: array of terminated scatterlists, with DMA addresses and lengths set.
+ * @out_sgs: the number of scatterlists readable by other side
+ * @in_sgs: the number of scatterlists which are writable (after readable ones)
+ * @data: the token identifying the buffer.
+ * @gfp: how to do memory allocations (if necessary).
+ *
+ * Like virtqueue_add_sgs(), but the buffers were mapped by the caller, e.g.
+ * taken from a virtqueue_dma_pool, and are neither mapped nor unmapped here.
+ *
+ * Caller must ensure we don't call this with other virtqueue operations
+ * at the same time (except where noted).
+ *
+ * Returns zero or a negative error (ie. ENOSPC, ENOMEM, EIO).
+ */
+int virtqueue_add_sgs_premapped(struct virtqueue *_vq,
+				struct scatterlist *sgs[],
+				unsigned int out_sgs,
+				unsigned int in_sgs,
+				void *data,
+				gfp_t gfp)
+{
+	unsigned int i, total_sg = 0;
+
+	/* Count them first. */
+	for (i = 0; i < out_sgs + in_sgs; i++) {
+		struct scatterlist *sg;
+
+		for (sg = sgs[i]; sg; sg = sg_next(sg))
+			total_sg++;
+	}
+	return virtqueue_add(_vq, sgs, total_sg, out_sgs, in_sgs,
+			     data, NULL, true, gfp);
+}
+EXPORT_SYMBOL_GPL(virtqueue_add_sgs_premapped);
+
+/* Expose the buffers added by virtqueue_add_batch() */
+static void virtqueue_publish_batch(struct vring_virtqueue *vq)
+{
+	/* Descriptors and available array need to be set before we expose the
+	 * new available array entries. */
+	virtio_wmb(vq->weak_barriers);
+
+	if (vq->packed_ring) {
+		if (vq->add_batch_pending) {
+			vq->packed.vring.desc[vq->add_batch_head].flags =
+				vq->add_batch_flags;
+			vq->add_batch_pending = false;
+		}
+	} else {
+		vq->split.vring.avail->idx = cpu_to_virtio16(vq->vq.vdev,
+						vq->split.avail_idx_shadow);
+	}
+}
+
+/**
+ * virtqueue_add_batch - expose several buffers to other end at once
+ * @_vq: the struct virtqueue we're talking about.
+ * @bufs: the buffers, as they would be passed to virtqueue_add_sgs()
+ * @num: the number of entries in @bufs
+ * @kick: whether to kick the other end once they are added
+ * @gfp: how to do memory allocations (if necessary).
+ *
+ * Like calling virtqueue_add_sgs() for each of @bufs followed by
+ * virtqueue_kick() if @kick is set, but the buffers are made available to
+ * the device together, with a single barrier.
+ *
+ * Caller must ensure we don't call this with other virtqueue operations
+ * at the same time (except where noted).
+ *
+ * Returns the number of buffers added, which is less than @num if adding
+ * one failed, or the negative error (ie. ENOSPC, ENOMEM, EIO) of the first.
+ */
+int virtqueue_add_batch(struct virtqueue *_vq, struct virtqueue_buf *bufs,
+			unsigned int num, bool kick, gfp_t gfp)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+	unsigned int i, n, total_sg;
+	struct scatterlist *sg;
+	int err = 0;
+
+	/*
+	 * The kick is only done at the end, so make room for as many as
+	 * could be added: num_added has to fit in the event index.
+	 */
+	if (unlikely(vq->num_added + _vq->num_free >= (1 << 16) - 1))
+		virtqueue_kick(_vq);
+
+	vq->add_batch = true;
+	for (i = 0; i < num; i++) {
+		total_sg = 0;
+		for (n = 0; n < bufs[i].out_sgs + bufs[i].in_sgs; n++)
+			for (sg = bufs[i].sgs[n]; sg; sg = sg_next(sg))
+				total_sg++;
+
+		err = virtqueue_add(_vq, bufs[i].sgs, total_sg,
+				    bufs[i].out_sgs, bufs[i].in_sgs,
+				    bufs[i].data, NULL, false, gfp);
+		if (err)
+			break;
+	}
+	vq->add_batch = false;
+
+	if (!i)
+		return err;
+
+	virtqueue_publish_batch(vq);
+
+	if (kick)
+		virtqueue_kick(_vq);
+
+	return i;
+}
+EXPORT_SYMBOL_GPL(virtqueue_add_batch);
+
 /**
  * virtqueue_add_outbuf - expose output buffers to other end
  * @vq: the struct virtqueue we're talking about.
@@ -2537,6 +2926,11 @@ void *virtqueue_get_buf_ctx(struct virtqueue *_vq, unsigned int *len,
 {
 	struct vring_virtqueue *vq = to_vvq(_vq);
 
+	if (vq->in_order)
+		return vq->packed_ring ?
+			virtqueue_get_buf_ctx_packed_in_order(_vq, len, ctx) :
+			virtqueue_get_buf_ctx_split_in_order(_vq, len, ctx);
+
 	return vq->packed_ring ? virtqueue_get_buf_ctx_packed(_vq, len, ctx) :
 				 virtqueue_get_buf_ctx_split(_vq, len, ctx);
 }
@@ -2981,6 +3375,8 @@ void vring_transport_features(struct virtio_device *vdev)
 			break;
 		case VIRTIO_F_ORDER_PLATFORM:
 			break;
+		case VIRTIO_F_IN_ORDER:
+			break;
 		case VIRTIO_F_NOTIFICATION_DATA:
 			break;
 		default:
@@ -3273,5 +3669,152 @@ void virtqueue_dma_sync_single_range_for_device(struct virtqueue *_vq,
 }
 EXPORT_SYMBOL_GPL(virtqueue_dma_sync_single_range_for_device);
 
+/*
+ * A pool of buffers mapped once for the lifetime of the pool, so that drivers
+ * can copy small requests into them and add them premapped instead of having
+ * every buffer mapped and unmapped around each request. That is what costs
+ * most behind an IOMMU or with bounce buffering in confidential guests.
+ */
+struct virtqueue_dma_pool {
+	struct virtqueue *vq;
+	size_t size;
+	enum dma_data_direction dir;
+	spinlock_t lock;
+	struct list_head free;
+	unsigned int num;
+	struct virtqueue_dma_buf bufs[];
+};
+
+/**
+ * virtqueue_dma_pool_create - allocate and map a pool of buffers
+ * @_vq: the struct virtqueue the buffers will be added to.
+ * @num: number of buffers
+ * @size: size of each buffer
+ * @dir: DMA direction of the buffers
+ *
+ * Returns the pool or an ERR_PTR().
+ */
+struct virtqueue_dma_pool *virtqueue_dma_pool_create(struct virtqueue *_vq,
+						     unsigned int num,
+						     size_t size,
+						     enum dma_data_direction dir)
+{
+	struct virtqueue_dma_pool *pool;
+	struct virtqueue_dma_buf *buf;
+	unsigned int i;
+
+	pool = kzalloc(struct_size(pool, bufs, num), GFP_KERNEL);
+	if (!pool)
+		return ERR_PTR(-ENOMEM);
+
+	pool->vq = _vq;
+	pool->size = size;
+	pool->dir = dir;
+	spin_lock_init(&pool->lock);
+	INIT_LIST_HEAD(&pool->free);
+
+	for (i = 0; i < num; i++) {
+		buf = &pool->bufs[i];
+		buf->vaddr = kmalloc(size, GFP_KERNEL);
+		if (!buf->vaddr)
+			goto err;
+
+		buf->addr = virtqueue_dma_map_single_attrs(_vq, buf->vaddr,
+							   size, dir, 0);
+		if (virtqueue_dma_mapping_error(_vq, buf->addr)) {
+			kfree(buf->vaddr);
+			goto err;
+		}
+
+		list_add_tail(&buf->list, &pool->free);
+		pool->num++;
+	}
+
+	return pool;
+
+err:
+	virtqueue_dma_pool_destroy(pool);
+	return ERR_PTR(-ENOMEM);
+}
+EXPORT_SYMBOL_GPL(virtqueue_dma_pool_create);
+
+/**
+ * virtqueue_dma_pool_destroy - unmap and free a pool of buffers
+ * @pool: the pool, may be NULL.
+ *
+ * All buffers must have been returned and the pool's virtqueue must still
+ * exist.
+ */
+void virtqueue_dma_pool_destroy(struct virtqueue_dma_pool *pool)
+{
+	struct virtqueue_dma_buf *buf;
+	unsigned int i;
+
+	if (!pool)
+		return;
+
+	for (i = 0; i < pool->num; i++) {
+		buf = &pool->bufs[i];
+		virtqueue_dma_unmap_single_attrs(pool->vq, buf->addr, pool->size,
+						 pool->dir, 0);
+		kfree(buf->vaddr);
+	}
+	kfree(pool);
+}
+EXPORT_SYMBOL_GPL(virtqueue_dma_pool_destroy);
+
+/**
+ * virtqueue_dma_pool_get - take a buffer from a pool
+ * @pool: the pool
+ *
+ * The caller syncs the buffer with virtqueue_dma_sync_single_range_for_*()
+ * around the device's accesses, as with any premapped buffer.
+ *
+ * Returns a buffer or NULL if all are in use. Can be called from any context.
+ */
+struct virtqueue_dma_buf *virtqueue_dma_pool_get(struct virtqueue_dma_pool *pool)
+{
+	struct virtqueue_dma_buf *buf;
+	unsigned long flags;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	buf = list_first_entry_or_null(&pool->free, struct virtqueue_dma_buf,
+				       list);
+	if (buf)
+		list_del(&buf->list);
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	return buf;
+}
+EXPORT_SYMBOL_GPL(virtqueue_dma_pool_get);
+
+/**
+ * virtqueue_dma_pool_put - give a buffer back to its pool
+ * @pool: the pool
+ * @buf: buffer from virtqueue_dma_pool_get()
+ *
+ * Can be called from any context.
+ */
+void virtqueue_dma_pool_put(struct virtqueue_dma_pool *pool,
+			    struct virtqueue_dma_buf *buf)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	list_add(&buf->list, &pool->free);
+	spin_unlock_irqrestore(&pool->lock, flags);
+}
+EXPORT_SYMBOL_GPL(virtqueue_dma_pool_put);
+
+/**
+ * virtqueue_dma_pool_size - size of the buffers of a pool
+ * @pool: the pool
+ */
+size_t virtqueue_dma_pool_size(struct virtqueue_dma_pool *pool)
+{
+	return pool->size;
+}
+EXPORT_SYMBOL_GPL(virtqueue_dma_pool_size);
+
 MODULE_DESCRIPTION("Virtio ring implementation");
 MODULE_LICENSE("GPL");
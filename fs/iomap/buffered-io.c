@@ -406,11 +406,23 @@ static loff_t iomap_readpage_iter(const struct iomap_iter *iter,
 	    !bio_add_folio(ctx->bio, folio, plen, poff)) {
 		gfp_t gfp = mapping_gfp_constraint(folio->mapping, GFP_KERNEL);
 		gfp_t orig_gfp = gfp;
-		unsigned int nr_vecs = DIV_ROUND_UP(length, PAGE_SIZE);
+		unsigned int nr_vecs;
 
 		if (ctx->bio)
 			submit_bio(ctx->bio);
 
+		/*
+		 * For readahead, size the bio for the rest of the readahead
+		 * window rather than for the current extent.  The bio is
+		 * carried over to the next extent if that one is physically
+		 * contiguous, and we don't want it to fill up at the extent
+		 * boundary.  The block layer splits it to the device limits.
+		 */
+		if (ctx->rac)
+			length = max_t(loff_t, length,
+				       plen + readahead_length(ctx->rac));
+		nr_vecs = DIV_ROUND_UP(length, PAGE_SIZE);
+
 		if (ctx->rac) /* same as readahead_gfp_mask */
 			gfp |= __GFP_NORETRY | __GFP_NOWARN;
 		ctx->bio = bio_alloc(iomap->bdev, bio_max_segs(nr_vecs),
@@ -600,13 +612,28 @@ EXPORT_SYMBOL_GPL(iomap_is_partially_uptodate);
 struct folio *iomap_get_folio(struct iomap_iter *iter, loff_t pos, size_t len)
 {
 	fgf_t fgp = FGP_WRITEBEGIN | FGP_NOFS;
+	struct folio *folio;
 
 	if (iter->flags & IOMAP_NOWAIT)
-		fgp |= FGP_NOWAIT;
+		fgp = (fgp & ~FGP_STABLE) | FGP_NOWAIT;
 	fgp |= fgf_set_order(len);
 
-	return __filemap_get_folio(iter->inode->i_mapping, pos >> PAGE_SHIFT,
+	folio = __filemap_get_folio(iter->inode->i_mapping, pos >> PAGE_SHIFT,
 			fgp, mapping_gfp_mask(iter->inode->i_mapping));
+	if (IS_ERR(folio) || !(iter->flags & IOMAP_NOWAIT))
+		return folio;
+
+	/*
+	 * FGP_STABLE would wait for writeback to finish on devices that need
+	 * stable pages, let the caller retry from a context that can block.
+	 */
+	if (mapping_stable_writes(folio->mapping) &&
+	    folio_test_writeback(folio)) {
+		folio_unlock(folio);
+		folio_put(folio);
+		return ERR_PTR(-EAGAIN);
+	}
+	return folio;
 }
 EXPORT_SYMBOL_GPL(iomap_get_folio);
 
@@ -943,11 +970,13 @@ static loff_t iomap_write_iter(struct iomap_iter *iter, struct iov_iter *i)
 		 * same page as we're writing to, without it being marked
 		 * up-to-date.
 		 *
-		 * For async buffered writes the assumption is that the user
-		 * page has already been faulted in. This can be optimized by
-		 * faulting the user page.
+		 * Faulting in may block, so for async buffered writes rely on
+		 * the user page being present already.  If it is not, the
+		 * atomic copy below comes up short and we return -EAGAIN so
+		 * that the caller retries from a context that can block.
 		 */
-		if (unlikely(fault_in_iov_iter_readable(i, bytes) == bytes)) {
+		if (!(iter->flags & IOMAP_NOWAIT) &&
+		    unlikely(fault_in_iov_iter_readable(i, bytes) == bytes)) {
 			status = -EFAULT;
 			break;
 		}
@@ -999,6 +1028,11 @@ static loff_t iomap_write_iter(struct iomap_iter *iter, struct iov_iter *i)
 			iomap_write_failed(iter->inode, pos, bytes);
 			iov_iter_revert(i, copied);
 
+			if (iter->flags & IOMAP_NOWAIT) {
+				status = -EAGAIN;
+				break;
+			}
+
 			if (chunk > PAGE_SIZE)
 				chunk /= 2;
 			if (copied) {
@@ -1895,6 +1929,47 @@ static int iomap_writepage_map_blocks(struct iomap_writepage_ctx *wpc,
 	return error;
 }
 
+/*
+ * Find the next dirty range of the folio that can be written back together
+ * with the one ending at pos, by also writing the clean blocks in between.
+ *
+ * This skips ->map_blocks for the merged range, which is fine as it has been
+ * called for this folio already and the range is entirely covered by the
+ * mapping it returned.  The gap must be uptodate so that the page cache holds
+ * its data, and the mapping must not be shared, as writing the gap in place
+ * would then modify data owned by another file.
+ */
+static unsigned iomap_writepage_merge_range(struct iomap_writepage_ctx *wpc,
+		struct folio *folio, u64 pos, u64 end_aligned)
+{
+	struct iomap_folio_state *ifs = folio->private;
+	struct inode *inode = folio->mapping->host;
+	unsigned first_blk, last_blk, i;
+	u64 next = pos;
+	unsigned rlen;
+
+	if (!wpc->max_clean_gap || !ifs || !wpc->ioend)
+		return 0;
+	if (wpc->iomap.type != IOMAP_MAPPED ||
+	    (wpc->iomap.flags & IOMAP_F_SHARED))
+		return 0;
+
+	rlen = iomap_find_dirty_range(folio, &next, end_aligned);
+	if (!rlen || next - pos > wpc->max_clean_gap)
+		return 0;
+	if (pos < wpc->iomap.offset ||
+	    next + rlen > wpc->iomap.offset + wpc->iomap.length)
+		return 0;
+
+	first_blk = offset_in_folio(folio, pos) >> inode->i_blkbits;
+	last_blk = offset_in_folio(folio, next) >> inode->i_blkbits;
+	for (i = first_blk; i < last_blk; i++)
+		if (!ifs_block_is_uptodate(ifs, i))
+			return 0;
+
+	return next + rlen - pos;
+}
+
 /*
  * Check interaction of the folio with the file end.
  *
@@ -2009,6 +2084,18 @@ static int iomap_writepage_map(struct iomap_writepage_ctx *wpc,
 		if (error)
 			break;
 		pos += rlen;
+
+		while ((rlen = iomap_writepage_merge_range(wpc, folio, pos,
+				end_aligned))) {
+			error = iomap_add_to_ioend(wpc, wbc, folio, inode, pos,
+					end_pos, rlen);
+			if (error)
+				break;
+			count++;
+			pos += rlen;
+		}
+		if (error)
+			break;
 	}
 
 	if (count)
@@ -20,6 +20,7 @@
  * Private flags for iomap_dio, must not overlap with the public ones in
  * iomap.h:
  */
+#define IOMAP_DIO_POLL_COMP	(1U << 25)
 #define IOMAP_DIO_CALLER_COMP	(1U << 26)
 #define IOMAP_DIO_INLINE_COMP	(1U << 27)
 #define IOMAP_DIO_WRITE_THROUGH	(1U << 28)
@@ -117,7 +118,8 @@ ssize_t iomap_dio_complete(struct iomap_dio *dio)
 	 * ->end_io() when necessary, otherwise a racing buffer read would cache
 	 * zeros from unwritten extents.
 	 */
-	if (!dio->error && dio->size && (dio->flags & IOMAP_DIO_WRITE))
+	if (!dio->error && dio->size && (dio->flags & IOMAP_DIO_WRITE) &&
+	    !(dio->flags & IOMAP_DIO_INLINE_COMP))
 		kiocb_invalidate_post_direct_write(iocb, dio->size);
 
 	inode_dio_end(file_inode(iocb->ki_filp));
@@ -186,6 +188,16 @@ void iomap_dio_bio_end_io(struct bio *bio)
 		goto release_bio;
 	}
 
+	/*
+	 * Polled pure overwrites can also be completed inline when we are
+	 * called from the polling task rather than from interrupt context, as
+	 * long as there is no page cache left to invalidate, which would
+	 * need to sleep.
+	 */
+	if ((dio->flags & IOMAP_DIO_POLL_COMP) && in_task() &&
+	    !file_inode(iocb->ki_filp)->i_mapping->nrpages)
+		dio->flags |= IOMAP_DIO_INLINE_COMP;
+
 	/*
 	 * Flagged with IOMAP_DIO_INLINE_COMP, we can complete it inline
 	 */
@@ -364,14 +376,22 @@ static loff_t iomap_dio_bio_iter(const struct iomap_iter *iter,
 	if (need_zeroout ||
 	    ((dio->flags & IOMAP_DIO_NEED_SYNC) && !use_fua) ||
 	    ((dio->flags & IOMAP_DIO_WRITE) && pos >= i_size_read(inode)))
-		dio->flags &= ~IOMAP_DIO_CALLER_COMP;
+		dio->flags &= ~(IOMAP_DIO_CALLER_COMP | IOMAP_DIO_POLL_COMP);
+
+	/*
+	 * Inline completion additionally rules out COW remapping and any write
+	 * that ends beyond i_size, as the size update may need a transaction.
+	 */
+	if ((dio->flags & IOMAP_DIO_COW) || pos + length > i_size_read(inode))
+		dio->flags &= ~IOMAP_DIO_POLL_COMP;
 
 	/*
 	 * The rules for polled IO completions follow the guidelines as the
 	 * ones we set for inline and deferred completions. If none of those
 	 * are available for this IO, clear the polled flag.
 	 */
-	if (!(dio->flags & (IOMAP_DIO_INLINE_COMP|IOMAP_DIO_CALLER_COMP)))
+	if (!(dio->flags & (IOMAP_DIO_INLINE_COMP | IOMAP_DIO_CALLER_COMP |
+			    IOMAP_DIO_POLL_COMP)))
 		dio->iocb->ki_flags &= ~IOCB_HIPRI;
 
 	if (need_zeroout) {
@@ -639,6 +659,15 @@ __iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 		if (iocb->ki_flags & IOCB_DIO_CALLER_COMP)
 			dio->flags |= IOMAP_DIO_CALLER_COMP;
 
+		/*
+		 * Polled pure overwrites can be completed from the polling
+		 * task if the file system allows it.  Cleared in
+		 * iomap_dio_bio_iter() for anything but pure overwrites.
+		 */
+		if ((iocb->ki_flags & IOCB_HIPRI) &&
+		    (dio_flags & IOMAP_DIO_OVERWRITE_INLINE_COMP))
+			dio->flags |= IOMAP_DIO_POLL_COMP;
+
 		if (dio_flags & IOMAP_DIO_OVERWRITE_ONLY) {
 			ret = -EAGAIN;
 			if (iomi.pos >= dio->i_size ||
@@ -55,6 +55,93 @@ static inline void iomap_iter_done(struct iomap_iter *iter)
 		trace_iomap_iter_srcmap(iter->inode, &iter->srcmap);
 }
 
+void iomap_extent_cache_init(struct iomap_extent_cache *ec)
+{
+	spin_lock_init(&ec->lock);
+	ec->seq = 0;
+	ec->nr = 0;
+	ec->next = 0;
+}
+EXPORT_SYMBOL_GPL(iomap_extent_cache_init);
+
+/**
+ * iomap_extent_cache_invalidate - drop all cached mappings
+ * @ec: extent cache of the inode
+ *
+ * Must be called after the new mapping is visible to ->iomap_begin, so that
+ * a lookup racing with the change can not insert the old mapping again.
+ */
+void iomap_extent_cache_invalidate(struct iomap_extent_cache *ec)
+{
+	spin_lock(&ec->lock);
+	ec->seq++;
+	ec->nr = 0;
+	ec->next = 0;
+	spin_unlock(&ec->lock);
+}
+EXPORT_SYMBOL_GPL(iomap_extent_cache_invalidate);
+
+static bool iomap_extent_cache_lookup(struct iomap_extent_cache *ec,
+		loff_t pos, struct iomap *iomap, unsigned int *seq)
+{
+	bool found = false;
+	unsigned int i;
+
+	spin_lock(&ec->lock);
+	*seq = ec->seq;
+	for (i = 0; i < ec->nr; i++) {
+		const struct iomap *cached = &ec->extents[i];
+
+		if (pos >= cached->offset &&
+		    pos < cached->offset + cached->length) {
+			*iomap = *cached;
+			found = true;
+			break;
+		}
+	}
+	spin_unlock(&ec->lock);
+
+	return found;
+}
+
+static void iomap_extent_cache_insert(struct iomap_extent_cache *ec,
+		const struct iomap *iomap, unsigned int seq)
+{
+	spin_lock(&ec->lock);
+	if (ec->seq == seq) {
+		ec->extents[ec->next] = *iomap;
+		ec->next = (ec->next + 1) % IOMAP_EXTENT_CACHE_NR;
+		if (ec->nr < IOMAP_EXTENT_CACHE_NR)
+			ec->nr++;
+	}
+	spin_unlock(&ec->lock);
+}
+
+static int iomap_iter_begin(struct iomap_iter *iter,
+		const struct iomap_ops *ops)
+{
+	struct iomap_extent_cache *ec = NULL;
+	unsigned int seq;
+	int ret;
+
+	if ((iter->flags & IOMAP_REPORT) && ops->report_cache &&
+	    !ops->iomap_end)
+		ec = ops->report_cache(iter->inode);
+	if (ec && iomap_extent_cache_lookup(ec, iter->pos, &iter->iomap, &seq))
+		return 0;
+
+	ret = ops->iomap_begin(iter->inode, iter->pos, iter->len, iter->flags,
+			       &iter->iomap, &iter->srcmap);
+	if (ret < 0 || !ec)
+		return ret;
+
+	/* Inline data and source mappings point into file system state */
+	if (iter->iomap.type != IOMAP_INLINE &&
+	    iter->srcmap.type == IOMAP_HOLE && iter->iomap.length)
+		iomap_extent_cache_insert(ec, &iter->iomap, seq);
+	return ret;
+}
+
 /**
  * iomap_iter - iterate over a ranges in a file
  * @iter: iteration structue
@@ -87,8 +174,7 @@ int iomap_iter(struct iomap_iter *iter, const struct iomap_ops *ops)
 	if (ret <= 0)
 		return ret;
 
-	ret = ops->iomap_begin(iter->inode, iter->pos, iter->len, iter->flags,
-			       &iter->iomap, &iter->srcmap);
+	ret = iomap_iter_begin(iter, ops);
 	if (ret < 0)
 		return ret;
 	iomap_iter_done(iter);
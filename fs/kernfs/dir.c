@@ -14,6 +14,11 @@
 #include <linux/slab.h>
 #include <linux/security.h>
 #include <linux/hash.h>
+#include <linux/sizes.h>
+#include <linux/uaccess.h>
+#include <uapi/linux/kernfs.h>
+
+#include <asm/sections.h>
 
 #include "kernfs-internal.h"
 
@@ -379,15 +384,16 @@ static int kernfs_link_sibling(struct kernfs_node *kn)
 	}
 
 	/* add new node and rebalance the tree */
-	rb_link_node(&kn->rb, parent, node);
+	kernfs_dir_change_begin(kn->parent);
+	rb_link_node_rcu(&kn->rb, parent, node);
 	rb_insert_color(&kn->rb, &kn->parent->dir.children);
 
 	/* successfully added, account subdir number */
 	down_write(&kernfs_root(kn)->kernfs_iattr_rwsem);
 	if (kernfs_type(kn) == KERNFS_DIR)
 		kn->parent->dir.subdirs++;
-	kernfs_inc_rev(kn->parent);
 	up_write(&kernfs_root(kn)->kernfs_iattr_rwsem);
+	kernfs_dir_change_end(kn->parent);
 
 	return 0;
 }
@@ -410,14 +416,15 @@ static bool kernfs_unlink_sibling(struct kernfs_node *kn)
 	if (RB_EMPTY_NODE(&kn->rb))
 		return false;
 
+	kernfs_dir_change_begin(kn->parent);
 	down_write(&kernfs_root(kn)->kernfs_iattr_rwsem);
 	if (kernfs_type(kn) == KERNFS_DIR)
 		kn->parent->dir.subdirs--;
-	kernfs_inc_rev(kn->parent);
 	up_write(&kernfs_root(kn)->kernfs_iattr_rwsem);
 
 	rb_erase(&kn->rb, &kn->parent->dir.children);
 	RB_CLEAR_NODE(&kn->rb);
+	kernfs_dir_change_end(kn->parent);
 	return true;
 }
 
@@ -867,6 +874,68 @@ static struct kernfs_node *kernfs_find_ns(struct kernfs_node *parent,
 	return NULL;
 }
 
+/**
+ * kernfs_find_and_get_ns_rcu - lockless kernfs_find_ns() and kernfs_get()
+ * @parent: kernfs_node to search under
+ * @name: name to look for
+ * @ns: the namespace tag to use
+ * @revp: if not %NULL, set to the ->dir.rev of @parent the result matches
+ *
+ * Look for @name under @parent without kernfs_rwsem.  Nodes and their names
+ * are freed after an RCU grace period, and rbtree rebalancing never makes a
+ * lookup that only follows child pointers loop, but it can make it miss a
+ * node, so the walk is validated against @parent's ->dir.rev.
+ *
+ * Return: the found kernfs_node with a reference held, or %NULL if there is
+ * none or the walk raced with a change of @parent's children.  Either way,
+ * the caller should fall back to kernfs_find_ns() under kernfs_rwsem.
+ */
+static struct kernfs_node *kernfs_find_and_get_ns_rcu(struct kernfs_node *parent,
+						      const unsigned char *name,
+						      const void *ns,
+						      unsigned long *revp)
+{
+	struct kernfs_node *kn = NULL;
+	struct rb_node *node;
+	unsigned long rev;
+	unsigned int hash;
+
+	/* Leave the warning to kernfs_find_ns() */
+	if (kernfs_ns_enabled(parent) != (bool)ns)
+		return NULL;
+
+	hash = kernfs_name_hash(name, ns);
+
+	rcu_read_lock();
+	rev = kernfs_dir_read_begin(parent);
+	node = rcu_dereference_raw(parent->dir.children.rb_node);
+	while (node) {
+		struct kernfs_node *pos = rb_to_kn(node);
+		int result;
+
+		result = kernfs_name_compare(hash, name, ns, pos);
+		if (result < 0) {
+			node = rcu_dereference_raw(node->rb_left);
+		} else if (result > 0) {
+			node = rcu_dereference_raw(node->rb_right);
+		} else {
+			if (atomic_inc_not_zero(&pos->count))
+				kn = pos;
+			break;
+		}
+	}
+	if (kernfs_dir_read_retry(parent, rev)) {
+		rcu_read_unlock();
+		kernfs_put(kn);
+		return NULL;
+	}
+	rcu_read_unlock();
+
+	if (revp)
+		*revp = rev;
+	return kn;
+}
+
 static struct kernfs_node *kernfs_walk_ns(struct kernfs_node *parent,
 					  const unsigned char *path,
 					  const void *ns)
@@ -915,6 +984,10 @@ struct kernfs_node *kernfs_find_and_get_ns(struct kernfs_node *parent,
 	struct kernfs_node *kn;
 	struct kernfs_root *root = kernfs_root(parent);
 
+	kn = kernfs_find_and_get_ns_rcu(parent, name, ns, NULL);
+	if (kn)
+		return kn;
+
 	down_read(&root->kernfs_rwsem);
 	kn = kernfs_find_ns(parent, name, ns);
 	kernfs_get(kn);
@@ -1111,16 +1184,13 @@ struct kernfs_node *kernfs_create_empty_dir(struct kernfs_node *parent,
 
 static int kernfs_dop_revalidate(struct dentry *dentry, unsigned int flags)
 {
-	struct kernfs_node *kn;
-	struct kernfs_root *root;
+	struct kernfs_node *kn, *parent;
 
 	if (flags & LOOKUP_RCU)
 		return -ECHILD;
 
 	/* Negative hashed dentry? */
 	if (d_really_is_negative(dentry)) {
-		struct kernfs_node *parent;
-
 		/* If the kernfs parent node has changed discard and
 		 * proceed to ->lookup.
 		 *
@@ -1136,17 +1206,15 @@ static int kernfs_dop_revalidate(struct dentry *dentry, unsigned int flags)
 		 * because they are invalidated on containing directory
 		 * changes and the lookup re-done so that a new positive
 		 * dentry can be properly created.
+		 *
+		 * No kernfs_rwsem is needed, ->dir.rev is odd while a change
+		 * is in progress, which also counts as changed.
 		 */
-		root = kernfs_root_from_sb(dentry->d_sb);
-		down_read(&root->kernfs_rwsem);
 		parent = kernfs_dentry_node(dentry->d_parent);
 		if (parent) {
-			if (kernfs_dir_changed(parent, dentry)) {
-				up_read(&root->kernfs_rwsem);
+			if (kernfs_dir_changed(parent, dentry))
 				return 0;
-			}
 		}
-		up_read(&root->kernfs_rwsem);
 
 		/* The kernfs parent node hasn't changed, leave the
 		 * dentry negative and return success.
@@ -1154,31 +1222,36 @@ static int kernfs_dop_revalidate(struct dentry *dentry, unsigned int flags)
 		return 1;
 	}
 
+	/*
+	 * The result is only a snapshot, with or without kernfs_rwsem, so
+	 * check locklessly.  kn->parent and kn->name are freed after an RCU
+	 * grace period once replaced.
+	 */
 	kn = kernfs_dentry_node(dentry);
-	root = kernfs_root(kn);
-	down_read(&root->kernfs_rwsem);
+	rcu_read_lock();
 
 	/* The kernfs node has been deactivated */
-	if (!kernfs_active(kn))
+	if (!__kernfs_active(kn))
 		goto out_bad;
 
 	/* The kernfs node has been moved? */
-	if (kernfs_dentry_node(dentry->d_parent) != kn->parent)
+	parent = READ_ONCE(kn->parent);
+	if (kernfs_dentry_node(dentry->d_parent) != parent)
 		goto out_bad;
 
 	/* The kernfs node has been renamed */
-	if (strcmp(dentry->d_name.name, kn->name) != 0)
+	if (strcmp(dentry->d_name.name, READ_ONCE(kn->name)) != 0)
 		goto out_bad;
 
 	/* The kernfs node has been moved to a different namespace */
-	if (kn->parent && kernfs_ns_enabled(kn->parent) &&
-	    kernfs_info(dentry->d_sb)->ns != kn->ns)
+	if (parent && kernfs_ns_enabled(parent) &&
+	    kernfs_info(dentry->d_sb)->ns != READ_ONCE(kn->ns))
 		goto out_bad;
 
-	up_read(&root->kernfs_rwsem);
+	rcu_read_unlock();
 	return 1;
 out_bad:
-	up_read(&root->kernfs_rwsem);
+	rcu_read_unlock();
 	return 0;
 }
 
@@ -1195,12 +1268,32 @@ static struct dentry *kernfs_iop_lookup(struct inode *dir,
 	struct kernfs_root *root;
 	struct inode *inode = NULL;
 	const void *ns = NULL;
+	unsigned long rev;
 
-	root = kernfs_root(parent);
-	down_read(&root->kernfs_rwsem);
 	if (kernfs_ns_enabled(parent))
 		ns = kernfs_info(dir->i_sb)->ns;
 
+	/*
+	 * Try without kernfs_rwsem first, only a miss or a race with a
+	 * change of @parent's children needs the locked lookup.
+	 */
+	kn = kernfs_find_and_get_ns_rcu(parent, dentry->d_name.name, ns, &rev);
+	if (kn) {
+		if (!__kernfs_active(kn)) {
+			kernfs_put(kn);
+			return NULL;
+		}
+		inode = kernfs_get_inode(dir->i_sb, kn);
+		kernfs_put(kn);
+		if (!inode)
+			inode = ERR_PTR(-ENOMEM);
+		else
+			dentry->d_time = rev;	/* see kernfs_set_rev() */
+		return d_splice_alias(inode, dentry);
+	}
+
+	root = kernfs_root(parent);
+	down_read(&root->kernfs_rwsem);
 	kn = kernfs_find_ns(parent, dentry->d_name.name, ns);
 	/* attach dentry and inode */
 	if (kn) {
@@ -1775,7 +1868,9 @@ int kernfs_rename_ns(struct kernfs_node *kn, struct kernfs_node *new_parent,
 	kernfs_link_sibling(kn);
 
 	kernfs_put(old_parent);
-	kfree_const(old_name);
+	/* Lockless lookups and revalidation may still be looking at it */
+	if (old_name && !is_kernel_rodata((unsigned long)old_name))
+		kvfree_rcu_mightsleep((void *)old_name);
 
 	error = 0;
  out:
@@ -1789,54 +1884,92 @@ static int kernfs_dir_fop_release(struct inode *inode, struct file *filp)
 	return 0;
 }
 
-static struct kernfs_node *kernfs_dir_pos(const void *ns,
-	struct kernfs_node *parent, loff_t hash, struct kernfs_node *pos)
+/*
+ * Find the first child of @parent after the key (@hash, @name, @key_ns) in
+ * rbtree order or, if @name is %NULL, the first one whose hash is at least
+ * @hash.  Only child pointers are followed, so this is safe under RCU, but
+ * may miss nodes if it races with a change of the tree.
+ */
+static struct kernfs_node *kernfs_dir_succ_rcu(struct kernfs_node *parent,
+					       unsigned int hash,
+					       const char *name,
+					       const void *key_ns)
 {
-	if (pos) {
-		int valid = kernfs_active(pos) &&
-			pos->parent == parent && hash == pos->hash;
-		kernfs_put(pos);
-		if (!valid)
-			pos = NULL;
-	}
-	if (!pos && (hash > 1) && (hash < INT_MAX)) {
-		struct rb_node *node = parent->dir.children.rb_node;
-		while (node) {
-			pos = rb_to_kn(node);
-
-			if (hash < pos->hash)
-				node = node->rb_left;
-			else if (hash > pos->hash)
-				node = node->rb_right;
-			else
-				break;
-		}
-	}
-	/* Skip over entries which are dying/dead or in the wrong namespace */
-	while (pos && (!kernfs_active(pos) || pos->ns != ns)) {
-		struct rb_node *node = rb_next(&pos->rb);
-		if (!node)
-			pos = NULL;
+	struct rb_node *node = rcu_dereference_raw(parent->dir.children.rb_node);
+	struct kernfs_node *succ = NULL;
+
+	while (node) {
+		struct kernfs_node *pos = rb_to_kn(node);
+		int result;
+
+		if (name)
+			result = kernfs_name_compare(hash, name, key_ns, pos);
 		else
-			pos = rb_to_kn(node);
+			result = hash <= pos->hash ? -1 : 1;
+
+		if (result < 0) {
+			succ = pos;
+			node = rcu_dereference_raw(node->rb_left);
+		} else {
+			node = rcu_dereference_raw(node->rb_right);
+		}
 	}
-	return pos;
+	return succ;
 }
 
+/*
+ * Find and get the next entry of @parent to emit.  If @pos was @emitted, that
+ * is the first active child in @ns after it, otherwise @pos again if it is
+ * still valid at @hash, or else the first one at or after @hash.  Drops the
+ * reference on @pos.
+ *
+ * This runs without kernfs_rwsem.  The walk is retried if it raced with a
+ * change of @parent's children, so that no entry which stays in the directory
+ * is skipped.
+ */
 static struct kernfs_node *kernfs_dir_next_pos(const void *ns,
-	struct kernfs_node *parent, ino_t ino, struct kernfs_node *pos)
+	struct kernfs_node *parent, loff_t hash, struct kernfs_node *pos,
+	bool emitted)
 {
-	pos = kernfs_dir_pos(ns, parent, ino, pos);
-	if (pos) {
-		do {
-			struct rb_node *node = rb_next(&pos->rb);
-			if (!node)
-				pos = NULL;
-			else
-				pos = rb_to_kn(node);
-		} while (pos && (!kernfs_active(pos) || pos->ns != ns));
+	struct kernfs_node *next;
+	unsigned long rev;
+
+	if (!emitted) {
+		if (pos && __kernfs_active(pos) &&
+		    READ_ONCE(pos->parent) == parent && hash == pos->hash)
+			return pos;
+		kernfs_put(pos);
+		pos = NULL;
+		if (hash <= 1 || hash >= INT_MAX)
+			return NULL;
+	}
+
+	rcu_read_lock();
+retry:
+	rev = kernfs_dir_read_begin(parent);
+	if (pos)
+		next = kernfs_dir_succ_rcu(parent, pos->hash,
+					   READ_ONCE(pos->name), pos->ns);
+	else
+		next = kernfs_dir_succ_rcu(parent, hash, NULL, NULL);
+
+	/* Skip over entries which are dying/dead or in the wrong namespace */
+	while (next && (!__kernfs_active(next) || next->ns != ns ||
+			!atomic_inc_not_zero(&next->count)))
+		next = kernfs_dir_succ_rcu(parent, next->hash,
+					   READ_ONCE(next->name), next->ns);
+
+	if (kernfs_dir_read_retry(parent, rev)) {
+		/* The last reference can't be dropped under RCU */
+		rcu_read_unlock();
+		kernfs_put(next);
+		rcu_read_lock();
+		goto retry;
 	}
-	return pos;
+	rcu_read_unlock();
+
+	kernfs_put(pos);
+	return next;
 }
 
 static int kernfs_fop_readdir(struct file *file, struct dir_context *ctx)
@@ -1844,44 +1977,219 @@ static int kernfs_fop_readdir(struct file *file, struct dir_context *ctx)
 	struct dentry *dentry = file->f_path.dentry;
 	struct kernfs_node *parent = kernfs_dentry_node(dentry);
 	struct kernfs_node *pos = file->private_data;
-	struct kernfs_root *root;
 	const void *ns = NULL;
 
 	if (!dir_emit_dots(file, ctx))
 		return 0;
 
-	root = kernfs_root(parent);
-	down_read(&root->kernfs_rwsem);
-
 	if (kernfs_ns_enabled(parent))
 		ns = kernfs_info(dentry->d_sb)->ns;
 
-	for (pos = kernfs_dir_pos(ns, parent, ctx->pos, pos);
+	/*
+	 * Walk the children without kernfs_rwsem, so that scanning large
+	 * directories doesn't hold off adding and removing nodes.
+	 * ->private_data holds a reference on the entry being emitted.
+	 */
+	file->private_data = NULL;
+	for (pos = kernfs_dir_next_pos(ns, parent, ctx->pos, pos, false);
 	     pos;
-	     pos = kernfs_dir_next_pos(ns, parent, ctx->pos, pos)) {
+	     pos = kernfs_dir_next_pos(ns, parent, ctx->pos, pos, true)) {
 		const char *name = pos->name;
 		unsigned int type = fs_umode_to_dtype(pos->mode);
 		int len = strlen(name);
 		ino_t ino = kernfs_ino(pos);
 
 		ctx->pos = pos->hash;
-		file->private_data = pos;
-		kernfs_get(pos);
-
-		up_read(&root->kernfs_rwsem);
-		if (!dir_emit(ctx, name, len, ino, type))
+		if (!dir_emit(ctx, name, len, ino, type)) {
+			file->private_data = pos;
 			return 0;
-		down_read(&root->kernfs_rwsem);
+		}
 	}
-	up_read(&root->kernfs_rwsem);
-	file->private_data = NULL;
 	ctx->pos = INT_MAX;
 	return 0;
 }
 
+/* Upper limit on kernfs_bulk_read.max_size */
+#define KERNFS_BULK_MAX_SIZE	SZ_256K
+
+static bool kernfs_bulk_attr_valid(const char *attr)
+{
+	const char *p = attr;
+
+	if (!*attr || *attr == '/')
+		return false;
+
+	while (*p) {
+		size_t len = strcspn(p, "/");
+
+		if (len == 2 && p[0] == '.' && p[1] == '.')
+			return false;
+		p += len;
+		if (*p)
+			p++;
+	}
+	return true;
+}
+
+/*
+ * Open and read @attr of the child @name of @dir into @data, which has room
+ * for @max_size + 1 bytes.  Returns the number of bytes read or -errno.
+ */
+static ssize_t kernfs_bulk_read_one(const struct path *dir, const char *name,
+				    const char *attr, char *path, void *data,
+				    size_t max_size)
+{
+	struct file *f;
+	loff_t off = 0;
+	ssize_t ret;
+
+	if (snprintf(path, PATH_MAX, "%s/%s", name, attr) >= PATH_MAX)
+		return -ENAMETOOLONG;
+
+	f = file_open_root(dir, path, O_RDONLY | O_NOFOLLOW, 0);
+	if (IS_ERR(f))
+		return PTR_ERR(f);
+	ret = kernel_read(f, data, max_size + 1, &off);
+	fput(f);
+	return ret;
+}
+
+static long kernfs_dir_bulk_read(struct file *file,
+				 struct kernfs_bulk_read __user *uarg)
+{
+	struct dentry *dentry = file->f_path.dentry;
+	struct kernfs_node *parent = kernfs_dentry_node(dentry);
+	char __user *ubuf;
+	struct kernfs_bulk_read args;
+	struct kernfs_node *pos;
+	const void *ns = NULL;
+	char name[NAME_MAX + 1];
+	char *attr, *path;
+	size_t max_size;
+	void *data;
+	long ret;
+
+	if (copy_from_user(&args, uarg, sizeof(args)))
+		return -EFAULT;
+	if (args.flags || args.reserved)
+		return -EINVAL;
+
+	max_size = args.max_size ?: PAGE_SIZE;
+	if (max_size > KERNFS_BULK_MAX_SIZE)
+		return -EINVAL;
+
+	attr = strndup_user(u64_to_user_ptr(args.attr), PATH_MAX);
+	if (IS_ERR(attr))
+		return PTR_ERR(attr);
+	ret = -EINVAL;
+	if (!kernfs_bulk_attr_valid(attr))
+		goto out_free_attr;
+
+	ret = -ENOMEM;
+	path = kmalloc(PATH_MAX, GFP_KERNEL);
+	data = kvmalloc(max_size + 1, GFP_KERNEL);
+	if (!path || !data)
+		goto out_free;
+
+	if (kernfs_ns_enabled(parent))
+		ns = kernfs_info(dentry->d_sb)->ns;
+
+	ubuf = u64_to_user_ptr(args.buf);
+	args.count = 0;
+	args.used = 0;
+	ret = 0;
+
+	pos = kernfs_dir_next_pos(ns, parent, max_t(u64, args.cookie, 2), NULL,
+				  false);
+	for (; pos; pos = kernfs_dir_next_pos(ns, parent, 0, pos, true)) {
+		struct kernfs_bulk_entry entry = {};
+		ssize_t len;
+		size_t rec_len;
+
+		if (kernfs_type(pos) != KERNFS_DIR && kernfs_type(pos) != KERNFS_LINK)
+			continue;
+
+		/* Renames free the old name after an RCU grace period */
+		rcu_read_lock();
+		strscpy(name, READ_ONCE(pos->name), sizeof(name));
+		rcu_read_unlock();
+
+		len = kernfs_bulk_read_one(&file->f_path, name, attr, path,
+					   data, max_size);
+		if (len == -ENOENT)
+			continue;
+
+		entry.name_len = strlen(name);
+		if (len < 0) {
+			entry.error = len;
+		} else if (len > max_size) {
+			entry.flags = KERNFS_BULK_TRUNCATED;
+			entry.data_len = max_size;
+		} else {
+			entry.data_len = len;
+		}
+		rec_len = ALIGN(sizeof(entry) + entry.name_len + 1 +
+				entry.data_len, 8);
+		entry.rec_len = rec_len;
+
+		if (rec_len > args.buf_len - args.used) {
+			if (!args.count)
+				ret = -EOVERFLOW;
+			break;
+		}
+
+		if (copy_to_user(ubuf, &entry, sizeof(entry)) ||
+		    copy_to_user(ubuf + sizeof(entry), name,
+				 entry.name_len + 1) ||
+		    copy_to_user(ubuf + sizeof(entry) + entry.name_len + 1,
+				 data, entry.data_len) ||
+		    clear_user(ubuf + sizeof(entry) + entry.name_len + 1 +
+			       entry.data_len,
+			       rec_len - sizeof(entry) - entry.name_len - 1 -
+			       entry.data_len)) {
+			ret = -EFAULT;
+			break;
+		}
+		ubuf += rec_len;
+		args.used += rec_len;
+		args.count++;
+
+		if (fatal_signal_pending(current)) {
+			ret = -EINTR;
+			break;
+		}
+		cond_resched();
+	}
+
+	args.cookie = pos ? pos->hash : KERNFS_BULK_COOKIE_END;
+	kernfs_put(pos);
+
+	if (!ret && copy_to_user(uarg, &args, sizeof(args)))
+		ret = -EFAULT;
+out_free:
+	kvfree(data);
+	kfree(path);
+out_free_attr:
+	kfree(attr);
+	return ret;
+}
+
+static long kernfs_dir_fop_ioctl(struct file *file, unsigned int cmd,
+				 unsigned long arg)
+{
+	switch (cmd) {
+	case KERNFS_IOC_BULK_READ:
+		return kernfs_dir_bulk_read(file, (void __user *)arg);
+	default:
+		return -ENOTTY;
+	}
+}
+
 const struct file_operations kernfs_dir_fops = {
 	.read		= generic_read_dir,
 	.iterate_shared	= kernfs_fop_readdir,
 	.release	= kernfs_dir_fop_release,
 	.llseek		= generic_file_llseek,
+	.unlocked_ioctl	= kernfs_dir_fop_ioctl,
+	.compat_ioctl	= compat_ptr_ioctl,
 };
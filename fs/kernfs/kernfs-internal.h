@@ -110,15 +110,42 @@ static inline void kernfs_set_rev(struct kernfs_node *parent,
 	dentry->d_time = parent->dir.rev;
 }
 
-static inline void kernfs_inc_rev(struct kernfs_node *parent)
+/*
+ * ->dir.rev also acts as a sequence count for lockless walks of the children
+ * rbtree: it is odd while the tree is being changed.  Writers are serialized
+ * by kernfs_rwsem held exclusive.
+ */
+static inline void kernfs_dir_change_begin(struct kernfs_node *parent)
+{
+	WRITE_ONCE(parent->dir.rev, parent->dir.rev + 1);
+	smp_wmb();
+}
+
+static inline void kernfs_dir_change_end(struct kernfs_node *parent)
+{
+	smp_wmb();
+	WRITE_ONCE(parent->dir.rev, parent->dir.rev + 1);
+}
+
+static inline unsigned long kernfs_dir_read_begin(struct kernfs_node *parent)
+{
+	unsigned long rev = READ_ONCE(parent->dir.rev);
+
+	smp_rmb();
+	return rev;
+}
+
+static inline bool kernfs_dir_read_retry(struct kernfs_node *parent,
+					 unsigned long rev)
 {
-	parent->dir.rev++;
+	smp_rmb();
+	return (rev & 1) || READ_ONCE(parent->dir.rev) != rev;
 }
 
 static inline bool kernfs_dir_changed(struct kernfs_node *parent,
 				      struct dentry *dentry)
 {
-	if (parent->dir.rev != dentry->d_time)
+	if (READ_ONCE(parent->dir.rev) != dentry->d_time)
 		return true;
 	return false;
 }
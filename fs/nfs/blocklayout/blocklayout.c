@@ -468,6 +468,7 @@ static struct pnfs_layout_hdr *__bl_alloc_layout_hdr(struct inode *inode,
 	bl->bl_ext_rw = RB_ROOT;
 	bl->bl_ext_ro = RB_ROOT;
 	spin_lock_init(&bl->bl_ext_lock);
+	seqcount_spinlock_init(&bl->bl_ext_seq, &bl->bl_ext_lock);
 
 	bl->bl_scsi_layout = is_scsi_layout;
 	return &bl->bl_layout;
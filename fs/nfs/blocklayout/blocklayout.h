@@ -126,10 +126,10 @@ enum {
 
 /* sector_t fields are all in 512-byte sectors */
 struct pnfs_block_extent {
-	union {
-		struct rb_node	be_node;
-		struct list_head be_list;
-	};
+	struct rb_node	be_node;
+	/* not in a tree yet, or removed from it but maybe still seen by RCU */
+	struct list_head be_list;
+	struct rcu_head	be_rcu;
 	struct nfs4_deviceid_node *be_device;
 	sector_t	be_f_offset;	/* the starting offset in the file */
 	sector_t	be_length;	/* the size of the extent */
@@ -145,6 +145,7 @@ struct pnfs_block_layout {
 	struct rb_root		bl_ext_rw;
 	struct rb_root		bl_ext_ro;
 	spinlock_t		bl_ext_lock;   /* Protects list manipulation */
+	seqcount_spinlock_t	bl_ext_seq;    /* For lockless lookups */
 	bool			bl_scsi_layout;
 	u64			bl_lwb;
 };
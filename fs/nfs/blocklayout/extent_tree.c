@@ -9,6 +9,33 @@
 
 #define NFSDBG_FACILITY		NFSDBG_PNFS_LD
 
+/*
+ * The extent trees are modified with bl_ext_lock held, and every change is
+ * done inside a bl_ext_seq write section so that lookups can run under RCU
+ * alone and retry if they raced with one. Extents that were in a tree are
+ * freed after an RCU grace period.
+ */
+static void
+ext_tree_lock(struct pnfs_block_layout *bl)
+{
+	spin_lock(&bl->bl_ext_lock);
+	write_seqcount_begin(&bl->bl_ext_seq);
+}
+
+static void
+ext_tree_unlock(struct pnfs_block_layout *bl)
+{
+	write_seqcount_end(&bl->bl_ext_seq);
+	spin_unlock(&bl->bl_ext_lock);
+}
+
+static void
+ext_free(struct pnfs_block_extent *be)
+{
+	nfs4_put_deviceid_node(be->be_device);
+	kfree_rcu(be, be_rcu);
+}
+
 static inline struct pnfs_block_extent *
 ext_node(struct rb_node *node)
 {
@@ -99,8 +126,7 @@ ext_try_to_merge_left(struct rb_root *root, struct pnfs_block_extent *be)
 	if (left && ext_can_merge(left, be)) {
 		left->be_length += be->be_length;
 		rb_erase(&be->be_node, root);
-		nfs4_put_deviceid_node(be->be_device);
-		kfree(be);
+		ext_free(be);
 		return left;
 	}
 
@@ -115,8 +141,7 @@ ext_try_to_merge_right(struct rb_root *root, struct pnfs_block_extent *be)
 	if (right && ext_can_merge(be, right)) {
 		be->be_length += right->be_length;
 		rb_erase(&right->be_node, root);
-		nfs4_put_deviceid_node(right->be_device);
-		kfree(right);
+		ext_free(right);
 	}
 
 	return be;
@@ -126,10 +151,8 @@ static void __ext_put_deviceids(struct list_head *head)
 {
 	struct pnfs_block_extent *be, *tmp;
 
-	list_for_each_entry_safe(be, tmp, head, be_list) {
-		nfs4_put_deviceid_node(be->be_device);
-		kfree(be);
-	}
+	list_for_each_entry_safe(be, tmp, head, be_list)
+		ext_free(be);
 }
 
 static void
@@ -165,7 +188,7 @@ __ext_tree_insert(struct rb_root *root,
 		}
 	}
 
-	rb_link_node(&new->be_node, parent, p);
+	rb_link_node_rcu(&new->be_node, parent, p);
 	rb_insert_color(&new->be_node, root);
 	return;
 free_new:
@@ -272,7 +295,7 @@ ext_tree_insert(struct pnfs_block_layout *bl, struct pnfs_block_extent *new)
 		return -EINVAL;
 	}
 
-	spin_lock(&bl->bl_ext_lock);
+	ext_tree_lock(bl);
 retry:
 	be = __ext_tree_search(root, new->be_f_offset);
 	if (!be || be->be_f_offset >= ext_f_end(new)) {
@@ -314,7 +337,7 @@ ext_tree_insert(struct pnfs_block_layout *bl, struct pnfs_block_extent *new)
 		goto retry;
 	}
 out:
-	spin_unlock(&bl->bl_ext_lock);
+	ext_tree_unlock(bl);
 	return err;
 }
 
@@ -325,13 +348,13 @@ __ext_tree_lookup(struct rb_root *root, sector_t isect,
 	struct rb_node *node;
 	struct pnfs_block_extent *be;
 
-	node = root->rb_node;
+	node = rcu_dereference_raw(root->rb_node);
 	while (node) {
 		be = ext_node(node);
 		if (isect < be->be_f_offset)
-			node = node->rb_left;
+			node = rcu_dereference_raw(node->rb_left);
 		else if (isect >= ext_f_end(be))
-			node = node->rb_right;
+			node = rcu_dereference_raw(node->rb_right);
 		else {
 			*ret = *be;
 			return true;
@@ -345,14 +368,24 @@ bool
 ext_tree_lookup(struct pnfs_block_layout *bl, sector_t isect,
 	    struct pnfs_block_extent *ret, bool rw)
 {
-	bool found = false;
+	unsigned int seq;
+	bool found;
 
-	spin_lock(&bl->bl_ext_lock);
-	if (!rw)
-		found = __ext_tree_lookup(&bl->bl_ext_ro, isect, ret);
-	if (!found)
-		found = __ext_tree_lookup(&bl->bl_ext_rw, isect, ret);
-	spin_unlock(&bl->bl_ext_lock);
+	/*
+	 * A lookup racing with a change may walk a partially updated tree or
+	 * copy a partially updated extent, and is then retried. It cannot
+	 * loop or touch freed memory.
+	 */
+	rcu_read_lock();
+	do {
+		seq = read_seqcount_begin(&bl->bl_ext_seq);
+		found = false;
+		if (!rw)
+			found = __ext_tree_lookup(&bl->bl_ext_ro, isect, ret);
+		if (!found)
+			found = __ext_tree_lookup(&bl->bl_ext_rw, isect, ret);
+	} while (read_seqcount_retry(&bl->bl_ext_seq, seq));
+	rcu_read_unlock();
 
 	return found;
 }
@@ -363,14 +396,14 @@ int ext_tree_remove(struct pnfs_block_layout *bl, bool rw,
 	int err, err2;
 	LIST_HEAD(tmp);
 
-	spin_lock(&bl->bl_ext_lock);
+	ext_tree_lock(bl);
 	err = __ext_tree_remove(&bl->bl_ext_ro, start, end, &tmp);
 	if (rw) {
 		err2 = __ext_tree_remove(&bl->bl_ext_rw, start, end, &tmp);
 		if (!err)
 			err = err2;
 	}
-	spin_unlock(&bl->bl_ext_lock);
+	ext_tree_unlock(bl);
 
 	__ext_put_deviceids(&tmp);
 	return err;
@@ -411,7 +444,7 @@ ext_tree_mark_written(struct pnfs_block_layout *bl, sector_t start,
 	int err = 0;
 	LIST_HEAD(tmp);
 
-	spin_lock(&bl->bl_ext_lock);
+	ext_tree_lock(bl);
 	/*
 	 * First remove all COW extents or holes from written to range.
 	 */
@@ -474,7 +507,7 @@ ext_tree_mark_written(struct pnfs_block_layout *bl, sector_t start,
 out:
 	if (bl->bl_lwb < lwb)
 		bl->bl_lwb = lwb;
-	spin_unlock(&bl->bl_ext_lock);
+	ext_tree_unlock(bl);
 
 	__ext_put_deviceids(&tmp);
 	return err;
@@ -526,7 +559,7 @@ static int ext_tree_encode_commit(struct pnfs_block_layout *bl, __be32 *p,
 	struct pnfs_block_extent *be;
 	int ret = 0;
 
-	spin_lock(&bl->bl_ext_lock);
+	ext_tree_lock(bl);
 	for (be = ext_tree_first(&bl->bl_ext_rw); be; be = ext_tree_next(be)) {
 		if (be->be_state != PNFS_BLOCK_INVALID_DATA ||
 		    be->be_tag != EXTENT_WRITTEN)
@@ -547,7 +580,7 @@ static int ext_tree_encode_commit(struct pnfs_block_layout *bl, __be32 *p,
 	}
 	*lastbyte = bl->bl_lwb - 1;
 	bl->bl_lwb = 0;
-	spin_unlock(&bl->bl_ext_lock);
+	ext_tree_unlock(bl);
 
 	return ret;
 }
@@ -622,7 +655,7 @@ ext_tree_mark_committed(struct nfs4_layoutcommit_args *arg, int status)
 
 	ext_tree_free_commitdata(arg, arg->layoutupdate_len);
 
-	spin_lock(&bl->bl_ext_lock);
+	ext_tree_lock(bl);
 	for (be = ext_tree_first(root); be; be = ext_tree_next(be)) {
 		if (be->be_state != PNFS_BLOCK_INVALID_DATA ||
 		    be->be_tag != EXTENT_COMMITTING)
@@ -643,5 +676,5 @@ ext_tree_mark_committed(struct nfs4_layoutcommit_args *arg, int status)
 		be = ext_try_to_merge_left(root, be);
 		be = ext_try_to_merge_right(root, be);
 	}
-	spin_unlock(&bl->bl_ext_lock);
+	ext_tree_unlock(bl);
 }
@@ -808,18 +808,63 @@ ff_layout_choose_best_ds_for_read(struct pnfs_layout_segment *lseg,
 	return ff_layout_choose_any_ds_for_read(lseg, start_idx, best_idx);
 }
 
+/*
+ * Pick the available mirror from @start_idx on with the lowest expected READ
+ * cost (see nfs4_ff_layout_ds_read_cost()). Ties, such as between mirrors
+ * that have not been measured yet, are broken by rotating through the
+ * mirrors, so that consecutive reads of a large request are striped across
+ * all of them and are in flight in parallel.
+ */
+static struct nfs4_pnfs_ds *
+ff_layout_choose_balanced_ds_for_read(struct pnfs_layout_segment *lseg,
+				      u32 start_idx, u32 *best_idx)
+{
+	struct nfs4_ff_layout_segment *fls = FF_LAYOUT_LSEG(lseg);
+	struct nfs4_ff_layout_mirror *mirror;
+	struct nfs4_pnfs_ds *ds, *best_ds = NULL;
+	u32 cnt = fls->mirror_array_cnt - start_idx;
+	u32 rotor, i, idx;
+	u64 cost, best_cost = U64_MAX;
+
+	if (cnt <= 1)
+		return ff_layout_choose_best_ds_for_read(lseg, start_idx,
+							 best_idx);
+
+	rotor = atomic_inc_return(&fls->read_rotor);
+	for (i = 0; i < cnt; i++) {
+		idx = start_idx + (rotor + i) % cnt;
+		mirror = FF_LAYOUT_COMP(lseg, idx);
+		ds = nfs4_ff_layout_prepare_ds(lseg, mirror, false);
+		if (!ds)
+			continue;
+
+		if (nfs4_test_deviceid_unavailable(&mirror->mirror_ds->id_node))
+			continue;
+
+		cost = nfs4_ff_layout_ds_read_cost(mirror->mirror_ds);
+		if (cost < best_cost) {
+			best_cost = cost;
+			best_ds = ds;
+			*best_idx = idx;
+		}
+	}
+
+	if (best_ds)
+		return best_ds;
+	return ff_layout_choose_any_ds_for_read(lseg, start_idx, best_idx);
+}
+
 static struct nfs4_pnfs_ds *
 ff_layout_get_ds_for_read(struct nfs_pageio_descriptor *pgio,
-			  u32 *best_idx)
+			  u32 start_idx, u32 *best_idx)
 {
 	struct pnfs_layout_segment *lseg = pgio->pg_lseg;
 	struct nfs4_pnfs_ds *ds;
 
-	ds = ff_layout_choose_best_ds_for_read(lseg, pgio->pg_mirror_idx,
-					       best_idx);
-	if (ds || !pgio->pg_mirror_idx)
+	ds = ff_layout_choose_balanced_ds_for_read(lseg, start_idx, best_idx);
+	if (ds || !start_idx)
 		return ds;
-	return ff_layout_choose_best_ds_for_read(lseg, 0, best_idx);
+	return ff_layout_choose_balanced_ds_for_read(lseg, 0, best_idx);
 }
 
 static void
@@ -845,8 +890,18 @@ ff_layout_pg_init_read(struct nfs_pageio_descriptor *pgio,
 	struct nfs_pgio_mirror *pgm;
 	struct nfs4_ff_layout_mirror *mirror;
 	struct nfs4_pnfs_ds *ds;
+	u32 start_idx = 0;
 	u32 ds_idx;
 
+	/*
+	 * A descriptor without a layout segment yet may be resending a failed
+	 * read, in which case pg_mirror_idx is the first mirror to retry on.
+	 * Otherwise, pg_mirror_idx is just the mirror used for the previous
+	 * read, and all mirrors are candidates for this one.
+	 */
+	if (!pgio->pg_lseg)
+		start_idx = pgio->pg_mirror_idx;
+
 retry:
 	pnfs_generic_pg_check_layout(pgio, req);
 	/* Use full layout for now */
@@ -861,7 +916,7 @@ ff_layout_pg_init_read(struct nfs_pageio_descriptor *pgio,
 			goto out_nolseg;
 	}
 
-	ds = ff_layout_get_ds_for_read(pgio, &ds_idx);
+	ds = ff_layout_get_ds_for_read(pgio, start_idx, &ds_idx);
 	if (!ds) {
 		if (!ff_layout_no_fallback_to_mds(pgio->pg_lseg))
 			goto out_mds;
@@ -1366,6 +1421,8 @@ static void ff_layout_read_record_layoutstats_start(struct rpc_task *task,
 			FF_LAYOUT_COMP(hdr->lseg, hdr->pgio_mirror_idx),
 			hdr->args.count,
 			task->tk_start);
+	nfs4_ff_layout_ds_read_start(FF_LAYOUT_COMP(hdr->lseg,
+					hdr->pgio_mirror_idx)->mirror_ds);
 }
 
 static void ff_layout_read_record_layoutstats_done(struct rpc_task *task,
@@ -1377,6 +1434,9 @@ static void ff_layout_read_record_layoutstats_done(struct rpc_task *task,
 			FF_LAYOUT_COMP(hdr->lseg, hdr->pgio_mirror_idx),
 			hdr->args.count,
 			hdr->res.count);
+	nfs4_ff_layout_ds_read_done(FF_LAYOUT_COMP(hdr->lseg,
+					hdr->pgio_mirror_idx)->mirror_ds,
+				    ktime_sub(ktime_get(), task->tk_start));
 	set_bit(NFS_LSEG_LAYOUTRETURN, &hdr->lseg->pls_flags);
 }
 
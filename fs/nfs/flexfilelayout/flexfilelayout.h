@@ -14,6 +14,7 @@
 #define FF_FLAGS_NO_IO_THRU_MDS  2
 #define FF_FLAGS_NO_READ_IO      4
 
+#include <linux/average.h>
 #include <linux/refcount.h>
 #include "../pnfs.h"
 
@@ -33,12 +34,17 @@ struct nfs4_ff_ds_version {
 	bool				tightly_coupled;
 };
 
+/* Average READ latency of a DS in ns, used to balance reads across mirrors */
+DECLARE_EWMA(ff_read_lat, 4, 8)
+
 /* chained in global deviceid hlist */
 struct nfs4_ff_layout_ds {
 	struct nfs4_deviceid_node	id_node;
 	u32				ds_versions_cnt;
 	struct nfs4_ff_ds_version	*ds_versions;
 	struct nfs4_pnfs_ds		*ds;
+	struct ewma_ff_read_lat		read_lat;
+	atomic_t			reads_in_flight;
 };
 
 struct nfs4_ff_layout_ds_err {
@@ -99,6 +105,7 @@ struct nfs4_ff_layout_segment {
 	u64				stripe_unit;
 	u32				flags;
 	u32				mirror_array_cnt;
+	atomic_t			read_rotor;
 	struct nfs4_ff_layout_mirror	*mirror_array[] __counted_by(mirror_array_cnt);
 };
 
@@ -190,6 +197,10 @@ struct nfs4_ff_layout_ds *
 nfs4_ff_alloc_deviceid_node(struct nfs_server *server, struct pnfs_device *pdev,
 			    gfp_t gfp_flags);
 void nfs4_ff_layout_put_deviceid(struct nfs4_ff_layout_ds *mirror_ds);
+void nfs4_ff_layout_ds_read_start(struct nfs4_ff_layout_ds *mirror_ds);
+void nfs4_ff_layout_ds_read_done(struct nfs4_ff_layout_ds *mirror_ds,
+				 ktime_t latency);
+u64 nfs4_ff_layout_ds_read_cost(struct nfs4_ff_layout_ds *mirror_ds);
 void nfs4_ff_layout_free_deviceid(struct nfs4_ff_layout_ds *mirror_ds);
 int ff_layout_track_ds_error(struct nfs4_flexfile_layout *flo,
 			     struct nfs4_ff_layout_mirror *mirror, u64 offset,
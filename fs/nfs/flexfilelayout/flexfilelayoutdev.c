@@ -185,6 +185,36 @@ nfs4_ff_alloc_deviceid_node(struct nfs_server *server, struct pnfs_device *pdev,
 	return NULL;
 }
 
+/*
+ * Per-DS READ statistics used to spread reads over the mirrors of a layout.
+ * The latency average is updated without locking, a lost sample now and then
+ * does not matter.
+ */
+void nfs4_ff_layout_ds_read_start(struct nfs4_ff_layout_ds *mirror_ds)
+{
+	atomic_inc(&mirror_ds->reads_in_flight);
+}
+
+void nfs4_ff_layout_ds_read_done(struct nfs4_ff_layout_ds *mirror_ds,
+				 ktime_t latency)
+{
+	atomic_dec(&mirror_ds->reads_in_flight);
+	ewma_ff_read_lat_add(&mirror_ds->read_lat,
+			     max_t(s64, ktime_to_ns(latency), 1));
+}
+
+/*
+ * Expected cost of sending one more READ to @mirror_ds: its average latency
+ * times the number of READs it would then have in flight. A DS without any
+ * completed READ yet has no cost, so that it gets tried.
+ */
+u64 nfs4_ff_layout_ds_read_cost(struct nfs4_ff_layout_ds *mirror_ds)
+{
+	u64 lat = ewma_ff_read_lat_read(&mirror_ds->read_lat);
+
+	return lat * (max(atomic_read(&mirror_ds->reads_in_flight), 0) + 1);
+}
+
 static void extend_ds_error(struct nfs4_ff_layout_ds_err *err,
 			    u64 offset, u64 length)
 {
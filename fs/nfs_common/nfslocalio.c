@@ -6,6 +6,8 @@
 
 #include <linux/module.h>
 #include <linux/list.h>
+#include <linux/stat.h>
+#include <linux/uio.h>
 #include <linux/nfslocalio.h>
 #include <net/netns/generic.h>
 
@@ -162,6 +164,75 @@ struct nfsd_file *nfs_open_local_fh(nfs_uuid_t *uuid,
 }
 EXPORT_SYMBOL_GPL(nfs_open_local_fh);
 
+/*
+ * With a co-located client and server, buffered LOCALIO caches the same data
+ * twice: in the client's page cache and in the page cache of the server's
+ * underlying file. Issuing the IO to the underlying file as direct IO keeps
+ * only the client's copy. Client O_DIRECT IO is always issued as direct IO
+ * when it is suitably aligned for the underlying file, and with
+ * localio_O_DIRECT_semantics set so is buffered client IO. IO that is not
+ * aligned falls back to buffered IO on the underlying file, since NFS itself
+ * has no alignment requirement for O_DIRECT.
+ */
+static bool localio_O_DIRECT_semantics __read_mostly;
+module_param(localio_O_DIRECT_semantics, bool, 0644);
+MODULE_PARM_DESC(localio_O_DIRECT_semantics,
+		 "LOCALIO will use direct IO to the underlying file for all aligned IO, not only for client O_DIRECT IO");
+
+/*
+ * Get the direct IO alignment constraints of the underlying file @file, to
+ * be kept with the LOCALIO open file. Returns false if @file does not support
+ * direct IO, in which case all IO to it is buffered.
+ */
+bool nfs_local_dio_init(struct file *file, struct nfs_local_dio *dio)
+{
+	struct kstat stat;
+
+	dio->mem_align = 0;
+	dio->offset_align = 0;
+
+	if (!(file->f_mode & FMODE_CAN_ODIRECT))
+		return false;
+
+	if (vfs_getattr(&file->f_path, &stat, STATX_DIOALIGN,
+			AT_STATX_SYNC_AS_STAT) ||
+	    !(stat.result_mask & STATX_DIOALIGN) ||
+	    !stat.dio_mem_align || !stat.dio_offset_align)
+		return false;
+
+	dio->mem_align = stat.dio_mem_align;
+	dio->offset_align = stat.dio_offset_align;
+	return true;
+}
+EXPORT_SYMBOL_GPL(nfs_local_dio_init);
+
+/*
+ * Decide whether the LOCALIO @iocb on @iter is issued as direct IO to the
+ * underlying file, and set IOCB_DIRECT if so. @client_dio is true for client
+ * O_DIRECT IO. The IO position and length must be aligned to the file's
+ * offset alignment and the memory of @iter to its memory alignment.
+ */
+bool nfs_local_iocb_dio(struct kiocb *iocb, const struct nfs_local_dio *dio,
+			struct iov_iter *iter, bool client_dio)
+{
+	if (!client_dio && !READ_ONCE(localio_O_DIRECT_semantics))
+		return false;
+
+	if (!dio->offset_align)
+		return false;
+
+	if ((iocb->ki_pos | iov_iter_count(iter)) & (dio->offset_align - 1))
+		return false;
+
+	if (!iov_iter_is_aligned(iter, dio->mem_align - 1,
+				 dio->offset_align - 1))
+		return false;
+
+	iocb->ki_flags |= IOCB_DIRECT;
+	return true;
+}
+EXPORT_SYMBOL_GPL(nfs_local_iocb_dio);
+
 /*
  * The NFS LOCALIO code needs to call into NFSD using various symbols,
  * but cannot be statically linked, because that will make the NFS
@@ -946,6 +946,13 @@ static int fanotify_handle_event(struct fsnotify_group *group, u32 mask,
 	}
 
 	fsn_event = &event->fse;
+	/* With a shared ring, the event is copied there and not queued */
+	if (fanotify_ring_add(group, event)) {
+		fsnotify_destroy_event(group, fsn_event);
+		ret = 0;
+		goto finish;
+	}
+
 	ret = fsnotify_insert_event(group, fsn_event, fanotify_merge,
 				    fanotify_insert_event);
 	if (ret) {
@@ -975,6 +982,8 @@ static void fanotify_free_group_priv(struct fsnotify_group *group)
 
 	if (mempool_initialized(&group->fanotify_data.error_events_pool))
 		mempool_exit(&group->fanotify_data.error_events_pool);
+
+	fanotify_ring_free(group->fanotify_data.ring);
 }
 
 static void fanotify_free_path_event(struct fanotify_event *event)
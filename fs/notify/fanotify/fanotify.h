@@ -518,3 +518,8 @@ static inline unsigned int fanotify_mark_user_flags(struct fsnotify_mark *mark)
 
 	return mflags;
 }
+
+/* Shared event ring, see fanotify_mmap() */
+bool fanotify_ring_add(struct fsnotify_group *group,
+		       struct fanotify_event *event);
+void fanotify_ring_free(struct fanotify_ring *ring);
@@ -19,8 +19,13 @@
 #include <linux/memcontrol.h>
 #include <linux/statfs.h>
 #include <linux/exportfs.h>
+#include <linux/uio.h>
+#include <linux/vmalloc.h>
+#include <linux/pid_namespace.h>
+#include <linux/sizes.h>
 
 #include <asm/ioctls.h>
+#include <asm/shmparam.h>
 
 #include "../fsnotify.h"
 #include "../fdinfo.h"
@@ -30,6 +35,7 @@
 #define FANOTIFY_OLD_DEFAULT_MAX_MARKS	8192
 #define FANOTIFY_DEFAULT_MAX_GROUPS	128
 #define FANOTIFY_DEFAULT_FEE_POOL_SIZE	32
+#define FANOTIFY_RING_MAX_SIZE		SZ_64M
 
 /*
  * Legacy fanotify marks limits (8192) is per group and we introduced a tunable
@@ -380,8 +386,8 @@ static int process_access_response(struct fsnotify_group *group,
 	return -ENOENT;
 }
 
-static size_t copy_error_info_to_user(struct fanotify_event *event,
-				      char __user *buf, int count)
+static size_t copy_error_info(struct fanotify_event *event,
+			      struct iov_iter *iter)
 {
 	struct fanotify_event_info_error info = { };
 	struct fanotify_error_event *fee = FANOTIFY_EE(event);
@@ -389,22 +395,21 @@ static size_t copy_error_info_to_user(struct fanotify_event *event,
 	info.hdr.info_type = FAN_EVENT_INFO_TYPE_ERROR;
 	info.hdr.len = FANOTIFY_ERROR_INFO_LEN;
 
-	if (WARN_ON(count < info.hdr.len))
+	if (WARN_ON(iov_iter_count(iter) < info.hdr.len))
 		return -EFAULT;
 
 	info.error = fee->error;
 	info.error_count = fee->err_count;
 
-	if (copy_to_user(buf, &info, sizeof(info)))
+	if (copy_to_iter(&info, sizeof(info), iter) != sizeof(info))
 		return -EFAULT;
 
 	return info.hdr.len;
 }
 
-static int copy_fid_info_to_user(__kernel_fsid_t *fsid, struct fanotify_fh *fh,
-				 int info_type, const char *name,
-				 size_t name_len,
-				 char __user *buf, size_t count)
+static int copy_fid_info(__kernel_fsid_t *fsid, struct fanotify_fh *fh,
+			 int info_type, const char *name, size_t name_len,
+			 struct iov_iter *iter)
 {
 	struct fanotify_event_info_fid info = { };
 	struct file_handle handle = { };
@@ -414,9 +419,9 @@ static int copy_fid_info_to_user(__kernel_fsid_t *fsid, struct fanotify_fh *fh,
 	size_t len = info_len;
 
 	pr_debug("%s: fh_len=%zu name_len=%zu, info_len=%zu, count=%zu\n",
-		 __func__, fh_len, name_len, info_len, count);
+		 __func__, fh_len, name_len, info_len, iov_iter_count(iter));
 
-	if (WARN_ON_ONCE(len < sizeof(info) || len > count))
+	if (WARN_ON_ONCE(len < sizeof(info) || len > iov_iter_count(iter)))
 		return -EFAULT;
 
 	/*
@@ -442,10 +447,9 @@ static int copy_fid_info_to_user(__kernel_fsid_t *fsid, struct fanotify_fh *fh,
 	info.hdr.info_type = info_type;
 	info.hdr.len = len;
 	info.fsid = *fsid;
-	if (copy_to_user(buf, &info, sizeof(info)))
+	if (copy_to_iter(&info, sizeof(info), iter) != sizeof(info))
 		return -EFAULT;
 
-	buf += sizeof(info);
 	len -= sizeof(info);
 	if (WARN_ON_ONCE(len < sizeof(handle)))
 		return -EFAULT;
@@ -457,10 +461,9 @@ static int copy_fid_info_to_user(__kernel_fsid_t *fsid, struct fanotify_fh *fh,
 	if (!fh_len)
 		handle.handle_type = FILEID_INVALID;
 
-	if (copy_to_user(buf, &handle, sizeof(handle)))
+	if (copy_to_iter(&handle, sizeof(handle), iter) != sizeof(handle))
 		return -EFAULT;
 
-	buf += sizeof(handle);
 	len -= sizeof(handle);
 	if (WARN_ON_ONCE(len < fh_len))
 		return -EFAULT;
@@ -474,10 +477,9 @@ static int copy_fid_info_to_user(__kernel_fsid_t *fsid, struct fanotify_fh *fh,
 		memcpy(bounce, fh_buf, fh_len);
 		fh_buf = bounce;
 	}
-	if (copy_to_user(buf, fh_buf, fh_len))
+	if (copy_to_iter(fh_buf, fh_len, iter) != fh_len)
 		return -EFAULT;
 
-	buf += fh_len;
 	len -= fh_len;
 
 	if (name_len) {
@@ -486,45 +488,42 @@ static int copy_fid_info_to_user(__kernel_fsid_t *fsid, struct fanotify_fh *fh,
 		if (WARN_ON_ONCE(len < name_len))
 			return -EFAULT;
 
-		if (copy_to_user(buf, name, name_len))
+		if (copy_to_iter(name, name_len, iter) != name_len)
 			return -EFAULT;
 
-		buf += name_len;
 		len -= name_len;
 	}
 
 	/* Pad with 0's */
 	WARN_ON_ONCE(len < 0 || len >= FANOTIFY_EVENT_ALIGN);
-	if (len > 0 && clear_user(buf, len))
+	if (len > 0 && iov_iter_zero(len, iter) != len)
 		return -EFAULT;
 
 	return info_len;
 }
 
-static int copy_pidfd_info_to_user(int pidfd,
-				   char __user *buf,
-				   size_t count)
+static int copy_pidfd_info(int pidfd, struct iov_iter *iter)
 {
 	struct fanotify_event_info_pidfd info = { };
 	size_t info_len = FANOTIFY_PIDFD_INFO_HDR_LEN;
 
-	if (WARN_ON_ONCE(info_len > count))
+	if (WARN_ON_ONCE(info_len > iov_iter_count(iter)))
 		return -EFAULT;
 
 	info.hdr.info_type = FAN_EVENT_INFO_TYPE_PIDFD;
 	info.hdr.len = info_len;
 	info.pidfd = pidfd;
 
-	if (copy_to_user(buf, &info, info_len))
+	if (copy_to_iter(&info, info_len, iter) != info_len)
 		return -EFAULT;
 
 	return info_len;
 }
 
-static int copy_info_records_to_user(struct fanotify_event *event,
-				     struct fanotify_info *info,
-				     unsigned int info_mode, int pidfd,
-				     char __user *buf, size_t count)
+static int copy_info_records(struct fanotify_event *event,
+			     struct fanotify_info *info,
+			     unsigned int info_mode, int pidfd,
+			     struct iov_iter *iter)
 {
 	int ret, total_bytes = 0, info_type = 0;
 	unsigned int fid_mode = info_mode & FANOTIFY_FID_BITS;
@@ -544,32 +543,28 @@ static int copy_info_records_to_user(struct fanotify_event *event,
 		if (event->mask & FAN_RENAME)
 			info_type = FAN_EVENT_INFO_TYPE_OLD_DFID_NAME;
 
-		ret = copy_fid_info_to_user(fanotify_event_fsid(event),
-					    fanotify_info_dir_fh(info),
-					    info_type,
-					    fanotify_info_name(info),
-					    info->name_len, buf, count);
+		ret = copy_fid_info(fanotify_event_fsid(event),
+				    fanotify_info_dir_fh(info),
+				    info_type,
+				    fanotify_info_name(info),
+				    info->name_len, iter);
 		if (ret < 0)
 			return ret;
 
-		buf += ret;
-		count -= ret;
 		total_bytes += ret;
 	}
 
 	/* New dir fid+name may be reported in addition to old dir fid+name */
 	if (fanotify_event_has_dir2_fh(event)) {
 		info_type = FAN_EVENT_INFO_TYPE_NEW_DFID_NAME;
-		ret = copy_fid_info_to_user(fanotify_event_fsid(event),
-					    fanotify_info_dir2_fh(info),
-					    info_type,
-					    fanotify_info_name2(info),
-					    info->name2_len, buf, count);
+		ret = copy_fid_info(fanotify_event_fsid(event),
+				    fanotify_info_dir2_fh(info),
+				    info_type,
+				    fanotify_info_name2(info),
+				    info->name2_len, iter);
 		if (ret < 0)
 			return ret;
 
-		buf += ret;
-		count -= ret;
 		total_bytes += ret;
 	}
 
@@ -611,34 +606,27 @@ static int copy_info_records_to_user(struct fanotify_event *event,
 			info_type = FAN_EVENT_INFO_TYPE_FID;
 		}
 
-		ret = copy_fid_info_to_user(fanotify_event_fsid(event),
-					    fanotify_event_object_fh(event),
-					    info_type, dot, dot_len,
-					    buf, count);
+		ret = copy_fid_info(fanotify_event_fsid(event),
+				    fanotify_event_object_fh(event),
+				    info_type, dot, dot_len, iter);
 		if (ret < 0)
 			return ret;
 
-		buf += ret;
-		count -= ret;
 		total_bytes += ret;
 	}
 
 	if (pidfd_mode) {
-		ret = copy_pidfd_info_to_user(pidfd, buf, count);
+		ret = copy_pidfd_info(pidfd, iter);
 		if (ret < 0)
 			return ret;
 
-		buf += ret;
-		count -= ret;
 		total_bytes += ret;
 	}
 
 	if (fanotify_is_error_event(event->mask)) {
-		ret = copy_error_info_to_user(event, buf, count);
+		ret = copy_error_info(event, iter);
 		if (ret < 0)
 			return ret;
-		buf += ret;
-		count -= ret;
 		total_bytes += ret;
 	}
 
@@ -656,6 +644,7 @@ static ssize_t copy_event_to_user(struct fsnotify_group *group,
 	unsigned int pidfd_mode = info_mode & FAN_REPORT_PIDFD;
 	struct file *f = NULL, *pidfd_file = NULL;
 	int ret, pidfd = -ESRCH, fd = -EBADF;
+	struct iov_iter iter;
 
 	pr_debug("%s: group=%p event=%p\n", __func__, group, event);
 
@@ -753,12 +742,10 @@ static ssize_t copy_event_to_user(struct fsnotify_group *group,
 	if (copy_to_user(buf, &metadata, FAN_EVENT_METADATA_LEN))
 		goto out_close_fd;
 
-	buf += FAN_EVENT_METADATA_LEN;
-	count -= FAN_EVENT_METADATA_LEN;
-
 	if (info_mode) {
-		ret = copy_info_records_to_user(event, info, info_mode, pidfd,
-						buf, count);
+		iov_iter_ubuf(&iter, ITER_DEST, buf + FAN_EVENT_METADATA_LEN,
+			      count - FAN_EVENT_METADATA_LEN);
+		ret = copy_info_records(event, info, info_mode, pidfd, &iter);
 		if (ret < 0)
 			goto out_close_fd;
 	}
@@ -788,10 +775,201 @@ static ssize_t copy_event_to_user(struct fsnotify_group *group,
 	return ret;
 }
 
+/*
+ * Shared event ring.
+ *
+ * A listener in fid mode can mmap() its fanotify fd to get the events written
+ * straight into a ring shared with userspace, instead of having them queued
+ * and copied out one by one by read().  Events carry file handles, so nothing
+ * needs to be installed in the listener's fd table, and the listener can
+ * consume a batch without a syscall: it is only woken up when an event is
+ * added to a ring it had fully drained, not for every event.
+ *
+ * The ring is filled from the context generating the event.  Its header is
+ * writable by userspace, so the kernel only trusts its own copy of the tail
+ * and checks the head it reads back.
+ */
+struct fanotify_ring {
+	spinlock_t lock;
+	struct fanotify_ring_header *hdr;
+	void *data;
+	u32 size;
+	u32 tail;
+	u32 overflow;
+	/* pid namespace and tgid of the task that set up the ring */
+	struct pid_namespace *pid_ns;
+	struct pid *tgid;
+};
+
+bool fanotify_ring_add(struct fsnotify_group *group,
+		       struct fanotify_event *event)
+{
+	struct fanotify_ring *ring = smp_load_acquire(&group->fanotify_data.ring);
+	unsigned int info_mode = FAN_GROUP_FLAG(group, FANOTIFY_INFO_MODES);
+	struct fanotify_event_metadata metadata;
+	u32 len, head, tail, used, off, skip;
+	struct iov_iter iter;
+	struct kvec kvec;
+	bool wake;
+
+	if (!ring || fanotify_is_error_event(event->mask))
+		return false;
+
+	len = fanotify_event_len(info_mode, event);
+	metadata.event_len = len;
+	metadata.metadata_len = FAN_EVENT_METADATA_LEN;
+	metadata.vers = FANOTIFY_METADATA_VERSION;
+	metadata.reserved = 0;
+	metadata.mask = event->mask & FANOTIFY_OUTGOING_EVENTS;
+	metadata.fd = FAN_NOFD;
+	/* Same rule as copy_event_to_user(), for the task owning the ring */
+	if (FAN_GROUP_FLAG(group, FANOTIFY_UNPRIV) && ring->tgid != event->pid)
+		metadata.pid = 0;
+	else
+		metadata.pid = pid_nr_ns(event->pid, ring->pid_ns);
+
+	spin_lock(&ring->lock);
+	tail = ring->tail;
+	head = smp_load_acquire(&ring->hdr->head);
+	used = tail - head;
+	off = tail & (ring->size - 1);
+	skip = ring->size - off < len ? ring->size - off : 0;
+	if (used > ring->size || skip + len > ring->size - used) {
+		WRITE_ONCE(ring->hdr->overflow, ++ring->overflow);
+		spin_unlock(&ring->lock);
+		return true;
+	}
+
+	if (skip) {
+		/* Records are 4 byte aligned, so event_len fits here */
+		*(u32 *)(ring->data + off) = 0;
+		off = 0;
+	}
+	memcpy(ring->data + off, &metadata, FAN_EVENT_METADATA_LEN);
+	if (info_mode) {
+		kvec.iov_base = ring->data + off + FAN_EVENT_METADATA_LEN;
+		kvec.iov_len = len - FAN_EVENT_METADATA_LEN;
+		iov_iter_kvec(&iter, ITER_DEST, &kvec, 1, kvec.iov_len);
+		/* Only fails on internal inconsistency, which does WARN */
+		if (copy_info_records(event, fanotify_event_info(event),
+				      info_mode, FAN_NOPIDFD, &iter) < 0) {
+			spin_unlock(&ring->lock);
+			return true;
+		}
+	}
+	WRITE_ONCE(ring->tail, tail + skip + len);
+	smp_store_release(&ring->hdr->tail, ring->tail);
+
+	/*
+	 * Only wake up the listener if it had consumed everything before this
+	 * event.  Pairs with the barrier in fanotify_poll(): either the
+	 * listener sees the new tail, or we see the head it caught up to.
+	 */
+	smp_mb();
+	wake = READ_ONCE(ring->hdr->head) == tail;
+	spin_unlock(&ring->lock);
+
+	if (wake)
+		wake_up(&group->notification_waitq);
+	return true;
+}
+
+static bool fanotify_ring_empty(struct fanotify_ring *ring)
+{
+	return READ_ONCE(ring->hdr->head) == READ_ONCE(ring->tail);
+}
+
+void fanotify_ring_free(struct fanotify_ring *ring)
+{
+	if (!ring)
+		return;
+	vfree(ring->hdr);
+	put_pid_ns(ring->pid_ns);
+	put_pid(ring->tgid);
+	kfree(ring);
+}
+
+static struct fanotify_ring *fanotify_ring_alloc(size_t size)
+{
+	struct fanotify_ring *ring;
+
+	ring = kzalloc(sizeof(*ring), GFP_KERNEL_ACCOUNT);
+	if (!ring)
+		return NULL;
+
+	/*
+	 * Like vmalloc_user(), but charged to the memcg of the caller, as the
+	 * ring size is chosen by a possibly unprivileged user.
+	 */
+	ring->hdr = __vmalloc_node_range(PAGE_SIZE + size, SHMLBA,
+					 VMALLOC_START, VMALLOC_END,
+					 GFP_KERNEL_ACCOUNT | __GFP_ZERO,
+					 PAGE_KERNEL, VM_USERMAP, NUMA_NO_NODE,
+					 __builtin_return_address(0));
+	if (!ring->hdr) {
+		kfree(ring);
+		return NULL;
+	}
+	spin_lock_init(&ring->lock);
+	ring->data = (void *)ring->hdr + PAGE_SIZE;
+	ring->size = size;
+	ring->hdr->size = size;
+	ring->hdr->data_offset = PAGE_SIZE;
+	ring->pid_ns = get_pid_ns(task_active_pid_ns(current));
+	ring->tgid = get_pid(task_tgid(current));
+	return ring;
+}
+
+/*
+ * Map the shared event ring, setting it up on the first call.  The mapping is
+ * one page of struct fanotify_ring_header followed by the data area, whose
+ * size must be a power of 2.  Later calls must map the same size.
+ *
+ * Only notification class groups in fid mode without FAN_REPORT_PIDFD can use
+ * a ring: ring events have no fds, permission events need the queue to wait
+ * for a response, and pidfds would have to be installed.
+ */
+static int fanotify_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct fsnotify_group *group = file->private_data;
+	unsigned long size = vma->vm_end - vma->vm_start;
+	struct fanotify_ring *ring, *old;
+
+	if (!FAN_GROUP_FLAG(group, FANOTIFY_FID_BITS) ||
+	    FAN_GROUP_FLAG(group, FAN_REPORT_PIDFD) ||
+	    group->priority != FSNOTIFY_PRIO_NORMAL)
+		return -EINVAL;
+
+	if (vma->vm_pgoff || size <= PAGE_SIZE ||
+	    size - PAGE_SIZE > FANOTIFY_RING_MAX_SIZE ||
+	    !is_power_of_2(size - PAGE_SIZE))
+		return -EINVAL;
+
+	ring = smp_load_acquire(&group->fanotify_data.ring);
+	if (!ring) {
+		ring = fanotify_ring_alloc(size - PAGE_SIZE);
+		if (!ring)
+			return -ENOMEM;
+		/* Pairs with smp_load_acquire() in fanotify_ring_add() */
+		old = cmpxchg(&group->fanotify_data.ring, NULL, ring);
+		if (old) {
+			/* Lost a race with another mmap() */
+			fanotify_ring_free(ring);
+			ring = old;
+		}
+	}
+	if (ring->size != size - PAGE_SIZE)
+		return -EINVAL;
+
+	vm_flags_set(vma, VM_DONTEXPAND);
+	return remap_vmalloc_range(vma, ring->hdr, 0);
+}
+
 /* intofiy userspace file descriptor functions */
 static __poll_t fanotify_poll(struct file *file, poll_table *wait)
 {
 	struct fsnotify_group *group = file->private_data;
+	struct fanotify_ring *ring;
 	__poll_t ret = 0;
 
 	poll_wait(file, &group->notification_waitq, wait);
@@ -800,6 +978,14 @@ static __poll_t fanotify_poll(struct file *file, poll_table *wait)
 		ret = EPOLLIN | EPOLLRDNORM;
 	spin_unlock(&group->notification_lock);
 
+	ring = smp_load_acquire(&group->fanotify_data.ring);
+	if (ring) {
+		/* Pairs with smp_mb() in fanotify_ring_add() */
+		smp_mb();
+		if (!fanotify_ring_empty(ring))
+			ret = EPOLLIN | EPOLLRDNORM;
+	}
+
 	return ret;
 }
 
@@ -996,6 +1182,7 @@ static const struct file_operations fanotify_fops = {
 	.poll		= fanotify_poll,
 	.read		= fanotify_read,
 	.write		= fanotify_write,
+	.mmap		= fanotify_mmap,
 	.fasync		= NULL,
 	.release	= fanotify_release,
 	.unlocked_ioctl	= fanotify_ioctl,
@@ -372,9 +372,17 @@ static int send_to_group(__u32 mask, const void *data, int data_type,
 	/* clear ignored on inode modification */
 	if (mask & FS_MODIFY) {
 		fsnotify_foreach_iter_mark_type(iter_info, mark, type) {
-			if (!(mark->flags &
-			      FSNOTIFY_MARK_FLAG_IGNORED_SURV_MODIFY))
-				mark->ignore_mask = 0;
+			struct fsnotify_mark_connector *conn;
+
+			if ((mark->flags &
+			     FSNOTIFY_MARK_FLAG_IGNORED_SURV_MODIFY) ||
+			    !mark->ignore_mask)
+				continue;
+			mark->ignore_mask = 0;
+			/* Drop the object's interest in FS_MODIFY if stale */
+			conn = READ_ONCE(mark->connector);
+			if (conn)
+				fsnotify_recalc_mask_ignored(conn);
 		}
 	}
 
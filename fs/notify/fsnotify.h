@@ -61,6 +61,9 @@ static inline fsnotify_connp_t *fsnotify_sb_marks(struct super_block *sb)
 	return sbinfo ? &sbinfo->sb_marks : NULL;
 }
 
+/* Recalculate object mask after an event cleared an ignore mask */
+extern void fsnotify_recalc_mask_ignored(struct fsnotify_mark_connector *conn);
+
 /* destroy all events sitting in this groups notification queue */
 extern void fsnotify_flush_notify(struct fsnotify_group *group);
 
@@ -233,9 +233,20 @@ static struct inode *fsnotify_update_iref(struct fsnotify_mark_connector *conn,
 	return inode;
 }
 
-static void *__fsnotify_recalc_mask(struct fsnotify_mark_connector *conn)
+static u32 fsnotify_conn_calc_mask(struct fsnotify_mark_connector *conn)
 {
 	u32 new_mask = 0;
+	struct fsnotify_mark *mark;
+
+	hlist_for_each_entry(mark, &conn->list, obj_list) {
+		if (mark->flags & FSNOTIFY_MARK_FLAG_ATTACHED)
+			new_mask |= fsnotify_calc_mask(mark);
+	}
+	return new_mask;
+}
+
+static void *__fsnotify_recalc_mask(struct fsnotify_mark_connector *conn)
+{
 	bool want_iref = false;
 	struct fsnotify_mark *mark;
 
@@ -246,7 +257,6 @@ static void *__fsnotify_recalc_mask(struct fsnotify_mark_connector *conn)
 	hlist_for_each_entry(mark, &conn->list, obj_list) {
 		if (!(mark->flags & FSNOTIFY_MARK_FLAG_ATTACHED))
 			continue;
-		new_mask |= fsnotify_calc_mask(mark);
 		if (conn->type == FSNOTIFY_OBJ_TYPE_INODE &&
 		    !(mark->flags & FSNOTIFY_MARK_FLAG_NO_IREF))
 			want_iref = true;
@@ -255,11 +265,33 @@ static void *__fsnotify_recalc_mask(struct fsnotify_mark_connector *conn)
 	 * We use WRITE_ONCE() to prevent silly compiler optimizations from
 	 * confusing readers not holding conn->lock with partial updates.
 	 */
-	WRITE_ONCE(*fsnotify_conn_mask_p(conn), new_mask);
+	WRITE_ONCE(*fsnotify_conn_mask_p(conn), fsnotify_conn_calc_mask(conn));
 
 	return fsnotify_update_iref(conn, want_iref);
 }
 
+/*
+ * Recalculate the mask of events for a list of marks after an event cleared
+ * the ignore mask of one of them.  A mark with an ignore mask makes its object
+ * show interest in FS_MODIFY so that the ignore mask can be cleared on
+ * modification, and once it has been cleared that interest is stale: left in
+ * place, it sends every later write to the object (with an sb or mount mark,
+ * every write on the sb or mount) through the slow path of fsnotify() just to
+ * find nothing to do.
+ *
+ * Unlike fsnotify_recalc_mask(), this only updates the mask and is called from
+ * event context with SRCU held and a reference to the object, but without any
+ * of the mark locks, so it must not touch the inode reference.
+ */
+void fsnotify_recalc_mask_ignored(struct fsnotify_mark_connector *conn)
+{
+	spin_lock(&conn->lock);
+	if (fsnotify_valid_obj_type(conn->type))
+		WRITE_ONCE(*fsnotify_conn_mask_p(conn),
+			   fsnotify_conn_calc_mask(conn));
+	spin_unlock(&conn->lock);
+}
+
 static bool fsnotify_conn_watches_children(
 					struct fsnotify_mark_connector *conn)
 {
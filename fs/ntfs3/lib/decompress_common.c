@@ -213,6 +213,24 @@ int make_huffman_decode_table(u16 decode_table[], const u32 num_syms,
 			p = (u16 *)decode_table_ptr;
 			n = stores_per_loop;
 
+#ifdef FAST_UNALIGNED_ACCESS
+			/* The short codewords, which have the most entries,
+			 * are filled a machine word at a time.  @n is a power
+			 * of 2, so it is a multiple of the entries per word.
+			 */
+			if (n >= WORDBYTES / sizeof(u16)) {
+				size_t v = repeat_u16(entry);
+
+				n /= WORDBYTES / sizeof(u16);
+				do {
+					put_unaligned(v, (size_t *)p);
+					p += WORDBYTES / sizeof(u16);
+				} while (--n);
+
+				decode_table_ptr = p;
+				continue;
+			}
+#endif
 			do {
 				*p++ = entry;
 			} while (--n);
@@ -227,7 +245,6 @@ int make_huffman_decode_table(u16 decode_table[], const u32 num_syms,
 	 */
 	decode_table_pos = (u16 *)decode_table_ptr - decode_table;
 	if (decode_table_pos != table_num_entries) {
-		u32 j;
 		u32 next_free_tree_slot;
 		u32 cur_codeword;
 
@@ -237,10 +254,9 @@ int make_huffman_decode_table(u16 decode_table[], const u32 num_syms,
 		 * will eventually be filled with the representation of
 		 * the root node of a binary tree.
 		 */
-		j = decode_table_pos;
-		do {
-			decode_table[j] = 0;
-		} while (++j != table_num_entries);
+		memset(&decode_table[decode_table_pos], 0,
+		       (table_num_entries - decode_table_pos) *
+		       sizeof(decode_table[0]));
 
 		/* We allocate child nodes starting at the end of the
 		 * direct lookup table.  Note that there should be
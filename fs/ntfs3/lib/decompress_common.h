@@ -18,8 +18,12 @@
 /* "Force inline" macro (not required, but helpful for performance)  */
 #define forceinline __always_inline
 
-/* Enable whole-word match copying on selected architectures  */
-#if defined(__i386__) || defined(__x86_64__) || defined(__ARM_FEATURE_UNALIGNED)
+/* Enable whole-word match copying and table filling on selected
+ * architectures, and on any the kernel knows to handle unaligned accesses
+ * efficiently.
+ */
+#if defined(__i386__) || defined(__x86_64__) || defined(__ARM_FEATURE_UNALIGNED) || \
+	defined(CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS)
 #  define FAST_UNALIGNED_ACCESS
 #endif
 
@@ -47,6 +51,17 @@ static forceinline size_t repeat_byte(u8 b)
 	return v;
 }
 
+/* Likewise for a word whose 16-bit halves all contain the value 'e'.  */
+static forceinline size_t repeat_u16(u16 e)
+{
+	size_t v;
+
+	v = e;
+	v |= v << 16;
+	v |= v << ((WORDBYTES == 8) ? 32 : 0);
+	return v;
+}
+
 /* Structure that encapsulates a block of in-memory data being interpreted as a
  * stream of bits, optionally with interwoven literal bytes.  Bits are assumed
  * to be stored in little endian 16-bit coding units, with the bits ordered high
@@ -289,11 +304,18 @@ static forceinline u8 *lz_copy(u8 *dst, u32 length, u32 offset, const u8 *bufend
 			dst += WORDBYTES;
 
 			if (dst < end) {
-				do {
+				/* Long match: two words per iteration, as long
+				 * as that stays within WORDBYTES - 1 of @end.
+				 */
+				while (end - dst > (ptrdiff_t)WORDBYTES) {
+					copy_unaligned_word(src, dst);
+					copy_unaligned_word(src + WORDBYTES,
+							    dst + WORDBYTES);
+					src += 2 * WORDBYTES;
+					dst += 2 * WORDBYTES;
+				}
+				if (dst < end)
 					copy_unaligned_word(src, dst);
-					src += WORDBYTES;
-					dst += WORDBYTES;
-				} while (dst < end);
 			}
 			return end;
 		} else if (offset == 1) {
@@ -312,14 +334,19 @@ static forceinline u8 *lz_copy(u8 *dst, u32 length, u32 offset, const u8 *bufend
 			return end;
 		}
 		/*
-		 * We don't bother with special cases for other 'offset <
-		 * WORDBYTES', which are usually rarer than 'offset == 1'.  Extra
-		 * checks will just slow things down.  Actually, it's possible
-		 * to handle all the 'offset < WORDBYTES' cases using the same
-		 * code, but it still becomes more complicated doesn't seem any
-		 * faster overall; it definitely slows down the more common
-		 * 'offset == 1' case.
+		 * Other 'offset < WORDBYTES' matches repeat a short pattern,
+		 * e.g. runs of 16-bit or 32-bit values.  A word read from @src
+		 * then overlaps @dst, but its first 'offset' bytes are already
+		 * final, so store it and advance by 'offset' only.  Each store
+		 * completes 'offset' more bytes, which is still fewer
+		 * operations than the bytewise copy below.
 		 */
+		do {
+			copy_unaligned_word(src, dst);
+			src += offset;
+			dst += offset;
+		} while (dst < end);
+		return end;
 	}
 #endif /* FAST_UNALIGNED_ACCESS */
 
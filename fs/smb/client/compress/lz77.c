@@ -9,6 +9,8 @@
 #include <linux/slab.h>
 #include <linux/sizes.h>
 #include <linux/count_zeros.h>
+#include <linux/completion.h>
+#include <linux/log2.h>
 #include <linux/unaligned.h>
 
 #include "lz77.h"
@@ -233,3 +235,101 @@ noinline int lz77_compress(const void *src, u32 slen, void *dst, u32 *dlen)
 
 	return -EMSGSIZE;
 }
+
+/*
+ * Heuristic to skip data that will not compress (already compressed or
+ * encrypted), much cheaper than compressing it to find out. Estimate the
+ * Shannon entropy of the byte distribution from a sample of the data, and
+ * consider data with more than 7 bits of entropy per byte as incompressible.
+ */
+#define LZ77_SAMPLE_LEN		16
+#define LZ77_SAMPLE_STEP	SZ_512
+#define LZ77_SAMPLE_MAX		SZ_8K
+#define LZ77_ENTROPY_MAX	7
+
+/* log2(n) with 2 more bits of precision, by taking log2(n^4) */
+static __always_inline u32 lz77_ilog2_w(u32 n)
+{
+	return ilog2((u64)n * n * n * n);
+}
+
+bool lz77_is_compressible(const void *src, u32 slen)
+{
+	u32 count[256] = {};
+	u32 total = 0, sum = 0;
+	u32 pos, i;
+
+	if (slen < SZ_4K)
+		return true;
+
+	for (pos = 0; pos + LZ77_SAMPLE_LEN <= slen && total < LZ77_SAMPLE_MAX;
+	     pos += LZ77_SAMPLE_STEP) {
+		const u8 *p = src + pos;
+
+		for (i = 0; i < LZ77_SAMPLE_LEN; i++)
+			count[p[i]]++;
+		total += LZ77_SAMPLE_LEN;
+	}
+
+	/* entropy * total = total * log2(total) - sum(c * log2(c)) */
+	for (i = 0; i < ARRAY_SIZE(count); i++)
+		if (count[i])
+			sum += count[i] * lz77_ilog2_w(count[i]);
+
+	return total * lz77_ilog2_w(total) - sum <=
+	       total * LZ77_ENTROPY_MAX * 4;
+}
+
+/*
+ * Parallel compression of large buffers. Each chunk is compressed alone, on
+ * its own CPU, so the caller must send each as a separate compressed payload
+ * (e.g. in a chained compression transform). The calling thread compresses the
+ * first chunk itself and waits for the others.
+ */
+struct lz77_batch {
+	atomic_t pending;
+	struct completion done;
+};
+
+static void lz77_compress_chunk(struct lz77_chunk *chunk)
+{
+	if (!lz77_is_compressible(chunk->src, chunk->slen)) {
+		chunk->ret = -EMSGSIZE;
+		return;
+	}
+
+	chunk->ret = lz77_compress(chunk->src, chunk->slen, chunk->dst,
+				   &chunk->dlen);
+}
+
+static void lz77_compress_work(struct work_struct *work)
+{
+	struct lz77_chunk *chunk = container_of(work, struct lz77_chunk, work);
+	struct lz77_batch *batch = chunk->batch;
+
+	lz77_compress_chunk(chunk);
+	if (atomic_dec_and_test(&batch->pending))
+		complete(&batch->done);
+}
+
+void lz77_compress_chunks(struct lz77_chunk *chunks, unsigned int nr)
+{
+	struct lz77_batch batch;
+	unsigned int i;
+
+	if (!nr)
+		return;
+
+	atomic_set(&batch.pending, nr);
+	init_completion(&batch.done);
+
+	for (i = 1; i < nr; i++) {
+		chunks[i].batch = &batch;
+		INIT_WORK(&chunks[i].work, lz77_compress_work);
+		queue_work(system_unbound_wq, &chunks[i].work);
+	}
+
+	lz77_compress_chunk(&chunks[0]);
+	if (!atomic_dec_and_test(&batch.pending))
+		wait_for_completion(&batch.done);
+}
@@ -10,6 +10,33 @@
 #define _SMB_COMPRESS_LZ77_H
 
 #include <linux/kernel.h>
+#include <linux/workqueue.h>
 
+/* Size of a destination buffer that can hold any compressed output of @len */
+#define LZ77_COMPRESS_BOUND(len)	((len) + ((len) >> 3) + 8)
+
+/* Chunk size for lz77_compress_chunks(), each chunk is compressed alone */
+#define LZ77_CHUNK_SIZE			SZ_256K
+
+/*
+ * One independently compressed chunk of a larger buffer. @dst must be
+ * LZ77_COMPRESS_BOUND(@slen) bytes. On return, @ret is 0 and @dlen is the
+ * compressed size, or @ret is -EMSGSIZE if the chunk is not worth compressing
+ * and should be sent uncompressed, or another negative error.
+ */
+struct lz77_chunk {
+	const void *src;
+	void *dst;
+	u32 slen;
+	u32 dlen;
+	int ret;
+
+	/* private */
+	struct work_struct work;
+	struct lz77_batch *batch;
+};
+
+bool lz77_is_compressible(const void *src, u32 slen);
 int lz77_compress(const void *src, u32 slen, void *dst, u32 *dlen);
+void lz77_compress_chunks(struct lz77_chunk *chunks, unsigned int nr);
 #endif /* _SMB_COMPRESS_LZ77_H */
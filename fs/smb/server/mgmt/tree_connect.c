@@ -126,7 +126,8 @@ int ksmbd_tree_conn_disconnect(struct ksmbd_session *sess,
 	ret = ksmbd_ipc_tree_disconnect_request(sess->id, tree_conn->id);
 	ksmbd_release_tree_conn_id(sess, tree_conn->id);
 	ksmbd_share_config_put(tree_conn->share_conf);
-	kfree(tree_conn);
+	/* ksmbd_tree_conn_lookup() may still be looking at it */
+	kfree_rcu(tree_conn, rcu);
 	return ret;
 }
 
@@ -135,15 +136,23 @@ struct ksmbd_tree_connect *ksmbd_tree_conn_lookup(struct ksmbd_session *sess,
 {
 	struct ksmbd_tree_connect *tcon;
 
-	read_lock(&sess->tree_conns_lock);
+	/*
+	 * Lockless: a tree connect being disconnected either has its state
+	 * changed first, which is rechecked once a reference is held, or is
+	 * waited on by the disconnect until the reference is put.
+	 */
+	rcu_read_lock();
 	tcon = xa_load(&sess->tree_conns, id);
 	if (tcon) {
-		if (tcon->t_state != TREE_CONNECTED)
+		if (READ_ONCE(tcon->t_state) != TREE_CONNECTED ||
+		    !atomic_inc_not_zero(&tcon->refcount)) {
 			tcon = NULL;
-		else if (!atomic_inc_not_zero(&tcon->refcount))
+		} else if (READ_ONCE(tcon->t_state) != TREE_CONNECTED) {
+			ksmbd_tree_connect_put(tcon);
 			tcon = NULL;
+		}
 	}
-	read_unlock(&sess->tree_conns_lock);
+	rcu_read_unlock();
 
 	return tcon;
 }
@@ -35,6 +35,7 @@ struct ksmbd_tree_connect {
 	atomic_t			refcount;
 	wait_queue_head_t		refcount_q;
 	unsigned int			t_state;
+	struct rcu_head			rcu;
 };
 
 struct ksmbd_tree_conn_status {
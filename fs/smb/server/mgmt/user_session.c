@@ -7,6 +7,7 @@
 #include <linux/slab.h>
 #include <linux/rwsem.h>
 #include <linux/xarray.h>
+#include <linux/wait_bit.h>
 
 #include "ksmbd_ida.h"
 #include "user_session.h"
@@ -18,10 +19,24 @@
 
 static DEFINE_IDA(session_ida);
 
-#define SESSION_HASH_BITS		3
+/*
+ * Sessions are looked up on every request, by id in the connection's
+ * sessions xarray, or for session binding in sessions_table. Both lookups are
+ * done under RCU only. Changes to the tables and session teardown are still
+ * serialized by sessions_table_lock and conn->session_lock, and sessions are
+ * freed after an RCU grace period.
+ *
+ * An idle session has a zero refcount. Expiring it moves the refcount to
+ * SESSION_DEAD, after which lockless lookups can no longer take a reference.
+ * Every destroy path does so before freeing the session, waiting for the
+ * references of in-flight requests to drop if needed.
+ */
+#define SESSION_HASH_BITS		12
 static DEFINE_HASHTABLE(sessions_table, SESSION_HASH_BITS);
 static DECLARE_RWSEM(sessions_table_lock);
 
+#define SESSION_DEAD			(-1)
+
 struct ksmbd_session_rpc {
 	int			id;
 	unsigned int		method;
@@ -157,22 +172,65 @@ void ksmbd_session_destroy(struct ksmbd_session *sess)
 	free_channel_list(sess);
 	kfree(sess->Preauth_HashValue);
 	ksmbd_release_id(&session_ida, sess->id);
-	kfree(sess);
+	kfree_rcu(sess, rcu);
 }
 
+/* Called with sessions_table_lock held, or under RCU. */
 struct ksmbd_session *__session_lookup(unsigned long long id)
 {
 	struct ksmbd_session *sess;
 
-	hash_for_each_possible(sessions_table, sess, hlist, id) {
+	hash_for_each_possible_rcu(sessions_table, sess, hlist, id,
+				   lockdep_is_held(&sessions_table_lock)) {
 		if (id == sess->id) {
-			sess->last_active = jiffies;
+			WRITE_ONCE(sess->last_active, jiffies);
 			return sess;
 		}
 	}
 	return NULL;
 }
 
+static bool ksmbd_user_session_tryget(struct ksmbd_session *sess)
+{
+	return atomic_inc_unless_negative(&sess->refcnt);
+}
+
+/*
+ * Unpublish @sess, called with sessions_table_lock and, if @sess is in the
+ * sessions of a connection, its session_lock held. An idle session is
+ * destroyed right away, otherwise it is queued on @dead for
+ * ksmbd_sessions_reap() to destroy once its references are gone.
+ */
+static void ksmbd_session_unpublish(struct ksmbd_session *sess,
+				    struct list_head *dead)
+{
+	bool idle = atomic_cmpxchg(&sess->refcnt, 0, SESSION_DEAD) == 0;
+
+	hash_del_rcu(&sess->hlist);
+	if (idle)
+		ksmbd_session_destroy(sess);
+	else
+		list_add_tail(&sess->dead_entry, dead);
+}
+
+/*
+ * Called without locks, as requests holding a reference may need them. The
+ * sessions are unpublished, so once their refcount drops to zero no lookup
+ * can take a new reference after it is moved to SESSION_DEAD.
+ */
+static void ksmbd_sessions_reap(struct list_head *dead)
+{
+	struct ksmbd_session *sess, *tmp;
+
+	list_for_each_entry_safe(sess, tmp, dead, dead_entry) {
+		wait_var_event(&sess->refcnt,
+			       atomic_cmpxchg(&sess->refcnt, 0,
+					      SESSION_DEAD) == 0);
+		list_del(&sess->dead_entry);
+		ksmbd_session_destroy(sess);
+	}
+}
+
 static void ksmbd_expire_session(struct ksmbd_conn *conn)
 {
 	unsigned long id;
@@ -184,9 +242,10 @@ static void ksmbd_expire_session(struct ksmbd_conn *conn)
 		if (atomic_read(&sess->refcnt) == 0 &&
 		    (sess->state != SMB2_SESSION_VALID ||
 		     time_after(jiffies,
-			       sess->last_active + SMB2_SESSION_TIMEOUT))) {
+			       sess->last_active + SMB2_SESSION_TIMEOUT)) &&
+		    atomic_cmpxchg(&sess->refcnt, 0, SESSION_DEAD) == 0) {
 			xa_erase(&conn->sessions, sess->id);
-			hash_del(&sess->hlist);
+			hash_del_rcu(&sess->hlist);
 			ksmbd_session_destroy(sess);
 			continue;
 		}
@@ -220,6 +279,7 @@ void ksmbd_sessions_deregister(struct ksmbd_conn *conn)
 {
 	struct ksmbd_session *sess;
 	unsigned long id;
+	LIST_HEAD(dead);
 
 	down_write(&sessions_table_lock);
 	if (conn->binding) {
@@ -228,10 +288,8 @@ void ksmbd_sessions_deregister(struct ksmbd_conn *conn)
 
 		hash_for_each_safe(sessions_table, bkt, tmp, sess, hlist) {
 			if (!ksmbd_chann_del(conn, sess) &&
-			    xa_empty(&sess->ksmbd_chann_list)) {
-				hash_del(&sess->hlist);
-				ksmbd_session_destroy(sess);
-			}
+			    xa_empty(&sess->ksmbd_chann_list))
+				ksmbd_session_unpublish(sess, &dead);
 		}
 	}
 
@@ -248,12 +306,13 @@ void ksmbd_sessions_deregister(struct ksmbd_conn *conn)
 		ksmbd_chann_del(conn, sess);
 		if (xa_empty(&sess->ksmbd_chann_list)) {
 			xa_erase(&conn->sessions, sess->id);
-			hash_del(&sess->hlist);
-			ksmbd_session_destroy(sess);
+			ksmbd_session_unpublish(sess, &dead);
 		}
 	}
 	up_write(&conn->session_lock);
 	up_write(&sessions_table_lock);
+
+	ksmbd_sessions_reap(&dead);
 }
 
 struct ksmbd_session *ksmbd_session_lookup(struct ksmbd_conn *conn,
@@ -261,13 +320,13 @@ struct ksmbd_session *ksmbd_session_lookup(struct ksmbd_conn *conn,
 {
 	struct ksmbd_session *sess;
 
-	down_read(&conn->session_lock);
+	rcu_read_lock();
 	sess = xa_load(&conn->sessions, id);
-	if (sess) {
-		sess->last_active = jiffies;
-		ksmbd_user_session_get(sess);
-	}
-	up_read(&conn->session_lock);
+	if (sess && ksmbd_user_session_tryget(sess))
+		WRITE_ONCE(sess->last_active, jiffies);
+	else
+		sess = NULL;
+	rcu_read_unlock();
 	return sess;
 }
 
@@ -275,11 +334,11 @@ struct ksmbd_session *ksmbd_session_lookup_slowpath(unsigned long long id)
 {
 	struct ksmbd_session *sess;
 
-	down_read(&sessions_table_lock);
+	rcu_read_lock();
 	sess = __session_lookup(id);
-	if (sess)
-		ksmbd_user_session_get(sess);
-	up_read(&sessions_table_lock);
+	if (sess && !ksmbd_user_session_tryget(sess))
+		sess = NULL;
+	rcu_read_unlock();
 
 	return sess;
 }
@@ -309,8 +368,9 @@ void ksmbd_user_session_put(struct ksmbd_session *sess)
 
 	if (atomic_read(&sess->refcnt) <= 0)
 		WARN_ON(1);
-	else
-		atomic_dec(&sess->refcnt);
+	else if (atomic_dec_and_test(&sess->refcnt))
+		/* ksmbd_sessions_reap() may be waiting for the last one */
+		wake_up_var(&sess->refcnt);
 }
 
 struct preauth_session *ksmbd_preauth_session_alloc(struct ksmbd_conn *conn,
@@ -426,7 +486,7 @@ static struct ksmbd_session *__session_create(int protocol)
 	ida_init(&sess->tree_conn_ida);
 
 	down_write(&sessions_table_lock);
-	hash_add(sessions_table, &sess->hlist, sess->id);
+	hash_add_rcu(sessions_table, &sess->hlist, sess->id);
 	up_write(&sessions_table_lock);
 
 	return sess;
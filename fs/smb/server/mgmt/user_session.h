@@ -63,6 +63,9 @@ struct ksmbd_session {
 	rwlock_t			tree_conns_lock;
 
 	atomic_t			refcnt;
+	/* unpublished, waiting for references to drop before destroy */
+	struct list_head		dead_entry;
+	struct rcu_head			rcu;
 };
 
 static inline int test_session_flag(struct ksmbd_session *sess, int bit)
@@ -69,6 +69,9 @@ struct fsverity_info {
 	u8 file_digest[FS_VERITY_MAX_DIGEST_SIZE];
 	const struct inode *inode;
 	unsigned long *hash_block_verified;
+	/* Trusted digests of hash blocks, see hash_cache.c */
+	struct xarray hash_cache;
+	struct list_head hash_cache_link;
 };
 
 #define FS_VERITY_MAX_SIGNATURE_SIZE	(FS_VERITY_MAX_DESCRIPTOR_SIZE - \
@@ -88,6 +91,16 @@ int fsverity_hash_buffer(const struct fsverity_hash_alg *alg,
 			 const void *data, size_t size, u8 *out);
 void __init fsverity_check_hash_algs(void);
 
+/* hash_cache.c */
+
+void fsverity_hash_cache_init(struct fsverity_info *vi);
+bool fsverity_hash_cache_lookup(struct fsverity_info *vi,
+				unsigned long hblock_idx, u8 *digest);
+void fsverity_hash_cache_insert(struct fsverity_info *vi,
+				unsigned long hblock_idx, const u8 *digest);
+void fsverity_hash_cache_destroy(struct fsverity_info *vi);
+void __init fsverity_init_hash_cache(void);
+
 /* init.c */
 
 void __printf(3, 4) __cold
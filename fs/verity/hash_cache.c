@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Cache of trusted Merkle tree hash block digests
+ *
+ * Whether a hash block has been verified is tracked through the page cache
+ * (PG_checked, and the ->hash_block_verified bitmap which is reset whenever
+ * the hash page is re-instantiated), so that hash pages read back from the
+ * backing storage are never trusted without being checked again.  Under
+ * memory pressure this means every re-read hash page leads to a walk up the
+ * tree, re-reading and re-hashing the upper levels until a resident, verified
+ * block or the root is reached.
+ *
+ * To shorten that walk, whenever a hash block is verified the digest it was
+ * verified against is remembered here, keyed by the block's index in the tree.
+ * This digest came from an already trusted parent, so a re-read copy of the
+ * hash block can later be verified by comparing its hash with the cached one,
+ * without looking at any of its ancestors.  Only digests are cached, never the
+ * fact that a block was verified, so a stale page is still caught.
+ *
+ * There is one entry per hash block, i.e. the cache is at most about 1/128 of
+ * the size of the tree with SHA-256 and 4K blocks.  Entries live until the
+ * inode is evicted or the shrinker reclaims them.
+ */
+
+#include "fsverity_private.h"
+
+#include <linux/shrinker.h>
+#include <linux/slab.h>
+
+struct fsverity_cached_hash {
+	struct rcu_head rcu;
+	u8 digest[];
+};
+
+static struct shrinker *fsverity_hash_cache_shrinker;
+static atomic_long_t fsverity_hash_cache_count = ATOMIC_LONG_INIT(0);
+
+/* fsverity_infos with a non-empty cache, in least recently added order */
+static LIST_HEAD(fsverity_hash_cache_infos);
+static DEFINE_SPINLOCK(fsverity_hash_cache_lock);
+
+void fsverity_hash_cache_init(struct fsverity_info *vi)
+{
+	xa_init(&vi->hash_cache);
+	INIT_LIST_HEAD(&vi->hash_cache_link);
+}
+
+/*
+ * Copy the cached digest of the hash block with index @hblock_idx to @digest.
+ * Returns true if there was one.
+ */
+bool fsverity_hash_cache_lookup(struct fsverity_info *vi,
+				unsigned long hblock_idx, u8 *digest)
+{
+	struct fsverity_cached_hash *ch;
+	bool found = false;
+
+	rcu_read_lock();
+	ch = xa_load(&vi->hash_cache, hblock_idx);
+	if (ch) {
+		memcpy(digest, ch->digest, vi->tree_params.digest_size);
+		found = true;
+	}
+	rcu_read_unlock();
+	return found;
+}
+
+/*
+ * Remember @digest as the trusted digest of the hash block with index
+ * @hblock_idx.  The caller must have just verified the block against it.  This
+ * is only an optimization, so failing to allocate is silently ignored.
+ */
+void fsverity_hash_cache_insert(struct fsverity_info *vi,
+				unsigned long hblock_idx, const u8 *digest)
+{
+	struct fsverity_cached_hash *ch;
+	void *old;
+
+	if (!fsverity_hash_cache_shrinker ||
+	    xa_load(&vi->hash_cache, hblock_idx))
+		return;
+
+	ch = kmalloc(struct_size(ch, digest, vi->tree_params.digest_size),
+		     GFP_NOFS | __GFP_NOWARN);
+	if (!ch)
+		return;
+	memcpy(ch->digest, digest, vi->tree_params.digest_size);
+
+	old = xa_cmpxchg(&vi->hash_cache, hblock_idx, NULL, ch,
+			 GFP_NOFS | __GFP_NOWARN);
+	if (old) {
+		/* Lost a race with another verifier, or -ENOMEM */
+		kfree(ch);
+		return;
+	}
+	atomic_long_inc(&fsverity_hash_cache_count);
+
+	spin_lock(&fsverity_hash_cache_lock);
+	if (list_empty(&vi->hash_cache_link))
+		list_add_tail(&vi->hash_cache_link, &fsverity_hash_cache_infos);
+	spin_unlock(&fsverity_hash_cache_lock);
+}
+
+/* Called when the fsverity_info is freed; no lookups can be running. */
+void fsverity_hash_cache_destroy(struct fsverity_info *vi)
+{
+	struct fsverity_cached_hash *ch;
+	unsigned long freed = 0;
+	unsigned long index;
+
+	spin_lock(&fsverity_hash_cache_lock);
+	list_del_init(&vi->hash_cache_link);
+	spin_unlock(&fsverity_hash_cache_lock);
+
+	xa_for_each(&vi->hash_cache, index, ch) {
+		kfree(ch);
+		freed++;
+	}
+	xa_destroy(&vi->hash_cache);
+	atomic_long_sub(freed, &fsverity_hash_cache_count);
+}
+
+static unsigned long fsverity_hash_cache_count_objects(struct shrinker *shrink,
+						       struct shrink_control *sc)
+{
+	unsigned long count = atomic_long_read(&fsverity_hash_cache_count);
+
+	return count ?: SHRINK_EMPTY;
+}
+
+static unsigned long fsverity_hash_cache_scan_objects(struct shrinker *shrink,
+						      struct shrink_control *sc)
+{
+	struct fsverity_cached_hash *ch;
+	struct fsverity_info *vi;
+	unsigned long freed = 0;
+	unsigned long index;
+
+	spin_lock(&fsverity_hash_cache_lock);
+	while (freed < sc->nr_to_scan &&
+	       !list_empty(&fsverity_hash_cache_infos)) {
+		vi = list_first_entry(&fsverity_hash_cache_infos,
+				      struct fsverity_info, hash_cache_link);
+		xa_for_each(&vi->hash_cache, index, ch) {
+			xa_erase(&vi->hash_cache, index);
+			kfree_rcu(ch, rcu);
+			if (++freed >= sc->nr_to_scan)
+				break;
+		}
+		if (xa_empty(&vi->hash_cache))
+			list_del_init(&vi->hash_cache_link);
+		else
+			list_move_tail(&vi->hash_cache_link,
+				       &fsverity_hash_cache_infos);
+	}
+	spin_unlock(&fsverity_hash_cache_lock);
+
+	atomic_long_sub(freed, &fsverity_hash_cache_count);
+	return freed;
+}
+
+void __init fsverity_init_hash_cache(void)
+{
+	struct shrinker *shrinker;
+
+	shrinker = shrinker_alloc(0, "fsverity-hash-cache");
+	if (!shrinker) {
+		/* Not fatal, verification just won't use the cache. */
+		pr_warn("failed to allocate hash cache shrinker\n");
+		return;
+	}
+	shrinker->count_objects = fsverity_hash_cache_count_objects;
+	shrinker->scan_objects = fsverity_hash_cache_scan_objects;
+	shrinker_register(shrinker);
+	fsverity_hash_cache_shrinker = shrinker;
+}
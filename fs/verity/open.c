@@ -187,6 +187,7 @@ struct fsverity_info *fsverity_create_info(const struct inode *inode,
 	if (!vi)
 		return ERR_PTR(-ENOMEM);
 	vi->inode = inode;
+	fsverity_hash_cache_init(vi);
 
 	err = fsverity_init_merkle_tree_params(&vi->tree_params, inode,
 					       desc->hash_algorithm,
@@ -273,6 +274,7 @@ void fsverity_free_info(struct fsverity_info *vi)
 		return;
 	kfree(vi->tree_params.hashstate);
 	kvfree(vi->hash_block_verified);
+	fsverity_hash_cache_destroy(vi);
 	kmem_cache_free(fsverity_info_cachep, vi);
 }
 
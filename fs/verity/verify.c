@@ -79,18 +79,31 @@ static bool is_hash_block_verified(struct fsverity_info *vi, struct page *hpage,
 }
 
 /*
- * Verify a single data block against the file's Merkle tree.
+ * Maximum number of data blocks verified against a single lookup of their
+ * Merkle tree path.  Consecutive data blocks usually have their hashes in the
+ * same leaf hash block, so only the first block of a batch needs to look up
+ * and check the hash blocks; the others just compare against hashes copied
+ * from the same leaf block.
+ */
+#define FSVERITY_MAX_BATCH	8
+
+/*
+ * Get the expected hashes of @nr consecutive data blocks starting at @data_pos,
+ * which must all have their hashes in the same leaf hash block.
  *
  * In principle, we need to verify the entire path to the root node.  However,
  * for efficiency the filesystem may cache the hash blocks.  Therefore we need
- * only ascend the tree until an already-verified hash block is seen, and then
- * verify the path to that block.
+ * only ascend the tree until an already-verified hash block, or a hash block
+ * whose trusted digest is in the hash cache, is seen, and then verify the path
+ * to that block.
  *
- * Return: %true if the data block is valid, else %false.
+ * Return: %true if the path to the leaf hash block is valid and the hashes have
+ * been copied to @want_hashes, else %false.
  */
 static bool
-verify_data_block(struct inode *inode, struct fsverity_info *vi,
-		  const void *data, u64 data_pos, unsigned long max_ra_pages)
+fsverity_get_data_hashes(struct inode *inode, struct fsverity_info *vi,
+			 u64 data_pos, unsigned int nr, u8 *want_hashes,
+			 unsigned long max_ra_pages)
 {
 	const struct merkle_tree_params *params = &vi->tree_params;
 	const unsigned int hsize = params->digest_size;
@@ -115,25 +128,8 @@ verify_data_block(struct inode *inode, struct fsverity_info *vi,
 	 */
 	u64 hidx = data_pos >> params->log_blocksize;
 
-	/* Up to 1 + FS_VERITY_MAX_LEVELS pages may be mapped at once */
-	BUILD_BUG_ON(1 + FS_VERITY_MAX_LEVELS > KM_MAX_IDX);
-
-	if (unlikely(data_pos >= inode->i_size)) {
-		/*
-		 * This can happen in the data page spanning EOF when the Merkle
-		 * tree block size is less than the page size.  The Merkle tree
-		 * doesn't cover data blocks fully past EOF.  But the entire
-		 * page spanning EOF can be visible to userspace via a mmap, and
-		 * any part past EOF should be all zeroes.  Therefore, we need
-		 * to verify that any data blocks fully past EOF are all zeroes.
-		 */
-		if (memchr_inv(data, 0, params->block_size)) {
-			fsverity_err(inode,
-				     "FILE CORRUPTED!  Data past EOF is not zeroed");
-			return false;
-		}
-		return true;
-	}
+	/* Up to FS_VERITY_MAX_LEVELS pages may be mapped at once */
+	BUILD_BUG_ON(FS_VERITY_MAX_LEVELS > KM_MAX_IDX);
 
 	/*
 	 * Starting at the leaf level, ascend the tree saving hash blocks along
@@ -180,6 +176,13 @@ verify_data_block(struct inode *inode, struct fsverity_info *vi,
 		}
 		haddr = kmap_local_page(hpage) + hblock_offset_in_page;
 		if (is_hash_block_verified(vi, hpage, hblock_idx)) {
+			if (level == 0) {
+				memcpy(want_hashes, haddr + hoffset,
+				       nr * hsize);
+				kunmap_local(haddr);
+				put_page(hpage);
+				return true;
+			}
 			memcpy(_want_hash, haddr + hoffset, hsize);
 			want_hash = _want_hash;
 			kunmap_local(haddr);
@@ -190,10 +193,25 @@ verify_data_block(struct inode *inode, struct fsverity_info *vi,
 		hblocks[level].addr = haddr;
 		hblocks[level].index = hblock_idx;
 		hblocks[level].hoffset = hoffset;
+		/*
+		 * If the block's hash page was evicted since the block was last
+		 * verified, its trusted digest may still be cached, in which
+		 * case there is no need to go further up the tree.
+		 */
+		if (fsverity_hash_cache_lookup(vi, hblock_idx, _want_hash)) {
+			want_hash = _want_hash;
+			level++;
+			goto descend;
+		}
 		hidx = next_hidx;
 	}
 
 	want_hash = vi->root_hash;
+	if (level == 0) {
+		/* A single block file has no tree, its hash is the root hash */
+		memcpy(want_hashes, want_hash, hsize);
+		return true;
+	}
 descend:
 	/* Descend the tree verifying hash blocks. */
 	for (; level > 0; level--) {
@@ -215,17 +233,16 @@ verify_data_block(struct inode *inode, struct fsverity_info *vi,
 			set_bit(hblock_idx, vi->hash_block_verified);
 		else
 			SetPageChecked(hpage);
-		memcpy(_want_hash, haddr + hoffset, hsize);
-		want_hash = _want_hash;
+		fsverity_hash_cache_insert(vi, hblock_idx, real_hash);
+		if (level == 1) {
+			memcpy(want_hashes, haddr + hoffset, nr * hsize);
+		} else {
+			memcpy(_want_hash, haddr + hoffset, hsize);
+			want_hash = _want_hash;
+		}
 		kunmap_local(haddr);
 		put_page(hpage);
 	}
-
-	/* Finally, verify the data block. */
-	if (fsverity_hash_block(params, inode, data, real_hash) != 0)
-		goto error;
-	if (memcmp(want_hash, real_hash, hsize) != 0)
-		goto corrupted;
 	return true;
 
 corrupted:
@@ -242,14 +259,39 @@ verify_data_block(struct inode *inode, struct fsverity_info *vi,
 	return false;
 }
 
+/*
+ * Verify a data block fully past EOF.
+ *
+ * This can happen in the data page spanning EOF when the Merkle tree block size
+ * is less than the page size.  The Merkle tree doesn't cover data blocks fully
+ * past EOF.  But the entire page spanning EOF can be visible to userspace via a
+ * mmap, and any part past EOF should be all zeroes.  Therefore, we need to
+ * verify that any data blocks fully past EOF are all zeroes.
+ */
+static bool verify_data_block_past_eof(struct inode *inode,
+				       const struct merkle_tree_params *params,
+				       const void *data)
+{
+	if (memchr_inv(data, 0, params->block_size)) {
+		fsverity_err(inode,
+			     "FILE CORRUPTED!  Data past EOF is not zeroed");
+		return false;
+	}
+	return true;
+}
+
 static bool
 verify_data_blocks(struct folio *data_folio, size_t len, size_t offset,
 		   unsigned long max_ra_pages)
 {
 	struct inode *inode = data_folio->mapping->host;
 	struct fsverity_info *vi = inode->i_verity_info;
-	const unsigned int block_size = vi->tree_params.block_size;
+	const struct merkle_tree_params *params = &vi->tree_params;
+	const unsigned int block_size = params->block_size;
+	const unsigned int hsize = params->digest_size;
 	u64 pos = (u64)data_folio->index << PAGE_SHIFT;
+	u8 want_hashes[FSVERITY_MAX_BATCH * FS_VERITY_MAX_DIGEST_SIZE];
+	u8 real_hash[FS_VERITY_MAX_DIGEST_SIZE];
 
 	if (WARN_ON_ONCE(len <= 0 || !IS_ALIGNED(len | offset, block_size)))
 		return false;
@@ -257,17 +299,59 @@ verify_data_blocks(struct folio *data_folio, size_t len, size_t offset,
 			 folio_test_uptodate(data_folio)))
 		return false;
 	do {
+		u64 data_pos = pos + offset;
+		u64 hidx = data_pos >> params->log_blocksize;
+		unsigned int nr, i;
 		void *data;
 		bool valid;
 
-		data = kmap_local_folio(data_folio, offset);
-		valid = verify_data_block(inode, vi, data, pos + offset,
-					  max_ra_pages);
-		kunmap_local(data);
-		if (!valid)
+		if (unlikely(data_pos >= inode->i_size)) {
+			data = kmap_local_folio(data_folio, offset);
+			valid = verify_data_block_past_eof(inode, params, data);
+			kunmap_local(data);
+			if (!valid)
+				return false;
+			offset += block_size;
+			len -= block_size;
+			continue;
+		}
+
+		/*
+		 * Batch the following blocks that are before EOF and have their
+		 * hashes in the same leaf hash block.
+		 */
+		nr = min_t(u64, len >> params->log_blocksize,
+			   DIV_ROUND_UP_ULL(inode->i_size - data_pos, block_size));
+		nr = min3(nr, (unsigned int)FSVERITY_MAX_BATCH,
+			  params->hashes_per_block -
+			  (unsigned int)(hidx & (params->hashes_per_block - 1)));
+
+		if (!fsverity_get_data_hashes(inode, vi, data_pos, nr,
+					      want_hashes, max_ra_pages))
 			return false;
-		offset += block_size;
-		len -= block_size;
+
+		for (i = 0; i < nr; i++) {
+			const u8 *want_hash = &want_hashes[i * hsize];
+			int err;
+
+			data = kmap_local_folio(data_folio, offset);
+			err = fsverity_hash_block(params, inode, data,
+						  real_hash);
+			kunmap_local(data);
+			if (err)
+				return false;
+			if (memcmp(want_hash, real_hash, hsize) != 0) {
+				fsverity_err(inode,
+					     "FILE CORRUPTED! pos=%llu, level=-1, want_hash=%s:%*phN, real_hash=%s:%*phN",
+					     pos + offset,
+					     params->hash_alg->name, hsize,
+					     want_hash, params->hash_alg->name,
+					     hsize, real_hash);
+				return false;
+			}
+			offset += block_size;
+			len -= block_size;
+		}
 	} while (len);
 	return true;
 }
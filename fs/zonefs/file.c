@@ -152,7 +152,13 @@ static const struct iomap_writeback_ops zonefs_writeback_ops = {
 static int zonefs_writepages(struct address_space *mapping,
 			     struct writeback_control *wbc)
 {
-	struct iomap_writepage_ctx wpc = { };
+	/*
+	 * Conventional zone files are fully mapped and never shared, so small
+	 * clean gaps between dirty blocks can always be written back with them.
+	 */
+	struct iomap_writepage_ctx wpc = {
+		.max_clean_gap	= SZ_16K,
+	};
 
 	return iomap_writepages(mapping, wbc, &wpc, &zonefs_writeback_ops);
 }
@@ -224,6 +230,9 @@ int zonefs_file_truncate(struct inode *inode, loff_t isize)
 	if (ret)
 		goto unlock;
 
+	if (op == REQ_OP_ZONE_RESET)
+		atomic_inc(&z->z_resets);
+
 	/*
 	 * If the mount option ZONEFS_MNTOPT_EXPLICIT_OPEN is set,
 	 * take care of open zones.
@@ -367,6 +376,7 @@ static int zonefs_file_write_dio_end_io(struct kiocb *iocb, ssize_t size,
 		 * size to the write end location.
 		 */
 		mutex_lock(&zi->i_truncate_mutex);
+		zonefs_account_write(inode, size);
 		if (i_size_read(inode) < iocb->ki_pos + size) {
 			zonefs_update_stats(inode, iocb->ki_pos + size);
 			zonefs_i_size_write(inode, iocb->ki_pos + size);
@@ -444,6 +454,264 @@ static ssize_t zonefs_write_checks(struct kiocb *iocb, struct iov_iter *from)
 	return iov_iter_count(from);
 }
 
+/*
+ * Zone append direct writes to sequential zone files.
+ *
+ * O_APPEND or RWF_APPEND direct writes are issued as a single
+ * REQ_OP_ZONE_APPEND BIO each, and the device chooses where the data goes.
+ * Since no write position needs to be enforced, these writes only take the
+ * inode lock shared and any number of them can be in flight for the same
+ * file. The space is reserved by advancing the zone write pointer offset on
+ * submission, and the location chosen by the device is reported on
+ * completion in iocb->ki_pos, which is set to the end of the written data,
+ * that is, the data was written at iocb->ki_pos - ret.
+ *
+ * Zone append writes and regular writes cannot be in flight at the same time
+ * for a zone, so switching between the two waits for all direct IOs to
+ * complete (see zonefs_file_dio_switch_mode()).
+ */
+struct zonefs_append_dio {
+	struct kiocb		*iocb;
+	struct work_struct	work;
+	ssize_t			size;
+	/* Must be last */
+	struct bio		bio;
+};
+
+static struct bio_set zonefs_append_bio_set;
+static struct workqueue_struct *zonefs_append_wq;
+
+static bool zonefs_file_dio_switch_mode(struct kiocb *iocb, bool append)
+{
+	struct inode *inode = file_inode(iocb->ki_filp);
+	struct zonefs_inode_info *zi = ZONEFS_I(inode);
+
+	if (READ_ONCE(zi->i_dio_append) == append)
+		return true;
+
+	if (iocb->ki_flags & IOCB_NOWAIT)
+		return false;
+
+	/*
+	 * With the inode lock held exclusive, no zone append write can be
+	 * issued, and with the inode lock held shared, no regular write can be
+	 * issued. So once the in-flight direct IOs are drained, the zone
+	 * cannot see a mix of both.
+	 */
+	inode_dio_wait(inode);
+	WRITE_ONCE(zi->i_dio_append, append);
+
+	return true;
+}
+
+static ssize_t zonefs_file_dio_append_end(struct zonefs_append_dio *dio,
+					  int error)
+{
+	struct kiocb *iocb = dio->iocb;
+	struct inode *inode = file_inode(iocb->ki_filp);
+	struct zonefs_inode_info *zi = ZONEFS_I(inode);
+	struct zonefs_zone *z = zonefs_inode_zone(inode);
+	struct bio *bio = &dio->bio;
+	ssize_t ret = dio->size;
+	loff_t pos;
+
+	/* On completion, the BIO sector is the one written by the device */
+	pos = (bio->bi_iter.bi_sector - z->z_sector) << SECTOR_SHIFT;
+
+	/*
+	 * If the file zone was written underneath the file system, the zone
+	 * write pointer may not be where we expect it to be, but the zone
+	 * append write can still succeed. So check that the data went into
+	 * the space reserved for the in-flight zone append writes.
+	 */
+	if (!error) {
+		mutex_lock(&zi->i_truncate_mutex);
+		if (pos < 0 || pos + dio->size > z->z_wpoffset) {
+			zonefs_warn(inode->i_sb,
+				"Corrupted write pointer %llu for zone at %llu\n",
+				bio->bi_iter.bi_sector, z->z_sector);
+			error = -EIO;
+		}
+		mutex_unlock(&zi->i_truncate_mutex);
+	}
+
+	if (!error)
+		iocb->ki_pos = pos;
+	error = zonefs_file_write_dio_end_io(iocb, dio->size, error, 0);
+	if (error) {
+		ret = error;
+	} else {
+		iocb->ki_pos = pos + dio->size;
+		task_io_account_write(dio->size);
+	}
+
+	trace_zonefs_file_dio_append(inode, pos, dio->size, ret);
+
+	bio_release_pages(bio, false);
+	bio_put(bio);
+	inode_dio_end(inode);
+
+	return ret;
+}
+
+static void zonefs_file_dio_append_work(struct work_struct *work)
+{
+	struct zonefs_append_dio *dio =
+		container_of(work, struct zonefs_append_dio, work);
+	struct kiocb *iocb = dio->iocb;
+	ssize_t ret;
+
+	ret = zonefs_file_dio_append_end(dio, blk_status_to_errno(dio->bio.bi_status));
+	iocb->ki_complete(iocb, ret);
+}
+
+static void zonefs_file_dio_append_bio_end_io(struct bio *bio)
+{
+	struct zonefs_append_dio *dio =
+		container_of(bio, struct zonefs_append_dio, bio);
+
+	/* Updating the inode size needs i_truncate_mutex */
+	INIT_WORK(&dio->work, zonefs_file_dio_append_work);
+	queue_work(zonefs_append_wq, &dio->work);
+}
+
+static ssize_t zonefs_file_dio_append(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct file *file = iocb->ki_filp;
+	struct inode *inode = file_inode(file);
+	struct zonefs_inode_info *zi = ZONEFS_I(inode);
+	struct zonefs_zone *z = zonefs_inode_zone(inode);
+	struct block_device *bdev = inode->i_sb->s_bdev;
+	unsigned int blksz = inode->i_sb->s_blocksize;
+	blk_opf_t opf = REQ_OP_ZONE_APPEND | REQ_SYNC | REQ_IDLE;
+	struct zonefs_append_dio *dio;
+	struct bio *bio;
+	loff_t count;
+	ssize_t ret;
+
+	if (iocb->ki_flags & IOCB_NOWAIT) {
+		if (!inode_trylock_shared(inode))
+			return -EAGAIN;
+	} else {
+		inode_lock_shared(inode);
+	}
+
+	if (IS_SWAPFILE(inode)) {
+		ret = -ETXTBSY;
+		goto inode_unlock;
+	}
+
+	if (!zonefs_file_dio_switch_mode(iocb, true)) {
+		ret = -EAGAIN;
+		goto inode_unlock;
+	}
+
+	/* A zone append write cannot be split */
+	iov_iter_truncate(from, ALIGN_DOWN(bdev_max_zone_append_sectors(bdev)
+					   << SECTOR_SHIFT, blksz));
+
+	mutex_lock(&zi->i_truncate_mutex);
+	count = zonefs_write_check_limits(file, z->z_wpoffset,
+					  iov_iter_count(from));
+	mutex_unlock(&zi->i_truncate_mutex);
+	if (count <= 0) {
+		ret = count;
+		goto inode_unlock;
+	}
+	iov_iter_truncate(from, count);
+
+	if (count & (blksz - 1)) {
+		ret = -EINVAL;
+		goto inode_unlock;
+	}
+
+	if (iocb->ki_flags & IOCB_DSYNC)
+		opf |= REQ_FUA;
+
+	bio = bio_alloc_bioset(bdev, bio_iov_vecs_to_alloc(from, BIO_MAX_VECS),
+			       opf, GFP_NOFS, &zonefs_append_bio_set);
+	bio->bi_iter.bi_sector = z->z_sector;
+	bio->bi_ioprio = iocb->ki_ioprio;
+	dio = container_of(bio, struct zonefs_append_dio, bio);
+	dio->iocb = iocb;
+
+	ret = bio_iov_iter_get_pages(bio, from);
+	if (unlikely(ret))
+		goto out_put_bio;
+
+	dio->size = bio->bi_iter.bi_size;
+	if (dio->size & (blksz - 1)) {
+		ret = -EINVAL;
+		goto out_release;
+	}
+
+	/*
+	 * Reserve space in the zone. As for regular writes, this assumes that
+	 * the IO will succeed and, if it fails, the error path will correct
+	 * the write pointer offset.
+	 */
+	mutex_lock(&zi->i_truncate_mutex);
+	if (z->z_wpoffset + dio->size > z->z_capacity) {
+		mutex_unlock(&zi->i_truncate_mutex);
+		ret = -EFBIG;
+		goto out_release;
+	}
+	z->z_wpoffset += dio->size;
+	zonefs_inode_account_active(inode);
+	mutex_unlock(&zi->i_truncate_mutex);
+
+	inode_dio_begin(inode);
+
+	if (is_sync_kiocb(iocb)) {
+		ret = zonefs_file_dio_append_end(dio, submit_bio_wait(bio));
+		if (ret < 0)
+			zonefs_io_error(inode, true);
+	} else {
+		bio->bi_end_io = zonefs_file_dio_append_bio_end_io;
+		submit_bio(bio);
+		ret = -EIOCBQUEUED;
+	}
+
+	inode_unlock_shared(inode);
+
+	return ret;
+
+out_release:
+	bio_release_pages(bio, false);
+out_put_bio:
+	bio_put(bio);
+inode_unlock:
+	inode_unlock_shared(inode);
+
+	return ret;
+}
+
+int __init zonefs_file_init(void)
+{
+	int ret;
+
+	ret = bioset_init(&zonefs_append_bio_set, 4,
+			  offsetof(struct zonefs_append_dio, bio),
+			  BIOSET_NEED_BVECS);
+	if (ret)
+		return ret;
+
+	zonefs_append_wq = alloc_workqueue("zonefs_append",
+					   WQ_MEM_RECLAIM | WQ_UNBOUND, 0);
+	if (!zonefs_append_wq) {
+		bioset_exit(&zonefs_append_bio_set);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+void zonefs_file_exit(void)
+{
+	destroy_workqueue(zonefs_append_wq);
+	bioset_exit(&zonefs_append_bio_set);
+}
+
 /*
  * Handle direct writes. For sequential zone files, this is the only possible
  * write path. For these files, check that the user is issuing writes
@@ -478,6 +746,11 @@ static ssize_t zonefs_file_dio_write(struct kiocb *iocb, struct iov_iter *from)
 		inode_lock(inode);
 	}
 
+	if (zonefs_zone_is_seq(z) && !zonefs_file_dio_switch_mode(iocb, false)) {
+		ret = -EAGAIN;
+		goto inode_unlock;
+	}
+
 	count = zonefs_write_checks(iocb, from);
 	if (count <= 0) {
 		ret = count;
@@ -591,7 +864,13 @@ static ssize_t zonefs_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 		return -EFBIG;
 
 	if (iocb->ki_flags & IOCB_DIRECT) {
-		ssize_t ret = zonefs_file_dio_write(iocb, from);
+		ssize_t ret;
+
+		if (zonefs_zone_is_seq(z) && (iocb->ki_flags & IOCB_APPEND) &&
+		    iov_iter_count(from))
+			return zonefs_file_dio_append(iocb, from);
+
+		ret = zonefs_file_dio_write(iocb, from);
 
 		if (ret != -ENOTBLK)
 			return ret;
@@ -724,45 +1003,55 @@ static inline bool zonefs_seq_file_need_wro(struct inode *inode,
 	return true;
 }
 
-static int zonefs_seq_file_write_open(struct inode *inode)
+static int zonefs_seq_file_write_open(struct inode *inode, struct file *file)
 {
 	struct zonefs_inode_info *zi = ZONEFS_I(inode);
 	struct zonefs_zone *z = zonefs_inode_zone(inode);
+	bool pending_active = false;
 	int ret = 0;
 
 	mutex_lock(&zi->i_truncate_mutex);
+	if (zi->i_wr_refcnt)
+		goto get;
+	mutex_unlock(&zi->i_truncate_mutex);
 
-	if (!zi->i_wr_refcnt) {
-		struct zonefs_sb_info *sbi = ZONEFS_SB(inode->i_sb);
-		unsigned int wro = atomic_inc_return(&sbi->s_wro_seq_files);
+	/*
+	 * Waiting for zone resources is done without i_truncate_mutex held so
+	 * that IOs to the file are not blocked meanwhile.
+	 */
+	ret = zonefs_wro_get(inode, file->f_flags & O_NONBLOCK,
+			     &pending_active);
+	if (ret)
+		return ret;
 
-		if (sbi->s_mount_opts & ZONEFS_MNTOPT_EXPLICIT_OPEN) {
+	mutex_lock(&zi->i_truncate_mutex);
 
-			if (sbi->s_max_wro_seq_files
-			    && wro > sbi->s_max_wro_seq_files) {
-				atomic_dec(&sbi->s_wro_seq_files);
-				ret = -EBUSY;
-				goto unlock;
-			}
+	if (zi->i_wr_refcnt) {
+		/* Raced with another write open of the same file */
+		zonefs_wro_put(inode->i_sb);
+		goto get;
+	}
 
-			if (i_size_read(inode) < z->z_capacity) {
-				ret = zonefs_inode_zone_mgmt(inode,
-							     REQ_OP_ZONE_OPEN);
-				if (ret) {
-					atomic_dec(&sbi->s_wro_seq_files);
-					goto unlock;
-				}
-				z->z_flags |= ZONEFS_ZONE_OPEN;
-				zonefs_inode_account_active(inode);
-			}
+	if ((ZONEFS_SB(inode->i_sb)->s_mount_opts & ZONEFS_MNTOPT_EXPLICIT_OPEN) &&
+	    i_size_read(inode) < z->z_capacity) {
+		ret = zonefs_inode_zone_mgmt(inode, REQ_OP_ZONE_OPEN);
+		if (ret) {
+			zonefs_wro_put(inode->i_sb);
+			goto unlock;
 		}
+		z->z_flags |= ZONEFS_ZONE_OPEN;
+		zonefs_inode_account_active(inode);
 	}
 
+get:
 	zi->i_wr_refcnt++;
 
 unlock:
 	mutex_unlock(&zi->i_truncate_mutex);
 
+	if (pending_active)
+		zonefs_wro_settle(inode->i_sb);
+
 	return ret;
 }
 
@@ -776,7 +1065,7 @@ static int zonefs_file_open(struct inode *inode, struct file *file)
 		return ret;
 
 	if (zonefs_seq_file_need_wro(inode, file))
-		return zonefs_seq_file_write_open(inode);
+		return zonefs_seq_file_write_open(inode, file);
 
 	return 0;
 }
@@ -786,7 +1075,6 @@ static void zonefs_seq_file_write_close(struct inode *inode)
 	struct zonefs_inode_info *zi = ZONEFS_I(inode);
 	struct zonefs_zone *z = zonefs_inode_zone(inode);
 	struct super_block *sb = inode->i_sb;
-	struct zonefs_sb_info *sbi = ZONEFS_SB(sb);
 	int ret = 0;
 
 	mutex_lock(&zi->i_truncate_mutex);
@@ -826,7 +1114,7 @@ static void zonefs_seq_file_write_close(struct inode *inode)
 		zonefs_inode_account_active(inode);
 	}
 
-	atomic_dec(&sbi->s_wro_seq_files);
+	zonefs_wro_put(sb);
 
 unlock:
 	mutex_unlock(&zi->i_truncate_mutex);
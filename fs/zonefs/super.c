@@ -44,6 +44,182 @@ static const char *zonefs_zgroup_name(enum zonefs_ztype ztype)
 	}
 }
 
+/*
+ * Write open scheduling.
+ *
+ * With the explicit-open mount option, opening a sequential file for writing
+ * explicitly opens its zone, which needs an open zone resource and, unless the
+ * zone is already active, an active zone resource of the device. Rather than
+ * failing such open() calls with -EBUSY when these resources are exhausted,
+ * queue them and grant the resources in arrival order as they are released.
+ * A waiter whose zone cannot be activated yet does not hold back later
+ * waiters for zones that are already active. Only O_NONBLOCK opens still get
+ * -EBUSY.
+ *
+ * A grant for a zone that is not active yet reserves an active zone resource
+ * until the opener has activated the zone, or given up, and calls
+ * zonefs_wro_settle().
+ */
+struct zonefs_wro_waiter {
+	struct list_head	list;
+	struct task_struct	*task;
+	struct zonefs_zone	*z;
+	bool			granted;
+	bool			pending_active;
+};
+
+static bool zonefs_wro_needs_active(struct zonefs_sb_info *sbi,
+				    struct zonefs_zone *z)
+{
+	return sbi->s_max_active_seq_files &&
+		!(READ_ONCE(z->z_flags) & ZONEFS_ZONE_ACTIVE);
+}
+
+static bool zonefs_wro_can_grant(struct zonefs_sb_info *sbi,
+				 struct zonefs_zone *z)
+{
+	if (!(sbi->s_mount_opts & ZONEFS_MNTOPT_EXPLICIT_OPEN))
+		return true;
+
+	if (sbi->s_max_wro_seq_files &&
+	    atomic_read(&sbi->s_wro_seq_files) >= sbi->s_max_wro_seq_files)
+		return false;
+
+	if (zonefs_wro_needs_active(sbi, z) &&
+	    atomic_read(&sbi->s_active_seq_files) +
+	    sbi->s_wro_pending_active >= sbi->s_max_active_seq_files)
+		return false;
+
+	return true;
+}
+
+/*
+ * Take the zone resources for a write open of z. Called with sbi->s_lock held.
+ */
+static bool zonefs_wro_grant(struct zonefs_sb_info *sbi,
+			     struct zonefs_zone *z)
+{
+	atomic_inc(&sbi->s_wro_seq_files);
+
+	if (!(sbi->s_mount_opts & ZONEFS_MNTOPT_EXPLICIT_OPEN) ||
+	    !zonefs_wro_needs_active(sbi, z))
+		return false;
+
+	sbi->s_wro_pending_active++;
+	return true;
+}
+
+/*
+ * Grant the zone resources to all the waiters that can now get them.
+ * Called with sbi->s_lock held.
+ */
+static void zonefs_wro_kick(struct zonefs_sb_info *sbi)
+{
+	struct zonefs_wro_waiter *w, *tmp;
+
+	lockdep_assert_held(&sbi->s_lock);
+
+	list_for_each_entry_safe(w, tmp, &sbi->s_wro_waiters, list) {
+		if (!zonefs_wro_can_grant(sbi, w->z))
+			continue;
+		w->pending_active = zonefs_wro_grant(sbi, w->z);
+		w->granted = true;
+		list_del_init(&w->list);
+		wake_up_process(w->task);
+	}
+}
+
+/*
+ * Account for a sequential file being open for writing, waiting for zone
+ * resources if needed. Must not be called with the inode i_truncate_mutex
+ * held. On success, *pending_active tells whether zonefs_wro_settle() must be
+ * called once the zone is activated.
+ */
+int zonefs_wro_get(struct inode *inode, bool nonblock, bool *pending_active)
+{
+	struct zonefs_sb_info *sbi = ZONEFS_SB(inode->i_sb);
+	struct zonefs_wro_waiter w = {
+		.task	= current,
+		.z	= zonefs_inode_zone(inode),
+	};
+	int ret = 0;
+
+	spin_lock(&sbi->s_lock);
+
+	if (list_empty(&sbi->s_wro_waiters) &&
+	    zonefs_wro_can_grant(sbi, w.z)) {
+		w.pending_active = zonefs_wro_grant(sbi, w.z);
+		goto unlock;
+	}
+
+	if (nonblock) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	list_add_tail(&w.list, &sbi->s_wro_waiters);
+	/* Resources may have been released since the check above */
+	zonefs_wro_kick(sbi);
+	for (;;) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (w.granted)
+			break;
+		if (signal_pending(current)) {
+			list_del(&w.list);
+			/* Waiters behind us may now be granted */
+			zonefs_wro_kick(sbi);
+			ret = -ERESTARTSYS;
+			break;
+		}
+		spin_unlock(&sbi->s_lock);
+		schedule();
+		spin_lock(&sbi->s_lock);
+	}
+	__set_current_state(TASK_RUNNING);
+
+unlock:
+	spin_unlock(&sbi->s_lock);
+
+	*pending_active = w.pending_active;
+
+	return ret;
+}
+
+/*
+ * Release the active zone resource reserved by zonefs_wro_get(), after the
+ * zone was activated and accounted in s_active_seq_files, or failed to be.
+ */
+void zonefs_wro_settle(struct super_block *sb)
+{
+	struct zonefs_sb_info *sbi = ZONEFS_SB(sb);
+
+	spin_lock(&sbi->s_lock);
+	sbi->s_wro_pending_active--;
+	zonefs_wro_kick(sbi);
+	spin_unlock(&sbi->s_lock);
+}
+
+void zonefs_wro_put(struct super_block *sb)
+{
+	struct zonefs_sb_info *sbi = ZONEFS_SB(sb);
+
+	spin_lock(&sbi->s_lock);
+	atomic_dec(&sbi->s_wro_seq_files);
+	zonefs_wro_kick(sbi);
+	spin_unlock(&sbi->s_lock);
+}
+
+static void zonefs_dec_active(struct zonefs_sb_info *sbi)
+{
+	atomic_dec(&sbi->s_active_seq_files);
+
+	if (sbi->s_mount_opts & ZONEFS_MNTOPT_EXPLICIT_OPEN) {
+		spin_lock(&sbi->s_lock);
+		zonefs_wro_kick(sbi);
+		spin_unlock(&sbi->s_lock);
+	}
+}
+
 /*
  * Manage the active zone count.
  */
@@ -79,7 +255,7 @@ static void zonefs_account_active(struct super_block *sb,
 	/* The zone is not active. If it was, update the active count */
 	if (z->z_flags & ZONEFS_ZONE_ACTIVE) {
 		z->z_flags &= ~ZONEFS_ZONE_ACTIVE;
-		atomic_dec(&sbi->s_active_seq_files);
+		zonefs_dec_active(sbi);
 	}
 }
 
@@ -145,9 +321,11 @@ void zonefs_i_size_write(struct inode *inode, loff_t isize)
 	if (isize >= z->z_capacity) {
 		struct zonefs_sb_info *sbi = ZONEFS_SB(inode->i_sb);
 
-		if (z->z_flags & ZONEFS_ZONE_ACTIVE)
-			atomic_dec(&sbi->s_active_seq_files);
-		z->z_flags &= ~(ZONEFS_ZONE_OPEN | ZONEFS_ZONE_ACTIVE);
+		z->z_flags &= ~ZONEFS_ZONE_OPEN;
+		if (z->z_flags & ZONEFS_ZONE_ACTIVE) {
+			z->z_flags &= ~ZONEFS_ZONE_ACTIVE;
+			zonefs_dec_active(sbi);
+		}
 	}
 }
 
@@ -183,6 +361,56 @@ void zonefs_update_stats(struct inode *inode, loff_t new_isize)
 	spin_unlock(&sbi->s_lock);
 }
 
+/*
+ * Account a completed write to a sequential file. Called with the inode
+ * i_truncate_mutex held.
+ */
+void zonefs_account_write(struct inode *inode, size_t size)
+{
+	struct zonefs_zone *z = zonefs_inode_zone(inode);
+	unsigned long now = jiffies;
+	unsigned long elapsed;
+
+	lockdep_assert_held(&ZONEFS_I(inode)->i_truncate_mutex);
+
+	atomic64_add(size, &z->z_bytes_written);
+	atomic64_inc(&z->z_write_ios);
+
+	if (!z->z_wp_rate_start)
+		z->z_wp_rate_start = now;
+	z->z_wp_rate_bytes += size;
+
+	elapsed = now - z->z_wp_rate_start;
+	if (elapsed < ZONEFS_WP_RATE_PERIOD)
+		return;
+
+	ewma_zonefs_wp_rate_add(&z->z_wp_rate,
+				div64_ul((u64)z->z_wp_rate_bytes * HZ, elapsed));
+	z->z_wp_rate_start = now;
+	z->z_wp_rate_bytes = 0;
+}
+
+/*
+ * Get the write pointer advancement rate of a sequential zone in bytes per
+ * second. The average is only updated on writes, so halve it for every
+ * period without any write.
+ */
+unsigned long zonefs_zone_wp_rate(struct zonefs_zone *z)
+{
+	unsigned long start = READ_ONCE(z->z_wp_rate_start);
+	unsigned long rate = ewma_zonefs_wp_rate_read(&z->z_wp_rate);
+	unsigned long idle;
+
+	if (!start)
+		return 0;
+
+	idle = (jiffies - start) / ZONEFS_WP_RATE_PERIOD;
+	if (idle > 1)
+		rate >>= min(idle - 1, BITS_PER_LONG - 1);
+
+	return rate;
+}
+
 /*
  * Check a zone condition. Return the amount of written (and still readable)
  * data in the zone.
@@ -426,6 +654,7 @@ static struct inode *zonefs_alloc_inode(struct super_block *sb)
 	inode_init_once(&zi->i_vnode);
 	mutex_init(&zi->i_truncate_mutex);
 	zi->i_wr_refcnt = 0;
+	zi->i_dio_append = false;
 
 	return &zi->i_vnode;
 }
@@ -1276,9 +1505,11 @@ static int zonefs_fill_super(struct super_block *sb, struct fs_context *fc)
 	sbi->s_mount_opts = ctx->s_mount_opts;
 
 	atomic_set(&sbi->s_wro_seq_files, 0);
+	sbi->s_wro_pending_active = 0;
 	sbi->s_max_wro_seq_files = bdev_max_open_zones(sb->s_bdev);
 	atomic_set(&sbi->s_active_seq_files, 0);
 	sbi->s_max_active_seq_files = bdev_max_active_zones(sb->s_bdev);
+	INIT_LIST_HEAD(&sbi->s_wro_waiters);
 
 	ret = zonefs_read_super(sb);
 	if (ret)
@@ -1454,12 +1685,18 @@ static int __init zonefs_init(void)
 	if (ret)
 		goto destroy_inodecache;
 
-	ret = register_filesystem(&zonefs_type);
+	ret = zonefs_file_init();
 	if (ret)
 		goto sysfs_exit;
 
+	ret = register_filesystem(&zonefs_type);
+	if (ret)
+		goto file_exit;
+
 	return 0;
 
+file_exit:
+	zonefs_file_exit();
 sysfs_exit:
 	zonefs_sysfs_exit();
 destroy_inodecache:
@@ -1471,6 +1708,7 @@ static int __init zonefs_init(void)
 static void __exit zonefs_exit(void)
 {
 	unregister_filesystem(&zonefs_type);
+	zonefs_file_exit();
 	zonefs_sysfs_exit();
 	zonefs_destroy_inodecache();
 }
@@ -58,6 +58,52 @@ static ssize_t nr_active_seq_files_show(struct zonefs_sb_info *sbi, char *buf)
 }
 ZONEFS_SYSFS_ATTR_RO(nr_active_seq_files);
 
+/*
+ * Write statistics of sequential zone files, one fixed size line per file,
+ * so that the line of the file "seq/N" starts at offset
+ * N * ZONEFS_SEQ_STAT_LEN. Each line has the file number, the write pointer
+ * offset, the number of bytes written, the number of write IOs and the number
+ * of resets of the zone since mount, and the write pointer advancement rate
+ * in bytes per second.
+ */
+#define ZONEFS_SEQ_STAT_LEN	128
+
+static ssize_t seq_zone_stats_read(struct file *file, struct kobject *kobj,
+				   const struct bin_attribute *attr, char *buf,
+				   loff_t off, size_t count)
+{
+	struct zonefs_sb_info *sbi =
+		container_of(kobj, struct zonefs_sb_info, s_kobj);
+	struct zonefs_zone_group *zgroup = &sbi->s_zgroup[ZONEFS_ZTYPE_SEQ];
+	char line[ZONEFS_SEQ_STAT_LEN + 1];
+	unsigned int i = div_u64(off, ZONEFS_SEQ_STAT_LEN);
+	size_t skip = off - (loff_t)i * ZONEFS_SEQ_STAT_LEN;
+	size_t copied = 0;
+
+	for (; i < zgroup->g_nr_zones && copied < count; i++) {
+		struct zonefs_zone *z = &zgroup->g_zones[i];
+		size_t len;
+
+		len = scnprintf(line, sizeof(line),
+				"%u %lld %lld %lld %d %lu",
+				i, READ_ONCE(z->z_wpoffset),
+				atomic64_read(&z->z_bytes_written),
+				atomic64_read(&z->z_write_ios),
+				atomic_read(&z->z_resets),
+				zonefs_zone_wp_rate(z));
+		memset(line + len, ' ', ZONEFS_SEQ_STAT_LEN - 1 - len);
+		line[ZONEFS_SEQ_STAT_LEN - 1] = '\n';
+
+		len = min(ZONEFS_SEQ_STAT_LEN - skip, count - copied);
+		memcpy(buf + copied, line + skip, len);
+		copied += len;
+		skip = 0;
+	}
+
+	return copied;
+}
+static const BIN_ATTR_RO(seq_zone_stats, 0);
+
 static struct attribute *zonefs_sysfs_attrs[] = {
 	ATTR_LIST(max_wro_seq_files),
 	ATTR_LIST(nr_wro_seq_files),
@@ -65,7 +111,17 @@ static struct attribute *zonefs_sysfs_attrs[] = {
 	ATTR_LIST(nr_active_seq_files),
 	NULL,
 };
-ATTRIBUTE_GROUPS(zonefs_sysfs);
+
+static const struct bin_attribute *const zonefs_sysfs_bin_attrs[] = {
+	&bin_attr_seq_zone_stats,
+	NULL,
+};
+
+static const struct attribute_group zonefs_sysfs_group = {
+	.attrs		= zonefs_sysfs_attrs,
+	.bin_attrs_new	= zonefs_sysfs_bin_attrs,
+};
+__ATTRIBUTE_GROUPS(zonefs_sysfs);
 
 static void zonefs_sysfs_sb_release(struct kobject *kobj)
 {
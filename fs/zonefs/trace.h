@@ -46,12 +46,13 @@ TRACE_EVENT(zonefs_zone_mgmt,
 );
 
 TRACE_EVENT(zonefs_file_dio_append,
-	    TP_PROTO(struct inode *inode, ssize_t size, ssize_t ret),
-	    TP_ARGS(inode, size, ret),
+	    TP_PROTO(struct inode *inode, loff_t pos, ssize_t size, ssize_t ret),
+	    TP_ARGS(inode, pos, size, ret),
 	    TP_STRUCT__entry(
 			     __field(dev_t, dev)
 			     __field(ino_t, ino)
 			     __field(sector_t, sector)
+			     __field(loff_t, pos)
 			     __field(ssize_t, size)
 			     __field(loff_t, wpoffset)
 			     __field(ssize_t, ret)
@@ -60,15 +61,16 @@ TRACE_EVENT(zonefs_file_dio_append,
 			   __entry->dev = inode->i_sb->s_dev;
 			   __entry->ino = inode->i_ino;
 			   __entry->sector = zonefs_inode_zone(inode)->z_sector;
+			   __entry->pos = pos;
 			   __entry->size = size;
 			   __entry->wpoffset =
 				zonefs_inode_zone(inode)->z_wpoffset;
 			   __entry->ret = ret;
 	    ),
-	    TP_printk("bdev=(%d, %d), ino=%lu, sector=%llu, size=%zu, wpoffset=%llu, ret=%zu",
+	    TP_printk("bdev=(%d, %d), ino=%lu, sector=%llu, pos=%lld, size=%zu, wpoffset=%llu, ret=%zd",
 		      show_dev(__entry->dev), (unsigned long)__entry->ino,
-		      __entry->sector, __entry->size, __entry->wpoffset,
-		      __entry->ret
+		      __entry->sector, __entry->pos, __entry->size,
+		      __entry->wpoffset, __entry->ret
 	    )
 );
 
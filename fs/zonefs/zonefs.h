@@ -13,6 +13,7 @@
 #include <linux/mutex.h>
 #include <linux/rwsem.h>
 #include <linux/kobject.h>
+#include <linux/average.h>
 
 /*
  * Maximum length of file names: this only needs to be large enough to fit
@@ -46,6 +47,13 @@ static inline enum zonefs_ztype zonefs_zone_type(struct blk_zone *zone)
 #define ZONEFS_ZONE_READONLY	(1U << 4)
 #define ZONEFS_ZONE_CNV		(1U << 31)
 
+/*
+ * Write pointer advancement rate of a sequential zone, in bytes per second,
+ * averaged over ZONEFS_WP_RATE_PERIOD long periods.
+ */
+DECLARE_EWMA(zonefs_wp_rate, 4, 4)
+#define ZONEFS_WP_RATE_PERIOD	HZ
+
 /*
  * In-memory per-file inode zone data.
  */
@@ -69,6 +77,17 @@ struct zonefs_zone {
 	umode_t			z_mode;
 	kuid_t			z_uid;
 	kgid_t			z_gid;
+
+	/*
+	 * Write statistics (sequential zones only). The rate fields are
+	 * updated with the inode i_truncate_mutex held.
+	 */
+	atomic64_t		z_bytes_written;
+	atomic64_t		z_write_ios;
+	atomic_t		z_resets;
+	struct ewma_zonefs_wp_rate z_wp_rate;
+	unsigned long		z_wp_rate_start;
+	unsigned long		z_wp_rate_bytes;
 };
 
 /*
@@ -104,6 +123,13 @@ struct zonefs_inode_info {
 
 	/* guarded by i_truncate_mutex */
 	unsigned int		i_wr_refcnt;
+
+	/*
+	 * Set while the last direct writes issued to a sequential file were
+	 * zone append writes, which cannot be mixed with in-flight regular
+	 * writes. Changed only after inode_dio_wait(), with the inode lock held.
+	 */
+	bool			i_dio_append;
 };
 
 static inline struct zonefs_inode_info *ZONEFS_I(struct inode *inode)
@@ -238,6 +264,10 @@ struct zonefs_sb_info {
 	unsigned int		s_max_active_seq_files;
 	atomic_t		s_active_seq_files;
 
+	/* Write open requests waiting for zone resources, under s_lock */
+	struct list_head	s_wro_waiters;
+	unsigned int		s_wro_pending_active;
+
 	bool			s_sysfs_registered;
 	struct kobject		s_kobj;
 	struct completion	s_kobj_unregister;
@@ -260,6 +290,11 @@ void zonefs_inode_account_active(struct inode *inode);
 int zonefs_inode_zone_mgmt(struct inode *inode, enum req_op op);
 void zonefs_i_size_write(struct inode *inode, loff_t isize);
 void zonefs_update_stats(struct inode *inode, loff_t new_isize);
+void zonefs_account_write(struct inode *inode, size_t size);
+unsigned long zonefs_zone_wp_rate(struct zonefs_zone *z);
+int zonefs_wro_get(struct inode *inode, bool nonblock, bool *pending_active);
+void zonefs_wro_settle(struct super_block *sb);
+void zonefs_wro_put(struct super_block *sb);
 void __zonefs_io_error(struct inode *inode, bool write);
 
 static inline void zonefs_io_error(struct inode *inode, bool write)
@@ -279,6 +314,8 @@ extern const struct file_operations zonefs_dir_operations;
 extern const struct address_space_operations zonefs_file_aops;
 extern const struct file_operations zonefs_file_operations;
 int zonefs_file_truncate(struct inode *inode, loff_t isize);
+int zonefs_file_init(void);
+void zonefs_file_exit(void);
 
 /* In sysfs.c */
 int zonefs_sysfs_register(struct super_block *sb);
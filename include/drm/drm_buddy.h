@@ -8,6 +8,7 @@
 
 #include <linux/bitops.h>
 #include <linux/list.h>
+#include <linux/rbtree.h>
 #include <linux/slab.h>
 #include <linux/sched.h>
 
@@ -29,6 +30,12 @@
 #define DRM_BUDDY_CLEARED			BIT(4)
 #define DRM_BUDDY_TRIM_DISABLE			BIT(5)
 
+enum drm_buddy_free_tree {
+	DRM_BUDDY_CLEAR_TREE = 0,
+	DRM_BUDDY_DIRTY_TREE,
+	DRM_BUDDY_MAX_FREE_TREES,
+};
+
 struct drm_buddy_block {
 #define DRM_BUDDY_HEADER_OFFSET GENMASK_ULL(63, 12)
 #define DRM_BUDDY_HEADER_STATE  GENMASK_ULL(11, 10)
@@ -47,6 +54,9 @@ struct drm_buddy_block {
 
 	void *private; /* owned by creator */
 
+	/* Node in the mm's free tree for the block's order and clear state */
+	struct rb_node rb;
+
 	/*
 	 * While the block is allocated by the user through drm_buddy_alloc*,
 	 * the user has ownership of the link, for example to maintain within
@@ -67,15 +77,19 @@ struct drm_buddy_block {
  * drm_buddy_alloc* and drm_buddy_free* should suffice.
  */
 struct drm_buddy {
-	/* Maintain a free list for each order. */
-	struct list_head *free_list;
+	/*
+	 * Maintain a free tree for each order and clear state, ordered by
+	 * offset, so that lookups within a range don't need to walk all the
+	 * free blocks.
+	 */
+	struct rb_root *free_trees[DRM_BUDDY_MAX_FREE_TREES];
 
 	/*
 	 * Maintain explicit binary tree(s) to track the allocation of the
 	 * address space. This gives us a simple way of finding a buddy block
 	 * and performing the potentially recursive merge step when freeing a
 	 * block.  Nodes are either allocated or free, in which case they will
-	 * also exist on the respective free list.
+	 * also exist on the respective free tree.
 	 */
 	struct drm_buddy_block **roots;
 
@@ -93,6 +107,19 @@ struct drm_buddy {
 	u64 clear_avail;
 };
 
+/**
+ * struct drm_buddy_compact - State of a compaction attempt
+ *
+ * @start: offset of the window being freed up
+ * @size: size of the window
+ * @reserved: the free blocks of the window, held until the end of the attempt
+ */
+struct drm_buddy_compact {
+	u64 start;
+	u64 size;
+	struct list_head reserved;
+};
+
 static inline u64
 drm_buddy_block_offset(struct drm_buddy_block *block)
 {
@@ -166,6 +193,12 @@ void drm_buddy_free_list(struct drm_buddy *mm,
 			 struct list_head *objects,
 			 unsigned int flags);
 
+unsigned int drm_buddy_fragmentation(struct drm_buddy *mm, unsigned int order);
+
+int drm_buddy_compact_begin(struct drm_buddy *mm, unsigned int order,
+			    struct drm_buddy_compact *cc);
+void drm_buddy_compact_end(struct drm_buddy *mm, struct drm_buddy_compact *cc);
+
 void drm_buddy_print(struct drm_buddy *mm, struct drm_printer *p);
 void drm_buddy_block_print(struct drm_buddy *mm,
 			   struct drm_buddy_block *block,
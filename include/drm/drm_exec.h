@@ -11,6 +11,27 @@
 
 struct drm_gem_object;
 
+/**
+ * struct drm_exec_hint - contention state carried across drm_exec contexts
+ *
+ * Drivers can embed this in e.g. their submission queue and attach it to
+ * each &drm_exec with drm_exec_set_hint(). The object which was contended
+ * the last time is then locked first, before the driver locks anything,
+ * which avoids running into the same contention and backing off again.
+ * The driver must serialize the &drm_exec contexts using the same hint.
+ */
+struct drm_exec_hint {
+	/**
+	 * @obj: the GEM object contended last, holds a reference
+	 */
+	struct drm_gem_object	*obj;
+
+	/**
+	 * @contentions: total number of contentions seen
+	 */
+	unsigned long		contentions;
+};
+
 /**
  * struct drm_exec - Execution context
  */
@@ -49,6 +70,17 @@ struct drm_exec {
 	 * @prelocked: already locked GEM object due to contention
 	 */
 	struct drm_gem_object *prelocked;
+
+	/**
+	 * @hint: optional contention hint, see &struct drm_exec_hint
+	 */
+	struct drm_exec_hint	*hint;
+
+	/**
+	 * @num_retries: number of times locking was restarted due to
+	 * contention
+	 */
+	unsigned int		num_retries;
 };
 
 /**
@@ -135,7 +167,19 @@ static inline bool drm_exec_is_contended(struct drm_exec *exec)
 	return !!exec->contended;
 }
 
+/**
+ * drm_exec_set_hint - attach a contention hint to a drm_exec object
+ * @exec: drm_exec object, initialized but not yet used for locking
+ * @hint: the hint, see &struct drm_exec_hint
+ */
+static inline void drm_exec_set_hint(struct drm_exec *exec,
+				     struct drm_exec_hint *hint)
+{
+	exec->hint = hint;
+}
+
 void drm_exec_init(struct drm_exec *exec, u32 flags, unsigned nr);
+void drm_exec_hint_fini(struct drm_exec_hint *hint);
 void drm_exec_fini(struct drm_exec *exec);
 bool drm_exec_cleanup(struct drm_exec *exec);
 int drm_exec_lock_obj(struct drm_exec *exec, struct drm_gem_object *obj);
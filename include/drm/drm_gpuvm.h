@@ -27,6 +27,7 @@
 
 #include <linux/dma-resv.h>
 #include <linux/list.h>
+#include <linux/maple_tree.h>
 #include <linux/rbtree.h>
 #include <linux/types.h>
 
@@ -160,6 +161,11 @@ struct drm_gpuva *drm_gpuva_find_first(struct drm_gpuvm *gpuvm,
 struct drm_gpuva *drm_gpuva_find_prev(struct drm_gpuvm *gpuvm, u64 start);
 struct drm_gpuva *drm_gpuva_find_next(struct drm_gpuvm *gpuvm, u64 end);
 
+struct drm_gpuva *drm_gpuva_find_rcu(struct drm_gpuvm *gpuvm,
+				     u64 addr, u64 range);
+struct drm_gpuva *drm_gpuva_find_first_rcu(struct drm_gpuvm *gpuvm,
+					   u64 addr, u64 range);
+
 static inline void drm_gpuva_init(struct drm_gpuva *va, u64 addr, u64 range,
 				  struct drm_gem_object *obj, u64 offset)
 {
@@ -205,10 +211,24 @@ enum drm_gpuvm_flags {
 	 */
 	DRM_GPUVM_RESV_PROTECTED = BIT(0),
 
+	/**
+	 * @DRM_GPUVM_RCU_LOOKUP: additionally track the &drm_gpuva entries in
+	 * an RCU safe maple tree, such that they can be looked up with
+	 * drm_gpuva_find_rcu() and drm_gpuva_find_first_rcu() without holding
+	 * the driver's VM lock
+	 *
+	 * Drivers setting this flag must not free a removed &drm_gpuva before
+	 * an RCU grace period elapsed, and must not insert &drm_gpuva entries
+	 * from the dma-fence signalling critical path, since insertion
+	 * allocates memory. For the same reason drm_gpuva_map() and
+	 * drm_gpuva_remap() can fail with -ENOMEM and must be checked.
+	 */
+	DRM_GPUVM_RCU_LOOKUP = BIT(1),
+
 	/**
 	 * @DRM_GPUVM_USERBITS: user defined bits
 	 */
-	DRM_GPUVM_USERBITS = BIT(1),
+	DRM_GPUVM_USERBITS = BIT(2),
 };
 
 /**
@@ -264,6 +284,12 @@ struct drm_gpuvm {
 		struct list_head list;
 	} rb;
 
+	/**
+	 * @mt: maple tree mirroring @rb.tree for lockless lookups, only used
+	 * if &DRM_GPUVM_RCU_LOOKUP is set
+	 */
+	struct maple_tree mt;
+
 	/**
 	 * @kref: reference count of this object
 	 */
@@ -1206,13 +1232,94 @@ int drm_gpuvm_sm_map(struct drm_gpuvm *gpuvm, void *priv,
 int drm_gpuvm_sm_unmap(struct drm_gpuvm *gpuvm, void *priv,
 		       u64 addr, u64 range);
 
-void drm_gpuva_map(struct drm_gpuvm *gpuvm,
-		   struct drm_gpuva *va,
-		   struct drm_gpuva_op_map *op);
+/**
+ * struct drm_gpuvm_bind_op - a single request of a batch of binds
+ */
+struct drm_gpuvm_bind_op {
+	/**
+	 * @op: either DRM_GPUVA_OP_MAP or DRM_GPUVA_OP_UNMAP
+	 */
+	enum drm_gpuva_op_type op;
+
+	/**
+	 * @addr: the start address of the range to map or unmap
+	 */
+	u64 addr;
+
+	/**
+	 * @range: the range to map or unmap
+	 */
+	u64 range;
+
+	/**
+	 * @obj: the &drm_gem_object to map, unused for unmap requests
+	 */
+	struct drm_gem_object *obj;
+
+	/**
+	 * @offset: the offset within @obj, unused for unmap requests
+	 */
+	u64 offset;
+};
+
+/**
+ * struct drm_gpuvm_range - a range of GPU VA space
+ */
+struct drm_gpuvm_range {
+	/**
+	 * @addr: the start address of the range
+	 */
+	u64 addr;
+
+	/**
+	 * @range: the size of the range
+	 */
+	u64 range;
+};
+
+/**
+ * struct drm_gpuvm_batch - result of drm_gpuvm_sm_batch()
+ *
+ * Must be zero initialized before it is passed to drm_gpuvm_sm_batch() and
+ * released with drm_gpuvm_batch_fini() afterwards.
+ */
+struct drm_gpuvm_batch {
+	/**
+	 * @ranges: the sorted, non-overlapping and non-adjacent ranges of GPU
+	 * VA space whose page table entries changed
+	 */
+	struct drm_gpuvm_range *ranges;
+
+	/**
+	 * @num_ranges: the number of entries in @ranges
+	 */
+	unsigned int num_ranges;
+
+	/**
+	 * @max_ranges: the number of entries @ranges has room for
+	 */
+	unsigned int max_ranges;
+
+	/**
+	 * @num_skipped: the number of requests which were superseded by a later
+	 * request of the batch and hence skipped
+	 */
+	unsigned int num_skipped;
+};
+
+int drm_gpuvm_sm_batch(struct drm_gpuvm *gpuvm, void *priv,
+		       const struct drm_gpuvm_bind_op *binds,
+		       unsigned int num_binds,
+		       struct drm_gpuvm_batch *batch);
+void drm_gpuvm_batch_fini(struct drm_gpuvm_batch *batch);
+
+int drm_gpuva_map(struct drm_gpuvm *gpuvm,
+		  struct drm_gpuva *va,
+		  struct drm_gpuva_op_map *op);
 
-void drm_gpuva_remap(struct drm_gpuva *prev,
-		     struct drm_gpuva *next,
-		     struct drm_gpuva_op_remap *op);
+int drm_gpuva_remap(struct drm_gpuva *prev,
+		    struct drm_gpuva *next,
+		    struct drm_gpuva_op_remap *op);
 
 void drm_gpuva_unmap(struct drm_gpuva_op_unmap *op);
 
@@ -546,6 +546,7 @@ bool drm_mm_scan_add_block(struct drm_mm_scan *scan,
 bool drm_mm_scan_remove_block(struct drm_mm_scan *scan,
 			      struct drm_mm_node *node);
 struct drm_mm_node *drm_mm_scan_color_evict(struct drm_mm_scan *scan);
+bool drm_mm_scan_window(const struct drm_mm_scan *scan, u64 *start, u64 *end);
 
 void drm_mm_print(const struct drm_mm *mm, struct drm_printer *p);
 
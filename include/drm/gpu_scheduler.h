@@ -29,6 +29,7 @@
 #include <linux/completion.h>
 #include <linux/xarray.h>
 #include <linux/workqueue.h>
+#include <linux/kref.h>
 
 #define MAX_WAIT_SCHED_ENTITY_Q_EMPTY msecs_to_jiffies(1000)
 
@@ -71,11 +72,37 @@ enum drm_sched_priority {
 	DRM_SCHED_PRIORITY_COUNT
 };
 
-/* Used to choose between FIFO and RR job-scheduling */
+/* Used to choose between FIFO, RR and FAIR job-scheduling */
 extern int drm_sched_policy;
 
 #define DRM_SCHED_POLICY_RR    0
 #define DRM_SCHED_POLICY_FIFO  1
+#define DRM_SCHED_POLICY_FAIR  2
+
+/* Weight of an entity unless set with drm_sched_entity_set_weight() */
+#define DRM_SCHED_WEIGHT_DEFAULT	1024
+#define DRM_SCHED_WEIGHT_MAX		(DRM_SCHED_WEIGHT_DEFAULT * 64)
+
+/**
+ * struct drm_sched_entity_stats - GPU time accounting of an entity
+ *
+ * Referenced by the entity and by each of its jobs until they are cleaned
+ * up, since jobs can complete after their entity is gone.
+ */
+struct drm_sched_entity_stats {
+	/** @kref: reference count */
+	struct kref			kref;
+	/**
+	 * @vruntime: GPU time consumed so far, in nanoseconds scaled by
+	 * DRM_SCHED_WEIGHT_DEFAULT / @weight. Jobs being run are charged
+	 * @avg_runtime up front, corrected once they complete.
+	 */
+	atomic64_t			vruntime;
+	/** @avg_runtime: moving average of the GPU time of a job */
+	u64				avg_runtime;
+	/** @weight: share of the GPU relative to DRM_SCHED_WEIGHT_DEFAULT */
+	u32				weight;
+};
 
 /**
  * struct drm_sched_entity - A wrapper around a job queue (typically
@@ -239,6 +266,13 @@ struct drm_sched_entity {
 	 */
 	struct rb_node			rb_tree_node;
 
+	/**
+	 * @stats:
+	 *
+	 * GPU time accounting, used by the FAIR policy to pick the entity
+	 * which got the least GPU time for its weight.
+	 */
+	struct drm_sched_entity_stats	*stats;
 };
 
 /**
@@ -249,6 +283,8 @@ struct drm_sched_entity {
  * @current_entity: the entity which is to be scheduled.
  * @entities: list of the entities to be scheduled.
  * @rb_tree_root: root of time based priority queue of entities for FIFO scheduling
+ * @min_vruntime: vruntime of the last entity picked with FAIR scheduling, at
+ *                least which entities becoming active start
  *
  * Run queue is a set of entities scheduling command submissions for
  * one specific ring. It implements the scheduling policy that selects
@@ -262,6 +298,7 @@ struct drm_sched_rq {
 	struct drm_sched_entity		*current_entity;
 	struct list_head		entities;
 	struct rb_root_cached		rb_tree_root;
+	u64				min_vruntime;
 };
 
 /**
@@ -385,6 +422,17 @@ struct drm_sched_job {
 	 * When the job was pushed into the entity queue.
 	 */
 	ktime_t                         submit_ts;
+
+	/**
+	 * @entity_stats:
+	 *
+	 * Accounting of the entity the job is charged to, referenced from
+	 * drm_sched_job_arm() to drm_sched_job_cleanup().
+	 */
+	struct drm_sched_entity_stats	*entity_stats;
+
+	/** @vcharge: vruntime charged up front when the job was run (FAIR) */
+	u64				vcharge;
 };
 
 static inline bool drm_sched_invalidate_job(struct drm_sched_job *s_job,
@@ -489,8 +537,24 @@ struct drm_sched_backend_ops {
 	 * This callback is optional.
 	 */
 	u32 (*update_job_credits)(struct drm_sched_job *sched_job);
+
+	/**
+	 * @commit_jobs: Called after a batch of run_job() calls.
+	 *
+	 * When this callback is set, the scheduler runs up to
+	 * DRM_SCHED_RUN_BATCH ready jobs, across entities and in priority
+	 * order, for as long as the credits allow, before calling it once.
+	 * Drivers can then only write the jobs to the ring in run_job() and
+	 * notify the hardware here, once for the whole batch.
+	 *
+	 * This callback is optional.
+	 */
+	void (*commit_jobs)(struct drm_gpu_scheduler *sched);
 };
 
+/* Maximum number of jobs run before &drm_sched_backend_ops.commit_jobs */
+#define DRM_SCHED_RUN_BATCH	32
+
 /**
  * struct drm_gpu_scheduler - scheduler instance-specific data
  *
@@ -522,6 +586,8 @@ struct drm_sched_backend_ops {
  * @free_guilty: A hit to time out handler to free the guilty job.
  * @pause_submit: pause queuing of @work_run_job on @submit_wq
  * @own_submit_wq: scheduler owns allocation of @submit_wq
+ * @last_done: when the last job completed, the earliest a job running after
+ *             it could have started executing
  * @dev: system &struct device
  *
  * One scheduler is implemented for each hardware ring.
@@ -550,6 +616,7 @@ struct drm_gpu_scheduler {
 	bool				free_guilty;
 	bool				pause_submit;
 	bool				own_submit_wq;
+	ktime_t				last_done;
 	struct device			*dev;
 };
 
@@ -620,6 +687,8 @@ struct drm_sched_job *drm_sched_entity_pop_job(struct drm_sched_entity *entity);
 void drm_sched_entity_push_job(struct drm_sched_job *sched_job);
 void drm_sched_entity_set_priority(struct drm_sched_entity *entity,
 				   enum drm_sched_priority priority);
+void drm_sched_entity_set_weight(struct drm_sched_entity *entity, u32 weight);
+void drm_sched_entity_stats_release(struct kref *kref);
 bool drm_sched_entity_is_ready(struct drm_sched_entity *entity);
 int drm_sched_entity_error(struct drm_sched_entity *entity);
 
@@ -46,6 +46,7 @@ struct ttm_tt;
  * @shrinker_list: our place on the global shrinker list
  * @lock: protection of the page list
  * @pages: the list of pages in the pool
+ * @nr_pages: number of pages on @pages, in units of 1 << @order
  */
 struct ttm_pool_type {
 	struct ttm_pool *pool;
@@ -56,6 +57,7 @@ struct ttm_pool_type {
 
 	spinlock_t lock;
 	struct list_head pages;
+	unsigned long nr_pages;
 };
 
 /**
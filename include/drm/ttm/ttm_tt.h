@@ -231,6 +231,7 @@ static inline void ttm_tt_mark_for_clear(struct ttm_tt *ttm)
 }
 
 void ttm_tt_mgr_init(unsigned long num_pages, unsigned long num_dma32_pages);
+void ttm_tt_mgr_fini(void);
 
 struct ttm_kmap_iter *ttm_kmap_iter_tt_init(struct ttm_kmap_iter_tt *iter_tt,
 					    struct ttm_tt *tt);
@@ -167,6 +167,24 @@ async_xor_offs(struct page *dest, unsigned int offset,
 		struct page **src_list, unsigned int *src_offset,
 		int src_cnt, size_t len, struct async_submit_ctl *submit);
 
+/**
+ * struct async_xor_stripe - one independent xor of an async_xor_batch()
+ * @dest: destination page
+ * @offset: dst offset to start transaction
+ * @src_list: array of source pages
+ * @src_offs: array of source pages offset, NULL means common src/dst offset
+ */
+struct async_xor_stripe {
+	struct page *dest;
+	unsigned int offset;
+	struct page **src_list;
+	unsigned int *src_offs;
+};
+
+struct dma_async_tx_descriptor *
+async_xor_batch(struct async_xor_stripe *stripes, int nr_stripes,
+		int src_cnt, size_t len, struct async_submit_ctl *submit);
+
 struct dma_async_tx_descriptor *
 async_xor_val(struct page *dest, struct page **src_list, unsigned int offset,
 	      int src_cnt, size_t len, enum sum_check_flags *result,
@@ -189,6 +207,20 @@ struct dma_async_tx_descriptor *
 async_gen_syndrome(struct page **blocks, unsigned int *offsets, int src_cnt,
 		   size_t len, struct async_submit_ctl *submit);
 
+/**
+ * struct async_pq_stripe - one independent syndrome of an async_gen_syndrome_batch()
+ * @blocks: source blocks from idx 0..disks-3, P @ disks-2 and Q @ disks-1
+ * @offsets: offset array into each block (src and dest) to start transaction
+ */
+struct async_pq_stripe {
+	struct page **blocks;
+	unsigned int *offsets;
+};
+
+struct dma_async_tx_descriptor *
+async_gen_syndrome_batch(struct async_pq_stripe *stripes, int nr_stripes,
+			 int disks, size_t len, struct async_submit_ctl *submit);
+
 struct dma_async_tx_descriptor *
 async_syndrome_val(struct page **blocks, unsigned int *offsets, int src_cnt,
 		   size_t len, enum sum_check_flags *pqres, struct page *spare,
@@ -33,6 +33,13 @@ struct cpuidle_driver;
 #define CPUIDLE_STATE_DISABLED_BY_USER		BIT(0)
 #define CPUIDLE_STATE_DISABLED_BY_DRIVER	BIT(1)
 
+/*
+ * Residency histogram: bucket 0 counts residencies below 1 << 10 ns, every
+ * following bucket doubles the upper bound and the last one is open-ended.
+ */
+#define CPUIDLE_RESIDENCY_HIST_SHIFT	10
+#define CPUIDLE_RESIDENCY_HIST_BUCKETS	16
+
 struct cpuidle_state_usage {
 	unsigned long long	disable;
 	unsigned long long	usage;
@@ -40,6 +47,9 @@ struct cpuidle_state_usage {
 	unsigned long long	above; /* Number of times it's been too deep */
 	unsigned long long	below; /* Number of times it's been too shallow */
 	unsigned long long	rejected; /* Number of times idle entry was rejected */
+	unsigned long long	predicted; /* Number of entries with a prediction */
+	u64			pred_error_ns; /* Sum of prediction errors */
+	unsigned long long	residency_hist[CPUIDLE_RESIDENCY_HIST_BUCKETS];
 #ifdef CONFIG_SUSPEND
 	unsigned long long	s2idle_usage;
 	unsigned long long	s2idle_time; /* in US */
@@ -100,6 +110,7 @@ struct cpuidle_device {
 	int			last_state_idx;
 	u64			last_residency_ns;
 	u64			poll_limit_ns;
+	u64			predicted_ns;
 	u64			forced_idle_latency_limit_ns;
 	struct cpuidle_state_usage	states_usage[CPUIDLE_STATE_MAX];
 	struct cpuidle_state_kobj *kobjs[CPUIDLE_STATE_MAX];
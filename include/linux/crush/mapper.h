@@ -31,4 +31,25 @@ static inline size_t crush_work_size(const struct crush_map *map,
 
 void crush_init_workspace(const struct crush_map *map, void *v);
 
+#ifdef __KERNEL__
+/* cache.c */
+#define CRUSH_CACHE_RESULT_MAX 16
+
+struct crush_cache;
+
+struct crush_cache *crush_cache_create(unsigned int order);
+void crush_cache_destroy(struct crush_cache *cache);
+void crush_cache_invalidate(struct crush_cache *cache);
+int crush_do_rule_cached(struct crush_cache *cache,
+			 const struct crush_map *map,
+			 int ruleno, int x, int *result, int result_max,
+			 const __u32 *weight, int weight_max,
+			 void *cwin, const struct crush_choose_arg *choose_args);
+void crush_do_rule_batch(struct crush_cache *cache,
+			 const struct crush_map *map, int ruleno,
+			 const int *x, int nr, int *results, int *result_lens,
+			 int result_max, const __u32 *weight, int weight_max,
+			 void *cwin, const struct crush_choose_arg *choose_args);
+#endif
+
 #endif
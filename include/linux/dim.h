@@ -59,6 +59,7 @@ struct dim_cq_moder {
 
 #define DIM_PROFILE_RX		BIT(0)	/* support rx profile modification */
 #define DIM_PROFILE_TX		BIT(1)	/* support tx profile modification */
+#define DIM_PROFILE_COORD	BIT(2)	/* align queues polled on one CPU */
 
 #define DIM_COALESCE_USEC	BIT(0)	/* support usec field modification */
 #define DIM_COALESCE_PKTS	BIT(1)	/* support pkts field modification */
@@ -124,6 +125,27 @@ struct dim_stats {
 	int cpe_ratio; /* ratio of completions to events */
 };
 
+/* Number of log2 latency buckets, the last one collects everything above */
+#define DIM_LAT_BUCKETS 16
+/* Minimum number of latency samples before a latency based decision */
+#define DIM_LAT_NSAMPLES 128
+
+/**
+ * struct dim_lat - Structure for DIM latency-target mode.
+ * Set by drivers that want the moderation chosen to keep the p99
+ * completion-to-poll latency under a target rather than to maximize
+ * the traffic per interrupt.
+ *
+ * @target_us: p99 latency target in usecs
+ * @nsamples: Number of latency samples in @hist
+ * @hist: Histogram of latency samples, bucket n holds [2^(n-1), 2^n) usecs
+ */
+struct dim_lat {
+	u32 target_us;
+	u32 nsamples;
+	u32 hist[DIM_LAT_BUCKETS];
+};
+
 /**
  * struct dim - Main structure for dynamic interrupt moderation (DIM).
  * Used for holding all information about a specific DIM instance.
@@ -140,6 +162,8 @@ struct dim_stats {
  * @steps_right: Number of steps taken towards higher moderation
  * @steps_left: Number of steps taken towards lower moderation
  * @tired: Parking depth counter
+ * @lat: Latency-target mode state, NULL to optimize for throughput
+ * @coord: Per-CPU group whose profile this instance follows, 0 if none
  */
 struct dim {
 	u8 state;
@@ -154,6 +178,8 @@ struct dim {
 	u8 steps_right;
 	u8 steps_left;
 	u8 tired;
+	u8 coord;
+	struct dim_lat *lat;
 };
 
 /**
@@ -261,6 +287,10 @@ void net_dim_free_irq_moder(struct net_device *dev);
  * @dev: target network device
  * @dim: DIM context
  * @is_tx: true indicates the tx direction, false indicates the rx direction
+ *
+ * With DIM_PROFILE_COORD set on @dev, @dim also joins the per-CPU group of
+ * its direction: a profile chosen by any queue of the group on a CPU is
+ * adopted by the other queues polled on that CPU.
  */
 void net_dim_setting(struct net_device *dev, struct dim *dim, bool is_tx);
 
@@ -341,6 +371,34 @@ void dim_park_on_top(struct dim *dim);
  */
 void dim_park_tired(struct dim *dim);
 
+/**
+ *	dim_lat_sample - record a completion-to-poll latency sample
+ *	@dim: DIM context, a no-op unless latency-target mode is enabled
+ *	@latency_us: time from the completion to its processing, in usecs
+ */
+static inline void dim_lat_sample(struct dim *dim, u32 latency_us)
+{
+	struct dim_lat *lat = dim->lat;
+
+	if (!lat)
+		return;
+
+	lat->hist[min_t(u32, fls(latency_us), DIM_LAT_BUCKETS - 1)]++;
+	lat->nsamples++;
+}
+
+/**
+ *	dim_lat_decision - pick a profile from the recorded latency
+ *	@dim: DIM context with latency-target mode enabled
+ *	@num_profiles: number of profiles, ordered by increasing moderation
+ *
+ * Once enough samples were recorded, step to a lighter profile when the
+ * p99 latency misses the target, or to a heavier one when it is below
+ * half the target, and start a new histogram.
+ * Returned boolean indicates whether the profile changed.
+ */
+bool dim_lat_decision(struct dim *dim, u8 num_profiles);
+
 /**
  *	dim_calc_stats - calculate the difference between two samples
  *	@start: start sample
@@ -255,6 +255,8 @@ struct fsnotify_group {
 			int f_flags; /* event_f_flags from fanotify_init() */
 			struct ucounts *ucounts;
 			mempool_t error_events_pool;
+			/* optional shared event ring, set up by mmap() */
+			struct fanotify_ring *ring;
 		} fanotify_data;
 #endif /* CONFIG_FANOTIFY */
 	};
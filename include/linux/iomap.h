@@ -202,8 +202,30 @@ struct iomap_ops {
 	 */
 	int (*iomap_end)(struct inode *inode, loff_t pos, loff_t length,
 			ssize_t written, unsigned flags, struct iomap *iomap);
+
+	/*
+	 * Optional, returns the cache for IOMAP_REPORT mappings of the inode,
+	 * so that repeated SEEK_HOLE/SEEK_DATA and fiemap calls can be served
+	 * without calling ->iomap_begin again.  Only used if ->iomap_end is
+	 * not set.  The file system must call iomap_extent_cache_invalidate()
+	 * after every change to the mapping of the inode.
+	 */
+	struct iomap_extent_cache *(*report_cache)(struct inode *inode);
 };
 
+#define IOMAP_EXTENT_CACHE_NR	8
+
+struct iomap_extent_cache {
+	spinlock_t		lock;
+	unsigned int		seq;	/* bumped on invalidation */
+	unsigned int		nr;	/* valid entries in extents */
+	unsigned int		next;	/* next entry to replace */
+	struct iomap		extents[IOMAP_EXTENT_CACHE_NR];
+};
+
+void iomap_extent_cache_init(struct iomap_extent_cache *ec);
+void iomap_extent_cache_invalidate(struct iomap_extent_cache *ec);
+
 /**
  * struct iomap_iter - Iterate through a range of a file
  * @inode: Set at the start of the iteration and should not change.
@@ -381,6 +403,15 @@ struct iomap_writepage_ctx {
 	struct iomap_ioend	*ioend;
 	const struct iomap_writeback_ops *ops;
 	u32			nr_folios;	/* folios added to the ioend */
+
+	/*
+	 * Clean but uptodate bytes between two dirty ranges of a folio that
+	 * may be written back along with them when both ranges are covered by
+	 * the current mapping, so that they go out in a single bio.  Only
+	 * IOMAP_MAPPED mappings without IOMAP_F_SHARED are extended this way.
+	 * Zero disables merging.
+	 */
+	u32			max_clean_gap;
 };
 
 void iomap_finish_ioends(struct iomap_ioend *ioend, int error);
@@ -434,6 +465,14 @@ struct iomap_dio_ops {
  */
 #define IOMAP_DIO_PARTIAL		(1 << 2)
 
+/*
+ * The ->end_io handler does not sleep for pure overwrites, i.e. writes within
+ * i_size that need neither unwritten extent conversion nor COW remapping.
+ * This allows polled pure overwrites to be completed from the polling task
+ * instead of being punted to a workqueue.
+ */
+#define IOMAP_DIO_OVERWRITE_INLINE_COMP	(1 << 3)
+
 ssize_t iomap_dio_rw(struct kiocb *iocb, struct iov_iter *iter,
 		const struct iomap_ops *ops, const struct iomap_dio_ops *dops,
 		unsigned int dio_flags, void *private, size_t done_before);
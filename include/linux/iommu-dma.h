@@ -9,6 +9,8 @@
 
 #include <linux/dma-direction.h>
 
+struct bio_vec;
+
 #ifdef CONFIG_IOMMU_DMA
 static inline bool use_dma_iommu(struct device *dev)
 {
@@ -26,6 +28,15 @@ dma_addr_t iommu_dma_map_page(struct device *dev, struct page *page,
 		unsigned long attrs);
 void iommu_dma_unmap_page(struct device *dev, dma_addr_t dma_handle,
 		size_t size, enum dma_data_direction dir, unsigned long attrs);
+int iommu_dma_map_batch(struct device *dev, const struct bio_vec *bv, int nr,
+		dma_addr_t *dma_addrs, enum dma_data_direction dir,
+		unsigned long attrs);
+void iommu_dma_unmap_batch(struct device *dev, const struct bio_vec *bv,
+		int nr, const dma_addr_t *dma_addrs,
+		enum dma_data_direction dir, unsigned long attrs);
+void iommu_dma_unmap_page_batch(struct device *dev,
+		const dma_addr_t *dma_handles, const size_t *sizes, int nr,
+		enum dma_data_direction dir, unsigned long attrs);
 int iommu_dma_map_sg(struct device *dev, struct scatterlist *sg, int nents,
 		enum dma_data_direction dir, unsigned long attrs);
 void iommu_dma_unmap_sg(struct device *dev, struct scatterlist *sg, int nents,
@@ -582,6 +582,9 @@ iommu_copy_struct_from_full_user_array(void *kdst, size_t kdst_entry_size,
  * @dev_enable/disable_feat: per device entries to enable/disable
  *                               iommu specific features.
  * @page_response: handle page request response
+ * @page_response_batch: handle several page request responses of a device at
+ *                       once, so that the hardware queue only needs to be
+ *                       synchronised once. Optional.
  * @def_domain_type: device default domain type, return value:
  *		- IOMMU_DOMAIN_IDENTITY: must use an identity domain
  *		- IOMMU_DOMAIN_DMA: must use a dma domain
@@ -645,6 +648,10 @@ struct iommu_ops {
 
 	void (*page_response)(struct device *dev, struct iopf_fault *evt,
 			      struct iommu_page_response *msg);
+	void (*page_response_batch)(struct device *dev,
+				    struct iopf_fault **evts,
+				    struct iommu_page_response *msgs,
+				    unsigned int nr);
 
 	int (*def_domain_type)(struct device *dev);
 	void (*remove_dev_pasid)(struct device *dev, ioasid_t pasid,
@@ -700,6 +707,8 @@ struct iommu_ops {
  *                           including no-snoop TLPs on PCIe or other platform
  *                           specific mechanisms.
  * @set_pgtable_quirks: Set io page table quirks (IO_PGTABLE_QUIRK_*)
+ * @prefetch: Preload the IOMMU TLBs with the translations of a range that
+ *            @dev is about to access through @pasid. Only a hint, optional.
  * @free: Release the domain after use.
  */
 struct iommu_domain_ops {
@@ -728,6 +737,8 @@ struct iommu_domain_ops {
 	bool (*enforce_cache_coherency)(struct iommu_domain *domain);
 	int (*set_pgtable_quirks)(struct iommu_domain *domain,
 				  unsigned long quirks);
+	void (*prefetch)(struct iommu_domain *domain, struct device *dev,
+			 ioasid_t pasid, unsigned long iova, size_t size);
 
 	void (*free)(struct iommu_domain *domain);
 };
@@ -761,6 +772,8 @@ struct iommu_device {
  * @partial: faults that are part of a Page Request Group for which the last
  *           request hasn't been submitted yet.
  * @faults: holds the pending faults which need response
+ * @responses: responses waiting to be sent with ops->page_response_batch()
+ * @resp_lock: held by the thread sending @responses
  */
 struct iommu_fault_param {
 	struct mutex lock;
@@ -773,6 +786,9 @@ struct iommu_fault_param {
 
 	struct list_head partial;
 	struct list_head faults;
+
+	struct list_head responses;
+	struct mutex resp_lock;
 };
 
 /**
@@ -862,6 +878,10 @@ extern struct iommu_domain *iommu_get_domain_for_dev(struct device *dev);
 extern struct iommu_domain *iommu_get_dma_domain(struct device *dev);
 extern int iommu_map(struct iommu_domain *domain, unsigned long iova,
 		     phys_addr_t paddr, size_t size, int prot, gfp_t gfp);
+int iommu_map_nosync(struct iommu_domain *domain, unsigned long iova,
+		     phys_addr_t paddr, size_t size, int prot, gfp_t gfp);
+int iommu_sync_map(struct iommu_domain *domain, unsigned long iova,
+		   size_t size);
 extern size_t iommu_unmap(struct iommu_domain *domain, unsigned long iova,
 			  size_t size);
 extern size_t iommu_unmap_fast(struct iommu_domain *domain,
@@ -1187,6 +1207,19 @@ static inline int iommu_map(struct iommu_domain *domain, unsigned long iova,
 	return -ENODEV;
 }
 
+static inline int iommu_map_nosync(struct iommu_domain *domain,
+				   unsigned long iova, phys_addr_t paddr,
+				   size_t size, int prot, gfp_t gfp)
+{
+	return -ENODEV;
+}
+
+static inline int iommu_sync_map(struct iommu_domain *domain,
+				 unsigned long iova, size_t size)
+{
+	return -ENODEV;
+}
+
 static inline size_t iommu_unmap(struct iommu_domain *domain,
 				 unsigned long iova, size_t size)
 {
@@ -1589,6 +1622,8 @@ struct iommu_sva *iommu_sva_bind_device(struct device *dev,
 					struct mm_struct *mm);
 void iommu_sva_unbind_device(struct iommu_sva *handle);
 u32 iommu_sva_get_pasid(struct iommu_sva *handle);
+int iommu_sva_prefault(struct iommu_sva *handle, unsigned long addr,
+		       size_t size, bool write);
 #else
 static inline struct iommu_sva *
 iommu_sva_bind_device(struct device *dev, struct mm_struct *mm)
@@ -1604,6 +1639,13 @@ static inline u32 iommu_sva_get_pasid(struct iommu_sva *handle)
 {
 	return IOMMU_PASID_INVALID;
 }
+
+static inline int iommu_sva_prefault(struct iommu_sva *handle,
+				     unsigned long addr, size_t size,
+				     bool write)
+{
+	return -ENODEV;
+}
 static inline void mm_pasid_init(struct mm_struct *mm) {}
 static inline bool mm_valid_pasid(struct mm_struct *mm) { return false; }
 
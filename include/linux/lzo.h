@@ -28,6 +28,15 @@ int lzo1x_1_compress(const unsigned char *src, size_t src_len,
 int lzorle1x_1_compress(const unsigned char *src, size_t src_len,
 		     unsigned char *dst, size_t *dst_len, void *wrkmem);
 
+/*
+ * As lzorle1x_1_compress(), but returns LZO_E_NOT_COMPRESSIBLE as soon as
+ * the first 'probe_len' bytes of 'src' have produced neither a match nor a
+ * zero run. This requires 'wrkmem' of size LZO1X_1_MEM_COMPRESS.
+ */
+int lzorle1x_1_compress_probe(const unsigned char *src, size_t src_len,
+		     unsigned char *dst, size_t *dst_len, void *wrkmem,
+		     size_t probe_len);
+
 /* safe decompression with overrun testing */
 int lzo1x_decompress_safe(const unsigned char *src, size_t src_len,
 			  unsigned char *dst, size_t *dst_len);
@@ -66,6 +66,16 @@ struct nfsd_file *nfs_open_local_fh(nfs_uuid_t *,
 		   struct rpc_clnt *, const struct cred *,
 		   const struct nfs_fh *, const fmode_t);
 
+/* Direct IO constraints of the underlying file of a LOCALIO open file */
+struct nfs_local_dio {
+	u32 mem_align;
+	u32 offset_align;
+};
+
+bool nfs_local_dio_init(struct file *, struct nfs_local_dio *);
+bool nfs_local_iocb_dio(struct kiocb *, const struct nfs_local_dio *,
+			struct iov_iter *, bool);
+
 static inline void nfs_to_nfsd_net_put(struct net *net)
 {
 	/*
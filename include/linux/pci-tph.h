@@ -26,6 +26,11 @@ int pcie_tph_set_st_entry(struct pci_dev *pdev,
 int pcie_tph_get_cpu_st(struct pci_dev *dev,
 			enum tph_mem_type mem_type,
 			unsigned int cpu_uid, u16 *tag);
+int pcie_tph_set_cpu_st(struct pci_dev *pdev, unsigned int index,
+			enum tph_mem_type mem_type, unsigned int cpu);
+int pcie_tph_irq_track_affinity(struct pci_dev *pdev, unsigned int index,
+				unsigned int irq, enum tph_mem_type mem_type);
+void pcie_tph_irq_untrack_affinity(unsigned int irq);
 void pcie_disable_tph(struct pci_dev *pdev);
 int pcie_enable_tph(struct pci_dev *pdev, int mode);
 #else
@@ -36,6 +41,16 @@ static inline int pcie_tph_get_cpu_st(struct pci_dev *dev,
 				      enum tph_mem_type mem_type,
 				      unsigned int cpu_uid, u16 *tag)
 { return -EINVAL; }
+static inline int pcie_tph_set_cpu_st(struct pci_dev *pdev, unsigned int index,
+				      enum tph_mem_type mem_type,
+				      unsigned int cpu)
+{ return -EINVAL; }
+static inline int pcie_tph_irq_track_affinity(struct pci_dev *pdev,
+					      unsigned int index,
+					      unsigned int irq,
+					      enum tph_mem_type mem_type)
+{ return -EINVAL; }
+static inline void pcie_tph_irq_untrack_affinity(unsigned int irq) { }
 static inline void pcie_disable_tph(struct pci_dev *pdev) { }
 static inline int pcie_enable_tph(struct pci_dev *pdev, int mode)
 { return -EINVAL; }
@@ -27,6 +27,8 @@
  * @iprim:	prim-th root of 1, index form
  * @gfpoly:	The primitive generator polynominal
  * @gffunc:	Function to generate the field, if non-canonical representation
+ * @gen_mul:	8-bit symbols only: @nroots tables of 256 products x * genpoly[k]
+ * @syn_mul:	8-bit symbols only: @nroots tables of 256 products x * root[i]
  * @users:	Users of this structure
  * @list:	List entry for the rs codec list
 */
@@ -42,6 +44,8 @@ struct rs_codec {
 	int		iprim;
 	int		gfpoly;
 	int		(*gffunc)(int);
+	uint8_t		*gen_mul;
+	uint8_t		*syn_mul;
 	int		users;
 	struct list_head list;
 };
@@ -10,6 +10,8 @@
 #define MAX_DA_NAME_LEN	24
 
 #ifdef CONFIG_RV
+#include <linux/jump_label.h>
+
 /*
  * Deterministic automaton per-object variables.
  */
@@ -54,14 +56,30 @@ struct rv_monitor {
 #endif
 };
 
-bool rv_monitoring_on(void);
+DECLARE_STATIC_KEY_FALSE(rv_monitoring_on_key);
+
+/*
+ * The monitors' event handlers run from hot tracepoints, so the global
+ * switches are static keys rather than flags to be loaded and checked.
+ */
+static inline bool rv_monitoring_on(void)
+{
+	return static_branch_likely(&rv_monitoring_on_key);
+}
+
 int rv_unregister_monitor(struct rv_monitor *monitor);
 int rv_register_monitor(struct rv_monitor *monitor);
 int rv_get_task_monitor_slot(void);
 void rv_put_task_monitor_slot(int slot);
 
 #ifdef CONFIG_RV_REACTORS
-bool rv_reacting_on(void);
+DECLARE_STATIC_KEY_FALSE(rv_reacting_on_key);
+
+static inline bool rv_reacting_on(void)
+{
+	return static_branch_unlikely(&rv_reacting_on_key);
+}
+
 int rv_unregister_reactor(struct rv_reactor *reactor);
 int rv_register_reactor(struct rv_reactor *reactor);
 #endif /* CONFIG_RV_REACTORS */
@@ -1542,6 +1542,9 @@ struct task_struct {
 #endif
 #ifdef CONFIG_LIVEPATCH
 	int patch_state;
+	/* Transition and context switch count of the last unsafe stack */
+	unsigned int patch_check_gen;
+	unsigned long patch_check_switches;
 #endif
 #ifdef CONFIG_SECURITY
 	/* Used by LSM modules for access restriction: */
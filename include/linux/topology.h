@@ -186,6 +186,9 @@ static inline int cpu_to_mem(int cpu)
 #if defined(topology_cluster_id) && defined(topology_cluster_cpumask)
 #define TOPOLOGY_CLUSTER_SYSFS
 #endif
+#if defined(topology_llc_id) && defined(topology_llc_cpumask)
+#define TOPOLOGY_LLC_SYSFS
+#endif
 #if defined(topology_book_id) && defined(topology_book_cpumask)
 #define TOPOLOGY_BOOK_SYSFS
 #endif
@@ -202,6 +205,9 @@ static inline int cpu_to_mem(int cpu)
 #ifndef topology_cluster_id
 #define topology_cluster_id(cpu)		((void)(cpu), -1)
 #endif
+#ifndef topology_llc_id
+#define topology_llc_id(cpu)			((void)(cpu), -1)
+#endif
 #ifndef topology_core_id
 #define topology_core_id(cpu)			((void)(cpu), 0)
 #endif
@@ -223,6 +229,9 @@ static inline int cpu_to_mem(int cpu)
 #ifndef topology_cluster_cpumask
 #define topology_cluster_cpumask(cpu)		cpumask_of(cpu)
 #endif
+#ifndef topology_llc_cpumask
+#define topology_llc_cpumask(cpu)		cpumask_of(cpu)
+#endif
 #ifndef topology_die_cpumask
 #define topology_die_cpumask(cpu)		cpumask_of(cpu)
 #endif
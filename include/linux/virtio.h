@@ -74,6 +74,30 @@ int virtqueue_add_sgs(struct virtqueue *vq,
 		      void *data,
 		      gfp_t gfp);
 
+/**
+ * struct virtqueue_buf - buffer for virtqueue_add_batch()
+ * @sgs: array of terminated scatterlists
+ * @out_sgs: the number of scatterlists readable by other side
+ * @in_sgs: the number of scatterlists which are writable (after readable ones)
+ * @data: the token identifying the buffer
+ */
+struct virtqueue_buf {
+	struct scatterlist **sgs;
+	unsigned int out_sgs;
+	unsigned int in_sgs;
+	void *data;
+};
+
+int virtqueue_add_batch(struct virtqueue *vq, struct virtqueue_buf *bufs,
+			unsigned int num, bool kick, gfp_t gfp);
+
+int virtqueue_add_sgs_premapped(struct virtqueue *vq,
+				struct scatterlist *sgs[],
+				unsigned int out_sgs,
+				unsigned int in_sgs,
+				void *data,
+				gfp_t gfp);
+
 struct device *virtqueue_dma_dev(struct virtqueue *vq);
 
 bool virtqueue_kick(struct virtqueue *vq);
@@ -263,6 +287,32 @@ void virtqueue_dma_sync_single_range_for_device(struct virtqueue *_vq, dma_addr_
 						unsigned long offset, size_t size,
 						enum dma_data_direction dir);
 
+/**
+ * struct virtqueue_dma_buf - buffer of a virtqueue_dma_pool
+ * @vaddr: kernel address of the buffer
+ * @addr: DMA address to add the buffer premapped with
+ * @list: link in the pool's free list
+ * @priv: for the user of the buffer while it is taken
+ */
+struct virtqueue_dma_buf {
+	void *vaddr;
+	dma_addr_t addr;
+	struct list_head list;
+	void *priv;
+};
+
+struct virtqueue_dma_pool;
+
+struct virtqueue_dma_pool *virtqueue_dma_pool_create(struct virtqueue *_vq,
+						     unsigned int num,
+						     size_t size,
+						     enum dma_data_direction dir);
+void virtqueue_dma_pool_destroy(struct virtqueue_dma_pool *pool);
+struct virtqueue_dma_buf *virtqueue_dma_pool_get(struct virtqueue_dma_pool *pool);
+void virtqueue_dma_pool_put(struct virtqueue_dma_pool *pool,
+			    struct virtqueue_dma_buf *buf);
+size_t virtqueue_dma_pool_size(struct virtqueue_dma_pool *pool);
+
 #ifdef CONFIG_VIRTIO_DEBUG
 void virtio_debug_device_init(struct virtio_device *dev);
 void virtio_debug_device_exit(struct virtio_device *dev);
@@ -227,6 +227,29 @@ void xz_dec_reset(struct xz_dec *s);
  */
 void xz_dec_end(struct xz_dec *s);
 
+/**
+ * xz_dec_mt_run() - Decode a whole .xz Stream using several CPUs
+ * @b:          Input and output buffers
+ * @nr_threads: Maximum number of Blocks decoded concurrently. Zero means
+ *              the number of online CPUs.
+ *
+ * This works like xz_dec_run() in single-call mode: b->in must contain the
+ * whole Stream, optionally followed by Stream Padding, and b->out must have
+ * room for all of the uncompressed data. The Index is parsed first and then
+ * the Blocks are decoded in parallel on an unbound workqueue, each directly
+ * into its part of b->out. Only a single Stream is supported.
+ *
+ * XZ_OPTIONS_ERROR is returned when the Stream cannot be decoded in parallel,
+ * for example because it has only one Block, has more than one Stream, or
+ * uses an integrity check other than none or CRC32. The caller should then
+ * fall back to xz_dec_run(). On success XZ_STREAM_END is returned; on any
+ * failure b->in_pos and b->out_pos are left unchanged, but the contents of
+ * b->out are undefined.
+ *
+ * This may sleep and is available only with CONFIG_XZ_DEC_MT.
+ */
+enum xz_ret xz_dec_mt_run(struct xz_buf *b, unsigned int nr_threads);
+
 /**
  * DOC: MicroLZMA decompressor
  *
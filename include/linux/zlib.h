@@ -511,6 +511,17 @@ extern int zlib_deflateReset (z_streamp strm);
    stream state was inconsistent (such as zalloc or state being NULL).
 */
 
+extern int zlib_deflate_set_may_sleep (z_streamp strm, int may_sleep);
+/*
+     Tells a hardware-assisted deflate implementation whether deflate() may
+   reschedule between the partial completions of a long conversion. Only set
+   this for streams that are never used in atomic context. The setting is
+   cleared by deflateInit and deflateReset.
+
+      Returns Z_OK if success, or Z_STREAM_ERROR if the stream state was
+   inconsistent.
+*/
+
 static inline unsigned long deflateBound(unsigned long s)
 {
 	return s + ((s + 7) >> 3) + ((s + 63) >> 6) + 11;
@@ -568,6 +579,12 @@ extern int zlib_inflateReset (z_streamp strm);
    stream state was inconsistent (such as zalloc or state being NULL).
 */
 
+extern int zlib_inflate_set_may_sleep (z_streamp strm, int may_sleep);
+/*
+     Inflate counterpart of zlib_deflate_set_may_sleep(). The setting is
+   cleared by inflateInit and inflateReset.
+*/
+
 extern int zlib_inflateIncomp (z_stream *strm);
 /*
      This function adds the data at next_in (avail_in bytes) to the output
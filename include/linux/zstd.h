@@ -411,6 +411,86 @@ typedef ZSTD_inBuffer zstd_in_buffer;
  */
 typedef ZSTD_outBuffer zstd_out_buffer;
 
+/* ======   Multi-threaded Compression   ====== */
+
+/**
+ * struct zstd_mt_ctx - multi-threaded compression context
+ *
+ * Splits the input into jobs of a fixed size, compresses every job into an
+ * independent zstd frame on an unbound workqueue and stitches the frames
+ * together in order. Concatenated frames decompress as one stream with any
+ * zstd decoder.
+ */
+typedef struct zstd_mt_ctx zstd_mt_ctx;
+
+/**
+ * zstd_mt_create() - create a multi-threaded compression context
+ * @parameters:     The zstd parameters used for every job.
+ * @nr_workers:     Number of jobs compressed concurrently. 0 selects the
+ *                  number of online CPUs.
+ * @job_size:       Uncompressed size of one job. 0 selects 4 MiB.
+ * @ldm_window_log: Enable long distance matching within each job with a
+ *                  window of 1 << @ldm_window_log bytes. 0 disables it.
+ *
+ * Every worker owns a compression context whose workspace is kept between
+ * jobs. The context may sleep and must not be shared between concurrent
+ * callers.
+ *
+ * Return:          The context or NULL on error.
+ */
+zstd_mt_ctx *zstd_mt_create(const zstd_parameters *parameters,
+	unsigned int nr_workers, size_t job_size, unsigned int ldm_window_log);
+
+/**
+ * zstd_mt_destroy() - free a multi-threaded compression context
+ * @mt: The context to free. May be NULL.
+ */
+void zstd_mt_destroy(zstd_mt_ctx *mt);
+
+/**
+ * zstd_mt_compress_bound() - maximum compressed size of the job frames
+ * @mt:       The multi-threaded compression context.
+ * @src_size: The size of the data to compress.
+ *
+ * Return:    The output size that is guaranteed to be large enough for
+ *            zstd_mt_compress() of @src_size bytes.
+ */
+size_t zstd_mt_compress_bound(const zstd_mt_ctx *mt, size_t src_size);
+
+/**
+ * zstd_mt_compress() - compress src into dst using several workers
+ * @mt:           The multi-threaded compression context.
+ * @dst:          The buffer to compress src into.
+ * @dst_capacity: The size of the destination buffer. Use
+ *                zstd_mt_compress_bound() to size it.
+ * @src:          The data to compress.
+ * @src_size:     The size of the data to compress.
+ *
+ * Return:        The compressed size or an error, which can be checked using
+ *                zstd_is_error().
+ */
+size_t zstd_mt_compress(zstd_mt_ctx *mt, void *dst, size_t dst_capacity,
+	const void *src, size_t src_size);
+
+/**
+ * zstd_mt_compress_stream() - compress whole jobs of input into output
+ * @mt:     The multi-threaded compression context.
+ * @output: Destination buffer. `output->pos` is updated to indicate how much
+ *          compressed data was written.
+ * @input:  Source buffer. `input->pos` is updated to indicate how much data
+ *          was read.
+ * @end:    Whether this is the last input. If false, a trailing partial job
+ *          is left unconsumed so the caller can refill it.
+ *
+ * A job is only started when the output has room for its worst case
+ * compressed size, so a small output buffer limits the parallelism.
+ *
+ * Return:  The number of input bytes left unconsumed, or an error, which can
+ *          be checked using zstd_is_error().
+ */
+size_t zstd_mt_compress_stream(zstd_mt_ctx *mt, zstd_out_buffer *output,
+	zstd_in_buffer *input, bool end);
+
 /* ======   Streaming Compression   ====== */
 
 typedef ZSTD_CStream zstd_cstream;
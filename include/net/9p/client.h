@@ -95,6 +95,8 @@ struct p9_req_t {
  * @fids: All active FID handles
  * @reqs: All active requests.
  * @name: node name used as client id
+ * @cache_ttl: lifetime of cached metadata in milliseconds, 0 if disabled
+ * @cache: metadata cache, see net/9p/cache.c
  *
  * The client structure is used to keep track of various per-client
  * state that has been instantiated.
@@ -124,6 +126,9 @@ struct p9_client {
 	struct idr reqs;
 
 	char name[__NEW_UTS_LEN + 1];
+
+	unsigned int cache_ttl;
+	struct p9_cache *cache;
 };
 
 /**
@@ -80,6 +80,8 @@ struct kcm_sock {
 	/* Receive */
 	struct kcm_psock *rx_psock;
 	struct list_head wait_rx_list; /* KCMs waiting for receiving */
+	int rx_cpu; /* CPU last read on, to steer messages to */
+	int rx_skipped; /* Times passed over while first waiter */
 	bool rx_wait;
 	u32 rx_disabled : 1;
 };
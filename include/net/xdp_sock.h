@@ -19,6 +19,7 @@
 struct net_device;
 struct xsk_queue;
 struct xdp_buff;
+struct xsk_bp_group;
 
 struct xdp_umem {
 	void *addrs;
@@ -38,6 +39,18 @@ struct xdp_umem {
 	struct work_struct work;
 };
 
+#define XSK_LAT_BUCKETS 16
+
+/* Sampled latency histogram. One ring position at a time is followed: @ts
+ * holds the time it was published (0 when there is no outstanding sample)
+ * and the sample completes once the other side of the ring moves past @idx.
+ */
+struct xsk_lat_hist {
+	atomic64_t ts;
+	u32 idx;
+	atomic64_t buckets[XSK_LAT_BUCKETS];
+};
+
 struct xsk_map {
 	struct bpf_map map;
 	spinlock_t lock; /* Synchronize map updates */
@@ -77,6 +90,19 @@ struct xdp_sock {
 	/* Statistics */
 	u64 rx_dropped;
 	u64 rx_queue_full;
+	u64 rx_wakeups;
+	u64 tx_wakeups;
+	u64 poll_wakeups;
+	/* Optional, enabled with the XDP_LATENCY_STATS socket option */
+	bool lat_stats;
+	struct xsk_lat_hist rx_lat;
+
+	/* Requested XDP_TX_COALESCE setting, applied to the pool on bind */
+	struct xdp_tx_coalesce tx_coalesce;
+
+	/* Busy-poll group this socket belongs to, see XDP_BUSY_POLL_GROUP */
+	struct xsk_bp_group __rcu *bp_group;
+	struct list_head bp_node;
 
 	/* When __xsk_generic_xmit() must return before it sees the EOP descriptor for the current
 	 * packet, the partially built skb is saved here so that packet building can resume in next
@@ -217,6 +217,16 @@ static inline void xsk_buff_dma_sync_for_cpu(struct xdp_buff *xdp)
 	xp_dma_sync_for_cpu(xskb);
 }
 
+/* Like xsk_buff_dma_sync_for_cpu(), but only for the first @len bytes of
+ * packet data, which is all the NIC wrote for a small frame.
+ */
+static inline void xsk_buff_dma_sync_for_cpu_len(struct xdp_buff *xdp, u32 len)
+{
+	struct xdp_buff_xsk *xskb = container_of(xdp, struct xdp_buff_xsk, xdp);
+
+	xp_dma_sync_for_cpu_len(xskb, len);
+}
+
 static inline void xsk_buff_raw_dma_sync_for_device(struct xsk_buff_pool *pool,
 						    dma_addr_t dma,
 						    size_t size)
@@ -389,6 +399,10 @@ static inline void xsk_buff_dma_sync_for_cpu(struct xdp_buff *xdp)
 {
 }
 
+static inline void xsk_buff_dma_sync_for_cpu_len(struct xdp_buff *xdp, u32 len)
+{
+}
+
 static inline void xsk_buff_raw_dma_sync_for_device(struct xsk_buff_pool *pool,
 						    dma_addr_t dma,
 						    size_t size)
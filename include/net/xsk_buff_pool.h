@@ -7,8 +7,10 @@
 #include <linux/if_xdp.h>
 #include <linux/types.h>
 #include <linux/dma-mapping.h>
+#include <linux/hrtimer.h>
 #include <linux/bpf.h>
 #include <net/xdp.h>
+#include <net/xdp_sock.h>
 
 struct xsk_buff_pool;
 struct xdp_rxq_info;
@@ -36,6 +38,8 @@ struct xdp_buff_xsk {
 
 struct xsk_dma_map {
 	dma_addr_t *dma_pages;
+	/* Bit set for the first page of each individually mapped IOVA range */
+	unsigned long *map_starts;
 	struct device *dev;
 	struct net_device *netdev;
 	refcount_t users;
@@ -57,6 +61,8 @@ struct xsk_buff_pool {
 	struct list_head xskb_list;
 	u32 heads_cnt;
 	u16 queue_id;
+	/* NUMA node of the bound netdev, used for pool metadata allocations */
+	int node;
 
 	/* Data path members as close to free_heads at the end as possible. */
 	struct xsk_queue *fq ____cacheline_aligned_in_smp;
@@ -65,6 +71,8 @@ struct xsk_buff_pool {
 	 * even when they are identical.
 	 */
 	dma_addr_t *dma_pages;
+	/* IOVA of the whole UMEM when it is mapped as a single range */
+	dma_addr_t dma_base;
 	struct xdp_buff_xsk *heads;
 	struct xdp_desc *tx_descs;
 	u64 chunk_mask;
@@ -82,12 +90,21 @@ struct xsk_buff_pool {
 	bool uses_need_wakeup;
 	bool unaligned;
 	bool tx_sw_csum;
+	bool dma_contig;
+	/* Set when a socket bound to this pool enabled XDP_LATENCY_STATS */
+	bool lat_stats;
 	void *addrs;
 	/* Mutual exclusion of the completion ring in the SKB mode. Two cases to protect:
 	 * NAPI TX thread and sendmsg error paths in the SKB destructor callback and when
 	 * sockets share a single cq when the same netdev and queue id is shared.
 	 */
 	spinlock_t cq_lock;
+	/* Tx completion coalescing, protected by cq_lock */
+	u32 cq_coalesce_frames;
+	u32 cq_coalesce_usecs;
+	u32 cq_pending;
+	struct hrtimer cq_timer;
+	struct xsk_lat_hist tx_lat;
 	struct xdp_buff_xsk *free_heads[];
 };
 
@@ -100,7 +117,8 @@ struct xsk_buff_pool {
 
 /* AF_XDP core. */
 struct xsk_buff_pool *xp_create_and_assign_umem(struct xdp_sock *xs,
-						struct xdp_umem *umem);
+						struct xdp_umem *umem,
+						struct net_device *dev);
 int xp_assign_dev(struct xsk_buff_pool *pool, struct net_device *dev,
 		  u16 queue_id, u16 flags);
 int xp_assign_dev_shared(struct xsk_buff_pool *pool, struct xdp_sock *umem_xs,
@@ -158,6 +176,12 @@ static inline void xp_dma_sync_for_cpu(struct xdp_buff_xsk *xskb)
 				DMA_BIDIRECTIONAL);
 }
 
+static inline void xp_dma_sync_for_cpu_len(struct xdp_buff_xsk *xskb, u32 len)
+{
+	dma_sync_single_for_cpu(xskb->pool->dev, xskb->dma, len,
+				DMA_BIDIRECTIONAL);
+}
+
 static inline void xp_dma_sync_for_device(struct xsk_buff_pool *pool,
 					  dma_addr_t dma, size_t size)
 {
@@ -179,7 +203,7 @@ static inline bool xp_desc_crosses_non_contig_pg(struct xsk_buff_pool *pool,
 	if (likely(!cross_pg))
 		return false;
 
-	return pool->dma_pages &&
+	return pool->dma_pages && !pool->dma_contig &&
 	       !(pool->dma_pages[addr >> PAGE_SHIFT] & XSK_NEXT_PG_CONTIG_MASK);
 }
 
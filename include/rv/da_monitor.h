@@ -36,9 +36,12 @@ static void cond_react_##name(char *msg)							\
 		rv_##name.react(msg);								\
 }												\
 												\
+/*												\
+ * rv_reacting_on_##name - checks if a reactor is set, so the message is worth formatting	\
+ */												\
 static bool rv_reacting_on_##name(void)								\
 {												\
-	return rv_reacting_on();								\
+	return rv_reacting_on() && READ_ONCE(rv_##name.react);					\
 }
 
 #else /* CONFIG_RV_REACTOR */
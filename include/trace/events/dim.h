@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM dim
+
+#if !defined(_TRACE_DIM_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_DIM_H
+
+#include <linux/dim.h>
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(net_dim_decision,
+
+	TP_PROTO(const struct dim *dim, const struct dim_stats *stats,
+		 bool changed),
+
+	TP_ARGS(dim, stats, changed),
+
+	TP_STRUCT__entry(
+		__field(	const void *,	dim)
+		__field(	int,		cpu)
+		__field(	int,		ppms)
+		__field(	int,		bpms)
+		__field(	int,		epms)
+		__field(	u8,		profile_ix)
+		__field(	u8,		tune_state)
+		__field(	u8,		steps_left)
+		__field(	u8,		steps_right)
+		__field(	u8,		tired)
+		__field(	u8,		coord)
+		__field(	bool,		changed)
+	),
+
+	TP_fast_assign(
+		__entry->dim = dim;
+		__entry->cpu = raw_smp_processor_id();
+		__entry->ppms = stats->ppms;
+		__entry->bpms = stats->bpms;
+		__entry->epms = stats->epms;
+		__entry->profile_ix = dim->profile_ix;
+		__entry->tune_state = dim->tune_state;
+		__entry->steps_left = dim->steps_left;
+		__entry->steps_right = dim->steps_right;
+		__entry->tired = dim->tired;
+		__entry->coord = dim->coord;
+		__entry->changed = changed;
+	),
+
+	TP_printk("dim %p cpu %d ppms %d bpms %d epms %d profile %u%s state %s steps %u/%u tired %u coord %u",
+		  __entry->dim, __entry->cpu, __entry->ppms, __entry->bpms,
+		  __entry->epms, __entry->profile_ix,
+		  __entry->changed ? " (new)" : "",
+		  __print_symbolic(__entry->tune_state,
+				   { DIM_PARKING_ON_TOP,	"parking_on_top" },
+				   { DIM_PARKING_TIRED,		"parking_tired" },
+				   { DIM_GOING_RIGHT,		"going_right" },
+				   { DIM_GOING_LEFT,		"going_left" }),
+		  __entry->steps_left, __entry->steps_right, __entry->tired,
+		  __entry->coord)
+);
+
+#endif /* _TRACE_DIM_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
@@ -62,6 +62,33 @@ TRACE_EVENT(cpu_idle_miss,
 		(unsigned long)__entry->state, (__entry->below)?"below":"above")
 );
 
+TRACE_EVENT(cpu_idle_residency,
+
+	TP_PROTO(unsigned int cpu_id, unsigned int state, u64 residency_ns,
+		 u64 predicted_ns),
+
+	TP_ARGS(cpu_id, state, residency_ns, predicted_ns),
+
+	TP_STRUCT__entry(
+		__field(u32,		cpu_id)
+		__field(u32,		state)
+		__field(u64,		residency_ns)
+		__field(u64,		predicted_ns)
+	),
+
+	TP_fast_assign(
+		__entry->cpu_id = cpu_id;
+		__entry->state = state;
+		__entry->residency_ns = residency_ns;
+		__entry->predicted_ns = predicted_ns;
+	),
+
+	TP_printk("cpu_id=%lu state=%lu residency_ns=%llu predicted_ns=%llu",
+		(unsigned long)__entry->cpu_id, (unsigned long)__entry->state,
+		(unsigned long long)__entry->residency_ns,
+		(unsigned long long)__entry->predicted_ns)
+);
+
 TRACE_EVENT(powernv_throttle,
 
 	TP_PROTO(int chip_id, const char *reason, int pmax),
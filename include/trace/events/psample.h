@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM psample
+
+#if !defined(_TRACE_PSAMPLE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_PSAMPLE_H
+
+#include <linux/skbuff.h>
+#include <linux/tracepoint.h>
+#include <net/psample.h>
+
+/*
+ * Fired for every sampled packet, whether or not anyone listens on the
+ * netlink sample group. BPF programs attached here (tp_btf) can copy the
+ * packet headers and metadata to a BPF ring buffer without paying for a
+ * netlink message per sample.
+ */
+TRACE_EVENT(psample_sample_packet,
+
+	TP_PROTO(struct psample_group *group, const struct sk_buff *skb,
+		 u32 sample_rate, const struct psample_metadata *md),
+
+	TP_ARGS(group, skb, sample_rate, md),
+
+	TP_STRUCT__entry(
+		__field(u32,		group_num)
+		__field(u32,		sample_rate)
+		__field(u32,		len)
+		__field(u32,		trunc_size)
+		__field(int,		in_ifindex)
+		__field(int,		out_ifindex)
+		__field(unsigned short,	protocol)
+	),
+
+	TP_fast_assign(
+		__entry->group_num = group->group_num;
+		__entry->sample_rate = sample_rate;
+		__entry->len = skb->len;
+		__entry->trunc_size = md->trunc_size;
+		__entry->in_ifindex = md->in_ifindex;
+		__entry->out_ifindex = md->out_ifindex;
+		__entry->protocol = ntohs(skb->protocol);
+	),
+
+	TP_printk("group=%u rate=%u len=%u trunc_size=%u iif=%d oif=%d protocol=0x%04x",
+		  __entry->group_num, __entry->sample_rate, __entry->len,
+		  __entry->trunc_size, __entry->in_ifindex,
+		  __entry->out_ifindex, __entry->protocol)
+);
+
+#endif /* _TRACE_PSAMPLE_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
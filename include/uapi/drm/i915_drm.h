@@ -2938,6 +2938,37 @@ struct drm_i915_perf_open_param {
  */
 #define I915_PERF_IOCTL_CONFIG	_IO('i', 0x2)
 
+/*
+ * Query and advance the head/tail of the OA buffer of a stream whose buffer
+ * was mmap'd, taking a struct drm_i915_perf_buf_ptrs.
+ *
+ * The OA buffer can be mapped read-only with mmap() on the stream fd, in
+ * which case userspace consumes the raw reports in place rather than
+ * copying them out with read(). Reports between @head and @tail (byte
+ * offsets into the buffer, wrapping around) have fully landed. Passing the
+ * offset consumed up to back as @head with I915_PERF_BUF_PTRS_SET_HEAD
+ * releases that space to the OA unit. Reports are not filtered or
+ * sanitized on this path, so mapping requires the same privileges as an
+ * unfiltered stream. read() and mmap consumption should not be mixed.
+ *
+ * This ioctl is available in perf revision 8.
+ */
+#define I915_PERF_IOCTL_BUF_PTRS	_IO('i', 0x3)
+
+struct drm_i915_perf_buf_ptrs {
+	__u32 flags;
+#define I915_PERF_BUF_PTRS_SET_HEAD	(1 << 0)
+
+	/* In/out: offset of the oldest unconsumed report */
+	__u32 head;
+
+	/* Out: offset just past the newest landed report */
+	__u32 tail;
+
+	/* MBZ */
+	__u32 pad;
+};
+
 /*
  * Common to all i915 perf records
  */
@@ -22,6 +22,7 @@ extern "C" {
 #define DRM_IVPU_METRIC_STREAMER_STOP	  0x08
 #define DRM_IVPU_METRIC_STREAMER_GET_DATA 0x09
 #define DRM_IVPU_METRIC_STREAMER_GET_INFO 0x0a
+#define DRM_IVPU_SUBMIT_BATCH		  0x0b
 
 #define DRM_IOCTL_IVPU_GET_PARAM                                               \
 	DRM_IOWR(DRM_COMMAND_BASE + DRM_IVPU_GET_PARAM, struct drm_ivpu_param)
@@ -57,6 +58,9 @@ extern "C" {
 	DRM_IOWR(DRM_COMMAND_BASE + DRM_IVPU_METRIC_STREAMER_GET_INFO,         \
 		 struct drm_ivpu_metric_streamer_get_data)
 
+#define DRM_IOCTL_IVPU_SUBMIT_BATCH                                            \
+	DRM_IOW(DRM_COMMAND_BASE + DRM_IVPU_SUBMIT_BATCH, struct drm_ivpu_submit_batch)
+
 /**
  * DOC: contexts
  *
@@ -107,6 +111,13 @@ extern "C" {
  * accessible by hardware DMA.
  */
 #define DRM_IVPU_CAP_DMA_MEMORY_RANGE	2
+/**
+ * DRM_IVPU_CAP_SUBMIT_BATCH
+ *
+ * Driver supports %DRM_IOCTL_IVPU_SUBMIT_BATCH, which queues several jobs
+ * with a single doorbell.
+ */
+#define DRM_IVPU_CAP_SUBMIT_BATCH	3
 
 /**
  * struct drm_ivpu_param - Get/Set VPU parameters
@@ -316,6 +327,34 @@ struct drm_ivpu_submit {
 	__u32 priority;
 };
 
+/* Maximum number of jobs in a single &drm_ivpu_submit_batch */
+#define DRM_IVPU_SUBMIT_BATCH_MAX 64
+
+/**
+ * struct drm_ivpu_submit_batch - Submit several jobs to the VPU at once
+ *
+ * Queues each element of @submits_ptr the same way as %DRM_IOCTL_IVPU_SUBMIT,
+ * but publishes all of them to the job queue together and rings the doorbell
+ * once for the whole batch. Either all jobs are queued or none of them is.
+ *
+ * All elements must target the same engine and use the same priority.
+ */
+struct drm_ivpu_submit_batch {
+	/**
+	 * @submits_ptr:
+	 *
+	 * A pointer to an array of &struct drm_ivpu_submit.
+	 * The number of elements in the array must be equal to the value given by @count.
+	 */
+	__u64 submits_ptr;
+
+	/** @count: Number of elements in the @submits_ptr, at most %DRM_IVPU_SUBMIT_BATCH_MAX */
+	__u32 count;
+
+	/** @flags: Reserved for future use - must be zero */
+	__u32 flags;
+};
+
 /* drm_ivpu_bo_wait job status codes */
 #define DRM_IVPU_JOB_STATUS_SUCCESS 0
 #define DRM_IVPU_JOB_STATUS_ABORTED 256
@@ -1453,6 +1453,12 @@ enum drm_xe_observation_ioctls {
 
 	/** @DRM_XE_OBSERVATION_IOCTL_INFO: Return observation stream info */
 	DRM_XE_OBSERVATION_IOCTL_INFO = _IO('i', 0x4),
+
+	/**
+	 * @DRM_XE_OBSERVATION_IOCTL_BUF_PTRS: Query and advance the head/tail
+	 * of an mmap'd observation stream buffer
+	 */
+	DRM_XE_OBSERVATION_IOCTL_BUF_PTRS = _IO('i', 0x5),
 };
 
 /**
@@ -1713,6 +1719,38 @@ struct drm_xe_oa_stream_info {
 	__u64 reserved[3];
 };
 
+/**
+ * struct drm_xe_oa_buf_ptrs - OA buffer pointers exchanged through the
+ * @DRM_XE_OBSERVATION_IOCTL_BUF_PTRS observation stream fd ioctl
+ *
+ * This lets userspace consume reports straight from the mmap'd OA buffer
+ * instead of copying them out with read(). Reports between @head and @tail
+ * (both byte offsets into the OA buffer, wrapping around) have fully landed.
+ * Once done with them, userspace passes the offset it consumed up to back
+ * as @head with DRM_XE_OA_BUF_PTRS_SET_HEAD, which releases that space to
+ * the OA unit. read() and mmap consumption should not be mixed on a stream.
+ */
+struct drm_xe_oa_buf_ptrs {
+	/** @extensions: Pointer to the first extension struct, if any */
+	__u64 extensions;
+
+	/** @flags: In, DRM_XE_OA_BUF_PTRS_* */
+	__u32 flags;
+#define DRM_XE_OA_BUF_PTRS_SET_HEAD	(1 << 0)
+
+	/** @head: In/out, offset of the oldest unconsumed report */
+	__u32 head;
+
+	/** @tail: Out, offset just past the newest landed report */
+	__u32 tail;
+
+	/** @pad: MBZ */
+	__u32 pad;
+
+	/** @reserved: reserved for future use */
+	__u64 reserved[2];
+};
+
 #if defined(__cplusplus)
 }
 #endif
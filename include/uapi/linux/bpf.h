@@ -1431,6 +1431,11 @@ enum {
 #define BPF_F_TEST_XDP_LIVE_FRAMES	(1U << 1)
 /* If set, apply CHECKSUM_COMPLETE to skb and validate the checksum */
 #define BPF_F_TEST_SKB_CHECKSUM_COMPLETE	(1U << 2)
+/* With BPF_F_TEST_XDP_LIVE_FRAMES, data_in holds several packets, each
+ * preceded by its length as a __u32 and padded to 4 bytes, which are
+ * replayed in turn.
+ */
+#define BPF_F_TEST_XDP_MULTI_FRAMES	(1U << 3)
 
 /* type for BPF_ENABLE_STATS */
 enum bpf_stats_type {
@@ -232,6 +232,29 @@ struct fanotify_response_info_audit_rule {
 #define FAN_NOPIDFD	FAN_NOFD
 #define FAN_EPIDFD	-2
 
+/*
+ * Header of the event ring set up by mmap() of a fanotify fd, see
+ * fanotify_mmap().  The data area starts data_offset bytes into the mapping
+ * and holds size bytes (a power of 2) of event records, in the same format as
+ * read() returns them, but always with fd set to FAN_NOFD.
+ *
+ * head and tail are free running byte offsets, taken modulo size.  The kernel
+ * advances tail after writing records, userspace advances head after consuming
+ * them.  A record never wraps: if the next one does not fit before the end of
+ * the data area, the kernel writes an event_len of 0 there and continues at
+ * the start, so a consumer that reads an event_len of 0 skips to the start.
+ * Events that find the ring full are dropped and counted in overflow.
+ */
+struct fanotify_ring_header {
+	__u32 tail;
+	__u32 size;
+	__u32 data_offset;
+	__u32 overflow;
+	__u32 reserved[12];
+	/* Written by userspace, on its own cache line */
+	__u32 head;
+};
+
 /* Helper functions to deal with fanotify_event_metadata buffers */
 #define FAN_EVENT_METADATA_LEN (sizeof(struct fanotify_event_metadata))
 
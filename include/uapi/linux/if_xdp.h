@@ -79,6 +79,9 @@ struct xdp_mmap_offsets {
 #define XDP_UMEM_COMPLETION_RING	6
 #define XDP_STATISTICS			7
 #define XDP_OPTIONS			8
+#define XDP_LATENCY_STATS		9
+#define XDP_BUSY_POLL_GROUP		10
+#define XDP_TX_COALESCE			11
 
 struct xdp_umem_reg {
 	__u64 addr; /* Start of packet data area */
@@ -102,6 +105,14 @@ struct xdp_options {
 	__u32 flags;
 };
 
+/* Publish Tx completions once max_frames are pending or usecs after the
+ * first pending one, whichever comes first. max_frames <= 1 disables it.
+ */
+struct xdp_tx_coalesce {
+	__u32 max_frames;
+	__u32 usecs;
+};
+
 /* Flags for the flags field of struct xdp_options */
 #define XDP_OPTIONS_ZEROCOPY (1 << 0)
 
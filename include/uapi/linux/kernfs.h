@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+#ifndef _UAPI_LINUX_KERNFS_H
+#define _UAPI_LINUX_KERNFS_H
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+#define KERNFS_IOC_MAGIC	0xb8
+
+/*
+ * Read the same attribute of all children of a kernfs (sysfs, cgroupfs, ...)
+ * directory in one call.
+ *
+ * @attr points to the NUL terminated path of the attribute relative to each
+ * child, e.g. "memory.stat" or "statistics/rx_bytes".  It may not be absolute
+ * or contain "..".  Each attribute is opened and read as by openat() relative
+ * to the child, so the usual permission checks apply.
+ *
+ * @buf receives one struct kernfs_bulk_entry per child having the attribute.
+ * At most @max_size bytes of each attribute are returned, 0 means PAGE_SIZE.
+ *
+ * The walk starts at @cookie, 0 for the first call, and stops when @buf is
+ * full.  On return @cookie is where to continue, or KERNFS_BULK_COOKIE_END if
+ * all children were visited, @count is the number of entries and @used the
+ * number of bytes stored in @buf.  Children whose names hash to the same
+ * cookie may be returned again after a continuation.
+ */
+struct kernfs_bulk_read {
+	__aligned_u64 attr;
+	__aligned_u64 buf;
+	__u32 buf_len;
+	__u32 max_size;
+	__aligned_u64 cookie;
+	__u32 count;
+	__u32 used;
+	__u32 flags;		/* must be 0 */
+	__u32 reserved;
+};
+
+#define KERNFS_BULK_COOKIE_END	0x7fffffff
+
+/*
+ * Entries are 8 byte aligned.  The NUL terminated child name is followed by
+ * data_len bytes of attribute contents, or nothing if error is set to the
+ * negative errno the open or read failed with.
+ */
+struct kernfs_bulk_entry {
+	__u32 rec_len;		/* total length, including padding */
+	__u16 name_len;		/* excluding the terminating NUL */
+	__u16 flags;
+	__s32 error;
+	__u32 data_len;
+	char name[];
+};
+
+/* The attribute is larger than max_size and was truncated */
+#define KERNFS_BULK_TRUNCATED	0x1
+
+#define KERNFS_IOC_BULK_READ	_IOWR(KERNFS_IOC_MAGIC, 1, struct kernfs_bulk_read)
+
+#endif /* _UAPI_LINUX_KERNFS_H */
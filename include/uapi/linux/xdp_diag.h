@@ -31,6 +31,7 @@ struct xdp_diag_msg {
 #define XDP_SHOW_UMEM		(1 << 2)
 #define XDP_SHOW_MEMINFO	(1 << 3)
 #define XDP_SHOW_STATS		(1 << 4)
+#define XDP_SHOW_LATENCY	(1 << 5)
 
 enum {
 	XDP_DIAG_NONE,
@@ -43,6 +44,7 @@ enum {
 	XDP_DIAG_UMEM_COMPLETION_RING,
 	XDP_DIAG_MEMINFO,
 	XDP_DIAG_STATS,
+	XDP_DIAG_LATENCY,
 	__XDP_DIAG_MAX,
 };
 
@@ -80,4 +82,20 @@ struct xdp_diag_stats {
 	__u64	n_tx_ring_empty;
 };
 
+#define XDP_DIAG_LAT_BUCKETS 16
+
+/* Sampled latency histograms, filled in once XDP_LATENCY_STATS has been
+ * enabled on the socket. Bucket 0 counts samples below 1024ns, bucket i
+ * counts samples in [2^(i-1), 2^i) * 1024ns and the last bucket is open
+ * ended. The wakeup counters count syscalls that had to kick the driver
+ * or the copy-mode Tx path.
+ */
+struct xdp_diag_latency {
+	__u64	rx_residency[XDP_DIAG_LAT_BUCKETS]; /* Rx ring: produced to consumed */
+	__u64	tx_completion[XDP_DIAG_LAT_BUCKETS]; /* Tx ring read to completion */
+	__u64	n_rx_wakeups;
+	__u64	n_tx_wakeups;
+	__u64	n_poll_wakeups;
+};
+
 #endif /* _LINUX_XDP_DIAG_H */
@@ -414,6 +414,16 @@ static ssize_t transition_show(struct kobject *kobj,
 	return sysfs_emit(buf, "%d\n", patch == klp_transition_patch);
 }
 
+static ssize_t pending_show(struct kobject *kobj,
+			    struct kobj_attribute *attr, char *buf)
+{
+	struct klp_patch *patch;
+
+	patch = container_of(kobj, struct klp_patch, kobj);
+	return sysfs_emit(buf, "%u\n", patch == klp_transition_patch ?
+			  READ_ONCE(klp_transition_pending) : 0);
+}
+
 static ssize_t force_store(struct kobject *kobj, struct kobj_attribute *attr,
 			   const char *buf, size_t count)
 {
@@ -454,11 +464,13 @@ static ssize_t replace_show(struct kobject *kobj,
 
 static struct kobj_attribute enabled_kobj_attr = __ATTR_RW(enabled);
 static struct kobj_attribute transition_kobj_attr = __ATTR_RO(transition);
+static struct kobj_attribute pending_kobj_attr = __ATTR_RO(pending);
 static struct kobj_attribute force_kobj_attr = __ATTR_WO(force);
 static struct kobj_attribute replace_kobj_attr = __ATTR_RO(replace);
 static struct attribute *klp_patch_attrs[] = {
 	&enabled_kobj_attr.attr,
 	&transition_kobj_attr.attr,
+	&pending_kobj_attr.attr,
 	&force_kobj_attr.attr,
 	&replace_kobj_attr.attr,
 	NULL
@@ -27,6 +27,15 @@ static int klp_target_state = KLP_TRANSITION_IDLE;
 
 static unsigned int klp_signals_cnt;
 
+/*
+ * Bumped on every transition start, so that stack checks cached by a previous
+ * transition aren't trusted.  Never 0, which new tasks start with.
+ */
+static unsigned int klp_check_gen;
+
+/* Tasks not yet switched to the target state, as of the last check */
+unsigned int klp_transition_pending;
+
 /*
  * When a livepatch is in progress, enable klp stack checking in
  * cond_resched().  This helps CPU-bound kthreads get patched.
@@ -290,6 +299,23 @@ static int klp_check_stack(struct task_struct *task, const char **oldname)
 	return 0;
 }
 
+static unsigned long klp_task_switches(struct task_struct *task)
+{
+	return READ_ONCE(task->nvcsw) + READ_ONCE(task->nivcsw);
+}
+
+/*
+ * A task whose stack was found unsafe, and which hasn't been switched out
+ * since, either still sleeps on the very same stack or is running.  Either
+ * way, walking its stack again would be a waste of time.
+ */
+static bool klp_check_cached(struct task_struct *task)
+{
+	return task != current &&
+	       READ_ONCE(task->patch_check_gen) == klp_check_gen &&
+	       READ_ONCE(task->patch_check_switches) == klp_task_switches(task);
+}
+
 static int klp_check_and_switch_task(struct task_struct *task, void *arg)
 {
 	int ret;
@@ -298,8 +324,15 @@ static int klp_check_and_switch_task(struct task_struct *task, void *arg)
 		return -EBUSY;
 
 	ret = klp_check_stack(task, arg);
-	if (ret)
+	if (ret) {
+		/* The task can't be switched out while we look at it */
+		if (task != current) {
+			WRITE_ONCE(task->patch_check_gen, klp_check_gen);
+			WRITE_ONCE(task->patch_check_switches,
+				   klp_task_switches(task));
+		}
 		return ret;
+	}
 
 	clear_tsk_thread_flag(task, TIF_PATCH_PENDING);
 	task->patch_state = klp_target_state;
@@ -327,6 +360,9 @@ static bool klp_try_switch_task(struct task_struct *task)
 	if (!klp_have_reliable_stack())
 		return false;
 
+	if (klp_check_cached(task))
+		return false;
+
 	/*
 	 * Now try to check the stack for any to-be-patched or to-be-unpatched
 	 * functions.  If all goes well, switch the task to the target patch
@@ -453,7 +489,7 @@ void klp_try_complete_transition(void)
 	unsigned int cpu;
 	struct task_struct *g, *task;
 	struct klp_patch *patch;
-	bool complete = true;
+	unsigned int pending = 0;
 
 	WARN_ON_ONCE(klp_target_state == KLP_TRANSITION_IDLE);
 
@@ -469,7 +505,7 @@ void klp_try_complete_transition(void)
 	read_lock(&tasklist_lock);
 	for_each_process_thread(g, task)
 		if (!klp_try_switch_task(task))
-			complete = false;
+			pending++;
 	read_unlock(&tasklist_lock);
 
 	/*
@@ -480,7 +516,7 @@ void klp_try_complete_transition(void)
 		task = idle_task(cpu);
 		if (cpu_online(cpu)) {
 			if (!klp_try_switch_task(task)) {
-				complete = false;
+				pending++;
 				/* Make idle task go through the main loop. */
 				wake_up_if_idle(cpu);
 			}
@@ -492,7 +528,9 @@ void klp_try_complete_transition(void)
 	}
 	cpus_read_unlock();
 
-	if (!complete) {
+	WRITE_ONCE(klp_transition_pending, pending);
+
+	if (pending) {
 		if (klp_signals_cnt && !(klp_signals_cnt % SIGNALS_TIMEOUT))
 			klp_send_signals();
 		klp_signals_cnt++;
@@ -530,6 +568,7 @@ void klp_try_complete_transition(void)
 void klp_start_transition(void)
 {
 	struct task_struct *g, *task;
+	unsigned int pending = 0;
 	unsigned int cpu;
 
 	WARN_ON_ONCE(klp_target_state == KLP_TRANSITION_IDLE);
@@ -543,10 +582,16 @@ void klp_start_transition(void)
 	 * switch either in klp_try_complete_transition() or as they exit the
 	 * kernel.
 	 */
+	/* Forget the stack checks of a previous transition. */
+	if (!++klp_check_gen)
+		klp_check_gen++;
+
 	read_lock(&tasklist_lock);
 	for_each_process_thread(g, task)
-		if (task->patch_state != klp_target_state)
+		if (task->patch_state != klp_target_state) {
 			set_tsk_thread_flag(task, TIF_PATCH_PENDING);
+			pending++;
+		}
 	read_unlock(&tasklist_lock);
 
 	/*
@@ -556,10 +601,14 @@ void klp_start_transition(void)
 	 */
 	for_each_possible_cpu(cpu) {
 		task = idle_task(cpu);
-		if (task->patch_state != klp_target_state)
+		if (task->patch_state != klp_target_state) {
 			set_tsk_thread_flag(task, TIF_PATCH_PENDING);
+			pending++;
+		}
 	}
 
+	WRITE_ONCE(klp_transition_pending, pending);
+
 	klp_cond_resched_enable();
 
 	klp_signals_cnt = 0;
@@ -713,6 +762,7 @@ void klp_copy_process(struct task_struct *child)
 		clear_tsk_thread_flag(child, TIF_PATCH_PENDING);
 
 	child->patch_state = current->patch_state;
+	child->patch_check_gen = 0;
 }
 
 /*
@@ -574,19 +574,8 @@ static const struct file_operations enabled_monitors_ops = {
 /*
  * Monitoring on global switcher!
  */
-static bool __read_mostly monitoring_on;
-
-/**
- * rv_monitoring_on - checks if monitoring is on
- *
- * Returns 1 if on, 0 otherwise.
- */
-bool rv_monitoring_on(void)
-{
-	/* Ensures that concurrent monitors read consistent monitoring_on */
-	smp_rmb();
-	return READ_ONCE(monitoring_on);
-}
+DEFINE_STATIC_KEY_FALSE(rv_monitoring_on_key);
+EXPORT_SYMBOL_GPL(rv_monitoring_on_key);
 
 /*
  * monitoring_on general switcher.
@@ -603,9 +592,7 @@ static ssize_t monitoring_on_read_data(struct file *filp, char __user *user_buf,
 
 static void turn_monitoring_off(void)
 {
-	WRITE_ONCE(monitoring_on, false);
-	/* Ensures that concurrent monitors read consistent monitoring_on */
-	smp_wmb();
+	static_branch_disable(&rv_monitoring_on_key);
 }
 
 static void reset_all_monitors(void)
@@ -620,9 +607,7 @@ static void reset_all_monitors(void)
 
 static void turn_monitoring_on(void)
 {
-	WRITE_ONCE(monitoring_on, true);
-	/* Ensures that concurrent monitors read consistent monitoring_on */
-	smp_wmb();
+	static_branch_enable(&rv_monitoring_on_key);
 }
 
 static void turn_monitoring_on_with_reset(void)
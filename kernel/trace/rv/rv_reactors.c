@@ -357,19 +357,8 @@ int rv_unregister_reactor(struct rv_reactor *reactor)
 /*
  * reacting_on interface.
  */
-static bool __read_mostly reacting_on;
-
-/**
- * rv_reacting_on - checks if reacting is on
- *
- * Returns 1 if on, 0 otherwise.
- */
-bool rv_reacting_on(void)
-{
-	/* Ensures that concurrent monitors read consistent reacting_on */
-	smp_rmb();
-	return READ_ONCE(reacting_on);
-}
+DEFINE_STATIC_KEY_FALSE(rv_reacting_on_key);
+EXPORT_SYMBOL_GPL(rv_reacting_on_key);
 
 static ssize_t reacting_on_read_data(struct file *filp,
 				     char __user *user_buf,
@@ -384,16 +373,12 @@ static ssize_t reacting_on_read_data(struct file *filp,
 
 static void turn_reacting_off(void)
 {
-	WRITE_ONCE(reacting_on, false);
-	/* Ensures that concurrent monitors read consistent reacting_on */
-	smp_wmb();
+	static_branch_disable(&rv_reacting_on_key);
 }
 
 static void turn_reacting_on(void)
 {
-	WRITE_ONCE(reacting_on, true);
-	/* Ensures that concurrent monitors read consistent reacting_on */
-	smp_wmb();
+	static_branch_enable(&rv_reacting_on_key);
 }
 
 static ssize_t reacting_on_write_data(struct file *filp, const char __user *user_buf,
@@ -467,15 +452,13 @@ void reactor_cleanup_monitor(struct rv_monitor_def *mdef)
 
 /*
  * Nop reactor register
+ *
+ * It has no react callback, which tells the monitors not to bother
+ * formatting the message of an exception.
  */
-static void rv_nop_reaction(char *msg)
-{
-}
-
 static struct rv_reactor rv_nop = {
 	.name = "nop",
 	.description = "no-operation reactor: do nothing.",
-	.react = rv_nop_reaction
 };
 
 int init_rv_reactors(struct dentry *root_dir)
@@ -83,7 +83,15 @@ struct sw842_hlist_node2 {
 };
 
 #define INDEX_NOT_FOUND		(-1)
-#define INDEX_NOT_CHECKED	(-2)
+
+/* bits of the index hit mask, one per 8, 4 and 2 byte chunk of a block */
+#define HIT8(n)			BIT(n)
+#define HIT4(n)			BIT(1 + (n))
+#define HIT2(n)			BIT(3 + (n))
+#define HIT_MASKS		BIT(7)
+
+/* first (shortest) template usable for each index hit mask */
+static u8 template_for_hits[HIT_MASKS];
 
 struct sw842_param {
 	u8 *in;
@@ -131,13 +139,10 @@ struct sw842_param {
 	p->index##b[n] >= 0;						\
 })
 
-#define check_index(p, b, n)			\
-	((p)->index##b[n] == INDEX_NOT_CHECKED	\
-	 ? find_index(p, b, n)			\
-	 : (p)->index##b[n] >= 0)
-
 #define replace_hash(p, b, i, d)	do {				\
 	struct sw842_hlist_node##b *_n = &(p)->node##b[(i)+(d)];	\
+	if (_n->data == (p)->data##b[d] && !hlist_unhashed(&_n->node))	\
+		break;							\
 	hash_del(&_n->node);						\
 	_n->data = (p)->data##b[d];					\
 	pr_debug("add hash index%x %x pos %x data %lx\n", b,		\
@@ -377,32 +382,41 @@ static int add_end_template(struct sw842_param *p)
 	return 0;
 }
 
-static bool check_template(struct sw842_param *p, u8 c)
+/* the index hits template c needs to be usable */
+static u8 template_hits(u8 c)
 {
 	u8 *t = comp_ops[c];
-	int i, match, b = 0;
-
-	if (c >= OPS_MAX)
-		return false;
+	int i, b = 0;
+	u8 hits = 0;
 
 	for (i = 0; i < 4; i++) {
 		if (t[i] & OP_ACTION_INDEX) {
 			if (t[i] & OP_AMOUNT_2)
-				match = check_index(p, 2, b >> 1);
+				hits |= HIT2(b >> 1);
 			else if (t[i] & OP_AMOUNT_4)
-				match = check_index(p, 4, b >> 2);
+				hits |= HIT4(b >> 2);
 			else if (t[i] & OP_AMOUNT_8)
-				match = check_index(p, 8, 0);
-			else
-				return false;
-			if (!match)
-				return false;
+				hits |= HIT8(0);
 		}
 
 		b += t[i] & OP_AMOUNT;
 	}
 
-	return true;
+	return hits;
+}
+
+static void init_template_for_hits(void)
+{
+	int c, hits;
+
+	for (hits = 0; hits < HIT_MASKS; hits++) {
+		/* last op is our fallback */
+		for (c = 0; c < OPS_MAX - 1; c++) {
+			if ((template_hits(c) & ~hits) == 0)
+				break;
+		}
+		template_for_hits[hits] = c;
+	}
 }
 
 static void get_next_data(struct sw842_param *p)
@@ -438,26 +452,34 @@ static void update_hashtables(struct sw842_param *p)
 
 /* find the next template to use, and add it
  * the p->dataN fields must already be set for the current 8 byte block
+ *
+ * like the hardware, look up all chunks of the block first and then
+ * pick the template from the resulting hit mask in one step
  */
 static int process_next(struct sw842_param *p)
 {
-	int ret, i;
+	u8 hits = 0;
+	int ret;
 
-	p->index8[0] = INDEX_NOT_CHECKED;
-	p->index4[0] = INDEX_NOT_CHECKED;
-	p->index4[1] = INDEX_NOT_CHECKED;
-	p->index2[0] = INDEX_NOT_CHECKED;
-	p->index2[1] = INDEX_NOT_CHECKED;
-	p->index2[2] = INDEX_NOT_CHECKED;
-	p->index2[3] = INDEX_NOT_CHECKED;
-
-	/* check up to OPS_MAX - 1; last op is our fallback */
-	for (i = 0; i < OPS_MAX - 1; i++) {
-		if (check_template(p, i))
-			break;
+	/* a full 8 byte hit always wins, skip the other lookups */
+	if (find_index(p, 8, 0)) {
+		hits = HIT8(0);
+	} else {
+		if (find_index(p, 4, 0))
+			hits |= HIT4(0);
+		if (find_index(p, 4, 1))
+			hits |= HIT4(1);
+		if (find_index(p, 2, 0))
+			hits |= HIT2(0);
+		if (find_index(p, 2, 1))
+			hits |= HIT2(1);
+		if (find_index(p, 2, 2))
+			hits |= HIT2(2);
+		if (find_index(p, 2, 3))
+			hits |= HIT2(3);
 	}
 
-	ret = add_template(p, i);
+	ret = add_template(p, template_for_hits[hits]);
 	if (ret)
 		return ret;
 
@@ -611,6 +633,8 @@ EXPORT_SYMBOL_GPL(sw842_compress);
 
 static int __init sw842_init(void)
 {
+	init_template_for_hits();
+
 	if (sw842_template_counts)
 		sw842_debugfs_create();
 
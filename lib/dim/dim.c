@@ -54,6 +54,39 @@ void dim_park_tired(struct dim *dim)
 }
 EXPORT_SYMBOL(dim_park_tired);
 
+bool dim_lat_decision(struct dim *dim, u8 num_profiles)
+{
+	struct dim_lat *lat = dim->lat;
+	u8 prev_ix = dim->profile_ix;
+	u32 seen = 0, thresh;
+	int b;
+
+	if (lat->nsamples < DIM_LAT_NSAMPLES)
+		return false;
+
+	/* upper bound of the bucket holding the 99th percentile */
+	thresh = lat->nsamples - lat->nsamples / 100;
+	for (b = 0; b < DIM_LAT_BUCKETS - 1; b++) {
+		seen += lat->hist[b];
+		if (seen >= thresh)
+			break;
+	}
+
+	if ((1U << b) > lat->target_us) {
+		if (dim->profile_ix > 0)
+			dim->profile_ix--;
+	} else if ((1U << b) * 2 <= lat->target_us) {
+		if (dim->profile_ix < num_profiles - 1)
+			dim->profile_ix++;
+	}
+
+	memset(lat->hist, 0, sizeof(lat->hist));
+	lat->nsamples = 0;
+
+	return dim->profile_ix != prev_ix;
+}
+EXPORT_SYMBOL(dim_lat_decision);
+
 bool dim_calc_stats(const struct dim_sample *start,
 		    const struct dim_sample *end,
 		    struct dim_stats *curr_stats)
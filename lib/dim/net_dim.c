@@ -4,8 +4,18 @@
  */
 
 #include <linux/dim.h>
+#include <linux/percpu.h>
 #include <linux/rtnetlink.h>
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/dim.h>
+
+/* Values of dim->coord, the per-CPU group a coordinated instance is in */
+enum {
+	NET_DIM_COORD_RX = 1,
+	NET_DIM_COORD_TX,
+};
+
 /*
  * Net DIM profiles:
  *        There are different set of profiles for each CQ period mode.
@@ -175,11 +185,14 @@ void net_dim_setting(struct net_device *dev, struct dim *dim, bool is_tx)
 	if (is_tx) {
 		INIT_WORK(&dim->work, irq_moder->tx_dim_work);
 		dim->mode = READ_ONCE(irq_moder->dim_tx_mode);
-		return;
+	} else {
+		INIT_WORK(&dim->work, irq_moder->rx_dim_work);
+		dim->mode = READ_ONCE(irq_moder->dim_rx_mode);
 	}
 
-	INIT_WORK(&dim->work, irq_moder->rx_dim_work);
-	dim->mode = READ_ONCE(irq_moder->dim_rx_mode);
+	dim->coord = 0;
+	if (irq_moder->profile_flags & DIM_PROFILE_COORD)
+		dim->coord = is_tx ? NET_DIM_COORD_TX : NET_DIM_COORD_RX;
 }
 EXPORT_SYMBOL(net_dim_setting);
 
@@ -347,9 +360,47 @@ static bool net_dim_decision(struct dim_stats *curr_stats, struct dim *dim)
 	return dim->profile_ix != prev_ix;
 }
 
+/*
+ * Queues polled on the same CPU see the same CPU budget, and when each runs
+ * its own DIM they tend to settle on different profiles and keep pushing
+ * each other around. Coordinated instances publish every decision in a
+ * per-CPU slot of their direction and adopt the profile another queue
+ * published there within the last NET_DIM_COORD_WINDOW, so the group moves
+ * as one while any of its members keeps measuring.
+ */
+#define NET_DIM_COORD_WINDOW	(HZ / 10)
+
+struct net_dim_coord {
+	const struct dim *owner;
+	unsigned long stamp;
+	u8 profile_ix;
+};
+
+static DEFINE_PER_CPU(struct net_dim_coord, net_dim_coord[NET_DIM_COORD_TX]);
+
+static bool net_dim_coordinate(struct dim *dim, bool changed)
+{
+	struct net_dim_coord *c = this_cpu_ptr(&net_dim_coord[dim->coord - 1]);
+	u8 prev_ix = dim->profile_ix;
+
+	if (!changed && c->owner != dim &&
+	    time_before(jiffies, c->stamp + NET_DIM_COORD_WINDOW) &&
+	    c->profile_ix < NET_DIM_PARAMS_NUM_PROFILES) {
+		dim->profile_ix = c->profile_ix;
+		return dim->profile_ix != prev_ix;
+	}
+
+	c->owner = dim;
+	c->stamp = jiffies;
+	c->profile_ix = dim->profile_ix;
+
+	return changed;
+}
+
 void net_dim(struct dim *dim, const struct dim_sample *end_sample)
 {
 	struct dim_stats curr_stats;
+	bool changed;
 	u16 nevents;
 
 	switch (dim->state) {
@@ -361,7 +412,13 @@ void net_dim(struct dim *dim, const struct dim_sample *end_sample)
 			break;
 		if (!dim_calc_stats(&dim->start_sample, end_sample, &curr_stats))
 			break;
-		if (net_dim_decision(&curr_stats, dim)) {
+		changed = dim->lat ?
+			  dim_lat_decision(dim, NET_DIM_PARAMS_NUM_PROFILES) :
+			  net_dim_decision(&curr_stats, dim);
+		if (dim->coord)
+			changed = net_dim_coordinate(dim, changed);
+		trace_net_dim_decision(dim, &curr_stats, changed);
+		if (changed) {
 			dim->state = DIM_APPLY_NEW_PROFILE;
 			schedule_work(&dim->work);
 			break;
@@ -90,7 +90,9 @@ void rdma_dim(struct dim *dim, u64 completions)
 			break;
 		if (!dim_calc_stats(&dim->start_sample, curr_sample, &curr_stats))
 			break;
-		if (rdma_dim_decision(&curr_stats, dim)) {
+		if (dim->lat ?
+		    dim_lat_decision(dim, RDMA_DIM_PARAMS_NUM_PROFILES) :
+		    rdma_dim_decision(&curr_stats, dim)) {
 			dim->state = DIM_APPLY_NEW_PROFILE;
 			schedule_work(&dim->work);
 			break;
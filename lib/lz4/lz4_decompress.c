@@ -402,6 +402,14 @@ static FORCE_INLINE int LZ4_decompress_generic(
 			continue;
 		}
 
+		/* runs of 1, 2 or 4 byte patterns: no overlapping reads */
+		if ((offset == 1 || offset == 2 || offset == 4) &&
+		    likely(cpy <= oend - MATCH_SAFEGUARD_DISTANCE)) {
+			LZ4_patternCopy(op, match, cpy, offset);
+			op = cpy;
+			continue;
+		}
+
 		if (unlikely(offset < 8)) {
 			op[0] = match[0];
 			op[1] = match[1];
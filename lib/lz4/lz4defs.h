@@ -183,6 +183,32 @@ static FORCE_INLINE void LZ4_wildCopy(void *dstPtr,
 	} while (d < e);
 }
 
+/*
+ * expand a match with an offset of 1, 2 or 4 bytes from srcPtr,
+ * the repeating pattern is built in a register once so the output
+ * is never read back; can overwrite up to 7 bytes beyond dstEnd
+ */
+static FORCE_INLINE void LZ4_patternCopy(void *dstPtr,
+	const void *srcPtr, void *dstEnd, size_t offset)
+{
+	BYTE *d = (BYTE *)dstPtr;
+	const BYTE *s = (const BYTE *)srcPtr;
+	BYTE *const e = (BYTE *)dstEnd;
+	U64 v;
+
+	if (offset == 1)
+		v = 0x0101010101010101ULL * s[0];
+	else if (offset == 2)
+		v = 0x0001000100010001ULL * LZ4_read16(s);
+	else
+		v = 0x0000000100000001ULL * LZ4_read32(s);
+
+	do {
+		put_unaligned(v, (U64 *)d);
+		d += 8;
+	} while (d < e);
+}
+
 static FORCE_INLINE unsigned int LZ4_NbCommonBytes(register size_t val)
 {
 #if LZ4_LITTLE_ENDIAN
@@ -125,7 +125,10 @@ static FORCE_INLINE int LZ4HC_InsertAndFindBestMatch(
 		if (matchIndex >= dictLimit) {
 			const BYTE * const match = base + matchIndex;
 
-			if (*(match + ml) == *(ip + ml)
+			/* a longer match has to agree at ml - 1 and ml */
+			if ((ml ? LZ4_read16(match + ml - 1)
+				== LZ4_read16(ip + ml - 1)
+				: *match == *ip)
 				&& (LZ4_read32(match) == LZ4_read32(ip))) {
 				size_t const mlt = LZ4_count(ip + MINMATCH,
 					match + MINMATCH, iLimit) + MINMATCH;
@@ -198,8 +201,8 @@ static FORCE_INLINE int LZ4HC_InsertAndGetWiderMatch(
 		if (matchIndex >= dictLimit) {
 			const BYTE *matchPtr = base + matchIndex;
 
-			if (*(iLowLimit + longest)
-				== *(matchPtr - delta + longest)) {
+			if (LZ4_read16(iLowLimit + longest - 1)
+				== LZ4_read16(matchPtr - delta + longest - 1)) {
 				if (LZ4_read32(matchPtr) == LZ4_read32(ip)) {
 					int mlt = MINMATCH + LZ4_count(
 						ip + MINMATCH,
@@ -18,11 +18,15 @@
 #include <linux/lzo.h>
 #include "lzodefs.h"
 
+/* Returned by lzo1x_1_do_compress() when nothing matched within probe_end */
+#define LZO_PROBE_FAILED	((size_t)-1)
+
 static noinline size_t
 lzo1x_1_do_compress(const unsigned char *in, size_t in_len,
 		    unsigned char *out, size_t *out_len,
 		    size_t ti, void *wrkmem, signed char *state_offset,
-		    const unsigned char bitstream_version)
+		    const unsigned char bitstream_version,
+		    const unsigned char *probe_end)
 {
 	const unsigned char *ip;
 	unsigned char *op;
@@ -43,6 +47,12 @@ lzo1x_1_do_compress(const unsigned char *in, size_t in_len,
 		u32 run_length = 0;
 literal:
 		ip += 1 + ((ip - ii) >> 5);
+		/*
+		 * Not a single match or zero run in the probe prefix: the
+		 * input is most likely random, give up rather than hash it all.
+		 */
+		if (unlikely(probe_end && ip >= probe_end) && op == out)
+			return LZO_PROBE_FAILED;
 next:
 		if (unlikely(ip >= ip_end))
 			break;
@@ -301,7 +311,8 @@ lzo1x_1_do_compress(const unsigned char *in, size_t in_len,
 
 static int lzogeneric1x_1_compress(const unsigned char *in, size_t in_len,
 		     unsigned char *out, size_t *out_len,
-		     void *wrkmem, const unsigned char bitstream_version)
+		     void *wrkmem, const unsigned char bitstream_version,
+		     size_t probe_len)
 {
 	const unsigned char *ip = in;
 	unsigned char *op = out;
@@ -331,7 +342,12 @@ static int lzogeneric1x_1_compress(const unsigned char *in, size_t in_len,
 		BUILD_BUG_ON(D_SIZE * sizeof(lzo_dict_t) > LZO1X_1_MEM_COMPRESS);
 		memset(wrkmem, 0, D_SIZE * sizeof(lzo_dict_t));
 		t = lzo1x_1_do_compress(ip, ll, op, out_len, t, wrkmem,
-					&state_offset, bitstream_version);
+					&state_offset, bitstream_version,
+					probe_len ? ip + probe_len : NULL);
+		if (unlikely(t == LZO_PROBE_FAILED))
+			return LZO_E_NOT_COMPRESSIBLE;
+		/* Only the start of the input is probed */
+		probe_len = 0;
 		ip += ll;
 		op += *out_len;
 		l  -= ll;
@@ -380,7 +396,7 @@ int lzo1x_1_compress(const unsigned char *in, size_t in_len,
 		     unsigned char *out, size_t *out_len,
 		     void *wrkmem)
 {
-	return lzogeneric1x_1_compress(in, in_len, out, out_len, wrkmem, 0);
+	return lzogeneric1x_1_compress(in, in_len, out, out_len, wrkmem, 0, 0);
 }
 
 int lzorle1x_1_compress(const unsigned char *in, size_t in_len,
@@ -388,11 +404,20 @@ int lzorle1x_1_compress(const unsigned char *in, size_t in_len,
 		     void *wrkmem)
 {
 	return lzogeneric1x_1_compress(in, in_len, out, out_len,
-				       wrkmem, LZO_VERSION);
+				       wrkmem, LZO_VERSION, 0);
+}
+
+int lzorle1x_1_compress_probe(const unsigned char *in, size_t in_len,
+		     unsigned char *out, size_t *out_len,
+		     void *wrkmem, size_t probe_len)
+{
+	return lzogeneric1x_1_compress(in, in_len, out, out_len,
+				       wrkmem, LZO_VERSION, probe_len);
 }
 
 EXPORT_SYMBOL_GPL(lzo1x_1_compress);
 EXPORT_SYMBOL_GPL(lzorle1x_1_compress);
+EXPORT_SYMBOL_GPL(lzorle1x_1_compress_probe);
 
 MODULE_LICENSE("GPL");
 MODULE_DESCRIPTION("LZO1X-1 Compressor");
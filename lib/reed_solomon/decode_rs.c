@@ -20,6 +20,7 @@
 	int iprim = rs->iprim;
 	uint16_t *alpha_to = rs->alpha_to;
 	uint16_t *index_of = rs->index_of;
+	uint8_t *syn_mul = rs->syn_mul;
 	uint16_t u, q, tmp, num1, num2, den, discr_r, syn_error;
 	int count = 0;
 	int num_corrected;
@@ -61,6 +62,22 @@
 	for (i = 0; i < nroots; i++)
 		syn[i] = (((uint16_t) data[0]) ^ invmsk) & msk;
 
+	if (syn_mul) {
+		/* Horner step syn[i] = syn[i] * root[i] + symbol by lookup */
+		for (j = 1; j < len; j++) {
+			u = (((uint16_t) data[j]) ^ invmsk) & msk;
+			for (i = 0; i < nroots; i++)
+				syn[i] = u ^ syn_mul[i * 256 + syn[i]];
+		}
+
+		for (j = 0; j < nroots; j++) {
+			u = ((uint16_t) par[j]) & msk;
+			for (i = 0; i < nroots; i++)
+				syn[i] = u ^ syn_mul[i * 256 + syn[i]];
+		}
+		goto syn_done;
+	}
+
 	for (j = 1; j < len; j++) {
 		for (i = 0; i < nroots; i++) {
 			if (syn[i] == 0) {
@@ -86,6 +103,7 @@
 			}
 		}
 	}
+ syn_done:
 	s = syn;
 
 	/* Convert syndromes to index form, checking for nonzero condition */
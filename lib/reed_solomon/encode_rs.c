@@ -14,6 +14,7 @@
 	int i, j, pad;
 	int nn = rs->nn;
 	int nroots = rs->nroots;
+	uint8_t *gen_mul = rs->gen_mul;
 	uint16_t *alpha_to = rs->alpha_to;
 	uint16_t *index_of = rs->index_of;
 	uint16_t *genpoly = rs->genpoly;
@@ -25,6 +26,18 @@
 	if (pad < 0 || pad >= nn)
 		return -ERANGE;
 
+	if (gen_mul) {
+		/* Shift and feedback in one pass, par[j] += fb * genpoly[k] */
+		for (i = 0; i < len; i++) {
+			fb = ((((uint16_t) data[i])^invmsk) ^ par[0]) & msk;
+			for (j = 1; j < nroots; j++)
+				par[j - 1] = par[j] ^
+					gen_mul[(nroots - j) * 256 + fb];
+			par[nroots - 1] = gen_mul[fb];
+		}
+		return 0;
+	}
+
 	for (i = 0; i < len; i++) {
 		fb = index_of[((((uint16_t) data[i])^invmsk) & msk) ^ par[0]];
 		/* feedback term is non-zero */
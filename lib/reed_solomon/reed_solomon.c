@@ -54,6 +54,44 @@ static LIST_HEAD(codec_list);
 /* Protection for the list */
 static DEFINE_MUTEX(rslistlock);
 
+/*
+ * For 8-bit symbols a full product table per generator coefficient and per
+ * root costs 256 bytes each and turns the inner loops of the encoder and of
+ * the syndrome computation into a single lookup per symbol and root, with
+ * no log/antilog round trip, no modulo reduction and no zero test. The
+ * tables are optional; without them the generic loops are used.
+ */
+static void codec_init_mul8(struct rs_codec *rs, gfp_t gfp)
+{
+	int i, k, x, root;
+	uint8_t *tab;
+
+	if (rs->mm != 8)
+		return;
+
+	tab = kmalloc_array(2 * rs->nroots, 256, gfp);
+	if (!tab)
+		return;
+
+	rs->gen_mul = tab;
+	rs->syn_mul = tab + rs->nroots * 256;
+
+	for (k = 0; k < rs->nroots; k++, tab += 256) {
+		tab[0] = 0;
+		for (x = 1; x < 256; x++)
+			tab[x] = rs->alpha_to[rs_modnn(rs, rs->index_of[x] +
+						       rs->genpoly[k])];
+	}
+
+	for (i = 0; i < rs->nroots; i++, tab += 256) {
+		root = rs_modnn(rs, (rs->fcr + i) * rs->prim);
+		tab[0] = 0;
+		for (x = 1; x < 256; x++)
+			tab[x] = rs->alpha_to[rs_modnn(rs, rs->index_of[x] +
+						       root)];
+	}
+}
+
 /**
  * codec_init - Initialize a Reed-Solomon codec
  * @symsize:	symbol size, bits (1-8)
@@ -152,6 +190,8 @@ static struct rs_codec *codec_init(int symsize, int gfpoly, int (*gffunc)(int),
 	for (i = 0; i <= nroots; i++)
 		rs->genpoly[i] = rs->index_of[rs->genpoly[i]];
 
+	codec_init_mul8(rs, gfp);
+
 	rs->users = 1;
 	list_add(&rs->list, &codec_list);
 	return rs;
@@ -185,6 +225,7 @@ void free_rs(struct rs_control *rs)
 	cd->users--;
 	if(!cd->users) {
 		list_del(&cd->list);
+		kfree(cd->gen_mul);
 		kfree(cd->alpha_to);
 		kfree(cd->index_of);
 		kfree(cd->genpoly);
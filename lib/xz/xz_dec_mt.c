@@ -0,0 +1,287 @@
+// SPDX-License-Identifier: 0BSD
+
+/*
+ * Block-parallel .xz Stream decoder
+ *
+ * The Index at the end of a .xz Stream stores the Unpadded Size and the
+ * Uncompressed Size of every Block. Since Blocks don't share any state,
+ * knowing where each Block starts in the input and in the output is enough
+ * to decode all of them concurrently, each with its own single-call
+ * decoder writing straight into its slice of the output buffer.
+ */
+
+#include <linux/atomic.h>
+#include <linux/cpumask.h>
+#include <linux/minmax.h>
+#include <linux/workqueue.h>
+
+#include "xz_private.h"
+#include "xz_stream.h"
+
+/* Location of one Block in the input and in the output */
+struct xz_mt_block {
+	size_t in_pos;
+	size_t in_size;
+	size_t out_pos;
+	size_t out_size;
+};
+
+struct xz_mt_worker {
+	struct work_struct work;
+	struct xz_mt *mt;
+	struct xz_dec *s;
+};
+
+struct xz_mt {
+	const uint8_t *in;
+	uint8_t *out;
+	uint8_t check_type;
+	struct xz_mt_block *blocks;
+	size_t count;
+	atomic_long_t next;
+	atomic_t ret;
+};
+
+/* Decode a variable-length integer from in[*pos] without reading past end. */
+static bool mt_vli(const uint8_t *in, size_t *pos, size_t end, vli_type *vli)
+{
+	uint32_t shift = 0;
+	uint8_t byte;
+
+	*vli = 0;
+	do {
+		if (*pos == end || shift >= 7 * VLI_BYTES_MAX)
+			return false;
+
+		byte = in[(*pos)++];
+		*vli |= (vli_type)(byte & 0x7F) << shift;
+
+		/* Don't allow non-minimal encodings. */
+		if (byte == 0 && shift != 0)
+			return false;
+
+		shift += 7;
+	} while (byte & 0x80);
+
+	return true;
+}
+
+/*
+ * Parse the Stream Header, Stream Footer, and Index of the Stream in
+ * b->in[b->in_pos..in_end] and fill mt->blocks. XZ_OPTIONS_ERROR means
+ * the Stream is valid as far as we can tell but not worth or not possible
+ * to decode in parallel.
+ */
+static enum xz_ret mt_parse(struct xz_mt *mt, const struct xz_buf *b,
+			    size_t in_end)
+{
+	const uint8_t *in = b->in + b->in_pos;
+	size_t size = in_end - b->in_pos;
+	const uint8_t *footer;
+	size_t index_pos, index_end, pos, in_pos, out_pos;
+	vli_type backward_size, count, unpadded, uncompressed;
+	size_t i;
+
+	if (size < 2 * STREAM_HEADER_SIZE)
+		return XZ_OPTIONS_ERROR;
+
+	if (!memeq(in, HEADER_MAGIC, HEADER_MAGIC_SIZE))
+		return XZ_FORMAT_ERROR;
+
+	if (xz_crc32(in + HEADER_MAGIC_SIZE, 2, 0)
+			!= get_unaligned_le32(in + HEADER_MAGIC_SIZE + 2))
+		return XZ_DATA_ERROR;
+
+	/* Only the checks verified by the sequential decoder are allowed. */
+	if (in[HEADER_MAGIC_SIZE] != 0
+			|| in[HEADER_MAGIC_SIZE + 1] > XZ_CHECK_CRC32)
+		return XZ_OPTIONS_ERROR;
+
+	mt->check_type = in[HEADER_MAGIC_SIZE + 1];
+
+	footer = in + size - STREAM_HEADER_SIZE;
+	if (!memeq(footer + 10, FOOTER_MAGIC, FOOTER_MAGIC_SIZE))
+		return XZ_OPTIONS_ERROR;
+
+	if (xz_crc32(footer + 4, 6, 0) != get_unaligned_le32(footer))
+		return XZ_DATA_ERROR;
+
+	/*
+	 * With several Streams the footer belongs to the last one, which may
+	 * use a different check. Leave it to the sequential decoder.
+	 */
+	if (footer[8] != 0 || footer[9] != mt->check_type)
+		return XZ_OPTIONS_ERROR;
+
+	/* Backward Size, which includes the Index CRC32 */
+	index_end = size - STREAM_HEADER_SIZE;
+	backward_size = ((vli_type)get_unaligned_le32(footer + 4) + 1) * 4;
+	if (backward_size > index_end - STREAM_HEADER_SIZE)
+		return XZ_DATA_ERROR;
+
+	index_pos = index_end - (size_t)backward_size;
+	if (in[index_pos] != 0 || xz_crc32(in + index_pos,
+			index_end - index_pos - 4, 0)
+				!= get_unaligned_le32(in + index_end - 4))
+		return XZ_DATA_ERROR;
+
+	pos = index_pos + 1;
+	if (!mt_vli(in, &pos, index_end - 4, &count))
+		return XZ_DATA_ERROR;
+
+	if (count < 2)
+		return XZ_OPTIONS_ERROR;
+
+	if (count > (index_end - index_pos) / 2)
+		return XZ_DATA_ERROR;
+
+	mt->blocks = kvmalloc_array(count, sizeof(*mt->blocks), GFP_KERNEL);
+	if (mt->blocks == NULL)
+		return XZ_MEM_ERROR;
+
+	mt->count = count;
+	in_pos = b->in_pos + STREAM_HEADER_SIZE;
+	out_pos = b->out_pos;
+
+	for (i = 0; i < count; ++i) {
+		if (!mt_vli(in, &pos, index_end - 4, &unpadded)
+				|| !mt_vli(in, &pos, index_end - 4,
+					   &uncompressed))
+			return XZ_DATA_ERROR;
+
+		unpadded = (unpadded + 3) & ~(vli_type)3;
+		if (unpadded == 0 || unpadded > b->in_pos + index_pos - in_pos)
+			return XZ_DATA_ERROR;
+
+		if (uncompressed > b->out_size - out_pos)
+			return XZ_BUF_ERROR;
+
+		mt->blocks[i].in_pos = in_pos;
+		mt->blocks[i].in_size = unpadded;
+		mt->blocks[i].out_pos = out_pos;
+		mt->blocks[i].out_size = uncompressed;
+
+		in_pos += unpadded;
+		out_pos += uncompressed;
+	}
+
+	/* Only Index Padding may remain. */
+	while (pos & 3) {
+		if (pos == index_end - 4 || in[pos++] != 0)
+			return XZ_DATA_ERROR;
+	}
+
+	if (pos != index_end - 4)
+		return XZ_DATA_ERROR;
+
+	/*
+	 * If the Blocks don't fill the gap up to the Index, the input most
+	 * likely holds more than one Stream and this Index only describes the
+	 * last one. Let the sequential decoder handle it.
+	 */
+	if (in_pos != b->in_pos + index_pos)
+		return XZ_OPTIONS_ERROR;
+
+	return XZ_OK;
+}
+
+static void mt_work(struct work_struct *work)
+{
+	struct xz_mt_worker *w = container_of(work, struct xz_mt_worker, work);
+	struct xz_mt *mt = w->mt;
+	long i;
+
+	while ((i = atomic_long_inc_return(&mt->next) - 1) < (long)mt->count) {
+		const struct xz_mt_block *blk = &mt->blocks[i];
+		struct xz_buf b = {
+			.in = mt->in,
+			.in_pos = blk->in_pos,
+			.in_size = blk->in_pos + blk->in_size,
+			.out = mt->out + blk->out_pos,
+			.out_pos = 0,
+			.out_size = blk->out_size,
+		};
+		enum xz_ret ret;
+
+		if (atomic_read(&mt->ret) != XZ_STREAM_END)
+			return;
+
+		ret = xz_dec_block_run(w->s, &b, mt->check_type);
+		if (ret == XZ_STREAM_END && b.out_pos != blk->out_size)
+			ret = XZ_DATA_ERROR;
+
+		if (ret != XZ_STREAM_END)
+			atomic_cmpxchg(&mt->ret, XZ_STREAM_END, ret);
+	}
+}
+
+enum xz_ret xz_dec_mt_run(struct xz_buf *b, unsigned int nr_threads)
+{
+	struct xz_mt_worker *workers;
+	struct xz_mt mt = {
+		.in = b->in,
+		.out = b->out,
+	};
+	size_t in_end = b->in_size;
+	enum xz_ret ret;
+	unsigned int i;
+
+	/* Stream Padding after the Stream Footer */
+	while (in_end - b->in_pos >= 4 && get_unaligned_le32(b->in + in_end - 4) == 0)
+		in_end -= 4;
+
+	ret = mt_parse(&mt, b, in_end);
+	if (ret != XZ_OK)
+		goto out;
+
+	if (nr_threads == 0)
+		nr_threads = num_online_cpus();
+
+	nr_threads = min_t(size_t, nr_threads, mt.count);
+	if (nr_threads < 2) {
+		ret = XZ_OPTIONS_ERROR;
+		goto out;
+	}
+
+	workers = kcalloc(nr_threads, sizeof(*workers), GFP_KERNEL);
+	if (workers == NULL) {
+		ret = XZ_MEM_ERROR;
+		goto out;
+	}
+
+	for (i = 0; i < nr_threads; ++i) {
+		workers[i].s = xz_dec_init(XZ_SINGLE, 0);
+		if (workers[i].s == NULL) {
+			ret = XZ_MEM_ERROR;
+			goto out_workers;
+		}
+
+		workers[i].mt = &mt;
+		INIT_WORK(&workers[i].work, mt_work);
+	}
+
+	atomic_long_set(&mt.next, 0);
+	atomic_set(&mt.ret, XZ_STREAM_END);
+
+	for (i = 0; i < nr_threads; ++i)
+		queue_work(system_unbound_wq, &workers[i].work);
+
+	for (i = 0; i < nr_threads; ++i)
+		flush_work(&workers[i].work);
+
+	ret = atomic_read(&mt.ret);
+	if (ret == XZ_STREAM_END) {
+		const struct xz_mt_block *last = &mt.blocks[mt.count - 1];
+
+		b->in_pos = b->in_size;
+		b->out_pos = last->out_pos + last->out_size;
+	}
+
+out_workers:
+	for (i = 0; i < nr_threads; ++i)
+		xz_dec_end(workers[i].s);
+	kfree(workers);
+out:
+	kvfree(mt.blocks);
+	return ret;
+}
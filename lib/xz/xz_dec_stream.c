@@ -782,6 +782,37 @@ enum xz_ret xz_dec_run(struct xz_dec *s, struct xz_buf *b)
 	return ret;
 }
 
+#ifdef XZ_DEC_MT
+enum xz_ret xz_dec_block_run(struct xz_dec *s, struct xz_buf *b,
+			     uint8_t check_type)
+{
+	size_t in_start = b->in_pos;
+	size_t out_start = b->out_pos;
+	enum xz_ret ret;
+
+	xz_dec_reset(s);
+	s->check_type = check_type;
+	s->sequence = SEQ_BLOCK_START;
+
+	ret = dec_main(s, b);
+
+	/*
+	 * Once the Block has been decoded, dec_main() waits for the first
+	 * byte of the next Block or the Index, which the caller didn't give.
+	 */
+	if (ret == XZ_OK && s->sequence == SEQ_BLOCK_START
+			&& s->block.count == 1 && b->in_pos == b->in_size)
+		return XZ_STREAM_END;
+
+	if (ret == XZ_OK || ret == XZ_STREAM_END)
+		ret = XZ_DATA_ERROR;
+
+	b->in_pos = in_start;
+	b->out_pos = out_start;
+	return ret;
+}
+#endif
+
 struct xz_dec *xz_dec_init(enum xz_mode mode, uint32_t dict_max)
 {
 	struct xz_dec *s = kmalloc(sizeof(*s), GFP_KERNEL);
@@ -45,6 +45,9 @@
 #		ifdef CONFIG_XZ_DEC_MICROLZMA
 #			define XZ_DEC_MICROLZMA
 #		endif
+#		ifdef CONFIG_XZ_DEC_MT
+#			define XZ_DEC_MT
+#		endif
 #		define memeq(a, b, size) (memcmp(a, b, size) == 0)
 #		define memzero(buf, size) memset(buf, 0, size)
 #	endif
@@ -158,4 +161,15 @@ enum xz_ret xz_dec_bcj_run(struct xz_dec_bcj *s, struct xz_dec_lzma2 *lzma2,
 #define xz_dec_bcj_end(s) kfree(s)
 #endif
 
+#ifdef XZ_DEC_MT
+/*
+ * Decode exactly one Block, from its Block Header to its Check field, from
+ * b->in to b->out. s must have been allocated in XZ_SINGLE mode. The Block
+ * has to end at b->in_size. Returns XZ_STREAM_END on success; on failure
+ * b->in_pos and b->out_pos are left unchanged.
+ */
+enum xz_ret xz_dec_block_run(struct xz_dec *s, struct xz_buf *b,
+			     uint8_t check_type);
+#endif
+
 #endif
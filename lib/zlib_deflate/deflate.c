@@ -57,6 +57,7 @@
 #  include "../zlib_dfltcc/dfltcc_deflate.h"
 #else
 #define DEFLATE_RESET_HOOK(strm) do {} while (0)
+#define DEFLATE_MAY_SLEEP_HOOK(strm, may_sleep) do {} while (0)
 #define DEFLATE_HOOK(strm, flush, bstate) 0
 #define DEFLATE_NEED_CHECKSUM(strm) 1
 #define DEFLATE_DFLTCC_ENABLED() 0
@@ -311,6 +312,19 @@ int zlib_deflateReset(
     return Z_OK;
 }
 
+/* ========================================================================= */
+int zlib_deflate_set_may_sleep(
+	z_streamp strm,
+	int may_sleep
+)
+{
+    if (strm == NULL || strm->state == NULL)
+        return Z_STREAM_ERROR;
+
+    DEFLATE_MAY_SLEEP_HOOK(strm, may_sleep);
+    return Z_OK;
+}
+
 /* =========================================================================
  * Put a short in the pending buffer. The 16-bit value is put in MSB order.
  * IN assertion: the stream state is correct and there is enough room in
@@ -35,6 +35,7 @@ void dfltcc_reset_state(struct dfltcc_state *dfltcc_state) {
     memset(&dfltcc_state->param, 0, sizeof(dfltcc_state->param));
     dfltcc_state->param.nt = 1;
     dfltcc_state->param.ribm = DFLTCC_RIBM;
+    dfltcc_state->may_sleep = 0;
 }
 
 MODULE_LICENSE("GPL");
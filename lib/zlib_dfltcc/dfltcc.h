@@ -95,6 +95,7 @@ struct dfltcc_state {
     struct dfltcc_param_v0 param;      /* Parameter block */
     struct dfltcc_qaf_param af;        /* Available functions */
     char msg[64];                      /* Buffer for strm->msg */
+    int may_sleep;                     /* Reschedule on partial completion */
 };
 
 /*
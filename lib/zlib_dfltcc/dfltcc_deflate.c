@@ -56,6 +56,13 @@ void dfltcc_reset_deflate_state(z_streamp strm) {
 }
 EXPORT_SYMBOL(dfltcc_reset_deflate_state);
 
+void dfltcc_deflate_set_may_sleep(z_streamp strm, int may_sleep) {
+    deflate_state *state = (deflate_state *)strm->state;
+
+    GET_DFLTCC_STATE(state)->may_sleep = may_sleep;
+}
+EXPORT_SYMBOL(dfltcc_deflate_set_may_sleep);
+
 static void dfltcc_gdht(
     z_streamp strm
 )
@@ -260,6 +267,8 @@ int dfltcc_deflate(
              * one handle more data.
              */
             break;
+        if (cc == DFLTCC_CC_AGAIN)
+            dfltcc_yield(&dfltcc_state->common);
     } while (cc == DFLTCC_CC_AGAIN);
 
     /* Translate parameter block to stream */
@@ -306,8 +315,11 @@ int dfltcc_deflate(
         param->bcf = 1;
         *result = need_more;
     }
-    if (strm->avail_in != 0 && strm->avail_out != 0)
+    if (strm->avail_in != 0 && strm->avail_out != 0) {
+        /* Each pass handles at most block_size bytes of input */
+        dfltcc_yield(&dfltcc_state->common);
         goto again; /* deflate() must use all input or all output */
+    }
     return 1;
 }
 EXPORT_SYMBOL(dfltcc_deflate);
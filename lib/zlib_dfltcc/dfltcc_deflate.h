@@ -10,12 +10,16 @@ int dfltcc_deflate(z_streamp strm,
                    int flush,
                    block_state *result);
 void dfltcc_reset_deflate_state(z_streamp strm);
+void dfltcc_deflate_set_may_sleep(z_streamp strm, int may_sleep);
 
 #define DEFLATE_RESET_HOOK(strm) \
     dfltcc_reset_deflate_state((strm))
 
 #define DEFLATE_HOOK dfltcc_deflate
 
+#define DEFLATE_MAY_SLEEP_HOOK(strm, may_sleep) \
+    dfltcc_deflate_set_may_sleep((strm), (may_sleep))
+
 #define DEFLATE_NEED_CHECKSUM(strm) (!dfltcc_can_deflate((strm)))
 
 #endif /* DFLTCC_DEFLATE_H */
@@ -36,6 +36,13 @@ void dfltcc_reset_inflate_state(z_streamp strm) {
 }
 EXPORT_SYMBOL(dfltcc_reset_inflate_state);
 
+void dfltcc_inflate_set_may_sleep(z_streamp strm, int may_sleep) {
+    struct inflate_state *state = (struct inflate_state *)strm->state;
+
+    GET_DFLTCC_STATE(state)->may_sleep = may_sleep;
+}
+EXPORT_SYMBOL(dfltcc_inflate_set_may_sleep);
+
 static int dfltcc_was_inflate_used(
     z_streamp strm
 )
@@ -134,6 +141,8 @@ dfltcc_inflate_action dfltcc_inflate(
     /* Inflate */
     do {
         cc = dfltcc_xpnd(strm);
+        if (cc == DFLTCC_CC_AGAIN)
+            dfltcc_yield(dfltcc_state);
     } while (cc == DFLTCC_CC_AGAIN);
 
     /* Translate parameter block to stream */
@@ -6,6 +6,7 @@
 
 /* External functions */
 void dfltcc_reset_inflate_state(z_streamp strm);
+void dfltcc_inflate_set_may_sleep(z_streamp strm, int may_sleep);
 int dfltcc_can_inflate(z_streamp strm);
 typedef enum {
     DFLTCC_INFLATE_CONTINUE,
@@ -17,6 +18,9 @@ dfltcc_inflate_action dfltcc_inflate(z_streamp strm,
 #define INFLATE_RESET_HOOK(strm) \
     dfltcc_reset_inflate_state((strm))
 
+#define INFLATE_MAY_SLEEP_HOOK(strm, may_sleep) \
+    dfltcc_inflate_set_may_sleep((strm), (may_sleep))
+
 #define INFLATE_TYPEDO_HOOK(strm, flush) \
     if (dfltcc_can_inflate((strm))) { \
         dfltcc_inflate_action action; \
@@ -4,6 +4,7 @@
 
 #include "dfltcc.h"
 #include <linux/kmsan-checks.h>
+#include <linux/sched.h>
 #include <linux/zutil.h>
 
 /*
@@ -126,6 +127,22 @@ static inline int dfltcc_are_params_ok(
         (strategy == Z_DEFAULT_STRATEGY);
 }
 
+/*
+ * DFLTCC ends with DFLTCC_CC_AGAIN after a CPU-determined amount of data has
+ * been processed. The conversion is synchronous, so the only way to keep a
+ * large buffer from monopolizing the CPU is to give it up at that point,
+ * which is only done for streams whose owner said it may sleep.
+ */
+static inline void dfltcc_yield(
+    const struct dfltcc_state *dfltcc_state
+)
+{
+#ifndef STATIC
+    if (dfltcc_state->may_sleep)
+        cond_resched();
+#endif
+}
+
 char *oesc_msg(char *buf, int oesc);
 
 #endif /* DFLTCC_UTIL_H */
@@ -3,6 +3,7 @@
  * For conditions of distribution and use, see copyright notice in zlib.h
  */
 
+#include <linux/unaligned.h>
 #include <linux/zutil.h>
 #include "inftrees.h"
 #include "inflate.h"
@@ -10,6 +11,14 @@
 
 #ifndef ASMINF
 
+/*
+ * With a 64-bit hold and cheap unaligned loads, refill the bit buffer with
+ * one load per code pair and copy long matches a word at a time.
+ */
+#if BITS_PER_LONG == 64 && defined(CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS)
+#define INFLATE_FAST_WIDE
+#endif
+
 union uu {
 	unsigned short us;
 	unsigned char b[2];
@@ -91,11 +100,17 @@ void inflate_fast(z_streamp strm, unsigned start)
     unsigned len;               /* match length, unused bytes */
     unsigned dist;              /* match distance */
     unsigned char *from;        /* where to copy match from */
+#ifdef INFLATE_FAST_WIDE
+    const unsigned char *in_end; /* end of the input, for wide loads */
+#endif
 
     /* copy state to local variables */
     state = (struct inflate_state *)strm->state;
     in = strm->next_in;
     last = in + (strm->avail_in - 5);
+#ifdef INFLATE_FAST_WIDE
+    in_end = in + strm->avail_in;
+#endif
     out = strm->next_out;
     beg = out - (start - strm->avail_out);
     end = out + (strm->avail_out - 257);
@@ -116,10 +131,23 @@ void inflate_fast(z_streamp strm, unsigned start)
     /* decode literals and length/distances until end-of-block or not enough
        input data or output space */
     do {
+#ifdef INFLATE_FAST_WIDE
+        /*
+         * Top hold up to 56..63 bits, enough for a whole length/distance
+         * pair (48 bits), so none of the refills below trigger. The part
+         * of a byte loaded above bits is the same data the next load puts
+         * there, which is why every refill in here ORs instead of adding.
+         */
+        if (likely(in_end - in >= 8)) {
+            hold |= (unsigned long)get_unaligned_le64(in) << bits;
+            in += (63 - bits) >> 3;
+            bits |= 56;
+        }
+#endif
         if (bits < 15) {
-            hold += (unsigned long)(*in++) << bits;
+            hold |= (unsigned long)(*in++) << bits;
             bits += 8;
-            hold += (unsigned long)(*in++) << bits;
+            hold |= (unsigned long)(*in++) << bits;
             bits += 8;
         }
         this = lcode[hold & lmask];
@@ -136,7 +164,7 @@ void inflate_fast(z_streamp strm, unsigned start)
             op &= 15;                           /* number of extra bits */
             if (op) {
                 if (bits < op) {
-                    hold += (unsigned long)(*in++) << bits;
+                    hold |= (unsigned long)(*in++) << bits;
                     bits += 8;
                 }
                 len += (unsigned)hold & ((1U << op) - 1);
@@ -144,9 +172,9 @@ void inflate_fast(z_streamp strm, unsigned start)
                 bits -= op;
             }
             if (bits < 15) {
-                hold += (unsigned long)(*in++) << bits;
+                hold |= (unsigned long)(*in++) << bits;
                 bits += 8;
-                hold += (unsigned long)(*in++) << bits;
+                hold |= (unsigned long)(*in++) << bits;
                 bits += 8;
             }
             this = dcode[hold & dmask];
@@ -159,10 +187,10 @@ void inflate_fast(z_streamp strm, unsigned start)
                 dist = (unsigned)(this.val);
                 op &= 15;                       /* number of extra bits */
                 if (bits < op) {
-                    hold += (unsigned long)(*in++) << bits;
+                    hold |= (unsigned long)(*in++) << bits;
                     bits += 8;
                     if (bits < op) {
-                        hold += (unsigned long)(*in++) << bits;
+                        hold |= (unsigned long)(*in++) << bits;
                         bits += 8;
                     }
                 }
@@ -236,6 +264,23 @@ void inflate_fast(z_streamp strm, unsigned start)
                             *out++ = *from++;
                     }
                 }
+#ifdef INFLATE_FAST_WIDE
+                else if (dist >= 8) {
+                    from = out - dist;          /* copy direct from output */
+                    /* words never overlap their own source at this distance */
+                    while (len >= 8) {
+                        put_unaligned(get_unaligned((const u64 *)from),
+                                      (u64 *)out);
+                        out += 8;
+                        from += 8;
+                        len -= 8;
+                    }
+                    while (len) {
+                        *out++ = *from++;
+                        len--;
+                    }
+                }
+#endif
                 else {
 		    unsigned short *sout;
 		    unsigned long loops;
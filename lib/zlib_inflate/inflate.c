@@ -20,6 +20,7 @@
 #  include "../zlib_dfltcc/dfltcc_inflate.h"
 #else
 #define INFLATE_RESET_HOOK(strm) do {} while (0)
+#define INFLATE_MAY_SLEEP_HOOK(strm, may_sleep) do {} while (0)
 #define INFLATE_TYPEDO_HOOK(strm, flush) do {} while (0)
 #define INFLATE_NEED_UPDATEWINDOW(strm) 1
 #define INFLATE_NEED_CHECKSUM(strm) 1
@@ -56,6 +57,14 @@ int zlib_inflateReset(z_streamp strm)
     return Z_OK;
 }
 
+int zlib_inflate_set_may_sleep(z_streamp strm, int may_sleep)
+{
+    if (strm == NULL || strm->state == NULL) return Z_STREAM_ERROR;
+
+    INFLATE_MAY_SLEEP_HOOK(strm, may_sleep);
+    return Z_OK;
+}
+
 int zlib_inflateInit2(z_streamp strm, int windowBits)
 {
     struct inflate_state *state;
@@ -9,9 +9,14 @@
  * You may select, at your option, one of the above-listed licenses.
  */
 
+#include <linux/completion.h>
+#include <linux/cpumask.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
+#include <linux/overflow.h>
+#include <linux/slab.h>
 #include <linux/string.h>
+#include <linux/workqueue.h>
 #include <linux/zstd.h>
 
 #include "common/zstd_deps.h"
@@ -209,5 +214,221 @@ size_t zstd_end_stream(zstd_cstream *cstream, zstd_out_buffer *output)
 }
 EXPORT_SYMBOL(zstd_end_stream);
 
+/* ======   Multi-threaded Compression   ====== */
+
+#define ZSTD_MT_DEFAULT_JOB_SIZE (4U << 20)
+
+struct zstd_mt_job {
+	struct work_struct work;
+	struct zstd_mt_ctx *mt;
+	zstd_cctx *cctx;
+	const void *src;
+	size_t src_size;
+	void *dst;
+	size_t dst_capacity;
+	size_t ret;
+};
+
+struct zstd_mt_ctx {
+	zstd_parameters parameters;
+	unsigned int ldm_window_log;
+	size_t job_size;
+	atomic_t pending;
+	struct completion done;
+	unsigned int nr_jobs;
+	struct zstd_mt_job jobs[] __counted_by(nr_jobs);
+};
+
+static void *zstd_mt_kvmalloc(void *opaque, size_t size)
+{
+	return kvmalloc(size, GFP_KERNEL);
+}
+
+static void zstd_mt_kvfree(void *opaque, void *address)
+{
+	kvfree(address);
+}
+
+/* Job contexts keep their workspace between frames, so they form the pool */
+static const zstd_custom_mem zstd_mt_mem = {
+	.customAlloc = zstd_mt_kvmalloc,
+	.customFree = zstd_mt_kvfree,
+};
+
+static size_t zstd_mt_job_init(struct zstd_mt_ctx *mt, zstd_cctx *cctx,
+	size_t src_size)
+{
+	ZSTD_FORWARD_IF_ERR(zstd_cctx_init(cctx, &mt->parameters, src_size));
+	if (!mt->ldm_window_log)
+		return 0;
+	ZSTD_FORWARD_IF_ERR(ZSTD_CCtx_setParameter(
+		cctx, ZSTD_c_enableLongDistanceMatching, 1));
+	ZSTD_FORWARD_IF_ERR(ZSTD_CCtx_setParameter(
+		cctx, ZSTD_c_windowLog, mt->ldm_window_log));
+	return 0;
+}
+
+static void zstd_mt_job_fn(struct work_struct *work)
+{
+	struct zstd_mt_job *job = container_of(work, struct zstd_mt_job, work);
+	struct zstd_mt_ctx *mt = job->mt;
+
+	job->ret = zstd_mt_job_init(mt, job->cctx, job->src_size);
+	if (!ZSTD_isError(job->ret))
+		job->ret = ZSTD_compress2(job->cctx, job->dst,
+			job->dst_capacity, job->src, job->src_size);
+
+	if (atomic_dec_and_test(&mt->pending))
+		complete(&mt->done);
+}
+
+zstd_mt_ctx *zstd_mt_create(const zstd_parameters *parameters,
+	unsigned int nr_workers, size_t job_size, unsigned int ldm_window_log)
+{
+	zstd_mt_ctx *mt;
+	unsigned int i;
+
+	if (ldm_window_log && (ldm_window_log < ZSTD_WINDOWLOG_MIN ||
+			       ldm_window_log > ZSTD_WINDOWLOG_MAX))
+		return NULL;
+
+	if (!nr_workers)
+		nr_workers = num_online_cpus();
+	if (!job_size)
+		job_size = ZSTD_MT_DEFAULT_JOB_SIZE;
+
+	mt = kvzalloc(struct_size(mt, jobs, nr_workers), GFP_KERNEL);
+	if (!mt)
+		return NULL;
+
+	mt->parameters = *parameters;
+	mt->ldm_window_log = ldm_window_log;
+	mt->job_size = job_size;
+	mt->nr_jobs = nr_workers;
+	init_completion(&mt->done);
+
+	for (i = 0; i < nr_workers; i++) {
+		struct zstd_mt_job *job = &mt->jobs[i];
+
+		INIT_WORK(&job->work, zstd_mt_job_fn);
+		job->mt = mt;
+		job->cctx = ZSTD_createCCtx_advanced(zstd_mt_mem);
+		if (!job->cctx) {
+			zstd_mt_destroy(mt);
+			return NULL;
+		}
+	}
+
+	return mt;
+}
+EXPORT_SYMBOL(zstd_mt_create);
+
+void zstd_mt_destroy(zstd_mt_ctx *mt)
+{
+	unsigned int i;
+
+	if (!mt)
+		return;
+
+	for (i = 0; i < mt->nr_jobs; i++)
+		ZSTD_freeCCtx(mt->jobs[i].cctx);
+	kvfree(mt);
+}
+EXPORT_SYMBOL(zstd_mt_destroy);
+
+size_t zstd_mt_compress_bound(const zstd_mt_ctx *mt, size_t src_size)
+{
+	size_t rem = src_size % mt->job_size;
+	size_t bound;
+
+	bound = (src_size / mt->job_size) * ZSTD_compressBound(mt->job_size);
+	if (rem)
+		bound += ZSTD_compressBound(rem);
+	return bound;
+}
+EXPORT_SYMBOL(zstd_mt_compress_bound);
+
+size_t zstd_mt_compress_stream(zstd_mt_ctx *mt, zstd_out_buffer *output,
+	zstd_in_buffer *input, bool end)
+{
+	while (input->pos < input->size) {
+		const char *src = (const char *)input->src + input->pos;
+		size_t src_left = input->size - input->pos;
+		char *dst = (char *)output->dst + output->pos;
+		size_t dst_left = output->size - output->pos;
+		size_t consumed = 0, written = 0;
+		unsigned int i, n;
+
+		/* Hand out jobs until the input or the output runs out */
+		for (n = 0; n < mt->nr_jobs && consumed < src_left; n++) {
+			struct zstd_mt_job *job = &mt->jobs[n];
+			size_t len = min(mt->job_size, src_left - consumed);
+			size_t bound = ZSTD_compressBound(len);
+
+			if (len < mt->job_size && !end)
+				break;
+			if (bound > dst_left)
+				break;
+
+			job->src = src + consumed;
+			job->src_size = len;
+			job->dst = dst;
+			job->dst_capacity = bound;
+			consumed += len;
+			dst += bound;
+			dst_left -= bound;
+		}
+
+		if (!n)
+			break;
+
+		reinit_completion(&mt->done);
+		atomic_set(&mt->pending, n);
+		for (i = 0; i < n; i++)
+			queue_work(system_unbound_wq, &mt->jobs[i].work);
+		wait_for_completion(&mt->done);
+
+		/* Stitch the frames together behind each other */
+		dst = (char *)output->dst + output->pos;
+		for (i = 0; i < n; i++) {
+			struct zstd_mt_job *job = &mt->jobs[i];
+
+			if (ZSTD_isError(job->ret))
+				return job->ret;
+			memmove(dst + written, job->dst, job->ret);
+			written += job->ret;
+		}
+
+		input->pos += consumed;
+		output->pos += written;
+	}
+
+	return input->size - input->pos;
+}
+EXPORT_SYMBOL(zstd_mt_compress_stream);
+
+size_t zstd_mt_compress(zstd_mt_ctx *mt, void *dst, size_t dst_capacity,
+	const void *src, size_t src_size)
+{
+	zstd_out_buffer output = { .dst = dst, .size = dst_capacity };
+	zstd_in_buffer input = { .src = src, .size = src_size };
+	size_t ret;
+
+	/* An empty input still makes one (empty) frame */
+	if (!src_size) {
+		ZSTD_FORWARD_IF_ERR(zstd_mt_job_init(mt, mt->jobs[0].cctx, 0));
+		return ZSTD_compress2(mt->jobs[0].cctx, dst, dst_capacity,
+			src, src_size);
+	}
+
+	ret = zstd_mt_compress_stream(mt, &output, &input, true);
+	if (ZSTD_isError(ret))
+		return ret;
+	if (ret)
+		return ERROR(dstSize_tooSmall);
+	return output.pos;
+}
+EXPORT_SYMBOL(zstd_mt_compress);
+
 MODULE_LICENSE("Dual BSD/GPL");
 MODULE_DESCRIPTION("Zstd Compressor");
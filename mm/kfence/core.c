@@ -11,6 +11,7 @@
 #include <linux/bug.h>
 #include <linux/debugfs.h>
 #include <linux/hash.h>
+#include <linux/hashtable.h>
 #include <linux/irq_work.h>
 #include <linux/jhash.h>
 #include <linux/kcsan-checks.h>
@@ -21,6 +22,7 @@
 #include <linux/log2.h>
 #include <linux/memblock.h>
 #include <linux/moduleparam.h>
+#include <linux/mutex.h>
 #include <linux/notifier.h>
 #include <linux/panic_notifier.h>
 #include <linux/random.h>
@@ -30,6 +32,8 @@
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/string.h>
+#include <linux/stringhash.h>
+#include <linux/uaccess.h>
 
 #include <asm/kfence.h>
 
@@ -111,6 +115,37 @@ module_param_named(deferrable, kfence_deferrable, bool, 0444);
 static bool kfence_check_on_panic __read_mostly;
 module_param_named(check_on_panic, kfence_check_on_panic, bool, 0444);
 
+static void kfence_resize_pool(unsigned long num);
+
+/*
+ * Number of pool objects in use. The pool is always reserved with
+ * CONFIG_KFENCE_NUM_OBJECTS objects, as is_kfence_address() relies on its size
+ * being a constant, but only the first kfence_pool_objects are handed out.
+ * This allows to start with a part of the pool and grow it at runtime.
+ */
+static unsigned long kfence_pool_objects __read_mostly = CONFIG_KFENCE_NUM_OBJECTS;
+
+static int param_set_pool_objects(const char *val, const struct kernel_param *kp)
+{
+	unsigned long num;
+	int ret = kstrtoul(val, 0, &num);
+
+	if (ret < 0)
+		return ret;
+
+	if (!num || num > CONFIG_KFENCE_NUM_OBJECTS)
+		return -EINVAL;
+
+	kfence_resize_pool(num);
+	return 0;
+}
+
+static const struct kernel_param_ops pool_objects_param_ops = {
+	.set = param_set_pool_objects,
+	.get = param_get_ulong,
+};
+module_param_cb(pool_objects, &pool_objects_param_ops, &kfence_pool_objects, 0600);
+
 /* The pool of pages used for guard pages and objects. */
 char *__kfence_pool __read_mostly;
 EXPORT_SYMBOL(__kfence_pool); /* Export for test modules. */
@@ -132,7 +167,29 @@ static struct kfence_metadata *kfence_metadata_init __read_mostly;
 
 /* Freelist with available objects. */
 static struct list_head kfence_freelist = LIST_HEAD_INIT(kfence_freelist);
-static DEFINE_RAW_SPINLOCK(kfence_freelist_lock); /* Lock protecting freelist. */
+/* Free objects beyond kfence_pool_objects, not available for allocation. */
+static struct list_head kfence_parked = LIST_HEAD_INIT(kfence_parked);
+static DEFINE_RAW_SPINLOCK(kfence_freelist_lock); /* Lock protecting freelists. */
+
+/*
+ * Per-CPU caches of free objects, refilled in batches from the head of
+ * kfence_freelist, i.e. with the objects that have been free the longest, so
+ * that the order in which objects are reused barely changes. Allocations then
+ * rarely take kfence_freelist_lock. Freed objects still go to the tail of
+ * kfence_freelist. Lock order: pcp->lock, kfence_freelist_lock.
+ */
+#define KFENCE_PCP_BATCH	4
+
+struct kfence_pcp_freelist {
+	raw_spinlock_t lock;
+	unsigned int next;	/* Index of the next object to hand out. */
+	unsigned int nr;	/* Number of objects in @objs. */
+	struct kfence_metadata *objs[KFENCE_PCP_BATCH];
+};
+
+static DEFINE_PER_CPU(struct kfence_pcp_freelist, kfence_pcp_freelist) = {
+	.lock = __RAW_SPIN_LOCK_UNLOCKED(kfence_pcp_freelist.lock),
+};
 
 /*
  * The static key to set up a KFENCE allocation; or if static keys are not used
@@ -179,6 +236,7 @@ enum kfence_counter_id {
 	KFENCE_COUNTER_SKIP_INCOMPAT,
 	KFENCE_COUNTER_SKIP_CAPACITY,
 	KFENCE_COUNTER_SKIP_COVERED,
+	KFENCE_COUNTER_SKIP_WEIGHT,
 	KFENCE_COUNTER_COUNT,
 };
 static atomic_long_t counters[KFENCE_COUNTER_COUNT];
@@ -191,14 +249,35 @@ static const char *const counter_names[] = {
 	[KFENCE_COUNTER_SKIP_INCOMPAT]	= "skipped allocations (incompatible)",
 	[KFENCE_COUNTER_SKIP_CAPACITY]	= "skipped allocations (capacity)",
 	[KFENCE_COUNTER_SKIP_COVERED]	= "skipped allocations (covered)",
+	[KFENCE_COUNTER_SKIP_WEIGHT]	= "skipped allocations (weight)",
 };
 static_assert(ARRAY_SIZE(counter_names) == KFENCE_COUNTER_COUNT);
 
+/*
+ * Per-cache sampling weights, by cache name so that they also apply to caches
+ * created later. Caches without an entry have KFENCE_WEIGHT_DEFAULT.
+ */
+#define KFENCE_WEIGHT_DEFAULT	100
+#define KFENCE_WEIGHT_MAX	10000
+
+struct kfence_cache_weight {
+	struct hlist_node node;
+	struct rcu_head rcu_head;
+	u32 hash;
+	unsigned int weight;
+	char name[];
+};
+
+static DEFINE_HASHTABLE(kfence_weights, 6);
+static DEFINE_MUTEX(kfence_weights_mutex); /* Serializes weight updates. */
+/* The largest weight in effect, or 0 if all caches have the default. */
+static unsigned int kfence_weights_max __read_mostly;
+
 /* === Internals ============================================================ */
 
 static inline bool should_skip_covered(void)
 {
-	unsigned long thresh = (CONFIG_KFENCE_NUM_OBJECTS * kfence_skip_covered_thresh) / 100;
+	unsigned long thresh = (READ_ONCE(kfence_pool_objects) * kfence_skip_covered_thresh) / 100;
 
 	return atomic_long_read(&counters[KFENCE_COUNTER_ALLOCATED]) > thresh;
 }
@@ -241,6 +320,82 @@ static bool alloc_covered_contains(u32 alloc_stack_hash)
 	return true;
 }
 
+static unsigned int kfence_cache_weight(struct kmem_cache *s)
+{
+	unsigned int weight = KFENCE_WEIGHT_DEFAULT;
+	struct kfence_cache_weight *w;
+	u32 hash;
+
+	hash = full_name_hash(NULL, s->name, strlen(s->name));
+	rcu_read_lock();
+	hash_for_each_possible_rcu(kfence_weights, w, node, hash) {
+		if (w->hash == hash && !strcmp(w->name, s->name)) {
+			weight = w->weight;
+			break;
+		}
+	}
+	rcu_read_unlock();
+
+	return weight;
+}
+
+/*
+ * With weights, an allocation from a cache of weight w takes the sample with
+ * probability w / kfence_weights_max, otherwise the allocation gate stays open
+ * for the next one. Samples are thus shared between caches allocating while
+ * the gate is open in proportion to their weight, without changing the number
+ * of samples.
+ */
+static bool should_skip_weight(struct kmem_cache *s)
+{
+	unsigned int max = READ_ONCE(kfence_weights_max);
+	unsigned int weight;
+
+	if (!max)
+		return false;
+
+	weight = kfence_cache_weight(s);
+	if (weight >= max)
+		return false;
+
+	return get_random_u32_below(max) >= weight;
+}
+
+static int kfence_set_cache_weight(const char *name, unsigned int weight)
+{
+	u32 hash = full_name_hash(NULL, name, strlen(name));
+	struct kfence_cache_weight *w, *new = NULL;
+	unsigned int max = 0;
+	int bkt;
+
+	if (weight != KFENCE_WEIGHT_DEFAULT) {
+		new = kmalloc(struct_size(new, name, strlen(name) + 1), GFP_KERNEL);
+		if (!new)
+			return -ENOMEM;
+		new->hash = hash;
+		new->weight = weight;
+		strcpy(new->name, name);
+	}
+
+	mutex_lock(&kfence_weights_mutex);
+	hash_for_each_possible(kfence_weights, w, node, hash) {
+		if (w->hash == hash && !strcmp(w->name, name)) {
+			hash_del_rcu(&w->node);
+			kfree_rcu(w, rcu_head);
+			break;
+		}
+	}
+	if (new)
+		hash_add_rcu(kfence_weights, &new->node, hash);
+
+	hash_for_each(kfence_weights, bkt, w, node)
+		max = max3(max, w->weight, KFENCE_WEIGHT_DEFAULT);
+	WRITE_ONCE(kfence_weights_max, max);
+	mutex_unlock(&kfence_weights_mutex);
+
+	return 0;
+}
+
 static bool kfence_protect(unsigned long addr)
 {
 	return !KFENCE_WARN_ON(!kfence_protect_page(ALIGN_DOWN(addr, PAGE_SIZE), true));
@@ -410,6 +565,58 @@ check_canary(const struct kfence_metadata *meta)
 	}
 }
 
+/* Must be called with pcp->lock held. */
+static struct kfence_metadata *kfence_pcp_take(struct kfence_pcp_freelist *pcp)
+{
+	if (pcp->next == pcp->nr)
+		return NULL;
+	return pcp->objs[pcp->next++];
+}
+
+static struct kfence_metadata *kfence_freelist_pop(void)
+{
+	struct kfence_pcp_freelist *pcp;
+	struct kfence_metadata *meta;
+	unsigned long flags;
+	int cpu;
+
+	local_irq_save(flags);
+	pcp = this_cpu_ptr(&kfence_pcp_freelist);
+	raw_spin_lock(&pcp->lock);
+	meta = kfence_pcp_take(pcp);
+	if (!meta) {
+		raw_spin_lock(&kfence_freelist_lock);
+		pcp->next = 0;
+		pcp->nr = 0;
+		while (pcp->nr < KFENCE_PCP_BATCH && !list_empty(&kfence_freelist)) {
+			meta = list_first_entry(&kfence_freelist, struct kfence_metadata, list);
+			list_del_init(&meta->list);
+			pcp->objs[pcp->nr++] = meta;
+		}
+		raw_spin_unlock(&kfence_freelist_lock);
+		meta = kfence_pcp_take(pcp);
+	}
+	raw_spin_unlock(&pcp->lock);
+	local_irq_restore(flags);
+	if (meta)
+		return meta;
+
+	/* The remaining free objects may all be cached by other CPUs. */
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(&kfence_pcp_freelist, cpu);
+		if (data_race(pcp->next == pcp->nr))
+			continue;
+
+		raw_spin_lock_irqsave(&pcp->lock, flags);
+		meta = kfence_pcp_take(pcp);
+		raw_spin_unlock_irqrestore(&pcp->lock, flags);
+		if (meta)
+			break;
+	}
+
+	return meta;
+}
+
 static void *kfence_guarded_alloc(struct kmem_cache *cache, size_t size, gfp_t gfp,
 				  unsigned long *stack_entries, size_t num_stack_entries,
 				  u32 alloc_stack_hash)
@@ -423,12 +630,7 @@ static void *kfence_guarded_alloc(struct kmem_cache *cache, size_t size, gfp_t g
 				  !get_random_u32_below(CONFIG_KFENCE_STRESS_TEST_FAULTS);
 
 	/* Try to obtain a free object. */
-	raw_spin_lock_irqsave(&kfence_freelist_lock, flags);
-	if (!list_empty(&kfence_freelist)) {
-		meta = list_entry(kfence_freelist.next, struct kfence_metadata, list);
-		list_del_init(&meta->list);
-	}
-	raw_spin_unlock_irqrestore(&kfence_freelist_lock, flags);
+	meta = kfence_freelist_pop();
 	if (!meta) {
 		atomic_long_inc(&counters[KFENCE_COUNTER_SKIP_CAPACITY]);
 		return NULL;
@@ -568,7 +770,10 @@ static void kfence_guarded_free(void *addr, struct kfence_metadata *meta, bool z
 		/* Add it to the tail of the freelist for reuse. */
 		raw_spin_lock_irqsave(&kfence_freelist_lock, flags);
 		KFENCE_WARN_ON(!list_empty(&meta->list));
-		list_add_tail(&meta->list, &kfence_freelist);
+		if (meta - kfence_metadata < kfence_pool_objects)
+			list_add_tail(&meta->list, &kfence_freelist);
+		else
+			list_add_tail(&meta->list, &kfence_parked);
 		raw_spin_unlock_irqrestore(&kfence_freelist_lock, flags);
 
 		atomic_long_dec(&counters[KFENCE_COUNTER_ALLOCATED]);
@@ -645,7 +850,10 @@ static unsigned long kfence_init_pool(void)
 		raw_spin_lock_init(&meta->lock);
 		meta->state = KFENCE_OBJECT_UNUSED;
 		meta->addr = addr; /* Initialize for validation in metadata_to_pageaddr(). */
-		list_add_tail(&meta->list, &kfence_freelist);
+		if (i < READ_ONCE(kfence_pool_objects))
+			list_add_tail(&meta->list, &kfence_freelist);
+		else
+			list_add_tail(&meta->list, &kfence_parked);
 
 		/* Protect the right redzone. */
 		if (unlikely(!kfence_protect(addr + PAGE_SIZE)))
@@ -713,6 +921,55 @@ static bool __init kfence_init_pool_early(void)
 	return false;
 }
 
+/*
+ * Set the number of pool objects used for allocations. Objects beyond @num
+ * that are free are parked right away; those still allocated are parked when
+ * freed.
+ */
+static void kfence_resize_pool(unsigned long num)
+{
+	struct kfence_metadata *meta, *next;
+	struct kfence_pcp_freelist *pcp;
+	unsigned long flags;
+	int cpu, i;
+
+	raw_spin_lock_irqsave(&kfence_freelist_lock, flags);
+	WRITE_ONCE(kfence_pool_objects, num);
+	/* Before the pool is initialized, it only has to pick up the value. */
+	if (kfence_metadata) {
+		list_for_each_entry_safe(meta, next, &kfence_freelist, list) {
+			if (meta - kfence_metadata >= num)
+				list_move_tail(&meta->list, &kfence_parked);
+		}
+		list_for_each_entry_safe(meta, next, &kfence_parked, list) {
+			if (meta - kfence_metadata < num)
+				list_move_tail(&meta->list, &kfence_freelist);
+		}
+	}
+	raw_spin_unlock_irqrestore(&kfence_freelist_lock, flags);
+
+	/*
+	 * Return the objects cached per CPU, which have been free the longest,
+	 * to the head of the lists; the refills from now on respect @num.
+	 */
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(&kfence_pcp_freelist, cpu);
+		raw_spin_lock_irqsave(&pcp->lock, flags);
+		raw_spin_lock(&kfence_freelist_lock);
+		for (i = pcp->nr - 1; i >= (int)pcp->next; i--) {
+			meta = pcp->objs[i];
+			if (meta - kfence_metadata < num)
+				list_add(&meta->list, &kfence_freelist);
+			else
+				list_add(&meta->list, &kfence_parked);
+		}
+		pcp->next = 0;
+		pcp->nr = 0;
+		raw_spin_unlock(&kfence_freelist_lock);
+		raw_spin_unlock_irqrestore(&pcp->lock, flags);
+	}
+}
+
 /* === DebugFS Interface ==================================================== */
 
 static int stats_show(struct seq_file *seq, void *v)
@@ -720,6 +977,8 @@ static int stats_show(struct seq_file *seq, void *v)
 	int i;
 
 	seq_printf(seq, "enabled: %i\n", READ_ONCE(kfence_enabled));
+	seq_printf(seq, "pool objects: %lu/%d\n", READ_ONCE(kfence_pool_objects),
+		   CONFIG_KFENCE_NUM_OBJECTS);
 	for (i = 0; i < KFENCE_COUNTER_COUNT; i++)
 		seq_printf(seq, "%s: %ld\n", counter_names[i], atomic_long_read(&counters[i]));
 
@@ -772,6 +1031,70 @@ static const struct seq_operations objects_sops = {
 };
 DEFINE_SEQ_ATTRIBUTE(objects);
 
+/*
+ * /sys/kernel/debug/kfence/cache_weights lists the caches with a non-default
+ * sampling weight. Writing "<cache name> <weight>" sets the weight of a cache,
+ * from 0 (never sampled) to KFENCE_WEIGHT_MAX; the default is 100.
+ */
+static int cache_weights_show(struct seq_file *seq, void *v)
+{
+	struct kfence_cache_weight *w;
+	int bkt;
+
+	mutex_lock(&kfence_weights_mutex);
+	hash_for_each(kfence_weights, bkt, w, node)
+		seq_printf(seq, "%s %u\n", w->name, w->weight);
+	mutex_unlock(&kfence_weights_mutex);
+
+	return 0;
+}
+
+static int cache_weights_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cache_weights_show, NULL);
+}
+
+static ssize_t cache_weights_write(struct file *file, const char __user *ubuf,
+				   size_t count, loff_t *ppos)
+{
+	unsigned int weight;
+	char *buf, *p, *name;
+	int ret;
+
+	if (count > KMALLOC_MAX_SIZE)
+		return -EINVAL;
+	buf = memdup_user_nul(ubuf, count);
+	if (IS_ERR(buf))
+		return PTR_ERR(buf);
+
+	p = strim(buf);
+	name = strsep(&p, " \t");
+	ret = -EINVAL;
+	if (!*name || !p)
+		goto out;
+
+	ret = kstrtouint(skip_spaces(p), 0, &weight);
+	if (ret)
+		goto out;
+	if (weight > KFENCE_WEIGHT_MAX) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	ret = kfence_set_cache_weight(name, weight);
+out:
+	kfree(buf);
+	return ret ?: count;
+}
+
+static const struct file_operations cache_weights_fops = {
+	.open = cache_weights_open,
+	.read = seq_read,
+	.write = cache_weights_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int kfence_debugfs_init(void)
 {
 	struct dentry *kfence_dir;
@@ -782,6 +1105,7 @@ static int kfence_debugfs_init(void)
 	kfence_dir = debugfs_create_dir("kfence", NULL);
 	debugfs_create_file("stats", 0444, kfence_dir, NULL, &stats_fops);
 	debugfs_create_file("objects", 0400, kfence_dir, NULL, &objects_fops);
+	debugfs_create_file("cache_weights", 0600, kfence_dir, NULL, &cache_weights_fops);
 	return 0;
 }
 
@@ -1096,6 +1420,21 @@ void *__kfence_alloc(struct kmem_cache *s, size_t size, gfp_t flags)
 	if (s->flags & SLAB_SKIP_KFENCE)
 		return NULL;
 
+	/* Leave the sample to another allocation, see should_skip_weight(). */
+	if (should_skip_weight(s)) {
+		atomic_long_inc(&counters[KFENCE_COUNTER_SKIP_WEIGHT]);
+		return NULL;
+	}
+
+	/*
+	 * All CPUs allocating when the gate opens get here; most of them after
+	 * another has already taken the sample. Only read the gate in that
+	 * case, instead of all of them bouncing its cache line with an atomic
+	 * increment.
+	 */
+	if (atomic_read(&kfence_allocation_gate) > 0)
+		return NULL;
+
 	allocation_gate = atomic_inc_return(&kfence_allocation_gate);
 	if (allocation_gate > 1)
 		return NULL;
@@ -18,6 +18,7 @@
 #include <linux/mm.h>
 #include <linux/mm_types.h>
 #include <linux/mmzone.h>
+#include <linux/moduleparam.h>
 #include <linux/percpu-defs.h>
 #include <linux/preempt.h>
 #include <linux/slab.h>
@@ -31,6 +32,14 @@
 
 bool kmsan_enabled __read_mostly;
 
+bool kmsan_track_origins __read_mostly = true;
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "kmsan."
+module_param_named(origins, kmsan_track_origins, bool, 0);
+
 /*
  * Per-CPU KMSAN context to be used in interrupts, where current->kmsan is
  * unavaliable.
@@ -70,6 +79,9 @@ depot_stack_handle_t kmsan_save_stack_with_flags(gfp_t flags,
 	unsigned int nr_entries;
 	depot_stack_handle_t handle;
 
+	if (!kmsan_track_origins)
+		return 0;
+
 	nr_entries = stack_trace_save(entries, KMSAN_STACK_DEPTH, 0);
 
 	/* Don't sleep. */
@@ -79,6 +91,24 @@ depot_stack_handle_t kmsan_save_stack_with_flags(gfp_t flags,
 	return stack_depot_set_extra_bits(handle, extra);
 }
 
+/*
+ * Check whether @size shadow bytes at @shadow are all zero, a word at a time.
+ * The runtime is not instrumented, so memchr_inv() is avoided here.
+ */
+static bool kmsan_shadow_is_clean(const u8 *shadow, size_t size)
+{
+	for (; size && !IS_ALIGNED((u64)shadow, sizeof(u64)); shadow++, size--)
+		if (*shadow)
+			return false;
+	for (; size >= sizeof(u64); shadow += sizeof(u64), size -= sizeof(u64))
+		if (*(const u64 *)shadow)
+			return false;
+	for (; size; shadow++, size--)
+		if (*shadow)
+			return false;
+	return true;
+}
+
 /* Copy the metadata following the memmove() behavior. */
 void kmsan_internal_memmove_metadata(void *dst, void *src, size_t n)
 {
@@ -98,13 +128,18 @@ void kmsan_internal_memmove_metadata(void *dst, void *src, size_t n)
 		(u32 *)ALIGN_DOWN((u64)shadow_dst, KMSAN_ORIGIN_SIZE);
 
 	shadow_src = kmsan_get_metadata(src, KMSAN_META_SHADOW);
-	if (!shadow_src) {
-		/* @src is untracked: mark @dst as initialized. */
+	if (!shadow_src || kmsan_shadow_is_clean(shadow_src, n)) {
+		/* @src is untracked or initialized: mark @dst as initialized. */
 		kmsan_internal_unpoison_memory(dst, n, /*checked*/ false);
 		return;
 	}
 	KMSAN_WARN_ON(!kmsan_metadata_is_contiguous(src, n));
 
+	if (!kmsan_track_origins) {
+		__memmove(shadow_dst, shadow_src, n);
+		return;
+	}
+
 	origin_dst = kmsan_get_metadata(dst, KMSAN_META_ORIGIN);
 	origin_src = kmsan_get_metadata(src, KMSAN_META_ORIGIN);
 	KMSAN_WARN_ON(!origin_dst || !origin_src);
@@ -153,7 +188,7 @@ depot_stack_handle_t kmsan_internal_chain_origin(depot_stack_handle_t id)
 	bool uaf;
 	depot_stack_handle_t handle;
 
-	if (!id)
+	if (!id || !kmsan_track_origins)
 		return id;
 	/*
 	 * Make sure we have enough spare bits in @id to hold the UAF bit and
@@ -214,6 +249,9 @@ void kmsan_internal_set_shadow_origin(void *addr, size_t size, int b,
 	}
 	__memset(shadow_start, b, size);
 
+	if (!kmsan_track_origins)
+		return;
+
 	if (!IS_ALIGNED(address, KMSAN_ORIGIN_SIZE)) {
 		pad = address % KMSAN_ORIGIN_SIZE;
 		address -= pad;
@@ -253,7 +291,7 @@ void kmsan_internal_check_memory(void *addr, size_t size,
 				 const void __user *user_addr, int reason)
 {
 	depot_stack_handle_t cur_origin = 0, new_origin = 0;
-	unsigned long addr64 = (unsigned long)addr;
+	unsigned long addr64 = (unsigned long)addr, chunk_start;
 	depot_stack_handle_t *origin = NULL;
 	unsigned char *shadow = NULL;
 	int cur_off_start = -1;
@@ -285,6 +323,31 @@ void kmsan_internal_check_memory(void *addr, size_t size,
 			pos += chunk_size;
 			continue;
 		}
+		/*
+		 * Most checked buffers are fully initialized: look at the whole
+		 * chunk of shadow at once, and only walk it byte by byte if it
+		 * has poisoned bytes.
+		 */
+		if (kmsan_shadow_is_clean(shadow, chunk_size)) {
+			if (cur_origin) {
+				kmsan_enter_runtime();
+				kmsan_report(cur_origin, addr, size,
+					     cur_off_start, pos - 1, user_addr,
+					     reason);
+				kmsan_leave_runtime();
+			}
+			cur_origin = 0;
+			cur_off_start = -1;
+			pos += chunk_size;
+			continue;
+		}
+		/* The chunk is within a page, so are its origins. */
+		chunk_start = ALIGN_DOWN(addr64 + pos, KMSAN_ORIGIN_SIZE);
+		if (kmsan_track_origins) {
+			origin = kmsan_get_metadata((void *)chunk_start,
+						    KMSAN_META_ORIGIN);
+			KMSAN_WARN_ON(!origin);
+		}
 		for (int i = 0; i < chunk_size; i++) {
 			if (!shadow[i]) {
 				/*
@@ -302,10 +365,12 @@ void kmsan_internal_check_memory(void *addr, size_t size,
 				cur_off_start = -1;
 				continue;
 			}
-			origin = kmsan_get_metadata((void *)(addr64 + pos + i),
-						    KMSAN_META_ORIGIN);
-			KMSAN_WARN_ON(!origin);
-			new_origin = *origin;
+			if (kmsan_track_origins)
+				new_origin = origin[(addr64 + pos + i -
+						     chunk_start) /
+						    KMSAN_ORIGIN_SIZE];
+			else
+				new_origin = KMSAN_NO_ORIGIN;
 			/*
 			 * Encountered new origin - report the previous
 			 * uninitialized range.
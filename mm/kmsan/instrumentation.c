@@ -282,9 +282,14 @@ void __msan_poison_alloca(void *address, uintptr_t size, char *descr)
 		entries[3] = 0;
 
 	/* stack_depot_save() may allocate memory. */
-	kmsan_enter_runtime();
-	handle = stack_depot_save(entries, ARRAY_SIZE(entries), __GFP_HIGH);
-	kmsan_leave_runtime();
+	if (kmsan_track_origins) {
+		kmsan_enter_runtime();
+		handle = stack_depot_save(entries, ARRAY_SIZE(entries),
+					  __GFP_HIGH);
+		kmsan_leave_runtime();
+	} else {
+		handle = 0;
+	}
 
 	kmsan_internal_set_shadow_origin(address, size, -1, handle,
 					 /*checked*/ true);
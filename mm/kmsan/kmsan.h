@@ -22,6 +22,8 @@
 
 #define KMSAN_ALLOCA_MAGIC_ORIGIN 0xabcd0100
 #define KMSAN_CHAIN_MAGIC_ORIGIN 0xabcd0200
+/* Stands for the origin of poisoned bytes when origins are not tracked. */
+#define KMSAN_NO_ORIGIN 0xabcd0300
 
 #define KMSAN_POISON_NOCHECK 0x0
 #define KMSAN_POISON_CHECK 0x1
@@ -35,6 +37,13 @@
 #define KMSAN_META_SHADOW (false)
 #define KMSAN_META_ORIGIN (true)
 
+/*
+ * When false (kmsan.origins=0), KMSAN only tracks the shadow. No stack traces
+ * are saved and the origin pages are neither filled nor copied, so reports
+ * tell which bytes are uninitialized but not where they came from.
+ */
+extern bool kmsan_track_origins;
+
 /*
  * A pair of metadata pointers to be returned by the instrumentation functions.
  */
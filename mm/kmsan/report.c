@@ -161,14 +161,16 @@ void kmsan_report(depot_stack_handle_t origin, void *address, int size,
 		return;
 	if (current->kmsan_ctx.depth)
 		return;
-	if (!origin)
+	/* Without origin tracking, the shadow alone tells a byte is poisoned. */
+	if (!origin && kmsan_track_origins)
 		return;
 
 	kmsan_disable_current();
 	ua_flags = user_access_save();
 	raw_spin_lock(&kmsan_report_lock);
 	pr_err("=====================================================\n");
-	is_uaf = kmsan_uaf_from_eb(stack_depot_get_extra_bits(origin));
+	is_uaf = kmsan_track_origins &&
+		 kmsan_uaf_from_eb(stack_depot_get_extra_bits(origin));
 	switch (reason) {
 	case REASON_ANY:
 		bug_type = is_uaf ? "use-after-free" : "uninit-value";
@@ -193,7 +195,10 @@ void kmsan_report(depot_stack_handle_t origin, void *address, int size,
 			  0);
 	pr_err("\n");
 
-	kmsan_print_origin(origin);
+	if (kmsan_track_origins)
+		kmsan_print_origin(origin);
+	else
+		pr_err("Origin tracking disabled (kmsan.origins=0)\n");
 
 	if (size) {
 		pr_err("\n");
@@ -162,7 +162,8 @@ void kmsan_copy_page_meta(struct page *dst, struct page *src)
 
 	kmsan_enter_runtime();
 	__memcpy(shadow_ptr_for(dst), shadow_ptr_for(src), PAGE_SIZE);
-	__memcpy(origin_ptr_for(dst), origin_ptr_for(src), PAGE_SIZE);
+	if (kmsan_track_origins)
+		__memcpy(origin_ptr_for(dst), origin_ptr_for(src), PAGE_SIZE);
 	kmsan_leave_runtime();
 }
 EXPORT_SYMBOL(kmsan_copy_page_meta);
@@ -182,7 +183,8 @@ void kmsan_alloc_page(struct page *page, unsigned int order, gfp_t flags)
 
 	if (initialized) {
 		__memset(page_address(shadow), 0, PAGE_SIZE * pages);
-		__memset(page_address(origin), 0, PAGE_SIZE * pages);
+		if (kmsan_track_origins)
+			__memset(page_address(origin), 0, PAGE_SIZE * pages);
 		return;
 	}
 
@@ -191,6 +193,8 @@ void kmsan_alloc_page(struct page *page, unsigned int order, gfp_t flags)
 		return;
 
 	__memset(page_address(shadow), -1, PAGE_SIZE * pages);
+	if (!kmsan_track_origins)
+		return;
 	kmsan_enter_runtime();
 	handle = kmsan_save_stack_with_flags(flags, /*extra_bits*/ 0);
 	kmsan_leave_runtime();
@@ -0,0 +1,347 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * 9P client metadata cache
+ *
+ * Without a cache nearly every stat() is at least one TGETATTR round trip,
+ * lookups of names that do not exist are a TWALK each, and directories are
+ * read again from the server every time they are listed.  With the cache_ttl
+ * option the client remembers, for at most that many milliseconds:
+ *
+ *  - the attributes returned by TGETATTR, keyed by qid path, so that they
+ *    are shared by all fids of a file;
+ *  - single component walks that failed with -ENOENT, keyed by the qid path
+ *    of the directory and the name;
+ *  - TREADDIR replies, keyed by the qid path of the directory, the offset
+ *    and the count.
+ *
+ * 9P has no leases or change notifications, so changes made by other clients
+ * of the server are only seen once the entries expire.  Changes made through
+ * this client invalidate what they affect: all entries of a qid path go away
+ * when anything modifies that file or, for a directory, its contents.  The
+ * few operations whose victims cannot be identified by qid (rename, remove
+ * and unlinkat) flush the whole cache.  A generation counter, bumped by
+ * every invalidation, keeps a reply that raced with a modification from being
+ * stored.
+ *
+ * Entries are evicted in LRU order once the cache holds more than
+ * P9_CACHE_MAX_BYTES.
+ */
+
+#include <linux/hashtable.h>
+#include <linux/jiffies.h>
+#include <linux/list.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/stringhash.h>
+#include <net/9p/9p.h>
+#include <net/9p/client.h>
+#include "cache.h"
+
+#define P9_CACHE_HASH_BITS	10
+#define P9_CACHE_MAX_BYTES	SZ_4M
+
+enum p9_cache_type {
+	P9_CACHE_ATTR,
+	P9_CACHE_NOENT,
+	P9_CACHE_DIRENTS,
+};
+
+/**
+ * struct p9_cache_entry - cached reply
+ * @node: link in the hash table, hashed by @path
+ * @lru: link in the LRU list
+ * @path: qid path of the file, or of the directory for NOENT and DIRENTS
+ * @key: request mask for ATTR, name hash for NOENT, offset for DIRENTS
+ * @count: requested count for DIRENTS
+ * @expires: jiffies after which the entry is stale
+ * @type: one of enum p9_cache_type
+ * @len: number of bytes in @data
+ * @data: struct p9_stat_dotl, name or directory entries
+ */
+struct p9_cache_entry {
+	struct hlist_node node;
+	struct list_head lru;
+	u64 path;
+	u64 key;
+	u32 count;
+	unsigned long expires;
+	u8 type;
+	u32 len;
+	u8 data[];
+};
+
+struct p9_cache {
+	spinlock_t lock;
+	unsigned long ttl;
+	unsigned long gen;
+	size_t bytes;
+	struct list_head lru;
+	DECLARE_HASHTABLE(table, P9_CACHE_HASH_BITS);
+};
+
+int p9_cache_init(struct p9_client *clnt)
+{
+	struct p9_cache *cache;
+
+	if (!clnt->cache_ttl)
+		return 0;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return -ENOMEM;
+
+	spin_lock_init(&cache->lock);
+	cache->ttl = msecs_to_jiffies(clnt->cache_ttl);
+	INIT_LIST_HEAD(&cache->lru);
+	hash_init(cache->table);
+	clnt->cache = cache;
+	return 0;
+}
+
+static void p9_cache_free(struct p9_cache *cache, struct p9_cache_entry *ent)
+{
+	hash_del(&ent->node);
+	list_del(&ent->lru);
+	cache->bytes -= sizeof(*ent) + ent->len;
+	kfree(ent);
+}
+
+void p9_cache_destroy(struct p9_client *clnt)
+{
+	struct p9_cache *cache = clnt->cache;
+	struct p9_cache_entry *ent, *tmp;
+
+	if (!cache)
+		return;
+
+	list_for_each_entry_safe(ent, tmp, &cache->lru, lru)
+		p9_cache_free(cache, ent);
+	kfree(cache);
+	clnt->cache = NULL;
+}
+
+/**
+ * p9_cache_begin - start a request whose reply may be cached
+ * @clnt: client
+ *
+ * Returns the generation to pass to the store function once the reply is
+ * in.  The reply is not stored if the cache was invalidated in between.
+ */
+unsigned long p9_cache_begin(struct p9_client *clnt)
+{
+	struct p9_cache *cache = clnt->cache;
+
+	return cache ? READ_ONCE(cache->gen) : 0;
+}
+
+/**
+ * p9_cache_invalidate - drop everything cached about a file
+ * @clnt: client
+ * @path: qid path of the file
+ *
+ * For a directory this includes the cached negative lookups of its names
+ * and its cached entries.
+ */
+void p9_cache_invalidate(struct p9_client *clnt, u64 path)
+{
+	struct p9_cache *cache = clnt->cache;
+	struct p9_cache_entry *ent;
+	struct hlist_node *tmp;
+
+	if (!cache)
+		return;
+
+	spin_lock(&cache->lock);
+	cache->gen++;
+	hash_for_each_possible_safe(cache->table, ent, tmp, node, path) {
+		if (ent->path == path)
+			p9_cache_free(cache, ent);
+	}
+	spin_unlock(&cache->lock);
+}
+
+void p9_cache_flush(struct p9_client *clnt)
+{
+	struct p9_cache *cache = clnt->cache;
+	struct p9_cache_entry *ent, *tmp;
+
+	if (!cache)
+		return;
+
+	spin_lock(&cache->lock);
+	cache->gen++;
+	list_for_each_entry_safe(ent, tmp, &cache->lru, lru)
+		p9_cache_free(cache, ent);
+	spin_unlock(&cache->lock);
+}
+
+/* Called with the cache lock held, returns a live entry and marks it used */
+static struct p9_cache_entry *p9_cache_find(struct p9_cache *cache, u8 type,
+					    u64 path, u64 key, u32 count,
+					    const char *name)
+{
+	struct p9_cache_entry *ent;
+	struct hlist_node *tmp;
+
+	hash_for_each_possible_safe(cache->table, ent, tmp, node, path) {
+		if (ent->path != path || ent->type != type)
+			continue;
+		if (time_after(jiffies, ent->expires)) {
+			p9_cache_free(cache, ent);
+			continue;
+		}
+
+		switch (type) {
+		case P9_CACHE_ATTR:
+			/* Only one per file, key is what it was fetched for */
+			if ((ent->key & key) != key)
+				return NULL;
+			break;
+		case P9_CACHE_NOENT:
+			if (ent->key != key || strcmp(ent->data, name))
+				continue;
+			break;
+		case P9_CACHE_DIRENTS:
+			if (ent->key != key || ent->count != count)
+				continue;
+			break;
+		}
+
+		list_move_tail(&ent->lru, &cache->lru);
+		return ent;
+	}
+	return NULL;
+}
+
+static void p9_cache_store(struct p9_cache *cache, unsigned long gen, u8 type,
+			   u64 path, u64 key, u32 count, const void *data,
+			   u32 len)
+{
+	struct p9_cache_entry *ent, *old;
+
+	ent = kmalloc(struct_size(ent, data, len), GFP_NOFS | __GFP_NOWARN);
+	if (!ent)
+		return;
+
+	ent->path = path;
+	ent->key = key;
+	ent->count = count;
+	ent->type = type;
+	ent->len = len;
+	memcpy(ent->data, data, len);
+
+	spin_lock(&cache->lock);
+	if (cache->gen != gen) {
+		spin_unlock(&cache->lock);
+		kfree(ent);
+		return;
+	}
+
+	/*
+	 * Replace an existing entry, for ATTR whatever mask it was fetched
+	 * for, as the new reply is more recent.
+	 */
+	old = p9_cache_find(cache, type, path,
+			    type == P9_CACHE_ATTR ? 0 : key, count,
+			    type == P9_CACHE_NOENT ? data : NULL);
+	if (old)
+		p9_cache_free(cache, old);
+
+	ent->expires = jiffies + cache->ttl;
+	hash_add(cache->table, &ent->node, path);
+	list_add_tail(&ent->lru, &cache->lru);
+	cache->bytes += sizeof(*ent) + len;
+
+	while (cache->bytes > P9_CACHE_MAX_BYTES) {
+		old = list_first_entry(&cache->lru, struct p9_cache_entry, lru);
+		p9_cache_free(cache, old);
+	}
+	spin_unlock(&cache->lock);
+}
+
+bool p9_cache_lookup_attr(struct p9_client *clnt, u64 path, u64 request_mask,
+			  struct p9_stat_dotl *st)
+{
+	struct p9_cache *cache = clnt->cache;
+	struct p9_cache_entry *ent;
+
+	if (!cache)
+		return false;
+
+	spin_lock(&cache->lock);
+	ent = p9_cache_find(cache, P9_CACHE_ATTR, path, request_mask, 0, NULL);
+	if (ent)
+		memcpy(st, ent->data, sizeof(*st));
+	spin_unlock(&cache->lock);
+	return ent;
+}
+
+void p9_cache_store_attr(struct p9_client *clnt, unsigned long gen, u64 path,
+			 u64 request_mask, const struct p9_stat_dotl *st)
+{
+	if (clnt->cache)
+		p9_cache_store(clnt->cache, gen, P9_CACHE_ATTR, path,
+			       request_mask, 0, st, sizeof(*st));
+}
+
+bool p9_cache_lookup_noent(struct p9_client *clnt, u64 dir_path,
+			   const char *name)
+{
+	struct p9_cache *cache = clnt->cache;
+	struct p9_cache_entry *ent;
+
+	if (!cache)
+		return false;
+
+	spin_lock(&cache->lock);
+	ent = p9_cache_find(cache, P9_CACHE_NOENT, dir_path,
+			    full_name_hash(NULL, name, strlen(name)), 0, name);
+	spin_unlock(&cache->lock);
+	return ent;
+}
+
+void p9_cache_store_noent(struct p9_client *clnt, unsigned long gen,
+			  u64 dir_path, const char *name)
+{
+	u32 len = strlen(name);
+
+	if (clnt->cache)
+		p9_cache_store(clnt->cache, gen, P9_CACHE_NOENT, dir_path,
+			       full_name_hash(NULL, name, len), 0, name,
+			       len + 1);
+}
+
+/*
+ * Copy cached directory entries read from @offset with @count to @data.
+ * Returns the number of bytes, or -ENOENT if nothing is cached.
+ */
+int p9_cache_lookup_dirents(struct p9_client *clnt, u64 dir_path, u64 offset,
+			    u32 count, char *data)
+{
+	struct p9_cache *cache = clnt->cache;
+	struct p9_cache_entry *ent;
+	int ret = -ENOENT;
+
+	if (!cache)
+		return ret;
+
+	spin_lock(&cache->lock);
+	ent = p9_cache_find(cache, P9_CACHE_DIRENTS, dir_path, offset, count,
+			    NULL);
+	if (ent) {
+		memcpy(data, ent->data, ent->len);
+		ret = ent->len;
+	}
+	spin_unlock(&cache->lock);
+	return ret;
+}
+
+void p9_cache_store_dirents(struct p9_client *clnt, unsigned long gen,
+			    u64 dir_path, u64 offset, u32 count,
+			    const char *data, u32 len)
+{
+	if (clnt->cache)
+		p9_cache_store(clnt->cache, gen, P9_CACHE_DIRENTS, dir_path,
+			       offset, count, data, len);
+}
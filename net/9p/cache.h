@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * 9P client metadata cache
+ */
+
+#ifndef NET_9P_CACHE_H
+#define NET_9P_CACHE_H
+
+struct p9_client;
+struct p9_stat_dotl;
+
+int p9_cache_init(struct p9_client *clnt);
+void p9_cache_destroy(struct p9_client *clnt);
+
+unsigned long p9_cache_begin(struct p9_client *clnt);
+void p9_cache_invalidate(struct p9_client *clnt, u64 path);
+void p9_cache_flush(struct p9_client *clnt);
+
+bool p9_cache_lookup_attr(struct p9_client *clnt, u64 path, u64 request_mask,
+			  struct p9_stat_dotl *st);
+void p9_cache_store_attr(struct p9_client *clnt, unsigned long gen, u64 path,
+			 u64 request_mask, const struct p9_stat_dotl *st);
+
+bool p9_cache_lookup_noent(struct p9_client *clnt, u64 dir_path,
+			   const char *name);
+void p9_cache_store_noent(struct p9_client *clnt, unsigned long gen,
+			  u64 dir_path, const char *name);
+
+int p9_cache_lookup_dirents(struct p9_client *clnt, u64 dir_path, u64 offset,
+			    u32 count, char *data);
+void p9_cache_store_dirents(struct p9_client *clnt, unsigned long gen,
+			    u64 dir_path, u64 offset, u32 count,
+			    const char *data, u32 len);
+
+#endif /* NET_9P_CACHE_H */
@@ -25,6 +25,7 @@
 #include <net/9p/client.h>
 #include <net/9p/transport.h>
 #include "protocol.h"
+#include "cache.h"
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/9p.h>
@@ -44,6 +45,7 @@ enum {
 	Opt_trans,
 	Opt_legacy,
 	Opt_version,
+	Opt_cache_ttl,
 	Opt_err,
 };
 
@@ -52,6 +54,7 @@ static const match_table_t tokens = {
 	{Opt_legacy, "noextend"},
 	{Opt_trans, "trans=%s"},
 	{Opt_version, "version=%s"},
+	{Opt_cache_ttl, "cache_ttl=%u"},
 	{Opt_err, NULL},
 };
 
@@ -72,6 +75,8 @@ int p9_show_client_options(struct seq_file *m, struct p9_client *clnt)
 	if (clnt->msize != DEFAULT_MSIZE)
 		seq_printf(m, ",msize=%u", clnt->msize);
 	seq_printf(m, ",trans=%s", clnt->trans_mod->name);
+	if (clnt->cache_ttl)
+		seq_printf(m, ",cache_ttl=%u", clnt->cache_ttl);
 
 	switch (clnt->proto_version) {
 	case p9_proto_legacy:
@@ -143,6 +148,7 @@ static int parse_opts(char *opts, struct p9_client *clnt)
 
 	clnt->proto_version = p9_proto_2000L;
 	clnt->msize = DEFAULT_MSIZE;
+	clnt->cache_ttl = 0;
 
 	if (!opts)
 		return 0;
@@ -211,6 +217,14 @@ static int parse_opts(char *opts, struct p9_client *clnt)
 				clnt->proto_version = r;
 			kfree(s);
 			break;
+		case Opt_cache_ttl:
+			r = match_uint(&args[0], &clnt->cache_ttl);
+			if (r < 0) {
+				p9_debug(P9_DEBUG_ERROR,
+					 "integer field, but no integer?\n");
+				ret = r;
+			}
+			break;
 		default:
 			continue;
 		}
@@ -989,6 +1003,7 @@ struct p9_client *p9_client_create(const char *dev_name, char *options)
 	clnt->trans_mod = NULL;
 	clnt->trans = NULL;
 	clnt->fcall_cache = NULL;
+	clnt->cache = NULL;
 
 	client_id = utsname()->nodename;
 	memcpy(clnt->name, client_id, strlen(client_id) + 1);
@@ -1037,11 +1052,15 @@ struct p9_client *p9_client_create(const char *dev_name, char *options)
 	if (err)
 		goto close_trans;
 
+	err = p9_cache_init(clnt);
+	if (err)
+		goto close_trans;
+
 	cache_name = kasprintf(GFP_KERNEL,
 		"9p-fcall-cache-%u", atomic_inc_return(&seqno));
 	if (!cache_name) {
 		err = -ENOMEM;
-		goto close_trans;
+		goto destroy_cache;
 	}
 
 	/* P9_HDRSZ + 4 is the smallest packet header we can have that is
@@ -1056,6 +1075,8 @@ struct p9_client *p9_client_create(const char *dev_name, char *options)
 	kfree(cache_name);
 	return clnt;
 
+destroy_cache:
+	p9_cache_destroy(clnt);
 close_trans:
 	clnt->trans_mod->close(clnt);
 put_trans:
@@ -1085,6 +1106,7 @@ void p9_client_destroy(struct p9_client *clnt)
 
 	p9_tag_cleanup(clnt);
 
+	p9_cache_destroy(clnt);
 	kmem_cache_destroy(clnt->fcall_cache);
 	kfree(clnt);
 }
@@ -1160,9 +1182,15 @@ struct p9_fid *p9_client_walk(struct p9_fid *oldfid, uint16_t nwname,
 	struct p9_qid *wqids;
 	struct p9_req_t *req;
 	u16 nwqids, count;
+	unsigned long gen;
 
 	wqids = NULL;
 	clnt = oldfid->clnt;
+	if (nwname == 1 &&
+	    p9_cache_lookup_noent(clnt, oldfid->qid.path, wnames[0]))
+		return ERR_PTR(-ENOENT);
+
+	gen = p9_cache_begin(clnt);
 	if (clone) {
 		fid = p9_fid_create(clnt);
 		if (!fid) {
@@ -1181,6 +1209,10 @@ struct p9_fid *p9_client_walk(struct p9_fid *oldfid, uint16_t nwname,
 			    nwname, wnames);
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
+		/* The first name does not exist */
+		if (err == -ENOENT && nwname)
+			p9_cache_store_noent(clnt, gen, oldfid->qid.path,
+					     wnames[0]);
 		goto error;
 	}
 
@@ -1195,6 +1227,12 @@ struct p9_fid *p9_client_walk(struct p9_fid *oldfid, uint16_t nwname,
 	p9_debug(P9_DEBUG_9P, "<<< RWALK nwqid %d:\n", nwqids);
 
 	if (nwqids != nwname) {
+		/* Remember which name of which directory does not exist */
+		if (nwqids < nwname)
+			p9_cache_store_noent(clnt, gen, nwqids ?
+					     wqids[nwqids - 1].path :
+					     oldfid->qid.path,
+					     wnames[nwqids]);
 		err = -ENOENT;
 		goto clunk_fid;
 	}
@@ -1245,6 +1283,8 @@ int p9_client_open(struct p9_fid *fid, int mode)
 		req = p9_client_rpc(clnt, P9_TLOPEN, "dd", fid->fid, mode & P9L_MODE_MASK);
 	else
 		req = p9_client_rpc(clnt, P9_TOPEN, "db", fid->fid, mode & P9L_MODE_MASK);
+	if (mode & (p9_is_proto_dotl(clnt) ? P9_DOTL_TRUNC : P9_OTRUNC))
+		p9_cache_invalidate(clnt, fid->qid.path);
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
 		goto error;
@@ -1290,6 +1330,7 @@ int p9_client_create_dotl(struct p9_fid *ofid, const char *name, u32 flags,
 
 	req = p9_client_rpc(clnt, P9_TLCREATE, "dsddg", ofid->fid, name, flags,
 			    mode & P9L_MODE_MASK, gid);
+	p9_cache_invalidate(clnt, ofid->qid.path);
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
 		goto error;
@@ -1333,6 +1374,7 @@ int p9_client_fcreate(struct p9_fid *fid, const char *name, u32 perm, int mode,
 
 	req = p9_client_rpc(clnt, P9_TCREATE, "dsdb?s", fid->fid, name, perm,
 			    mode & P9L_MODE_MASK, extension);
+	p9_cache_invalidate(clnt, fid->qid.path);
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
 		goto error;
@@ -1371,6 +1413,7 @@ int p9_client_symlink(struct p9_fid *dfid, const char *name,
 
 	req = p9_client_rpc(clnt, P9_TSYMLINK, "dssg", dfid->fid, name, symtgt,
 			    gid);
+	p9_cache_invalidate(clnt, dfid->qid.path);
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
 		goto error;
@@ -1402,6 +1445,8 @@ int p9_client_link(struct p9_fid *dfid, struct p9_fid *oldfid, const char *newna
 	clnt = dfid->clnt;
 	req = p9_client_rpc(clnt, P9_TLINK, "dds", dfid->fid, oldfid->fid,
 			    newname);
+	p9_cache_invalidate(clnt, dfid->qid.path);
+	p9_cache_invalidate(clnt, oldfid->qid.path);
 	if (IS_ERR(req))
 		return PTR_ERR(req);
 
@@ -1482,6 +1527,8 @@ int p9_client_remove(struct p9_fid *fid)
 	clnt = fid->clnt;
 
 	req = p9_client_rpc(clnt, P9_TREMOVE, "d", fid->fid);
+	/* The parent directory is not known */
+	p9_cache_flush(clnt);
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
 		goto error;
@@ -1510,6 +1557,8 @@ int p9_client_unlinkat(struct p9_fid *dfid, const char *name, int flags)
 
 	clnt = dfid->clnt;
 	req = p9_client_rpc(clnt, P9_TUNLINKAT, "dsd", dfid->fid, name, flags);
+	/* Neither is the qid of the victim */
+	p9_cache_flush(clnt);
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
 		goto error;
@@ -1670,6 +1719,7 @@ p9_client_write(struct p9_fid *fid, u64 offset, struct iov_iter *from, int *err)
 		total += written;
 		offset += written;
 	}
+	p9_cache_invalidate(clnt, fid->qid.path);
 	return total;
 }
 EXPORT_SYMBOL(p9_client_write);
@@ -1697,6 +1747,7 @@ p9_client_write_subreq(struct netfs_io_subrequest *subreq)
 		req = p9_client_rpc(clnt, P9_TWRITE, "dqV", fid->fid,
 				    start, len, &subreq->io_iter);
 	}
+	p9_cache_invalidate(clnt, fid->qid.path);
 	if (IS_ERR(req)) {
 		netfs_write_subrequest_terminated(subreq, PTR_ERR(req), false);
 		return;
@@ -1780,6 +1831,7 @@ struct p9_stat_dotl *p9_client_getattr_dotl(struct p9_fid *fid,
 	struct p9_client *clnt;
 	struct p9_stat_dotl *ret;
 	struct p9_req_t *req;
+	unsigned long gen;
 
 	p9_debug(P9_DEBUG_9P, ">>> TGETATTR fid %d, request_mask %lld\n",
 		 fid->fid, request_mask);
@@ -1790,6 +1842,12 @@ struct p9_stat_dotl *p9_client_getattr_dotl(struct p9_fid *fid,
 
 	clnt = fid->clnt;
 
+	if (p9_cache_lookup_attr(clnt, fid->qid.path, request_mask, ret)) {
+		p9_debug(P9_DEBUG_9P, "<<< RGETATTR fid %d cached\n", fid->fid);
+		return ret;
+	}
+
+	gen = p9_cache_begin(clnt);
 	req = p9_client_rpc(clnt, P9_TGETATTR, "dq", fid->fid, request_mask);
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
@@ -1826,6 +1884,7 @@ struct p9_stat_dotl *p9_client_getattr_dotl(struct p9_fid *fid,
 		 ret->st_gen, ret->st_data_version);
 
 	p9_req_put(clnt, req);
+	p9_cache_store_attr(clnt, gen, fid->qid.path, request_mask, ret);
 	return ret;
 
 error:
@@ -1889,6 +1948,8 @@ int p9_client_wstat(struct p9_fid *fid, struct p9_wstat *wst)
 
 	req = p9_client_rpc(clnt, P9_TWSTAT, "dwS",
 			    fid->fid, wst->size + 2, wst);
+	/* May rename, whose old parent is not known */
+	p9_cache_flush(clnt);
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
 		goto error;
@@ -1921,6 +1982,7 @@ int p9_client_setattr(struct p9_fid *fid, struct p9_iattr_dotl *p9attr)
 		 p9attr->mtime_sec, p9attr->mtime_nsec);
 
 	req = p9_client_rpc(clnt, P9_TSETATTR, "dI", fid->fid, p9attr);
+	p9_cache_invalidate(clnt, fid->qid.path);
 
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
@@ -1983,6 +2045,8 @@ int p9_client_rename(struct p9_fid *fid,
 
 	req = p9_client_rpc(clnt, P9_TRENAME, "dds", fid->fid,
 			    newdirfid->fid, name);
+	/* The old parent is not known */
+	p9_cache_flush(clnt);
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
 		goto error;
@@ -2011,6 +2075,8 @@ int p9_client_renameat(struct p9_fid *olddirfid, const char *old_name,
 
 	req = p9_client_rpc(clnt, P9_TRENAMEAT, "dsds", olddirfid->fid,
 			    old_name, newdirfid->fid, new_name);
+	/* Nor is the qid of the renamed file, or of one it replaced */
+	p9_cache_flush(clnt);
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
 		goto error;
@@ -2085,6 +2151,7 @@ int p9_client_xattrcreate(struct p9_fid *fid, const char *name,
 	clnt = fid->clnt;
 	req = p9_client_rpc(clnt, P9_TXATTRCREATE, "dsqd",
 			    fid->fid, name, attr_size, flags);
+	p9_cache_invalidate(clnt, fid->qid.path);
 	if (IS_ERR(req)) {
 		err = PTR_ERR(req);
 		goto error;
@@ -2104,6 +2171,7 @@ int p9_client_readdir(struct p9_fid *fid, char *data, u32 count, u64 offset)
 	char *dataptr;
 	struct kvec kv = {.iov_base = data, .iov_len = count};
 	struct iov_iter to;
+	unsigned long gen;
 
 	iov_iter_kvec(&to, ITER_DEST, &kv, 1, count);
 
@@ -2119,6 +2187,14 @@ int p9_client_readdir(struct p9_fid *fid, char *data, u32 count, u64 offset)
 	if (count < rsize)
 		rsize = count;
 
+	err = p9_cache_lookup_dirents(clnt, fid->qid.path, offset, rsize, data);
+	if (err >= 0) {
+		p9_debug(P9_DEBUG_9P, "<<< RREADDIR count %d cached\n", err);
+		return err;
+	}
+
+	gen = p9_cache_begin(clnt);
+
 	/* Don't bother zerocopy for small IO (< 1024) */
 	if (clnt->trans_mod->zc_request && rsize > 1024) {
 		/* response header len is 11
@@ -2152,6 +2228,8 @@ int p9_client_readdir(struct p9_fid *fid, char *data, u32 count, u64 offset)
 		memmove(data, dataptr, count);
 
 	p9_req_put(clnt, req);
+	p9_cache_store_dirents(clnt, gen, fid->qid.path, offset, rsize, data,
+			       count);
 	return count;
 
 free_and_error:
@@ -2174,6 +2252,7 @@ int p9_client_mknod_dotl(struct p9_fid *fid, const char *name, int mode,
 		 fid->fid, name, mode, MAJOR(rdev), MINOR(rdev));
 	req = p9_client_rpc(clnt, P9_TMKNOD, "dsdddg", fid->fid, name, mode,
 			    MAJOR(rdev), MINOR(rdev), gid);
+	p9_cache_invalidate(clnt, fid->qid.path);
 	if (IS_ERR(req))
 		return PTR_ERR(req);
 
@@ -2203,6 +2282,7 @@ int p9_client_mkdir_dotl(struct p9_fid *fid, const char *name, int mode,
 		 fid->fid, name, mode, from_kgid(&init_user_ns, gid));
 	req = p9_client_rpc(clnt, P9_TMKDIR, "dsdg",
 			    fid->fid, name, mode, gid);
+	p9_cache_invalidate(clnt, fid->qid.path);
 	if (IS_ERR(req))
 		return PTR_ERR(req);
 
@@ -31,52 +31,85 @@
 #include <net/9p/transport.h>
 #include <linux/scatterlist.h>
 #include <linux/swap.h>
+#include <linux/interrupt.h>
 #include <linux/virtio.h>
 #include <linux/virtio_9p.h>
 #include "trans_common.h"
 
 #define VIRTQUEUE_NUM	128
 
+/*
+ * When the ring uses the DMA API, requests whose message and reply fit in
+ * half a buffer go through buffers mapped once at probe: the request is
+ * copied in and the reply out, instead of mapping and unmapping both around
+ * each request.  The first half of a buffer holds the request, the second the
+ * reply.  Such buffers are added with P9_VIRTIO_POOLED set in the token.
+ */
+#define P9_VIRTIO_POOL_NUM	(VIRTQUEUE_NUM / 2)
+#define P9_VIRTIO_POOL_SIZE	(2 * PAGE_SIZE)
+#define P9_VIRTIO_POOLED	0x1UL
+
 /* a single mutex to manage channel initialization and attachment */
 static DEFINE_MUTEX(virtio_9p_lock);
 static DECLARE_WAIT_QUEUE_HEAD(vp_wq);
 static atomic_t vp_pinned = ATOMIC_INIT(0);
 
+/**
+ * struct virtio_9p_vq - per-virtqueue transport information
+ * @lock: protects @vq, @ring_bufs_avail and @sg
+ * @vq: request virtqueue
+ * @ring_bufs_avail: flag to indicate there is some available in the ring buf
+ * @vc_wq: wait queue for waiting for thing to be added to ring buf
+ * @sg: scatter gather list which is used to pack a request
+ * @pool: premapped buffers for small requests, NULL if not used
+ * @name: name of the virtqueue
+ */
+
+struct virtio_9p_vq {
+	spinlock_t lock;
+	struct virtqueue *vq;
+	int ring_bufs_avail;
+	wait_queue_head_t vc_wq;
+	struct virtqueue_dma_pool *pool;
+	/* Scatterlist: can be too big for stack. */
+	struct scatterlist sg[VIRTQUEUE_NUM];
+	char name[16];
+} ____cacheline_aligned_in_smp;
+
 /**
  * struct virtio_chan - per-instance transport information
  * @inuse: whether the channel is in use
- * @lock: protects multiple elements within this structure
  * @client: client instance
  * @vdev: virtio dev associated with this channel
- * @vq: virtio queue associated with this channel
- * @ring_bufs_avail: flag to indicate there is some available in the ring buf
- * @vc_wq: wait queue for waiting for thing to be added to ring buf
+ * @num_vqs: number of request virtqueues
+ * @vqs: request virtqueues
+ * @cpu_vq: index in @vqs of the virtqueue each CPU submits requests on
  * @p9_max_pages: maximum number of pinned pages
- * @sg: scatter gather list which is used to pack a request (protected?)
  * @chan_list: linked list of channels
  *
  * We keep all per-channel information in a structure.
  * This structure is allocated within the devices dev->mem space.
  * A pointer to the structure will get put in the transport private.
  *
+ * The channel is built around an array of request virtqueues.  A
+ * request is submitted on the queue whose interrupt is routed to the
+ * submitting CPU, so that CPUs do not contend on one queue lock and the
+ * reply is completed on the CPU that sent the request.
+ *
  */
 
 struct virtio_chan {
 	bool inuse;
 
-	spinlock_t lock;
-
 	struct p9_client *client;
 	struct virtio_device *vdev;
-	struct virtqueue *vq;
-	int ring_bufs_avail;
-	wait_queue_head_t *vc_wq;
+	unsigned int num_vqs;
+	struct virtio_9p_vq *vqs;
+	unsigned int *cpu_vq;
 	/* This is global limit. Since we don't have a global structure,
 	 * will be placing it in each channel.
 	 */
 	unsigned long p9_max_pages;
-	/* Scatterlist: can be too big for stack. */
-	struct scatterlist sg[VIRTQUEUE_NUM];
 	/**
 	 * @tag: name to identify a mount null terminated
 	 */
@@ -87,6 +120,11 @@ struct virtio_chan {
 
 static struct list_head virtio_chan_list;
 
+static struct virtio_9p_vq *p9_virtio_vq(struct virtio_chan *chan)
+{
+	return &chan->vqs[chan->cpu_vq[raw_smp_processor_id()]];
+}
+
 /* How many bytes left in this page. */
 static unsigned int rest_of_page(void *data)
 {
@@ -112,6 +150,75 @@ static void p9_virtio_close(struct p9_client *client)
 	mutex_unlock(&virtio_9p_lock);
 }
 
+/*
+ * Take a premapped buffer for @req and copy the request to it, if the pool is
+ * used and the request is small enough.
+ */
+static struct virtqueue_dma_buf *p9_virtio_pool_get(struct virtio_9p_vq *pvq,
+						    struct p9_req_t *req)
+{
+	struct virtqueue_dma_buf *buf;
+
+	if (!pvq->pool || req->tc.size > P9_VIRTIO_POOL_SIZE / 2 ||
+	    req->rc.capacity > P9_VIRTIO_POOL_SIZE / 2)
+		return NULL;
+
+	buf = virtqueue_dma_pool_get(pvq->pool);
+	if (!buf)
+		return NULL;
+
+	buf->priv = req;
+	memcpy(buf->vaddr, req->tc.sdata, req->tc.size);
+	virtqueue_dma_sync_single_range_for_device(pvq->vq, buf->addr, 0,
+						   req->tc.size,
+						   DMA_BIDIRECTIONAL);
+	return buf;
+}
+
+/* Copy the reply out of a premapped buffer and give the buffer back */
+static struct p9_req_t *p9_virtio_pool_done(struct virtio_9p_vq *pvq,
+					    void *token, unsigned int len)
+{
+	struct virtqueue_dma_buf *buf;
+	struct p9_req_t *req;
+
+	buf = (void *)((unsigned long)token & ~P9_VIRTIO_POOLED);
+	req = buf->priv;
+
+	len = min_t(size_t, len, req->rc.capacity);
+	virtqueue_dma_sync_single_range_for_cpu(pvq->vq, buf->addr,
+						P9_VIRTIO_POOL_SIZE / 2, len,
+						DMA_BIDIRECTIONAL);
+	memcpy(req->rc.sdata, buf->vaddr + P9_VIRTIO_POOL_SIZE / 2, len);
+	virtqueue_dma_pool_put(pvq->pool, buf);
+	return req;
+}
+
+static void p9_virtio_pool_create(struct virtio_9p_vq *pvq)
+{
+	struct virtqueue_dma_pool *pool;
+
+	if (!virtqueue_dma_dev(pvq->vq))
+		return;
+
+	/* Not fatal, requests are just mapped one by one. */
+	pool = virtqueue_dma_pool_create(pvq->vq, P9_VIRTIO_POOL_NUM,
+					 P9_VIRTIO_POOL_SIZE,
+					 DMA_BIDIRECTIONAL);
+	if (!IS_ERR(pool))
+		pvq->pool = pool;
+}
+
+static void p9_virtio_pool_destroy(struct virtio_chan *chan)
+{
+	unsigned int i;
+
+	for (i = 0; i < chan->num_vqs; i++) {
+		virtqueue_dma_pool_destroy(chan->vqs[i].pool);
+		chan->vqs[i].pool = NULL;
+	}
+}
+
 /**
  * req_done - callback which signals activity from the server
  * @vq: virtio queue activity was received on
@@ -128,17 +235,24 @@ static void p9_virtio_close(struct p9_client *client)
 static void req_done(struct virtqueue *vq)
 {
 	struct virtio_chan *chan = vq->vdev->priv;
+	struct virtio_9p_vq *pvq = &chan->vqs[vq->index];
 	unsigned int len;
 	struct p9_req_t *req;
+	void *token;
 	bool need_wakeup = false;
 	unsigned long flags;
 
 	p9_debug(P9_DEBUG_TRANS, ": request done\n");
 
-	spin_lock_irqsave(&chan->lock, flags);
-	while ((req = virtqueue_get_buf(chan->vq, &len)) != NULL) {
-		if (!chan->ring_bufs_avail) {
-			chan->ring_bufs_avail = 1;
+	spin_lock_irqsave(&pvq->lock, flags);
+	while ((token = virtqueue_get_buf(pvq->vq, &len)) != NULL) {
+		if ((unsigned long)token & P9_VIRTIO_POOLED)
+			req = p9_virtio_pool_done(pvq, token, len);
+		else
+			req = token;
+
+		if (!pvq->ring_bufs_avail) {
+			pvq->ring_bufs_avail = 1;
 			need_wakeup = true;
 		}
 
@@ -147,10 +261,10 @@ static void req_done(struct virtqueue *vq)
 			p9_client_cb(chan->client, req, REQ_STATUS_RCVD);
 		}
 	}
-	spin_unlock_irqrestore(&chan->lock, flags);
+	spin_unlock_irqrestore(&pvq->lock, flags);
 	/* Wakeup if anyone waiting for VirtIO ring space. */
 	if (need_wakeup)
-		wake_up(chan->vc_wq);
+		wake_up(&pvq->vc_wq);
 }
 
 /**
@@ -258,48 +372,75 @@ p9_virtio_request(struct p9_client *client, struct p9_req_t *req)
 	int in, out, out_sgs, in_sgs;
 	unsigned long flags;
 	struct virtio_chan *chan = client->trans;
+	struct virtio_9p_vq *pvq = p9_virtio_vq(chan);
 	struct scatterlist *sgs[2];
+	struct scatterlist pool_sg[2];
+	struct virtqueue_dma_buf *buf;
 
 	p9_debug(P9_DEBUG_TRANS, "9p debug: virtio request\n");
 
 	WRITE_ONCE(req->status, REQ_STATUS_SENT);
+	buf = p9_virtio_pool_get(pvq, req);
 req_retry:
-	spin_lock_irqsave(&chan->lock, flags);
+	spin_lock_irqsave(&pvq->lock, flags);
 
 	out_sgs = in_sgs = 0;
+	if (buf) {
+		sg_init_one(&pool_sg[0], buf->vaddr, req->tc.size);
+		sg_dma_address(&pool_sg[0]) = buf->addr;
+		sg_dma_len(&pool_sg[0]) = req->tc.size;
+		sg_init_one(&pool_sg[1], buf->vaddr + P9_VIRTIO_POOL_SIZE / 2,
+			    req->rc.capacity);
+		sg_dma_address(&pool_sg[1]) = buf->addr + P9_VIRTIO_POOL_SIZE / 2;
+		sg_dma_len(&pool_sg[1]) = req->rc.capacity;
+		sgs[out_sgs++] = &pool_sg[0];
+		sgs[out_sgs + in_sgs++] = &pool_sg[1];
+
+		err = virtqueue_add_sgs_premapped(pvq->vq, sgs, out_sgs, in_sgs,
+				(void *)((unsigned long)buf | P9_VIRTIO_POOLED),
+				GFP_ATOMIC);
+		goto added;
+	}
+
 	/* Handle out VirtIO ring buffers */
-	out = pack_sg_list(chan->sg, 0,
+	out = pack_sg_list(pvq->sg, 0,
 			   VIRTQUEUE_NUM, req->tc.sdata, req->tc.size);
 	if (out)
-		sgs[out_sgs++] = chan->sg;
+		sgs[out_sgs++] = pvq->sg;
 
-	in = pack_sg_list(chan->sg, out,
+	in = pack_sg_list(pvq->sg, out,
 			  VIRTQUEUE_NUM, req->rc.sdata, req->rc.capacity);
 	if (in)
-		sgs[out_sgs + in_sgs++] = chan->sg + out;
+		sgs[out_sgs + in_sgs++] = pvq->sg + out;
 
-	err = virtqueue_add_sgs(chan->vq, sgs, out_sgs, in_sgs, req,
+	err = virtqueue_add_sgs(pvq->vq, sgs, out_sgs, in_sgs, req,
 				GFP_ATOMIC);
+added:
 	if (err < 0) {
 		if (err == -ENOSPC) {
-			chan->ring_bufs_avail = 0;
-			spin_unlock_irqrestore(&chan->lock, flags);
-			err = wait_event_killable(*chan->vc_wq,
-						  chan->ring_bufs_avail);
-			if (err  == -ERESTARTSYS)
+			pvq->ring_bufs_avail = 0;
+			spin_unlock_irqrestore(&pvq->lock, flags);
+			err = wait_event_killable(pvq->vc_wq,
+						  pvq->ring_bufs_avail);
+			if (err  == -ERESTARTSYS) {
+				if (buf)
+					virtqueue_dma_pool_put(pvq->pool, buf);
 				return err;
+			}
 
 			p9_debug(P9_DEBUG_TRANS, "Retry virtio request\n");
 			goto req_retry;
 		} else {
-			spin_unlock_irqrestore(&chan->lock, flags);
+			spin_unlock_irqrestore(&pvq->lock, flags);
 			p9_debug(P9_DEBUG_TRANS,
 				 "virtio rpc add_sgs returned failure\n");
+			if (buf)
+				virtqueue_dma_pool_put(pvq->pool, buf);
 			return -EIO;
 		}
 	}
-	virtqueue_kick(chan->vq);
-	spin_unlock_irqrestore(&chan->lock, flags);
+	virtqueue_kick(pvq->vq);
+	spin_unlock_irqrestore(&pvq->lock, flags);
 
 	p9_debug(P9_DEBUG_TRANS, "virtio request kicked\n");
 	return 0;
@@ -427,6 +568,7 @@ p9_virtio_zc_request(struct p9_client *client, struct p9_req_t *req,
 	int in_nr_pages = 0, out_nr_pages = 0;
 	struct page **in_pages = NULL, **out_pages = NULL;
 	struct virtio_chan *chan = client->trans;
+	struct virtio_9p_vq *pvq;
 	struct scatterlist *sgs[4];
 	size_t offs = 0;
 	int need_drop = 0;
@@ -469,21 +611,22 @@ p9_virtio_zc_request(struct p9_client *client, struct p9_req_t *req,
 		}
 	}
 	WRITE_ONCE(req->status, REQ_STATUS_SENT);
+	pvq = p9_virtio_vq(chan);
 req_retry_pinned:
-	spin_lock_irqsave(&chan->lock, flags);
+	spin_lock_irqsave(&pvq->lock, flags);
 
 	out_sgs = in_sgs = 0;
 
 	/* out data */
-	out = pack_sg_list(chan->sg, 0,
+	out = pack_sg_list(pvq->sg, 0,
 			   VIRTQUEUE_NUM, req->tc.sdata, req->tc.size);
 
 	if (out)
-		sgs[out_sgs++] = chan->sg;
+		sgs[out_sgs++] = pvq->sg;
 
 	if (out_pages) {
-		sgs[out_sgs++] = chan->sg + out;
-		out += pack_sg_list_p(chan->sg, out, VIRTQUEUE_NUM,
+		sgs[out_sgs++] = pvq->sg + out;
+		out += pack_sg_list_p(pvq->sg, out, VIRTQUEUE_NUM,
 				      out_pages, out_nr_pages, offs, outlen);
 	}
 
@@ -494,41 +637,41 @@ p9_virtio_zc_request(struct p9_client *client, struct p9_req_t *req,
 	 * Arrange in such a way that server places header in the
 	 * allocated memory and payload onto the user buffer.
 	 */
-	in = pack_sg_list(chan->sg, out,
+	in = pack_sg_list(pvq->sg, out,
 			  VIRTQUEUE_NUM, req->rc.sdata, in_hdr_len);
 	if (in)
-		sgs[out_sgs + in_sgs++] = chan->sg + out;
+		sgs[out_sgs + in_sgs++] = pvq->sg + out;
 
 	if (in_pages) {
-		sgs[out_sgs + in_sgs++] = chan->sg + out + in;
-		pack_sg_list_p(chan->sg, out + in, VIRTQUEUE_NUM,
+		sgs[out_sgs + in_sgs++] = pvq->sg + out + in;
+		pack_sg_list_p(pvq->sg, out + in, VIRTQUEUE_NUM,
 			       in_pages, in_nr_pages, offs, inlen);
 	}
 
 	BUG_ON(out_sgs + in_sgs > ARRAY_SIZE(sgs));
-	err = virtqueue_add_sgs(chan->vq, sgs, out_sgs, in_sgs, req,
+	err = virtqueue_add_sgs(pvq->vq, sgs, out_sgs, in_sgs, req,
 				GFP_ATOMIC);
 	if (err < 0) {
 		if (err == -ENOSPC) {
-			chan->ring_bufs_avail = 0;
-			spin_unlock_irqrestore(&chan->lock, flags);
-			err = wait_event_killable(*chan->vc_wq,
-						  chan->ring_bufs_avail);
+			pvq->ring_bufs_avail = 0;
+			spin_unlock_irqrestore(&pvq->lock, flags);
+			err = wait_event_killable(pvq->vc_wq,
+						  pvq->ring_bufs_avail);
 			if (err  == -ERESTARTSYS)
 				goto err_out;
 
 			p9_debug(P9_DEBUG_TRANS, "Retry virtio request\n");
 			goto req_retry_pinned;
 		} else {
-			spin_unlock_irqrestore(&chan->lock, flags);
+			spin_unlock_irqrestore(&pvq->lock, flags);
 			p9_debug(P9_DEBUG_TRANS,
 				 "virtio rpc add_sgs returned failure\n");
 			err = -EIO;
 			goto err_out;
 		}
 	}
-	virtqueue_kick(chan->vq);
-	spin_unlock_irqrestore(&chan->lock, flags);
+	virtqueue_kick(pvq->vq);
+	spin_unlock_irqrestore(&pvq->lock, flags);
 	kicked = 1;
 	p9_debug(P9_DEBUG_TRANS, "virtio request kicked\n");
 	err = wait_event_killable(req->wq,
@@ -581,6 +724,92 @@ static ssize_t p9_mount_tag_show(struct device *dev,
 
 static DEVICE_ATTR(mount_tag, 0444, p9_mount_tag_show, NULL);
 
+/**
+ * p9_virtio_find_vqs - set up the request virtqueues of a channel
+ * @chan: channel being probed
+ *
+ * Returns 0 on success.  On failure the caller frees @chan->vqs and
+ * @chan->cpu_vq.
+ *
+ */
+
+static int p9_virtio_find_vqs(struct virtio_chan *chan)
+{
+	struct virtio_device *vdev = chan->vdev;
+	struct irq_affinity desc = { 0, };
+	struct virtqueue_info *vqs_info;
+	struct virtqueue **vqs;
+	unsigned int num_vqs;
+	unsigned int i, cpu;
+	int err;
+
+	/*
+	 * The virtio spec defines no way for a 9p device to advertise more
+	 * than one request queue, so there is a single one for now.
+	 */
+	num_vqs = 1;
+
+	chan->vqs = kcalloc(num_vqs, sizeof(*chan->vqs), GFP_KERNEL);
+	chan->cpu_vq = kcalloc(nr_cpu_ids, sizeof(*chan->cpu_vq), GFP_KERNEL);
+	vqs_info = kcalloc(num_vqs, sizeof(*vqs_info), GFP_KERNEL);
+	vqs = kcalloc(num_vqs, sizeof(*vqs), GFP_KERNEL);
+	if (!chan->vqs || !chan->cpu_vq || !vqs_info || !vqs) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < num_vqs; i++) {
+		if (num_vqs == 1)
+			strscpy(chan->vqs[i].name, "requests");
+		else
+			snprintf(chan->vqs[i].name, sizeof(chan->vqs[i].name),
+				 "requests.%u", i);
+		vqs_info[i].name = chan->vqs[i].name;
+		vqs_info[i].callback = req_done;
+	}
+
+	/* Let the transport spread the queue interrupts over the CPUs. */
+	err = virtio_find_vqs(vdev, num_vqs, vqs, vqs_info,
+			      num_vqs > 1 ? &desc : NULL);
+	if (err)
+		goto out;
+
+	for (i = 0; i < num_vqs; i++) {
+		struct virtio_9p_vq *pvq = &chan->vqs[i];
+
+		spin_lock_init(&pvq->lock);
+		pvq->vq = vqs[i];
+		pvq->ring_bufs_avail = 1;
+		init_waitqueue_head(&pvq->vc_wq);
+		sg_init_table(pvq->sg, VIRTQUEUE_NUM);
+		p9_virtio_pool_create(pvq);
+	}
+	chan->num_vqs = num_vqs;
+
+	/*
+	 * Submit on the queue whose interrupt goes to the submitting CPU, so
+	 * the reply comes back there.  Without affinity information just
+	 * spread the CPUs over the queues.
+	 */
+	for_each_possible_cpu(cpu)
+		chan->cpu_vq[cpu] = cpu % num_vqs;
+	if (num_vqs > 1 && vdev->config->get_vq_affinity) {
+		for (i = 0; i < num_vqs; i++) {
+			const struct cpumask *mask;
+
+			mask = vdev->config->get_vq_affinity(vdev, i);
+			if (!mask)
+				continue;
+			for_each_cpu(cpu, mask)
+				chan->cpu_vq[cpu] = i;
+		}
+	}
+out:
+	kfree(vqs);
+	kfree(vqs_info);
+	return err;
+}
+
 /**
  * p9_virtio_probe - probe for existence of 9P virtio channels
  * @vdev: virtio device to probe
@@ -602,7 +831,7 @@ static int p9_virtio_probe(struct virtio_device *vdev)
 		return -EINVAL;
 	}
 
-	chan = kmalloc(sizeof(struct virtio_chan), GFP_KERNEL);
+	chan = kzalloc(sizeof(struct virtio_chan), GFP_KERNEL);
 	if (!chan) {
 		pr_err("Failed to allocate virtio 9P channel\n");
 		err = -ENOMEM;
@@ -610,45 +839,32 @@ static int p9_virtio_probe(struct virtio_device *vdev)
 	}
 
 	chan->vdev = vdev;
-
-	/* We expect one virtqueue, for requests. */
-	chan->vq = virtio_find_single_vq(vdev, req_done, "requests");
-	if (IS_ERR(chan->vq)) {
-		err = PTR_ERR(chan->vq);
-		goto out_free_chan;
-	}
-	chan->vq->vdev->priv = chan;
-	spin_lock_init(&chan->lock);
-
-	sg_init_table(chan->sg, VIRTQUEUE_NUM);
-
 	chan->inuse = false;
 	if (virtio_has_feature(vdev, VIRTIO_9P_MOUNT_TAG)) {
 		virtio_cread(vdev, struct virtio_9p_config, tag_len, &tag_len);
 	} else {
 		err = -EINVAL;
-		goto out_free_vq;
+		goto out_free_chan;
 	}
 	tag = kzalloc(tag_len + 1, GFP_KERNEL);
 	if (!tag) {
 		err = -ENOMEM;
-		goto out_free_vq;
+		goto out_free_chan;
 	}
 
 	virtio_cread_bytes(vdev, offsetof(struct virtio_9p_config, tag),
 			   tag, tag_len);
 	chan->tag = tag;
+
+	err = p9_virtio_find_vqs(chan);
+	if (err)
+		goto out_free_tag;
+	vdev->priv = chan;
+
 	err = sysfs_create_file(&(vdev->dev.kobj), &dev_attr_mount_tag.attr);
 	if (err) {
-		goto out_free_tag;
-	}
-	chan->vc_wq = kmalloc(sizeof(wait_queue_head_t), GFP_KERNEL);
-	if (!chan->vc_wq) {
-		err = -ENOMEM;
-		goto out_remove_file;
+		goto out_free_vq;
 	}
-	init_waitqueue_head(chan->vc_wq);
-	chan->ring_bufs_avail = 1;
 	/* Ceiling limit to avoid denial of service attacks */
 	chan->p9_max_pages = nr_free_buffer_pages()/4;
 
@@ -663,19 +879,19 @@ static int p9_virtio_probe(struct virtio_device *vdev)
 
 	return 0;
 
-out_remove_file:
-	sysfs_remove_file(&vdev->dev.kobj, &dev_attr_mount_tag.attr);
-out_free_tag:
-	kfree(tag);
 out_free_vq:
+	p9_virtio_pool_destroy(chan);
 	vdev->config->del_vqs(vdev);
+out_free_tag:
+	kfree(chan->cpu_vq);
+	kfree(chan->vqs);
+	kfree(tag);
 out_free_chan:
 	kfree(chan);
 fail:
 	return err;
 }
 
-
 /**
  * p9_virtio_create - allocate a new virtio channel
  * @client: client instance invoking this transport
@@ -757,12 +973,14 @@ static void p9_virtio_remove(struct virtio_device *vdev)
 	mutex_unlock(&virtio_9p_lock);
 
 	virtio_reset_device(vdev);
+	p9_virtio_pool_destroy(chan);
 	vdev->config->del_vqs(vdev);
 
 	sysfs_remove_file(&(vdev->dev.kobj), &dev_attr_mount_tag.attr);
 	kobject_uevent(&(vdev->dev.kobj), KOBJ_CHANGE);
 	kfree(chan->tag);
-	kfree(chan->vc_wq);
+	kfree(chan->cpu_vq);
+	kfree(chan->vqs);
 	kfree(chan);
 
 }
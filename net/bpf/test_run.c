@@ -108,8 +108,17 @@ struct xdp_page_head {
 	};
 };
 
+/* Packets replayed with BPF_F_TEST_XDP_MULTI_FRAMES */
+struct xdp_test_pkts {
+	void *buf;
+	u32 *offs;
+	u32 cnt;
+};
+
 struct xdp_test_data {
 	struct xdp_buff *orig_ctx;
+	const struct xdp_test_pkts *pkts;
+	u32 next_pkt;
 	struct xdp_rxq_info rxq;
 	struct net_device *dev;
 	struct page_pool *pp;
@@ -126,27 +135,22 @@ struct xdp_test_data {
  */
 #define TEST_XDP_FRAME_SIZE (PAGE_SIZE - sizeof(struct xdp_page_head))
 #define TEST_XDP_MAX_BATCH 256
+#define TEST_XDP_MAX_PKTS_SIZE (1 << 24)
 
-static void xdp_test_run_init_page(netmem_ref netmem, void *arg)
+static void xdp_test_init_head(struct xdp_test_data *xdp,
+			       struct xdp_page_head *head,
+			       const void *data_meta, size_t frm_len,
+			       size_t meta_len)
 {
-	struct xdp_page_head *head =
-		phys_to_virt(page_to_phys(netmem_to_page(netmem)));
-	struct xdp_buff *new_ctx, *orig_ctx;
-	u32 headroom = XDP_PACKET_HEADROOM;
-	struct xdp_test_data *xdp = arg;
-	size_t frm_len, meta_len;
+	u32 headroom = XDP_PACKET_HEADROOM - meta_len;
+	struct xdp_buff *new_ctx;
 	struct xdp_frame *frm;
 	void *data;
 
-	orig_ctx = xdp->orig_ctx;
-	frm_len = orig_ctx->data_end - orig_ctx->data_meta;
-	meta_len = orig_ctx->data - orig_ctx->data_meta;
-	headroom -= meta_len;
-
 	new_ctx = &head->ctx;
 	frm = head->frame;
 	data = head->data;
-	memcpy(data + headroom, orig_ctx->data_meta, frm_len);
+	memcpy(data + headroom, data_meta, frm_len);
 
 	xdp_init_buff(new_ctx, TEST_XDP_FRAME_SIZE, &xdp->rxq);
 	xdp_prepare_buff(new_ctx, data, headroom, frm_len, true);
@@ -158,6 +162,32 @@ static void xdp_test_run_init_page(netmem_ref netmem, void *arg)
 	memcpy(&head->orig_ctx, new_ctx, sizeof(head->orig_ctx));
 }
 
+static void xdp_test_run_init_page(netmem_ref netmem, void *arg)
+{
+	struct xdp_page_head *head =
+		phys_to_virt(page_to_phys(netmem_to_page(netmem)));
+	struct xdp_test_data *xdp = arg;
+	struct xdp_buff *orig_ctx = xdp->orig_ctx;
+
+	xdp_test_init_head(xdp, head, orig_ctx->data_meta,
+			   orig_ctx->data_end - orig_ctx->data_meta,
+			   orig_ctx->data - orig_ctx->data_meta);
+}
+
+/* Pages are recycled, so the next packet is copied in on every run,
+ * much like a NIC would write it.
+ */
+static void xdp_test_load_pkt(struct xdp_test_data *xdp,
+			      struct xdp_page_head *head)
+{
+	const struct xdp_test_pkts *pkts = xdp->pkts;
+	void *rec = pkts->buf + pkts->offs[xdp->next_pkt];
+
+	xdp_test_init_head(xdp, head, rec + sizeof(u32), *(u32 *)rec, 0);
+	if (++xdp->next_pkt == pkts->cnt)
+		xdp->next_pkt = 0;
+}
+
 static int xdp_test_run_setup(struct xdp_test_data *xdp, struct xdp_buff *orig_ctx)
 {
 	struct page_pool *pp;
@@ -310,7 +340,10 @@ static int xdp_test_run_batch(struct xdp_test_data *xdp, struct bpf_prog *prog,
 		}
 
 		head = phys_to_virt(page_to_phys(page));
-		reset_ctx(head);
+		if (xdp->pkts)
+			xdp_test_load_pkt(xdp, head);
+		else
+			reset_ctx(head);
 		ctx = &head->ctx;
 		frm = head->frame;
 		xdp->frame_cnt++;
@@ -370,10 +403,11 @@ static int xdp_test_run_batch(struct xdp_test_data *xdp, struct bpf_prog *prog,
 }
 
 static int bpf_test_run_xdp_live(struct bpf_prog *prog, struct xdp_buff *ctx,
+				 const struct xdp_test_pkts *pkts,
 				 u32 repeat, u32 batch_size, u32 *time)
 
 {
-	struct xdp_test_data xdp = { .batch_size = batch_size };
+	struct xdp_test_data xdp = { .batch_size = batch_size, .pkts = pkts };
 	struct bpf_test_timer t = { .mode = NO_MIGRATE };
 	int ret;
 
@@ -1198,10 +1232,73 @@ static void xdp_convert_buff_to_md(struct xdp_buff *xdp, struct xdp_md *xdp_md)
 		dev_put(xdp->rxq->dev);
 }
 
+static void xdp_test_pkts_free(struct xdp_test_pkts *pkts)
+{
+	kvfree(pkts->buf);
+	kvfree(pkts->offs);
+}
+
+/* Copy in and index the packets of a BPF_F_TEST_XDP_MULTI_FRAMES run */
+static int xdp_test_pkts_init(const union bpf_attr *kattr,
+			      struct xdp_test_pkts *pkts, u32 max_data_sz)
+{
+	void __user *data_in = u64_to_user_ptr(kattr->test.data_in);
+	u32 size = kattr->test.data_size_in;
+	u32 off, len = 0, i;
+
+	if (size < sizeof(u32) + ETH_HLEN || size > TEST_XDP_MAX_PKTS_SIZE)
+		return -EINVAL;
+
+	pkts->buf = kvmalloc(size, GFP_USER);
+	if (!pkts->buf)
+		return -ENOMEM;
+
+	if (copy_from_user(pkts->buf, data_in, size))
+		return -EFAULT;
+
+	for (off = 0; off < size; off += sizeof(u32) + round_up(len, 4)) {
+		if (size - off < sizeof(u32))
+			return -EINVAL;
+		len = *(u32 *)(pkts->buf + off);
+		if (len < ETH_HLEN || len > max_data_sz ||
+		    len > size - off - sizeof(u32))
+			return -EINVAL;
+		pkts->cnt++;
+	}
+
+	pkts->offs = kvmalloc_array(pkts->cnt, sizeof(*pkts->offs), GFP_USER);
+	if (!pkts->offs)
+		return -ENOMEM;
+
+	for (off = 0, i = 0; i < pkts->cnt; i++) {
+		pkts->offs[i] = off;
+		len = *(u32 *)(pkts->buf + off);
+		off += sizeof(u32) + round_up(len, 4);
+	}
+
+	return 0;
+}
+
+/* The first packet also serves as the usual template */
+static void *xdp_test_pkts_first(const struct xdp_test_pkts *pkts, u32 *size,
+				 u32 headroom, u32 tailroom)
+{
+	void *data;
+
+	*size = *(u32 *)pkts->buf;
+	data = kzalloc(SKB_DATA_ALIGN(*size) + headroom + tailroom, GFP_USER);
+	if (!data)
+		return ERR_PTR(-ENOMEM);
+
+	memcpy(data + headroom, pkts->buf + sizeof(u32), *size);
+	return data;
+}
+
 int bpf_prog_test_run_xdp(struct bpf_prog *prog, const union bpf_attr *kattr,
 			  union bpf_attr __user *uattr)
 {
 	bool do_live = (kattr->test.flags & BPF_F_TEST_XDP_LIVE_FRAMES);
+	bool do_multi = (kattr->test.flags & BPF_F_TEST_XDP_MULTI_FRAMES);
 	u32 tailroom = SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
 	u32 batch_size = kattr->test.batch_size;
 	u32 retval = 0, duration, max_data_sz;
@@ -1210,6 +1307,7 @@ int bpf_prog_test_run_xdp(struct bpf_prog *prog, const union bpf_attr *kattr,
 	u32 repeat = kattr->test.repeat;
 	struct netdev_rx_queue *rxqueue;
 	struct skb_shared_info *sinfo;
+	struct xdp_test_pkts pkts = {};
 	struct xdp_buff xdp = {};
 	int i, ret = -EINVAL;
 	struct xdp_md *ctx;
@@ -1219,7 +1317,11 @@ int bpf_prog_test_run_xdp(struct bpf_prog *prog, const union bpf_attr *kattr,
 	    prog->expected_attach_type == BPF_XDP_CPUMAP)
 		return -EINVAL;
 
-	if (kattr->test.flags & ~BPF_F_TEST_XDP_LIVE_FRAMES)
+	if (kattr->test.flags & ~(BPF_F_TEST_XDP_LIVE_FRAMES |
+				  BPF_F_TEST_XDP_MULTI_FRAMES))
+		return -EINVAL;
+
+	if (do_multi && !do_live)
 		return -EINVAL;
 
 	if (bpf_prog_is_dev_bound(prog->aux))
@@ -1242,7 +1344,7 @@ int bpf_prog_test_run_xdp(struct bpf_prog *prog, const union bpf_attr *kattr,
 
 	if (ctx) {
 		/* There can't be user provided data before the meta data */
-		if (ctx->data_meta || ctx->data_end != size ||
+		if (do_multi || ctx->data_meta || ctx->data_end != size ||
 		    ctx->data > ctx->data_end ||
 		    unlikely(xdp_metalen_invalid(ctx->data)) ||
 		    (do_live && (kattr->test.data_out || kattr->test.ctx_out)))
@@ -1252,14 +1354,20 @@ int bpf_prog_test_run_xdp(struct bpf_prog *prog, const union bpf_attr *kattr,
 	}
 
 	max_data_sz = 4096 - headroom - tailroom;
-	if (size > max_data_sz) {
+	if (do_multi) {
+		ret = xdp_test_pkts_init(kattr, &pkts, max_data_sz);
+		if (ret)
+			goto free_ctx;
+		data = xdp_test_pkts_first(&pkts, &size, headroom, tailroom);
+	} else if (size > max_data_sz) {
 		/* disallow live data mode for jumbo frames */
 		if (do_live)
 			goto free_ctx;
 		size = max_data_sz;
 	}
 
-	data = bpf_test_init(kattr, size, max_data_sz, headroom, tailroom);
+	if (!do_multi)
+		data = bpf_test_init(kattr, size, max_data_sz, headroom, tailroom);
 	if (IS_ERR(data)) {
 		ret = PTR_ERR(data);
 		goto free_ctx;
@@ -1275,7 +1383,7 @@ int bpf_prog_test_run_xdp(struct bpf_prog *prog, const union bpf_attr *kattr,
 	if (ret)
 		goto free_data;
 
-	if (unlikely(kattr->test.data_size_in > size)) {
+	if (unlikely(!do_multi && kattr->test.data_size_in > size)) {
 		void __user *data_in = u64_to_user_ptr(kattr->test.data_in);
 
 		while (size < kattr->test.data_size_in) {
@@ -1315,7 +1423,8 @@ int bpf_prog_test_run_xdp(struct bpf_prog *prog, const union bpf_attr *kattr,
 		bpf_prog_change_xdp(NULL, prog);
 
 	if (do_live)
-		ret = bpf_test_run_xdp_live(prog, &xdp, repeat, batch_size, &duration);
+		ret = bpf_test_run_xdp_live(prog, &xdp, do_multi ? &pkts : NULL,
+					    repeat, batch_size, &duration);
 	else
 		ret = bpf_test_run(prog, &xdp, repeat, &retval, &duration, true);
 	/* We convert the xdp_buff back to an xdp_md before checking the return
@@ -1341,6 +1450,7 @@ int bpf_prog_test_run_xdp(struct bpf_prog *prog, const union bpf_attr *kattr,
 		__free_page(skb_frag_page(&sinfo->frags[i]));
 	kfree(data);
 free_ctx:
+	xdp_test_pkts_free(&pkts);
 	kfree(ctx);
 	return ret;
 }
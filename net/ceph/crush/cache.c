@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Cache of CRUSH mapping results.
+ *
+ * crush_do_rule() is a pure function of the map, the rule, the input
+ * and the weight vector, and hot PGs map the same inputs over and over
+ * between two map changes. Results are kept in a direct-mapped table
+ * that is read locklessly; a generation number, bumped by the owner on
+ * every map or weight change, invalidates it all at once.
+ */
+
+#include <linux/slab.h>
+#include <linux/hash.h>
+#include <linux/seqlock.h>
+#include <linux/atomic.h>
+#include <linux/crush/crush.h>
+#include <linux/crush/mapper.h>
+
+struct crush_cache_entry {
+	seqlock_t lock;
+	unsigned int gen;	/* 0 if empty */
+	int ruleno;
+	int x;
+	int result_max;
+	const struct crush_choose_arg *choose_args;
+	int result_len;
+	int result[CRUSH_CACHE_RESULT_MAX];
+};
+
+struct crush_cache {
+	atomic_t gen;
+	unsigned int order;
+	struct crush_cache_entry entries[];
+};
+
+/**
+ * crush_cache_create - allocate an empty mapping cache
+ * @order: log2 of the number of cached mappings
+ */
+struct crush_cache *crush_cache_create(unsigned int order)
+{
+	struct crush_cache *cache;
+	unsigned int i;
+
+	cache = kvzalloc(struct_size(cache, entries, 1U << order), GFP_NOIO);
+	if (!cache)
+		return NULL;
+
+	atomic_set(&cache->gen, 1);
+	cache->order = order;
+	for (i = 0; i < 1U << order; i++)
+		seqlock_init(&cache->entries[i].lock);
+	return cache;
+}
+
+void crush_cache_destroy(struct crush_cache *cache)
+{
+	kvfree(cache);
+}
+
+/**
+ * crush_cache_invalidate - forget all cached mappings
+ * @cache: the cache
+ *
+ * Must be called whenever the map, the weight vector or the choose_args
+ * the cached mappings were computed with change.
+ */
+void crush_cache_invalidate(struct crush_cache *cache)
+{
+	/* Skip 0, it marks empty entries */
+	if (atomic_inc_return(&cache->gen) == 0)
+		atomic_inc(&cache->gen);
+}
+
+static struct crush_cache_entry *crush_cache_slot(struct crush_cache *cache,
+						  int ruleno, int x)
+{
+	u32 h = hash_32((u32)x ^ ((u32)ruleno << 24), cache->order);
+
+	return &cache->entries[h];
+}
+
+static bool crush_cache_match(const struct crush_cache_entry *e,
+			      unsigned int gen, int ruleno, int x,
+			      int result_max,
+			      const struct crush_choose_arg *choose_args)
+{
+	return e->gen == gen && e->ruleno == ruleno && e->x == x &&
+	       e->result_max == result_max && e->choose_args == choose_args;
+}
+
+static int crush_cache_lookup(struct crush_cache *cache, unsigned int gen,
+			      int ruleno, int x, int *result, int result_max,
+			      const struct crush_choose_arg *choose_args)
+{
+	struct crush_cache_entry *e = crush_cache_slot(cache, ruleno, x);
+	unsigned int seq;
+	int len;
+
+	do {
+		seq = read_seqbegin(&e->lock);
+		if (!crush_cache_match(e, gen, ruleno, x, result_max,
+				       choose_args)) {
+			len = -1;
+			continue;
+		}
+		/* May be torn by a concurrent store, retried below */
+		len = READ_ONCE(e->result_len);
+		if (len < 0 || len > result_max) {
+			len = -1;
+			continue;
+		}
+		memcpy(result, e->result, len * sizeof(*result));
+	} while (read_seqretry(&e->lock, seq));
+
+	return len;
+}
+
+static void crush_cache_store(struct crush_cache *cache, unsigned int gen,
+			      int ruleno, int x, const int *result,
+			      int result_len, int result_max,
+			      const struct crush_choose_arg *choose_args)
+{
+	struct crush_cache_entry *e = crush_cache_slot(cache, ruleno, x);
+
+	write_seqlock(&e->lock);
+	e->gen = gen;
+	e->ruleno = ruleno;
+	e->x = x;
+	e->result_max = result_max;
+	e->choose_args = choose_args;
+	e->result_len = result_len;
+	memcpy(e->result, result, result_len * sizeof(*result));
+	write_sequnlock(&e->lock);
+}
+
+/**
+ * crush_do_rule_cached - crush_do_rule(), going through a mapping cache
+ * @cache: the cache, or NULL
+ *
+ * See crush_do_rule() for the other arguments. Results larger than
+ * CRUSH_CACHE_RESULT_MAX are never cached.
+ */
+int crush_do_rule_cached(struct crush_cache *cache,
+			 const struct crush_map *map,
+			 int ruleno, int x, int *result, int result_max,
+			 const __u32 *weight, int weight_max,
+			 void *cwin, const struct crush_choose_arg *choose_args)
+{
+	unsigned int gen;
+	int len;
+
+	if (!cache || result_max > CRUSH_CACHE_RESULT_MAX)
+		return crush_do_rule(map, ruleno, x, result, result_max,
+				     weight, weight_max, cwin, choose_args);
+
+	gen = atomic_read(&cache->gen);
+	len = crush_cache_lookup(cache, gen, ruleno, x, result, result_max,
+				 choose_args);
+	if (len >= 0)
+		return len;
+
+	len = crush_do_rule(map, ruleno, x, result, result_max, weight,
+			    weight_max, cwin, choose_args);
+	crush_cache_store(cache, gen, ruleno, x, result, len, result_max,
+			  choose_args);
+	return len;
+}
+
+/**
+ * crush_do_rule_batch - map several inputs with the same rule
+ * @cache: mapping cache, or NULL
+ * @map: the crush_map
+ * @ruleno: the rule id
+ * @x: @nr hash inputs
+ * @nr: number of inputs
+ * @results: @nr result vectors of @result_max entries each
+ * @result_lens: filled with the @nr result sizes
+ * @result_max: maximum result size
+ * @weight: weight vector (for map leaves)
+ * @weight_max: size of weight vector
+ * @cwin: pointer to at least crush_work_size() bytes of memory
+ * @choose_args: weights and ids for each known bucket
+ *
+ * The workspace and the caller's map locking are shared by the whole
+ * batch.
+ */
+void crush_do_rule_batch(struct crush_cache *cache,
+			 const struct crush_map *map, int ruleno,
+			 const int *x, int nr, int *results, int *result_lens,
+			 int result_max, const __u32 *weight, int weight_max,
+			 void *cwin, const struct crush_choose_arg *choose_args)
+{
+	int i;
+
+	for (i = 0; i < nr; i++)
+		result_lens[i] = crush_do_rule_cached(cache, map, ruleno, x[i],
+						      results + i * result_max,
+						      result_max, weight,
+						      weight_max, cwin,
+						      choose_args);
+}
@@ -480,6 +480,77 @@ static void handshake_req_destroy_test1(struct kunit *test)
 	KUNIT_EXPECT_PTR_EQ(test, handshake_req_destroy_test, req);
 }
 
+static void handshake_session_test1(struct kunit *test)
+{
+	static const u8 ticket[] = { 0x01, 0x02, 0x03, 0x04 };
+	struct handshake_session *hs;
+	struct handshake_net *hn;
+	int err;
+
+	/* Arrange */
+	hn = handshake_pernet(&init_net);
+	KUNIT_ASSERT_NOT_NULL(test, hn);
+
+	err = handshake_session_save(hn, "server.example", HANDSHAKE_AUTH_X509,
+				     42, 7, ticket, sizeof(ticket), 0);
+	KUNIT_ASSERT_EQ(test, err, 0);
+
+	/* Act */
+	hs = handshake_session_take(hn, "server.example", HANDSHAKE_AUTH_X509,
+				    42, 7);
+
+	/* Assert */
+	KUNIT_ASSERT_NOT_NULL(test, hs);
+	KUNIT_EXPECT_EQ(test, hs->hs_len, sizeof(ticket));
+	KUNIT_EXPECT_MEMEQ(test, hs->hs_data, ticket, sizeof(ticket));
+	handshake_session_free(hs);
+
+	/* Session data is handed out only once */
+	hs = handshake_session_take(hn, "server.example", HANDSHAKE_AUTH_X509,
+				    42, 7);
+	KUNIT_EXPECT_NULL(test, hs);
+}
+
+KUNIT_DEFINE_ACTION_WRAPPER(handshake_session_flush_action,
+			    handshake_session_flush, struct handshake_net *);
+
+static void handshake_session_test2(struct kunit *test)
+{
+	static const u8 ticket[] = { 0x01, 0x02, 0x03, 0x04 };
+	struct handshake_session *hs;
+	struct handshake_net *hn;
+	int err;
+
+	/* Arrange */
+	hn = handshake_pernet(&init_net);
+	KUNIT_ASSERT_NOT_NULL(test, hn);
+	err = kunit_add_action_or_reset(test, handshake_session_flush_action,
+					hn);
+	KUNIT_ASSERT_EQ(test, err, 0);
+
+	err = handshake_session_save(hn, "server.example", HANDSHAKE_AUTH_X509,
+				     42, 7, ticket, sizeof(ticket), 0);
+	KUNIT_ASSERT_EQ(test, err, 0);
+
+	/* Act */
+	hs = handshake_session_take(hn, "server.example", HANDSHAKE_AUTH_X509,
+				    43, 7);
+
+	/* Assert */
+	KUNIT_EXPECT_NULL(test, hs);
+	hs = handshake_session_take(hn, "server.example", HANDSHAKE_AUTH_PSK,
+				    42, 7);
+	KUNIT_EXPECT_NULL(test, hs);
+	hs = handshake_session_take(hn, "other.example", HANDSHAKE_AUTH_X509,
+				    42, 7);
+	KUNIT_EXPECT_NULL(test, hs);
+
+	/* Another consumer's trust anchors must not resume this session */
+	hs = handshake_session_take(hn, "server.example", HANDSHAKE_AUTH_X509,
+				    42, 8);
+	KUNIT_EXPECT_NULL(test, hs);
+}
+
 static struct kunit_case handshake_api_test_cases[] = {
 	{
 		.name			= "req_alloc API fuzzing",
@@ -526,6 +597,14 @@ static struct kunit_case handshake_api_test_cases[] = {
 		.name			= "req_destroy works",
 		.run_case		= handshake_req_destroy_test1,
 	},
+	{
+		.name			= "session_take is one-shot",
+		.run_case		= handshake_session_test1,
+	},
+	{
+		.name			= "session_take matches the whole key",
+		.run_case		= handshake_session_test2,
+	},
 	{}
 };
 
@@ -10,6 +10,9 @@
 #ifndef _INTERNAL_HANDSHAKE_H
 #define _INTERNAL_HANDSHAKE_H
 
+#include <linux/hashtable.h>
+#include <linux/key.h>
+
 /* Per-net namespace context */
 struct handshake_net {
 	spinlock_t		hn_lock;	/* protects next 3 fields */
@@ -18,6 +21,11 @@ struct handshake_net {
 	struct list_head	hn_requests;
 
 	unsigned long		hn_flags;
+
+	spinlock_t		hn_session_lock;	/* protects next 3 fields */
+	int			hn_nr_sessions;
+	struct list_head	hn_session_lru;
+	DECLARE_HASHTABLE(hn_sessions, 8);
 };
 
 enum hn_flags_bits {
@@ -26,6 +34,25 @@ enum hn_flags_bits {
 
 struct handshake_proto;
 
+/* Largest session data an agent may hand to the kernel */
+#define HANDSHAKE_SESSION_DATA_MAX	2048
+
+/* Cached session resumption data */
+struct handshake_session {
+	struct hlist_node		hs_hash;
+	struct list_head		hs_lru;
+	u32				hs_hashval;
+	int				hs_auth_mode;
+	key_serial_t			hs_identity;
+	key_serial_t			hs_keyring;
+	unsigned long			hs_expires;
+	unsigned int			hs_len;
+	u8				*hs_data;
+
+	/* Always the last field */
+	char				hs_peername[];
+};
+
 /* One handshake request */
 struct handshake_req {
 	struct list_head		hr_list;
@@ -90,4 +117,18 @@ void handshake_complete(struct handshake_req *req, unsigned int status,
 			struct genl_info *info);
 bool handshake_req_cancel(struct sock *sk);
 
+/* session.c */
+void handshake_session_init(struct handshake_net *hn);
+void handshake_session_flush(struct handshake_net *hn);
+int handshake_session_save(struct handshake_net *hn, const char *peername,
+			   int auth_mode, key_serial_t identity,
+			   key_serial_t keyring, const void *data,
+			   unsigned int len,
+			   unsigned int lifetime);
+struct handshake_session *
+handshake_session_take(struct handshake_net *hn, const char *peername,
+		       int auth_mode, key_serial_t identity,
+		       key_serial_t keyring);
+void handshake_session_free(struct handshake_session *hs);
+
 #endif /* _INTERNAL_HANDSHAKE_H */
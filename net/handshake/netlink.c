@@ -189,6 +189,7 @@ static int __net_init handshake_net_init(struct net *net)
 	hn->hn_pending = 0;
 	hn->hn_flags = 0;
 	INIT_LIST_HEAD(&hn->hn_requests);
+	handshake_session_init(hn);
 	return 0;
 }
 
@@ -219,6 +220,8 @@ static void __net_exit handshake_net_exit(struct net *net)
 
 		handshake_complete(req, -ETIMEDOUT, NULL);
 	}
+
+	handshake_session_flush(hn);
 }
 
 static struct pernet_operations handshake_genl_net_ops = {
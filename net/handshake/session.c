@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Cache of TLS session resumption data for kernel consumers
+ *
+ * When a consumer reconnects to a peer it has talked to before, the
+ * handshake agent can do an abbreviated handshake if it still has
+ * session data (e.g. a TLS 1.3 session ticket) from an earlier
+ * session with that peer. Agents are short-lived processes, so the
+ * data is kept here, keyed by peer name, local identity and the
+ * keyring of trust anchors the peer was verified against, and handed
+ * back to the agent along with the next matching request.
+ */
+
+#include <linux/types.h>
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/jhash.h>
+#include <linux/hashtable.h>
+#include <linux/jiffies.h>
+#include <linux/key.h>
+
+#include <kunit/visibility.h>
+
+#include "handshake.h"
+
+/* Bounds the memory a reconnect storm can pin, per net namespace */
+#define HANDSHAKE_SESSION_MAX		8192
+
+/* Upper limit of a TLS 1.3 ticket lifetime, RFC 8446 Section 4.6.1 */
+#define HANDSHAKE_SESSION_LIFETIME_MAX	(7 * 24 * 60 * 60)
+
+static u32 handshake_session_hash(const char *peername, int auth_mode,
+				  key_serial_t identity, key_serial_t keyring)
+{
+	return jhash(peername, strlen(peername),
+		     jhash_3words(auth_mode, identity, keyring, 0));
+}
+
+static bool handshake_session_match(const struct handshake_session *hs,
+				    const char *peername, int auth_mode,
+				    key_serial_t identity, key_serial_t keyring)
+{
+	return hs->hs_auth_mode == auth_mode &&
+	       hs->hs_identity == identity &&
+	       hs->hs_keyring == keyring &&
+	       !strcmp(hs->hs_peername, peername);
+}
+
+static void __handshake_session_unlink(struct handshake_net *hn,
+				       struct handshake_session *hs)
+{
+	hash_del(&hs->hs_hash);
+	list_del(&hs->hs_lru);
+	hn->hn_nr_sessions--;
+}
+
+void handshake_session_init(struct handshake_net *hn)
+{
+	spin_lock_init(&hn->hn_session_lock);
+	hn->hn_nr_sessions = 0;
+	INIT_LIST_HEAD(&hn->hn_session_lru);
+	hash_init(hn->hn_sessions);
+}
+
+/**
+ * handshake_session_flush - Drop all cached session data
+ * @hn: per-net handshake context
+ *
+ */
+void handshake_session_flush(struct handshake_net *hn)
+{
+	struct handshake_session *hs, *tmp;
+	LIST_HEAD(sessions);
+
+	spin_lock(&hn->hn_session_lock);
+	list_splice_init(&hn->hn_session_lru, &sessions);
+	hash_init(hn->hn_sessions);
+	hn->hn_nr_sessions = 0;
+	spin_unlock(&hn->hn_session_lock);
+
+	list_for_each_entry_safe(hs, tmp, &sessions, hs_lru)
+		handshake_session_free(hs);
+}
+EXPORT_SYMBOL_IF_KUNIT(handshake_session_flush);
+
+/**
+ * handshake_session_save - Cache session data for a later handshake
+ * @hn: per-net handshake context
+ * @peername: name of the remote peer
+ * @auth_mode: HANDSHAKE_AUTH_* the session was authenticated with
+ * @identity: local certificate or PSK the session was established with
+ * @keyring: trust anchors the peer was verified against
+ * @data: opaque session data returned by the handshake agent
+ * @len: length of @data in bytes
+ * @lifetime: seconds @data stays usable, or zero for the maximum
+ *
+ * Several entries may be cached for the same key; each of them is
+ * handed out only once. When the cache is full, the least recently
+ * saved entry is dropped.
+ *
+ * Return values:
+ *   %0: @data was cached
+ *   %-EINVAL: @len is out of range
+ *   %-ENOMEM: Memory allocation failed
+ */
+int handshake_session_save(struct handshake_net *hn, const char *peername,
+			   int auth_mode, key_serial_t identity,
+			   key_serial_t keyring, const void *data, unsigned int len,
+			   unsigned int lifetime)
+{
+	size_t namelen = strlen(peername) + 1;
+	struct handshake_session *hs, *old = NULL;
+
+	if (!len || len > HANDSHAKE_SESSION_DATA_MAX)
+		return -EINVAL;
+
+	hs = kmalloc(struct_size(hs, hs_peername, namelen) + len, GFP_KERNEL);
+	if (!hs)
+		return -ENOMEM;
+
+	memcpy(hs->hs_peername, peername, namelen);
+	hs->hs_data = (u8 *)hs->hs_peername + namelen;
+	memcpy(hs->hs_data, data, len);
+	hs->hs_len = len;
+	hs->hs_auth_mode = auth_mode;
+	hs->hs_identity = identity;
+	hs->hs_keyring = keyring;
+	hs->hs_hashval = handshake_session_hash(peername, auth_mode, identity,
+						keyring);
+
+	if (!lifetime || lifetime > HANDSHAKE_SESSION_LIFETIME_MAX)
+		lifetime = HANDSHAKE_SESSION_LIFETIME_MAX;
+	hs->hs_expires = jiffies + (unsigned long)lifetime * HZ;
+
+	spin_lock(&hn->hn_session_lock);
+	if (hn->hn_nr_sessions >= HANDSHAKE_SESSION_MAX) {
+		old = list_first_entry(&hn->hn_session_lru,
+				       struct handshake_session, hs_lru);
+		__handshake_session_unlink(hn, old);
+	}
+	hash_add(hn->hn_sessions, &hs->hs_hash, hs->hs_hashval);
+	list_add_tail(&hs->hs_lru, &hn->hn_session_lru);
+	hn->hn_nr_sessions++;
+	spin_unlock(&hn->hn_session_lock);
+
+	if (old)
+		handshake_session_free(old);
+	return 0;
+}
+EXPORT_SYMBOL_IF_KUNIT(handshake_session_save);
+
+/**
+ * handshake_session_take - Remove cached session data from the cache
+ * @hn: per-net handshake context
+ * @peername: name of the remote peer
+ * @auth_mode: HANDSHAKE_AUTH_* of the new handshake
+ * @identity: local certificate or PSK of the new handshake
+ * @keyring: trust anchors of the new handshake
+ *
+ * Returns the most recently saved unexpired entry for the key, which
+ * the caller releases with handshake_session_free(), or NULL. Expired
+ * entries found on the way are dropped.
+ */
+struct handshake_session *
+handshake_session_take(struct handshake_net *hn, const char *peername,
+		       int auth_mode, key_serial_t identity,
+		       key_serial_t keyring)
+{
+	u32 hashval = handshake_session_hash(peername, auth_mode, identity,
+					     keyring);
+	struct handshake_session *hs, *next, *found = NULL;
+	struct hlist_node *tmp;
+	LIST_HEAD(expired);
+
+	spin_lock(&hn->hn_session_lock);
+	hash_for_each_possible_safe(hn->hn_sessions, hs, tmp, hs_hash, hashval) {
+		if (hs->hs_hashval != hashval ||
+		    !handshake_session_match(hs, peername, auth_mode, identity,
+					     keyring))
+			continue;
+		__handshake_session_unlink(hn, hs);
+		if (time_after(jiffies, hs->hs_expires)) {
+			list_add(&hs->hs_lru, &expired);
+			continue;
+		}
+		found = hs;
+		break;
+	}
+	spin_unlock(&hn->hn_session_lock);
+
+	list_for_each_entry_safe(hs, next, &expired, hs_lru)
+		handshake_session_free(hs);
+	return found;
+}
+EXPORT_SYMBOL_IF_KUNIT(handshake_session_take);
+
+void handshake_session_free(struct handshake_session *hs)
+{
+	kfree_sensitive(hs);
+}
+EXPORT_SYMBOL_IF_KUNIT(handshake_session_free);
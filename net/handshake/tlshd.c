@@ -36,6 +36,7 @@ struct tls_handshake_req {
 	key_serial_t		th_keyring;
 	key_serial_t		th_certificate;
 	key_serial_t		th_privkey;
+	key_serial_t		th_identity;
 
 	unsigned int		th_num_peerids;
 	key_serial_t		th_peerid[5];
@@ -55,6 +56,7 @@ tls_handshake_req_init(struct handshake_req *req,
 	treq->th_num_peerids = 0;
 	treq->th_certificate = TLS_NO_CERT;
 	treq->th_privkey = TLS_NO_PRIVKEY;
+	treq->th_identity = TLS_NO_PEERID;
 	return treq;
 }
 
@@ -85,6 +87,48 @@ static void tls_handshake_remote_peerids(struct tls_handshake_req *treq,
 	}
 }
 
+/*
+ * Sessions are resumed only by clients that name their peer, with the
+ * same local identity the session was established with.
+ */
+static bool tls_handshake_resumable(struct tls_handshake_req *treq)
+{
+	return treq->th_type == HANDSHAKE_MSG_TYPE_CLIENTHELLO &&
+	       treq->th_peername;
+}
+
+static void tls_handshake_save_sessions(struct handshake_req *req,
+					struct tls_handshake_req *treq,
+					struct genl_info *info)
+{
+	struct nlattr *head = nlmsg_attrdata(info->nlhdr, GENL_HDRLEN);
+	int rem, len = nlmsg_attrlen(info->nlhdr, GENL_HDRLEN);
+	struct handshake_net *hn;
+	unsigned int lifetime = 0;
+	struct nlattr *nla;
+
+	if (!tls_handshake_resumable(treq))
+		return;
+	hn = handshake_pernet(sock_net(req->hr_sk));
+	if (!hn)
+		return;
+
+	if (info->attrs[HANDSHAKE_A_DONE_SESSION_LIFETIME])
+		lifetime = nla_get_u32(info->attrs[HANDSHAKE_A_DONE_SESSION_LIFETIME]);
+
+	/* A TLS 1.3 server may issue more than one ticket */
+	nla_for_each_attr(nla, head, len, rem) {
+		if (nla_type(nla) != HANDSHAKE_A_DONE_SESSION_DATA)
+			continue;
+		if (handshake_session_save(hn, treq->th_peername,
+					   treq->th_auth_mode,
+					   treq->th_identity,
+					   treq->th_keyring, nla_data(nla),
+					   nla_len(nla), lifetime))
+			break;
+	}
+}
+
 /**
  * tls_handshake_done - callback to handle a CMD_DONE request
  * @req: socket on which the handshake was performed
@@ -101,8 +145,11 @@ static void tls_handshake_done(struct handshake_req *req,
 	if (info)
 		tls_handshake_remote_peerids(treq, info);
 
-	if (!status)
+	if (!status) {
 		set_bit(HANDSHAKE_F_REQ_SESSION, &req->hr_flags);
+		if (info)
+			tls_handshake_save_sessions(req, treq, info);
+	}
 
 	treq->th_consumer_done(treq->th_consumer_data, -status,
 			       treq->th_peerid[0]);
@@ -185,6 +232,31 @@ static int tls_handshake_put_certificate(struct sk_buff *msg,
 	return 0;
 }
 
+static int tls_handshake_put_session(struct sk_buff *msg,
+				     struct handshake_req *req,
+				     struct tls_handshake_req *treq)
+{
+	struct handshake_session *hs;
+	struct handshake_net *hn;
+	int ret;
+
+	if (!tls_handshake_resumable(treq))
+		return 0;
+	hn = handshake_pernet(sock_net(req->hr_sk));
+	if (!hn)
+		return 0;
+
+	hs = handshake_session_take(hn, treq->th_peername, treq->th_auth_mode,
+				    treq->th_identity, treq->th_keyring);
+	if (!hs)
+		return 0;
+
+	ret = nla_put(msg, HANDSHAKE_A_ACCEPT_SESSION_DATA, hs->hs_len,
+		      hs->hs_data);
+	handshake_session_free(hs);
+	return ret;
+}
+
 /**
  * tls_handshake_accept - callback to construct a CMD_ACCEPT response
  * @req: handshake parameters to return
@@ -248,6 +320,10 @@ static int tls_handshake_accept(struct handshake_req *req,
 		break;
 	}
 
+	ret = tls_handshake_put_session(msg, req, treq);
+	if (ret < 0)
+		goto out_cancel;
+
 	genlmsg_end(msg, hdr);
 	return genlmsg_reply(msg, info);
 
@@ -315,6 +391,7 @@ int tls_client_hello_x509(const struct tls_handshake_args *args, gfp_t flags)
 	treq->th_auth_mode = HANDSHAKE_AUTH_X509;
 	treq->th_certificate = args->ta_my_cert;
 	treq->th_privkey = args->ta_my_privkey;
+	treq->th_identity = args->ta_my_cert;
 
 	return handshake_req_submit(args->ta_sock, req, flags);
 }
@@ -350,6 +427,7 @@ int tls_client_hello_psk(const struct tls_handshake_args *args, gfp_t flags)
 	treq->th_num_peerids = args->ta_num_peerids;
 	for (i = 0; i < args->ta_num_peerids; i++)
 		treq->th_peerid[i] = args->ta_my_peerids[i];
+	treq->th_identity = args->ta_my_peerids[0];
 
 	return handshake_req_submit(args->ta_sock, req, flags);
 }
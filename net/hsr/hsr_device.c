@@ -340,7 +340,7 @@ static void send_hsr_supervision_frame(struct hsr_port *port,
 	ether_addr_copy(hsr_sp->macaddress_A, addr);
 
 	if (hsr->redbox &&
-	    hsr_is_node_in_db(&hsr->proxy_node_db, addr)) {
+	    hsr_is_node_in_db(hsr, &hsr->proxy_node_db, addr)) {
 		hsr_stlv = skb_put(skb, sizeof(struct hsr_sup_tlv));
 		hsr_stlv->HSR_TLV_type = PRP_TLV_REDBOX_MAC;
 		hsr_stlv->HSR_TLV_length = sizeof(struct hsr_sup_payload);
@@ -680,6 +680,9 @@ int hsr_dev_finalize(struct net_device *hsr_dev, struct net_device *slave[2],
 	INIT_LIST_HEAD(&hsr->ports);
 	INIT_LIST_HEAD(&hsr->node_db);
 	INIT_LIST_HEAD(&hsr->proxy_node_db);
+	hash_init(hsr->node_hash_A);
+	hash_init(hsr->node_hash_B);
+	hash_init(hsr->proxy_node_hash);
 	spin_lock_init(&hsr->list_lock);
 
 	eth_hw_addr_set(hsr_dev, slave[0]->dev_addr);
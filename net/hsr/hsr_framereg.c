@@ -64,14 +64,51 @@ bool hsr_addr_is_self(struct hsr_priv *hsr, unsigned char *addr)
 	return ret;
 }
 
-/* Search for mac entry. Caller must hold rcu read lock.
+static struct hlist_head *hsr_node_bucket(struct hlist_head *table,
+					  const unsigned char addr[ETH_ALEN])
+{
+	return &table[hash_min(ether_addr_to_u64(addr), HSR_NODE_HASH_BITS)];
+}
+
+static struct hlist_head *hsr_node_bucket_A(struct hsr_priv *hsr,
+					    struct list_head *node_db,
+					    const unsigned char addr[ETH_ALEN])
+{
+	if (node_db == &hsr->proxy_node_db)
+		return hsr_node_bucket(hsr->proxy_node_hash, addr);
+
+	return hsr_node_bucket(hsr->node_hash_A, addr);
+}
+
+/* list_lock held. Moving the node between buckets without a grace period
+ * means that a concurrent RCU lookup may miss it, or another node that
+ * follows it in its old bucket. That is accepted: a miss only sends the
+ * frame to hsr_add_node(), which looks again under list_lock.
+ */
+static void hsr_node_hash_B(struct hsr_priv *hsr, struct hsr_node *node)
+{
+	hlist_del_init_rcu(&node->hash_B);
+	hlist_add_head_rcu(&node->hash_B,
+			   hsr_node_bucket(hsr->node_hash_B, node->macaddress_B));
+}
+
+/* list_lock held */
+static void hsr_node_unhash(struct hsr_node *node)
+{
+	hlist_del_init_rcu(&node->hash_A);
+	hlist_del_init_rcu(&node->hash_B);
+}
+
+/* Search for mac entry. Caller must hold rcu read lock or list_lock.
  */
-static struct hsr_node *find_node_by_addr_A(struct list_head *node_db,
+static struct hsr_node *find_node_by_addr_A(struct hsr_priv *hsr,
+					    struct list_head *node_db,
 					    const unsigned char addr[ETH_ALEN])
 {
 	struct hsr_node *node;
 
-	list_for_each_entry_rcu(node, node_db, mac_list) {
+	hlist_for_each_entry_rcu(node, hsr_node_bucket_A(hsr, node_db, addr),
+				 hash_A, lockdep_is_held(&hsr->list_lock)) {
 		if (ether_addr_equal(node->macaddress_A, addr))
 			return node;
 	}
@@ -79,12 +116,34 @@ static struct hsr_node *find_node_by_addr_A(struct list_head *node_db,
 	return NULL;
 }
 
+/* Search by MAC address A, and by address B in node_db. Caller must hold rcu
+ * read lock or list_lock.
+ */
+static struct hsr_node *find_node_by_addr(struct hsr_priv *hsr,
+					  struct list_head *node_db,
+					  const unsigned char addr[ETH_ALEN])
+{
+	struct hsr_node *node;
+
+	node = find_node_by_addr_A(hsr, node_db, addr);
+	if (node || node_db == &hsr->proxy_node_db)
+		return node;
+
+	hlist_for_each_entry_rcu(node, hsr_node_bucket(hsr->node_hash_B, addr),
+				 hash_B, lockdep_is_held(&hsr->list_lock)) {
+		if (ether_addr_equal(node->macaddress_B, addr))
+			return node;
+	}
+
+	return NULL;
+}
+
 /* Check if node for a given MAC address is already present in data base
  */
-bool hsr_is_node_in_db(struct list_head *node_db,
+bool hsr_is_node_in_db(struct hsr_priv *hsr, struct list_head *node_db,
 		       const unsigned char addr[ETH_ALEN])
 {
-	return !!find_node_by_addr_A(node_db, addr);
+	return !!find_node_by_addr_A(hsr, node_db, addr);
 }
 
 /* Helper for device init; the self_node is used in hsr_rcv() to recognize
@@ -183,14 +242,12 @@ static struct hsr_node *hsr_add_node(struct hsr_priv *hsr,
 		hsr->proto_ops->handle_san_frame(san, rx_port, new_node);
 
 	spin_lock_bh(&hsr->list_lock);
-	list_for_each_entry_rcu(node, node_db, mac_list,
-				lockdep_is_held(&hsr->list_lock)) {
-		if (ether_addr_equal(node->macaddress_A, addr))
-			goto out;
-		if (ether_addr_equal(node->macaddress_B, addr))
-			goto out;
-	}
+	node = find_node_by_addr(hsr, node_db, addr);
+	if (node)
+		goto out;
 	list_add_tail_rcu(&new_node->mac_list, node_db);
+	hlist_add_head_rcu(&new_node->hash_A,
+			   hsr_node_bucket_A(hsr, node_db, addr));
 	spin_unlock_bh(&hsr->list_lock);
 	return new_node;
 out:
@@ -226,26 +283,15 @@ struct hsr_node *hsr_get_node(struct hsr_port *port, struct list_head *node_db,
 
 	ethhdr = (struct ethhdr *)skb_mac_header(skb);
 
-	list_for_each_entry_rcu(node, node_db, mac_list) {
-		if (ether_addr_equal(node->macaddress_A, ethhdr->h_source)) {
-			if (hsr->proto_ops->update_san_info)
-				hsr->proto_ops->update_san_info(node, is_sup);
-			return node;
-		}
-		if (ether_addr_equal(node->macaddress_B, ethhdr->h_source)) {
-			if (hsr->proto_ops->update_san_info)
-				hsr->proto_ops->update_san_info(node, is_sup);
-			return node;
-		}
-	}
-
+	node = find_node_by_addr(hsr, node_db, ethhdr->h_source);
 	/* Check if required node is not in proxy nodes table */
-	list_for_each_entry_rcu(node, &hsr->proxy_node_db, mac_list) {
-		if (ether_addr_equal(node->macaddress_A, ethhdr->h_source)) {
-			if (hsr->proto_ops->update_san_info)
-				hsr->proto_ops->update_san_info(node, is_sup);
-			return node;
-		}
+	if (!node)
+		node = find_node_by_addr_A(hsr, &hsr->proxy_node_db,
+					   ethhdr->h_source);
+	if (node) {
+		if (hsr->proto_ops->update_san_info)
+			hsr->proto_ops->update_san_info(node, is_sup);
+		return node;
 	}
 
 	/* Everyone may create a node entry, connected node to a HSR/PRP
@@ -332,7 +378,7 @@ void hsr_handle_sup_frame(struct hsr_frame_info *frame)
 
 	/* Merge node_curr (registered on macaddress_B) into node_real */
 	node_db = &port_rcv->hsr->node_db;
-	node_real = find_node_by_addr_A(node_db, hsr_sp->macaddress_A);
+	node_real = find_node_by_addr_A(hsr, node_db, hsr_sp->macaddress_A);
 	if (!node_real)
 		/* No frame received from AddrA of this node yet */
 		node_real = hsr_add_node(hsr, node_db, hsr_sp->macaddress_A,
@@ -375,7 +421,16 @@ void hsr_handle_sup_frame(struct hsr_frame_info *frame)
 		}
 	}
 
-	ether_addr_copy(node_real->macaddress_B, ethhdr->h_source);
+	if (!ether_addr_equal(node_real->macaddress_B, ethhdr->h_source)) {
+		spin_lock_bh(&hsr->list_lock);
+		/* Don't hash a node that hsr_prune_nodes() is freeing */
+		if (!node_real->removed) {
+			ether_addr_copy(node_real->macaddress_B,
+					ethhdr->h_source);
+			hsr_node_hash_B(hsr, node_real);
+		}
+		spin_unlock_bh(&hsr->list_lock);
+	}
 	spin_lock_bh(&node_real->seq_out_lock);
 	for (i = 0; i < HSR_PT_PORTS; i++) {
 		if (!node_curr->time_in_stale[i] &&
@@ -393,6 +448,7 @@ void hsr_handle_sup_frame(struct hsr_frame_info *frame)
 	spin_lock_bh(&hsr->list_lock);
 	if (!node_curr->removed) {
 		list_del_rcu(&node_curr->mac_list);
+		hsr_node_unhash(node_curr);
 		node_curr->removed = true;
 		kfree_rcu(node_curr, rcu_head);
 	}
@@ -441,10 +497,11 @@ void hsr_addr_subst_dest(struct hsr_node *node_src, struct sk_buff *skb,
 	if (!is_unicast_ether_addr(eth_hdr(skb)->h_dest))
 		return;
 
-	node_dst = find_node_by_addr_A(&port->hsr->node_db,
+	node_dst = find_node_by_addr_A(port->hsr, &port->hsr->node_db,
 				       eth_hdr(skb)->h_dest);
 	if (!node_dst && port->hsr->redbox)
-		node_dst = find_node_by_addr_A(&port->hsr->proxy_node_db,
+		node_dst = find_node_by_addr_A(port->hsr,
+					       &port->hsr->proxy_node_db,
 					       eth_hdr(skb)->h_dest);
 
 	if (!node_dst) {
@@ -577,6 +634,7 @@ void hsr_prune_nodes(struct timer_list *t)
 			hsr_nl_nodedown(hsr, node->macaddress_A);
 			if (!node->removed) {
 				list_del_rcu(&node->mac_list);
+				hsr_node_unhash(node);
 				node->removed = true;
 				/* Note that we need to free this entry later: */
 				kfree_rcu(node, rcu_head);
@@ -611,6 +669,7 @@ void hsr_prune_proxy_nodes(struct timer_list *t)
 			hsr_nl_nodedown(hsr, node->macaddress_A);
 			if (!node->removed) {
 				list_del_rcu(&node->mac_list);
+				hsr_node_unhash(node);
 				node->removed = true;
 				/* Note that we need to free this entry later: */
 				kfree_rcu(node, rcu_head);
@@ -660,7 +719,7 @@ int hsr_get_node_data(struct hsr_priv *hsr,
 	struct hsr_port *port;
 	unsigned long tdiff;
 
-	node = find_node_by_addr_A(&hsr->node_db, addr);
+	node = find_node_by_addr_A(hsr, &hsr->node_db, addr);
 	if (!node)
 		return -ENOENT;
 
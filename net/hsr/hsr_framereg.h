@@ -70,11 +70,14 @@ void prp_handle_san_frame(bool san, enum hsr_port_type port,
 			  struct hsr_node *node);
 void prp_update_san_info(struct hsr_node *node, bool is_sup);
 
-bool hsr_is_node_in_db(struct list_head *node_db,
+bool hsr_is_node_in_db(struct hsr_priv *hsr, struct list_head *node_db,
 		       const unsigned char addr[ETH_ALEN]);
 
 struct hsr_node {
 	struct list_head	mac_list;
+	/* In hsr_priv::node_hash_A or proxy_node_hash, and node_hash_B */
+	struct hlist_node	hash_A;
+	struct hlist_node	hash_B;
 	/* Protect R/W access to seq_out */
 	spinlock_t		seq_out_lock;
 	unsigned char		macaddress_A[ETH_ALEN];
@@ -11,6 +11,7 @@
 #define __HSR_PRIVATE_H
 
 #include <linux/netdevice.h>
+#include <linux/hashtable.h>
 #include <linux/list.h>
 #include <linux/if_vlan.h>
 #include <linux/if_hsr.h>
@@ -196,6 +197,13 @@ struct hsr_priv {
 	struct list_head	ports;
 	struct list_head	node_db;	/* Known HSR nodes */
 	struct list_head	proxy_node_db;	/* RedBox HSR proxy nodes */
+	/* Lookup of the node_db nodes by MAC address A and B, and of the
+	 * proxy_node_db ones by MAC address A. Changed under list_lock.
+	 */
+#define HSR_NODE_HASH_BITS	8
+	DECLARE_HASHTABLE(node_hash_A, HSR_NODE_HASH_BITS);
+	DECLARE_HASHTABLE(node_hash_B, HSR_NODE_HASH_BITS);
+	DECLARE_HASHTABLE(proxy_node_hash, HSR_NODE_HASH_BITS);
 	struct hsr_self_node	__rcu *self_node;	/* MACs of slaves */
 	struct timer_list	announce_timer;	/* Supervision frame dispatch */
 	struct timer_list	announce_proxy_timer;
@@ -161,6 +161,7 @@ static void kcm_rcv_ready(struct kcm_sock *kcm)
 	}
 
 	/* Buffer limit is okay now, add to ready list */
+	kcm->rx_skipped = 0;
 	list_add_tail(&kcm->wait_rx_list,
 		      &kcm->mux->kcm_rx_waiters);
 	/* paired with lockless reads in kcm_rfree() */
@@ -250,6 +251,40 @@ static void requeue_rx_msgs(struct kcm_mux *mux, struct sk_buff_head *head)
 	}
 }
 
+/* Waiters looked at for one that last read on the current CPU */
+#define KCM_RX_WAITERS_SCAN	8
+/* Messages the first waiter can be passed over for before it gets one */
+#define KCM_RX_WAITER_SKIPS	4
+
+/* Pick a waiting KCM socket for a message, preferring one whose reader
+ * runs on this CPU, so that the message is consumed where it's still hot
+ * and without a cross CPU wakeup. The first waiter is only passed over a
+ * bounded number of times, so it can't be starved. RX mux lock held.
+ */
+static struct kcm_sock *kcm_rx_waiter(struct kcm_mux *mux)
+{
+	int cpu = smp_processor_id();
+	struct kcm_sock *head, *kcm;
+	int n = 0;
+
+	head = list_first_entry(&mux->kcm_rx_waiters,
+				struct kcm_sock, wait_rx_list);
+	if (head->rx_skipped >= KCM_RX_WAITER_SKIPS)
+		return head;
+
+	list_for_each_entry(kcm, &mux->kcm_rx_waiters, wait_rx_list) {
+		if (READ_ONCE(kcm->rx_cpu) == cpu) {
+			if (kcm != head)
+				head->rx_skipped++;
+			return kcm;
+		}
+		if (++n == KCM_RX_WAITERS_SCAN)
+			break;
+	}
+
+	return head;
+}
+
 /* Lower sock lock held */
 static struct kcm_sock *reserve_rx_kcm(struct kcm_psock *psock,
 				       struct sk_buff *head)
@@ -280,8 +315,7 @@ static struct kcm_sock *reserve_rx_kcm(struct kcm_psock *psock,
 		return NULL;
 	}
 
-	kcm = list_first_entry(&mux->kcm_rx_waiters,
-			       struct kcm_sock, wait_rx_list);
+	kcm = kcm_rx_waiter(mux);
 	list_del(&kcm->wait_rx_list);
 	/* paired with lockless reads in kcm_rfree() */
 	WRITE_ONCE(kcm->rx_wait, false);
@@ -439,6 +473,28 @@ static void psock_write_space(struct sock *sk)
 
 static void unreserve_psock(struct kcm_sock *kcm);
 
+/* Pick the available psock with the least data queued on its lower socket,
+ * so that messages are spread over the connections by load rather than
+ * piling up on the first one. mux lock held.
+ */
+static struct kcm_psock *kcm_avail_psock(struct kcm_mux *mux)
+{
+	struct kcm_psock *psock, *best = NULL;
+	int queued, best_queued = INT_MAX;
+
+	list_for_each_entry(psock, &mux->psocks_avail, psock_avail_list) {
+		queued = READ_ONCE(psock->sk->sk_wmem_queued);
+		if (queued < best_queued) {
+			best = psock;
+			best_queued = queued;
+			if (!queued)
+				break;
+		}
+	}
+
+	return best;
+}
+
 /* kcm sock is locked. */
 static struct kcm_psock *reserve_psock(struct kcm_sock *kcm)
 {
@@ -470,9 +526,7 @@ static struct kcm_psock *reserve_psock(struct kcm_sock *kcm)
 	}
 
 	if (!list_empty(&mux->psocks_avail)) {
-		psock = list_first_entry(&mux->psocks_avail,
-					 struct kcm_psock,
-					 psock_avail_list);
+		psock = kcm_avail_psock(mux);
 		list_del(&psock->psock_avail_list);
 		if (kcm->tx_wait) {
 			list_del(&kcm->wait_psock_list);
@@ -984,6 +1038,8 @@ static int kcm_recvmsg(struct socket *sock, struct msghdr *msg,
 	if (!skb)
 		goto out;
 
+	WRITE_ONCE(kcm->rx_cpu, raw_smp_processor_id());
+
 	/* Okay, have a message on the receive queue */
 
 	stm = strp_msg(skb);
@@ -1187,6 +1243,7 @@ static void init_kcm_sock(struct kcm_sock *kcm, struct kcm_mux *mux)
 	 * EPOLLHUP
 	 */
 	kcm->sk.sk_state = TCP_ESTABLISHED;
+	kcm->rx_cpu = -1;
 
 	/* Add to mux's kcm sockets list */
 	kcm->mux = mux;
@@ -18,6 +18,9 @@
 #include <net/ip_tunnels.h>
 #include <net/dst_metadata.h>
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/psample.h>
+
 #define PSAMPLE_MAX_PACKET_SIZE 0xffff
 
 static LIST_HEAD(psample_groups_list);
@@ -377,6 +380,8 @@ void psample_sample_packet(struct psample_group *group,
 	void *data;
 	int ret;
 
+	trace_psample_sample_packet(group, skb, sample_rate, md);
+
 	if (!genl_has_listeners(&psample_nl_family, group->net,
 				PSAMPLE_NL_MCGRP_SAMPLE))
 		return;
@@ -28,12 +28,14 @@
 #include <net/netdev_rx_queue.h>
 #include <net/xdp.h>
 
+#include "../core/dev.h"
 #include "xsk_queue.h"
 #include "xdp_umem.h"
 #include "xsk.h"
 
 #define TX_BATCH_SIZE 32
 #define MAX_PER_SOCKET_BUDGET (TX_BATCH_SIZE)
+#define TX_XMIT_BATCH_SIZE 16
 
 void xsk_set_rx_need_wakeup(struct xsk_buff_pool *pool)
 {
@@ -325,9 +327,60 @@ static int xsk_rcv_check(struct xdp_sock *xs, struct xdp_buff *xdp, u32 len)
 	return 0;
 }
 
+static u32 xsk_lat_bucket(u64 ns)
+{
+	u64 us = ns >> 10;
+
+	return us ? min_t(u32, ilog2(us) + 1, XSK_LAT_BUCKETS - 1) : 0;
+}
+
+static void xsk_lat_close(struct xsk_lat_hist *h, s64 ts, u64 now)
+{
+	if (atomic64_try_cmpxchg(&h->ts, &ts, 0))
+		atomic64_inc(&h->buckets[xsk_lat_bucket(now - ts)]);
+}
+
+/* Complete the outstanding sample of @h if the other side of the ring has
+ * moved to or past it. May run concurrently with xsk_lat_sample().
+ */
+static void xsk_lat_check(struct xsk_lat_hist *h, u32 pos)
+{
+	s64 ts = atomic64_read_acquire(&h->ts);
+
+	if (ts && (s32)(pos - READ_ONCE(h->idx)) >= 0)
+		xsk_lat_close(h, ts, ktime_get_ns());
+}
+
+/* Complete the outstanding sample of @h as in xsk_lat_check() and, if none
+ * is left, start following ring position @idx. Only one context may start
+ * samples on a given histogram: the Rx flush path for Rx residency and the
+ * completion ring producer for Tx completions.
+ */
+static void xsk_lat_sample(struct xsk_lat_hist *h, u32 pos, u32 idx)
+{
+	s64 ts = atomic64_read_acquire(&h->ts);
+	u64 now;
+
+	if (ts && (s32)(pos - READ_ONCE(h->idx)) < 0)
+		return;
+	if (!ts && (s32)(idx - pos) <= 0)
+		return;
+
+	now = ktime_get_ns();
+	if (ts)
+		xsk_lat_close(h, ts, now);
+	if ((s32)(idx - pos) > 0) {
+		WRITE_ONCE(h->idx, idx);
+		atomic64_set_release(&h->ts, now);
+	}
+}
+
 static void xsk_flush(struct xdp_sock *xs)
 {
 	xskq_prod_submit(xs->rx);
+	if (READ_ONCE(xs->lat_stats))
+		xsk_lat_sample(&xs->rx_lat, READ_ONCE(xs->rx->ring->consumer),
+			       xs->rx->cached_prod);
 	__xskq_cons_release(xs->pool->fq);
 	sock_def_readable(&xs->sk);
 }
@@ -394,9 +447,98 @@ void __xsk_map_flush(struct list_head *flush_list)
 	}
 }
 
+static void xsk_tx_lat_start(struct xsk_buff_pool *pool)
+{
+	if (READ_ONCE(pool->lat_stats))
+		xsk_lat_sample(&pool->tx_lat, READ_ONCE(pool->cq->ring->producer),
+			       pool->cq->cached_prod);
+}
+
+static void xsk_tx_lat_end(struct xsk_buff_pool *pool)
+{
+	if (READ_ONCE(pool->lat_stats))
+		xsk_lat_check(&pool->tx_lat, READ_ONCE(pool->cq->ring->producer));
+}
+
+static void xsk_cq_publish(struct xsk_buff_pool *pool, u32 n)
+{
+	xskq_prod_submit_n(pool->cq, n);
+	xsk_tx_lat_end(pool);
+}
+
+/* Hand @n completed entries to user space, or hold them back until enough
+ * have accumulated or the coalescing timer fires. Called with cq_lock held.
+ */
+static void xsk_cq_complete_locked(struct xsk_buff_pool *pool, u32 n)
+{
+	if (!pool->cq_coalesce_frames) {
+		xsk_cq_publish(pool, n);
+		return;
+	}
+
+	pool->cq_pending += n;
+	if (pool->cq_pending >= pool->cq_coalesce_frames) {
+		xsk_cq_publish(pool, pool->cq_pending);
+		pool->cq_pending = 0;
+		return;
+	}
+
+	if (!hrtimer_is_queued(&pool->cq_timer))
+		hrtimer_start(&pool->cq_timer,
+			      us_to_ktime(pool->cq_coalesce_usecs),
+			      HRTIMER_MODE_REL_SOFT);
+}
+
+enum hrtimer_restart xsk_cq_coalesce_timer(struct hrtimer *timer)
+{
+	struct xsk_buff_pool *pool = container_of(timer, struct xsk_buff_pool,
+						  cq_timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&pool->cq_lock, flags);
+	if (pool->cq_pending) {
+		xsk_cq_publish(pool, pool->cq_pending);
+		pool->cq_pending = 0;
+	}
+	spin_unlock_irqrestore(&pool->cq_lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
+static void xsk_apply_tx_coalesce(struct xdp_sock *xs)
+{
+	struct xsk_buff_pool *pool = xs->pool;
+	u32 frames = xs->tx_coalesce.max_frames;
+	unsigned long flags;
+
+	if (frames <= 1)
+		frames = 0;
+
+	spin_lock_irqsave(&pool->cq_lock, flags);
+	pool->cq_coalesce_usecs = xs->tx_coalesce.usecs;
+	WRITE_ONCE(pool->cq_coalesce_frames, min(frames, pool->cq->nentries));
+	if (!pool->cq_coalesce_frames && pool->cq_pending) {
+		xsk_cq_publish(pool, pool->cq_pending);
+		pool->cq_pending = 0;
+	}
+	spin_unlock_irqrestore(&pool->cq_lock, flags);
+}
+
 void xsk_tx_completed(struct xsk_buff_pool *pool, u32 nb_entries)
 {
-	xskq_prod_submit_n(pool->cq, nb_entries);
+	unsigned long flags;
+
+	/* Zero-copy drivers complete from a single context, so the ring only
+	 * needs the lock once the coalescing timer may publish as well.
+	 */
+	if (likely(!READ_ONCE(pool->cq_coalesce_frames))) {
+		xsk_cq_publish(pool, nb_entries);
+		return;
+	}
+
+	spin_lock_irqsave(&pool->cq_lock, flags);
+	xsk_cq_complete_locked(pool, nb_entries);
+	spin_unlock_irqrestore(&pool->cq_lock, flags);
 }
 EXPORT_SYMBOL(xsk_tx_completed);
 
@@ -443,6 +585,7 @@ bool xsk_tx_peek_desc(struct xsk_buff_pool *pool, struct xdp_desc *desc)
 		if (xskq_prod_reserve_addr(pool->cq, desc->addr))
 			goto out;
 
+		xsk_tx_lat_start(pool);
 		xskq_cons_release(xs->tx);
 		rcu_read_unlock();
 		return true;
@@ -511,6 +654,7 @@ u32 xsk_tx_peek_release_desc_batch(struct xsk_buff_pool *pool, u32 nb_pkts)
 
 	__xskq_cons_release(xs->tx);
 	xskq_prod_write_addr_batch(pool->cq, pool->tx_descs, nb_pkts);
+	xsk_tx_lat_start(pool);
 	xs->sk.sk_write_space(&xs->sk);
 
 out:
@@ -533,6 +677,8 @@ static int xsk_cq_reserve_addr_locked(struct xsk_buff_pool *pool, u64 addr)
 
 	spin_lock_irqsave(&pool->cq_lock, flags);
 	ret = xskq_prod_reserve_addr(pool->cq, addr);
+	if (!ret)
+		xsk_tx_lat_start(pool);
 	spin_unlock_irqrestore(&pool->cq_lock, flags);
 
 	return ret;
@@ -543,7 +689,7 @@ static void xsk_cq_submit_locked(struct xsk_buff_pool *pool, u32 n)
 	unsigned long flags;
 
 	spin_lock_irqsave(&pool->cq_lock, flags);
-	xskq_prod_submit_n(pool->cq, n);
+	xsk_cq_complete_locked(pool, n);
 	spin_unlock_irqrestore(&pool->cq_lock, flags);
 }
 
@@ -771,15 +917,121 @@ static struct sk_buff *xsk_build_skb(struct xdp_sock *xs,
 	return ERR_PTR(err);
 }
 
+/* Packets built in copy mode, handed to the driver under one tx lock. */
+struct xsk_tx_batch {
+	struct sk_buff *skbs[TX_XMIT_BATCH_SIZE];
+	/* Tx ring position of the first descriptor of each packet */
+	u32 cons[TX_XMIT_BATCH_SIZE];
+	/* Tx invalid_descs count before the first descriptor of each packet */
+	u64 invalid[TX_XMIT_BATCH_SIZE];
+	u32 nb;
+};
+
+/* Hand the descriptors of the packets from @from onwards back to the Tx ring. */
+static void xsk_tx_batch_cancel(struct xdp_sock *xs, struct xsk_tx_batch *batch,
+				u32 from)
+{
+	u32 i;
+
+	xskq_cons_cancel_n(xs->tx, xs->tx->cached_cons - batch->cons[from]);
+	/* The descriptors are validated and counted again when re-read */
+	xs->tx->invalid_descs = batch->invalid[from];
+	for (i = from; i < batch->nb; i++)
+		xsk_consume_skb(batch->skbs[i]);
+}
+
+static int xsk_tx_batch_flush(struct xdp_sock *xs, struct xsk_tx_batch *batch,
+			      bool *sent_frame)
+{
+	struct net_device *dev = xs->dev;
+	struct netdev_queue *txq;
+	u32 i, nb_xmit, sent = 0;
+	bool again = false;
+	int err = 0;
+
+	if (!batch->nb)
+		return 0;
+
+	if (unlikely(!netif_running(dev) || !netif_carrier_ok(dev))) {
+		nb_xmit = 0;
+		kfree_skb(batch->skbs[0]);
+	} else {
+		for (nb_xmit = 0; nb_xmit < batch->nb; nb_xmit++) {
+			struct sk_buff *skb = batch->skbs[nb_xmit];
+			struct sk_buff *nskb;
+
+			nskb = validate_xmit_skb_list(skb, dev, &again);
+			if (unlikely(nskb != skb)) {
+				kfree_skb_list(nskb);
+				break;
+			}
+			skb_set_queue_mapping(skb, xs->queue_id);
+		}
+	}
+
+	if (nb_xmit < batch->nb) {
+		/* SKB completed but not sent, the packets after it are retried */
+		dev_core_stats_tx_dropped_inc(dev);
+		err = -EBUSY;
+		if (nb_xmit + 1 < batch->nb)
+			xsk_tx_batch_cancel(xs, batch, nb_xmit + 1);
+	}
+
+	if (nb_xmit) {
+		txq = netdev_get_tx_queue(dev, xs->queue_id);
+
+		local_bh_disable();
+		dev_xmit_recursion_inc();
+		HARD_TX_LOCK(dev, txq, smp_processor_id());
+		for (; sent < nb_xmit; sent++) {
+			netdev_tx_t ret;
+
+			if (netif_xmit_frozen_or_drv_stopped(txq))
+				break;
+			ret = netdev_start_xmit(batch->skbs[sent], dev, txq,
+						sent + 1 < nb_xmit);
+			if (!dev_xmit_complete(ret))
+				break;
+		}
+		HARD_TX_UNLOCK(dev, txq);
+		dev_xmit_recursion_dec();
+		local_bh_enable();
+	}
+
+	if (sent)
+		*sent_frame = true;
+
+	if (sent < nb_xmit) {
+		if (err) {
+			/* Descriptors can't be handed back past a dropped packet */
+			for (i = sent; i < nb_xmit; i++) {
+				dev_core_stats_tx_dropped_inc(dev);
+				kfree_skb(batch->skbs[i]);
+			}
+		} else {
+			/* Tell user-space to retry the send */
+			xsk_tx_batch_cancel(xs, batch, sent);
+			err = -EAGAIN;
+		}
+	}
+
+	batch->nb = 0;
+	return err;
+}
+
 static int __xsk_generic_xmit(struct sock *sk)
 {
 	struct xdp_sock *xs = xdp_sk(sk);
 	u32 max_batch = TX_BATCH_SIZE;
+	struct xsk_tx_batch batch;
 	bool sent_frame = false;
 	struct xdp_desc desc;
 	struct sk_buff *skb;
+	u64 invalid = 0;
+	u32 cons = 0;
 	int err = 0;
 
+	batch.nb = 0;
 	mutex_lock(&xs->mutex);
 
 	/* Since we dropped the RCU read lock, the socket state might have changed. */
@@ -791,12 +1043,35 @@ static int __xsk_generic_xmit(struct sock *sk)
 	if (xs->queue_id >= xs->dev->real_num_tx_queues)
 		goto out;
 
-	while (xskq_cons_peek_desc(xs->tx, &desc, xs->pool)) {
+	for (;;) {
+		/* Fetching new entries publishes the consumer pointer, after
+		 * which the descriptors of the batch can't be handed back.
+		 */
+		if (batch.nb && !xskq_has_descs(xs->tx)) {
+			err = xsk_tx_batch_flush(xs, &batch, &sent_frame);
+			if (err)
+				goto out;
+		}
+
+		if (!xskq_cons_peek_desc(xs->tx, &desc, xs->pool))
+			break;
+
 		if (max_batch-- == 0) {
 			err = -EAGAIN;
 			goto out;
 		}
 
+		if (!xs->skb) {
+			/* A multi-buffer packet is built with an empty batch */
+			if (batch.nb && xp_mb_desc(&desc)) {
+				err = xsk_tx_batch_flush(xs, &batch, &sent_frame);
+				if (err)
+					goto out;
+			}
+			cons = xs->tx->cached_cons;
+			invalid = xs->tx->invalid_descs;
+		}
+
 		/* This is the backpressure mechanism for the Tx path.
 		 * Reserve space in the completion queue and only proceed
 		 * if there is space in it. This avoids having to implement
@@ -821,27 +1096,21 @@ static int __xsk_generic_xmit(struct sock *sk)
 			continue;
 		}
 
-		err = __dev_direct_xmit(skb, xs->queue_id);
-		if  (err == NETDEV_TX_BUSY) {
-			/* Tell user-space to retry the send */
-			xskq_cons_cancel_n(xs->tx, xsk_get_num_desc(skb));
-			xsk_consume_skb(skb);
-			err = -EAGAIN;
-			goto out;
-		}
-
-		/* Ignore NET_XMIT_CN as packet might have been sent */
-		if (err == NET_XMIT_DROP) {
-			/* SKB completed but not sent */
-			err = -EBUSY;
-			xs->skb = NULL;
-			goto out;
-		}
-
-		sent_frame = true;
 		xs->skb = NULL;
+		batch.skbs[batch.nb] = skb;
+		batch.cons[batch.nb] = cons;
+		batch.invalid[batch.nb++] = invalid;
+		if (batch.nb == TX_XMIT_BATCH_SIZE) {
+			err = xsk_tx_batch_flush(xs, &batch, &sent_frame);
+			if (err)
+				goto out;
+		}
 	}
 
+	err = xsk_tx_batch_flush(xs, &batch, &sent_frame);
+	if (err)
+		goto out;
+
 	if (xskq_has_descs(xs->tx)) {
 		if (xs->skb)
 			xsk_drop_skb(xs->skb);
@@ -849,6 +1118,13 @@ static int __xsk_generic_xmit(struct sock *sk)
 	}
 
 out:
+	if (batch.nb) {
+		int ret = xsk_tx_batch_flush(xs, &batch, &sent_frame);
+
+		if (!err)
+			err = ret;
+	}
+
 	if (sent_frame)
 		if (xsk_tx_writeable(xs))
 			sk->sk_write_space(sk);
@@ -881,6 +1157,91 @@ static bool xsk_no_wakeup(struct sock *sk)
 #endif
 }
 
+#ifdef CONFIG_NET_RX_BUSY_POLL
+/* A busy-poll group lets one non-blocking syscall on any member drive the
+ * NAPI contexts of all members, so that an application serving many sockets
+ * from one core does not have to make one syscall per socket and loop.
+ */
+struct xsk_bp_group {
+	struct list_head members; /* RCU protected, xsk_bp_group_mutex */
+	u32 nr_members;
+	struct rcu_head rcu;
+};
+
+static DEFINE_MUTEX(xsk_bp_group_mutex);
+
+static void xsk_busy_loop(struct xdp_sock *xs)
+{
+	struct sock *sk = &xs->sk;
+	unsigned int napi_id, prev = 0;
+	struct xsk_bp_group *grp;
+	struct xdp_sock *member;
+	bool prefer;
+	u16 budget;
+
+	grp = rcu_dereference(xs->bp_group);
+	if (!grp) {
+		sk_busy_loop(sk, 1);
+		return;
+	}
+
+	prefer = READ_ONCE(sk->sk_prefer_busy_poll);
+	budget = READ_ONCE(sk->sk_busy_poll_budget) ?: BUSY_POLL_BUDGET;
+
+	/* Sockets sharing a queue are usually adjacent in the list, so only
+	 * skipping repeats of the previous id avoids most redundant polls.
+	 */
+	list_for_each_entry_rcu(member, &grp->members, bp_node) {
+		napi_id = READ_ONCE(member->sk.sk_napi_id);
+		if (napi_id < MIN_NAPI_ID || napi_id == prev)
+			continue;
+		napi_busy_loop(napi_id, NULL, NULL, prefer, budget);
+		prev = napi_id;
+	}
+}
+
+static void xsk_bp_group_add(struct xsk_bp_group *grp, struct xdp_sock *xs)
+{
+	list_add_tail_rcu(&xs->bp_node, &grp->members);
+	grp->nr_members++;
+	rcu_assign_pointer(xs->bp_group, grp);
+}
+
+static bool xsk_bp_group_leave(struct xdp_sock *xs)
+{
+	struct xsk_bp_group *grp;
+
+	grp = rcu_dereference_protected(xs->bp_group,
+					lockdep_is_held(&xsk_bp_group_mutex));
+	if (!grp)
+		return false;
+
+	list_del_rcu(&xs->bp_node);
+	RCU_INIT_POINTER(xs->bp_group, NULL);
+	if (!--grp->nr_members)
+		kfree_rcu(grp, rcu);
+	return true;
+}
+
+static void xsk_bp_group_release(struct xdp_sock *xs)
+{
+	if (!rcu_access_pointer(xs->bp_group))
+		return;
+
+	mutex_lock(&xsk_bp_group_mutex);
+	xsk_bp_group_leave(xs);
+	mutex_unlock(&xsk_bp_group_mutex);
+}
+#else
+static void xsk_busy_loop(struct xdp_sock *xs)
+{
+}
+
+static void xsk_bp_group_release(struct xdp_sock *xs)
+{
+}
+#endif
+
 static int xsk_check_common(struct xdp_sock *xs)
 {
 	if (unlikely(!xsk_is_bound(xs)))
@@ -908,13 +1269,14 @@ static int __xsk_sendmsg(struct socket *sock, struct msghdr *m, size_t total_len
 		return -ENOBUFS;
 
 	if (sk_can_busy_loop(sk))
-		sk_busy_loop(sk, 1); /* only support non-blocking sockets */
+		xsk_busy_loop(xs); /* only support non-blocking sockets */
 
 	if (xs->zc && xsk_no_wakeup(sk))
 		return 0;
 
 	pool = xs->pool;
 	if (pool->cached_need_wakeup & XDP_WAKEUP_TX) {
+		xs->tx_wakeups++;
 		if (xs->zc)
 			return xsk_wakeup(xs, XDP_WAKEUP_TX);
 		return xsk_generic_xmit(sk);
@@ -949,13 +1311,15 @@ static int __xsk_recvmsg(struct socket *sock, struct msghdr *m, size_t len, int
 		return -EOPNOTSUPP;
 
 	if (sk_can_busy_loop(sk))
-		sk_busy_loop(sk, 1); /* only support non-blocking sockets */
+		xsk_busy_loop(xs); /* only support non-blocking sockets */
 
 	if (xsk_no_wakeup(sk))
 		return 0;
 
-	if (xs->pool->cached_need_wakeup & XDP_WAKEUP_RX && xs->zc)
+	if (xs->pool->cached_need_wakeup & XDP_WAKEUP_RX && xs->zc) {
+		xs->rx_wakeups++;
 		return xsk_wakeup(xs, XDP_WAKEUP_RX);
+	}
 	return 0;
 }
 
@@ -987,6 +1351,7 @@ static __poll_t xsk_poll(struct file *file, struct socket *sock,
 	pool = xs->pool;
 
 	if (pool->cached_need_wakeup) {
+		xs->poll_wakeups++;
 		if (xs->zc)
 			xsk_wakeup(xs, pool->cached_need_wakeup);
 		else if (xs->tx)
@@ -994,6 +1359,9 @@ static __poll_t xsk_poll(struct file *file, struct socket *sock,
 			xsk_generic_xmit(sk);
 	}
 
+	if (xs->rx && READ_ONCE(xs->lat_stats))
+		xsk_lat_check(&xs->rx_lat, READ_ONCE(xs->rx->ring->consumer));
+
 	if (xs->rx && !xskq_prod_is_empty(xs->rx))
 		mask |= EPOLLIN | EPOLLRDNORM;
 	if (xs->tx && xsk_tx_writeable(xs))
@@ -1101,6 +1469,7 @@ static int xsk_release(struct socket *sock)
 
 	sock_prot_inuse_add(net, sk->sk_prot, -1);
 
+	xsk_bp_group_release(xs);
 	xsk_delete_from_maps(xs);
 	mutex_lock(&xs->mutex);
 	xsk_unbind_dev(xs);
@@ -1136,6 +1505,64 @@ static struct socket *xsk_lookup_xsk_from_fd(int fd)
 	return sock;
 }
 
+#ifdef CONFIG_NET_RX_BUSY_POLL
+/* Join the busy-poll group of the xsk referred to by @fd, creating one if it
+ * is not in a group yet. A negative @fd leaves the current group.
+ */
+static int xsk_bp_group_join(struct xdp_sock *xs, int fd)
+{
+	struct xsk_bp_group *grp;
+	struct xdp_sock *leader;
+	struct socket *sock;
+	int err = 0;
+
+	if (fd < 0) {
+		mutex_lock(&xsk_bp_group_mutex);
+		xsk_bp_group_leave(xs);
+		mutex_unlock(&xsk_bp_group_mutex);
+		return 0;
+	}
+
+	sock = xsk_lookup_xsk_from_fd(fd);
+	if (IS_ERR(sock))
+		return PTR_ERR(sock);
+	leader = xdp_sk(sock->sk);
+
+	mutex_lock(&xsk_bp_group_mutex);
+	grp = rcu_dereference_protected(leader->bp_group,
+					lockdep_is_held(&xsk_bp_group_mutex));
+	if (!grp) {
+		grp = kzalloc(sizeof(*grp), GFP_KERNEL);
+		if (!grp) {
+			err = -ENOMEM;
+			goto out_unlock;
+		}
+		INIT_LIST_HEAD(&grp->members);
+		xsk_bp_group_add(grp, leader);
+	}
+
+	if (leader != xs &&
+	    rcu_access_pointer(xs->bp_group) != grp) {
+		/* Readers may still be walking the old list through this
+		 * socket, wait for them before linking it into a new one.
+		 */
+		if (xsk_bp_group_leave(xs))
+			synchronize_rcu();
+		xsk_bp_group_add(grp, xs);
+	}
+
+out_unlock:
+	mutex_unlock(&xsk_bp_group_mutex);
+	sockfd_put(sock);
+	return err;
+}
+#else
+static int xsk_bp_group_join(struct xdp_sock *xs, int fd)
+{
+	return -EOPNOTSUPP;
+}
+#endif
+
 static bool xsk_validate_queues(struct xdp_sock *xs)
 {
 	return xs->fq_tmp && xs->cq_tmp;
@@ -1220,7 +1647,8 @@ static int xsk_bind(struct socket *sock, struct sockaddr *addr, int addr_len)
 			 * and/or device.
 			 */
 			xs->pool = xp_create_and_assign_umem(xs,
-							     umem_xs->umem);
+							     umem_xs->umem,
+							     dev);
 			if (!xs->pool) {
 				err = -ENOMEM;
 				sockfd_put(sock);
@@ -1270,7 +1698,7 @@ static int xsk_bind(struct socket *sock, struct sockaddr *addr, int addr_len)
 		goto out_unlock;
 	} else {
 		/* This xsk has its own umem. */
-		xs->pool = xp_create_and_assign_umem(xs, xs->umem);
+		xs->pool = xp_create_and_assign_umem(xs, xs->umem, dev);
 		if (!xs->pool) {
 			err = -ENOMEM;
 			goto out_unlock;
@@ -1292,6 +1720,10 @@ static int xsk_bind(struct socket *sock, struct sockaddr *addr, int addr_len)
 	xs->zc = xs->umem->zc;
 	xs->sg = !!(xs->umem->flags & XDP_UMEM_SG_FLAG);
 	xs->queue_id = qid;
+	if (xs->lat_stats)
+		WRITE_ONCE(xs->pool->lat_stats, true);
+	if (xs->tx_coalesce.max_frames)
+		xsk_apply_tx_coalesce(xs);
 	xp_add_xsk(xs->pool, xs);
 
 	if (xs->zc && qid < dev->real_num_rx_queues) {
@@ -1426,6 +1858,54 @@ static int xsk_setsockopt(struct socket *sock, int level, int optname,
 		mutex_unlock(&xs->mutex);
 		return err;
 	}
+	case XDP_LATENCY_STATS:
+	{
+		int enable;
+
+		if (optlen < sizeof(enable))
+			return -EINVAL;
+		if (copy_from_sockptr(&enable, optval, sizeof(enable)))
+			return -EFAULT;
+
+		mutex_lock(&xs->mutex);
+		WRITE_ONCE(xs->lat_stats, !!enable);
+		/* Completions are tracked per buffer pool, which may be
+		 * shared with other sockets, so this is never turned off.
+		 */
+		if (enable && xs->state == XSK_BOUND)
+			WRITE_ONCE(xs->pool->lat_stats, true);
+		mutex_unlock(&xs->mutex);
+		return 0;
+	}
+	case XDP_TX_COALESCE:
+	{
+		struct xdp_tx_coalesce tc;
+
+		if (optlen < sizeof(tc))
+			return -EINVAL;
+		if (copy_from_sockptr(&tc, optval, sizeof(tc)))
+			return -EFAULT;
+		if (tc.max_frames > 1 && (!tc.usecs || tc.usecs > USEC_PER_SEC))
+			return -EINVAL;
+
+		mutex_lock(&xs->mutex);
+		xs->tx_coalesce = tc;
+		if (xs->state == XSK_BOUND)
+			xsk_apply_tx_coalesce(xs);
+		mutex_unlock(&xs->mutex);
+		return 0;
+	}
+	case XDP_BUSY_POLL_GROUP:
+	{
+		int fd;
+
+		if (optlen < sizeof(fd))
+			return -EINVAL;
+		if (copy_from_sockptr(&fd, optval, sizeof(fd)))
+			return -EFAULT;
+
+		return xsk_bp_group_join(xs, fd);
+	}
 	default:
 		break;
 	}
@@ -44,28 +44,38 @@ void xp_destroy(struct xsk_buff_pool *pool)
 
 int xp_alloc_tx_descs(struct xsk_buff_pool *pool, struct xdp_sock *xs)
 {
-	pool->tx_descs = kvcalloc(xs->tx->nentries, sizeof(*pool->tx_descs),
-				  GFP_KERNEL);
+	pool->tx_descs = kvcalloc_node(xs->tx->nentries, sizeof(*pool->tx_descs),
+				       GFP_KERNEL, pool->node);
 	if (!pool->tx_descs)
 		return -ENOMEM;
 
 	return 0;
 }
 
+/* The heads and free_heads arrays are walked for every buffer handed to the
+ * driver, so keep them on the node of the device the pool is bound to. With a
+ * UMEM shared between queues on different nodes, each queue gets its own pool
+ * and fill/completion rings, so every pool ends up node-local to its queue.
+ */
 struct xsk_buff_pool *xp_create_and_assign_umem(struct xdp_sock *xs,
-						struct xdp_umem *umem)
+						struct xdp_umem *umem,
+						struct net_device *dev)
 {
 	bool unaligned = umem->flags & XDP_UMEM_UNALIGNED_CHUNK_FLAG;
+	int node = dev ? dev_to_node(&dev->dev) : NUMA_NO_NODE;
 	struct xsk_buff_pool *pool;
 	struct xdp_buff_xsk *xskb;
 	u32 i, entries;
 
 	entries = unaligned ? umem->chunks : 0;
-	pool = kvzalloc(struct_size(pool, free_heads, entries),	GFP_KERNEL);
+	pool = kvzalloc_node(struct_size(pool, free_heads, entries), GFP_KERNEL,
+			     node);
 	if (!pool)
 		goto out;
 
-	pool->heads = kvcalloc(umem->chunks, sizeof(*pool->heads), GFP_KERNEL);
+	pool->node = node;
+	pool->heads = kvcalloc_node(umem->chunks, sizeof(*pool->heads),
+				    GFP_KERNEL, node);
 	if (!pool->heads)
 		goto out;
 
@@ -92,6 +102,8 @@ struct xsk_buff_pool *xp_create_and_assign_umem(struct xdp_sock *xs,
 	INIT_LIST_HEAD(&pool->xsk_tx_list);
 	spin_lock_init(&pool->xsk_tx_list_lock);
 	spin_lock_init(&pool->cq_lock);
+	hrtimer_setup(&pool->cq_timer, xsk_cq_coalesce_timer, CLOCK_MONOTONIC,
+		      HRTIMER_MODE_REL_SOFT);
 	refcount_set(&pool->users, 1);
 
 	pool->fq = xs->fq_tmp;
@@ -281,6 +293,8 @@ static void xp_release_deferred(struct work_struct *work)
 	xp_clear_dev(pool);
 	rtnl_unlock();
 
+	hrtimer_cancel(&pool->cq_timer);
+
 	if (pool->fq) {
 		xskq_destroy(pool->fq);
 		pool->fq = NULL;
@@ -331,16 +345,26 @@ static struct xsk_dma_map *xp_create_dma_map(struct device *dev, struct net_devi
 {
 	struct xsk_dma_map *dma_map;
 
-	dma_map = kzalloc(sizeof(*dma_map), GFP_KERNEL);
+	dma_map = kzalloc_node(sizeof(*dma_map), GFP_KERNEL, dev_to_node(dev));
 	if (!dma_map)
 		return NULL;
 
-	dma_map->dma_pages = kvcalloc(nr_pages, sizeof(*dma_map->dma_pages), GFP_KERNEL);
+	dma_map->dma_pages = kvcalloc_node(nr_pages, sizeof(*dma_map->dma_pages),
+					   GFP_KERNEL, dev_to_node(dev));
 	if (!dma_map->dma_pages) {
 		kfree(dma_map);
 		return NULL;
 	}
 
+	dma_map->map_starts = kvcalloc_node(BITS_TO_LONGS(nr_pages),
+					    sizeof(*dma_map->map_starts),
+					    GFP_KERNEL, dev_to_node(dev));
+	if (!dma_map->map_starts) {
+		kvfree(dma_map->dma_pages);
+		kfree(dma_map);
+		return NULL;
+	}
+
 	dma_map->netdev = netdev;
 	dma_map->dev = dev;
 	dma_map->dma_pages_cnt = nr_pages;
@@ -352,23 +376,26 @@ static struct xsk_dma_map *xp_create_dma_map(struct device *dev, struct net_devi
 static void xp_destroy_dma_map(struct xsk_dma_map *dma_map)
 {
 	list_del(&dma_map->list);
+	kvfree(dma_map->map_starts);
 	kvfree(dma_map->dma_pages);
 	kfree(dma_map);
 }
 
 static void __xp_dma_unmap(struct xsk_dma_map *dma_map, unsigned long attrs)
 {
-	dma_addr_t *dma;
-	u32 i;
+	unsigned long i, end;
+	dma_addr_t dma;
 
-	for (i = 0; i < dma_map->dma_pages_cnt; i++) {
-		dma = &dma_map->dma_pages[i];
-		if (*dma) {
-			*dma &= ~XSK_NEXT_PG_CONTIG_MASK;
-			dma_unmap_page_attrs(dma_map->dev, *dma, PAGE_SIZE,
+	for (i = 0; i < dma_map->dma_pages_cnt; i = end) {
+		end = find_next_bit(dma_map->map_starts, dma_map->dma_pages_cnt,
+				    i + 1);
+		dma = dma_map->dma_pages[i] & ~XSK_NEXT_PG_CONTIG_MASK;
+		if (dma)
+			dma_unmap_page_attrs(dma_map->dev, dma,
+					     (end - i) << PAGE_SHIFT,
 					     DMA_BIDIRECTIONAL, attrs);
-			*dma = 0;
-		}
+		memset(&dma_map->dma_pages[i], 0,
+		       (end - i) * sizeof(*dma_map->dma_pages));
 	}
 
 	xp_destroy_dma_map(dma_map);
@@ -393,6 +420,8 @@ void xp_dma_unmap(struct xsk_buff_pool *pool, unsigned long attrs)
 	kvfree(pool->dma_pages);
 	pool->dma_pages = NULL;
 	pool->dma_pages_cnt = 0;
+	pool->dma_contig = false;
+	pool->dma_base = 0;
 	pool->dev = NULL;
 }
 EXPORT_SYMBOL(xp_dma_unmap);
@@ -409,6 +438,19 @@ static void xp_check_dma_contiguity(struct xsk_dma_map *dma_map)
 	}
 }
 
+static bool xp_dma_map_is_contig(struct xsk_dma_map *dma_map)
+{
+	dma_addr_t base = dma_map->dma_pages[0] & ~XSK_NEXT_PG_CONTIG_MASK;
+	u32 i;
+
+	for (i = 1; i < dma_map->dma_pages_cnt; i++)
+		if ((dma_map->dma_pages[i] & ~XSK_NEXT_PG_CONTIG_MASK) !=
+		    base + ((dma_addr_t)i << PAGE_SHIFT))
+			return false;
+
+	return true;
+}
+
 static int xp_init_dma_info(struct xsk_buff_pool *pool, struct xsk_dma_map *dma_map)
 {
 	if (!pool->unaligned) {
@@ -423,7 +465,8 @@ static int xp_init_dma_info(struct xsk_buff_pool *pool, struct xsk_dma_map *dma_
 		}
 	}
 
-	pool->dma_pages = kvcalloc(dma_map->dma_pages_cnt, sizeof(*pool->dma_pages), GFP_KERNEL);
+	pool->dma_pages = kvcalloc_node(dma_map->dma_pages_cnt, sizeof(*pool->dma_pages),
+					GFP_KERNEL, pool->node);
 	if (!pool->dma_pages)
 		return -ENOMEM;
 
@@ -431,17 +474,40 @@ static int xp_init_dma_info(struct xsk_buff_pool *pool, struct xsk_dma_map *dma_
 	pool->dma_pages_cnt = dma_map->dma_pages_cnt;
 	memcpy(pool->dma_pages, dma_map->dma_pages,
 	       pool->dma_pages_cnt * sizeof(*pool->dma_pages));
+	pool->dma_contig = xp_dma_map_is_contig(dma_map);
+	pool->dma_base = pool->dma_pages[0] & ~XSK_NEXT_PG_CONTIG_MASK;
 
 	return 0;
 }
 
+/* Number of pages starting at @start that are physically contiguous within
+ * one folio and can be mapped as a single IOVA range. For a UMEM backed by
+ * huge pages this covers the whole huge page, so the IOMMU can use large
+ * IOTLB entries and chunks may cross 4K boundaries inside it.
+ */
+static u32 xp_dma_run_len(struct device *dev, struct page **pages, u32 start,
+			  u32 nr_pages)
+{
+	size_t max = max_t(size_t, dma_max_mapping_size(dev) >> PAGE_SHIFT, 1);
+	struct folio *folio = page_folio(pages[start]);
+	unsigned long pfn = page_to_pfn(pages[start]);
+	u32 n = 1;
+
+	while (start + n < nr_pages && n < max &&
+	       page_folio(pages[start + n]) == folio &&
+	       page_to_pfn(pages[start + n]) == pfn + n)
+		n++;
+
+	return n;
+}
+
 int xp_dma_map(struct xsk_buff_pool *pool, struct device *dev,
 	       unsigned long attrs, struct page **pages, u32 nr_pages)
 {
 	struct xsk_dma_map *dma_map;
 	dma_addr_t dma;
+	u32 i, j, n;
 	int err;
-	u32 i;
 
 	dma_map = xp_find_dma_map(pool);
 	if (dma_map) {
@@ -457,14 +523,17 @@ int xp_dma_map(struct xsk_buff_pool *pool, struct device *dev,
 	if (!dma_map)
 		return -ENOMEM;
 
-	for (i = 0; i < dma_map->dma_pages_cnt; i++) {
-		dma = dma_map_page_attrs(dev, pages[i], 0, PAGE_SIZE,
+	for (i = 0; i < dma_map->dma_pages_cnt; i += n) {
+		n = xp_dma_run_len(dev, pages, i, dma_map->dma_pages_cnt);
+		__set_bit(i, dma_map->map_starts);
+		dma = dma_map_page_attrs(dev, pages[i], 0, (size_t)n << PAGE_SHIFT,
 					 DMA_BIDIRECTIONAL, attrs);
 		if (dma_mapping_error(dev, dma)) {
 			__xp_dma_unmap(dma_map, attrs);
 			return -ENOMEM;
 		}
-		dma_map->dma_pages[i] = dma;
+		for (j = 0; j < n; j++)
+			dma_map->dma_pages[i + j] = dma + ((dma_addr_t)j << PAGE_SHIFT);
 	}
 
 	if (pool->unaligned)
@@ -709,6 +778,8 @@ EXPORT_SYMBOL(xp_raw_get_data);
 dma_addr_t xp_raw_get_dma(struct xsk_buff_pool *pool, u64 addr)
 {
 	addr = pool->unaligned ? xp_unaligned_add_offset_to_addr(addr) : addr;
+	if (pool->dma_contig)
+		return pool->dma_base + addr;
 	return (pool->dma_pages[addr >> PAGE_SHIFT] &
 		~XSK_NEXT_PG_CONTIG_MASK) +
 		(addr & ~PAGE_MASK);
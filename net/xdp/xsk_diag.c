@@ -89,6 +89,34 @@ static int xsk_diag_put_stats(const struct xdp_sock *xs, struct sk_buff *nlskb)
 	return nla_put(nlskb, XDP_DIAG_STATS, sizeof(du), &du);
 }
 
+static void xsk_diag_put_hist(__u64 *dst, const struct xsk_lat_hist *h)
+{
+	int i;
+
+	for (i = 0; i < XSK_LAT_BUCKETS; i++)
+		dst[i] = atomic64_read(&h->buckets[i]);
+}
+
+static int xsk_diag_put_latency(const struct xdp_sock *xs,
+				struct sk_buff *nlskb)
+{
+	struct xdp_diag_latency dl = {};
+
+	BUILD_BUG_ON(XSK_LAT_BUCKETS != XDP_DIAG_LAT_BUCKETS);
+
+	if (!xs->lat_stats)
+		return 0;
+
+	if (xs->rx)
+		xsk_diag_put_hist(dl.rx_residency, &xs->rx_lat);
+	if (xs->pool && xs->pool->lat_stats)
+		xsk_diag_put_hist(dl.tx_completion, &xs->pool->tx_lat);
+	dl.n_rx_wakeups = xs->rx_wakeups;
+	dl.n_tx_wakeups = xs->tx_wakeups;
+	dl.n_poll_wakeups = xs->poll_wakeups;
+	return nla_put(nlskb, XDP_DIAG_LATENCY, sizeof(dl), &dl);
+}
+
 static int xsk_diag_fill(struct sock *sk, struct sk_buff *nlskb,
 			 struct xdp_diag_req *req,
 			 struct user_namespace *user_ns,
@@ -138,6 +166,10 @@ static int xsk_diag_fill(struct sock *sk, struct sk_buff *nlskb,
 	    xsk_diag_put_stats(xs, nlskb))
 		goto out_nlmsg_trim;
 
+	if ((req->xdiag_show & XDP_SHOW_LATENCY) &&
+	    xsk_diag_put_latency(xs, nlskb))
+		goto out_nlmsg_trim;
+
 	mutex_unlock(&xs->mutex);
 	nlmsg_end(nlskb, nlh);
 	return 0;
@@ -11,6 +11,8 @@
 #include <linux/rcupdate.h>
 #include <linux/moduleparam.h>
 #include <linux/fsverity.h>
+#include <linux/bitfield.h>
+#include <linux/seqlock.h>
 
 #include "ipe.h"
 #include "eval.h"
@@ -21,6 +23,7 @@
 struct ipe_policy __rcu *ipe_active_policy;
 bool success_audit;
 bool enforce = true;
+DEFINE_SEQLOCK(ipe_decision_lock);
 #define INO_BLOCK_DEV(ino) ((ino)->i_sb->s_bdev)
 
 #define FILE_SUPERBLOCK(f) ((f)->f_path.mnt->mnt_sb)
@@ -58,6 +61,7 @@ static void build_ipe_inode_blob_ctx(struct ipe_eval_ctx *ctx,
 				     const struct inode *const ino)
 {
 	ctx->ipe_inode = ipe_inode(ctx->ino);
+	ctx->fs_verity_signed = READ_ONCE(ctx->ipe_inode->fs_verity_signed);
 }
 #else
 static inline void build_ipe_inode_blob_ctx(struct ipe_eval_ctx *ctx,
@@ -73,7 +77,6 @@ static inline void build_ipe_inode_blob_ctx(struct ipe_eval_ctx *ctx,
  */
 static void build_ipe_inode_ctx(struct ipe_eval_ctx *ctx, const struct inode *const ino)
 {
-	ctx->ino = ino;
 	build_ipe_inode_blob_ctx(ctx, ino);
 }
 #else
@@ -103,6 +106,7 @@ void ipe_build_eval_ctx(struct ipe_eval_ctx *ctx,
 	if (file) {
 		build_ipe_sb_ctx(ctx, file);
 		ino = d_real_inode(file->f_path.dentry);
+		ctx->ino = ino;
 		build_ipe_bdev_ctx(ctx, ino);
 		build_ipe_inode_ctx(ctx, ino);
 	}
@@ -238,7 +242,7 @@ static bool evaluate_fsv_sig_false(const struct ipe_eval_ctx *const ctx)
 	return !ctx->ino ||
 	       !IS_VERITY(ctx->ino) ||
 	       !ctx->ipe_inode ||
-	       !ctx->ipe_inode->fs_verity_signed;
+	       !ctx->fs_verity_signed;
 }
 
 /**
@@ -302,6 +306,135 @@ static bool evaluate_property(const struct ipe_eval_ctx *const ctx,
 	}
 }
 
+/*
+ * The decision of the last evaluation is cached in the inode's blob as a
+ * single word, so that it can be read and written without locking:
+ *
+ * * the ipe_decision_lock sequence it was made under, which changes when
+ *   the active policy or any integrity data other than the inode's own
+ *   changes;
+ * * the other inputs which may differ for the same inode: the operation,
+ *   the boot_verified state of the file's superblock, whether fs-verity
+ *   is enabled on the inode and whether its builtin signature was verified;
+ * * the result: how it matched, the action and the index of the rule.
+ */
+#define IPE_DECISION_SEQ	GENMASK_ULL(63, 32)
+#define IPE_DECISION_VALID	BIT_ULL(31)
+#define IPE_DECISION_INITRAMFS	BIT_ULL(30)
+#define IPE_DECISION_VERITY	BIT_ULL(29)
+#define IPE_DECISION_OP		GENMASK_ULL(28, 26)
+#define IPE_DECISION_MATCH	GENMASK_ULL(25, 24)
+#define IPE_DECISION_ACTION	BIT_ULL(23)
+#define IPE_DECISION_FSV_SIG	BIT_ULL(22)
+#define IPE_DECISION_RULE	GENMASK_ULL(21, 0)
+
+#ifdef CONFIG_IPE_PROP_FS_VERITY_BUILTIN_SIG
+static bool ipe_decision_fsv_sig(const struct ipe_eval_ctx *const ctx)
+{
+	return ctx->ipe_inode && ctx->fs_verity_signed;
+}
+#else
+static bool ipe_decision_fsv_sig(const struct ipe_eval_ctx *const ctx)
+{
+	return false;
+}
+#endif /* CONFIG_IPE_PROP_FS_VERITY_BUILTIN_SIG */
+
+static u64 ipe_decision_key(const struct ipe_eval_ctx *const ctx, unsigned int seq)
+{
+	return FIELD_PREP(IPE_DECISION_SEQ, seq) | IPE_DECISION_VALID |
+	       (ctx->initramfs ? IPE_DECISION_INITRAMFS : 0) |
+	       (IS_VERITY(ctx->ino) ? IPE_DECISION_VERITY : 0) |
+	       (ipe_decision_fsv_sig(ctx) ? IPE_DECISION_FSV_SIG : 0) |
+	       FIELD_PREP(IPE_DECISION_OP, ctx->op);
+}
+
+#define IPE_DECISION_KEY	(IPE_DECISION_SEQ | IPE_DECISION_VALID |	\
+				 IPE_DECISION_INITRAMFS | IPE_DECISION_VERITY |	\
+				 IPE_DECISION_FSV_SIG | IPE_DECISION_OP)
+
+/**
+ * ipe_cached_decision() - Look up the cached decision for @ctx.
+ * @ctx: Supplies a pointer to the context being evaluated.
+ * @rules: Supplies the operation's rule table of the active policy.
+ * @seq: Supplies the ipe_decision_lock sequence the policy was read under.
+ * @action: Returns the cached action.
+ * @match_type: Returns the cached match type.
+ * @rule: Returns the matched rule, for IPE_MATCH_RULE.
+ *
+ * Return: %true if there is a valid cached decision, %false otherwise.
+ */
+static bool ipe_cached_decision(const struct ipe_eval_ctx *const ctx,
+				const struct ipe_op_table *rules, unsigned int seq,
+				enum ipe_action_type *action,
+				enum ipe_match *match_type,
+				const struct ipe_rule **rule)
+{
+	u64 d;
+	size_t i;
+
+	if (!ctx->ino)
+		return false;
+
+	d = atomic64_read(&ipe_inode(ctx->ino)->decision);
+	if ((d & IPE_DECISION_KEY) != ipe_decision_key(ctx, seq))
+		return false;
+
+	/* the policy read under @seq may have been replaced meanwhile */
+	if (read_seqretry(&ipe_decision_lock, seq))
+		return false;
+
+	*match_type = FIELD_GET(IPE_DECISION_MATCH, d);
+	*action = FIELD_GET(IPE_DECISION_ACTION, d);
+	if (*match_type == IPE_MATCH_RULE) {
+		i = FIELD_GET(IPE_DECISION_RULE, d);
+		if (WARN_ON_ONCE(i >= rules->rule_count))
+			return false;
+		*rule = rules->rule_vec[i];
+	}
+
+	return true;
+}
+
+/**
+ * ipe_cache_decision() - Cache the decision just made for @ctx.
+ * @ctx: Supplies a pointer to the context that was evaluated.
+ * @seq: Supplies the ipe_decision_lock sequence the policy was read under.
+ * @action: Supplies the action.
+ * @match_type: Supplies the match type.
+ * @idx: Supplies the index of the matched rule, for IPE_MATCH_RULE.
+ */
+static void ipe_cache_decision(const struct ipe_eval_ctx *const ctx,
+			       unsigned int seq, enum ipe_action_type action,
+			       enum ipe_match match_type, size_t idx)
+{
+	if (!ctx->ino || action >= IPE_ACTION_INVALID ||
+	    idx > FIELD_MAX(IPE_DECISION_RULE))
+		return;
+
+	/* made with a policy or integrity data that's gone already */
+	if (read_seqretry(&ipe_decision_lock, seq))
+		return;
+
+	atomic64_set(&ipe_inode(ctx->ino)->decision,
+		     ipe_decision_key(ctx, seq) |
+		     FIELD_PREP(IPE_DECISION_MATCH, match_type) |
+		     FIELD_PREP(IPE_DECISION_ACTION, action) |
+		     FIELD_PREP(IPE_DECISION_RULE, idx));
+}
+
+/**
+ * ipe_invalidate_decisions() - Invalidate all cached decisions.
+ *
+ * Must be called after changing integrity data that the evaluation of any
+ * number of inodes depends on.
+ */
+void ipe_invalidate_decisions(void)
+{
+	write_seqlock(&ipe_decision_lock);
+	write_sequnlock(&ipe_decision_lock);
+}
+
 /**
  * ipe_evaluate_event() - Analyze @ctx against the current active policy.
  * @ctx: Supplies a pointer to the context to be evaluated.
@@ -321,10 +454,13 @@ int ipe_evaluate_event(const struct ipe_eval_ctx *const ctx)
 	enum ipe_action_type action;
 	enum ipe_match match_type;
 	bool match = false;
+	unsigned int seq;
+	size_t idx = 0;
 	int rc = 0;
 
 	rcu_read_lock();
 
+	seq = read_seqbegin(&ipe_decision_lock);
 	pol = rcu_dereference(ipe_active_policy);
 	if (!pol) {
 		rcu_read_unlock();
@@ -344,6 +480,9 @@ int ipe_evaluate_event(const struct ipe_eval_ctx *const ctx)
 
 	rules = &pol->parsed->rules[ctx->op];
 
+	if (ipe_cached_decision(ctx, rules, seq, &action, &match_type, &rule))
+		goto eval;
+
 	list_for_each_entry(rule, &rules->rules, next) {
 		match = true;
 
@@ -355,6 +494,7 @@ int ipe_evaluate_event(const struct ipe_eval_ctx *const ctx)
 
 		if (match)
 			break;
+		idx++;
 	}
 
 	if (match) {
@@ -368,6 +508,8 @@ int ipe_evaluate_event(const struct ipe_eval_ctx *const ctx)
 		match_type = IPE_MATCH_GLOBAL;
 	}
 
+	ipe_cache_decision(ctx, seq, action, match_type, idx);
+
 eval:
 	ipe_audit_match(ctx, match_type, action, rule);
 	rcu_read_unlock();
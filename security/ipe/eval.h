@@ -8,6 +8,7 @@
 
 #include <linux/file.h>
 #include <linux/types.h>
+#include <linux/seqlock.h>
 
 #include "policy.h"
 #include "hooks.h"
@@ -17,6 +18,7 @@
 extern struct ipe_policy __rcu *ipe_active_policy;
 extern bool success_audit;
 extern bool enforce;
+extern seqlock_t ipe_decision_lock;
 
 struct ipe_superblock {
 	bool initramfs;
@@ -31,26 +33,28 @@ struct ipe_bdev {
 };
 #endif /* CONFIG_IPE_PROP_DM_VERITY */
 
-#ifdef CONFIG_IPE_PROP_FS_VERITY_BUILTIN_SIG
 struct ipe_inode {
+	/* decision of the last evaluation, see ipe_cache_decision() */
+	atomic64_t decision;
+#ifdef CONFIG_IPE_PROP_FS_VERITY_BUILTIN_SIG
 	bool fs_verity_signed;
-};
 #endif /* CONFIG_IPE_PROP_FS_VERITY_BUILTIN_SIG */
+};
 
 struct ipe_eval_ctx {
 	enum ipe_op_type op;
 	enum ipe_hook_type hook;
 
 	const struct file *file;
+	const struct inode *ino;
 	bool initramfs;
 #ifdef CONFIG_IPE_PROP_DM_VERITY
 	const struct ipe_bdev *ipe_bdev;
 #endif /* CONFIG_IPE_PROP_DM_VERITY */
-#ifdef CONFIG_IPE_PROP_FS_VERITY
-	const struct inode *ino;
-#endif /* CONFIG_IPE_PROP_FS_VERITY */
 #ifdef CONFIG_IPE_PROP_FS_VERITY_BUILTIN_SIG
 	const struct ipe_inode *ipe_inode;
+	/* snapshot of ipe_inode->fs_verity_signed for this evaluation */
+	bool fs_verity_signed;
 #endif /* CONFIG_IPE_PROP_FS_VERITY_BUILTIN_SIG */
 };
 
@@ -66,5 +70,6 @@ void ipe_build_eval_ctx(struct ipe_eval_ctx *ctx,
 			enum ipe_op_type op,
 			enum ipe_hook_type hook);
 int ipe_evaluate_event(const struct ipe_eval_ctx *const ctx);
+void ipe_invalidate_decisions(void);
 
 #endif /* _IPE_EVAL_H */
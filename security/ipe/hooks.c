@@ -192,6 +192,7 @@ int ipe_kernel_load_data(enum kernel_load_data_id id, bool contents)
 void ipe_unpack_initramfs(void)
 {
 	ipe_sb(current->fs->root.mnt->mnt_sb)->initramfs = true;
+	ipe_invalidate_decisions();
 }
 
 #ifdef CONFIG_IPE_PROP_DM_VERITY
@@ -244,6 +245,7 @@ int ipe_bdev_setintegrity(struct block_device *bdev, enum lsm_integrity_type typ
 
 	if (type == LSM_INT_DMVERITY_SIG_VALID) {
 		ipe_set_dmverity_signature(blob, value, size);
+		ipe_invalidate_decisions();
 
 		return 0;
 	}
@@ -254,6 +256,7 @@ int ipe_bdev_setintegrity(struct block_device *bdev, enum lsm_integrity_type typ
 	if (!value) {
 		ipe_digest_free(blob->root_hash);
 		blob->root_hash = NULL;
+		ipe_invalidate_decisions();
 
 		return 0;
 	}
@@ -275,6 +278,7 @@ int ipe_bdev_setintegrity(struct block_device *bdev, enum lsm_integrity_type typ
 
 	ipe_digest_free(blob->root_hash);
 	blob->root_hash = info;
+	ipe_invalidate_decisions();
 
 	return 0;
 err:
@@ -305,7 +309,8 @@ int ipe_inode_setintegrity(const struct inode *inode,
 	struct ipe_inode *inode_sec = ipe_inode(inode);
 
 	if (type == LSM_INT_FSVERITY_BUILTINSIG_VALID) {
-		inode_sec->fs_verity_signed = size > 0 && value;
+		/* part of the inode's cached decision key */
+		WRITE_ONCE(inode_sec->fs_verity_signed, size > 0 && value);
 		return 0;
 	}
 
@@ -119,7 +119,9 @@ int ipe_update_policy(struct inode *root, const char *text, size_t textlen,
 	ap = rcu_dereference_protected(ipe_active_policy,
 				       lockdep_is_held(&ipe_policy_lock));
 	if (old == ap) {
+		write_seqlock(&ipe_decision_lock);
 		rcu_assign_pointer(ipe_active_policy, new);
+		write_sequnlock(&ipe_decision_lock);
 		mutex_unlock(&ipe_policy_lock);
 		ipe_audit_policy_activation(old, new);
 	} else {
@@ -231,7 +233,9 @@ int ipe_set_active_pol(const struct ipe_policy *p)
 		return -EINVAL;
 	}
 
+	write_seqlock(&ipe_decision_lock);
 	rcu_assign_pointer(ipe_active_policy, p);
+	write_sequnlock(&ipe_decision_lock);
 	ipe_audit_policy_activation(ap, p);
 	mutex_unlock(&ipe_policy_lock);
 
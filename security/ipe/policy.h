@@ -59,6 +59,9 @@ struct ipe_rule {
 
 struct ipe_op_table {
 	struct list_head rules;
+	/* the rules above, indexed in order of evaluation */
+	const struct ipe_rule **rule_vec;
+	size_t rule_count;
 	enum ipe_action_type default_action;
 };
 
@@ -454,11 +454,13 @@ void ipe_free_parsed_policy(struct ipe_parsed_policy *p)
 	if (IS_ERR_OR_NULL(p))
 		return;
 
-	for (i = 0; i < ARRAY_SIZE(p->rules); ++i)
+	for (i = 0; i < ARRAY_SIZE(p->rules); ++i) {
 		list_for_each_entry_safe(pp, t, &p->rules[i].rules, next) {
 			list_del(&pp->next);
 			free_rule(pp);
 		}
+		kfree(p->rules[i].rule_vec);
+	}
 
 	kfree(p->name);
 	kfree(p);
@@ -490,6 +492,41 @@ static int validate_policy(const struct ipe_parsed_policy *p)
 	return 0;
 }
 
+/**
+ * compile_policy() - Index the rules of a parsed policy.
+ * @p: Supplies the fully parsed policy.
+ *
+ * The evaluation refers to the rules by their position in the rule list of
+ * their operation, so that a decision can be cached as a plain integer.
+ *
+ * Return:
+ * * %0		- Success
+ * * %-ENOMEM	- Out of memory (OOM)
+ */
+static int compile_policy(struct ipe_parsed_policy *p)
+{
+	struct ipe_op_table *table;
+	const struct ipe_rule *r;
+	size_t i, n;
+
+	for (i = 0; i < ARRAY_SIZE(p->rules); ++i) {
+		table = &p->rules[i];
+
+		n = list_count_nodes(&table->rules);
+		if (!n)
+			continue;
+
+		table->rule_vec = kcalloc(n, sizeof(*table->rule_vec), GFP_KERNEL);
+		if (!table->rule_vec)
+			return -ENOMEM;
+
+		list_for_each_entry(r, &table->rules, next)
+			table->rule_vec[table->rule_count++] = r;
+	}
+
+	return 0;
+}
+
 /**
  * ipe_parse_policy() - Given a string, parse the string into an IPE policy.
  * @p: partially filled ipe_policy structure to populate with the result.
@@ -548,6 +585,10 @@ int ipe_parse_policy(struct ipe_policy *p)
 		goto err;
 	}
 
+	rc = compile_policy(pp);
+	if (rc)
+		goto err;
+
 	p->parsed = pp;
 
 out:
@@ -247,7 +247,9 @@ KUNIT_ARRAY_PARAM(ipe_policies, policy_cases, pol_to_desc);
 static void ipe_parser_unsigned_test(struct kunit *test)
 {
 	const struct policy_case *p = test->param_value;
+	const struct ipe_rule *r;
 	struct ipe_policy *pol;
+	size_t i;
 
 	pol = ipe_new_policy(p->policy, strlen(p->policy), NULL, 0);
 
@@ -262,6 +264,19 @@ static void ipe_parser_unsigned_test(struct kunit *test)
 	KUNIT_EXPECT_PTR_EQ(test, NULL, pol->pkcs7);
 	KUNIT_EXPECT_EQ(test, 0, pol->pkcs7len);
 
+	/* the rule vectors index the rules in their evaluation order */
+	for (i = 0; i < ARRAY_SIZE(pol->parsed->rules); ++i) {
+		const struct ipe_op_table *table = &pol->parsed->rules[i];
+		size_t n = 0;
+
+		list_for_each_entry(r, &table->rules, next) {
+			KUNIT_ASSERT_LT(test, n, table->rule_count);
+			KUNIT_EXPECT_PTR_EQ(test, r, table->rule_vec[n]);
+			n++;
+		}
+		KUNIT_EXPECT_EQ(test, n, table->rule_count);
+	}
+
 	ipe_free_policy(pol);
 }
 
@@ -1220,6 +1220,7 @@ static int __init alsa_pcm_init(void)
 	snd_ctl_register_ioctl(snd_pcm_control_ioctl);
 	snd_ctl_register_ioctl_compat(snd_pcm_control_ioctl);
 	snd_pcm_proc_init();
+	snd_pcm_buffer_cache_init();
 	return 0;
 }
 
@@ -1228,6 +1229,7 @@ static void __exit alsa_pcm_exit(void)
 	snd_ctl_unregister_ioctl(snd_pcm_control_ioctl);
 	snd_ctl_unregister_ioctl_compat(snd_pcm_control_ioctl);
 	snd_pcm_proc_done();
+	snd_pcm_buffer_cache_done();
 }
 
 module_init(alsa_pcm_init)
@@ -10,6 +10,7 @@
 #include <linux/slab.h>
 #include <linux/moduleparam.h>
 #include <linux/export.h>
+#include <linux/shrinker.h>
 #include <sound/core.h>
 #include <sound/pcm.h>
 #include <sound/info.h>
@@ -30,6 +31,10 @@ static unsigned long max_alloc_per_card = 32UL * 1024UL * 1024UL;
 module_param(max_alloc_per_card, ulong, 0644);
 MODULE_PARM_DESC(max_alloc_per_card, "Max total allocation bytes per card.");
 
+static unsigned long buffer_cache_size = 16UL * 1024UL * 1024UL;
+module_param(buffer_cache_size, ulong, 0644);
+MODULE_PARM_DESC(buffer_cache_size, "Max total bytes of released buffers kept for reuse.");
+
 static void __update_allocated_size(struct snd_card *card, ssize_t bytes)
 {
 	card->total_pcm_alloc_bytes += bytes;
@@ -89,6 +94,166 @@ static void do_free_pages(struct snd_card *card, struct snd_dma_buffer *dmab)
 	dmab->area = NULL;
 }
 
+/*
+ * Cache of the buffers released by snd_pcm_lib_free_pages(), so that
+ * reopening or reconfiguring a stream doesn't have to go through the page
+ * allocation and the IOMMU mapping again, nor fail because memory got
+ * fragmented in the meantime.  The cached buffers stay accounted to their
+ * card, they are evicted oldest first beyond buffer_cache_size and on
+ * memory pressure, and released when the PCM goes away.
+ */
+struct pcm_cached_buffer {
+	struct list_head list;
+	struct snd_pcm *pcm;
+	struct snd_dma_buffer *dmab;
+};
+
+static LIST_HEAD(buffer_cache);		/* the oldest first */
+static DEFINE_MUTEX(buffer_cache_lock);
+static unsigned long buffer_cache_bytes;
+static struct shrinker *buffer_cache_shrinker;
+
+/*
+ * release the given cached buffer; called with buffer_cache_lock held, as
+ * that's the only thing keeping its PCM and card from going away
+ */
+static void buffer_cache_evict(struct pcm_cached_buffer *cb)
+{
+	list_del(&cb->list);
+	buffer_cache_bytes -= cb->dmab->bytes;
+	do_free_pages(cb->pcm->card, cb->dmab);
+	kfree(cb->dmab);
+	kfree(cb);
+}
+
+/*
+ * take the most recent cached buffer for the same device and direction,
+ * in the size class of the request, i.e. not more than twice as large
+ */
+static struct snd_dma_buffer *buffer_cache_get(struct snd_pcm_substream *substream,
+					       size_t size)
+{
+	struct snd_dma_device *dev = &substream->dma_buffer.dev;
+	struct snd_card *card = substream->pcm->card;
+	struct snd_dma_buffer *dmab;
+	struct pcm_cached_buffer *cb;
+	enum dma_data_direction dir;
+
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+		dir = DMA_TO_DEVICE;
+	else
+		dir = DMA_FROM_DEVICE;
+
+	guard(mutex)(&buffer_cache_lock);
+	list_for_each_entry_reverse(cb, &buffer_cache, list) {
+		dmab = cb->dmab;
+		if (cb->pcm->card != card || dmab->dev.type != dev->type ||
+		    dmab->dev.dev != dev->dev || dmab->dev.dir != dir)
+			continue;
+		if (dmab->bytes < size || dmab->bytes / 2 > size)
+			continue;
+		list_del(&cb->list);
+		buffer_cache_bytes -= dmab->bytes;
+		kfree(cb);
+		return dmab;
+	}
+	return NULL;
+}
+
+/* keep the released buffer for reuse; returns false if not taken */
+static bool buffer_cache_put(struct snd_pcm_substream *substream,
+			     struct snd_dma_buffer *dmab)
+{
+	unsigned long limit = READ_ONCE(buffer_cache_size);
+	struct pcm_cached_buffer *cb;
+
+	/* the buffer contents aren't cleared for the drivers copying */
+	if (!buffer_cache_shrinker || dmab->bytes > limit ||
+	    substream->ops->copy)
+		return false;
+
+	cb = kmalloc(sizeof(*cb), GFP_KERNEL);
+	if (!cb)
+		return false;
+	cb->pcm = substream->pcm;
+	cb->dmab = dmab;
+
+	guard(mutex)(&buffer_cache_lock);
+	list_add_tail(&cb->list, &buffer_cache);
+	buffer_cache_bytes += dmab->bytes;
+	while (buffer_cache_bytes > limit)
+		buffer_cache_evict(list_first_entry(&buffer_cache,
+						    struct pcm_cached_buffer,
+						    list));
+	return true;
+}
+
+/*
+ * release the cached buffers of the given PCM, or all of the card ones if
+ * @pcm is NULL; returns true if anything was released
+ */
+static bool buffer_cache_drop(struct snd_card *card, struct snd_pcm *pcm)
+{
+	struct pcm_cached_buffer *cb, *next;
+	bool dropped = false;
+
+	guard(mutex)(&buffer_cache_lock);
+	list_for_each_entry_safe(cb, next, &buffer_cache, list) {
+		if (pcm ? cb->pcm == pcm : cb->pcm->card == card) {
+			buffer_cache_evict(cb);
+			dropped = true;
+		}
+	}
+	return dropped;
+}
+
+static unsigned long buffer_cache_count(struct shrinker *shrink,
+					struct shrink_control *sc)
+{
+	unsigned long pages = READ_ONCE(buffer_cache_bytes) >> PAGE_SHIFT;
+
+	return pages ?: SHRINK_EMPTY;
+}
+
+static unsigned long buffer_cache_scan(struct shrinker *shrink,
+				       struct shrink_control *sc)
+{
+	struct pcm_cached_buffer *cb;
+	unsigned long freed = 0;
+
+	if (!mutex_trylock(&buffer_cache_lock))
+		return SHRINK_STOP;
+	while (freed < sc->nr_to_scan && !list_empty(&buffer_cache)) {
+		cb = list_first_entry(&buffer_cache, struct pcm_cached_buffer,
+				      list);
+		freed += cb->dmab->bytes >> PAGE_SHIFT;
+		buffer_cache_evict(cb);
+	}
+	mutex_unlock(&buffer_cache_lock);
+
+	return freed;
+}
+
+void __init snd_pcm_buffer_cache_init(void)
+{
+	buffer_cache_shrinker = shrinker_alloc(0, "snd-pcm-buffer");
+	if (!buffer_cache_shrinker) {
+		pr_warn("ALSA: cannot register the PCM buffer cache shrinker\n");
+		return;
+	}
+
+	buffer_cache_shrinker->count_objects = buffer_cache_count;
+	buffer_cache_shrinker->scan_objects = buffer_cache_scan;
+	shrinker_register(buffer_cache_shrinker);
+}
+
+void snd_pcm_buffer_cache_done(void)
+{
+	/* all PCMs, and so their cached buffers, are gone by now */
+	shrinker_free(buffer_cache_shrinker);
+	buffer_cache_shrinker = NULL;
+}
+
 /*
  * try to allocate as the large pages as possible.
  * stores the resultant memory size in *res_size.
@@ -142,6 +307,7 @@ void snd_pcm_lib_preallocate_free_for_all(struct snd_pcm *pcm)
 	struct snd_pcm_substream *substream;
 	int stream;
 
+	buffer_cache_drop(pcm->card, pcm);
 	for_each_pcm_substream(pcm, stream, substream)
 		snd_pcm_lib_preallocate_free(substream);
 }
@@ -422,6 +588,7 @@ int snd_pcm_lib_malloc_pages(struct snd_pcm_substream *substream, size_t size)
 	struct snd_card *card;
 	struct snd_pcm_runtime *runtime;
 	struct snd_dma_buffer *dmab = NULL;
+	int err;
 
 	if (PCM_RUNTIME_CHECK(substream))
 		return -EINVAL;
@@ -448,21 +615,32 @@ int snd_pcm_lib_malloc_pages(struct snd_pcm_substream *substream, size_t size)
 		/* dma_max=0 means the fixed size preallocation */
 		if (substream->dma_buffer.area && !substream->dma_max)
 			return -ENOMEM;
-		dmab = kzalloc(sizeof(*dmab), GFP_KERNEL);
-		if (! dmab)
-			return -ENOMEM;
-		dmab->dev = substream->dma_buffer.dev;
-		if (do_alloc_pages(card,
-				   substream->dma_buffer.dev.type,
-				   substream->dma_buffer.dev.dev,
-				   substream->stream,
-				   size, dmab) < 0) {
-			kfree(dmab);
-			pr_debug("ALSA pcmC%dD%d%c,%d:%s: cannot preallocate for size %zu\n",
-				 substream->pcm->card->number, substream->pcm->device,
-				 substream->stream ? 'c' : 'p', substream->number,
-				 substream->pcm->name, size);
-			return -ENOMEM;
+		dmab = buffer_cache_get(substream, size);
+		if (!dmab) {
+			dmab = kzalloc(sizeof(*dmab), GFP_KERNEL);
+			if (!dmab)
+				return -ENOMEM;
+			dmab->dev = substream->dma_buffer.dev;
+			err = do_alloc_pages(card,
+					     substream->dma_buffer.dev.type,
+					     substream->dma_buffer.dev.dev,
+					     substream->stream,
+					     size, dmab);
+			/* retry with the cached buffers of the card released */
+			if (err < 0 && buffer_cache_drop(card, NULL))
+				err = do_alloc_pages(card,
+						     substream->dma_buffer.dev.type,
+						     substream->dma_buffer.dev.dev,
+						     substream->stream,
+						     size, dmab);
+			if (err < 0) {
+				kfree(dmab);
+				pr_debug("ALSA pcmC%dD%d%c,%d:%s: cannot preallocate for size %zu\n",
+					 substream->pcm->card->number, substream->pcm->device,
+					 substream->stream ? 'c' : 'p', substream->number,
+					 substream->pcm->name, size);
+				return -ENOMEM;
+			}
 		}
 	}
 	snd_pcm_set_runtime_buffer(substream, dmab);
@@ -491,9 +669,13 @@ int snd_pcm_lib_free_pages(struct snd_pcm_substream *substream)
 	if (runtime->dma_buffer_p != &substream->dma_buffer) {
 		struct snd_card *card = substream->pcm->card;
 
-		/* it's a newly allocated buffer.  release it now. */
-		do_free_pages(card, runtime->dma_buffer_p);
-		kfree(runtime->dma_buffer_p);
+		/* it's a newly allocated buffer.  keep it for reuse or
+		 * release it now.
+		 */
+		if (!buffer_cache_put(substream, runtime->dma_buffer_p)) {
+			do_free_pages(card, runtime->dma_buffer_p);
+			kfree(runtime->dma_buffer_p);
+		}
 	}
 	snd_pcm_set_runtime_buffer(substream, NULL);
 	return 0;
@@ -8,6 +8,7 @@
 
 #include <sound/seq_kernel.h>
 #include <linux/poll.h>
+#include <linux/rbtree.h>
 
 struct snd_info_buffer;
 
@@ -33,6 +34,7 @@ struct snd_seq_event_cell {
 	};
 	struct snd_seq_pool *pool;				/* used pool */
 	struct snd_seq_event_cell *next;	/* next cell */
+	struct rb_node node;			/* node in prioq */
 };
 
 /* design note: the pool is a contiguous block of memory, if we dynamicly
@@ -11,29 +11,15 @@
 #include "seq_prioq.h"
 
 
-/* Implementation is a simple linked list for now...
+/* Implementation is a red-black tree of the cells, cached leftmost.
 
    This priority queue orders the events on timestamp. For events with an
-   equeal timestamp the queue behaves as a FIFO. 
-
-   *
-   *           +-------+
-   *  Head --> | first |
-   *           +-------+
-   *                 |next
-   *           +-----v-+
-   *           |       |
-   *           +-------+
-   *                 |
-   *           +-----v-+
-   *           |       |
-   *           +-------+
-   *                 |
-   *           +-----v-+
-   *  Tail --> | last  |
-   *           +-------+
-   *
+   equal timestamp the queue behaves as a FIFO, except for the events with
+   the high priority flag, which go before all the others with the same
+   timestamp.
 
+   Insertion is O(log n), which keeps large scheduled streams cheap, and
+   the earliest event is always at hand for the dequeue.
  */
 
 
@@ -48,8 +34,7 @@ struct snd_seq_prioq *snd_seq_prioq_new(void)
 		return NULL;
 	
 	spin_lock_init(&f->lock);
-	f->head = NULL;
-	f->tail = NULL;
+	f->root = RB_ROOT_CACHED;
 	f->cells = 0;
 	
 	return f;
@@ -81,20 +66,6 @@ void snd_seq_prioq_delete(struct snd_seq_prioq **fifo)
 
 
 
-/* compare timestamp between events */
-/* return 1 if a >= b; 0 */
-static inline int compare_timestamp(struct snd_seq_event *a,
-				    struct snd_seq_event *b)
-{
-	if ((a->flags & SNDRV_SEQ_TIME_STAMP_MASK) == SNDRV_SEQ_TIME_STAMP_TICK) {
-		/* compare ticks */
-		return (snd_seq_compare_tick_time(&a->time.tick, &b->time.tick));
-	} else {
-		/* compare real time */
-		return (snd_seq_compare_real_time(&a->time.time, &b->time.time));
-	}
-}
-
 /* compare timestamp between events */
 /* return negative if a < b;
  *        zero     if a = b;
@@ -127,71 +98,36 @@ static inline int compare_timestamp_rel(struct snd_seq_event *a,
 	}
 }
 
+static inline struct snd_seq_event_cell *prioq_cell(const struct rb_node *node)
+{
+	return rb_entry(node, struct snd_seq_event_cell, node);
+}
+
+/* a high priority cell goes before the cells with an equal timestamp */
+static bool prioq_cell_less(struct rb_node *a, const struct rb_node *b)
+{
+	struct snd_seq_event_cell *cell = prioq_cell(a);
+	int rel;
+
+	rel = compare_timestamp_rel(&cell->event, &prioq_cell(b)->event);
+	if (rel)
+		return rel < 0;
+	return cell->event.flags & SNDRV_SEQ_PRIORITY_MASK;
+}
+
 /* enqueue cell to prioq */
 int snd_seq_prioq_cell_in(struct snd_seq_prioq * f,
 			  struct snd_seq_event_cell * cell)
 {
-	struct snd_seq_event_cell *cur, *prev;
-	int count;
-	int prior;
-
 	if (snd_BUG_ON(!f || !cell))
 		return -EINVAL;
-	
-	/* check flags */
-	prior = (cell->event.flags & SNDRV_SEQ_PRIORITY_MASK);
 
 	guard(spinlock_irqsave)(&f->lock);
 
-	/* check if this element needs to inserted at the end (ie. ordered 
-	   data is inserted) This will be very likeley if a sequencer 
-	   application or midi file player is feeding us (sequential) data */
-	if (f->tail && !prior) {
-		if (compare_timestamp(&cell->event, &f->tail->event)) {
-			/* add new cell to tail of the fifo */
-			f->tail->next = cell;
-			f->tail = cell;
-			cell->next = NULL;
-			f->cells++;
-			return 0;
-		}
-	}
-	/* traverse list of elements to find the place where the new cell is
-	   to be inserted... Note that this is a order n process ! */
-
-	prev = NULL;		/* previous cell */
-	cur = f->head;		/* cursor */
-
-	count = 10000; /* FIXME: enough big, isn't it? */
-	while (cur != NULL) {
-		/* compare timestamps */
-		int rel = compare_timestamp_rel(&cell->event, &cur->event);
-		if (rel < 0)
-			/* new cell has earlier schedule time, */
-			break;
-		else if (rel == 0 && prior)
-			/* equal schedule time and prior to others */
-			break;
-		/* new cell has equal or larger schedule time, */
-		/* move cursor to next cell */
-		prev = cur;
-		cur = cur->next;
-		if (! --count) {
-			pr_err("ALSA: seq: cannot find a pointer.. infinite loop?\n");
-			return -EINVAL;
-		}
-	}
-
-	/* insert it before cursor */
-	if (prev != NULL)
-		prev->next = cell;
-	cell->next = cur;
-
-	if (f->head == cur) /* this is the first cell, set head to it */
-		f->head = cell;
-	if (cur == NULL) /* reached end of the list */
-		f->tail = cell;
-	f->cells++;
+	/* the common case of ordered data ends up on the right-most path */
+	rb_add_cached(&cell->node, &f->root, prioq_cell_less);
+	if (++f->cells > f->max_cells)
+		f->max_cells = f->cells;
 	return 0;
 }
 
@@ -209,6 +145,7 @@ struct snd_seq_event_cell *snd_seq_prioq_cell_out(struct snd_seq_prioq *f,
 						  void *current_time)
 {
 	struct snd_seq_event_cell *cell;
+	struct rb_node *node;
 
 	if (f == NULL) {
 		pr_debug("ALSA: seq: snd_seq_prioq_cell_in() called with NULL prioq\n");
@@ -216,19 +153,16 @@ struct snd_seq_event_cell *snd_seq_prioq_cell_out(struct snd_seq_prioq *f,
 	}
 
 	guard(spinlock_irqsave)(&f->lock);
-	cell = f->head;
-	if (cell && current_time && !event_is_ready(&cell->event, current_time))
-		cell = NULL;
-	if (cell) {
-		f->head = cell->next;
-
-		/* reset tail if this was the last element */
-		if (f->tail == cell)
-			f->tail = NULL;
-
-		cell->next = NULL;
-		f->cells--;
-	}
+	node = rb_first_cached(&f->root);
+	if (!node)
+		return NULL;
+	cell = prioq_cell(node);
+	if (current_time && !event_is_ready(&cell->event, current_time))
+		return NULL;
+
+	rb_erase_cached(node, &f->root);
+	cell->next = NULL;
+	f->cells--;
 
 	return cell;
 }
@@ -243,32 +177,34 @@ int snd_seq_prioq_avail(struct snd_seq_prioq * f)
 	return f->cells;
 }
 
+/* return the largest number of events the prioq ever held */
+int snd_seq_prioq_max_avail(struct snd_seq_prioq *f)
+{
+	if (f == NULL)
+		return 0;
+	return f->max_cells;
+}
+
 /* remove cells matching with the condition */
 static void prioq_remove_cells(struct snd_seq_prioq *f,
 			       bool (*match)(struct snd_seq_event_cell *cell,
 					     void *arg),
 			       void *arg)
 {
-	register struct snd_seq_event_cell *cell, *next;
-	struct snd_seq_event_cell *prev = NULL;
+	struct snd_seq_event_cell *cell;
 	struct snd_seq_event_cell *freefirst = NULL, *freeprev = NULL, *freenext;
+	struct rb_node *node, *next;
 
 	/* collect all removed cells */
 	scoped_guard(spinlock_irqsave, &f->lock) {
-		for (cell = f->head; cell; cell = next) {
-			next = cell->next;
-			if (!match(cell, arg)) {
-				prev = cell;
+		for (node = rb_first_cached(&f->root); node; node = next) {
+			next = rb_next(node);
+			cell = prioq_cell(node);
+			if (!match(cell, arg))
 				continue;
-			}
 
 			/* remove cell from prioq */
-			if (cell == f->head)
-				f->head = cell->next;
-			else
-				prev->next = cell->next;
-			if (cell == f->tail)
-				f->tail = cell->next;
+			rb_erase_cached(node, &f->root);
 			f->cells--;
 
 			/* add cell to free list */
@@ -12,9 +12,9 @@
 /* === PRIOQ === */
 
 struct snd_seq_prioq {
-	struct snd_seq_event_cell *head;      /* pointer to head of prioq */
-	struct snd_seq_event_cell *tail;      /* pointer to tail of prioq */
+	struct rb_root_cached root;	/* cells sorted on timestamp */
 	int cells;
+	int max_cells;			/* peak number of cells */
 	spinlock_t lock;
 };
 
@@ -35,6 +35,9 @@ struct snd_seq_event_cell *snd_seq_prioq_cell_out(struct snd_seq_prioq *f,
 /* return number of events available in prioq */
 int snd_seq_prioq_avail(struct snd_seq_prioq *f);
 
+/* return the peak number of events in prioq */
+int snd_seq_prioq_max_avail(struct snd_seq_prioq *f);
+
 /* client left queue */
 void snd_seq_prioq_leave(struct snd_seq_prioq *f, int client, int timestamp);        
 
@@ -600,8 +600,11 @@ static struct sharded_mutex *sharded_mutex;
 
 static void annotation__init_sharded_mutex(void)
 {
-	/* As many mutexes as there are CPUs. */
-	sharded_mutex = sharded_mutex__new(cpu__max_present_cpu().cpu);
+	/*
+	 * Four mutexes per CPU, so that hot annotations rarely end up sharing
+	 * a mutex when samples are processed on several threads.
+	 */
+	sharded_mutex = sharded_mutex__new(4 * cpu__max_present_cpu().cpu);
 }
 
 static size_t annotation__hash(const struct annotation *notes)
@@ -7,6 +7,7 @@
 #include <inttypes.h>
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <fcntl.h>
 #include <stdbool.h>
 #include <string.h>
 #include <limits.h>
@@ -1172,6 +1173,19 @@ void *auxtrace_buffer__get_data_rw(struct auxtrace_buffer *buffer, int fd, bool
 	return buffer->data;
 }
 
+/*
+ * Start reading in the data of a buffer that will be needed soon, so that
+ * the I/O overlaps with decoding the current one instead of stalling on
+ * page faults later. Only useful for data still in the file.
+ */
+void auxtrace_buffer__prefetch(struct auxtrace_buffer *buffer, int fd)
+{
+	if (buffer->data || !buffer->size)
+		return;
+
+	posix_fadvise(fd, buffer->data_offset, buffer->size, POSIX_FADV_WILLNEED);
+}
+
 void auxtrace_buffer__put_data(struct auxtrace_buffer *buffer)
 {
 	if (!buffer->data || !buffer->mmap_addr)
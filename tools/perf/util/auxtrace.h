@@ -545,6 +545,7 @@ static inline void *auxtrace_buffer__get_data(struct auxtrace_buffer *buffer, in
 {
 	return auxtrace_buffer__get_data_rw(buffer, fd, false);
 }
+void auxtrace_buffer__prefetch(struct auxtrace_buffer *buffer, int fd);
 void auxtrace_buffer__put_data(struct auxtrace_buffer *buffer);
 void auxtrace_buffer__drop_data(struct auxtrace_buffer *buffer);
 void auxtrace_buffer__free(struct auxtrace_buffer *buffer);
@@ -9,6 +9,7 @@
 #include "util/thread.h"
 #include "util/thread_map.h"
 #include "util/lock-contention.h"
+#include <linux/build_bug.h>
 #include <linux/zalloc.h>
 #include <linux/string.h>
 #include <bpf/bpf.h>
@@ -33,7 +34,12 @@ int lock_contention_prepare(struct lock_contention *con)
 	}
 
 	bpf_map__set_value_size(skel->maps.stacks, con->max_stack * sizeof(u64));
-	bpf_map__set_max_entries(skel->maps.lock_stat, con->map_nr_entries);
+	if (con->use_hist) {
+		bpf_map__set_max_entries(skel->maps.lock_hist, con->map_nr_entries);
+		bpf_map__set_max_entries(skel->maps.lock_stat, 1);
+	} else {
+		bpf_map__set_max_entries(skel->maps.lock_stat, con->map_nr_entries);
+	}
 	bpf_map__set_max_entries(skel->maps.tstamp, con->map_nr_entries);
 
 	if (con->aggr_mode == LOCK_AGGR_TASK)
@@ -103,6 +109,7 @@ int lock_contention_prepare(struct lock_contention *con)
 	skel->rodata->aggr_mode = con->aggr_mode;
 	skel->rodata->needs_callstack = con->save_callstack;
 	skel->rodata->lock_owner = con->owner;
+	skel->rodata->use_hist = con->use_hist;
 
 	if (con->aggr_mode == LOCK_AGGR_CGROUP || con->filters->nr_cgrps) {
 		if (cgroup_is_v2("perf_event"))
@@ -403,6 +410,45 @@ static const char *lock_contention_get_name(struct lock_contention *con,
 	return name_buf;
 }
 
+static void lock_stat_add_hist(struct lock_stat *st, u64 *buckets)
+{
+	for (int i = 0; i < CONTENTION_HIST_BUCKETS; i++)
+		st->wait_hist[i] += buckets[i];
+}
+
+/*
+ * Take the per-CPU histogram entry for @key out of the map, so the next
+ * read only sees what came after, and sum it up into @data and @buckets.
+ */
+static int lock_contention_take_hist(int fd, struct contention_key *key,
+				     struct contention_hist *hist, int ncpus,
+				     struct contention_data *data, u64 *buckets)
+{
+	if (bpf_map_lookup_and_delete_elem(fd, key, hist) < 0)
+		return -1;
+
+	memset(data, 0, sizeof(*data));
+	memset(buckets, 0, CONTENTION_HIST_BUCKETS * sizeof(*buckets));
+
+	for (int i = 0; i < ncpus; i++) {
+		if (!hist[i].count)
+			continue;
+
+		if (!data->count || data->min_time > hist[i].min_time)
+			data->min_time = hist[i].min_time;
+		if (data->max_time < hist[i].max_time)
+			data->max_time = hist[i].max_time;
+		data->total_time += hist[i].total_time;
+		data->count += hist[i].count;
+		data->flags = hist[i].flags;
+
+		for (int b = 0; b < CONTENTION_HIST_BUCKETS; b++)
+			buckets[b] += hist[i].buckets[b];
+	}
+
+	return 0;
+}
+
 int lock_contention_read(struct lock_contention *con)
 {
 	int fd, stack, err = 0;
@@ -412,8 +458,25 @@ int lock_contention_read(struct lock_contention *con)
 	struct machine *machine = con->machine;
 	u64 *stack_trace;
 	size_t stack_size = con->max_stack * sizeof(*stack_trace);
+	struct contention_hist *hist = NULL;
+	u64 buckets[CONTENTION_HIST_BUCKETS];
+	int ncpus = 0;
+
+	BUILD_BUG_ON(CONTENTION_HIST_BUCKETS != LOCK_HIST_BUCKETS);
+
+	if (con->use_hist) {
+		ncpus = libbpf_num_possible_cpus();
+		if (ncpus < 0)
+			return -1;
+
+		hist = calloc(ncpus, sizeof(*hist));
+		if (hist == NULL)
+			return -1;
 
-	fd = bpf_map__fd(skel->maps.lock_stat);
+		fd = bpf_map__fd(skel->maps.lock_hist);
+	} else {
+		fd = bpf_map__fd(skel->maps.lock_stat);
+	}
 	stack = bpf_map__fd(skel->maps.stacks);
 
 	con->fails.task = skel->bss->task_fail;
@@ -422,10 +485,14 @@ int lock_contention_read(struct lock_contention *con)
 	con->fails.data = skel->bss->data_fail;
 
 	stack_trace = zalloc(stack_size);
-	if (stack_trace == NULL)
+	if (stack_trace == NULL) {
+		free(hist);
 		return -1;
+	}
 
-	account_end_timestamp(con);
+	/* Contention still in progress shows up in a later read */
+	if (!con->use_hist)
+		account_end_timestamp(con);
 
 	if (con->aggr_mode == LOCK_AGGR_TASK) {
 		struct thread *idle = machine__findnew_thread(machine,
@@ -454,7 +521,14 @@ int lock_contention_read(struct lock_contention *con)
 		/* to handle errors in the loop body */
 		err = -1;
 
-		bpf_map_lookup_elem(fd, &key, &data);
+		if (con->use_hist) {
+			/* Can't skip it, it would be the next key again */
+			if (lock_contention_take_hist(fd, &key, hist, ncpus,
+						      &data, buckets) < 0)
+				break;
+		} else {
+			bpf_map_lookup_elem(fd, &key, &data);
+		}
 		if (con->save_callstack) {
 			bpf_map_lookup_elem(stack, &key.stack_id, stack_trace);
 
@@ -490,6 +564,8 @@ int lock_contention_read(struct lock_contention *con)
 			st->nr_contended += data.count;
 			if (st->nr_contended)
 				st->avg_wait_time = st->wait_time_total / st->nr_contended;
+			if (con->use_hist)
+				lock_stat_add_hist(st, buckets);
 			goto next;
 		}
 
@@ -506,6 +582,9 @@ int lock_contention_read(struct lock_contention *con)
 		if (data.count)
 			st->avg_wait_time = data.total_time / data.count;
 
+		if (con->use_hist)
+			lock_stat_add_hist(st, buckets);
+
 		if (con->aggr_mode == LOCK_AGGR_CALLER && verbose > 0) {
 			st->callstack = memdup(stack_trace, stack_size);
 			if (st->callstack == NULL)
@@ -513,13 +592,15 @@ int lock_contention_read(struct lock_contention *con)
 		}
 
 next:
-		prev_key = &key;
+		/* Taken entries are gone, the next key is the first one then */
+		prev_key = con->use_hist ? NULL : &key;
 
 		/* we're fine now, reset the error */
 		err = 0;
 	}
 
 	free(stack_trace);
+	free(hist);
 
 	return err;
 }
@@ -23,6 +23,9 @@
 
 static struct off_cpu_bpf *skel;
 
+/* dummy timestamps keep increasing across flushes */
+static u64 off_cpu_tstamp = OFF_CPU_TIMESTAMP;
+
 struct off_cpu_key {
 	u32 pid;
 	u32 tgid;
@@ -200,6 +203,8 @@ int off_cpu_prepare(struct evlist *evlist, struct target *target,
 			skel->rodata->uses_cgroup_v1 = true;
 	}
 
+	skel->rodata->offcpu_thresh_ns = opts->off_cpu_thresh_ns;
+
 	set_max_rlimit();
 	check_sched_switch_args();
 
@@ -291,7 +296,12 @@ int off_cpu_prepare(struct evlist *evlist, struct target *target,
 	return -1;
 }
 
-int off_cpu_write(struct perf_session *session)
+/*
+ * Write the accumulated off-CPU time as samples. With @take the entries are
+ * removed from the map as they're written, so that the next call only
+ * writes the time accumulated since.
+ */
+static int __off_cpu_write(struct perf_session *session, bool take)
 {
 	int bytes = 0, size;
 	int fd, stack;
@@ -305,9 +315,6 @@ int off_cpu_write(struct perf_session *session)
 			.misc = PERF_RECORD_MISC_USER,
 		},
 	};
-	u64 tstamp = OFF_CPU_TIMESTAMP;
-
-	skel->bss->enabled = 0;
 
 	evsel = evlist__find_evsel_by_str(session->evlist, OFFCPU_EVENT);
 	if (evsel == NULL) {
@@ -332,11 +339,19 @@ int off_cpu_write(struct perf_session *session)
 	stack = bpf_map__fd(skel->maps.stacks);
 	memset(&prev, 0, sizeof(prev));
 
-	while (!bpf_map_get_next_key(fd, &prev, &key)) {
+	while (!bpf_map_get_next_key(fd, take ? NULL : &prev, &key)) {
 		int n = 1;  /* start from perf_event_header */
 		int ip_pos = -1;
 
-		bpf_map_lookup_elem(fd, &key, &val);
+		if (take) {
+			/* Taken entries are gone, the next key is the first one then */
+			if (bpf_map_lookup_and_delete_elem(fd, &key, &val) < 0) {
+				pr_err("failed to take off-cpu data: %m\n");
+				return bytes;
+			}
+		} else {
+			bpf_map_lookup_elem(fd, &key, &val);
+		}
 
 		if (sample_type & PERF_SAMPLE_IDENTIFIER)
 			data.array[n++] = sid;
@@ -347,7 +362,7 @@ int off_cpu_write(struct perf_session *session)
 		if (sample_type & PERF_SAMPLE_TID)
 			data.array[n++] = (u64)key.pid << 32 | key.tgid;
 		if (sample_type & PERF_SAMPLE_TIME)
-			data.array[n++] = tstamp;
+			data.array[n++] = off_cpu_tstamp;
 		if (sample_type & PERF_SAMPLE_ID)
 			data.array[n++] = sid;
 		if (sample_type & PERF_SAMPLE_CPU)
@@ -387,9 +402,27 @@ int off_cpu_write(struct perf_session *session)
 			return bytes;
 		}
 
-		prev = key;
+		if (!take)
+			prev = key;
 		/* increase dummy timestamp to sort later samples */
-		tstamp++;
+		off_cpu_tstamp++;
 	}
 	return bytes;
 }
+
+int off_cpu_write(struct perf_session *session)
+{
+	skel->bss->enabled = 0;
+
+	return __off_cpu_write(session, /*take=*/false);
+}
+
+/*
+ * Write out the off-CPU time accumulated so far while collection goes on,
+ * keeping the map small for long running sessions. Must be serialized with
+ * the other writes to the data file.
+ */
+int off_cpu_flush(struct perf_session *session)
+{
+	return __off_cpu_write(session, /*take=*/true);
+}
@@ -51,6 +51,18 @@ struct {
 	__uint(max_entries, MAX_ENTRIES);
 } lock_stat SEC(".maps");
 
+/*
+ * per-CPU lock contention statistics with histograms, for use_hist.
+ * Not preallocated, as a full map would take nr_cpus * max_entries values.
+ */
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_HASH);
+	__uint(map_flags, BPF_F_NO_PREALLOC);
+	__uint(key_size, sizeof(struct contention_key));
+	__uint(value_size, sizeof(struct contention_hist));
+	__uint(max_entries, 1);
+} lock_hist SEC(".maps");
+
 struct {
 	__uint(type, BPF_MAP_TYPE_HASH);
 	__uint(key_size, sizeof(__u32));
@@ -126,6 +138,7 @@ const volatile int needs_callstack;
 const volatile int stack_skip;
 const volatile int lock_owner;
 const volatile int use_cgroup_v2;
+const volatile int use_hist;
 
 /* determine the key of lock stat */
 const volatile int aggr_mode;
@@ -357,6 +370,56 @@ static inline struct tstamp_data *get_tstamp_elem(__u32 flags)
 	return pelem;
 }
 
+static inline __u32 hist_bucket(__u64 v)
+{
+	__u32 r, shift;
+
+	r = (v > 0xFFFFFFFF) << 5; v >>= r;
+	shift = (v > 0xFFFF) << 4; v >>= shift; r |= shift;
+	shift = (v > 0xFF) << 3; v >>= shift; r |= shift;
+	shift = (v > 0xF) << 2; v >>= shift; r |= shift;
+	shift = (v > 0x3) << 1; v >>= shift; r |= shift;
+	r |= (v >> 1);
+
+	return r < LOCK_HIST_BUCKETS ? r : LOCK_HIST_BUCKETS - 1;
+}
+
+/* The entry is this CPU's, no atomics needed */
+static inline void update_contention_hist(struct contention_key *key,
+					  __u64 duration, __u32 flags)
+{
+	struct contention_hist *hist;
+	__u32 bucket;
+
+	hist = bpf_map_lookup_elem(&lock_hist, key);
+	if (!hist) {
+		struct contention_hist first = {
+			.min_time = duration,
+			.flags = flags,
+		};
+
+		if (bpf_map_update_elem(&lock_hist, key, &first, BPF_NOEXIST) == -E2BIG) {
+			__sync_fetch_and_add(&data_fail, 1);
+			return;
+		}
+
+		hist = bpf_map_lookup_elem(&lock_hist, key);
+		if (!hist)
+			return;
+	}
+
+	hist->total_time += duration;
+	hist->count++;
+	if (hist->max_time < duration)
+		hist->max_time = duration;
+	if (hist->min_time > duration || hist->count == 1)
+		hist->min_time = duration;
+
+	bucket = hist_bucket(duration);
+	if (bucket < LOCK_HIST_BUCKETS)
+		hist->buckets[bucket]++;
+}
+
 SEC("tp_btf/contention_begin")
 int contention_begin(u64 *ctx)
 {
@@ -471,6 +534,16 @@ int contention_end(u64 *ctx)
 		return 0;
 	}
 
+	if (use_hist) {
+		__u32 flags = pelem->flags;
+
+		if (aggr_mode == LOCK_AGGR_ADDR)
+			flags |= check_lock_type(pelem->lock, pelem->flags);
+
+		update_contention_hist(&key, duration, flags);
+		goto out;
+	}
+
 	data = bpf_map_lookup_elem(&lock_stat, &key);
 	if (!data) {
 		if (data_map_full) {
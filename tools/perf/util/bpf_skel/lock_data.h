@@ -42,6 +42,19 @@ struct contention_data {
 	u32 flags;
 };
 
+/* log2 buckets of wait time in ns, the last one takes everything above */
+#define LOCK_HIST_BUCKETS	32
+
+/* Per-CPU statistics with a wait time histogram, see lock_contention.use_hist */
+struct contention_hist {
+	u64 total_time;
+	u64 min_time;
+	u64 max_time;
+	u32 count;
+	u32 flags;
+	u32 buckets[LOCK_HIST_BUCKETS];
+};
+
 enum lock_aggr_mode {
 	LOCK_AGGR_ADDR = 0,
 	LOCK_AGGR_TASK,
@@ -95,6 +95,9 @@ const volatile bool has_prev_state = false;
 const volatile bool needs_cgroup = false;
 const volatile bool uses_cgroup_v1 = false;
 
+/* off-CPU periods shorter than this are not accounted */
+const volatile __u64 offcpu_thresh_ns = 0;
+
 int perf_subsys_id = -1;
 
 /*
@@ -221,14 +224,17 @@ static int off_cpu_stat(u64 *ctx, struct task_struct *prev,
 		__u64 delta = ts - pelem->timestamp;
 		__u64 *total;
 
+		/* prevent to reuse the timestamp later */
+		pelem->timestamp = 0;
+
+		if (delta < offcpu_thresh_ns)
+			return 0;
+
 		total = bpf_map_lookup_elem(&off_cpu, &key);
 		if (total)
 			*total += delta;
 		else
 			bpf_map_update_elem(&off_cpu, &key, &delta, BPF_ANY);
-
-		/* prevent to reuse the timestamp later */
-		pelem->timestamp = 0;
 	}
 
 	return 0;
@@ -15,6 +15,7 @@
 #include "linux/compiler.h"
 #include "linux/err.h"
 #include "util/auxtrace.h"
+#include "util/config.h"
 #include "util/debug.h"
 #include "util/dso.h"
 #include "util/event.h"
@@ -36,8 +37,16 @@ struct convert_json {
 	FILE *out;
 	bool first;
 	u64 events_count;
+	u64 queue_size;
 };
 
+// Output buffer size, large enough to keep the writes out of the profile
+#define JSON_OUTPUT_BUFSIZE	(1 << 20)
+
+// Write one compact JSON object per line (JSON Lines) instead of a single
+// indented document, see bt_convert__perf2json().
+static bool output_json_lines;
+
 // Outputs a JSON-encoded string surrounded by quotes with characters escaped.
 static void output_json_string(FILE *out, const char *s)
 {
@@ -76,6 +85,8 @@ static void output_json_delimiters(FILE *out, bool comma, int depth)
 
 	if (comma)
 		fputc(',', out);
+	if (output_json_lines)
+		return;
 	fputc('\n', out);
 	for (i = 0; i < depth; ++i)
 		fputc('\t', out);
@@ -99,7 +110,7 @@ static void output_json_key_string(FILE *out, bool comma, int depth,
 {
 	output_json_delimiters(out, comma, depth);
 	output_json_string(out, key);
-	fputs(": ", out);
+	fputs(output_json_lines ? ":" : ": ", out);
 	output_json_string(out, value);
 }
 
@@ -112,7 +123,7 @@ static void output_json_key_format(FILE *out, bool comma, int depth,
 
 	output_json_delimiters(out, comma, depth);
 	output_json_string(out, key);
-	fputs(": ", out);
+	fputs(output_json_lines ? ":" : ": ", out);
 	va_start(args, format);
 	vfprintf(out,  format, args);
 	va_end(args);
@@ -169,7 +180,7 @@ static int process_sample_event(const struct perf_tool *tool,
 
 	if (c->first)
 		c->first = false;
-	else
+	else if (!output_json_lines)
 		fputc(',', out);
 	output_json_format(out, false, 2, "{");
 
@@ -250,6 +261,8 @@ static int process_sample_event(const struct perf_tool *tool,
 	}
 #endif
 	output_json_format(out, false, 2, "}");
+	if (output_json_lines)
+		fputc('\n', out);
 	addr_location__exit(&al);
 	return 0;
 }
@@ -310,6 +323,16 @@ static void output_headers(struct perf_session *session, struct convert_json *c)
 	output_json_format(out, false, 2, "]");
 }
 
+static int convert_json__config(const char *var, const char *value, void *cb)
+{
+	struct convert_json *c = cb;
+
+	if (!strcmp(var, "convert.queue-size"))
+		return perf_config_u64(&c->queue_size, var, value);
+
+	return 0;
+}
+
 int bt_convert__perf2json(const char *input_name, const char *output_name,
 		struct perf_data_convert_opts *opts __maybe_unused)
 {
@@ -370,6 +393,11 @@ int bt_convert__perf2json(const char *input_name, const char *output_name,
 		close(fd);
 		goto err;
 	}
+	setvbuf(c.out, NULL, _IOFBF, JSON_OUTPUT_BUFSIZE);
+	output_json_lines = opts->json_lines;
+
+	if (perf_config(convert_json__config, &c))
+		goto err_fclose;
 
 	session = perf_session__new(&data, &c.tool);
 	if (IS_ERR(session)) {
@@ -377,11 +405,30 @@ int bt_convert__perf2json(const char *input_name, const char *output_name,
 		goto err_fclose;
 	}
 
+	// Bound the memory the reordering queue may take on large inputs
+	if (c.queue_size) {
+		ordered_events__set_alloc_size(&session->ordered_events,
+					       c.queue_size);
+	}
+
 	if (symbol__init(&session->header.env) < 0) {
 		fprintf(stderr, "Symbol init error!\n");
 		goto err_session_delete;
 	}
 
+	if (output_json_lines) {
+		// The first line holds the version and headers, every following
+		// line is a sample, so samples can be consumed as they're written
+		// without parsing the whole document.
+		fputc('{', c.out);
+		output_json_format(c.out, false, 1, "\"linux-perf-json-version\":1");
+		output_json_format(c.out, true, 1, "\"headers\":{");
+		output_headers(session, &c);
+		output_json_format(c.out, false, 1, "}}\n");
+		perf_session__process_events(session);
+		goto out_done;
+	}
+
 	// The opening brace is printed manually because it isn't delimited from a
 	// previous value (i.e. we don't want a leading newline)
 	fputc('{', c.out);
@@ -403,6 +450,7 @@ int bt_convert__perf2json(const char *input_name, const char *output_name,
 	output_json_format(c.out, false, 0, "}");
 	fputc('\n', c.out);
 
+out_done:
 	fprintf(stderr,
 			"[ perf data convert: Converted '%s' into JSON data '%s' ]\n",
 			data.path, output_name);
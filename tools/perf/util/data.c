@@ -12,6 +12,7 @@
 #include <string.h>
 #include <asm/bug.h>
 #include <dirent.h>
+#include <limits.h>
 
 #include "data.h"
 #include "util.h" // rm_rf_perf_data()
@@ -417,6 +418,39 @@ ssize_t perf_data_file__write(struct perf_data_file *file,
 	return writen(file->fd, buf, size);
 }
 
+/*
+ * Write all of @iov, handling short writes. @iov is used as scratch space
+ * and left pointing past the written data.
+ */
+ssize_t perf_data_file__writev(struct perf_data_file *file,
+			       struct iovec *iov, int iovcnt)
+{
+	ssize_t total = 0;
+
+	while (iovcnt) {
+		ssize_t ret = writev(file->fd, iov, min(iovcnt, IOV_MAX));
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return ret;
+		}
+		total += ret;
+
+		while (iovcnt && (size_t)ret >= iov->iov_len) {
+			ret -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (ret) {
+			iov->iov_base += ret;
+			iov->iov_len -= ret;
+		}
+	}
+
+	return total;
+}
+
 ssize_t perf_data__write(struct perf_data *data,
 			 void *buf, size_t size)
 {
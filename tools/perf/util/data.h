@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <unistd.h>
+#include <sys/uio.h>
 #include <linux/types.h>
 
 enum perf_data_mode {
@@ -83,6 +84,8 @@ ssize_t perf_data__write(struct perf_data *data,
 			 void *buf, size_t size);
 ssize_t perf_data_file__write(struct perf_data_file *file,
 			      void *buf, size_t size);
+ssize_t perf_data_file__writev(struct perf_data_file *file,
+			       struct iovec *iov, int iovcnt);
 /*
  * If at_exit is set, only rename current perf.data to
  * perf.data.<postfix>, continue write on original data.
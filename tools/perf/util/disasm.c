@@ -7,6 +7,7 @@
 #include <regex.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 #include <linux/string.h>
 #include <subcmd/run-command.h>
@@ -21,6 +22,7 @@
 #include "dwarf-regs.h"
 #include "env.h"
 #include "evsel.h"
+#include "hashmap.h"
 #include "map.h"
 #include "maps.h"
 #include "namespaces.h"
@@ -2075,6 +2077,115 @@ static char *expand_tabs(char *line, char **storage, size_t *storage_len)
 	return new_line;
 }
 
+/*
+ * The objdump output for a symbol is kept in the build-id cache next to the
+ * DSO and reused by later sessions instead of running objdump again. It's
+ * keyed by the objdump command line, which has the symbol range and all the
+ * options affecting the output, plus the file objdump runs on and its size
+ * and mtime, as that may be the DSO or separate debuginfo which can be
+ * installed or updated later. The first line of the file is that key to
+ * check against hash collisions.
+ */
+static char *objdump_cache__key(const char *filename, const char *command)
+{
+	struct stat st;
+	char *key;
+
+	if (stat(filename, &st) < 0)
+		return NULL;
+
+	if (asprintf(&key, "%s # %s %lld %lld.%09ld", command, filename,
+		     (long long)st.st_size, (long long)st.st_mtim.tv_sec,
+		     st.st_mtim.tv_nsec) < 0)
+		return NULL;
+
+	return key;
+}
+
+static char *objdump_cache__path(struct dso *dso, const char *key)
+{
+	char sbuild_id[SBUILD_ID_SIZE];
+	char *dir_name, *path;
+
+	/* The file objdump runs on is a temporary extract for these */
+	if (!dso__has_build_id(dso) || dso__is_kcore(dso) ||
+	    dso__needs_decompress(dso))
+		return NULL;
+
+	build_id__sprintf(dso__bid(dso), sbuild_id);
+	dir_name = build_id_cache__cachedir(sbuild_id, dso__long_name(dso),
+					    dso__nsinfo(dso), false, false);
+	if (!dir_name)
+		return NULL;
+
+	if (asprintf(&path, "%s/objdump-%zx", dir_name, str_hash(key)) < 0)
+		path = NULL;
+
+	free(dir_name);
+	return path;
+}
+
+static FILE *objdump_cache__open(const char *path, const char *key)
+{
+	char *line = NULL;
+	size_t line_len = 0;
+	FILE *file;
+
+	file = fopen(path, "r");
+	if (!file)
+		return NULL;
+
+	if (getline(&line, &line_len, file) < 0 || strcmp(strim(line), key)) {
+		fclose(file);
+		file = NULL;
+	}
+
+	free(line);
+	return file;
+}
+
+/* Fails if the DSO isn't in the build-id cache, which is fine. */
+static FILE *objdump_cache__create(const char *path, const char *key,
+				   char **tmp)
+{
+	FILE *file;
+	int fd;
+
+	if (asprintf(tmp, "%s.XXXXXX", path) < 0) {
+		*tmp = NULL;
+		return NULL;
+	}
+
+	fd = mkstemp(*tmp);
+	if (fd < 0)
+		goto out_free;
+
+	file = fdopen(fd, "w");
+	if (!file) {
+		close(fd);
+		goto out_unlink;
+	}
+
+	fprintf(file, "%s\n", key);
+	return file;
+
+out_unlink:
+	unlink(*tmp);
+out_free:
+	zfree(tmp);
+	return NULL;
+}
+
+static void objdump_cache__commit(FILE *file, char *tmp, const char *path,
+				  bool complete)
+{
+	if (fclose(file) == 0 && complete && rename(tmp, path) == 0)
+		pr_debug("Saved objdump output to %s\n", path);
+	else
+		unlink(tmp);
+	free(tmp);
+}
+
 static int symbol__disassemble_objdump(const char *filename, struct symbol *sym,
 				       struct annotate_args *args)
 {
@@ -2097,6 +2208,9 @@ static int symbol__disassemble_objdump(const char *filename, struct symbol *sym,
 		NULL,
 	};
 	struct child_process objdump_process;
+	char *cache_key, *cache_path = NULL, *cache_tmp = NULL;
+	FILE *cache_file = NULL;
+	bool cached;
 	int err;
 
 	err = asprintf(&command,
@@ -2123,6 +2237,16 @@ static int symbol__disassemble_objdump(const char *filename, struct symbol *sym,
 		return err;
 	}
 
+	cache_key = objdump_cache__key(filename, command);
+	if (cache_key)
+		cache_path = objdump_cache__path(dso, cache_key);
+	file = cache_path ? objdump_cache__open(cache_path, cache_key) : NULL;
+	cached = file != NULL;
+	if (cached) {
+		pr_debug("Using objdump output in %s\n", cache_path);
+		goto read_lines;
+	}
+
 	pr_debug("Executing: %s\n", command);
 
 	objdump_argv[2] = command;
@@ -2151,6 +2275,10 @@ static int symbol__disassemble_objdump(const char *filename, struct symbol *sym,
 		goto out_close_stdout;
 	}
 
+	if (cache_path)
+		cache_file = objdump_cache__create(cache_path, cache_key, &cache_tmp);
+
+read_lines:
 	/* Storage for getline. */
 	line = NULL;
 	line_len = 0;
@@ -2168,6 +2296,9 @@ static int symbol__disassemble_objdump(const char *filename, struct symbol *sym,
 		if (match && match[strlen(filename)] == ':')
 			continue;
 
+		if (cache_file)
+			fputs(line, cache_file);
+
 		expanded_line = strim(line);
 		expanded_line = expand_tabs(expanded_line, &line, &line_len);
 		if (!expanded_line)
@@ -2187,7 +2318,7 @@ static int symbol__disassemble_objdump(const char *filename, struct symbol *sym,
 	free(line);
 	free(fileloc);
 
-	err = finish_command(&objdump_process);
+	err = cached ? 0 : finish_command(&objdump_process);
 	if (err)
 		pr_err("Error running %s\n", command);
 
@@ -2196,6 +2327,11 @@ static int symbol__disassemble_objdump(const char *filename, struct symbol *sym,
 		pr_err("No output from %s\n", command);
 	}
 
+	if (cache_file) {
+		objdump_cache__commit(cache_file, cache_tmp, cache_path,
+				      !err && feof(file));
+	}
+
 	/*
 	 * kallsyms does not have symbol sizes so there may a nop at the end.
 	 * Remove it.
@@ -2204,11 +2340,15 @@ static int symbol__disassemble_objdump(const char *filename, struct symbol *sym,
 		delete_last_nop(sym);
 
 	fclose(file);
+	if (cached)
+		goto out_free_command;
 
 out_close_stdout:
 	close(objdump_process.out);
 
 out_free_command:
+	free(cache_path);
+	free(cache_key);
 	free(command);
 	return err;
 }
@@ -2217,6 +2357,10 @@ static int annotation_options__init_disassemblers(struct annotation_options *opt
 {
 	char *disassembler;
 
+	/* Called for every symbol, the list only needs parsing once */
+	if (options->nr_disassemblers)
+		return 0;
+
 	if (options->disassemblers_str == NULL) {
 		const char *default_disassemblers_str =
 #ifdef HAVE_LIBLLVM_SUPPORT
@@ -1437,6 +1437,7 @@ struct dso *dso__new_id(const char *name, const struct dso_id *id)
 		dso->symbol_names_len = 0;
 		dso->inlined_nodes = RB_ROOT_CACHED;
 		dso->srclines = RB_ROOT_CACHED;
+		dso->a2l_cache = RB_ROOT_CACHED;
 		dso->data_types = RB_ROOT;
 		dso->global_vars = RB_ROOT;
 		dso->data.fd = -1;
@@ -1481,6 +1482,7 @@ void dso__delete(struct dso *dso)
 	/* free inlines first, as they reference symbols */
 	inlines__tree_delete(&RC_CHK_ACCESS(dso)->inlined_nodes);
 	srcline__tree_delete(&RC_CHK_ACCESS(dso)->srclines);
+	a2l_cache__delete(&RC_CHK_ACCESS(dso)->a2l_cache);
 	symbols__delete(&RC_CHK_ACCESS(dso)->symbols);
 	RC_CHK_ACCESS(dso)->symbol_names_len = 0;
 	zfree(&RC_CHK_ACCESS(dso)->symbol_names);
@@ -176,6 +176,7 @@ DECLARE_RC_STRUCT(dso) {
 	size_t		 symbol_names_len;
 	struct rb_root_cached inlined_nodes;
 	struct rb_root_cached srclines;
+	struct rb_root_cached a2l_cache;
 	struct rb_root	 data_types;
 	struct rb_root	 global_vars;
 
@@ -557,6 +558,11 @@ static inline struct rb_root_cached *dso__srclines(struct dso *dso)
 	return &RC_CHK_ACCESS(dso)->srclines;
 }
 
+static inline struct rb_root_cached *dso__a2l_cache(struct dso *dso)
+{
+	return &RC_CHK_ACCESS(dso)->a2l_cache;
+}
+
 static inline struct rb_root *dso__data_types(struct dso *dso)
 {
 	return &RC_CHK_ACCESS(dso)->data_types;
@@ -828,6 +828,27 @@ iter_add_next_nop_entry(struct hist_entry_iter *iter __maybe_unused,
 	return 0;
 }
 
+/*
+ * Threads processing a shard of the samples (see sample-shards.c) account
+ * into private hists, which are merged into the evsel ones at the end.
+ */
+static __thread struct hists *sample_shard_hists;
+static __thread int sample_shard_nr;
+
+void hists__set_sample_shard(struct hists *hists, int nr)
+{
+	sample_shard_hists = hists;
+	sample_shard_nr = nr;
+}
+
+struct hists *evsel__sample_hists(struct evsel *evsel)
+{
+	if (sample_shard_hists && evsel->core.idx < sample_shard_nr)
+		return &sample_shard_hists[evsel->core.idx];
+
+	return evsel__hists(evsel);
+}
+
 static int
 iter_prepare_mem_entry(struct hist_entry_iter *iter, struct addr_location *al)
 {
@@ -847,7 +868,7 @@ iter_add_single_mem_entry(struct hist_entry_iter *iter, struct addr_location *al
 {
 	u64 cost;
 	struct mem_info *mi = iter->mi;
-	struct hists *hists = evsel__hists(iter->evsel);
+	struct hists *hists = evsel__sample_hists(iter->evsel);
 	struct perf_sample *sample = iter->sample;
 	struct hist_entry *he;
 
@@ -881,7 +902,7 @@ iter_finish_mem_entry(struct hist_entry_iter *iter,
 		      struct addr_location *al __maybe_unused)
 {
 	struct evsel *evsel = iter->evsel;
-	struct hists *hists = evsel__hists(evsel);
+	struct hists *hists = evsel__sample_hists(evsel);
 	struct hist_entry *he = iter->he;
 	int err = -EINVAL;
 
@@ -949,7 +970,7 @@ iter_add_next_branch_entry(struct hist_entry_iter *iter, struct addr_location *a
 {
 	struct branch_info *bi;
 	struct evsel *evsel = iter->evsel;
-	struct hists *hists = evsel__hists(evsel);
+	struct hists *hists = evsel__sample_hists(evsel);
 	struct perf_sample *sample = iter->sample;
 	struct hist_entry *he = NULL;
 	int i = iter->curr;
@@ -1015,7 +1036,7 @@ iter_add_single_normal_entry(struct hist_entry_iter *iter, struct addr_location
 	struct perf_sample *sample = iter->sample;
 	struct hist_entry *he;
 
-	he = hists__add_entry(evsel__hists(evsel), al, iter->parent, NULL, NULL,
+	he = hists__add_entry(evsel__sample_hists(evsel), al, iter->parent, NULL, NULL,
 			      NULL, sample, true);
 	if (he == NULL)
 		return -ENOMEM;
@@ -1037,7 +1058,7 @@ iter_finish_normal_entry(struct hist_entry_iter *iter,
 
 	iter->he = NULL;
 
-	hists__inc_nr_samples(evsel__hists(evsel), he->filtered);
+	hists__inc_nr_samples(evsel__sample_hists(evsel), he->filtered);
 
 	return hist_entry__append_callchain(he, sample);
 }
@@ -1074,7 +1095,7 @@ iter_add_single_cumulative_entry(struct hist_entry_iter *iter,
 				 struct addr_location *al)
 {
 	struct evsel *evsel = iter->evsel;
-	struct hists *hists = evsel__hists(evsel);
+	struct hists *hists = evsel__sample_hists(evsel);
 	struct perf_sample *sample = iter->sample;
 	struct hist_entry **he_cache = iter->he_cache;
 	struct hist_entry *he;
@@ -1137,7 +1158,7 @@ iter_add_next_cumulative_entry(struct hist_entry_iter *iter,
 	struct hist_entry **he_cache = iter->he_cache;
 	struct hist_entry *he;
 	struct hist_entry he_tmp = {
-		.hists = evsel__hists(evsel),
+		.hists = evsel__sample_hists(evsel),
 		.cpu = al->cpu,
 		.thread = al->thread,
 		.comm = thread__comm(al->thread),
@@ -1183,7 +1204,7 @@ iter_add_next_cumulative_entry(struct hist_entry_iter *iter,
 		}
 	}
 
-	he = hists__add_entry(evsel__hists(evsel), al, iter->parent, NULL, NULL,
+	he = hists__add_entry(evsel__sample_hists(evsel), al, iter->parent, NULL, NULL,
 			      NULL, sample, false);
 	if (he == NULL)
 		return -ENOMEM;
@@ -1730,6 +1751,69 @@ int hists__collapse_resort(struct hists *hists, struct ui_progress *prog)
 	return 0;
 }
 
+/*
+ * Move all entries of @src into @dest, combining the ones that collapse
+ * into an existing entry the same way hists__collapse_resort() does. @src
+ * must have been collapsed already and uses the same hpp_list as @dest.
+ * Without need_collapse the collapse keys are the plain sort keys, so the
+ * entries can go straight to the input tree output_resort() reads.
+ *
+ * On error the entries not moved yet are left in @src, to be freed with it.
+ */
+int hists__merge(struct hists *dest, struct hists *src)
+{
+	struct rb_root_cached *root, *dest_root;
+	struct rb_node *next;
+	struct hist_entry *n;
+	int col, ret;
+
+	if (symbol_conf.report_hierarchy)
+		return -EOPNOTSUPP;
+
+	if (hists__has(src, need_collapse)) {
+		root = &src->entries_collapsed;
+		dest_root = &dest->entries_collapsed;
+	} else {
+		root = src->entries_in;
+		dest_root = dest->entries_in;
+	}
+
+	next = rb_first_cached(root);
+	while (next) {
+		n = rb_entry(next, struct hist_entry, rb_node_in);
+		next = rb_next(&n->rb_node_in);
+
+		rb_erase_cached(&n->rb_node_in, root);
+		n->hists = dest;
+		/*
+		 * @n is either linked into @dest_root or, when it collapses
+		 * into an existing entry, freed, even if merging its
+		 * callchain fails.
+		 */
+		ret = hists__collapse_insert_entry(dest, dest_root, n);
+		if (ret < 0)
+			return -1;
+
+		if (ret)
+			hists__apply_filters(dest, n);
+	}
+
+	dest->stats.total_period += src->stats.total_period;
+	dest->stats.total_non_filtered_period += src->stats.total_non_filtered_period;
+	dest->stats.nr_samples += src->stats.nr_samples;
+	dest->stats.nr_non_filtered_samples += src->stats.nr_non_filtered_samples;
+	dest->stats.nr_lost_samples += src->stats.nr_lost_samples;
+	dest->stats.nr_dropped_samples += src->stats.nr_dropped_samples;
+	dest->callchain_period += src->callchain_period;
+	dest->callchain_non_filtered_period += src->callchain_non_filtered_period;
+	dest->has_callchains |= src->has_callchains;
+
+	for (col = 0; col < HISTC_NR_COLS; col++)
+		hists__new_col_len(dest, col, hists__col_len(src, col));
+
+	return 0;
+}
+
 static int64_t hist_entry__sort(struct hist_entry *a, struct hist_entry *b)
 {
 	struct hists *hists = a->hists;
@@ -2905,6 +2989,12 @@ static void hists__delete_all_entries(struct hists *hists)
 	hists__delete_remaining_entries(&hists->entries_collapsed);
 }
 
+void hists__exit(struct hists *hists)
+{
+	hists__delete_all_entries(hists);
+	mutex_destroy(&hists->lock);
+}
+
 static void hists_evsel__exit(struct evsel *evsel)
 {
 	struct hists *hists = evsel__hists(evsel);
@@ -362,6 +362,7 @@ void hists__output_resort(struct hists *hists, struct ui_progress *prog);
 void hists__output_resort_cb(struct hists *hists, struct ui_progress *prog,
 			     hists__resort_cb_t cb);
 int hists__collapse_resort(struct hists *hists, struct ui_progress *prog);
+int hists__merge(struct hists *dest, struct hists *src);
 
 void hists__decay_entries(struct hists *hists, bool zap_user, bool zap_kernel);
 void hists__delete_entries(struct hists *hists);
@@ -441,6 +442,11 @@ static __pure inline bool hists__has_callchains(struct hists *hists)
 
 int hists__init(void);
 int __hists__init(struct hists *hists, struct perf_hpp_list *hpp_list);
+void hists__exit(struct hists *hists);
+
+/* Hists the samples of @evsel processed by the calling thread go to */
+struct hists *evsel__sample_hists(struct evsel *evsel);
+void hists__set_sample_shard(struct hists *hists, int nr);
 
 struct rb_root_cached *hists__get_rotate_entries_in(struct hists *hists);
 
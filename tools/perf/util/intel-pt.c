@@ -498,6 +498,7 @@ static int intel_pt_get_trace(struct intel_pt_buffer *b, void *data)
 	struct intel_pt_queue *ptq = data;
 	struct auxtrace_buffer *buffer = ptq->buffer;
 	struct auxtrace_buffer *old_buffer = ptq->old_buffer;
+	struct auxtrace_buffer *next;
 	struct auxtrace_queue *queue;
 	int err;
 
@@ -522,6 +523,11 @@ static int intel_pt_get_trace(struct intel_pt_buffer *b, void *data)
 	if (err)
 		return err;
 
+	/* Read the next buffer in while this one is decoded */
+	next = auxtrace_buffer__next(queue, buffer);
+	if (next)
+		auxtrace_buffer__prefetch(next, perf_data__fd(ptq->pt->session->data));
+
 	if (ptq->step_through_buffers)
 		ptq->stop = true;
 
@@ -16,6 +16,9 @@ struct lock_filter {
 	u64			*cgrps;
 };
 
+/* Must match LOCK_HIST_BUCKETS in bpf_skel/lock_data.h */
+#define CONTENTION_HIST_BUCKETS	32
+
 struct lock_stat {
 	struct hlist_node	hash_entry;
 	struct rb_node		rb;		/* used for sorting */
@@ -43,6 +46,9 @@ struct lock_stat {
 
 	int			broken; /* flag of blacklist */
 	int			combined;
+
+	/* log2 histogram of wait times in ns, only with use_hist */
+	u64			wait_hist[CONTENTION_HIST_BUCKETS];
 };
 
 /*
@@ -146,6 +152,12 @@ struct lock_contention {
 	int owner;
 	int nr_filtered;
 	bool save_callstack;
+	/*
+	 * Aggregate into per-CPU maps with a wait time histogram, avoiding
+	 * atomics on shared entries, and have every lock_contention_read()
+	 * return the contention since the previous one.
+	 */
+	bool use_hist;
 };
 
 #ifdef HAVE_BPF_SKEL
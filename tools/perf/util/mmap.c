@@ -18,6 +18,7 @@
 #include <numaif.h>
 #endif
 #include "cpumap.h"
+#include "data.h"
 #include "debug.h"
 #include "event.h"
 #include "mmap.h"
@@ -357,6 +358,84 @@ int perf_mmap__push(struct mmap *md, void *to,
 	return rc;
 }
 
+void mmap_write_batch__init(struct mmap_write_batch *batch)
+{
+	batch->nr_maps = 0;
+	batch->nr_iov = 0;
+	batch->size = 0;
+}
+
+/*
+ * Add the data readable in @md to @batch, flushing it to @file first if it
+ * is full. Returns 1 if there was nothing to read, 0 if data was added and
+ * -1 on failure, like perf_mmap__push().
+ */
+int mmap_write_batch__add(struct mmap_write_batch *batch, struct mmap *md,
+			  struct perf_data_file *file)
+{
+	u64 head = perf_mmap__read_head(&md->core);
+	unsigned char *data = md->core.base + page_size;
+	struct iovec *iov;
+	unsigned long size;
+	int rc;
+
+	if (batch->nr_maps == MMAP_WRITE_BATCH_MAX &&
+	    mmap_write_batch__flush(batch, file) < 0)
+		return -1;
+
+	rc = perf_mmap__read_init(&md->core);
+	if (rc < 0)
+		return (rc == -EAGAIN) ? 1 : -1;
+
+	size = md->core.end - md->core.start;
+	batch->size += size;
+
+	/* The data wraps around the end of the ring buffer, two chunks. */
+	if ((md->core.start & md->core.mask) + size != (md->core.end & md->core.mask)) {
+		iov = &batch->iov[batch->nr_iov++];
+		iov->iov_base = &data[md->core.start & md->core.mask];
+		iov->iov_len = md->core.mask + 1 - (md->core.start & md->core.mask);
+		md->core.start += iov->iov_len;
+	}
+
+	iov = &batch->iov[batch->nr_iov++];
+	iov->iov_base = &data[md->core.start & md->core.mask];
+	iov->iov_len = md->core.end - md->core.start;
+	md->core.start += iov->iov_len;
+
+	batch->maps[batch->nr_maps] = md;
+	batch->heads[batch->nr_maps++] = head;
+	return 0;
+}
+
+/*
+ * Write everything in @batch to @file and release the ring buffer space.
+ * Returns the number of bytes written or -1 on failure, in which case the
+ * data is not consumed.
+ */
+ssize_t mmap_write_batch__flush(struct mmap_write_batch *batch,
+				struct perf_data_file *file)
+{
+	ssize_t ret = 0;
+	int i;
+
+	if (batch->nr_iov) {
+		ret = perf_data_file__writev(file, batch->iov, batch->nr_iov);
+		if (ret < 0)
+			return ret;
+	}
+
+	for (i = 0; i < batch->nr_maps; i++) {
+		struct mmap *md = batch->maps[i];
+
+		md->core.prev = batch->heads[i];
+		perf_mmap__consume(&md->core);
+	}
+
+	mmap_write_batch__init(batch);
+	return ret;
+}
+
 int mmap_cpu_mask__duplicate(struct mmap_cpu_mask *original, struct mmap_cpu_mask *clone)
 {
 	clone->nbits = original->nbits;
@@ -5,6 +5,7 @@
 #include <linux/types.h>
 #include <linux/bitops.h>
 #include <perf/cpumap.h>
+#include <sys/uio.h>
 #ifdef HAVE_AIO_SUPPORT
 #include <aio.h>
 #endif
@@ -57,6 +58,30 @@ union perf_event *perf_mmap__read_forward(struct mmap *map);
 int perf_mmap__push(struct mmap *md, void *to,
 		    int push(struct mmap *map, void *to, void *buf, size_t size));
 
+#define MMAP_WRITE_BATCH_MAX	64
+
+/**
+ * struct mmap_write_batch - ring buffer data pending a single writev()
+ *
+ * Collects the readable data of several mmaps, written straight from the
+ * ring buffers with one system call, and only consumed once written. An
+ * mmap can only be added once per flush. Not for mmaps that compress or use AIO, their data needs a copy anyway.
+ */
+struct mmap_write_batch {
+	struct mmap	*maps[MMAP_WRITE_BATCH_MAX];
+	u64		heads[MMAP_WRITE_BATCH_MAX];
+	struct iovec	iov[2 * MMAP_WRITE_BATCH_MAX];
+	int		nr_maps;
+	int		nr_iov;
+	size_t		size;
+};
+
+void mmap_write_batch__init(struct mmap_write_batch *batch);
+int mmap_write_batch__add(struct mmap_write_batch *batch, struct mmap *md,
+			  struct perf_data_file *file);
+ssize_t mmap_write_batch__flush(struct mmap_write_batch *batch,
+				struct perf_data_file *file);
+
 size_t mmap__mmap_len(struct mmap *map);
 
 void mmap_cpu_mask__scnprintf(struct mmap_cpu_mask *mask, const char *tag);
@@ -22,9 +22,11 @@ int init_rwsem(struct rw_semaphore *sem);
 int exit_rwsem(struct rw_semaphore *sem);
 
 int down_read(struct rw_semaphore *sem);
+bool down_read_trylock(struct rw_semaphore *sem);
 int up_read(struct rw_semaphore *sem);
 
 int down_write(struct rw_semaphore *sem);
+bool down_write_trylock(struct rw_semaphore *sem);
 int up_write(struct rw_semaphore *sem);
 
 #endif /* _PERF_RWSEM_H */
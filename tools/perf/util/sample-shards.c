@@ -0,0 +1,332 @@
+// SPDX-License-Identifier: GPL-2.0
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/list.h>
+#include <linux/zalloc.h>
+
+#include "debug.h"
+#include "event.h"
+#include "evlist.h"
+#include "evsel.h"
+#include "hist.h"
+#include "mutex.h"
+#include "sample.h"
+#include "sample-shards.h"
+#include "session.h"
+#include "tool.h"
+
+/* Samples a shard may have queued before the reader waits for it */
+#define SHARD_QUEUE_MAX		4096
+
+struct shard_sample {
+	struct list_head	list;
+	struct evsel		*evsel;
+	struct machine		*machine;
+	u64			event[];
+};
+
+struct sample_shard {
+	struct sample_shards	*shards;
+	pthread_t		thread;
+	bool			started;
+	struct mutex		lock;
+	/* queue not empty, queue not full and shard idle all signal this */
+	struct cond		cond;
+	struct list_head	queue;
+	unsigned int		nr_queued;
+	bool			busy;
+	bool			done;
+	int			err;
+	/* Private hists, indexed by evsel->core.idx */
+	struct hists		*hists;
+};
+
+struct sample_shards {
+	struct perf_session	*session;
+	int			nr_evsel;
+	int			nr;
+	struct sample_shard	shard[];
+};
+
+static int sample_shard__process(struct sample_shard *shard,
+				 struct list_head *batch)
+{
+	const struct perf_tool *tool = shard->shards->session->tool;
+	struct shard_sample *ss, *tmp;
+	int err = 0;
+
+	list_for_each_entry_safe(ss, tmp, batch, list) {
+		union perf_event *event = (union perf_event *)ss->event;
+		struct perf_sample sample;
+
+		list_del(&ss->list);
+
+		/* Keep emptying the queue after an error, the reader may wait */
+		if (!err)
+			err = evsel__parse_sample(ss->evsel, event, &sample);
+		if (!err)
+			err = tool->sample(tool, event, &sample, ss->evsel,
+					   ss->machine);
+		free(ss);
+	}
+
+	return err;
+}
+
+static void *sample_shard__thread(void *arg)
+{
+	struct sample_shard *shard = arg;
+	LIST_HEAD(batch);
+	int i, err;
+
+	hists__set_sample_shard(shard->hists, shard->shards->nr_evsel);
+
+	mutex_lock(&shard->lock);
+	for (;;) {
+		while (list_empty(&shard->queue) && !shard->done)
+			cond_wait(&shard->cond, &shard->lock);
+		if (list_empty(&shard->queue))
+			break;
+
+		list_splice_init(&shard->queue, &batch);
+		shard->nr_queued = 0;
+		shard->busy = true;
+		cond_broadcast(&shard->cond);
+		mutex_unlock(&shard->lock);
+
+		err = sample_shard__process(shard, &batch);
+
+		mutex_lock(&shard->lock);
+		if (err && !shard->err)
+			shard->err = err;
+		shard->busy = false;
+		cond_broadcast(&shard->cond);
+	}
+	mutex_unlock(&shard->lock);
+
+	/* Collapsing the private hists is part of the parallel work too. */
+	for (i = 0; i < shard->shards->nr_evsel; i++)
+		hists__collapse_resort(&shard->hists[i], NULL);
+
+	hists__set_sample_shard(NULL, 0);
+	return NULL;
+}
+
+static void sample_shard__exit(struct sample_shard *shard)
+{
+	struct shard_sample *ss, *tmp;
+	int i;
+
+	list_for_each_entry_safe(ss, tmp, &shard->queue, list) {
+		list_del(&ss->list);
+		free(ss);
+	}
+
+	if (shard->hists) {
+		for (i = 0; i < shard->shards->nr_evsel; i++)
+			hists__exit(&shard->hists[i]);
+		zfree(&shard->hists);
+	}
+
+	cond_destroy(&shard->cond);
+	mutex_destroy(&shard->lock);
+}
+
+static int sample_shard__init(struct sample_shard *shard,
+			      struct sample_shards *shards)
+{
+	struct evsel *evsel;
+
+	shard->shards = shards;
+	mutex_init(&shard->lock);
+	cond_init(&shard->cond);
+	INIT_LIST_HEAD(&shard->queue);
+
+	shard->hists = calloc(shards->nr_evsel, sizeof(*shard->hists));
+	if (!shard->hists)
+		return -ENOMEM;
+
+	evlist__for_each_entry(shards->session->evlist, evsel) {
+		struct hists *hists = evsel__hists(evsel);
+
+		__hists__init(&shard->hists[evsel->core.idx], hists->hpp_list);
+	}
+
+	return 0;
+}
+
+struct sample_shards *sample_shards__new(struct perf_session *session,
+					 int nr_threads)
+{
+	struct sample_shards *shards;
+	int i;
+
+	shards = zalloc(sizeof(*shards) + nr_threads * sizeof(shards->shard[0]));
+	if (!shards)
+		return NULL;
+
+	shards->session = session;
+	shards->nr_evsel = session->evlist->core.nr_entries;
+
+	for (i = 0; i < nr_threads; i++) {
+		struct sample_shard *shard = &shards->shard[i];
+
+		/* Count it first, so a failed init is cleaned up as well. */
+		shards->nr++;
+		if (sample_shard__init(shard, shards))
+			goto out_delete;
+
+		if (pthread_create(&shard->thread, NULL, sample_shard__thread,
+				   shard)) {
+			pr_err("Failed to start sample shard thread\n");
+			goto out_delete;
+		}
+		shard->started = true;
+	}
+
+	return shards;
+
+out_delete:
+	sample_shards__delete(shards);
+	return NULL;
+}
+
+static void sample_shards__stop(struct sample_shards *shards)
+{
+	int i;
+
+	for (i = 0; i < shards->nr; i++) {
+		struct sample_shard *shard = &shards->shard[i];
+
+		mutex_lock(&shard->lock);
+		shard->done = true;
+		cond_broadcast(&shard->cond);
+		mutex_unlock(&shard->lock);
+	}
+
+	for (i = 0; i < shards->nr; i++) {
+		struct sample_shard *shard = &shards->shard[i];
+
+		if (shard->started)
+			pthread_join(shard->thread, NULL);
+		shard->started = false;
+	}
+}
+
+void sample_shards__delete(struct sample_shards *shards)
+{
+	int i;
+
+	if (!shards)
+		return;
+
+	sample_shards__stop(shards);
+
+	for (i = 0; i < shards->nr; i++)
+		sample_shard__exit(&shards->shard[i]);
+
+	free(shards);
+}
+
+/*
+ * Returns 1 if the sample was queued, 0 if it has to be delivered by the
+ * caller, and the first error a worker ran into otherwise.
+ */
+int sample_shards__queue(struct sample_shards *shards, union perf_event *event,
+			 struct perf_sample *sample, struct evsel *evsel,
+			 struct machine *machine)
+{
+	struct sample_shard *shard;
+	struct shard_sample *ss;
+	u32 key;
+	int err;
+
+	/* Added after the shards were set up, e.g. in pipe mode */
+	if (evsel->core.idx >= shards->nr_evsel)
+		return 0;
+
+	/* Per-CPU sharding, recordings without the CPU spread by thread */
+	key = sample->cpu != (u32)-1 ? sample->cpu : (u32)sample->tid;
+	shard = &shards->shard[key % shards->nr];
+
+	ss = malloc(sizeof(*ss) + event->header.size);
+	if (!ss)
+		return -ENOMEM;
+
+	ss->evsel = evsel;
+	ss->machine = machine;
+	memcpy(ss->event, event, event->header.size);
+
+	mutex_lock(&shard->lock);
+	while (shard->nr_queued >= SHARD_QUEUE_MAX && !shard->err)
+		cond_wait(&shard->cond, &shard->lock);
+
+	err = shard->err;
+	if (!err) {
+		list_add_tail(&ss->list, &shard->queue);
+		if (shard->nr_queued++ == 0)
+			cond_broadcast(&shard->cond);
+	}
+	mutex_unlock(&shard->lock);
+
+	if (err) {
+		free(ss);
+		return err;
+	}
+
+	return 1;
+}
+
+/* Wait until every queued sample has been processed. */
+int sample_shards__drain(struct sample_shards *shards)
+{
+	int i, err = 0;
+
+	for (i = 0; i < shards->nr; i++) {
+		struct sample_shard *shard = &shards->shard[i];
+
+		mutex_lock(&shard->lock);
+		while (!list_empty(&shard->queue) || shard->busy)
+			cond_wait(&shard->cond, &shard->lock);
+		if (shard->err && !err)
+			err = shard->err;
+		mutex_unlock(&shard->lock);
+	}
+
+	return err;
+}
+
+/*
+ * Stop the workers and merge their hists into the evsel ones. The evsel
+ * hists are left for the usual hists__collapse_resort() and output resort.
+ */
+int sample_shards__finish(struct sample_shards *shards)
+{
+	struct evsel *evsel;
+	int i, err = 0;
+
+	sample_shards__stop(shards);
+
+	for (i = 0; i < shards->nr; i++) {
+		if (shards->shard[i].err && !err)
+			err = shards->shard[i].err;
+	}
+	if (err)
+		return err;
+
+	evlist__for_each_entry(shards->session->evlist, evsel) {
+		if (evsel->core.idx >= shards->nr_evsel)
+			continue;
+
+		for (i = 0; i < shards->nr; i++) {
+			err = hists__merge(evsel__hists(evsel),
+					   &shards->shard[i].hists[evsel->core.idx]);
+			if (err)
+				return err;
+		}
+	}
+
+	return 0;
+}
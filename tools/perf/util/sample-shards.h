@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __PERF_SAMPLE_SHARDS_H
+#define __PERF_SAMPLE_SHARDS_H
+
+struct evsel;
+struct machine;
+struct perf_sample;
+struct perf_session;
+union perf_event;
+
+/*
+ * Spread the delivery of PERF_RECORD_SAMPLE events over worker threads,
+ * each accounting into private hists that are merged into the evsel ones
+ * once processing is done. Every other event waits for the queued samples
+ * to be processed first, so samples always see the machine state they
+ * were recorded in.
+ *
+ * Only usable by tools whose sample callback doesn't depend on the order
+ * samples are processed in and that account through evsel__sample_hists().
+ */
+struct sample_shards;
+
+struct sample_shards *sample_shards__new(struct perf_session *session,
+					 int nr_threads);
+void sample_shards__delete(struct sample_shards *shards);
+
+int sample_shards__queue(struct sample_shards *shards, union perf_event *event,
+			 struct perf_sample *sample, struct evsel *evsel,
+			 struct machine *machine);
+int sample_shards__drain(struct sample_shards *shards);
+int sample_shards__finish(struct sample_shards *shards);
+
+#endif /* __PERF_SAMPLE_SHARDS_H */
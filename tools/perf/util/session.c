@@ -30,6 +30,7 @@
 #include "thread.h"
 #include "thread-stack.h"
 #include "sample-raw.h"
+#include "sample-shards.h"
 #include "stat.h"
 #include "tsc.h"
 #include "ui/progress.h"
@@ -241,6 +242,7 @@ void perf_session__delete(struct perf_session *session)
 {
 	if (session == NULL)
 		return;
+	sample_shards__delete(session->shards);
 	auxtrace__free(session);
 	auxtrace_index__free(&session->auxtrace_index);
 	debuginfo_cache__delete();
@@ -1254,6 +1256,7 @@ static int evlist__deliver_sample(struct evlist *evlist, const struct perf_tool
 
 static int machines__deliver_event(struct machines *machines,
 				   struct evlist *evlist,
+				   struct sample_shards *shards,
 				   union perf_event *event,
 				   struct perf_sample *sample,
 				   const struct perf_tool *tool, u64 file_offset,
@@ -1261,9 +1264,17 @@ static int machines__deliver_event(struct machines *machines,
 {
 	struct evsel *evsel;
 	struct machine *machine;
+	int ret;
 
 	dump_event(evlist, event, file_offset, sample, file_path);
 
+	/* Anything but a sample may change what queued samples resolve to */
+	if (shards && event->header.type != PERF_RECORD_SAMPLE) {
+		ret = sample_shards__drain(shards);
+		if (ret)
+			return ret;
+	}
+
 	evsel = evlist__id2evsel(evlist, sample->id);
 
 	machine = machines__find_for_cpumode(machines, event, sample);
@@ -1280,6 +1291,11 @@ static int machines__deliver_event(struct machines *machines,
 			return 0;
 		}
 		dump_sample(evsel, event, sample, perf_env__arch(machine->env));
+		if (shards && !(evsel->core.attr.sample_type & PERF_SAMPLE_READ)) {
+			ret = sample_shards__queue(shards, event, sample, evsel, machine);
+			if (ret)
+				return ret < 0 ? ret : 0;
+		}
 		return evlist__deliver_sample(evlist, tool, event, sample, evsel, machine);
 	case PERF_RECORD_MMAP:
 		return tool->mmap(tool, event, sample, machine);
@@ -1364,7 +1380,8 @@ static int perf_session__deliver_event(struct perf_session *session,
 		return 0;
 
 	ret = machines__deliver_event(&session->machines, session->evlist,
-				      event, &sample, tool, file_offset, file_path);
+				      session->shards, event, &sample, tool,
+				      file_offset, file_path);
 
 	if (dump_trace && sample.aux_sample.size)
 		auxtrace__dump_auxtrace_sample(session, &sample);
@@ -1386,6 +1403,14 @@ static s64 perf_session__process_user_event(struct perf_session *session,
 	if (event->header.type != PERF_RECORD_COMPRESSED || perf_tool__compressed_is_stub(tool))
 		dump_event(session->evlist, event, file_offset, &sample, file_path);
 
+	/* Rounds and compressed data only feed events through the usual path */
+	if (session->shards && event->header.type != PERF_RECORD_FINISHED_ROUND &&
+	    event->header.type != PERF_RECORD_COMPRESSED) {
+		err = sample_shards__drain(session->shards);
+		if (err)
+			return err;
+	}
+
 	/* These events are processed right away */
 	switch (event->header.type) {
 	case PERF_RECORD_HEADER_ATTR:
@@ -1471,7 +1496,15 @@ int perf_session__deliver_synth_event(struct perf_session *session,
 	if (event->header.type >= PERF_RECORD_USER_TYPE_START)
 		return perf_session__process_user_event(session, event, 0, NULL);
 
-	return machines__deliver_event(&session->machines, evlist, event, sample, tool, 0, NULL);
+	/* Synthesized events are delivered right away, in order */
+	if (session->shards) {
+		int err = sample_shards__drain(session->shards);
+
+		if (err)
+			return err;
+	}
+
+	return machines__deliver_event(&session->machines, evlist, NULL, event, sample, tool, 0, NULL);
 }
 
 int perf_session__deliver_synth_attr_event(struct perf_session *session,
@@ -2375,11 +2408,35 @@ static int __perf_session__process_dir_events(struct perf_session *session)
 	return ret;
 }
 
-int perf_session__process_events(struct perf_session *session)
+/**
+ * perf_session__enable_sample_shards - process samples on worker threads
+ * @session: session to be processed with perf_session__process_events()
+ * @nr_threads: number of worker threads, 0 for one per online CPU
+ *
+ * Samples are spread over @nr_threads workers by CPU and accounted into
+ * private hists, merged into the evsel hists at the end of
+ * perf_session__process_events(). The tool's sample callback must account
+ * through evsel__sample_hists() and not depend on the order of samples.
+ */
+int perf_session__enable_sample_shards(struct perf_session *session,
+				       int nr_threads)
 {
-	if (perf_session__register_idle_thread(session) < 0)
-		return -ENOMEM;
+	if (nr_threads == 0)
+		nr_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (nr_threads < 2)
+		return 0;
+
+	/* Not supported: dumps must stay in order, hierarchy hists merging */
+	if (dump_trace || symbol_conf.report_hierarchy)
+		return -EOPNOTSUPP;
+
+	session->shards = sample_shards__new(session, nr_threads);
+	return session->shards ? 0 : -ENOMEM;
+}
 
+static int __perf_session__process_events_any(struct perf_session *session)
+{
 	if (perf_data__is_pipe(session->data))
 		return __perf_session__process_pipe_events(session);
 
@@ -2389,6 +2446,26 @@ int perf_session__process_events(struct perf_session *session)
 	return __perf_session__process_events(session);
 }
 
+int perf_session__process_events(struct perf_session *session)
+{
+	int err, shard_err;
+
+	if (perf_session__register_idle_thread(session) < 0)
+		return -ENOMEM;
+
+	err = __perf_session__process_events_any(session);
+
+	if (session->shards) {
+		shard_err = sample_shards__finish(session->shards);
+		sample_shards__delete(session->shards);
+		session->shards = NULL;
+		if (!err)
+			err = shard_err;
+	}
+
+	return err;
+}
+
 bool perf_session__has_traces(struct perf_session *session, const char *msg)
 {
 	struct evsel *evsel;
@@ -91,6 +91,11 @@ struct perf_session {
 	struct zstd_data	zstd_data;
 	struct decomp_data	decomp_data;
 	struct decomp_data	*active_decomp;
+	/**
+	 * @shards: Worker threads samples are delivered to, see
+	 * perf_session__enable_sample_shards().
+	 */
+	struct sample_shards	*shards;
 };
 
 struct decomp {
@@ -117,6 +122,9 @@ static inline struct perf_session *perf_session__new(struct perf_data *data,
 
 void perf_session__delete(struct perf_session *session);
 
+int perf_session__enable_sample_shards(struct perf_session *session,
+				       int nr_threads);
+
 void perf_event_header__bswap(struct perf_event_header *hdr);
 
 int perf_session__peek_event(struct perf_session *session, off_t file_offset,
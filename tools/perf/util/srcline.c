@@ -848,6 +848,119 @@ void dso__free_a2l(struct dso *dso)
 
 #endif /* HAVE_LIBBFD_SUPPORT */
 
+/*
+ * addr2line results by address, failures included, so that hist entries
+ * for the same address, e.g. from different threads or callchains, or both
+ * the srcline and srcfile sort keys, only resolve it once. The result
+ * depends on whether inlines were unwound, so that is part of the key.
+ */
+struct a2l_cache_node {
+	struct rb_node		rb_node;
+	u64			addr;
+	bool			unwind_inlines;
+	int			ret;
+	unsigned int		line_nr;
+	char			*file;
+};
+
+static int a2l_cache_node__cmp(const struct a2l_cache_node *n, u64 addr,
+			       bool unwind_inlines)
+{
+	if (addr != n->addr)
+		return addr < n->addr ? -1 : 1;
+
+	return (int)unwind_inlines - (int)n->unwind_inlines;
+}
+
+static struct a2l_cache_node *a2l_cache__find(struct rb_root_cached *tree, u64 addr,
+					      bool unwind_inlines)
+{
+	struct rb_node *n = tree->rb_root.rb_node;
+
+	while (n) {
+		struct a2l_cache_node *i = rb_entry(n, struct a2l_cache_node, rb_node);
+		int cmp = a2l_cache_node__cmp(i, addr, unwind_inlines);
+
+		if (cmp < 0)
+			n = n->rb_left;
+		else if (cmp > 0)
+			n = n->rb_right;
+		else
+			return i;
+	}
+
+	return NULL;
+}
+
+static void a2l_cache__insert(struct rb_root_cached *tree, struct a2l_cache_node *node)
+{
+	struct rb_node **p = &tree->rb_root.rb_node;
+	struct rb_node *parent = NULL;
+	bool leftmost = true;
+
+	while (*p != NULL) {
+		struct a2l_cache_node *i;
+
+		parent = *p;
+		i = rb_entry(parent, struct a2l_cache_node, rb_node);
+		if (a2l_cache_node__cmp(i, node->addr, node->unwind_inlines) < 0) {
+			p = &(*p)->rb_left;
+		} else {
+			p = &(*p)->rb_right;
+			leftmost = false;
+		}
+	}
+	rb_link_node(&node->rb_node, parent, p);
+	rb_insert_color_cached(&node->rb_node, tree, leftmost);
+}
+
+void a2l_cache__delete(struct rb_root_cached *tree)
+{
+	struct a2l_cache_node *pos;
+	struct rb_node *next = rb_first_cached(tree);
+
+	while (next) {
+		pos = rb_entry(next, struct a2l_cache_node, rb_node);
+		next = rb_next(&pos->rb_node);
+		rb_erase_cached(&pos->rb_node, tree);
+		free(pos->file);
+		free(pos);
+	}
+}
+
+/* addr2line() for the file and line only, without building inline lists. */
+static int addr2line_cached(const char *dso_name, u64 addr,
+			    char **file, unsigned int *line_nr,
+			    struct dso *dso, bool unwind_inlines)
+{
+	struct rb_root_cached *tree = dso__a2l_cache(dso);
+	struct a2l_cache_node *node;
+
+	node = a2l_cache__find(tree, addr, unwind_inlines);
+	if (!node) {
+		node = zalloc(sizeof(*node));
+		if (!node)
+			return addr2line(dso_name, addr, file, line_nr, dso,
+					 unwind_inlines, NULL, NULL);
+
+		node->addr = addr;
+		node->unwind_inlines = unwind_inlines;
+		node->ret = addr2line(dso_name, addr, &node->file, &node->line_nr,
+				      dso, unwind_inlines, NULL, NULL);
+		a2l_cache__insert(tree, node);
+	}
+
+	if (!node->ret)
+		return 0;
+
+	*file = node->file ? strdup(node->file) : NULL;
+	if (node->file && !*file)
+		return 0;
+
+	*line_nr = node->line_nr;
+	return node->ret;
+}
+
 static struct inline_node *addr2inlines(const char *dso_name, u64 addr,
 					struct dso *dso, struct symbol *sym)
 {
@@ -888,8 +1001,7 @@ char *__get_srcline(struct dso *dso, u64 addr, struct symbol *sym,
 	if (dso_name == NULL)
 		goto out_err;
 
-	if (!addr2line(dso_name, addr, &file, &line, dso,
-		       unwind_inlines, NULL, sym))
+	if (!addr2line_cached(dso_name, addr, &file, &line, dso, unwind_inlines))
 		goto out_err;
 
 	srcline = srcline_from_fileline(file, line);
@@ -935,7 +1047,7 @@ char *get_srcline_split(struct dso *dso, u64 addr, unsigned *line)
 	if (dso_name == NULL)
 		goto out_err;
 
-	if (!addr2line(dso_name, addr, &file, line, dso, true, NULL, NULL))
+	if (!addr2line_cached(dso_name, addr, &file, line, dso, true))
 		goto out_err;
 
 	dso__set_a2l_fails(dso, 0);
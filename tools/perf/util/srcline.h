@@ -25,6 +25,8 @@ void srcline__tree_insert(struct rb_root_cached *tree, u64 addr, char *srcline);
 char *srcline__tree_find(struct rb_root_cached *tree, u64 addr);
 /* delete all srclines within the tree */
 void srcline__tree_delete(struct rb_root_cached *tree);
+/* delete the addr2line results cached for a DSO */
+void a2l_cache__delete(struct rb_root_cached *tree);
 
 extern char *srcline__unknown;
 #define SRCLINE_UNKNOWN srcline__unknown
@@ -0,0 +1,298 @@
+// SPDX-License-Identifier: GPL-2.0
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/zalloc.h>
+
+#include "build-id.h"
+#include "debug.h"
+#include "dso.h"
+#include "symbol.h"
+#include "symbol-index.h"
+
+#define SYMBOL_INDEX_NAME	"symbols"
+#define SYMBOL_INDEX_MAGIC	0x494d595346524550ULL	/* "PERFSYMI" */
+#define SYMBOL_INDEX_VERSION	1
+
+/* symbol_conf settings the loaded symbols depend on */
+#define SYMBOL_INDEX_F_DEMANGLE	(1U << 0)
+
+#define SYMBOL_F_IDLE		(1U << 0)
+#define SYMBOL_F_IGNORE		(1U << 1)
+#define SYMBOL_F_IFUNC_ALIAS	(1U << 2)
+
+/*
+ * The file is the header, nr_syms entries sorted by address and the string
+ * table the entries point into. The string at offset 0 is the symsrc
+ * filename. It's only ever read by the perf that wrote it, so everything
+ * is in host byte order, a foreign index fails the magic check.
+ */
+struct symbol_index_header {
+	u64	magic;
+	u32	version;
+	u32	flags;
+	u64	nr_syms;
+	u64	text_offset;
+	u64	text_end;
+	u64	strtab_size;
+	u8	symtab_type;
+	u8	binary_type;
+	u8	is_64_bit;
+	u8	rel;
+	u8	adjust_symbols;
+	u8	__reserved[3];
+};
+
+struct symbol_index_entry {
+	u64	start;
+	u64	end;
+	u32	name;
+	u8	type;
+	u8	binding;
+	u8	arch_sym;
+	u8	flags;
+};
+
+static u32 symbol_index__flags(void)
+{
+	return symbol_conf.demangle ? SYMBOL_INDEX_F_DEMANGLE : 0;
+}
+
+static char *symbol_index__path(struct dso *dso)
+{
+	char sbuild_id[SBUILD_ID_SIZE];
+	char *dir_name, *path;
+
+	if (!dso__has_build_id(dso))
+		return NULL;
+
+	build_id__sprintf(dso__bid(dso), sbuild_id);
+	dir_name = build_id_cache__cachedir(sbuild_id, dso__long_name(dso),
+					    dso__nsinfo(dso), false, false);
+	if (!dir_name)
+		return NULL;
+
+	if (asprintf(&path, "%s/" SYMBOL_INDEX_NAME, dir_name) < 0)
+		path = NULL;
+
+	free(dir_name);
+	return path;
+}
+
+static int symbol_index__load(struct dso *dso, const void *buf, size_t size)
+{
+	const struct symbol_index_header *hdr = buf;
+	const struct symbol_index_entry *entries = buf + sizeof(*hdr);
+	const char *strtab;
+	u64 i;
+
+	if (size < sizeof(*hdr) || hdr->magic != SYMBOL_INDEX_MAGIC ||
+	    hdr->version != SYMBOL_INDEX_VERSION ||
+	    hdr->flags != symbol_index__flags())
+		return -1;
+
+	if (hdr->nr_syms > (size - sizeof(*hdr)) / sizeof(*entries) ||
+	    hdr->strtab_size != size - sizeof(*hdr) - hdr->nr_syms * sizeof(*entries))
+		return -1;
+
+	strtab = (const char *)(entries + hdr->nr_syms);
+	if (hdr->strtab_size == 0 || strtab[hdr->strtab_size - 1] != '\0')
+		return -1;
+
+	for (i = 0; i < hdr->nr_syms; i++) {
+		const struct symbol_index_entry *e = &entries[i];
+		struct symbol *sym;
+
+		if (e->name >= hdr->strtab_size || e->end < e->start)
+			goto out_delete;
+
+		sym = symbol__new(e->start, e->end - e->start, e->binding,
+				  e->type, strtab + e->name);
+		if (!sym)
+			goto out_delete;
+
+		sym->idle = !!(e->flags & SYMBOL_F_IDLE);
+		sym->ignore = !!(e->flags & SYMBOL_F_IGNORE);
+		sym->ifunc_alias = !!(e->flags & SYMBOL_F_IFUNC_ALIAS);
+		sym->arch_sym = e->arch_sym;
+		symbols__insert(dso__symbols(dso), sym);
+	}
+
+	dso__set_symtab_type(dso, hdr->symtab_type);
+	if (dso__binary_type(dso) == DSO_BINARY_TYPE__NOT_FOUND)
+		dso__set_binary_type(dso, hdr->binary_type);
+	dso__set_is_64_bit(dso, hdr->is_64_bit);
+	dso__set_rel(dso, hdr->rel);
+	dso__set_adjust_symbols(dso, hdr->adjust_symbols);
+	dso__set_text_offset(dso, hdr->text_offset);
+	dso__set_text_end(dso, hdr->text_end);
+	if (!dso__symsrc_filename(dso) && strtab[0])
+		dso__set_symsrc_filename(dso, strdup(strtab));
+
+	return hdr->nr_syms;
+
+out_delete:
+	symbols__delete(dso__symbols(dso));
+	return -1;
+}
+
+/*
+ * Load the symbols of @dso from its index in the build-id cache. Returns
+ * the number of symbols loaded, 0 or less if there is no usable index and
+ * the symbols have to be read from the DSO.
+ */
+int dso__load_symbol_index(struct dso *dso)
+{
+	struct stat st;
+	void *buf;
+	char *path;
+	int fd, ret = -1;
+
+	path = symbol_index__path(dso);
+	if (!path)
+		return -1;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		goto out_free;
+
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(struct symbol_index_header))
+		goto out_close;
+
+	buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (buf == MAP_FAILED)
+		goto out_close;
+
+	ret = symbol_index__load(dso, buf, st.st_size);
+	if (ret < 0)
+		pr_debug("Ignoring invalid symbol index %s\n", path);
+	else
+		pr_debug2("Loaded %d symbols from %s\n", ret, path);
+
+	munmap(buf, st.st_size);
+out_close:
+	close(fd);
+out_free:
+	free(path);
+	return ret;
+}
+
+static int symbol_index__write(struct dso *dso, FILE *fp)
+{
+	struct symbol_index_header hdr = {
+		.magic		= SYMBOL_INDEX_MAGIC,
+		.version	= SYMBOL_INDEX_VERSION,
+		.flags		= symbol_index__flags(),
+		.text_offset	= dso__text_offset(dso),
+		.text_end	= dso__text_end(dso),
+		.symtab_type	= dso__symtab_type(dso),
+		.binary_type	= dso__binary_type(dso),
+		.is_64_bit	= dso__is_64_bit(dso),
+		.rel		= dso__rel(dso),
+		.adjust_symbols	= dso__adjust_symbols(dso),
+	};
+	const char *symsrc = dso__symsrc_filename(dso) ?: "";
+	struct rb_root_cached *symbols = dso__symbols(dso);
+	struct symbol *pos;
+	struct rb_node *nd;
+	u64 strtab_size;
+
+	strtab_size = strlen(symsrc) + 1;
+	symbols__for_each_entry(symbols, pos, nd) {
+		hdr.nr_syms++;
+		strtab_size += pos->namelen + 1;
+	}
+	if (strtab_size > UINT32_MAX)
+		return -E2BIG;
+	hdr.strtab_size = strtab_size;
+
+	if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1)
+		return -errno;
+
+	strtab_size = strlen(symsrc) + 1;
+	symbols__for_each_entry(symbols, pos, nd) {
+		struct symbol_index_entry e = {
+			.start	  = pos->start,
+			.end	  = pos->end,
+			.name	  = strtab_size,
+			.type	  = pos->type,
+			.binding  = pos->binding,
+			.arch_sym = pos->arch_sym,
+			.flags	  = (pos->idle ? SYMBOL_F_IDLE : 0) |
+				    (pos->ignore ? SYMBOL_F_IGNORE : 0) |
+				    (pos->ifunc_alias ? SYMBOL_F_IFUNC_ALIAS : 0),
+		};
+
+		if (fwrite(&e, sizeof(e), 1, fp) != 1)
+			return -errno;
+		strtab_size += pos->namelen + 1;
+	}
+
+	if (fwrite(symsrc, strlen(symsrc) + 1, 1, fp) != 1)
+		return -errno;
+
+	symbols__for_each_entry(symbols, pos, nd) {
+		if (fwrite(pos->name, pos->namelen + 1, 1, fp) != 1)
+			return -errno;
+	}
+
+	return 0;
+}
+
+/*
+ * Save the symbols of @dso, just read from its ELF image, to the build-id
+ * cache. Nothing is done unless the DSO is already in the cache. The index
+ * is written to a temporary file first, so that concurrent perf sessions
+ * only ever see a complete one.
+ */
+void dso__save_symbol_index(struct dso *dso)
+{
+	char *path, *tmp = NULL;
+	FILE *fp;
+	int fd, err;
+
+	path = symbol_index__path(dso);
+	if (!path)
+		return;
+
+	/* Already there, written by an earlier or concurrent session. */
+	if (access(path, F_OK) == 0)
+		goto out_free;
+
+	if (asprintf(&tmp, "%s.XXXXXX", path) < 0) {
+		tmp = NULL;
+		goto out_free;
+	}
+
+	/* Fails if the DSO isn't in the build-id cache, which is fine. */
+	fd = mkstemp(tmp);
+	if (fd < 0)
+		goto out_free;
+
+	fp = fdopen(fd, "w");
+	if (!fp) {
+		err = -errno;
+		close(fd);
+		goto out_unlink;
+	}
+
+	err = symbol_index__write(dso, fp);
+	if (fclose(fp) && !err)
+		err = -errno;
+	if (!err && rename(tmp, path) < 0)
+		err = -errno;
+
+out_unlink:
+	if (err) {
+		pr_debug("Failed to write symbol index %s: %s\n", path, strerror(-err));
+		unlink(tmp);
+	}
+out_free:
+	free(tmp);
+	free(path);
+}
@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __PERF_SYMBOL_INDEX_H
+#define __PERF_SYMBOL_INDEX_H
+
+struct dso;
+
+/*
+ * Symbols of user space DSOs are saved to a compact, address sorted index
+ * next to the DSO in the build-id cache once they have been read from the
+ * ELF image, and are loaded from it on later runs, skipping the symtab
+ * parsing and demangling.
+ */
+int dso__load_symbol_index(struct dso *dso);
+void dso__save_symbol_index(struct dso *dso);
+
+#endif /* __PERF_SYMBOL_INDEX_H */
@@ -25,6 +25,8 @@
 #include "machine.h"
 #include "map.h"
 #include "symbol.h"
+#include "symbol-index.h"
+#include "vdso.h"
 #include "map_symbol.h"
 #include "mem-events.h"
 #include "mem-info.h"
@@ -1860,6 +1862,19 @@ int dso__load(struct dso *dso, struct map *map)
 			dso__set_build_id(dso, &bid);
 	}
 
+	/*
+	 * Symbols read from the ELF image before are in the build-id cache,
+	 * which lives outside the DSO's mount namespace.
+	 */
+	if (!kmod && !dso__is_vdso(dso) && dso__has_build_id(dso)) {
+		nsinfo__mountns_exit(&nsc);
+		ret = dso__load_symbol_index(dso);
+		nsinfo__mountns_enter(dso__nsinfo(dso), &nsc);
+		if (ret > 0)
+			goto out_free;
+		ret = -1;
+	}
+
 	/*
 	 * Iterate over candidate debug images.
 	 * Keep track of "interesting" ones (those which have a symtab, dynsym,
@@ -1964,6 +1979,12 @@ int dso__load(struct dso *dso, struct map *map)
 		nr_plt = dso__synthesize_plt_symbols(dso, runtime_ss);
 		if (nr_plt > 0)
 			ret += nr_plt;
+
+		if (!kmod && !dso__is_vdso(dso) && dso__has_build_id(dso)) {
+			nsinfo__mountns_exit(&nsc);
+			dso__save_symbol_index(dso);
+			nsinfo__mountns_enter(dso__nsinfo(dso), &nsc);
+		}
 	}
 
 	for (; ss_pos > 0; ss_pos--)
@@ -1,14 +1,56 @@
 // SPDX-License-Identifier: GPL-2.0
 #include "threads.h"
+#include "debug.h"
 #include "machine.h"
 #include "thread.h"
 
+/*
+ * Front-end cache - TID lookups come in blocks, so most of the time we
+ * don't have to look up the hashmap. It is kept per worker thread so that
+ * concurrent lookups never write to shared state, and holds no reference:
+ * the thread is known to still be in the table, and so alive, as long as
+ * the table generation didn't change.
+ */
+struct threads_last_match {
+	const struct threads_table_entry *table;
+	unsigned int			 gen;
+	struct thread			 *thread;
+};
+
+static __thread struct threads_last_match last_match[THREADS__TABLE_SIZE];
+
+/* Generations are unique across tables, so stale matches never validate. */
+static unsigned int threads__gen;
+
+static unsigned int threads__new_gen(void)
+{
+	return __atomic_add_fetch(&threads__gen, 1, __ATOMIC_RELAXED);
+}
+
 static struct threads_table_entry *threads__table(struct threads *threads, pid_t tid)
 {
 	/* Cast it to handle tid == -1 */
 	return &threads->table[(unsigned int)tid % THREADS__TABLE_SIZE];
 }
 
+static void threads_table_entry__down_read(struct threads_table_entry *table)
+{
+	if (down_read_trylock(&table->lock))
+		return;
+
+	__atomic_add_fetch(&table->contended, 1, __ATOMIC_RELAXED);
+	down_read(&table->lock);
+}
+
+static void threads_table_entry__down_write(struct threads_table_entry *table)
+{
+	if (down_write_trylock(&table->lock))
+		return;
+
+	__atomic_add_fetch(&table->contended, 1, __ATOMIC_RELAXED);
+	down_write(&table->lock);
+}
+
 static size_t key_hash(long key, void *ctx __maybe_unused)
 {
 	/* The table lookup removes low bit entropy, but this is just ignored here. */
@@ -27,19 +69,26 @@ void threads__init(struct threads *threads)
 
 		hashmap__init(&table->shard, key_hash, key_equal, NULL);
 		init_rwsem(&table->lock);
-		table->last_match = NULL;
+		table->gen = threads__new_gen();
+		table->contended = 0;
 	}
 }
 
 void threads__exit(struct threads *threads)
 {
+	unsigned long contended = 0;
+
 	threads__remove_all_threads(threads);
 	for (int i = 0; i < THREADS__TABLE_SIZE; i++) {
 		struct threads_table_entry *table = &threads->table[i];
 
+		contended += table->contended;
 		hashmap__clear(&table->shard);
 		exit_rwsem(&table->lock);
 	}
+
+	if (contended)
+		pr_debug2("threads: %lu contended table lock acquisitions\n", contended);
 }
 
 size_t threads__nr(struct threads *threads)
@@ -49,44 +98,34 @@ size_t threads__nr(struct threads *threads)
 	for (int i = 0; i < THREADS__TABLE_SIZE; i++) {
 		struct threads_table_entry *table = &threads->table[i];
 
-		down_read(&table->lock);
+		threads_table_entry__down_read(table);
 		nr += hashmap__size(&table->shard);
 		up_read(&table->lock);
 	}
 	return nr;
 }
 
-/*
- * Front-end cache - TID lookups come in blocks,
- * so most of the time we dont have to look up
- * the full rbtree:
- */
+/* Called with the table lock held, returns a new reference. */
 static struct thread *__threads_table_entry__get_last_match(struct threads_table_entry *table,
 							    pid_t tid)
 {
-	struct thread *th, *res = NULL;
+	struct threads_last_match *lm = &last_match[(unsigned int)tid % THREADS__TABLE_SIZE];
 
-	th = table->last_match;
-	if (th != NULL) {
-		if (thread__tid(th) == tid)
-			res = thread__get(th);
-	}
-	return res;
+	if (lm->table != table || lm->gen != table->gen || lm->thread == NULL)
+		return NULL;
+
+	return thread__tid(lm->thread) == tid ? thread__get(lm->thread) : NULL;
 }
 
+/* Called with the table lock held, @th being the table's reference. */
 static void __threads_table_entry__set_last_match(struct threads_table_entry *table,
-						  struct thread *th)
+						  pid_t tid, struct thread *th)
 {
-	thread__put(table->last_match);
-	table->last_match = thread__get(th);
-}
+	struct threads_last_match *lm = &last_match[(unsigned int)tid % THREADS__TABLE_SIZE];
 
-static void threads_table_entry__set_last_match(struct threads_table_entry *table,
-						struct thread *th)
-{
-	down_write(&table->lock);
-	__threads_table_entry__set_last_match(table, th);
-	up_write(&table->lock);
+	lm->table = table;
+	lm->gen = table->gen;
+	lm->thread = th;
 }
 
 struct thread *threads__find(struct threads *threads, pid_t tid)
@@ -94,15 +133,13 @@ struct thread *threads__find(struct threads *threads, pid_t tid)
 	struct threads_table_entry *table  = threads__table(threads, tid);
 	struct thread *res;
 
-	down_read(&table->lock);
+	threads_table_entry__down_read(table);
 	res = __threads_table_entry__get_last_match(table, tid);
-	if (!res) {
-		if (hashmap__find(&table->shard, tid, &res))
-			res = thread__get(res);
+	if (!res && hashmap__find(&table->shard, tid, &res)) {
+		__threads_table_entry__set_last_match(table, tid, res);
+		res = thread__get(res);
 	}
 	up_read(&table->lock);
-	if (res)
-		threads_table_entry__set_last_match(table, res);
 	return res;
 }
 
@@ -112,21 +149,21 @@ struct thread *threads__findnew(struct threads *threads, pid_t pid, pid_t tid, b
 	struct thread *res = NULL;
 
 	*created = false;
-	down_write(&table->lock);
+	threads_table_entry__down_write(table);
 	res = thread__new(pid, tid);
 	if (res) {
 		if (hashmap__add(&table->shard, tid, res)) {
 			/* Add failed. Assume a race so find other entry. */
 			thread__put(res);
 			res = NULL;
-			if (hashmap__find(&table->shard, tid, &res))
-				res = thread__get(res);
+			hashmap__find(&table->shard, tid, &res);
 		} else {
-			res = thread__get(res);
 			*created = true;
 		}
-		if (res)
-			__threads_table_entry__set_last_match(table, res);
+		if (res) {
+			__threads_table_entry__set_last_match(table, tid, res);
+			res = thread__get(res);
+		}
 	}
 	up_write(&table->lock);
 	return res;
@@ -139,8 +176,8 @@ void threads__remove_all_threads(struct threads *threads)
 		struct hashmap_entry *cur, *tmp;
 		size_t bkt;
 
-		down_write(&table->lock);
-		__threads_table_entry__set_last_match(table, NULL);
+		threads_table_entry__down_write(table);
+		table->gen = threads__new_gen();
 		hashmap__for_each_entry_safe(&table->shard, cur, tmp, bkt) {
 			struct thread *old_value;
 
@@ -156,10 +193,8 @@ void threads__remove(struct threads *threads, struct thread *thread)
 	struct threads_table_entry *table  = threads__table(threads, thread__tid(thread));
 	struct thread *old_value;
 
-	down_write(&table->lock);
-	if (table->last_match && RC_CHK_EQUAL(table->last_match, thread))
-		__threads_table_entry__set_last_match(table, NULL);
-
+	threads_table_entry__down_write(table);
+	table->gen = threads__new_gen();
 	hashmap__delete(&table->shard, thread__tid(thread), /*old_key=*/NULL, &old_value);
 	thread__put(old_value);
 	up_write(&table->lock);
@@ -174,7 +209,7 @@ int threads__for_each_thread(struct threads *threads,
 		struct hashmap_entry *cur;
 		size_t bkt;
 
-		down_read(&table->lock);
+		threads_table_entry__down_read(table);
 		hashmap__for_each_entry(&table->shard, cur, bkt) {
 			int rc = fn((struct thread *)cur->pvalue, data);
 
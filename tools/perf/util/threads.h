@@ -7,14 +7,17 @@
 
 struct thread;
 
-#define THREADS__TABLE_BITS	3
+#define THREADS__TABLE_BITS	5
 #define THREADS__TABLE_SIZE	(1 << THREADS__TABLE_BITS)
 
 struct threads_table_entry {
 	/* Key is tid, value is struct thread. */
 	struct hashmap	       shard;
 	struct rw_semaphore    lock;
-	struct thread	       *last_match;
+	/* Changed whenever a thread is removed, invalidates last matches. */
+	unsigned int	       gen;
+	/* Lock acquisitions that had to wait, reported with -vv. */
+	unsigned int	       contended;
 };
 
 struct threads {
@@ -0,0 +1,450 @@
+// SPDX-License-Identifier: GPL-2.0
+#include <argp.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "bpf_util.h"
+#include "map_scaling_bench.skel.h"
+
+/* Must match progs/map_scaling_bench.c */
+#define KEYS_NR		(1 << 16)
+#define KEY_UPDATE	(1U << 31)
+#define LAT_BUCKETS	256
+
+struct lpm_key {
+	__u32 prefixlen;
+	__u32 data;
+};
+
+struct bench_stats {
+	__u64 ops;
+	__u64 lat[LAT_BUCKETS];
+};
+
+struct map_scaling_type {
+	const char *name;
+	bool lpm;
+	bool percpu;
+	bool prefill;
+};
+
+static const struct map_scaling_type map_types[] = {
+	{ .name = "hash", .prefill = true },
+	{ .name = "lru_hash", .prefill = true },
+	{ .name = "percpu_hash", .percpu = true, .prefill = true },
+	{ .name = "array" },
+	{ .name = "percpu_array", .percpu = true },
+	{ .name = "lpm_trie", .lpm = true, .prefill = true },
+};
+
+static struct map_scaling_ctx {
+	const struct map_scaling_type *type;
+	struct map_scaling_bench *skel;
+	struct bpf_map *map;
+	struct bench_stats *stats;
+	__u64 last_ops;
+} ctx;
+
+static struct map_scaling_args {
+	const char *map_type;
+	__u32 nr_entries;
+	bool zipf;
+	double zipf_s;
+	__u32 update_pct;
+	int numa_node;
+	bool json;
+} args = {
+	.map_type = "hash",
+	.nr_entries = 65536,
+	.zipf_s = 0.99,
+	.numa_node = -1,
+};
+
+enum {
+	ARG_MAP_TYPE = 11000,
+	ARG_NR_ENTRIES,
+	ARG_KEY_DIST,
+	ARG_ZIPF_S,
+	ARG_UPDATE_PCT,
+	ARG_NUMA_NODE,
+	ARG_JSON,
+};
+
+static const struct argp_option opts[] = {
+	{ "map-type", ARG_MAP_TYPE, "TYPE", 0,
+	  "Map type: hash|lru_hash|percpu_hash|array|percpu_array|lpm_trie (default hash)" },
+	{ "nr-entries", ARG_NR_ENTRIES, "NR", 0,
+	  "Number of entries in the map, and of keys used (default 65536)" },
+	{ "key-dist", ARG_KEY_DIST, "DIST", 0,
+	  "Key distribution: uniform|zipf (default uniform)" },
+	{ "zipf-s", ARG_ZIPF_S, "S", 0,
+	  "Exponent of the zipf distribution (default 0.99)" },
+	{ "update-pct", ARG_UPDATE_PCT, "PCT", 0,
+	  "Percentage of updates, the rest are lookups (default 0)" },
+	{ "numa-node", ARG_NUMA_NODE, "NODE", 0,
+	  "Allocate the map on this NUMA node" },
+	{ "json", ARG_JSON, NULL, 0,
+	  "Print the summary as a JSON object" },
+	{},
+};
+
+static error_t map_scaling_parse_arg(int key, char *arg, struct argp_state *state)
+{
+	long ret;
+
+	switch (key) {
+	case ARG_MAP_TYPE:
+		args.map_type = strdup(arg);
+		if (!args.map_type) {
+			fprintf(stderr, "no mem for map-type\n");
+			argp_usage(state);
+		}
+		break;
+	case ARG_NR_ENTRIES:
+		ret = strtol(arg, NULL, 10);
+		if (ret < 1 || ret >= KEY_UPDATE) {
+			fprintf(stderr, "invalid nr-entries\n");
+			argp_usage(state);
+		}
+		args.nr_entries = ret;
+		break;
+	case ARG_KEY_DIST:
+		if (!strcmp(arg, "zipf")) {
+			args.zipf = true;
+		} else if (strcmp(arg, "uniform")) {
+			fprintf(stderr, "invalid key-dist %s\n", arg);
+			argp_usage(state);
+		}
+		break;
+	case ARG_ZIPF_S:
+		args.zipf_s = strtod(arg, NULL);
+		if (args.zipf_s <= 0) {
+			fprintf(stderr, "invalid zipf-s\n");
+			argp_usage(state);
+		}
+		break;
+	case ARG_UPDATE_PCT:
+		ret = strtol(arg, NULL, 10);
+		if (ret < 0 || ret > 100) {
+			fprintf(stderr, "invalid update-pct\n");
+			argp_usage(state);
+		}
+		args.update_pct = ret;
+		break;
+	case ARG_NUMA_NODE:
+		args.numa_node = strtol(arg, NULL, 10);
+		break;
+	case ARG_JSON:
+		args.json = true;
+		break;
+	default:
+		return ARGP_ERR_UNKNOWN;
+	}
+
+	return 0;
+}
+
+const struct argp bench_map_scaling_argp = {
+	.options = opts,
+	.parser = map_scaling_parse_arg,
+};
+
+static void map_scaling_validate(void)
+{
+	if (env.consumer_cnt != 0) {
+		fprintf(stderr, "benchmark doesn't support consumer!\n");
+		exit(1);
+	}
+}
+
+static const struct map_scaling_type *map_scaling_find_type_or_exit(const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(map_types); i++) {
+		if (!strcmp(name, map_types[i].name))
+			return &map_types[i];
+	}
+
+	fprintf(stderr, "no such map type: %s\n", name);
+	fprintf(stderr, "available map types:");
+	for (i = 0; i < ARRAY_SIZE(map_types); i++)
+		fprintf(stderr, " %s", map_types[i].name);
+	fprintf(stderr, "\n");
+	exit(1);
+}
+
+/* Zipf distributed ranks by inverting the CDF, uniform ones otherwise */
+static void map_scaling_fill_keys(__u32 *keys)
+{
+	double *cdf = NULL;
+	__u32 i;
+
+	if (args.zipf) {
+		cdf = calloc(args.nr_entries, sizeof(*cdf));
+		if (!cdf) {
+			fprintf(stderr, "no mem for zipf cdf\n");
+			exit(1);
+		}
+		for (i = 0; i < args.nr_entries; i++)
+			cdf[i] = (i ? cdf[i - 1] : 0) + 1.0 / pow(i + 1, args.zipf_s);
+		for (i = 0; i < args.nr_entries; i++)
+			cdf[i] /= cdf[args.nr_entries - 1];
+	}
+
+	for (i = 0; i < KEYS_NR; i++) {
+		double u = drand48();
+		__u32 key;
+
+		if (cdf) {
+			__u32 lo = 0, hi = args.nr_entries - 1;
+
+			while (lo < hi) {
+				__u32 mid = lo + (hi - lo) / 2;
+
+				if (cdf[mid] < u)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			key = lo;
+		} else {
+			key = u * args.nr_entries;
+		}
+
+		if (drand48() * 100 < args.update_pct)
+			key |= KEY_UPDATE;
+		keys[i] = key;
+	}
+
+	free(cdf);
+}
+
+/* libbpf has no setter for the NUMA node, so create the map here */
+static void map_scaling_create_on_node(struct bpf_map *map)
+{
+	LIBBPF_OPTS(bpf_map_create_opts, opts,
+		.map_flags = bpf_map__map_flags(map) | BPF_F_NUMA_NODE,
+		.numa_node = args.numa_node,
+	);
+	int fd, err;
+
+	fd = bpf_map_create(bpf_map__type(map), bpf_map__name(map),
+			    bpf_map__key_size(map), bpf_map__value_size(map),
+			    bpf_map__max_entries(map), &opts);
+	if (fd < 0) {
+		fprintf(stderr, "failed to create map on node %d: %s\n",
+			args.numa_node, strerror(errno));
+		exit(1);
+	}
+
+	err = bpf_map__reuse_fd(map, fd);
+	close(fd);
+	if (err) {
+		fprintf(stderr, "failed to reuse map fd: %s\n", strerror(-err));
+		exit(1);
+	}
+}
+
+static void map_scaling_prefill(void)
+{
+	unsigned int nr_cpus = bpf_num_possible_cpus();
+	int fd = bpf_map__fd(ctx.map);
+	__u64 *values;
+	__u32 i;
+
+	values = calloc(ctx.type->percpu ? nr_cpus : 1, sizeof(*values));
+	if (!values) {
+		fprintf(stderr, "no mem for values\n");
+		exit(1);
+	}
+
+	for (i = 0; i < args.nr_entries; i++) {
+		struct lpm_key key = { .prefixlen = 32, .data = i };
+		void *kp = ctx.type->lpm ? (void *)&key : (void *)&key.data;
+
+		if (bpf_map_update_elem(fd, kp, values, BPF_ANY)) {
+			fprintf(stderr, "failed to prefill map: %s\n", strerror(errno));
+			exit(1);
+		}
+	}
+
+	free(values);
+}
+
+static void map_scaling_setup(void)
+{
+	struct bpf_program *prog;
+	struct bpf_map *map;
+	char name[64];
+	int err;
+
+	setup_libbpf();
+
+	ctx.type = map_scaling_find_type_or_exit(args.map_type);
+
+	ctx.stats = calloc(bpf_num_possible_cpus(), sizeof(*ctx.stats));
+	if (!ctx.stats) {
+		fprintf(stderr, "no mem for stats\n");
+		exit(1);
+	}
+
+	ctx.skel = map_scaling_bench__open();
+	if (!ctx.skel) {
+		fprintf(stderr, "failed to open skeleton\n");
+		exit(1);
+	}
+
+	/* Only the map under test and its program are created */
+	bpf_object__for_each_map(map, ctx.skel->obj) {
+		if (!strcmp(bpf_map__name(map), ctx.type->name))
+			ctx.map = map;
+		else if (map != ctx.skel->maps.stats &&
+			 !bpf_map__is_internal(map))
+			bpf_map__set_autocreate(map, false);
+	}
+	bpf_map__set_max_entries(ctx.map, args.nr_entries);
+	if (args.numa_node >= 0)
+		map_scaling_create_on_node(ctx.map);
+
+	snprintf(name, sizeof(name), "%s_bench", ctx.type->name);
+	prog = bpf_object__find_program_by_name(ctx.skel->obj, name);
+	if (!prog) {
+		fprintf(stderr, "no such program %s\n", name);
+		goto cleanup;
+	}
+	bpf_program__set_autoload(prog, true);
+
+	map_scaling_fill_keys(ctx.skel->bss->keys);
+
+	err = map_scaling_bench__load(ctx.skel);
+	if (err) {
+		fprintf(stderr, "failed to load skeleton\n");
+		goto cleanup;
+	}
+
+	/* Lookups of the hash types are meant to hit */
+	if (ctx.type->prefill)
+		map_scaling_prefill();
+
+	if (!bpf_program__attach(prog)) {
+		fprintf(stderr, "failed to attach program!\n");
+		goto cleanup;
+	}
+	return;
+
+cleanup:
+	map_scaling_bench__destroy(ctx.skel);
+	exit(1);
+}
+
+static void *map_scaling_producer(void *arg)
+{
+	while (true)
+		(void)syscall(__NR_getpgid);
+	return NULL;
+}
+
+static void map_scaling_read_stats(struct bench_stats *sum)
+{
+	unsigned int i, b, nr_cpus = bpf_num_possible_cpus();
+	__u32 zero = 0;
+
+	memset(sum, 0, sizeof(*sum));
+	if (bpf_map_lookup_elem(bpf_map__fd(ctx.skel->maps.stats), &zero, ctx.stats))
+		return;
+
+	for (i = 0; i < nr_cpus; i++) {
+		sum->ops += ctx.stats[i].ops;
+		for (b = 0; b < LAT_BUCKETS; b++)
+			sum->lat[b] += ctx.stats[i].lat[b];
+	}
+}
+
+static void map_scaling_measure(struct bench_res *res)
+{
+	struct bench_stats sum;
+
+	map_scaling_read_stats(&sum);
+	res->hits = sum.ops - ctx.last_ops;
+	ctx.last_ops = sum.ops;
+}
+
+/* Lower bound of a latency bucket, the inverse of lat_bucket() in BPF */
+static __u64 lat_bucket_ns(unsigned int b)
+{
+	if (b < 8)
+		return b;
+
+	return (4ULL + b % 4) << (b / 4 - 1);
+}
+
+static __u64 lat_percentile(const struct bench_stats *sum, double pct)
+{
+	__u64 total = 0, seen = 0;
+	unsigned int b;
+
+	for (b = 0; b < LAT_BUCKETS; b++)
+		total += sum->lat[b];
+
+	for (b = 0; b < LAT_BUCKETS; b++) {
+		seen += sum->lat[b];
+		if (seen && seen >= total * pct / 100.0)
+			return lat_bucket_ns(b);
+	}
+
+	return 0;
+}
+
+static void map_scaling_report_final(struct bench_res res[], int res_cnt)
+{
+	double ops_mean = 0.0, ops_stddev = 0.0;
+	struct bench_stats sum;
+	int i;
+
+	for (i = 0; i < res_cnt; i++)
+		ops_mean += res[i].hits / 1000000.0 / (0.0 + res_cnt);
+	if (res_cnt > 1)  {
+		for (i = 0; i < res_cnt; i++)
+			ops_stddev += (ops_mean - res[i].hits / 1000000.0) *
+				      (ops_mean - res[i].hits / 1000000.0) /
+				      (res_cnt - 1.0);
+		ops_stddev = sqrt(ops_stddev);
+	}
+
+	/* Percentiles are over the whole run, warmup included */
+	map_scaling_read_stats(&sum);
+
+	if (args.json) {
+		printf("{\"map_type\":\"%s\",\"nr_entries\":%u,\"key_dist\":\"%s\","
+		       "\"zipf_s\":%.2lf,\"update_pct\":%u,\"numa_node\":%d,"
+		       "\"producers\":%d,\"throughput_mops\":%.3lf,"
+		       "\"throughput_stddev_mops\":%.3lf,\"p50_ns\":%llu,"
+		       "\"p90_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu}\n",
+		       ctx.type->name, args.nr_entries,
+		       args.zipf ? "zipf" : "uniform", args.zipf ? args.zipf_s : 0.0,
+		       args.update_pct, args.numa_node, env.producer_cnt,
+		       ops_mean, ops_stddev,
+		       lat_percentile(&sum, 50), lat_percentile(&sum, 90),
+		       lat_percentile(&sum, 99), lat_percentile(&sum, 99.9));
+		return;
+	}
+
+	printf("Summary: throughput %8.3lf ± %5.3lf M ops/s, latency p50 %llu"
+	       " p90 %llu p99 %llu p99.9 %llu ns/op\n",
+	       ops_mean, ops_stddev,
+	       lat_percentile(&sum, 50), lat_percentile(&sum, 90),
+	       lat_percentile(&sum, 99), lat_percentile(&sum, 99.9));
+}
+
+const struct bench bench_map_scaling = {
+	.name = "map-scaling",
+	.argp = &bench_map_scaling_argp,
+	.validate = map_scaling_validate,
+	.setup = map_scaling_setup,
+	.producer_thread = map_scaling_producer,
+	.measure = map_scaling_measure,
+	.report_progress = hits_drops_report_progress,
+	.report_final = map_scaling_report_final,
+};
@@ -0,0 +1,29 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Sweep map types, producers, key distributions and op mixes, printing
+# one JSON object per run. Extra arguments, e.g. --numa-node 1, are
+# passed to every run.
+
+source ./benchs/run_common.sh
+
+set -eufo pipefail
+
+nr_cpus=$(nproc)
+
+for map_type in hash lru_hash percpu_hash array percpu_array lpm_trie
+do
+	for key_dist in uniform zipf
+	do
+		for update_pct in 0 10 50
+		do
+			for p in 1 2 4 8 16 32 64
+			do
+				[ $p -le $nr_cpus ] || break
+				$RUN_BENCH -q -p$p map-scaling --map-type $map_type \
+					--key-dist $key_dist --update-pct $update_pct \
+					--json "$@" | tail -n1
+			done
+		done
+	done
+done
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: GPL-2.0
+#include <linux/bpf.h>
+#include <stdbool.h>
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_tracing.h>
+#include "bpf_misc.h"
+
+char _license[] SEC("license") = "GPL";
+
+/* Must match benchs/bench_map_scaling.c */
+#define KEYS_NR		(1 << 16)
+#define KEY_UPDATE	(1U << 31)
+#define LAT_BUCKETS	256
+#define OPS_PER_CALL	64
+#define LAT_SAMPLE_MASK	15
+
+struct lpm_key {
+	__u32 prefixlen;
+	__u32 data;
+};
+
+struct bench_stats {
+	__u64 ops;
+	__u64 lat[LAT_BUCKETS];
+};
+
+/* max_entries of the map under test are set by user space */
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, 1);
+	__type(key, __u32);
+	__type(value, __u64);
+} hash SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__uint(max_entries, 1);
+	__type(key, __u32);
+	__type(value, __u64);
+} lru_hash SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_HASH);
+	__uint(max_entries, 1);
+	__type(key, __u32);
+	__type(value, __u64);
+} percpu_hash SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_ARRAY);
+	__uint(max_entries, 1);
+	__type(key, __u32);
+	__type(value, __u64);
+} array SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+	__uint(max_entries, 1);
+	__type(key, __u32);
+	__type(value, __u64);
+} percpu_array SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_LPM_TRIE);
+	__uint(max_entries, 1);
+	__type(key, struct lpm_key);
+	__type(value, __u64);
+	__uint(map_flags, BPF_F_NO_PREALLOC);
+} lpm_trie SEC(".maps");
+
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+	__uint(max_entries, 1);
+	__type(key, __u32);
+	__type(value, struct bench_stats);
+} stats SEC(".maps");
+
+/*
+ * Keys in the configured distribution, filled by user space. KEY_UPDATE
+ * marks the keys to update instead of looking up, so the op mix costs
+ * nothing at run time.
+ */
+__u32 keys[KEYS_NR];
+
+/* log2 buckets split in four, exact below 8ns */
+static __always_inline __u32 lat_bucket(__u64 ns)
+{
+	__u64 v = ns;
+	__u32 msb = 0;
+
+	if (ns < 8)
+		return ns;
+
+	if (v >> 32) { msb += 32; v >>= 32; }
+	if (v >> 16) { msb += 16; v >>= 16; }
+	if (v >> 8)  { msb += 8;  v >>= 8; }
+	if (v >> 4)  { msb += 4;  v >>= 4; }
+	if (v >> 2)  { msb += 2;  v >>= 2; }
+	if (v >> 1)  { msb += 1; }
+
+	return (msb - 1) * 4 + ((ns >> (msb - 2)) & 3);
+}
+
+/*
+ * Run OPS_PER_CALL operations on @map starting at a random position in
+ * keys[], timing every LAT_SAMPLE_MASK + 1th one. The timed ops include
+ * the cost of bpf_ktime_get_ns().
+ */
+static __always_inline int run_ops(void *map, bool lpm)
+{
+	struct lpm_key key = { .prefixlen = 32 };
+	void *kp = lpm ? (void *)&key : (void *)&key.data;
+	__u32 start = bpf_get_prandom_u32(), zero = 0;
+	struct bench_stats *st;
+	__u64 val = 0, t = 0;
+	int i;
+
+	st = bpf_map_lookup_elem(&stats, &zero);
+	if (!st)
+		return 0;
+
+	for (i = 0; i < OPS_PER_CALL; i++) {
+		__u32 k = keys[(start + i) & (KEYS_NR - 1)];
+		bool timed = !(i & LAT_SAMPLE_MASK);
+
+		key.data = k & ~KEY_UPDATE;
+		if (timed)
+			t = bpf_ktime_get_ns();
+		if (k & KEY_UPDATE)
+			bpf_map_update_elem(map, kp, &val, BPF_ANY);
+		else
+			bpf_map_lookup_elem(map, kp);
+		if (timed)
+			st->lat[lat_bucket(bpf_ktime_get_ns() - t) & (LAT_BUCKETS - 1)]++;
+	}
+	st->ops += OPS_PER_CALL;
+	return 0;
+}
+
+SEC("?fentry/" SYS_PREFIX "sys_getpgid")
+int hash_bench(void *ctx)
+{
+	return run_ops(&hash, false);
+}
+
+SEC("?fentry/" SYS_PREFIX "sys_getpgid")
+int lru_hash_bench(void *ctx)
+{
+	return run_ops(&lru_hash, false);
+}
+
+SEC("?fentry/" SYS_PREFIX "sys_getpgid")
+int percpu_hash_bench(void *ctx)
+{
+	return run_ops(&percpu_hash, false);
+}
+
+SEC("?fentry/" SYS_PREFIX "sys_getpgid")
+int array_bench(void *ctx)
+{
+	return run_ops(&array, false);
+}
+
+SEC("?fentry/" SYS_PREFIX "sys_getpgid")
+int percpu_array_bench(void *ctx)
+{
+	return run_ops(&percpu_array, false);
+}
+
+SEC("?fentry/" SYS_PREFIX "sys_getpgid")
+int lpm_trie_bench(void *ctx)
+{
+	return run_ops(&lpm_trie, true);
+}